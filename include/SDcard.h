@@ -32,7 +32,9 @@ struct mp3spec_t                                      // For List of mp3 file on
   #include <SPI.h>
   #include <SD.h>
   #include <FS.h>
-  #define SDSPEED   2000000                             // SPI speed of SD card
+  #ifndef SDSPEED                                       // May be set in config.h
+    #define SDSPEED 2000000                             // SPI speed of SD card
+  #endif
   #define TRACKLIST "/tracklist.dat"                    // File with tracklist on SD card
 
   bool            SD_okay = false ;                     // SD is okay
@@ -53,6 +55,8 @@ struct mp3spec_t                                      // For List of mp3 file on
 
   const char*      STAG = "SDcard" ;
 
+  #include "SDseek.h"                                   // Seeking in MP3 files
+
 
   //**************************************************************************************************
   //                               C L O S E T R A C K F I L E                                       *
@@ -67,6 +71,41 @@ struct mp3spec_t                                      // For List of mp3 file on
   }
 
 
+  //**************************************************************************************************
+  //                                    S D C O N T E N T T Y P E                                    *
+  //**************************************************************************************************
+  // Content type for a file on the SD card, sets the decoder mode.  NULL if the file cannot be      *
+  // played.  The VS1053 plays WAV itself, only the helix decoder plays FLAC.                        *
+  //**************************************************************************************************
+  const char* SDcontentType ( const char* name )
+  {
+    const char* ext = strrchr ( name, '.' ) ;           // Point to extension
+
+    if ( ext == NULL )                                  // No extension at all?
+    {
+      return NULL ;
+    }
+    if ( ( strcmp ( ext, ".mp3" ) == 0 ) ||
+         ( strcmp ( ext, ".MP3" ) == 0 ) )
+    {
+      return "audio/mpeg" ;
+    }
+    if ( ( strcmp ( ext, ".wav" ) == 0 ) ||
+         ( strcmp ( ext, ".WAV" ) == 0 ) )
+    {
+      return "audio/wav" ;
+    }
+    #ifdef DEC_HELIX
+      if ( ( strcmp ( ext, ".flac" ) == 0 ) ||
+           ( strcmp ( ext, ".FLAC" ) == 0 ) )
+      {
+        return "audio/flac" ;
+      }
+    #endif
+    return NULL ;
+  }
+
+
   //**************************************************************************************************
   //                                  O P E N T R A C K F I L E                                       *
   //**************************************************************************************************
@@ -305,10 +344,7 @@ struct mp3spec_t                                      // For List of mp3 file on
       }
       else                                                // It is a file
       {
-        const char* ext = file.name() ;                   // Point to begin of name
-        ext = ext + strlen ( ext ) - 4 ;                  // Point to extension
-        if ( ( strcmp ( ext, ".MP3" ) == 0 ) ||           // It is a file, but is it an MP3?
-            ( strcmp ( ext, ".mp3" ) == 0 ) )
+        if ( SDcontentType ( file.name() ) )              // It is a file, but is it MP3, WAV or FLAC?
         {
           if ( ! addToFileList ( file.path() ) )          // Add file to the list
           {
@@ -322,10 +358,62 @@ struct mp3spec_t                                      // For List of mp3 file on
   }
 
 
+#ifdef DEC_HELIX
+  //**************************************************************************************************
+  //                                     I D 3 G A I N _ S D                                         *
+  //**************************************************************************************************
+  // Get the gain in 0.1 dB from a ReplayGain (TXXX) or iTunNORM (COMM) tag with text txt (after the *
+  // encoding byte).  Track gain goes before album gain, iTunNORM is only used without ReplayGain.   *
+  // The priority of the gain found so far is kept in prio.                                          *
+  //**************************************************************************************************
+  void ID3gain_SD ( const char* id, const char* txt, int len, int16_t* gain, uint8_t* prio )
+  {
+    const char* val ;                                         // Value after the description
+    unsigned    a, b ;                                        // iTunNORM values of left and right
+
+    if ( strncmp ( id, "TXXX", 4 ) == 0 )                     // User defined text?
+    {
+      val = txt + strlen ( txt ) + 1 ;                        // Value follows description
+      if ( val >= txt + len )                                 // Value present?
+      {
+        return ;                                              // No
+      }
+      if ( ( *prio < 3 ) && ( strcasecmp ( txt, "replaygain_track_gain" ) == 0 ) )
+      {
+        *gain = lround ( atof ( val ) * 10.0 ) ;              // Like "-7.89 dB"
+        *prio = 3 ;
+      }
+      else if ( ( *prio < 2 ) && ( strcasecmp ( txt, "replaygain_album_gain" ) == 0 ) )
+      {
+        *gain = lround ( atof ( val ) * 10.0 ) ;
+        *prio = 2 ;
+      }
+    }
+    else if ( ( *prio < 1 ) && ( len > 3 ) &&                 // Comment, language code first
+              ( strncmp ( id, "COMM", 4 ) == 0 ) &&
+              ( strcmp ( txt + 3, "iTunNORM" ) == 0 ) )
+    {
+      val = txt + 3 + strlen ( txt + 3 ) + 1 ;                // Like " 0000044E 00000533 ..."
+      if ( ( val < txt + len ) &&
+           ( sscanf ( val, "%x %x", &a, &b ) == 2 ) )         // Level of left and right
+      {
+        a = max ( a, b ) ;
+        if ( a )
+        {
+          *gain = lround ( -100.0 * log10 ( a / 1000.0 ) ) ;  // 1000 is 0 dB
+          *prio = 1 ;
+        }
+      }
+    }
+  }
+#endif
+
+
   //**************************************************************************************************
   //                                  H A N D L E _ I D 3 _ S D                                      *
   //**************************************************************************************************
   // Check file on SD card for ID3 tags and use them to display some info.                           *
+  // The gain of ReplayGain or iTunNORM tags is used for loudness normalization.                     *
   // Extended headers are not parsed.                                                                *
   //**************************************************************************************************
   void handle_ID3_SD ( String &path )
@@ -341,6 +429,7 @@ struct mp3spec_t                                      // For List of mp3 file on
     uint8_t  exthsiz[4] ;                                     // Extended header size
     uint32_t stx ;                                            // Ext header size converted
     uint32_t sttg ;                                           // Total tagsize converted
+    uint32_t tagend = 0 ;                                     // Position of first byte after tag
     uint32_t stg ;                                            // Size of a single tag
     struct ID3tag_t                                           // Tag in ID3 info
     {
@@ -353,6 +442,10 @@ struct mp3spec_t                                      // For List of mp3 file on
     String    albttl = String() ;                              // Album and title
     bool      talb ;                                          // Tag is TALB (album title)
     bool      tpe1 ;                                          // Tag is TPE1 (artist)
+    #ifdef DEC_HELIX
+      int16_t rgain = 0 ;                                     // Gain from tags in 0.1 dB
+      uint8_t rgprio = 0 ;                                    // Kind of tag for rgain, 0 is none
+    #endif
 
     tftset ( 2, "Playing from local file" ) ;                 // Assume no ID3
     p = (char*)path.c_str() + 1 ;                             // Point to filename (after the slash)
@@ -362,6 +455,11 @@ struct mp3spec_t                                      // For List of mp3 file on
     if ( strncmp ( ID3head.fid, "ID3", 3 ) == 0 )
     {
       sttg = ssconv ( ID3head.ttagsize ) ;                    // Convert tagsize
+      tagend = sttg + sizeof(ID3head) ;                       // Audio data starts here
+      if ( ID3head.hflags & 0x10 )                            // Footer present?
+      {
+        tagend += sizeof(ID3head) ;                           // Yes, skip footer too
+      }
       ESP_LOGI ( STAG, "Found ID3 info" ) ;
       if ( ID3head.hflags & 0x40 )                            // Extended header?
       {
@@ -390,14 +488,27 @@ struct mp3spec_t                                      // For List of mp3 file on
           sttg -= mp3file.read ( tmpbuf, 1 ) ;                // Yes, ignore 1 byte
           stg-- ;                                             // Reduce tagsize by 1
         }
-        if ( stg > ( sizeof(metalinebf) + 2 ) )               // Room for tag?
+        if ( stg >= sizeof(metalinebf) )                      // Room for tag?
         {
-          break ;                                             // No, skip this and further tags
+          if ( stg > sttg )                                   // No, tag size valid?
+          {
+            break ;                                           // No, skip this and further tags
+          }
+          mp3file.seek ( mp3file.position() + stg ) ;         // Skip this one (cover art),
+          sttg -= stg ;                                       // gain tags may follow
+          continue ;
         }
         sttg -= mp3file.read ( (uint8_t*)metalinebf,
                                stg ) ;                        // Read tag contents
         metalinebf[stg] = '\0' ;                              // Add delimeter
         tenc = metalinebf[0] ;                                // First byte is encoding type
+        #ifdef DEC_HELIX
+          if ( ( tenc == 0 ) || ( tenc == 3 ) )               // Latin-1 or UTF-8?
+          {
+            ID3gain_SD ( ID3tag.tagid, metalinebf + 1,        // Yes, check for gain tags
+                         stg - 1, &rgain, &rgprio ) ;
+          }
+        #endif
         if ( tenc == '\0' )                                   // Debug all tags with encoding 0
         {
           ESP_LOGI ( STAG, "ID3 %s = %s", ID3tag.tagid,
@@ -426,7 +537,61 @@ struct mp3spec_t                                      // For List of mp3 file on
       }
       tftset ( 1, albttl ) ;                                  // Show album and title
     }
-    //mp3file.seek ( 0 ) ;                                      // Back to begin of file
+    #ifdef DEC_HELIX
+      if ( rgprio )                                           // Gain from tags?
+      {
+        ESP_LOGI ( STAG, "Track gain %.1f dB from tags", rgain / 10.0 ) ;
+        helixLoudNext ( LN_RGREF - rgain, true ) ;            // Yes, loudness is known
+      }
+    #endif
+    mp3file.seek ( tagend ) ;                                 // Skip ID3 tag (if any) in one jump
+  }
+
+
+  //**************************************************************************************************
+  //                                     F L A C I N F O _ S D                                       *
+  //**************************************************************************************************
+  // Show the bitrate of a FLAC file and the transfer rate it needs from the SD card.  FLAC has a    *
+  // high bitrate: 44.1 kHz/16 bits is 0.7..1 Mbps, 96 kHz/24 bits up to 3.5 Mbps.  The SPI clock  *
+  // should be at least twice that, see SDSPEED.  The file position is restored.                     *
+  //**************************************************************************************************
+  void flacInfo_SD()
+  {
+    uint8_t  h[42] ;                                    // "fLaC", block header and STREAMINFO
+    uint32_t pos = mp3file.position() ;                 // Position after ID3 tag
+    uint32_t rate ;                                     // Sample rate
+    uint64_t total ;                                    // Total number of samples
+    uint32_t kbps ;                                     // Average bitrate of the file
+
+    if ( ( mp3file.read ( h, sizeof(h) ) != sizeof(h) ) ||
+         ( memcmp ( h, "fLaC", 4 ) != 0 ) )
+    {
+      mp3file.seek ( pos ) ;
+      ESP_LOGE ( STAG, "No FLAC header found" ) ;
+      return ;
+    }
+    mp3file.seek ( pos ) ;                              // Back to start for playing
+    rate = ( h[18] << 12 ) | ( h[19] << 4 ) | ( h[20] >> 4 ) ;
+    total = ( (uint64_t)( h[21] & 0x0F ) << 32 ) |
+            ( (uint32_t)h[22] << 24 ) | ( h[23] << 16 ) | ( h[24] << 8 ) | h[25] ;
+    if ( ( rate == 0 ) || ( total == 0 ) )              // Length unknown?
+    {
+      return ;
+    }
+    kbps = (uint64_t)( mp3file.size() - pos ) * 8 * rate / total / 1000 ;
+    ESP_LOGI ( STAG, "FLAC %d Hz, %d bits, %d channels, %d kbps, needs %d kB/sec from SD",
+               rate, ( ( ( h[20] & 1 ) << 4 ) | ( h[21] >> 4 ) ) + 1,
+               ( ( h[20] >> 1 ) & 7 ) + 1, kbps, kbps / 8 ) ;
+    if ( kbps )
+    {
+      ESP_LOGI ( STAG, "Data queue holds %d msec of audio",
+                 (int)( QSIZ * sizeof(qdata_struct::buf) * 8 / kbps ) ) ;
+    }
+    if ( ( kbps * 1000 * 2 ) > SDSPEED )                // SPI clock less than twice the bitrate?
+    {
+      ESP_LOGW ( STAG, "SD clock of %d Hz may be too slow, set SDSPEED in config.h",
+                 SDSPEED ) ;
+    }
   }
 
 
@@ -437,9 +602,13 @@ struct mp3spec_t                                      // For List of mp3 file on
   //**************************************************************************************************
   bool connecttofile_SD()
   {
-    String path ;                                           // Full file spec
+    String      path ;                                      // Full file spec
+    const char* ct ;                                        // Content type of the file
 
-    stop_mp3client() ;                                      // Disconnect if still connected
+    if ( mp3client && mp3client->connected() )              // Still connected to a station?
+    {
+      stop_mp3client() ;                                    // Yes, disconnect
+    }
     tftset ( 0, "MP3 Player" ) ;                            // Set screen segment top line
     displaytime ( "" ) ;                                    // Clear time on TFT screen
     setdatamode ( DATA ) ;                                  // Start in datamode 
@@ -454,6 +623,19 @@ struct mp3spec_t                                      // For List of mp3 file on
       return false ;
     }
     mp3filelength = mp3file.available() ;                   // Get length
+    ct = SDcontentType ( path.c_str() ) ;                   // Type of file
+    if ( ct && ( strcmp ( ct, "audio/mpeg" ) == 0 ) )       // MP3 file?
+    {
+      seekInit ( path.c_str() ) ;                           // Yes, prepare for seek
+    }
+    else
+    {
+      memset ( &sk, 0, sizeof(sk) ) ;                       // No, seek is for MP3 only
+    }
+    if ( ct && ( strcmp ( ct, "audio/flac" ) == 0 ) )       // FLAC file?
+    {
+      flacInfo_SD() ;                                       // Yes, show bitrate, check SPI speed
+    }
     mqttpub.trigger ( MQTT_STREAMTITLE ) ;                  // Request publishing to MQTT
     chunked = false ;                                       // File not chunked
     metaint = 0 ;                                           // No metadata
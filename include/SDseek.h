@@ -0,0 +1,593 @@
+// SDseek.h
+// Seeking in MP3 files on the SD card ("seek" and "skip" commands).
+// The position of a frame is found by one of these methods:
+// - Xing TOC.  100 file positions, one per percent of the playing time.  Written by LAME for VBR
+//   files.  Accurate to about 1 percent of the length between the points, the decoder resyncs.
+// - Index.  The file offset of every SEEK_STEP-th frame.  Taken from a VBRI header (Fraunhofer
+//   encoders) or built while the file is read for playing.  A complete index is cached on the SD
+//   card, next to the tracklist.  From the nearest entry the frame headers are followed to the
+//   exact frame.
+// - Estimate.  For the part of the file that is not indexed yet.  Uses the average frame length
+//   of the indexed part or the bitrate of the first frame, exact for CBR files.
+// Reading starts some bytes before the wanted frame, so the decoder can fill its bit reservoir.
+//
+#define SEEK_MAXIDX     512                           // Max. number of index entries (2 kB)
+#define SEEK_STEP       32                            // Initial frames between index entries
+#define SEEK_HDRBUF     2048                          // Bytes to read to find the first frame
+#define SEEK_DIR        "/.seekidx"                   // Directory for cached indexes
+#define SEEK_MAGIC      0x31494B53                    // "SKI1", version of the cache file
+
+struct seekhdr_t                                      // Header of a cached index file
+{
+  uint32_t       magic ;                              // SEEK_MAGIC
+  uint32_t       filesize ;                           // Size of the mp3 file, to detect changes
+  uint32_t       start ;                              // Offset of the first frame
+  uint32_t       step ;                               // Frames per index entry
+  uint32_t       nidx ;                               // Number of entries
+  uint32_t       frames ;                             // Total number of frames
+} ;
+
+struct seek_t                                         // Seek state of the current file
+{
+  bool           ok ;                                 // First frame found, seeking possible
+  uint32_t       filesize ;                           // Size of the file
+  uint32_t       start ;                              // Offset of the first frame
+  uint32_t       rate ;                               // Sample rate
+  uint16_t       spf ;                                // Samples per frame
+  uint16_t       prime ;                              // Bytes to read before the wanted frame
+  float          avg ;                                // Average frame length from the bitrate
+  uint32_t       frames ;                             // Total number of frames, 0 if unknown
+  uint32_t       bytes ;                              // Bytes covered by the TOC
+  bool           toc ;                                // Xing TOC present
+  uint8_t        tocbuf[100] ;                        // The TOC
+  bool           cached ;                             // Index complete (VBRI or cache file)
+  uint32_t       step ;                               // Frames per index entry
+  uint32_t       nidx ;                               // Number of index entries
+  uint32_t       idx[SEEK_MAXIDX] ;                   // File offset of frame i * step
+  uint32_t       kframe ;                             // Last frame with known offset
+  uint32_t       koff ;                               // and its offset
+  bool           scan ;                               // Following frame headers in read data
+  bool           complete ;                           // Index covers the whole file
+  uint32_t       pos ;                                // File offset of next data to scan
+  uint32_t       next ;                               // Offset of next frame header
+  uint32_t       fnum ;                               // Number of that frame
+  uint8_t        hdr[4] ;                             // Frame header being collected
+  uint8_t        hn ;                                 // Number of bytes in hdr
+} ;
+
+static seek_t    sk ;                                 // Seek state
+
+int              seekreq ;                            // Requested position or skip in seconds
+bool             seekrel ;                            // Request is relative (skip)
+
+// Forward declaration
+void queueToPt ( qdata_type func ) ;
+
+
+static const uint16_t seek_brtab[2][15] =             // Bitrates MPEG1, MPEG2/2.5 layer 3
+  { { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 },
+    { 0,  8, 16, 24, 32, 40, 48, 56,  64,  80,  96, 112, 128, 144, 160 } } ;
+static const uint16_t seek_srtab[3] = { 44100, 48000, 32000 } ;
+
+
+//**************************************************************************************************
+//                                   S E E K F R A M E L E N                                       *
+//**************************************************************************************************
+// Check a layer 3 frame header.  Returns the length of the frame or 0 if not valid.               *
+// Free format frames are not supported.  The sample rate and the average frame length are         *
+// returned if rate is not NULL.                                                                   *
+//**************************************************************************************************
+int seekFrameLen ( const uint8_t* h, uint32_t* rate = NULL, float* avg = NULL )
+{
+  int      ver = ( h[1] >> 3 ) & 3 ;                  // 3 = MPEG1, 2 = MPEG2, 0 = MPEG2.5
+  int      bri = h[2] >> 4 ;                          // Bitrate index
+  int      sri = ( h[2] >> 2 ) & 3 ;                  // Sample rate index
+  uint32_t sr ;                                       // Sample rate
+  float    fl ;                                       // Average frame length
+
+  if ( ( h[0] != 0xFF ) || ( ( h[1] & 0xE0 ) != 0xE0 ) ||
+       ( ver == 1 ) || ( ( h[1] & 0x06 ) != 0x02 ) || // Reserved version, not layer 3
+       ( bri == 0 ) || ( bri == 15 ) || ( sri == 3 ) )
+  {
+    return 0 ;                                        // Not valid
+  }
+  sr = seek_srtab[sri] >> ( ver == 3 ? 0 : ( ver == 2 ? 1 : 2 ) ) ;
+  fl = ( ver == 3 ) ? 144000.0f * seek_brtab[0][bri] / sr :
+                      72000.0f * seek_brtab[1][bri] / sr ;
+  if ( rate )
+  {
+    *rate = sr ;
+    *avg = fl ;
+  }
+  return (int)fl + ( ( h[2] >> 1 ) & 1 ) ;            // Add padding byte
+}
+
+
+//**************************************************************************************************
+//                                      S E E K A D D                                              *
+//**************************************************************************************************
+// Add the offset of a frame to the index.  Only the next entry is added.  If the index is full,   *
+// every second entry is removed and the distance between the entries is doubled.                  *
+//**************************************************************************************************
+void seekAdd ( uint32_t frame, uint32_t off )
+{
+  if ( ( frame % sk.step ) || ( frame / sk.step != sk.nidx ) )
+  {
+    return ;                                          // Not the next entry
+  }
+  if ( sk.nidx == SEEK_MAXIDX )                       // Index full?
+  {
+    for ( int i = 0 ; i < SEEK_MAXIDX / 2 ; i++ )     // Yes, keep every second entry
+    {
+      sk.idx[i] = sk.idx[i*2] ;
+    }
+    sk.nidx = SEEK_MAXIDX / 2 ;
+    sk.step *= 2 ;
+    if ( ( frame % sk.step ) || ( frame / sk.step != sk.nidx ) )
+    {
+      return ;
+    }
+  }
+  sk.idx[sk.nidx++] = off ;
+}
+
+
+//**************************************************************************************************
+//                                    S E E K C A C H E N A M E                                    *
+//**************************************************************************************************
+// Name of the cache file for the index of a track.  A hash of the full path is used.              *
+//**************************************************************************************************
+String seekCacheName ( const char* path )
+{
+  uint32_t h = 2166136261 ;                           // FNV-1a hash
+  char     nam[32] ;                                  // Resulting name
+
+  while ( *path )
+  {
+    h = ( h ^ (uint8_t)*path++ ) * 16777619 ;
+  }
+  sprintf ( nam, SEEK_DIR "/%08X.idx", h ) ;
+  return String ( nam ) ;
+}
+
+
+//**************************************************************************************************
+//                                      S E E K L O A D                                            *
+//**************************************************************************************************
+// Load the cached index of a track.  The cache is only used if the size of the file is the same.  *
+//**************************************************************************************************
+bool seekLoad ( const char* path )
+{
+  File      f ;                                       // Cache file
+  seekhdr_t h ;                                       // Header of cache file
+  bool      res = false ;                             // Function result
+
+  f = SD.open ( seekCacheName ( path ) ) ;
+  if ( ! f )
+  {
+    return false ;                                    // No index cached
+  }
+  if ( ( f.read ( (uint8_t*)&h, sizeof(h) ) == sizeof(h) ) &&
+       ( h.magic == SEEK_MAGIC ) &&
+       ( h.filesize == sk.filesize ) &&
+       ( h.start == sk.start ) &&
+       ( h.nidx > 0 ) && ( h.nidx <= SEEK_MAXIDX ) && ( h.step > 0 ) &&
+       ( f.read ( (uint8_t*)sk.idx, h.nidx * 4 ) == h.nidx * 4 ) )
+  {
+    sk.step = h.step ;                                // Valid cache, use it
+    sk.nidx = h.nidx ;
+    sk.frames = h.frames ;
+    sk.kframe = ( sk.nidx - 1 ) * sk.step ;           // Last known frame
+    sk.koff = sk.idx[sk.nidx - 1] ;
+    sk.cached = true ;
+    res = true ;
+  }
+  f.close() ;
+  return res ;
+}
+
+
+//**************************************************************************************************
+//                                      S E E K S A V E                                            *
+//**************************************************************************************************
+// Save the index of the current track on the SD card if it covers the complete file.              *
+//**************************************************************************************************
+void seekSave ( const char* path )
+{
+  File      f ;                                       // Cache file
+  seekhdr_t h ;                                       // Header of cache file
+
+  if ( ( ! sk.ok ) || sk.cached || ( ! sk.complete ) || ( sk.nidx < 2 ) )
+  {
+    return ;                                          // Nothing (new) to save
+  }
+  SD.mkdir ( SEEK_DIR ) ;                             // Make sure directory exists
+  f = SD.open ( seekCacheName ( path ), FILE_WRITE ) ;
+  if ( ! f )
+  {
+    return ;
+  }
+  h.magic = SEEK_MAGIC ;
+  h.filesize = sk.filesize ;
+  h.start = sk.start ;
+  h.step = sk.step ;
+  h.nidx = sk.nidx ;
+  h.frames = sk.frames ;
+  f.write ( (uint8_t*)&h, sizeof(h) ) ;
+  f.write ( (uint8_t*)sk.idx, sk.nidx * 4 ) ;
+  f.close() ;
+  sk.cached = true ;                                  // Saved
+  ESP_LOGI ( STAG, "Seek index saved, %d entries", sk.nidx ) ;
+}
+
+
+//**************************************************************************************************
+//                                     S E E K V B R I                                             *
+//**************************************************************************************************
+// Convert the table of a VBRI header to the index.  p points to "VBRI", the file is positioned    *
+// just after the fixed part of the header.                                                        *
+//**************************************************************************************************
+void seekVBRI ( const uint8_t* p )
+{
+  uint32_t entries = ( p[18] << 8 ) | p[19] ;         // Number of table entries
+  uint32_t scale = ( p[20] << 8 ) | p[21] ;           // Scale factor of entries
+  uint32_t esize = ( p[22] << 8 ) | p[23] ;           // Bytes per entry
+  uint32_t fpe = ( p[24] << 8 ) | p[25] ;             // Frames per entry
+  uint32_t off = sk.start ;                           // Offset of frame
+  uint8_t  e[4] ;                                     // One entry
+  uint32_t v ;                                        // Value of entry
+
+  sk.frames = ( p[14] << 24 ) | ( p[15] << 16 ) | ( p[16] << 8 ) | p[17] ;
+  if ( ( esize < 1 ) || ( esize > 4 ) || ( fpe == 0 ) )
+  {
+    return ;                                          // Not usable
+  }
+  sk.step = fpe ;
+  seekAdd ( 0, off ) ;
+  for ( uint32_t i = 0 ; i < entries ; i++ )
+  {
+    if ( mp3file.read ( e, esize ) != esize )
+    {
+      break ;
+    }
+    v = 0 ;
+    for ( uint32_t j = 0 ; j < esize ; j++ )
+    {
+      v = ( v << 8 ) | e[j] ;
+    }
+    off += v * scale ;
+    seekAdd ( ( i + 1 ) * fpe, off ) ;
+  }
+  sk.kframe = ( sk.nidx - 1 ) * sk.step ;             // Last known frame
+  sk.koff = sk.idx[sk.nidx - 1] ;
+  sk.cached = true ;                                  // Index complete
+}
+
+
+//**************************************************************************************************
+//                                      S E E K I N I T                                            *
+//**************************************************************************************************
+// Called when a file is opened and positioned after the ID3 tag.  Finds the first frame and       *
+// reads the Xing or VBRI header if present.  The file position is restored.                       *
+//**************************************************************************************************
+void seekInit ( const char* path )
+{
+  uint8_t* buf ;                                      // Start of audio data
+  int      n ;                                        // Bytes in buf
+  int      s ;                                        // Offset of first frame
+  int      len ;                                      // Length of first frame
+  int      q ;                                        // Offset in frame
+  uint32_t flags ;                                    // Xing flags
+  uint32_t pos = mp3file.position() ;                 // Position after ID3 tag
+  bool     mpeg1 ;                                    // MPEG1 or MPEG2(.5)
+  bool     mono ;                                     // Single channel
+
+  memset ( &sk, 0, sizeof(sk) ) ;                     // Forget previous file
+  sk.filesize = mp3file.size() ;
+  sk.step = SEEK_STEP ;
+  sk.pos = pos ;
+  buf = (uint8_t*)malloc ( SEEK_HDRBUF ) ;
+  if ( buf == NULL )
+  {
+    return ;
+  }
+  n = mp3file.read ( buf, SEEK_HDRBUF ) ;
+  mp3file.seek ( pos ) ;                              // Back to start for playing
+  for ( s = 0 ; s < n - 4 ; s++ )                     // Search first frame, confirmed by the next
+  {
+    len = seekFrameLen ( buf + s ) ;
+    if ( len && ( ( s + len + 4 > n ) || seekFrameLen ( buf + s + len ) ) )
+    {
+      break ;
+    }
+  }
+  if ( s >= n - 4 )
+  {
+    free ( buf ) ;
+    ESP_LOGI ( STAG, "No MP3 frame found, seek not possible" ) ;
+    return ;
+  }
+  uint8_t* p = buf + s ;                              // First frame
+  mpeg1 = ( ( p[1] & 0x18 ) == 0x18 ) ;
+  mono = ( ( p[3] & 0xC0 ) == 0xC0 ) ;
+  sk.start = pos + s ;
+  sk.spf = mpeg1 ? 1152 : 576 ;
+  seekFrameLen ( p, &sk.rate, &sk.avg ) ;             // Get sample rate and bitrate
+  sk.prime = ( mpeg1 ? 511 : 255 ) + 36 ;             // Max. bit reservoir plus header and side info
+  sk.ok = true ;
+  sk.next = sk.start ;
+  q = 4 + ( mpeg1 ? ( mono ? 17 : 32 ) : ( mono ? 9 : 17 ) ) ;
+  if ( ( p[1] & 0x01 ) == 0 )                         // CRC present?
+  {
+    q += 2 ;
+  }
+  if ( ( s + q + 120 <= n ) &&
+       ( ( memcmp ( p + q, "Xing", 4 ) == 0 ) || ( memcmp ( p + q, "Info", 4 ) == 0 ) ) )
+  {
+    flags = ( p[q+4] << 24 ) | ( p[q+5] << 16 ) | ( p[q+6] << 8 ) | p[q+7] ;
+    q += 8 ;
+    if ( flags & 0x01 )                               // Number of frames
+    {
+      sk.frames = ( p[q] << 24 ) | ( p[q+1] << 16 ) | ( p[q+2] << 8 ) | p[q+3] ;
+      q += 4 ;
+    }
+    sk.bytes = sk.filesize - sk.start ;               // Default for number of bytes
+    if ( flags & 0x02 )                               // Number of bytes
+    {
+      sk.bytes = ( p[q] << 24 ) | ( p[q+1] << 16 ) | ( p[q+2] << 8 ) | p[q+3] ;
+      q += 4 ;
+    }
+    if ( ( flags & 0x04 ) && sk.frames && sk.bytes )  // TOC usable?
+    {
+      memcpy ( sk.tocbuf, p + q, 100 ) ;              // Yes, remember
+      sk.toc = true ;
+    }
+  }
+  else if ( ( s + 36 + 26 <= n ) && ( memcmp ( p + 36, "VBRI", 4 ) == 0 ) )
+  {
+    mp3file.seek ( sk.start + 36 + 26 ) ;             // Table follows the header
+    seekVBRI ( p + 36 ) ;
+    mp3file.seek ( pos ) ;
+  }
+  free ( buf ) ;
+  if ( ( ! sk.toc ) && ( ! sk.cached ) )              // No TOC or index in the file?
+  {
+    sk.scan = ! seekLoad ( path ) ;                   // Try cached index, else build while playing
+  }
+  if ( sk.frames == 0 )                               // Length unknown?
+  {
+    sk.frames = ( sk.filesize - sk.start ) / sk.avg ; // Estimate
+  }
+  ESP_LOGI ( STAG, "Seek: %d Hz, %d frames, %s", sk.rate, sk.frames,
+             sk.toc ? "Xing TOC" : ( sk.cached ? "index" : "index while playing" ) ) ;
+}
+
+
+//**************************************************************************************************
+//                                      S E E K S C A N                                            *
+//**************************************************************************************************
+// Follow the frame headers in the data read for playing and add them to the index.                *
+//**************************************************************************************************
+void seekScan ( const uint8_t* buf, int n )
+{
+  uint32_t end = sk.pos + n ;                         // Offset after this data
+  int      len ;                                      // Length of frame
+
+  while ( sk.scan && ( sk.next + sk.hn < end ) )      // Header byte in this data?
+  {
+    if ( sk.next + sk.hn < sk.pos )                   // Missed it?
+    {
+      sk.scan = false ;                               // Yes, stop
+      break ;
+    }
+    sk.hdr[sk.hn] = buf[sk.next + sk.hn - sk.pos] ;
+    if ( ++sk.hn < 4 )                                // Complete header?
+    {
+      continue ;
+    }
+    sk.hn = 0 ;
+    len = seekFrameLen ( sk.hdr ) ;
+    if ( len == 0 )                                   // End of audio?
+    {
+      sk.scan = false ;                               // Yes, stop
+      sk.complete = ( sk.next + 128 + 4 >= sk.filesize ) ; // Only ID3v1 tag may follow
+      if ( sk.complete )
+      {
+        sk.frames = sk.fnum ;                         // Now length is known
+      }
+      break ;
+    }
+    seekAdd ( sk.fnum, sk.next ) ;
+    if ( sk.fnum > sk.kframe )                        // Beyond known part?
+    {
+      sk.kframe = sk.fnum ;                           // Yes, remember
+      sk.koff = sk.next ;
+    }
+    sk.fnum++ ;
+    sk.next += len ;
+  }
+  sk.pos = end ;
+  if ( sk.scan && ( sk.pos >= sk.filesize ) )         // End of file reached?
+  {
+    sk.scan = false ;
+    sk.complete = true ;
+    sk.frames = sk.fnum ;
+  }
+}
+
+
+//**************************************************************************************************
+//                                      S E E K W A L K                                            *
+//**************************************************************************************************
+// Follow the frame headers in the file from a known frame.  Returns the offset of frame "to".     *
+//**************************************************************************************************
+uint32_t seekWalk ( uint32_t frame, uint32_t off, uint32_t to )
+{
+  uint8_t h[4] ;                                      // Frame header
+  int     len ;                                       // Length of frame
+
+  while ( frame < to )
+  {
+    mp3file.seek ( off ) ;
+    if ( mp3file.read ( h, 4 ) != 4 )
+    {
+      break ;
+    }
+    if ( ( len = seekFrameLen ( h ) ) == 0 )
+    {
+      break ;                                         // Lost, use what we have
+    }
+    off += len ;
+    frame++ ;
+  }
+  return off ;
+}
+
+
+//**************************************************************************************************
+//                                   S E E K F R A M E T O O F F                                   *
+//**************************************************************************************************
+// Find the file offset of a frame.  exact is set if the offset is the start of that frame.        *
+//**************************************************************************************************
+uint32_t seekFrameToOff ( uint32_t frame, bool* exact )
+{
+  uint32_t i ;                                        // Index entry
+  float    p, a, b ;                                  // For TOC interpolation
+
+  *exact = false ;
+  if ( sk.toc )                                       // Xing TOC?
+  {
+    p = frame * 100.0f / sk.frames ;                  // Yes, percent of length
+    i = (uint32_t)p ;
+    if ( i > 99 )
+    {
+      i = 99 ;
+    }
+    a = sk.tocbuf[i] ;
+    b = ( i < 99 ) ? sk.tocbuf[i+1] : 256.0f ;
+    return sk.start + ( a + ( b - a ) * ( p - i ) ) * sk.bytes / 256.0f ;
+  }
+  if ( ( sk.nidx > 0 ) &&                             // In the indexed part?
+       ( ( frame <= sk.kframe ) || sk.cached || sk.complete ) )
+  {
+    i = frame / sk.step ;
+    if ( i >= sk.nidx )
+    {
+      i = sk.nidx - 1 ;
+    }
+    *exact = true ;                                   // Yes, walk to the exact frame
+    return seekWalk ( i * sk.step, sk.idx[i], frame ) ;
+  }
+  a = sk.avg ;                                        // Estimate from here
+  if ( sk.kframe >= SEEK_STEP )                       // Enough indexed to average?
+  {
+    a = (float)( sk.koff - sk.start ) / sk.kframe ;   // Yes, use that
+  }
+  return sk.koff + ( frame - sk.kframe ) * a ;
+}
+
+
+//**************************************************************************************************
+//                                   S E E K O F F T O F R A M E                                   *
+//**************************************************************************************************
+// Find the frame at a file offset, the reverse of seekFrameToOff.                                 *
+//**************************************************************************************************
+uint32_t seekOffToFrame ( uint32_t off )
+{
+  float    f ;                                        // Position in 1/256 of the bytes
+  uint32_t i ;                                        // Index entry
+
+  if ( off < sk.start )
+  {
+    return 0 ;
+  }
+  if ( sk.toc )                                       // Xing TOC?
+  {
+    f = ( off - sk.start ) * 256.0f / sk.bytes ;      // Yes, search the percent point
+    for ( i = 0 ; ( i < 99 ) && ( sk.tocbuf[i+1] <= f ) ; i++ ) ;
+    float a = sk.tocbuf[i] ;
+    float b = ( i < 99 ) ? sk.tocbuf[i+1] : 256.0f ;
+    f = ( b > a ) ? ( f - a ) / ( b - a ) : 0.0f ;   // Part of this percent
+    return ( i + f ) * sk.frames / 100.0f ;
+  }
+  if ( ( sk.nidx > 1 ) && ( off < sk.koff ) )         // In the indexed part?
+  {
+    for ( i = 0 ; ( i < sk.nidx - 1 ) && ( sk.idx[i+1] <= off ) ; i++ ) ;
+    f = ( i < sk.nidx - 1 ) ?                         // Average frame length of this part
+        (float)( sk.idx[i+1] - sk.idx[i] ) / sk.step : sk.avg ;
+    return i * sk.step + ( off - sk.idx[i] ) / f ;
+  }
+  f = sk.avg ;
+  if ( sk.kframe >= SEEK_STEP )
+  {
+    f = (float)( sk.koff - sk.start ) / sk.kframe ;
+  }
+  return sk.kframe + ( off - sk.koff ) / f ;
+}
+
+
+//**************************************************************************************************
+//                                          S E E K S D                                            *
+//**************************************************************************************************
+// Seek in the current file.  sec is the new position in seconds, or the number of seconds to      *
+// skip forward (backward if negative) if relative is set.  The data still in the queue and in the *
+// frame buffer of the decoder is counted as not yet played.  Returns the new position in seconds, *
+// -1 if seek is not possible.                                                                     *
+//**************************************************************************************************
+int seekSD ( int sec, bool relative )
+{
+  uint32_t t0 = millis() ;                            // For latency measurement
+  int32_t  frame ;                                    // Wanted frame
+  uint32_t off ;                                      // Its offset
+  uint32_t from ;                                     // Start reading here
+  uint32_t played ;                                   // Offset now playing
+  bool     exact ;                                    // Offset is exact
+
+  if ( ! sk.ok )
+  {
+    return -1 ;
+  }
+  played = mp3file.position() -                       // Subtract data still in the queue
+           uxQueueMessagesWaiting ( dataqueue ) * sizeof(qdata_struct::buf) ;
+  #ifdef DEC_HELIX
+    played -= min ( played, (uint32_t)mp3bcnt ) ;     // and the data in the frame buffer
+  #endif
+  frame = (int64_t)sec * sk.rate / sk.spf ;           // Frames to go
+  if ( relative )
+  {
+    frame += seekOffToFrame ( played ) ;              // Relative to current frame
+  }
+  if ( frame >= (int32_t)sk.frames )                  // Beyond end?
+  {
+    frame = sk.frames - 1 ;                           // Yes, play last frame
+  }
+  if ( frame < 0 )
+  {
+    frame = 0 ;
+  }
+  off = seekFrameToOff ( frame, &exact ) ;
+  if ( off >= sk.filesize )
+  {
+    off = sk.filesize - 1 ;
+  }
+  from = ( off > sk.start + sk.prime ) ?              // Room for the bit reservoir
+         off - sk.prime : sk.start ;
+  if ( frame == 0 )
+  {
+    from = sk.start ;                                 // Start of track, no reservoir needed
+  }
+  queueToPt ( QSTOPSONG ) ;                           // Stop and flush the player
+  mp3file.seek ( from ) ;
+  mp3filelength = sk.filesize - from ;                // Rest of the file
+  sk.pos = from ;                                     // Data for scan starts here
+  sk.hn = 0 ;
+  sk.scan = exact && ! ( sk.complete || sk.cached ) ; // Index can be extended from an exact frame
+  sk.next = off ;
+  sk.fnum = frame ;
+  queueToPt ( QSTARTSONG ) ;                          // and restart
+  ESP_LOGI ( STAG, "Seek to frame %d at offset %d (%s) in %d msec",
+             frame, off,
+             sk.toc ? "TOC" : ( exact ? "index" : "estimate" ),
+             millis() - t0 ) ;
+  return frame * sk.spf / sk.rate ;
+}
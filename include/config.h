@@ -10,6 +10,9 @@
                                                             // Default is "ESP32-Radio"
 
   //#define SDCARD                                          // Experimental: For SD card support (reading MP3-files)
+  //#define SDSPEED 20000000                                // SPI clock of the SD card, default 2 MHz.  FLAC needs
+                                                            // about 2 MHz for 44.1 kHz/16 bits, 8 MHz for 96 kHz/24 bits
+  //#define QSIZ 800                                        // Entries of 32 bytes in the data queue, default 400
 
   //#define ETHERNET                                        // For wired Ethernet (WT32-ETH-01 or similar)
 
@@ -24,8 +27,18 @@
   //#define DEC_VS1003                                      // Hardware decoder for MP3 only
   //#define DEC_HELIX                                       // Software decoder for MP3, AAC. I2S output
   //#define DEC_HELIX_SPDIF                                 // Toslink/Spdif output for MP3, AAC
+  //#define HELIX_SPDIF24                                   // Spdif only: 24 bit samples, volume keeps resolution
   //#define DEC_HELIX_AI                                    // Software decoder for AI Audio kit (AC101)
   //#define DEC_HELIX_INT                                   // Software decoder for MP3, AAC. DAC output
+  //#define HELIX_PLACEMENT 1                               // Helix only: 1 = hot decoder functions in IRAM,
+                                                            // 2 = also most used tables in DRAM
+  //#define HELIX_DUALCORE                                  // Helix only: decode on core 0, output on core 1,
+                                                            // MP3 IMDCT and synthesis also on core 1
+  //#define HELIX_FIXEDRATE 48000                           // Helix only: resample all streams to this I2S rate
+  //#define HELIX_PROFILE                                   // Helix only: "test" shows cycles per decoder stage
+  //#define HELIX_OPUS                                      // Helix only: Ogg Opus streams (libopus, about 28 kB heap),
+                                                            // set by the esp32-opus environment of platformio.ini
+  //#define HELIX_DMAMS 40                                  // Helix only: I2S DMA depth in msec, default 70 (35 SPDIF)
   
   // Define (just one) type of display.  See documentation.
   #define BLUETFT                                           // Works also for RED TFT 128x160
@@ -0,0 +1,124 @@
+// driftfuncs.h
+// Compensation of the clock difference between the sender of a stream and the audio clock of the
+// ESP32.  Without it, the stream queue slowly fills up (packets dropped) or runs empty (underrun).
+// Every second the fill of the queue is measured and filtered.  A PI controller computes a rate
+// trim in ppm that keeps the queue half full.  The trim is sent to player_AdjustRate(), the VS1053
+// uses its own resampler, the Helix decoder drops or inserts a frame now and then.
+// The loop is slow on purpose (about 1 hour), the network jitter is much faster than the drift.
+//
+#define DRIFT_AVG       30                           // Time constant of fill filter in seconds
+#define DRIFT_SETTLE    20                           // Seconds to wait after start of stream
+#define DRIFT_KP        3500.0f                      // ppm per second of audio above target
+#define DRIFT_KI        3.0f                         // ppm per second per second of audio error
+#define DRIFT_MAXPPM    300                          // Max. trim in ppm
+#define DRIFT_LOGSECS   300                          // Log the drift estimate every 5 minutes
+
+struct drift_t                                       // State of drift controller
+{
+  bool           on ;                                // Controller enabled
+  int            secs ;                              // Seconds since start of stream
+  float          fill ;                              // Filtered queue fill in seconds of audio
+  float          target ;                            // Wanted fill in seconds of audio
+  float          integ ;                             // Integral part, the drift estimate in ppm
+  int            ppm ;                               // Current trim in ppm
+} ;
+
+static drift_t   drift = { true, 0, 0.0f, 0.0f, 0.0f, 0 } ;
+
+
+//**************************************************************************************************
+//                                    D R I F T S E T R A T E                                      *
+//**************************************************************************************************
+// Send a new trim to the decoder.  AdjustRate works in ppm2 (0.5 ppm) units.                      *
+//**************************************************************************************************
+void driftSetRate ( int ppm )
+{
+  if ( ppm != drift.ppm )                            // Change?
+  {
+    drift.ppm = ppm ;                                // Yes, remember
+    player_AdjustRate ( (long)ppm * 2 ) ;            // and set
+  }
+}
+
+
+//**************************************************************************************************
+//                                    D R I F T S E T M O D E                                      *
+//**************************************************************************************************
+// Switch the controller on or off.  The trim of the controller is removed.                        *
+//**************************************************************************************************
+void driftSetMode ( bool on )
+{
+  drift.on = on ;
+  drift.secs = 0 ;                                   // Start again
+  drift.integ = 0.0f ;
+  driftSetRate ( 0 ) ;                               // No trim
+}
+
+
+//**************************************************************************************************
+//                                    D R I F T C O N T R O L                                      *
+//**************************************************************************************************
+// Called every second.  Streaming is true if a network stream is playing, fill is the number      *
+// of chunks in the queue of qsize chunks of chunkbytes bytes and kbps is the measured bitrate.    *
+//**************************************************************************************************
+void driftControl ( bool streaming, int fill, int qsize, int chunkbytes, int kbps )
+{
+  float sec ;                                        // Fill in seconds of audio
+  float err ;                                        // Deviation from target in seconds
+  float p ;                                          // New trim
+
+  if ( ! drift.on )                                  // Controller active?
+  {
+    return ;                                         // No, manual "rate" or off
+  }
+  if ( ( ! streaming ) || ( kbps <= 0 ) )            // Network stream with known bitrate?
+  {
+    drift.secs = 0 ;                                 // No, start again at next stream
+    driftSetRate ( 0 ) ;                             // Remove trim
+    return ;
+  }
+  sec = (float)fill * chunkbytes * 8 / ( kbps * 1000.0f ) ;
+  if ( drift.secs++ < DRIFT_SETTLE )                 // Initial burst still in progress?
+  {
+    drift.fill = sec ;                               // Yes, start filter at current value
+    drift.target = (float)qsize * chunkbytes * 4 /   // Half full queue in seconds
+                   ( kbps * 1000.0f ) ;
+    return ;
+  }
+  drift.fill += ( sec - drift.fill ) / DRIFT_AVG ;   // Filter out network jitter
+  err = drift.fill - drift.target ;                  // Positive if queue fills up, play faster
+  p = DRIFT_KP * err + drift.integ ;                 // PI controller
+  if ( p > DRIFT_MAXPPM )                            // Limit output
+  {
+    p = DRIFT_MAXPPM ;
+  }
+  else if ( p < -DRIFT_MAXPPM )
+  {
+    p = -DRIFT_MAXPPM ;
+  }
+  else
+  {
+    drift.integ += DRIFT_KI * err ;                  // Integrate if not saturated (anti windup)
+  }
+  driftSetRate ( lroundf ( p ) ) ;
+  if ( ( drift.secs % DRIFT_LOGSECS ) == 0 )         // Time to log?
+  {
+    ESP_LOGI ( "drift", "Queue %.2f sec (target %.2f), trim %d ppm, drift estimate %d ppm",
+               drift.fill, drift.target, drift.ppm, (int)drift.integ ) ;
+  }
+}
+
+
+//**************************************************************************************************
+//                                    D R I F T R E P O R T                                        *
+//**************************************************************************************************
+// Show the state of the controller for the "test" command.                                        *
+//**************************************************************************************************
+void driftReport()
+{
+  log_printf ( "Drift control %s, queue %.2f sec (target %.2f), "
+               "trim %d ppm, drift estimate %d ppm\n",
+               drift.on ? "on" : "off",
+               drift.fill, drift.target,
+               drift.ppm, (int)drift.integ ) ;
+}
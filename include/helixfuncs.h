@@ -1,76 +1,267 @@
 // helixfuncs.h
 // Functions for HELIX decoder.
-// Code for SPDIF leans heavily on https://github.com/earlephilhower/ESP8266Audio/blob/master/src/AudioOutputSPDIF.cpp
+// SPDIF output is encoded by spdif_encoder.cpp in lib/codecs/src.
+// A crossfade decodes the old stream as a second "voice" next to the new one, see helixXfadeChunk().
+// Loudness normalization measures the stream (EBU R128), see helixLoudMeter().
 //
 // 26-04-2023, ES: correction setting disable_pin
 #include "config.h"
+#include <utility>                                   // For std::swap
+#ifdef HELIX_FIXEDRATE
+  #include "resampler.h"                             // Sample rate converter
+#endif
+#ifdef DEC_HELIX_SPDIF
+  #include "spdif_encoder.h"                         // Biphase mark encoder for SPDIF
+#endif
 
-#define player_AdjustRate(a)                         // Not supported function
-#define player_setTone(a)                            // Not supported function
 
 #define FRAMESIZE               1600                 // Max. frame size in bytes (mp3 and aac)
-#define OUTSIZE                 1152                 // Max number of samples per channel (mp3 and aac)
-                                                     // AAC is max 1024, MP3 is 1152
+#define SYNCSIZE                ( 3 * FRAMESIZE )    // Room to confirm the first frame by the next two
+#ifdef AAC_ENABLE_SBR
+  #define OUTSIZE               2048                 // Max number of samples per channel (HE-AAC)
+#else
+  #define OUTSIZE               1152                 // Max number of samples per channel (mp3 and aac)
+#endif
+                                                     // AAC and Vorbis are max 1024, HE-AAC 2048, MP3 1152,
+                                                     // Opus is max 960 per call, FLAC and WAV max 1152
 #define I2SSIZE                 128                  // For I2S buffer (16/32 bits words).  Multiple of 8.
+#ifdef HELIX_FIXEDRATE
+  #define I2SRATE       HELIX_FIXEDRATE              // I2S clock is fixed, streams are resampled
+  #define SRCFRAMES     256                          // Output frames per call of the resampler
+#else
+  #define I2SRATE       44100                        // Initial I2S rate, set per stream
+#endif
+#define SBR_OFF                 0                    // HE-AAC: always bypass SBR, play core AAC only
+#define SBR_ON                  1                    // HE-AAC: always decode SBR
+#define SBR_AUTO                2                    // HE-AAC: bypass SBR if CPU or RAM is short
+#define SBR_MAXLOAD             80                   // Auto: max. decode time in percent of real time
+#define SBR_MINHEAP             30000                // Auto: min. free internal RAM for SBR
+#define SBR_TESTFRAMES          32                   // Auto: number of frames to measure the load
+#define TONE_QBITS              28                   // Fraction bits of tone filter coefficients
+#define TONE_XBITS              8                    // Extra fraction bits of tone filter state
+#define LN_QBITS                14                   // Fraction bits of the output gain
+#define LN_BLOCKMS              400                  // Loudness: length of a measuring block
+#define LN_BINS                 70                   // Loudness: histogram of blocks, 1 LU from -70 LUFS
+#define LN_MINBLOCKS            50                   // Loudness: 20 seconds measured before adapting
+#define LN_MINGAIN              -150                 // Loudness: min. gain in 0.1 dB
+#define LN_MAXGAIN              60                   // Loudness: max. gain in 0.1 dB, output saturates
+#define LN_RGREF                -180                 // Loudness: ReplayGain reference, -18 LUFS in 0.1 LU
+#define LN_UNKNOWN              -32767               // Loudness: not known, start at 0 dB
+#define LN_KEEP                 -32768               // Loudness: not known, keep current gain
+#define XF_MAXSECS              8                    // Crossfade: max. length in seconds
+#define XF_MINMS                1000                 // Crossfade: shorter fades are not done
+#define XF_MAXLOAD              40                   // Crossfade: max. decoder load (percent) to start
+#define XF_ABORTLOAD            85                   // Crossfade: max. load of both decoders, else cut
+#define XF_MINHEAP              30000                // Crossfade: min. free internal RAM for 2 decoders
+#define OUTSTACK                5000                 // Dual core: stack of the output task, see helixOutTask
+#define GRANSLOTS               2                    // Dual core: MP3 granules between stage 1 and 2
+#define XF_TESTDIV              4                    // Crossfade: load checked every 1/4 second
+#define XF_ARMTIME              10000                // Crossfade: max. msec to wait for the new station
+#define XF_KEEP                 OUTSIZE              // Crossfade: frames of old stream ready for mixing
+#define XF_FIFOSIZE             ( 2 * OUTSIZE )      // Crossfade: max. frames of old stream buffered
+#define XF_IDLE                 0                    // Crossfade: not active
+#define XF_PENDING              1                    // Crossfade: QFADESONG not yet seen by playtask
+#define XF_ARMED                2                    // Crossfade: old stream from fadequeue, no new yet
+#define XF_WAIT                 3                    // Crossfade: new stream started, no output yet
+#define XF_FADE                 4                    // Crossfade: both streams mixed
+#define XF_TAIL                 5                    // Crossfade refused: play rest of old track first
 
 extern bool      muteflag ;                          // True if output must be muted
 extern String    audio_ct ;                          // Content type, like "audio/aacp"
+void             playChunk ( const uint8_t* chunk ) ; // Forward declarations for the crossfade
+void             helixNextTrack() ;
 
 static int16_t   vol ;                               // Volume 0..100 percent
 static bool      mp3mode ;                           // True if mp3 input (not aac)
-static uint8_t   mp3buff[FRAMESIZE+32] ;             // Space for enough chunks to hold one frame
+static bool      oggmode ;                           // True if Ogg (Vorbis or Opus) input
+static bool      opusmode ;                          // True if Ogg Opus input
+static bool      flacmode ;                          // True if FLAC input (native or Ogg)
+static bool      wavmode ;                           // True if WAV input (PCM, no decoding)
+static bool      oggprobe ;                          // True if codec of Ogg stream not known yet
+static uint8_t   mp3buf0[SYNCSIZE+32] ;              // Space for enough chunks to find the first frame
+static uint8_t*  mp3buff = mp3buf0 ;                 // Frame buffer of the current stream
 static uint8_t*  mp3bpnt ;                           // Points into mp3buff
 static int       mp3bcnt ;                           // Number of samples in buffer
 static bool      searchFrame ;                       // True if search for startframe is needed
+static uint32_t  id3skip ;                           // Number of bytes of ID3 tag still to skip
 static int16_t   outbuf[OUTSIZE*2] ;                 // MP3 output (PCM) buffer
+static uint32_t  dec_frames ;                        // Number of frames decoded, for "test" command
+static uint64_t  dec_cycles ;                        // Total CPU cycles used by the decoder
+static uint32_t  dec_maxcycles ;                     // Max. cycles for one frame
+static uint8_t   dec_load ;                          // Decoder load in percent, last second
+static uint64_t  ld_cycles ;                         // Cycles for dec_load measurement
+static uint32_t  ld_frames ;                         // Output frames for dec_load measurement
+static uint32_t  br_bytes ;                          // Input bytes of current stream, for byte rate
+static uint32_t  br_frames ;                         // Output frames of current stream, for byte rate
+static MP3Decoder_t* mp3ctx ;                        // MP3 decoder instance, NULL is the default one
+static AACDecoder_t* aacctx ;                        // AAC decoder instance, NULL is the default one
+#ifdef DEC_HELIX_INT
+  static bool    halfrate = true ;                   // 8 bit DAC: decode MP3 at half the sample rate
+#else
+  static bool    halfrate = false ;                  // Decode MP3 at full sample rate
+#endif
+static int64_t   rep_time ;                          // Time (usec) of last report
+static uint8_t   sbrmode = SBR_AUTO ;                // SBR mode from "sbr" preference
+static int8_t    sbrpreset = -1 ;                    // SBR mode forced for this preset, -1 if not
+static bool      sbrbypass ;                         // SBR bypassed for this stream
+static uint32_t  sbr_frames ;                        // Frames measured for SBR auto mode
+static uint64_t  sbr_cycles ;                        // Cycles used by these frames
+struct biquad_t                                      // Shelving filter for tone control
+{
+  int32_t        b0, b1, b2, a1, a2 ;                // Coefficients, TONE_QBITS fraction bits
+  bool           on ;                                // Filter active (gain is not 0 dB)
+  int32_t        s[2][4] ;                           // State x1, x2, y1, y2 per channel
+} ;
+static biquad_t  tonefilt[2] ;                       // Treble (high shelf) and bass (low shelf)
+static uint8_t   tonenib[4] ;                        // Requested tone, same nibbles as VS1053 SCI_BASS
+static volatile bool tonechange ;                    // New tone setting, coefficients to be computed
+static uint32_t  tonerate ;                          // Sample rate of current coefficients
+static uint64_t  tone_cycles ;                       // Cycles used by the tone filters
+struct loud_t                                        // Loudness meter and normalization
+{
+  int8_t         target ;                            // From "loudness" setting in LUFS, 0 is off
+  volatile int16_t next ;                            // Loudness of next track in 0.1 LUFS, see helixLoudNext
+  volatile bool  nextfix ;                           // Next loudness from tags, do not adapt
+  bool           fixed ;                             // Loudness of current track from tags
+  int16_t        gain ;                              // Current gain in 0.1 dB
+  volatile int16_t integ ;                           // Integrated loudness in 0.1 LUFS, LN_UNKNOWN if not yet
+  uint32_t       rate ;                              // Sample rate of the K-weighting filters
+  biquad_t       kw[2] ;                             // K-weighting (BS.1770) at half the sample rate
+  bool           half ;                              // Frame skipped, every other frame is measured
+  uint64_t       sum ;                               // Sum of squares in current block
+  uint32_t       cnt ;                               // Decimated frames in current block
+  uint32_t       blk ;                               // Decimated frames in one block
+  uint32_t       hist[LN_BINS] ;                     // Number of blocks per LU above -70 LUFS
+  float          energy[LN_BINS] ;                   // Sum of the mean squares of these blocks
+  uint32_t       blocks ;                            // Number of blocks in hist
+  uint64_t       cycles ;                            // Cycles used by the meter
+} ;
+static loud_t    ln = { 0, LN_KEEP, false, false,    // Loudness state, meter cleared
+                        0, LN_UNKNOWN, 0, {}, false,
+                        0, 0, 0, {}, {}, 0, 0 } ;
+static volatile int32_t outgain ;                    // Output gain, volume times loudness gain, set by
+                                                     // helixSetGain, 0 like the volume until then
+static int32_t   slip_ppm2 ;                         // Rate trim in 0.5 ppm units, see player_AdjustRate
+static int64_t   slip_acc ;                          // Accumulated trim, one frame is 2000000
+static uint32_t  slip_drop ;                         // Number of frames dropped to play faster
+static uint32_t  slip_ins ;                          // Number of frames inserted to play slower
+static uint32_t  samprate ;                          // Sample rate of current stream
+static int       channels ;                          // Number of channels
+static int       smpbytes ;                          // Number of bytes for I2S
+static int       smpwords ;                          // Number of 16 bit words for I2S
+static bool      once ;                              // Get stream parameters from next frame
+static int       gl_skip ;                           // Gapless: samples per channel still to skip
+static int32_t   gl_left = -1 ;                      // Gapless: samples per channel left, -1 unknown
+struct voice_t                                       // Decoding state of one stream, see helixSwapVoice
+{
+  bool           mp3mode, oggmode, opusmode ;        // Same as the globals
+  bool           flacmode, wavmode, oggprobe ;
+  uint8_t*       mp3buff ;
+  uint8_t*       mp3bpnt ;
+  int            mp3bcnt ;
+  bool           searchFrame ;
+  uint32_t       id3skip ;
+  uint32_t       samprate ;
+  int            channels ;
+  int            smpbytes ;
+  int            smpwords ;
+  bool           once ;
+  int            gl_skip ;
+  int32_t        gl_left ;
+  bool           sbrbypass ;
+  uint32_t       sbr_frames ;
+  uint64_t       sbr_cycles ;
+  MP3Decoder_t*  mp3ctx ;
+  AACDecoder_t*  aacctx ;
+} ;
+struct xfade_t                                       // Crossfade between two streams
+{
+  volatile uint8_t state ;                           // XF_IDLE, XF_PENDING, ...
+  uint8_t        secs ;                              // Length from "crossfade" setting, 0 is off
+  uint32_t       ms ;                                // Max. length for this fade
+  bool           tail ;                              // SD: old track may not be cut
+  bool           eof ;                               // End of old stream seen
+  int64_t        t_armed ;                           // Time (usec) old stream went to fadequeue
+  voice_t        v ;                                 // Old stream while the new one is current
+  int16_t*       pcm ;                               // Decoder output of old stream
+  int16_t*       fifo ;                              // Old stream, stereo, waiting for mixing
+  int            fifocnt ;                           // Frames in fifo
+  uint32_t       len ;                               // Length of fade in frames
+  uint32_t       pos ;                               // Frames mixed so far
+  uint64_t       cycles ;                            // Cycles of both decoders for load check
+  uint32_t       frames ;                            // Frames output for load check
+  uint32_t       fades ;                             // Number of fades done
+  uint32_t       cuts ;                              // Number of fades refused or aborted
+  uint32_t       under ;                             // Frames without old stream data
+} ;
+static xfade_t   xf ;                                // Crossfade state
+static bool      xfvoice ;                           // Globals hold the old stream of a crossfade
+#ifdef HELIX_FIXEDRATE
+  static int16_t  srcbuf[SRCFRAMES*2] ;              // Output of the resampler
+  static uint64_t src_cycles ;                       // Cycles used by the resampler
+#endif
+#ifdef HELIX_DUALCORE
+  struct pcmblock_t                                  // Decoded frame for the output task
+  {
+    int16_t*     buf ;                               // Points to outbuf or outbuf2
+    int          words ;                             // Number of 16 bit samples in buf
+    bool         mono ;                              // Mono, right sample equals left sample
+    bool         start ;                             // First frame of stream, (re)start I2S
+    uint32_t     rate ;                              // I2S sample rate for start, 0 is no change
+    int64_t      t_start ;                           // Time (usec) the frame was ready for decoding
+    MP3Granule_t* gran ;                             // MP3 granule for stage 2, NULL if buf is PCM
+    MP3Decoder_t* ctx ;                              // Decoder instance of the granule
+    int          skip ;                              // Frames of the granule to drop (gapless trim)
+    uint32_t     samprate ;                          // Sample rate of the granule for helixPost
+  } ;
+  static int16_t       outbuf2[OUTSIZE*2] ;          // Second PCM buffer for the output task
+  static MP3Granule_t  granbuf[GRANSLOTS] ;          // Frequency domain data from stage 1
+  static int16_t       granpcm[m_MAX_NSAMP*2] ;      // PCM of a granule from stage 2
+  static QueueHandle_t pcmfull ;                     // Decoded frames for the output task
+  static QueueHandle_t pcmfree ;                     // Buffers given back by the output task
+  static QueueHandle_t granfree ;                    // Granule buffers given back by the output task
+  static uint64_t      syn_cycles ;                  // Cycles of stage 2 of MP3 in the output task
+  static TaskHandle_t  xouttask ;                    // Task handle of the output task
+  static uint32_t      out_frames ;                  // Number of frames sent to I2S
+  static uint64_t      out_cycles ;                  // Cycles used by output task, I2S wait excluded
+  static uint32_t      out_i2swait ;                 // Cycles waiting for DMA for current frame   
+  static uint64_t      lat_total ;                   // Sum of latencies (usec)
+  static uint32_t      lat_max ;                     // Max. latency
+#endif
 
 const  char*     HTAG = "helixfuncs" ;
 
 #ifdef DEC_HELIX_SPDIF
-  // BMC (Biphase Mark Coded) values (bit order reversed, i.e. LSB first)
-  static const uint16_t PROGMEM spdif_bmclookup[256] =
-    { 
-      0xcccc, 0x4ccc, 0x2ccc, 0xaccc, 0x34cc, 0xb4cc, 0xd4cc, 0x54cc, // 00..07
-      0x32cc, 0xb2cc, 0xd2cc, 0x52cc, 0xcacc, 0x4acc, 0x2acc, 0xaacc, // 08..0F
-      0x334c, 0xb34c, 0xd34c, 0x534c, 0xcb4c, 0x4b4c, 0x2b4c, 0xab4c, // 10..17
-      0xcd4c, 0x4d4c, 0x2d4c, 0xad4c, 0x354c, 0xb54c, 0xd54c, 0x554c, // 18..1F
-      0x332c, 0xb32c, 0xd32c, 0x532c, 0xcb2c, 0x4b2c, 0x2b2c, 0xab2c, // 20..27
-      0xcd2c, 0x4d2c, 0x2d2c, 0xad2c, 0x352c, 0xb52c, 0xd52c, 0x552c, // 28..2F
-      0xccac, 0x4cac, 0x2cac, 0xacac, 0x34ac, 0xb4ac, 0xd4ac, 0x54ac, // 30..37
-      0x32ac, 0xb2ac, 0xd2ac, 0x52ac, 0xcaac, 0x4aac, 0x2aac, 0xaaac, // 38..3F
-      0x3334, 0xb334, 0xd334, 0x5334, 0xcb34, 0x4b34, 0x2b34, 0xab34, // 40..47
-      0xcd34, 0x4d34, 0x2d34, 0xad34, 0x3534, 0xb534, 0xd534, 0x5534, // 48..4F
-      0xccb4, 0x4cb4, 0x2cb4, 0xacb4, 0x34b4, 0xb4b4, 0xd4b4, 0x54b4, // 50..57
-      0x32b4, 0xb2b4, 0xd2b4, 0x52b4, 0xcab4, 0x4ab4, 0x2ab4, 0xaab4, // 58..5F
-      0xccd4, 0x4cd4, 0x2cd4, 0xacd4, 0x34d4, 0xb4d4, 0xd4d4, 0x54d4, // 60..67
-      0x32d4, 0xb2d4, 0xd2d4, 0x52d4, 0xcad4, 0x4ad4, 0x2ad4, 0xaad4, // 68..6F
-      0x3354, 0xb354, 0xd354, 0x5354, 0xcb54, 0x4b54, 0x2b54, 0xab54, // 70..77
-      0xcd54, 0x4d54, 0x2d54, 0xad54, 0x3554, 0xb554, 0xd554, 0x5554, // 78..7F
-      0x3332, 0xb332, 0xd332, 0x5332, 0xcb32, 0x4b32, 0x2b32, 0xab32, // 80..87
-      0xcd32, 0x4d32, 0x2d32, 0xad32, 0x3532, 0xb532, 0xd532, 0x5532, // 88..8F
-      0xccb2, 0x4cb2, 0x2cb2, 0xacb2, 0x34b2, 0xb4b2, 0xd4b2, 0x54b2, // 90..97
-      0x32b2, 0xb2b2, 0xd2b2, 0x52b2, 0xcab2, 0x4ab2, 0x2ab2, 0xaab2, // 98..9F
-      0xccd2, 0x4cd2, 0x2cd2, 0xacd2, 0x34d2, 0xb4d2, 0xd4d2, 0x54d2, // A0..A7
-      0x32d2, 0xb2d2, 0xd2d2, 0x52d2, 0xcad2, 0x4ad2, 0x2ad2, 0xaad2, // A8..AF
-      0x3352, 0xb352, 0xd352, 0x5352, 0xcb52, 0x4b52, 0x2b52, 0xab52, // B0..B7
-      0xcd52, 0x4d52, 0x2d52, 0xad52, 0x3552, 0xb552, 0xd552, 0x5552, // B8..BF
-      0xccca, 0x4cca, 0x2cca, 0xacca, 0x34ca, 0xb4ca, 0xd4ca, 0x54ca, // C0..C7
-      0x32ca, 0xb2ca, 0xd2ca, 0x52ca, 0xcaca, 0x4aca, 0x2aca, 0xaaca, // C8..CF
-      0x334a, 0xb34a, 0xd34a, 0x534a, 0xcb4a, 0x4b4a, 0x2b4a, 0xab4a, // D0..D7
-      0xcd4a, 0x4d4a, 0x2d4a, 0xad4a, 0x354a, 0xb54a, 0xd54a, 0x554a, // D8..DF
-      0x332a, 0xb32a, 0xd32a, 0x532a, 0xcb2a, 0x4b2a, 0x2b2a, 0xab2a, // E0..E7
-      0xcd2a, 0x4d2a, 0x2d2a, 0xad2a, 0x352a, 0xb52a, 0xd52a, 0x552a, // E8..EF
-      0xccaa, 0x4caa, 0x2caa, 0xacaa, 0x34aa, 0xb4aa, 0xd4aa, 0x54aa, // F0..F7
-      0x32aa, 0xb2aa, 0xd2aa, 0x52aa, 0xcaaa, 0x4aaa, 0x2aaa, 0xaaaa  // F8..FF
-    } ;
-    const uint32_t VUCP_PREAMBLE_B = 0xCCE80000 ;     // 11001100 11101000
-    const uint32_t VUCP_PREAMBLE_M = 0xCCE20000 ;     // 11001100 11100010
-    const uint32_t VUCP_PREAMBLE_W = 0xCCE40000 ;     // 11001100 11100100
+  #ifdef HELIX_SPDIF24
+    #define SPDIF_BITS        24                      // Bits per sample on SPDIF
+    static int32_t  spdifpcm[I2SSIZE/2] ;             // Stereo samples for the SPDIF encoder
+  #else
+    #define SPDIF_BITS        16                      // Bits per sample on SPDIF
+    static int16_t  spdifpcm[I2SSIZE/2] ;             // Stereo samples for the SPDIF encoder
+  #endif
     static uint32_t i2sbuf[I2SSIZE] ;                 // Buffer for I2S biphase buffer
 #else
     static int16_t  i2sbuf[I2SSIZE] ;                 // Buffer for I2S
 #endif
 
+//**************************************************************************************************
+//                                  H E L I X S E T G A I N                                        *
+//**************************************************************************************************
+// Compute the gain of the output stage from the volume and the loudness normalization.            *
+// The AI Audio kit sets the volume in the codec, only the loudness gain is applied here.          *
+//**************************************************************************************************
+void helixSetGain()
+{
+  float g = powf ( 10.0f, ln.gain / 200.0f ) *        // Loudness gain is in 0.1 dB
+            ( 1 << LN_QBITS ) ;
+
+  #ifndef DEC_HELIX_AI
+    g = g * vol / 100 ;                               // Times volume
+  #endif
+  outgain = (int32_t)g ;                              // Used by outputSample
+}
+
+
 //**************************************************************************************************
 //                              P L A Y E R _ S E T V O L U M E                                    *
 //**************************************************************************************************
@@ -87,6 +278,7 @@ void player_setVolume ( int16_t v )
       dac.SetVolumeSpeaker ( db ) ;                    // Set volume control of amplifier
       dac.SetVolumeHeadphone ( db ) ;
     #endif
+    helixSetGain() ;                                   // New gain for the output stage
   }
 }
 
@@ -103,228 +295,2665 @@ int16_t player_getVolume()
 
 
 //**************************************************************************************************
-//                                    H E L I X I N I T                                            *
+//                             P L A Y E R _ A D J U S T R A T E                                   *
 //**************************************************************************************************
-// Initialize helix buffering.                                                                     *
+// Fine tune the output rate, same unit as for the VS1053 (ppm2, 0.5 ppm).  Positive is faster.    *
+// The I2S clock is not changed, a frame is dropped or inserted now and then (see outputBlock).    *
 //**************************************************************************************************
-void helixInit ( int8_t enable_pin, int8_t disable_pin )
+void player_AdjustRate ( long ppm2 )
 {
-  ESP_LOGI ( HTAG, "helixInit called for %s",         // Show activity
-             audio_ct.c_str() ) ;
-  mp3mode = ( audio_ct.indexOf ( "mpeg" ) > 0 ) ;     // Set mp3/aac mode
-  mp3bpnt = mp3buff ;                                 // Reset pointer
-  mp3bcnt = 0 ;                                       // Buffer empty
-  searchFrame = true ;                                // Start searching for frame
-  if ( enable_pin >= 0 )                              // Enable pin defined?
+  slip_ppm2 = ppm2 ;                                  // Used by output
+}
+
+
+//**************************************************************************************************
+//                                P L A Y E R _ S E T T O N E                                      *
+//**************************************************************************************************
+// Set bass/treble.  Same 4 nibbles as the SCI_BASS register of the VS1053:                        *
+//   rtone[0] : Treble gain, -8..7 in steps of 1.5 dB (ST_AMPLITUDE)                               *
+//   rtone[1] : Treble lower limit frequency in kHz, 1..15 (ST_FREQLIMIT)                          *
+//   rtone[2] : Bass boost, 0..15 dB (SB_AMPLITUDE)                                                *
+//   rtone[3] : Bass upper limit frequency in 10 Hz steps, 2..15 (SB_FREQLIMIT)                    *
+// The filter coefficients are computed by playtask before the next frame.                         *
+//**************************************************************************************************
+void player_setTone ( uint8_t* rtone )
+{
+  for ( int i = 0 ; i < 4 ; i++ )
   {
-    pinMode ( enable_pin, OUTPUT ) ;                  // Yes, set pin to output
-    digitalWrite ( enable_pin, HIGH ) ;               // Enable output
+    tonenib[i] = rtone[i] & 0x0F ;                    // Copy nibble
   }
-  if ( disable_pin >= 0 )                             // Disable pin defined?
+  tonechange = true ;                                 // Playtask will compute new coefficients
+}
+
+
+//**************************************************************************************************
+//                               H E L I X S E T H A L F R A T E                                   *
+//**************************************************************************************************
+// Switch half rate MP3 decoding on or off.  Only subbands 0..15 are decoded and the output has    *
+// half the sample rate.  Saves CPU time if the output cannot reproduce high frequencies anyway.   *
+// Opus is decoded at 24 kHz then.                                                                 *
+// Takes effect at the start of the next stream.                                                   *
+//**************************************************************************************************
+void helixSetHalfRate ( bool on )
+{
+  halfrate = on ;                                     // Remember for next helixInit
+  ESP_LOGI ( HTAG, "Half rate decoding %s",
+             on ? "on" : "off" ) ;
+}
+
+
+//**************************************************************************************************
+//                               H E L I X S E T S B R M O D E                                     *
+//**************************************************************************************************
+// Set the SBR mode for HE-AAC streams: "off", "on" or "auto" (also 0, 1 or 2).                    *
+// If "preset" is true, the mode is forced for the current preset only.  A NULL value removes     *
+// the forced mode.  Takes effect at the start of the next stream.                                 *
+//**************************************************************************************************
+void helixSetSBRMode ( const char* val, bool preset )
+{
+  int8_t mode = SBR_AUTO ;                            // Assume auto mode
+
+  if ( val == NULL )                                  // No value?
   {
-    pinMode ( disable_pin, OUTPUT ) ;                 // Yes, set pin to output
-    digitalWrite ( disable_pin, LOW ) ;               // Enable output
+    mode = -1 ;                                       // Yes, not forced
+  }
+  else if ( ( strcmp ( val, "off" ) == 0 ) ||         // Bypass SBR?
+            ( strcmp ( val, "0" ) == 0 ) )
+  {
+    mode = SBR_OFF ;
+  }
+  else if ( ( strcmp ( val, "on" ) == 0 ) ||          // Always SBR?
+            ( strcmp ( val, "1" ) == 0 ) )
+  {
+    mode = SBR_ON ;
+  }
+  if ( preset )                                       // For this preset only?
+  {
+    sbrpreset = mode ;                                // Yes, remember
+  }
+  else if ( mode >= 0 )
+  {
+    sbrmode = mode ;                                  // Set default mode
+    ESP_LOGI ( HTAG, "SBR mode set to %d", mode ) ;
   }
 }
 
 
 //**************************************************************************************************
-//                               O U T P U T S A M P L E                                           *
+//                             H E L I X S E T C R O S S F A D E                                   *
 //**************************************************************************************************
-// Add a sample to the I2S buffer.  Send to I2S driver if buffer is full.                          *
-// For SPDIFF: convert to a valid frame.  16-bit sample to a frame of 2 x 32 bits.                 *
+// Set the length of the crossfade between SD tracks and between stations in seconds, 0 is off.    *
 //**************************************************************************************************
-void outputSample ( int16_t c )
+void helixSetCrossfade ( int secs )
 {
-  static uint8_t  frame_num = 0 ;                     // Frame number for spdif
-  static bool     left = true ;                       // Switch between left and right sample
-  static uint8_t  i2sinx = 0 ;                        // Index in i2sbuf
-  size_t          bw ;                                // Number of bytes written to I2S
-  
-  #ifndef DEC_HELIX_AI
-    #ifdef DEC_HELIX_INT                              // Internal DAC used?
-      c = c * vol / 100 + 0x8000 ;                    // Yes, scale according to volume and shift above negative values 
-    #else
-      c = c * vol / 100 ;                             // Scale according to volume
-    #endif
-  #endif
-  #ifdef DEC_HELIX_SPDIF                              // Spdif output?
-    uint16_t hi, lo, aux ;                            // Needed for spdif conversion
-    hi = spdif_bmclookup[(uint8_t)(c >> 8)] ;         // Convert high byte of sample, sign extend later
-    lo = spdif_bmclookup[(uint8_t)c] ;                // Convert low byte of sample
-    // Low word is inverted depending on sign bit of high word. Positive causes inversion (XOR with 0xFFFF).
-    lo ^= ( ~( (int16_t)hi ) >> 16 ) ;                // XOR with 0x0000 or 0xFFFF
-    // Compute auxiliary audio databits, XOR with 0x0000 or 0X7FFF
-    aux = 0xb333 ^ (((uint32_t)((int16_t)lo)) >> 17) ;
-    if ( left )                                       // Left channel?
+  if ( secs < 0 )                                     // Limit to 0..XF_MAXSECS
+  {
+    secs = 0 ;
+  }
+  if ( secs > XF_MAXSECS )
+  {
+    secs = XF_MAXSECS ;
+  }
+  xf.secs = secs ;
+  ESP_LOGI ( HTAG, "Crossfade set to %d seconds", secs ) ;
+}
+
+
+//**************************************************************************************************
+//                             H E L I X S E T L O U D N E S S                                     *
+//**************************************************************************************************
+// Set the target of the loudness normalization in LUFS (-30..-10), 0 is off.                      *
+//**************************************************************************************************
+void helixSetLoudness ( int lufs )
+{
+  if ( lufs != 0 )                                    // Limit to -30..-10
+  {
+    lufs = constrain ( lufs, -30, -10 ) ;
+  }
+  ln.target = lufs ;
+  if ( lufs == 0 )                                    // Switched off?
+  {
+    ln.gain = 0 ;                                     // Yes, back to 0 dB
+    helixSetGain() ;
+  }
+  ESP_LOGI ( HTAG, "Loudness target set to %d LUFS", lufs ) ;
+}
+
+
+//**************************************************************************************************
+//                                    H E L I X R E P O R T                                        *
+//**************************************************************************************************
+// Show decoder load for the "test" command.  The counters are reset afterwards.                   *
+//**************************************************************************************************
+void helixReport()
+{
+  uint32_t avg = 0 ;                                  // Average cycles per frame
+  int64_t  now = esp_timer_get_time() ;               // Current time in usec
+  uint64_t avail ;                                    // Cycles available in measured period
+  MP3Decoder_t* pm = MP3Decoder_Select ( mp3ctx ) ;   // Decoders of the current stream
+  AACDecoder_t* pa = AACDecoder_Select ( aacctx ) ;   // for this task
+
+  avail = ( now - rep_time ) * ESP.getCpuFreqMHz() ;  // Cycles since last report
+  if ( avail == 0 )                                   // Prevent division by zero
+  {
+    avail = 1 ;
+  }
+  if ( dec_frames )                                   // Prevent division by zero
+  {
+    avg = dec_cycles / dec_frames ;                   // Compute average
+  }
+  log_printf ( "Decoder %s%s, placement profile %d: %d frames, "
+               "%d cycles/frame average, %d max, load core 0 is %d%%\n",
+               mp3mode ? "MP3" : wavmode ? "WAV" : flacmode ? "FLAC" : opusmode ? "Opus" :
+               oggmode ? "Vorbis" : "AAC",
+               ( ( mp3mode || opusmode ) && halfrate ) ? " (half rate)" : "",
+               HELIX_PLACEMENT,
+               dec_frames, avg, dec_maxcycles,
+               (int)( dec_cycles * 100 / avail ) ) ;
+  if ( mp3mode && dec_frames )                        // Show cycles per granule for MP3
+  {
+    int grans = MP3GetOutputSamps() / MP3GetChannels() /
+                ( 576 >> ( halfrate ? 1 : 0 ) ) ;     // Granules in last frame (1 or 2)
+    if ( grans > 0 )
+    {
+      log_printf ( "MP3: %d granules/frame, %d cycles/granule average\n",
+                   grans, avg / grans ) ;
+    }
+  }
+  #ifdef HELIX_PROFILE
+    if ( dec_frames && ! wavmode )                    // Show cycles per frame for every stage
     {
-      if ( frame_num )                                // First frame?
+      if ( mp3mode )
       {
-        i2sbuf[i2sinx++] = VUCP_PREAMBLE_M | aux ;    // No, use preamble M
+        log_printf ( "MP3 stages, cycles/frame: header %d, huffman %d, dequant %d, "
+                     "imdct %d, subband %d\n",
+                     (int)( MP3GetProfile ( MP3_PROF_HEADER ) / dec_frames ),
+                     (int)( MP3GetProfile ( MP3_PROF_HUFFMAN ) / dec_frames ),
+                     (int)( MP3GetProfile ( MP3_PROF_DEQUANT ) / dec_frames ),
+                     (int)( MP3GetProfile ( MP3_PROF_IMDCT ) / dec_frames ),
+                     (int)( MP3GetProfile ( MP3_PROF_SUBBAND ) / dec_frames ) ) ;
       }
-      else
+      else if ( flacmode )
       {
-        i2sbuf[i2sinx++] = VUCP_PREAMBLE_B | aux ;    // Yes, use preamble B
+        log_printf ( "FLAC stages, cycles/block: framing %d, residual %d, predict %d, "
+                     "output %d\n",
+                     (int)( FlacGetProfile ( FLAC_PROF_FRAMING ) / dec_frames ),
+                     (int)( FlacGetProfile ( FLAC_PROF_RESIDUAL ) / dec_frames ),
+                     (int)( FlacGetProfile ( FLAC_PROF_PREDICT ) / dec_frames ),
+                     (int)( FlacGetProfile ( FLAC_PROF_OUTPUT ) / dec_frames ) ) ;
       }
-      left = false ;                                  // Next channel is right
-    }
-    else                                              // Right channel
-    {
-      i2sbuf[i2sinx++] = VUCP_PREAMBLE_W | aux ;      // Use preamble W
-      if ( ++frame_num == 192 )                       // Update and check frame number
+     #ifdef HELIX_OPUS
+      else if ( opusmode )
+      {
+        log_printf ( "Opus stages, cycles/block: ogg %d, decode %d\n",
+                     (int)( OggOpusGetProfile ( OGGOPUS_PROF_OGG ) / dec_frames ),
+                     (int)( OggOpusGetProfile ( OGGOPUS_PROF_DECODE ) / dec_frames ) ) ;
+      }
+     #endif
+      else if ( oggmode )
+      {
+        log_printf ( "Vorbis stages, cycles/packet: ogg %d, floor %d, residue %d, "
+                     "imdct %d\n",
+                     (int)( VorbisGetProfile ( VORBIS_PROF_OGG ) / dec_frames ),
+                     (int)( VorbisGetProfile ( VORBIS_PROF_FLOOR ) / dec_frames ),
+                     (int)( VorbisGetProfile ( VORBIS_PROF_RESIDUE ) / dec_frames ),
+                     (int)( VorbisGetProfile ( VORBIS_PROF_IMDCT ) / dec_frames ) ) ;
+      }
+      else
       {
-        frame_num = 0 ;                               // Start a new frame
+        log_printf ( "AAC stages, cycles/frame: bitstream %d, dequant %d, tns %d, "
+                     "imdct %d, sbr %d (ps %d)\n",
+                     (int)( AACGetProfile ( AAC_PROF_BITSTREAM ) / dec_frames ),
+                     (int)( AACGetProfile ( AAC_PROF_DEQUANT ) / dec_frames ),
+                     (int)( AACGetProfile ( AAC_PROF_TNS ) / dec_frames ),
+                     (int)( AACGetProfile ( AAC_PROF_IMDCT ) / dec_frames ),
+                     (int)( AACGetProfile ( AAC_PROF_SBR ) / dec_frames ),
+                     (int)( AACGetProfile ( AAC_PROF_PS ) / dec_frames ) ) ;
       }
-      left = true ;                                   // Next sample is left
     }
-    i2sbuf[i2sinx++] = ( (uint32_t)lo << 16 ) | hi ;  // Store the 32 data bits (16 bit sample) 
-  #else
-    i2sbuf[i2sinx++] = c ;                            // Store 16 bits data
+    MP3ResetProfile() ;                               // Start new measurement
+    AACResetProfile() ;
+    VorbisResetProfile() ;
+    FlacResetProfile() ;
+    #ifdef HELIX_OPUS
+      OggOpusResetProfile() ;
+    #endif
   #endif
-  if ( i2sinx == I2SSIZE )                            // Buffer filled?
+  if ( flacmode )                                     // Show frame statistics and input rate
+  {
+    FlacReport() ;
+  }
+  if ( wavmode )                                      // Show format and skipped chunks
   {
-    if ( i2s_write ( I2S_NUM_0, i2sbuf,               // Yes, send to I2S
-                     sizeof(i2sbuf), &bw,
-                     portMAX_DELAY ) != ESP_OK )
+    WavReport() ;
+  }
+  #ifdef HELIX_OPUS
+    if ( opusmode )                                   // Show Opus modes and Ogg statistics
     {
-      ESP_LOGI ( HTAG, "i2s_write error!" ) ;
+      OggOpusReport() ;
     }
-    if ( bw != sizeof(i2sbuf) )
+  #endif
+  if ( oggmode && ! opusmode && ! flacmode )          // Show Ogg statistics
+  {
+    VorbisReport() ;
+  }
+  if ( tonefilt[0].on || tonefilt[1].on )            // Tone control active?
+  {
+    log_printf ( "Tone control: treble %s, bass %s, load %d%%\n",
+                 tonefilt[0].on ? "on" : "off",
+                 tonefilt[1].on ? "on" : "off",
+                 (int)( tone_cycles * 100 / avail ) ) ;
+  }
+  tone_cycles = 0 ;
+  if ( ln.target )                                    // Loudness normalization active?
+  {
+    log_printf ( "Loudness %.1f LUFS%s, gain %.1f dB, target %d LUFS, load %d%%\n",
+                 ( ln.integ == LN_UNKNOWN ) ? 0.0 : ln.integ / 10.0,
+                 ln.fixed ? " (tags)" : "",
+                 ln.gain / 10.0, ln.target,
+                 (int)( ln.cycles * 100 / avail ) ) ;
+  }
+  ln.cycles = 0 ;
+  log_printf ( "Crossfade %d sec, %d done, %d refused or cut, %d frames without old stream, "
+               "decoder load %d%%\n",
+               xf.secs, xf.fades, xf.cuts, xf.under, dec_load ) ;
+  log_printf ( "Rate trim %d ppm, %d frames dropped, %d inserted\n",
+               slip_ppm2 / 2, slip_drop, slip_ins ) ;
+  #ifdef HELIX_FIXEDRATE
+    log_printf ( "Output rate %d Hz, resampler %s, load %d%%\n",
+                 HELIX_FIXEDRATE,
+                 Resampler_Active() ? "active" : "not needed",
+                 (int)( src_cycles * 100 / avail ) ) ;
+    src_cycles = 0 ;
+  #endif
+  #ifdef DEC_HELIX_SPDIF
+    Spdif_Report() ;                                  // Show format and channel status
+  #endif
+  i2sOutReport() ;                                    // DMA depth and underruns
+  if ( ! mp3mode && ! oggmode && ! flacmode &&        // Show SBR status for AAC
+       ! wavmode )
+  {
+    log_printf ( "SBR mode %d%s, SBR %s, %d bytes for SBR state\n",
+                 sbrpreset >= 0 ? sbrpreset : sbrmode,
+                 sbrpreset >= 0 ? " (preset)" : "",
+                 sbrbypass ? "bypassed" : "decoded",
+                 sbrbypass ? 0 : (int)sizeof(PSInfoSBR_t) ) ;
+    #ifdef AAC_ENABLE_PS
+      log_printf ( "Parametric stereo %s, %d bytes for PS state\n",
+                   ( AACDecoder_IsInit() && AACGetParametricStereo() ) ? "active" : "not active",
+                   (int)sizeof(PSInfoPS_t) ) ;
+    #else
+      log_printf ( "Parametric stereo not compiled in\n" ) ;
+    #endif
+    if ( AACDecoder_IsInit() && ( AACGetFormat() == AAC_FF_LOAS ) )
     {
-      ESP_LOGI ( HTAG, "i2s_write bytes written %d, should be %d!",
-                 bw, sizeof(i2sbuf) ) ;
+      log_printf ( "LATM/LOAS transport, %d config changes\n",
+                   AACGetLATMConfigChanges() ) ;
     }
-    i2sinx = 0 ;                                      // Start at new buffer
   }
+  #ifdef HELIX_DUALCORE
+    log_printf ( "Output task: %d blocks, load core 1 is %d%% (MP3 stage 2 %d%%), "
+                 "latency %d usec average, %d max\n",
+                 out_frames,
+                 (int)( out_cycles * 100 / avail ),
+                 (int)( syn_cycles * 100 / avail ),
+                 out_frames ? (int)( lat_total / out_frames ) : 0,
+                 lat_max ) ;
+    out_frames = 0 ;                                  // Start new measurement
+    out_cycles = 0 ;
+    syn_cycles = 0 ;
+    lat_total = 0 ;
+    lat_max = 0 ;
+  #endif
+  dec_frames = 0 ;                                    // Start new measurement
+  dec_cycles = 0 ;
+  dec_maxcycles = 0 ;
+  rep_time = now ;
+  MP3Decoder_Select ( pm ) ;                          // Back to the decoders used before
+  AACDecoder_Select ( pa ) ;
 }
 
 
 //**************************************************************************************************
-//                                    P L A Y C H U N K                                            *
+//                                 H E L I X C H O O S E S B R                                     *
 //**************************************************************************************************
-// Play the next 32 bytes.                                                                         *
+// Decide whether SBR will be decoded for the next AAC stream.  In auto mode SBR is bypassed if    *
+// there is not enough internal RAM.  Too much CPU load is checked during decoding.                *
 //**************************************************************************************************
-void playChunk ( const uint8_t* chunk )
+void helixChooseSBR()
 {
-  static uint32_t samprate ;                          // Sample rate
-  static int      channels ;                          // Number of channels
-  static int      smpbytes ;                          // Number of bytes for I2S
-  static int      smpwords ;                          // Number of 16 bit wordsfor I2S
-  int             s ;                                 // Position of syncword
-  static bool     once ;                              // To execute part of code once
-  int             n ;                                 // Number of samples decoded
-  int             br = 0 ;                            // Bit rate
-  int             bps = 0 ;                           // Bits per sample
+  uint8_t mode = ( sbrpreset >= 0 ) ? sbrpreset : sbrmode ;   // Forced by preset?
 
-  memcpy ( mp3bpnt, chunk, 32 ) ;                     // Add chunk to frame buffer
-  mp3bcnt += 32 ;                                     // Update counter
-  mp3bpnt += 32 ;                                     // and pointer
-  if ( searchFrame && ( mp3bcnt >= FRAMESIZE ) )      // Frame search complete?
+  if ( mode == SBR_AUTO )                             // Auto mode?
   {
-    if ( mp3mode )
-    {
-      s = MP3FindSyncWord ( mp3buff, mp3bcnt ) ;      // Search for first mp3 frame
-    }
-    else
-    {
-      s = AACFindSyncWord ( mp3buff, mp3bcnt ) ;      // Search for first aac frame
-    }
-    if ( ( searchFrame = ( s < 0 ) ) )                // Sync found?
-    {
-      mp3bcnt = 0 ;                                   // No, reset counter
-      mp3bpnt = mp3buff ;                             // And fillpointer
-      samprate = 0 ;                                  // Still unknown
-      return ;                                        // Return with no effect
-    }
-    else
-    {
-      once = true ;                                   // Get samplerate once
-      ESP_LOGI ( HTAG, "Sync found at 0x%04X", s ) ;
-      if ( s > 0 )
-      {
-        mp3bcnt -= s ;                                // Frame found, update count
-        memcpy ( mp3buff, mp3buff + s, mp3bcnt ) ;    // Shift mp3 data to begin of buffer
-        mp3bpnt = mp3buff + mp3bcnt ;                 // Adjust fill pointer
-      }
-    }
+    sbrbypass = ( heap_caps_get_free_size ( MALLOC_CAP_INTERNAL ) < SBR_MINHEAP ) ;
   }
-  if ( mp3bcnt >= FRAMESIZE )                         // Complete frame in buffer?
+  else
   {
-    int newcnt = mp3bcnt ;                            // Used to get number of bytes converted
-    if ( mp3mode )
+    sbrbypass = ( mode == SBR_OFF ) ;                 // Fixed setting
+  }
+  sbr_frames = 0 ;                                    // Start new load measurement
+  sbr_cycles = 0 ;
+  AACSetSBRBypass ( sbrbypass ) ;                     // Tell the decoder
+  ESP_LOGI ( HTAG, "SBR mode %d, bypass is %d",
+             mode, sbrbypass ) ;
+}
+
+
+//**************************************************************************************************
+//                                 H E L I X C H E C K S B R                                       *
+//**************************************************************************************************
+// SBR auto mode: bypass SBR if decoding an HE-AAC frame takes too much of the frame time.         *
+// Returns true if SBR has been switched off, the output parameters must be read again then.       *
+//**************************************************************************************************
+bool helixCheckSBR ( uint32_t cycles, int smpwords, int channels, uint32_t samprate )
+{
+  uint8_t  mode = ( sbrpreset >= 0 ) ? sbrpreset : sbrmode ;  // Forced by preset?
+  uint64_t budget ;                                   // Cycles available for one frame
+
+  if ( sbrbypass || ( mode != SBR_AUTO ) ||           // Already bypassed or not auto mode?
+       ( smpwords <= channels * 1024 ) ||             // Or no SBR in this stream (1024 per channel)?
+       ( samprate == 0 ) )
+  {
+    return false ;                                    // Yes, nothing to check
+  }
+  sbr_cycles += cycles ;                              // Add to measurement
+  if ( ++sbr_frames < SBR_TESTFRAMES )                // Enough frames seen?
+  {
+    return false ;                                    // No, continue
+  }
+  budget = (uint64_t)( smpwords / channels ) *        // Frame time in cycles
+           ESP.getCpuFreqMHz() * 1000000 / samprate ;
+  if ( ( sbr_cycles / sbr_frames ) * 100 <=           // Load acceptable?
+       budget * SBR_MAXLOAD )
+  {
+    sbr_frames = 0 ;                                  // Yes, start new measurement
+    sbr_cycles = 0 ;
+    return false ;
+  }
+  ESP_LOGI ( HTAG, "SBR takes too much CPU time "
+             "(%d of %d cycles), bypass",
+             (uint32_t)( sbr_cycles / sbr_frames ),
+             (uint32_t)budget ) ;
+  sbrbypass = true ;                                  // Switch to core AAC
+  AACSetSBRBypass ( true ) ;
+  return true ;
+}
+
+
+//**************************************************************************************************
+//                                 H E L I X T O N E S H E L F                                     *
+//**************************************************************************************************
+// Compute the coefficients of a shelving filter (Audio EQ cookbook, slope 1).                     *
+// The filter is switched off if the gain is 0 dB.  The state is cleared.                          *
+//**************************************************************************************************
+void helixToneShelf ( biquad_t* f, bool high, float db, float freq, uint32_t rate )
+{
+  double A, w0, c, sa ;                               // Intermediate results
+  double b0, b1, b2, a0, a1, a2 ;                     // Coefficients before normalization
+  const double q = (double)( 1 << TONE_QBITS ) ;      // Scale for fixed point
+
+  memset ( f->s, 0, sizeof(f->s) ) ;                  // Clear filter state
+  f->on = ( db != 0.0 ) && ( rate != 0 ) ;
+  if ( ! f->on )                                      // Filter needed?
+  {
+    return ;                                          // No, do not bother
+  }
+  if ( freq > rate * 0.45 )                           // Keep corner frequency below Nyquist
+  {
+    freq = rate * 0.45 ;
+  }
+  A  = pow ( 10.0, db / 40.0 ) ;
+  w0 = 2.0 * M_PI * freq / rate ;
+  c  = cos ( w0 ) ;
+  sa = sin ( w0 ) * sqrt ( 2.0 * A ) ;                // 2 * sqrt(A) * alpha for slope 1
+  if ( high )                                         // Treble: high shelf
+  {
+    b0 =        A * ( ( A + 1 ) + ( A - 1 ) * c + sa ) ;
+    b1 = -2.0 * A * ( ( A - 1 ) + ( A + 1 ) * c ) ;
+    b2 =        A * ( ( A + 1 ) + ( A - 1 ) * c - sa ) ;
+    a0 =              ( A + 1 ) - ( A - 1 ) * c + sa ;
+    a1 =  2.0 *     ( ( A - 1 ) - ( A + 1 ) * c ) ;
+    a2 =              ( A + 1 ) - ( A - 1 ) * c - sa ;
+  }
+  else                                                // Bass: low shelf
+  {
+    b0 =        A * ( ( A + 1 ) - ( A - 1 ) * c + sa ) ;
+    b1 =  2.0 * A * ( ( A - 1 ) - ( A + 1 ) * c ) ;
+    b2 =        A * ( ( A + 1 ) - ( A - 1 ) * c - sa ) ;
+    a0 =              ( A + 1 ) + ( A - 1 ) * c + sa ;
+    a1 = -2.0 *     ( ( A - 1 ) + ( A + 1 ) * c ) ;
+    a2 =              ( A + 1 ) + ( A - 1 ) * c - sa ;
+  }
+  f->b0 = (int32_t)lround ( b0 / a0 * q ) ;           // Normalize and convert to fixed point
+  f->b1 = (int32_t)lround ( b1 / a0 * q ) ;
+  f->b2 = (int32_t)lround ( b2 / a0 * q ) ;
+  f->a1 = (int32_t)lround ( a1 / a0 * q ) ;
+  f->a2 = (int32_t)lround ( a2 / a0 * q ) ;
+}
+
+
+//**************************************************************************************************
+//                                 H E L I X T O N E S E T U P                                     *
+//**************************************************************************************************
+// Compute the tone filters for the requested setting and the sample rate of the stream.           *
+// Only called if the setting or the sample rate has changed.                                      *
+//**************************************************************************************************
+void helixToneSetup ( uint32_t rate )
+{
+  int8_t tg = ( tonenib[0] ^ 8 ) - 8 ;                // Treble gain is a signed nibble
+
+  tonechange = false ;                                // Handled (before reading the nibbles)
+  tonerate = rate ;
+  helixToneShelf ( &tonefilt[0], true, tg * 1.5,      // Treble
+                   tonenib[1] * 1000.0, rate ) ;
+  helixToneShelf ( &tonefilt[1], false, tonenib[2],   // Bass
+                   tonenib[3] * 10.0, rate ) ;
+  ESP_LOGI ( HTAG, "Tone treble %d, %d kHz, bass %d dB, %d Hz, rate %d",
+             tg, tonenib[1], tonenib[2], tonenib[3] * 10, rate ) ;
+}
+
+
+//**************************************************************************************************
+//                                     H E L I X T O N E                                           *
+//**************************************************************************************************
+// Apply the tone filters to a block of PCM samples (interleaved if stereo).                       *
+// Direct form 1, coefficients with TONE_QBITS and state with TONE_XBITS fraction bits.            *
+//**************************************************************************************************
+void helixTone ( int16_t* buf, int words, int channels )
+{
+  for ( int n = 0 ; n < 2 ; n++ )                     // Treble and bass filter
+  {
+    biquad_t* f = &tonefilt[n] ;
+    if ( ! f->on )                                    // Active?
     {
-      n = MP3Decode ( mp3buff, &newcnt,               // Decode the frame
-                          outbuf, 0 ) ;
-      if ( n == ERR_MP3_NONE )
-      {
-        if ( once )
-        {
-          samprate = MP3GetSampRate() ;               // Get sample rate
-          channels = MP3GetChannels() ;               // Get number of channels
-          br       = MP3GetBitrate() ;                // Get bit rate
-          bps      = MP3GetBitsPerSample() ;          // Get bits per sample
-          smpwords = MP3GetOutputSamps() ;            // Get number of output samples
-        }
-      }
+      continue ;                                      // No, skip
     }
-    else
+    for ( int ch = 0 ; ch < channels ; ch++ )         // Every channel has its own state
     {
-      n = AACDecode ( mp3buff, &newcnt, outbuf ) ;    // Decode the frame
-      if ( n == ERR_AAC_NONE )
+      int32_t* s = f->s[ch] ;                         // State of this channel
+      int32_t  x, y ;                                 // Input and output sample
+      int64_t  acc ;                                  // Accumulator
+      for ( int i = ch ; i < words ; i += channels )
       {
-        if ( once )
+        x = (int32_t)buf[i] << TONE_XBITS ;
+        acc = (int64_t)f->b0 * x    + (int64_t)f->b1 * s[0] + (int64_t)f->b2 * s[1] -
+              (int64_t)f->a1 * s[2] - (int64_t)f->a2 * s[3] ;
+        y = (int32_t)( acc >> TONE_QBITS ) ;
+        s[1] = s[0] ;                                 // Shift state
+        s[0] = x ;
+        s[3] = s[2] ;
+        s[2] = y ;
+        y = ( y + ( 1 << ( TONE_XBITS - 1 ) ) ) >> TONE_XBITS ;
+        if ( y > 32767 )                              // Saturate
         {
-          samprate = AACGetSampRate() ;               // Get sample rate
-          channels = AACGetChannels() ;               // Get number of channels
-          br       = AACGetBitrate() ;                // Get bit rate
-          bps      = AACGetBitsPerSample() ;          // Get bits per sample
-          smpwords = AACGetOutputSamps() ;            // Get number of output (16 bit) samples
+          y = 32767 ;
         }
+        else if ( y < -32768 )
+        {
+          y = -32768 ;
+        }
+        buf[i] = y ;
       }
     }
-    int hb = mp3bcnt - newcnt ;                       // Number of bytes handled
-    if ( n < 0 )                                      // Check if decode is okay
-    {
-      ESP_LOGI ( HTAG, "MP3Decode error %d", n ) ;
-      helixInit ( -1, -1 ) ;                          // Totally wrong, start all over
-      return ;
-    }
-    if ( once )
+  }
+}
+
+
+//**************************************************************************************************
+//                                 H E L I X L O U D S E T U P                                     *
+//**************************************************************************************************
+// Compute the K-weighting filters of ITU-R BS.1770 (high shelf and high pass) for half the sample  *
+// rate.  The formulas give the coefficients of the standard for 48 kHz.  The meter is cleared.     *
+//**************************************************************************************************
+void helixLoudSetup ( uint32_t rate )
+{
+  double       fs = rate / 2.0 ;                      // The meter runs at half the rate
+  double       K, Vh, Vb, a0 ;                        // Intermediate results
+  const double q = (double)( 1 << TONE_QBITS ) ;      // Scale for fixed point
+  biquad_t*    f ;                                    // Filter to compute
+
+  memset ( ln.kw, 0, sizeof(ln.kw) ) ;                // Clear coefficients and state
+  ln.rate = rate ;
+  ln.blk = rate / 2 * LN_BLOCKMS / 1000 ;             // Decimated frames in a block
+  ln.sum = 0 ;
+  ln.cnt = 0 ;
+  ln.half = false ;
+  f = &ln.kw[0] ;                                     // Stage 1, high shelf +4 dB at 1682 Hz
+  K  = tan ( M_PI * 1681.974450955533 / fs ) ;
+  Vh = pow ( 10.0, 3.999843853973347 / 20.0 ) ;
+  Vb = pow ( Vh, 0.4996667741545416 ) ;
+  a0 = 1.0 + K / 0.7071752369554196 + K * K ;
+  f->b0 = (int32_t)lround ( ( Vh + Vb * K / 0.7071752369554196 + K * K ) / a0 * q ) ;
+  f->b1 = (int32_t)lround ( 2.0 * ( K * K - Vh ) / a0 * q ) ;
+  f->b2 = (int32_t)lround ( ( Vh - Vb * K / 0.7071752369554196 + K * K ) / a0 * q ) ;
+  f->a1 = (int32_t)lround ( 2.0 * ( K * K - 1.0 ) / a0 * q ) ;
+  f->a2 = (int32_t)lround ( ( 1.0 - K / 0.7071752369554196 + K * K ) / a0 * q ) ;
+  f = &ln.kw[1] ;                                     // Stage 2, high pass at 38 Hz
+  K  = tan ( M_PI * 38.13547087602444 / fs ) ;
+  a0 = 1.0 + K / 0.5003270373238773 + K * K ;
+  f->b0 = 1 << TONE_QBITS ;                           // Not normalized, as in the standard
+  f->b1 = -( 2 << TONE_QBITS ) ;
+  f->b2 = 1 << TONE_QBITS ;
+  f->a1 = (int32_t)lround ( 2.0 * ( K * K - 1.0 ) / a0 * q ) ;
+  f->a2 = (int32_t)lround ( ( 1.0 - K / 0.5003270373238773 + K * K ) / a0 * q ) ;
+}
+
+
+//**************************************************************************************************
+//                             H E L I X L O U D I N T E G R A T E                                 *
+//**************************************************************************************************
+// Integrated loudness of the blocks in the histogram, gated at -70 LUFS and at 10 LU below the     *
+// loudness of the blocks above -70 LUFS (EBU R128).  Result in 0.1 LUFS, LN_UNKNOWN if no blocks.  *
+//**************************************************************************************************
+int16_t helixLoudIntegrate()
+{
+  float    gate = -70.0f ;                            // Absolute gate first
+  float    esum ;                                     // Sum of mean squares above the gate
+  uint32_t n ;                                        // Number of blocks above the gate
+  float    l = 0.0f ;                                 // Loudness of these blocks
+
+  for ( int pass = 0 ; pass < 2 ; pass++ )            // Absolute and relative gate
+  {
+    esum = 0.0f ;
+    n = 0 ;
+    for ( int b = 0 ; b < LN_BINS ; b++ )
     {
-      smpbytes = smpwords * 2 ;                       // Number of bytes in outbuf
-      ESP_LOGI ( HTAG, "Bitrate     is %d", br ) ;    // Show decoder parameters
-      ESP_LOGI ( HTAG, "Samprate    is %d", samprate ) ;
-      ESP_LOGI ( HTAG, "Channels    is %d", channels ) ;
-      ESP_LOGI ( HTAG, "Bitpersamp  is %d", bps ) ;
-      ESP_LOGI ( HTAG, "Outputsamps is %d", smpwords ) ;
-      if ( br )                                       // Prevent division by zero
+      if ( ( b - 70 + 1 ) > gate )                    // Upper edge of bin above the gate?
       {
-       #ifdef DEC_HELIX_SPDIF
-        i2s_set_sample_rates ( I2S_NUM_0,             // Set samplerate (biphase)
-                               samprate*2 ) ;
-       #else
-        i2s_set_sample_rates ( I2S_NUM_0,             // Set samplerate
-                               samprate ) ;
-       #endif
+        esum += ln.energy[b] ;                        // Yes, use these blocks
+        n += ln.hist[b] ;
       }
-      i2s_start ( I2S_NUM_0 ) ;                       // Start I2S output
-      once = false ;                                  // No need to set samplerate again
-    }
-    if ( muteflag )                                   // Muted?
-    {
-      memset ( outbuf, 0, smpbytes ) ;                // Yes, clear buffer
     }
-    for ( int i = 0 ; i < smpwords ; i++ )            // Handle all samples in outbuf
+    if ( n == 0 )                                     // All blocks too quiet?
     {
-      outputSample ( outbuf[i] ) ;
-      if ( channels == 1 )                            // Mono signal?
-      {
-        outputSample ( outbuf[i] ) ;                  // Yes, right sample equals left sample
-      }
+      return LN_UNKNOWN ;
     }
-    mp3bcnt -= hb ;
-    memcpy ( mp3buff, mp3buff + hb,                   // Shift mp3 data to begin of buffer
-             mp3bcnt ) ;
-    mp3bpnt = mp3buff +mp3bcnt ;
+    l = -0.691f + 10.0f * log10f ( esum / n ) ;       // Loudness of the gated blocks
+    gate = l - 10.0f ;                                // Relative gate for the second pass
   }
+  return (int16_t)lroundf ( l * 10.0f ) ;
+}
+
+
+//**************************************************************************************************
+//                                 H E L I X L O U D B L O C K                                     *
+//**************************************************************************************************
+// A block of LN_BLOCKMS is measured.  Add it to the histogram and adapt the gain to the           *
+// integrated loudness, 0.1 dB per block.  A mono stream is counted as played on two speakers.     *
+//**************************************************************************************************
+void helixLoudBlock ( int ch )
+{
+  float   ms ;                                        // Mean square, full scale is 1.0
+  float   l ;                                         // Loudness of this block
+  int     b ;                                         // Bin in the histogram
+  int16_t want ;                                      // Gain to reach the target
+
+  ms = (float)ln.sum / ln.cnt / ( 32768.0f * 32768.0f ) ;
+  if ( ch == 1 )                                      // Mono?
+  {
+    ms *= 2.0f ;                                      // Yes, same on both channels
+  }
+  ln.sum = 0 ;                                        // Start next block
+  ln.cnt = 0 ;
+  if ( ms <= 0.0f )                                   // Silence?
+  {
+    return ;                                          // Yes, below the gate anyway
+  }
+  l = -0.691f + 10.0f * log10f ( ms ) ;
+  if ( l < -70.0f )                                   // Below absolute gate?
+  {
+    return ;                                          // Yes, ignore
+  }
+  b = (int)floorf ( l ) + 70 ;                        // Bin, 1 LU wide
+  if ( b >= LN_BINS )
+  {
+    b = LN_BINS - 1 ;
+  }
+  ln.hist[b]++ ;
+  ln.energy[b] += ms ;
+  if ( ++ln.blocks < LN_MINBLOCKS )                   // Measured long enough?
+  {
+    return ;                                          // No, wait
+  }
+  ln.integ = helixLoudIntegrate() ;                   // Loudness so far
+  if ( ln.integ == LN_UNKNOWN )
+  {
+    return ;
+  }
+  want = constrain ( ln.target * 10 - ln.integ,       // Gain to reach the target
+                     LN_MINGAIN, LN_MAXGAIN ) ;
+  if ( want == ln.gain )                              // Reached?
+  {
+    return ;                                          // Yes, nothing to change
+  }
+  ln.gain += ( want > ln.gain ) ? 1 : -1 ;            // Slowly to the wanted gain
+  helixSetGain() ;
+}
+
+
+//**************************************************************************************************
+//                                 H E L I X L O U D M E T E R                                     *
+//**************************************************************************************************
+// Loudness meter on decoded samples.  Only every other frame is used (no filter before), so the    *
+// K-weighting filters run at half the sample rate.  Filters in fixed point like helixTone, the     *
+// sum of squares of a block is kept in 64 bits.  Sound above a quarter of the sample rate folds    *
+// back below it with the same energy, where the K-weighting is almost flat, so the error is small  *
+// for speech and music.                                                                            *
+//**************************************************************************************************
+void helixLoudMeter ( int16_t* pcm, int words, int ch, uint32_t rate )
+{
+  uint32_t tc = ESP.getCycleCount() ;                 // Measure the meter
+  int32_t  x, y ;                                     // Input and output sample of a filter
+  int64_t  acc ;                                      // Accumulator
+
+  if ( ln.rate != rate )                              // New sample rate?
+  {
+    helixLoudSetup ( rate ) ;                         // Yes, compute filters
+  }
+  for ( int i = 0 ; i < words ; i += ch )             // For every frame
+  {
+    ln.half = ! ln.half ;
+    if ( ln.half )                                    // Every other frame
+    {
+      continue ;
+    }
+    for ( int c = 0 ; c < ch ; c++ )
+    {
+      x = (int32_t)pcm[i+c] << TONE_XBITS ;
+      for ( int n = 0 ; n < 2 ; n++ )                 // High shelf, then high pass
+      {
+        biquad_t* f = &ln.kw[n] ;
+        int32_t*  s = f->s[c] ;                       // State of this channel
+        acc = (int64_t)f->b0 * x    + (int64_t)f->b1 * s[0] + (int64_t)f->b2 * s[1] -
+              (int64_t)f->a1 * s[2] - (int64_t)f->a2 * s[3] ;
+        acc += 1LL << ( TONE_QBITS - 1 ) ;            // Round, the high pass amplifies a bias
+        y = (int32_t)( acc >> TONE_QBITS ) ;
+        s[1] = s[0] ;                                 // Shift state
+        s[0] = x ;
+        s[3] = s[2] ;
+        s[2] = y ;
+        x = y ;                                       // Input of next stage
+      }
+      y = x >> TONE_XBITS ;                           // Back to 16 bits scale
+      ln.sum += (int64_t)y * y ;
+    }
+    if ( ++ln.cnt >= ln.blk )                         // Block complete?
+    {
+      helixLoudBlock ( ch ) ;                         // Yes, evaluate
+    }
+  }
+  ln.cycles += ESP.getCycleCount() - tc ;
+}
+
+
+//**************************************************************************************************
+//                                  H E L I X L O U D N E X T                                      *
+//**************************************************************************************************
+// Set the loudness of the next track or stream in 0.1 LUFS, known from the preset or from tags.    *
+// If fixed, the loudness is from tags and is not measured.  LN_UNKNOWN starts at 0 dB gain.        *
+// Taken by helixLoudStart().                                                                       *
+//**************************************************************************************************
+void helixLoudNext ( int16_t lufs, bool fixed )
+{
+  ln.nextfix = fixed ;
+  ln.next = lufs ;
+}
+
+
+//**************************************************************************************************
+//                                 H E L I X L O U D S T A R T                                     *
+//**************************************************************************************************
+// Start of a new stream or track.  Clear the meter and set the gain for the loudness given by     *
+// helixLoudNext().  Without a call of helixLoudNext (SD track without tags) the gain is kept.      *
+//**************************************************************************************************
+void helixLoudStart()
+{
+  int16_t next = ln.next ;                            // Loudness of this track
+
+  ln.next = LN_KEEP ;                                 // Taken
+  ln.fixed = ln.nextfix ;
+  ln.nextfix = false ;
+  memset ( ln.hist, 0, sizeof(ln.hist) ) ;            // Clear the meter
+  memset ( ln.energy, 0, sizeof(ln.energy) ) ;
+  ln.blocks = 0 ;
+  ln.rate = 0 ;                                       // Filters set up by first frame
+  ln.integ = ln.fixed ? next : LN_UNKNOWN ;
+  if ( ( ln.target == 0 ) || ( next == LN_UNKNOWN ) ) // Off or loudness not known?
+  {
+    ln.gain = 0 ;                                     // Yes, start at 0 dB
+  }
+  else if ( next != LN_KEEP )                         // Loudness known?
+  {
+    ln.gain = constrain ( ln.target * 10 - next,      // Yes, gain to reach the target
+                          LN_MINGAIN, LN_MAXGAIN ) ;
+  }
+  helixSetGain() ;
+}
+
+
+//**************************************************************************************************
+//                               H E L I X L O U D M E A S U R E D                                 *
+//**************************************************************************************************
+// Integrated loudness of the current stream in 0.1 LUFS, LN_UNKNOWN if not measured long enough.  *
+//**************************************************************************************************
+int16_t helixLoudMeasured()
+{
+  if ( ln.fixed )                                     // Loudness from tags?
+  {
+    return LN_UNKNOWN ;                               // Yes, not measured
+  }
+  return ln.integ ;
+}
+
+
+#ifdef HELIX_DUALCORE
+//**************************************************************************************************
+//                                  H E L I X G R A N W A I T                                      *
+//**************************************************************************************************
+// Wait until the output task has sent all MP3 granules to I2S.  Needed before an MP3 decoder is   *
+// used in one stage, reset or freed, and before playtask calls helixPost again.                   *
+//**************************************************************************************************
+void helixGranWait()
+{
+  int tries = 100 ;                                   // Max. 200 msec
+
+  while ( granfree && ( uxQueueMessagesWaiting ( granfree ) < GRANSLOTS ) && tries-- )
+  {
+    vTaskDelay ( 2 / portTICK_PERIOD_MS ) ;           // Allow output task to finish
+  }
+}
+#endif
+
+
+//**************************************************************************************************
+//                                    H E L I X I N I T                                            *
+//**************************************************************************************************
+// Initialize helix buffering.  Returns false if the buffers of the decoder could not be allocated, *
+// decodeFrame() will then try again with the first data.                                          *
+//**************************************************************************************************
+bool helixInit ( int8_t enable_pin, int8_t disable_pin )
+{
+  bool ok = true ;                                    // Decoder buffers allocated
+
+  ESP_LOGI ( HTAG, "helixInit called for %s",         // Show activity
+             audio_ct.c_str() ) ;
+  #ifdef HELIX_DUALCORE
+    helixGranWait() ;                                 // MP3 decoder is reset below
+  #endif
+  mp3mode = ( audio_ct.indexOf ( "mpeg" ) > 0 ) ;     // Set mp3/aac/ogg mode
+  oggmode = ( audio_ct.indexOf ( "ogg" ) > 0 ) ||
+            ( audio_ct.indexOf ( "opus" ) > 0 ) ;
+  opusmode = false ;                                  // Ogg codec is set by oggProbe()
+  flacmode = ( audio_ct.indexOf ( "flac" ) > 0 ) &&   // Native FLAC, like "audio/flac"
+             ! oggmode ;
+  wavmode = ( audio_ct.indexOf ( "wav" ) > 0 ) ;      // Like "audio/wav" or "audio/x-wav"
+  if ( xf.state != XF_WAIT )                          // The old stream of a crossfade keeps its decoder
+  {
+    #ifdef HELIX_OPUS
+      OggOpusDecoder_FreeBuffers() ;                  // Only allocated by oggProbe()
+    #endif
+    FlacDecoder_FreeBuffers() ;                       // Also frees frame and sample buffers
+    WavDecoder_FreeBuffers() ;
+    VorbisDecoder_FreeBuffers() ;                     // Vorbis, Opus or FLAC, see oggProbe()
+  }
+  if ( mp3mode )                                      // Only the decoder in use holds the arena
+  {
+    AACDecoder_FreeBuffers() ;                        // Give arena back
+    ok = MP3Decoder_AllocateBuffers() ;               // Get (and clear) MP3 buffers
+    MP3SetHalfRate ( halfrate ) ;                     // Full or half sample rate
+  }
+  else if ( oggmode )
+  {
+    MP3Decoder_FreeBuffers() ;                        // Give arena back
+    AACDecoder_FreeBuffers() ;
+    oggprobe = true ;                                 // Find codec in first page
+    once = true ;                                     // No frame sync, get samplerate from first packet
+  }
+  else if ( flacmode )
+  {
+    MP3Decoder_FreeBuffers() ;                        // Give arena back
+    AACDecoder_FreeBuffers() ;
+    ok = FlacDecoder_AllocateBuffers() ;              // Get (and clear) FLAC state
+    FlacSetOgg ( false ) ;                            // Native stream, starts with "fLaC"
+    once = true ;                                     // No frame sync, get samplerate from first frame
+  }
+  else if ( wavmode )
+  {
+    MP3Decoder_FreeBuffers() ;                        // Give arena back
+    AACDecoder_FreeBuffers() ;
+    ok = WavDecoder_AllocateBuffers() ;               // Get (and clear) WAV state
+    once = true ;                                     // No frame sync, get samplerate from header
+  }
+  else
+  {
+    MP3Decoder_FreeBuffers() ;                        // Give arena back
+    helixChooseSBR() ;                                // Decide on SBR before allocation
+    ok = AACDecoder_AllocateBuffers() ;               // Get (and clear) AAC buffers
+  }
+  if ( ! ok )
+  {
+    ESP_LOGE ( HTAG, "No RAM for the decoder buffers" ) ;
+  }
+  mp3bpnt = mp3buff ;                                 // Reset pointer
+  mp3bcnt = 0 ;                                       // Buffer empty
+  searchFrame = true ;                                // Start searching for frame
+  id3skip = 0 ;                                       // No ID3 tag to skip (yet)
+  gl_skip = 0 ;                                       // No encoder delay known (yet)
+  gl_left = -1 ;                                      // Length unknown
+  br_bytes = 0 ;                                      // Start measuring the byte rate
+  br_frames = 0 ;
+  ld_cycles = 0 ;                                     // and the decoder load
+  ld_frames = 0 ;
+  if ( enable_pin >= 0 )                              // Enable pin defined?
+  {
+    pinMode ( enable_pin, OUTPUT ) ;                  // Yes, set pin to output
+    digitalWrite ( enable_pin, HIGH ) ;               // Enable output
+  }
+  if ( disable_pin >= 0 )                             // Disable pin defined?
+  {
+    pinMode ( disable_pin, OUTPUT ) ;                 // Yes, set pin to output
+    digitalWrite ( disable_pin, LOW ) ;               // Enable output
+  }
+  return ok ;
+}
+
+
+//**************************************************************************************************
+//                               O U T P U T S A M P L E                                           *
+//**************************************************************************************************
+// Add a sample to the I2S buffer.  Send to I2S driver if buffer is full.                          *
+// The sample is scaled by outgain (volume and loudness gain) and saturated.                       *
+// For SPDIFF: the samples are collected and converted to valid frames (2 x 32 bits per sample)    *
+// by the block encoder when I2SSIZE / 4 stereo frames are complete.                               *
+//**************************************************************************************************
+void outputSample ( int16_t c )
+{
+  static uint8_t  i2sinx = 0 ;                        // Index in i2sbuf (spdifpcm for SPDIF)
+  #ifdef HELIX_SPDIF24
+    const int32_t lim = 0x7FFFFF ;                    // Scale to 24 bits, volume keeps the resolution
+    int32_t s = ( (int32_t)c * outgain ) >> ( LN_QBITS - 8 ) ;
+  #else
+    const int32_t lim = 0x7FFF ;                      // Scale to 16 bits
+    int32_t s = ( (int32_t)c * outgain ) >> LN_QBITS ;
+  #endif
+  
+  if ( s > lim )                                      // Saturate, loudness gain may be above 0 dB
+  {
+    s = lim ;
+  }
+  else if ( s < -lim - 1 )
+  {
+    s = -lim - 1 ;
+  }
+  #ifdef DEC_HELIX_INT                                // Internal DAC used?
+    c = s + 0x8000 ;                                  // Yes, shift above negative values
+  #else
+    c = s ;
+  #endif
+  #ifdef DEC_HELIX_SPDIF                              // Spdif output?
+    #ifdef HELIX_SPDIF24
+      spdifpcm[i2sinx++] = s ;                        // Store 24 bits sample for the encoder
+    #else
+      spdifpcm[i2sinx++] = c ;                        // Store sample for the encoder
+    #endif
+    if ( i2sinx < I2SSIZE / 2 )                       // Block for the encoder complete?
+    {
+      return ;                                        // No, wait for more samples
+    }
+    #ifdef HELIX_SPDIF24
+      i2sinx = Spdif_Encode24 ( spdifpcm, I2SSIZE / 4, i2sbuf ) ;  // Fills i2sbuf
+    #else
+      i2sinx = Spdif_Encode16 ( spdifpcm, I2SSIZE / 4, i2sbuf ) ;  // Fills i2sbuf
+    #endif
+  #else
+    i2sbuf[i2sinx++] = c ;                            // Store 16 bits data
+  #endif
+  if ( i2sinx == I2SSIZE )                            // Buffer filled?
+  {
+    #ifdef HELIX_DUALCORE
+      uint32_t wt = ESP.getCycleCount() ;             // Measure time waiting for DMA
+    #endif
+    i2sOutWrite ( i2sbuf, sizeof(i2sbuf) ) ;          // Yes, send to I2S, paced by DMA events
+    #ifdef HELIX_DUALCORE
+      out_i2swait += ESP.getCycleCount() - wt ;       // Not counted as load
+    #endif
+    i2sinx = 0 ;                                      // Start at new buffer
+  }
+}
+
+
+//**************************************************************************************************
+//                                   H E L I X S E T R A T E                                       *
+//**************************************************************************************************
+// Set the sample rate for a new stream.  With HELIX_FIXEDRATE the resampler is set up instead,    *
+// the I2S clock is only changed if the resampler cannot handle the rate.                          *
+//**************************************************************************************************
+void helixSetRate ( uint32_t rate )
+{
+  #ifdef HELIX_FIXEDRATE
+    if ( Resampler_Init ( rate, HELIX_FIXEDRATE ) )   // Can we convert to the fixed rate?
+    {
+      rate = HELIX_FIXEDRATE ;                        // Yes, I2S rate stays the same
+    }
+  #endif
+  #ifdef DEC_HELIX_SPDIF
+    Spdif_SetFormat ( rate, SPDIF_BITS ) ;            // Sample rate in channel status
+    rate *= 2 ;                                       // Biphase
+  #endif
+  i2sOutSetRate ( rate ) ;                            // Change I2S clock if needed
+}
+
+
+//**************************************************************************************************
+//                                 H E L I X S T A R T I 2 S                                       *
+//**************************************************************************************************
+// Start the I2S output if not already running.  On a gapless change of track the output keeps     *
+// running, a restart would reset the DMA buffers and cause a click.                               *
+//**************************************************************************************************
+void helixStartI2S()
+{
+  i2sOutStart() ;                                     // Does nothing if already started
+}
+
+
+//**************************************************************************************************
+//                                     H E L I X S L I P                                           *
+//**************************************************************************************************
+// Add the rate trim for a number of output frames.  Returns 1 if a frame must be dropped, -1 if   *
+// a frame must be inserted and 0 if nothing is to be done.                                        *
+//**************************************************************************************************
+int helixSlip ( int frames )
+{
+  slip_acc += (int64_t)slip_ppm2 * frames ;           // Accumulate deviation
+  if ( slip_acc >= 2000000 )                          // One frame ahead?
+  {
+    slip_acc -= 2000000 ;
+    slip_drop++ ;
+    return 1 ;                                        // Yes, drop one
+  }
+  if ( slip_acc <= -2000000 )                         // One frame behind?
+  {
+    slip_acc += 2000000 ;
+    slip_ins++ ;
+    return -1 ;                                       // Yes, insert one
+  }
+  return 0 ;
+}
+
+
+//**************************************************************************************************
+//                                   O U T P U T F R A M E S                                       *
+//**************************************************************************************************
+// Send frames (1 or 2 samples) to I2S.  For mono, the sample is sent to both channels.            *
+// If slip is not 0, the frame in the middle is merged with the next (slip 1) or the average of    *
+// both is inserted between them (slip -1).  The middle frame always has a next frame in buf.      *
+//**************************************************************************************************
+void outputFrames ( int16_t* buf, int frames, bool mono, int slip )
+{
+  int ch = mono ? 1 : 2 ;                             // Samples per frame
+  int mid = ( frames - 1 ) / 2 ;                      // Frame for the slip, not the last one
+  int s ;                                             // Sample to output
+
+  if ( frames < 2 )                                   // Slip needs 2 frames
+  {
+    slip = 0 ;
+  }
+  for ( int f = 0 ; f < frames ; f++ )
+  {
+    for ( int c = 0 ; c < ch ; c++ )
+    {
+      s = buf[f*ch+c] ;
+      if ( ( f == mid ) && ( slip > 0 ) )             // Drop a frame here?
+      {
+        s = ( s + buf[(f+1)*ch+c] ) / 2 ;             // Yes, average with next
+      }
+      outputSample ( s ) ;
+      if ( mono )                                     // Mono signal?
+      {
+        outputSample ( s ) ;                          // Yes, right sample equals left sample
+      }
+    }
+    if ( ( f == mid ) && slip )                       // Slip at this frame?
+    {
+      if ( slip > 0 )                                 // Drop?
+      {
+        f++ ;                                         // Yes, skip next frame
+      }
+      else
+      {
+        for ( int c = 0 ; c < ch ; c++ )              // Insert average of this and next
+        {
+          s = ( buf[f*ch+c] + buf[(f+1)*ch+c] ) / 2 ;
+          outputSample ( s ) ;
+          if ( mono )
+          {
+            outputSample ( s ) ;
+          }
+        }
+      }
+    }
+  }
+}
+
+
+//**************************************************************************************************
+//                                   O U T P U T B L O C K                                         *
+//**************************************************************************************************
+// Send a block of decoded samples to I2S.  For mono, the sample is sent to both channels.         *
+// With HELIX_FIXEDRATE the block is converted to the fixed output rate first.                     *
+// The rate trim of player_AdjustRate is applied on the output frames.                             *
+//**************************************************************************************************
+void outputBlock ( int16_t* buf, int words, bool mono )
+{
+  #ifdef HELIX_FIXEDRATE
+    if ( Resampler_Active() )                         // Conversion needed?
+    {
+      int      ch = mono ? 1 : 2 ;                    // Number of channels
+      int      frames = words / ch ;                  // Number of input frames
+      int      used ;                                 // Input frames used by resampler
+      int      n ;                                    // Output frames
+      uint32_t cycles ;                               // For measuring the resampler
+      while ( frames > 0 )
+      {
+        cycles = ESP.getCycleCount() ;
+        n = Resampler_Process ( buf, frames, ch,      // Convert part of the block
+                                srcbuf, SRCFRAMES, &used ) ;
+        src_cycles += ESP.getCycleCount() - cycles ;
+        buf += used * ch ;
+        frames -= used ;
+        outputFrames ( srcbuf, n, mono,               // Handle all converted samples
+                       helixSlip ( n ) ) ;
+      }
+      return ;
+    }
+  #endif
+  if ( ! mono )
+  {
+    words /= 2 ;                                      // Number of frames
+  }
+  outputFrames ( buf, words, mono,                    // Handle all samples in buffer
+                 helixSlip ( words ) ) ;
+}
+
+
+//**************************************************************************************************
+//                                     H E L I X P O S T                                           *
+//**************************************************************************************************
+// Mute or apply tone control to decoded samples of a stream with sample rate rate, just before    *
+// output.  The loudness meter sees the samples before tone control, the loudness gain is applied  *
+// in outputSample.                                                                                *
+//**************************************************************************************************
+void helixPost ( int16_t* pcm, int words, int ch, uint32_t rate )
+{
+  if ( muteflag )                                     // Muted?
+  {
+    memset ( pcm, 0, words * 2 ) ;                    // Yes, clear buffer
+    return ;
+  }
+  if ( ln.target && ! ln.fixed &&                     // Measure loudness of a single stream?
+       ( xf.state == XF_IDLE ) && rate )
+  {
+    helixLoudMeter ( pcm, words, ch, rate ) ;         // Yes, before tone control
+  }
+  if ( tonechange || ( tonerate != rate ) || tonefilt[0].on || tonefilt[1].on )
+  {
+    uint32_t tc = ESP.getCycleCount() ;               // Measure tone control separately
+    if ( tonechange || ( tonerate != rate ) )         // New setting or new sample rate?
+    {
+      helixToneSetup ( rate ) ;                       // Yes, compute coefficients
+    }
+    helixTone ( pcm, words, ch ) ;                    // Apply bass/treble
+    tone_cycles += ESP.getCycleCount() - tc ;
+  }
+}
+
+
+#ifdef HELIX_DUALCORE
+//**************************************************************************************************
+//                                  H E L I X O U T T A S K                                        *
+//**************************************************************************************************
+// Second stage of the pipeline, runs on the other core than playtask.                             *
+// Takes decoded frames from pcmfull, sends them to I2S and gives the buffer back in pcmfree.      *
+// MP3 is decoded in two stages: playtask does the bitstream, Huffman decoding and dequantizing    *
+// of a granule (see helixSplitGranules), this task the IMDCT, the polyphase synthesis, the        *
+// gapless trim and helixPost.  The other decoders run completely on the core of playtask, with    *
+// tone control and loudness, only the output (resampler, volume, SPDIF encoding, I2S) is moved.   *
+// Latency is measured from the moment the frame was ready for decoding until the last sample is   *
+// in the DMA buffers.  The DMA buffers add dma_buf_count * dma_buf_len samples to that.           *
+// The stack (OUTSTACK) has room for a log_i/log_e call (about 1.5 kB with vprintf), made by       *
+// Resampler_Init and Spdif_SetFormat on a change of rate, and for stage 2 of MP3.  "test" shows   *
+// the unused part.                                                                                *
+//**************************************************************************************************
+void helixOutTask ( void* )                            // Parameter not used
+{
+  pcmblock_t blk ;                                    // Frame to output
+  uint32_t   cycles ;                                 // For measuring output time
+  uint32_t   lat ;                                    // Latency of this frame
+  int        ch ;                                     // Channels of a granule
+
+  while ( true )
+  {
+    if ( xQueueReceive ( pcmfull, &blk, portMAX_DELAY ) != pdTRUE )
+    {
+      continue ;
+    }
+    cycles = ESP.getCycleCount() ;                    // Start measurement
+    out_i2swait = 0 ;
+    if ( blk.start )                                  // First frame of a new stream?
+    {
+      if ( blk.rate )                                 // Yes, change samplerate?
+      {
+        helixSetRate ( blk.rate ) ;                   // Yes, set samplerate or resampler
+      }
+      helixStartI2S() ;                               // Start I2S output
+    }
+    if ( blk.gran )                                   // MP3 granule for stage 2?
+    {
+      MP3Decoder_Select ( blk.ctx ) ;                 // Yes, decoder instance of the stream
+      if ( MP3SynthGranule ( blk.gran, granpcm ) < 0 ) // IMDCT and polyphase synthesis
+      {
+        memset ( granpcm, 0, sizeof(granpcm) ) ;      // Error, play silence
+      }
+      ch = blk.mono ? 1 : 2 ;
+      if ( blk.skip && blk.words )                    // Encoder delay in this granule?
+      {
+        memmove ( granpcm, granpcm + blk.skip * ch,   // Yes, drop it
+                  blk.words * sizeof(int16_t) ) ;
+      }
+      helixPost ( granpcm, blk.words, ch, blk.samprate ) ;  // Mute or tone control
+      syn_cycles += ESP.getCycleCount() - cycles ;
+      blk.buf = granpcm ;
+    }
+    outputBlock ( blk.buf, blk.words, blk.mono ) ;    // Send to I2S
+    out_cycles += ESP.getCycleCount() - cycles -      // Add cycles used, minus waiting for I2S
+                  out_i2swait ;
+    lat = esp_timer_get_time() - blk.t_start ;        // End-to-end latency
+    lat_total += lat ;
+    if ( lat > lat_max )                              // New maximum?
+    {
+      lat_max = lat ;                                 // Yes, remember
+    }
+    out_frames++ ;                                    // Count frames
+    if ( blk.gran )                                   // Give buffer back to decoder
+    {
+      xQueueSend ( granfree, &blk.gran, portMAX_DELAY ) ;
+    }
+    else
+    {
+      xQueueSend ( pcmfree, &blk.buf, portMAX_DELAY ) ;
+    }
+  }
+}
+
+
+//**************************************************************************************************
+//                               H E L I X S T A R T O U T P U T                                   *
+//**************************************************************************************************
+// Create the queues and start the output task on core 1.  Called once by playtask.               *
+// Both PCM buffers and all granule buffers are initially free.                                    *
+//**************************************************************************************************
+void helixStartOutput()
+{
+  int16_t*      p ;                                   // Pointer to PCM buffer
+  MP3Granule_t* g ;                                   // Pointer to granule buffer
+
+  pcmfull = xQueueCreate ( 2 + GRANSLOTS,             // Decoded frames and granules
+                           sizeof(pcmblock_t) ) ;
+  pcmfree = xQueueCreate ( 2, sizeof(int16_t*) ) ;    // Free buffers
+  granfree = xQueueCreate ( GRANSLOTS, sizeof(MP3Granule_t*) ) ;
+  p = outbuf ;
+  xQueueSend ( pcmfree, &p, 0 ) ;                     // Both buffers free
+  p = outbuf2 ;
+  xQueueSend ( pcmfree, &p, 0 ) ;
+  for ( int i = 0 ; i < GRANSLOTS ; i++ )
+  {
+    g = &granbuf[i] ;
+    xQueueSend ( granfree, &g, 0 ) ;
+  }
+  xTaskCreatePinnedToCore (
+    helixOutTask,                                     // Task to send PCM data to I2S
+    "Outtask",                                        // Name of task
+    OUTSTACK,                                         // Stack size of task
+    NULL,                                             // parameter of the task
+    2,                                                // priority of the task
+    &xouttask,                                        // Task handle to keep track of created task
+    1 ) ;                                             // Run on CPU 1
+  rep_time = esp_timer_get_time() ;                   // Start of load measurement
+}
+
+
+//**************************************************************************************************
+//                                    H E L I X F L U S H                                          *
+//**************************************************************************************************
+// Wait until the output task has sent all decoded frames to I2S.  Must be called before           *
+// i2sOutStop(), otherwise the last frames are dropped.                                            *
+//**************************************************************************************************
+void helixFlush()
+{
+  int tries = 100 ;                                   // Max. 200 msec
+
+  helixGranWait() ;
+  while ( ( uxQueueMessagesWaiting ( pcmfree ) < 2 ) && tries-- )
+  {
+    vTaskDelay ( 2 / portTICK_PERIOD_MS ) ;           // Allow output task to finish
+  }
+}
+#endif
+
+
+//**************************************************************************************************
+//                                     H E L I X E M I T                                           *
+//**************************************************************************************************
+// Send stereo frames of the old stream of a crossfade to the output, before the new stream has    *
+// its first frame.                                                                                *
+//**************************************************************************************************
+void helixEmit ( int16_t* buf, int frames )
+{
+  #ifdef HELIX_DUALCORE
+    pcmblock_t blk ;                                  // Block for output task
+    int16_t*   pcm ;                                  // Free buffer of output task
+    int        n ;                                    // Frames in this block
+
+    helixGranWait() ;                                 // No helixPost in the output task now
+    while ( frames > 0 )
+    {
+      n = ( frames < OUTSIZE ) ? frames : OUTSIZE ;   // Limited by size of buffer
+      blk.t_start = esp_timer_get_time() ;            // Start of latency measurement
+      xQueueReceive ( pcmfree, &pcm, portMAX_DELAY ) ;
+      memcpy ( pcm, buf, n * 4 ) ;
+      helixPost ( pcm, n * 2, 2, xf.v.samprate ) ;
+      blk.buf = pcm ;
+      blk.words = n * 2 ;
+      blk.mono = false ;
+      blk.start = false ;                             // Output is running already
+      blk.rate = 0 ;
+      xQueueSend ( pcmfull, &blk, portMAX_DELAY ) ;
+      buf += n * 2 ;
+      frames -= n ;
+    }
+  #else
+    helixPost ( buf, frames * 2, 2, xf.v.samprate ) ;
+    outputBlock ( buf, frames * 2, false ) ;          // Send to I2S
+  #endif
+}
+
+
+//**************************************************************************************************
+//                             H E L I X S W A P V O I C E                                         *
+//**************************************************************************************************
+// Exchange the decoding state of the current stream with the state in v.  The decoder instances   *
+// of the stream in the globals are selected for this task.                                        *
+//**************************************************************************************************
+void helixSwapVoice ( voice_t* v )
+{
+  std::swap ( mp3mode, v->mp3mode ) ;
+  std::swap ( oggmode, v->oggmode ) ;
+  std::swap ( opusmode, v->opusmode ) ;
+  std::swap ( flacmode, v->flacmode ) ;
+  std::swap ( wavmode, v->wavmode ) ;
+  std::swap ( oggprobe, v->oggprobe ) ;
+  std::swap ( mp3buff, v->mp3buff ) ;
+  std::swap ( mp3bpnt, v->mp3bpnt ) ;
+  std::swap ( mp3bcnt, v->mp3bcnt ) ;
+  std::swap ( searchFrame, v->searchFrame ) ;
+  std::swap ( id3skip, v->id3skip ) ;
+  std::swap ( samprate, v->samprate ) ;
+  std::swap ( channels, v->channels ) ;
+  std::swap ( smpbytes, v->smpbytes ) ;
+  std::swap ( smpwords, v->smpwords ) ;
+  std::swap ( once, v->once ) ;
+  std::swap ( gl_skip, v->gl_skip ) ;
+  std::swap ( gl_left, v->gl_left ) ;
+  std::swap ( sbrbypass, v->sbrbypass ) ;
+  std::swap ( sbr_frames, v->sbr_frames ) ;
+  std::swap ( sbr_cycles, v->sbr_cycles ) ;
+  std::swap ( mp3ctx, v->mp3ctx ) ;
+  std::swap ( aacctx, v->aacctx ) ;
+  MP3Decoder_Select ( mp3ctx ) ;                      // Decoders of the stream in the globals
+  AACDecoder_Select ( aacctx ) ;
+}
+
+
+//**************************************************************************************************
+//                             H E L I X X F A D E R E A D Y                                       *
+//**************************************************************************************************
+// Check if a crossfade to a new stream can be started.  The current stream must be playing with   *
+// a low decoder load and there must be RAM for a second decoder.  The buffers are allocated in   *
+// one piece (the arena), so the largest free block counts.  Called by the main task.             *
+//**************************************************************************************************
+bool helixXfadeReady()
+{
+  const char* why = NULL ;                            // Reason for refusal
+  uint32_t    need ;                                  // Internal RAM needed for the second stream
+  uint32_t    arena ;                                 // Buffers of the largest decoder
+
+  if ( ( xf.secs == 0 ) || ( xf.state != XF_IDLE ) || ( samprate == 0 ) )
+  {
+    return false ;                                    // Off, busy or nothing playing
+  }
+  arena = ( m_ARENA_BUDGET > AAC_ARENA_BUDGET ) ? m_ARENA_BUDGET : AAC_ARENA_BUDGET ;
+  need = XF_FIFOSIZE * 4 + OUTSIZE * 4 +              // Fifo, PCM and frame buffer
+         SYNCSIZE + 32 +
+         sizeof(MP3Decoder_t) + sizeof(AACDecoder_t) + arena ;
+  if ( dec_load > XF_MAXLOAD )
+  {
+    why = "decoder load too high" ;
+  }
+  else if ( heap_caps_get_free_size ( MALLOC_CAP_INTERNAL ) < ( need + XF_MINHEAP ) )
+  {
+    why = "not enough RAM" ;
+  }
+  else if ( heap_caps_get_largest_free_block ( MALLOC_CAP_INTERNAL ) < arena )
+  {
+    why = "RAM too fragmented" ;
+  }
+  if ( why )
+  {
+    ESP_LOGI ( HTAG, "No crossfade, %s", why ) ;
+    xf.cuts++ ;
+    return false ;
+  }
+  return true ;
+}
+
+
+//**************************************************************************************************
+//                             H E L I X X F A D E B Y T E S                                       *
+//**************************************************************************************************
+// Number of input bytes of the current stream for ms milliseconds, 0 for the "crossfade" setting. *
+// Returns 0 if the byte rate is not known yet.                                                    *
+//**************************************************************************************************
+uint32_t helixXfadeBytes ( uint32_t ms )
+{
+  if ( ms == 0 )
+  {
+    ms = xf.secs * 1000 ;                             // Length of the setting
+  }
+  if ( ( xf.state != XF_IDLE ) || ( samprate == 0 ) || ( br_frames < samprate ) )
+  {
+    return 0 ;                                        // Less than a second measured
+  }
+  return (uint64_t)br_bytes * ms * samprate / 1000 / br_frames ;
+}
+
+
+//**************************************************************************************************
+//                             H E L I X X F A D E A R M                                           *
+//**************************************************************************************************
+// Prepare a crossfade of max. ms milliseconds (0 for the setting).  The old stream will be sent   *
+// to fadequeue after a QFADESONG in the data queue.  With tail set, the old stream will be played *
+// to the end if the fade is not possible.  Called by the main task after helixXfadeReady().       *
+//**************************************************************************************************
+void helixXfadeArm ( uint32_t ms, bool tail )
+{
+  if ( ( ms == 0 ) || ( ms > xf.secs * 1000U ) )
+  {
+    ms = xf.secs * 1000 ;                             // Not longer than the setting
+  }
+  xf.ms = ms ;
+  xf.tail = tail ;
+  xf.eof = false ;
+  xf.state = XF_PENDING ;                             // Waiting for QFADESONG
+}
+
+
+//**************************************************************************************************
+//                             H E L I X X F A D E A R M E D                                       *
+//**************************************************************************************************
+// QFADESONG seen by playtask, the old stream comes from fadequeue now.                            *
+//**************************************************************************************************
+void helixXfadeArmed()
+{
+  if ( xf.state == XF_PENDING )
+  {
+    xf.t_armed = esp_timer_get_time() ;               // Start of wait for new stream
+    xf.state = XF_ARMED ;
+  }
+}
+
+
+//**************************************************************************************************
+//                             H E L I X X F A D E B U S Y                                         *
+//**************************************************************************************************
+// True if a crossfade is prepared or running.                                                     *
+//**************************************************************************************************
+bool helixXfadeBusy()
+{
+  return ( xf.state != XF_IDLE ) ;
+}
+
+
+//**************************************************************************************************
+//                             H E L I X X F A D E H O L D                                         *
+//**************************************************************************************************
+// True if the new stream must wait until the old one has been played to the end.                  *
+//**************************************************************************************************
+bool helixXfadeHold()
+{
+  return ( xf.state == XF_TAIL ) ;
+}
+
+
+//**************************************************************************************************
+//                             H E L I X X F A D E M I X I N G                                     *
+//**************************************************************************************************
+// True if both streams are mixed.  The old stream is only read as far as needed for mixing then.  *
+//**************************************************************************************************
+bool helixXfadeMixing()
+{
+  return ( xf.state == XF_FADE ) ;
+}
+
+
+//**************************************************************************************************
+//                             H E L I X X F A D E F R E E                                         *
+//**************************************************************************************************
+// Free the decoders and buffers of the old stream.                                                *
+//**************************************************************************************************
+void helixXfadeFree()
+{
+  MP3Decoder_t* pm = MP3Decoder_Select ( xf.v.mp3ctx ) ;  // Decoders of the old stream
+  AACDecoder_t* pa = AACDecoder_Select ( xf.v.aacctx ) ;
+
+  #ifdef HELIX_DUALCORE
+    helixGranWait() ;                                 // Output task may still use the old decoder
+  #endif
+  MP3Decoder_FreeBuffers() ;                          // Only one of them is in use
+  AACDecoder_FreeBuffers() ;
+  MP3Decoder_Select ( pm ) ;                          // Back to the current stream
+  AACDecoder_Select ( pa ) ;
+  if ( xf.v.flacmode )                                // Other decoders have one instance,
+  {                                                   // not in use by the new stream
+    FlacDecoder_FreeBuffers() ;
+  }
+  else if ( xf.v.wavmode )
+  {
+    WavDecoder_FreeBuffers() ;
+  }
+  #ifdef HELIX_OPUS
+  else if ( xf.v.opusmode )
+  {
+    OggOpusDecoder_FreeBuffers() ;
+  }
+  #endif
+  else if ( xf.v.oggmode )
+  {
+    VorbisDecoder_FreeBuffers() ;
+  }
+  free ( xf.v.mp3ctx ) ;                              // NULL for the default instances
+  free ( xf.v.aacctx ) ;
+  if ( xf.v.mp3buff != mp3buf0 )                      // Frame buffer from heap?
+  {
+    free ( xf.v.mp3buff ) ;
+  }
+  free ( xf.pcm ) ;
+  free ( xf.fifo ) ;
+  xf.pcm = NULL ;
+  xf.fifo = NULL ;
+  xf.fifocnt = 0 ;
+  memset ( &xf.v, 0, sizeof(xf.v) ) ;
+}
+
+
+//**************************************************************************************************
+//                             H E L I X X F A D E E N D                                           *
+//**************************************************************************************************
+// End or abort a crossfade.  The old stream, if any, is dropped.                                  *
+//**************************************************************************************************
+void helixXfadeEnd()
+{
+  if ( ( xf.state == XF_WAIT ) || ( xf.state == XF_FADE ) )
+  {
+    helixXfadeFree() ;                                // Old stream has a decoder
+  }
+  xf.state = XF_IDLE ;
+}
+
+
+//**************************************************************************************************
+//                             H E L I X X F A D E S T A R T                                       *
+//**************************************************************************************************
+// Called on QSTARTSONG.  If a crossfade is armed, the current stream is kept as the old stream    *
+// and the new one gets a second decoder.  Returns false if the caller must start the new stream  *
+// the normal way by helixInit().  If the buffers of the second decoder cannot be allocated, the    *
+// old stream is stopped and the new one starts with a hard cut.                                   *
+//**************************************************************************************************
+bool helixXfadeStart ( int8_t enable_pin, int8_t disable_pin )
+{
+  const char* why = NULL ;                            // Reason for refusal
+  bool        single ;                                // New stream needs a single instance decoder
+
+  if ( xf.state != XF_ARMED )                         // Crossfade to this stream?
+  {
+    if ( xf.state != XF_IDLE )                        // No, drop anything prepared
+    {
+      helixXfadeEnd() ;
+    }
+    return false ;
+  }
+  single = ( audio_ct.indexOf ( "ogg" ) > 0 ) || ( audio_ct.indexOf ( "opus" ) > 0 ) ||
+           ( audio_ct.indexOf ( "flac" ) > 0 ) || ( audio_ct.indexOf ( "wav" ) > 0 ) ;
+  memset ( &xf.v, 0, sizeof(xf.v) ) ;                // State of the new stream
+  if ( samprate == 0 )
+  {
+    why = "old stream not playing" ;
+  }
+  else if ( dec_load > XF_MAXLOAD )
+  {
+    why = "decoder load too high" ;
+  }
+  else if ( single && ( oggmode || flacmode || wavmode ) )
+  {
+    why = "both streams need the same decoder" ;
+  }
+  else
+  {
+    xf.pcm = (int16_t*)malloc ( OUTSIZE * 4 ) ;       // Output of the old stream
+    xf.fifo = (int16_t*)malloc ( XF_FIFOSIZE * 4 ) ;
+    xf.v.mp3buff = mp3buf0 ;                          // Frame buffer not in use
+    if ( mp3buff == mp3buf0 )
+    {
+      xf.v.mp3buff = (uint8_t*)malloc ( SYNCSIZE + 32 ) ;
+    }
+    if ( mp3ctx == NULL )                             // Decoders not in use
+    {
+      xf.v.mp3ctx = (MP3Decoder_t*)calloc ( 1, sizeof(MP3Decoder_t) ) ;
+      xf.v.aacctx = (AACDecoder_t*)calloc ( 1, sizeof(AACDecoder_t) ) ;
+    }
+    if ( ! ( xf.pcm && xf.fifo && xf.v.mp3buff &&
+             ( mp3ctx || ( xf.v.mp3ctx && xf.v.aacctx ) ) ) )
+    {
+      why = "not enough RAM" ;
+      free ( xf.v.mp3ctx ) ;                          // Give back what we got
+      free ( xf.v.aacctx ) ;
+      if ( xf.v.mp3buff != mp3buf0 )
+      {
+        free ( xf.v.mp3buff ) ;
+      }
+      free ( xf.pcm ) ;
+      free ( xf.fifo ) ;
+      xf.pcm = NULL ;
+      xf.fifo = NULL ;
+      memset ( &xf.v, 0, sizeof(xf.v) ) ;
+    }
+  }
+  if ( why )
+  {
+    ESP_LOGI ( HTAG, "No crossfade, %s", why ) ;
+    xf.cuts++ ;
+    if ( xf.tail )                                    // Play old stream to the end?
+    {
+      xf.state = XF_TAIL ;                            // Yes, new stream waits
+      return true ;
+    }
+    xf.state = XF_IDLE ;                              // No, start the new stream now
+    return false ;
+  }
+  xf.v.mp3bpnt = xf.v.mp3buff ;
+  xf.v.gl_left = -1 ;
+  helixSwapVoice ( &xf.v ) ;                          // Old stream to xf.v
+  xf.fifocnt = 0 ;
+  xf.cycles = 0 ;
+  xf.frames = 0 ;
+  xf.state = XF_WAIT ;                                // Until the first frame of the new stream
+  if ( ! helixInit ( enable_pin, disable_pin ) )      // New stream in the globals
+  {
+    ESP_LOGI ( HTAG, "Crossfade cut, no decoder buffers" ) ;
+    xf.cuts++ ;
+    helixXfadeEnd() ;                                 // Free the old stream
+    helixInit ( enable_pin, disable_pin ) ;           // and try again
+  }
+  else if ( heap_caps_get_free_size ( MALLOC_CAP_INTERNAL ) < XF_MINHEAP )
+  {
+    ESP_LOGI ( HTAG, "Crossfade cut, not enough RAM" ) ;
+    xf.cuts++ ;
+    helixXfadeEnd() ;
+  }
+  return true ;
+}
+
+
+//**************************************************************************************************
+//                             H E L I X X F A D E P U S H                                         *
+//**************************************************************************************************
+// Add decoded frames of the old stream to the fifo, as stereo.                                    *
+//**************************************************************************************************
+void helixXfadePush ( const int16_t* pcm, int words, int ch )
+{
+  int      frames = words / ch ;                      // Frames to add
+  int16_t* p = xf.fifo + xf.fifocnt * 2 ;             // Free part of fifo
+
+  if ( frames > ( XF_FIFOSIZE - xf.fifocnt ) )        // Room for all of them?
+  {
+    frames = XF_FIFOSIZE - xf.fifocnt ;               // No, drop the rest
+  }
+  for ( int f = 0 ; f < frames ; f++ )
+  {
+    *p++ = pcm[f*ch] ;                                // Left
+    *p++ = pcm[f*ch+ch-1] ;                           // Right, same as left for mono
+  }
+  xf.fifocnt += frames ;
+}
+
+
+//**************************************************************************************************
+//                             H E L I X X F A D E T A K E                                         *
+//**************************************************************************************************
+// Remove frames from the start of the fifo.                                                       *
+//**************************************************************************************************
+void helixXfadeTake ( int frames )
+{
+  xf.fifocnt -= frames ;
+  memmove ( xf.fifo, xf.fifo + frames * 2, xf.fifocnt * 4 ) ;
+}
+
+
+//**************************************************************************************************
+//                             H E L I X X F A D E B E G I N                                       *
+//**************************************************************************************************
+// First frame of the new stream decoded.  Start mixing if both streams have the same sample rate. *
+//**************************************************************************************************
+bool helixXfadeBegin()
+{
+  if ( samprate != xf.v.samprate )                    // Mixing needs the same rate
+  {
+    ESP_LOGI ( HTAG, "Crossfade cut, sample rates differ" ) ;
+    xf.cuts++ ;
+    helixXfadeEnd() ;
+    return false ;
+  }
+  xf.len = (uint64_t)xf.ms * samprate / 1000 ;        // Length in frames
+  if ( xf.len == 0 )
+  {
+    xf.len = 1 ;
+  }
+  xf.pos = 0 ;
+  xf.cycles = 0 ;
+  xf.frames = 0 ;
+  xf.state = XF_FADE ;
+  ESP_LOGI ( HTAG, "Crossfade of %d msec", xf.ms ) ;
+  return true ;
+}
+
+
+//**************************************************************************************************
+//                             H E L I X X F A D E M I X                                           *
+//**************************************************************************************************
+// Mix a decoded frame of the new stream with the old stream in the fifo.  The gain of the new     *
+// stream rises linearly from 0 to 1 over the length of the fade.  The result is always stereo,    *
+// a mono frame is expanded in place from the end.  Returns the number of words in pcm.            *
+// The fade is cut if both decoders together use too much of the frame time.                      *
+//**************************************************************************************************
+int helixXfadeMix ( int16_t* pcm, int words, int ch )
+{
+  int      frames = words / ch ;                      // Frames in this block
+  int      have ;                                     // Frames of old stream available
+  int32_t  g0 ;                                       // Gain of new stream at first frame (Q15)
+  int32_t  dg ;                                       // Increment per frame (Q31)
+  int32_t  g ;                                        // Gain of new stream (Q15)
+  int32_t  l, r ;                                     // New samples
+  int32_t  ol = 0, orr = 0 ;                          // Old samples
+  uint64_t budget ;                                   // Cycles available for the measured frames
+
+  have = ( frames < xf.fifocnt ) ? frames : xf.fifocnt ;
+  g0 = (int32_t)( ( (uint64_t)xf.pos << 15 ) / xf.len ) ;
+  dg = (int32_t)( ( (uint64_t)32768 << 16 ) / xf.len ) ;
+  for ( int f = frames - 1 ; f >= 0 ; f-- )
+  {
+    g = g0 + (int32_t)( ( (int64_t)f * dg ) >> 16 ) ;
+    if ( g > 32768 )                                  // End of fade in this block?
+    {
+      g = 32768 ;
+    }
+    l = pcm[f*ch] ;
+    r = pcm[f*ch+ch-1] ;
+    if ( f < have )
+    {
+      ol = xf.fifo[f*2] ;
+      orr = xf.fifo[f*2+1] ;
+    }
+    pcm[f*2] = ( l * g + ol * ( 32768 - g ) ) >> 15 ;
+    pcm[f*2+1] = ( r * g + orr * ( 32768 - g ) ) >> 15 ;
+  }
+  if ( ! xf.eof )                                     // Old stream too slow?
+  {
+    xf.under += frames - have ;                       // Count the gap
+  }
+  helixXfadeTake ( have ) ;
+  xf.pos += frames ;
+  xf.frames += frames ;
+  if ( ( xf.pos >= xf.len ) ||                        // Fade complete?
+       ( xf.eof && ( xf.fifocnt == 0 ) ) )            // Or old stream ended?
+  {
+    ESP_LOGI ( HTAG, "Crossfade done, %d frames without old stream", xf.under ) ;
+    xf.fades++ ;
+    helixXfadeEnd() ;
+  }
+  else if ( xf.frames >= ( samprate / XF_TESTDIV ) )  // Time to check the load?
+  {
+    budget = (uint64_t)xf.frames * ESP.getCpuFreqMHz() * 1000000 / samprate ;
+    if ( xf.cycles * 100 > budget * XF_ABORTLOAD )    // Both decoders too heavy?
+    {
+      ESP_LOGI ( HTAG, "Crossfade cut, decoder load %d%%",
+                 (int)( xf.cycles * 100 / budget ) ) ;
+      xf.cuts++ ;
+      helixXfadeEnd() ;
+    }
+    xf.cycles = 0 ;
+    xf.frames = 0 ;
+  }
+  return frames * 2 ;
+}
+
+
+//**************************************************************************************************
+//                             H E L I X X F A D E W A N T                                         *
+//**************************************************************************************************
+// True if playtask must give the next chunk of fadequeue to helixXfadeChunk().  First is true for *
+// the first chunk in a pass of the playtask loop.  While mixing, the old stream is decoded until  *
+// XF_KEEP frames are ready.  An armed fade ends if the new stream does not start in time.         *
+//**************************************************************************************************
+bool helixXfadeWant ( bool first )
+{
+  switch ( xf.state )
+  {
+    case XF_ARMED :
+      if ( ( esp_timer_get_time() - xf.t_armed ) > ( XF_ARMTIME * 1000LL ) )
+      {
+        ESP_LOGI ( HTAG, "Crossfade cut, no new stream" ) ;
+        xf.cuts++ ;
+        helixXfadeEnd() ;
+        return false ;
+      }
+      return true ;                                   // Only stream playing
+    case XF_TAIL :
+      return true ;
+    case XF_WAIT :
+      return first ;                                  // Alternate with the new stream
+    case XF_FADE :
+      return ( xf.fifocnt < XF_KEEP ) ;
+  }
+  return false ;
+}
+
+
+//**************************************************************************************************
+//                             H E L I X X F A D E C H U N K                                       *
+//**************************************************************************************************
+// Handle a chunk of the old stream from fadequeue, NULL is its end.  Before the new stream starts *
+// (armed, or refused with tail) the old stream is simply played.  Otherwise it is decoded as      *
+// a second "voice": the globals are swapped with xf.v and the output goes to the fifo.  Until the *
+// new stream has its first frame, everything but the last XF_KEEP frames is played directly.      *
+//**************************************************************************************************
+void helixXfadeChunk ( const uint8_t* chunk )
+{
+  if ( ( xf.state == XF_ARMED ) || ( xf.state == XF_TAIL ) )
+  {
+    if ( chunk )
+    {
+      playChunk ( chunk ) ;                           // Only stream playing
+    }
+    else if ( xf.state == XF_TAIL )                   // End of old SD track?
+    {
+      xf.state = XF_IDLE ;
+      helixNextTrack() ;                              // Yes, next track follows in data queue
+    }
+    else
+    {
+      helixXfadeEnd() ;                               // Old station stopped
+    }
+    return ;
+  }
+  if ( ( xf.state != XF_WAIT ) && ( xf.state != XF_FADE ) )
+  {
+    return ;                                          // Fade has ended
+  }
+  if ( chunk == NULL )
+  {
+    xf.eof = true ;
+  }
+  else if ( ! xf.eof )
+  {
+    helixSwapVoice ( &xf.v ) ;                        // Old stream in the globals
+    xfvoice = true ;
+    playChunk ( chunk ) ;                             // Decode to the fifo
+    xfvoice = false ;
+    helixSwapVoice ( &xf.v ) ;                        // New stream back
+  }
+  if ( xf.state == XF_WAIT )                          // New stream not playing yet?
+  {
+    int n = xf.eof ? xf.fifocnt : ( xf.fifocnt - XF_KEEP ) ;
+    if ( n > 0 )
+    {
+      helixEmit ( xf.fifo, n ) ;                      // Play old stream directly
+      helixXfadeTake ( n ) ;
+    }
+    if ( xf.eof )                                     // Nothing left to mix?
+    {
+      helixXfadeEnd() ;
+    }
+  }
+}
+
+
+//**************************************************************************************************
+//                                     H E L I X S T O P                                           *
+//**************************************************************************************************
+// Stop the output at the end of a song.  Any frames still in the pipeline are played first.       *
+//**************************************************************************************************
+void helixStop()
+{
+  if ( xf.state != XF_IDLE )                          // Crossfade running?
+  {
+    helixXfadeEnd() ;                                 // Yes, drop old stream
+  }
+  #ifdef HELIX_DUALCORE
+    helixFlush() ;                                    // Let output task finish
+  #endif
+  i2sOutStop() ;                                      // Stop DAC
+}
+
+
+//**************************************************************************************************
+//                                    C H E C K I D 3                                              *
+//**************************************************************************************************
+// Check for an ID3v2 tag at the start of the buffer.  If found, the tag will be skipped.           *
+// Album art in the tag often contains false sync words, so do not even search in there.           *
+//**************************************************************************************************
+void checkID3()
+{
+  uint32_t tagsize ;                                  // Total size of tag including header
+
+  if ( ( mp3bcnt < 10 ) ||                            // Need the complete tag header
+       ( memcmp ( mp3buff, "ID3", 3 ) != 0 ) ||       // Starts with "ID3"?
+       ( ( mp3buff[6] | mp3buff[7] |                  // Size must be synchsafe
+           mp3buff[8] | mp3buff[9] ) & 0x80 ) )
+  {
+    return ;                                          // No ID3v2 tag
+  }
+  tagsize = ( mp3buff[6] << 21 ) | ( mp3buff[7] << 14 ) |
+            ( mp3buff[8] << 7  ) |   mp3buff[9] ;
+  tagsize += 10 ;                                     // Add size of header
+  if ( mp3buff[5] & 0x10 )                            // Footer present?
+  {
+    tagsize += 10 ;                                   // Yes, add size of footer
+  }
+  ESP_LOGI ( HTAG, "Skip ID3 tag of %d bytes",
+             tagsize ) ;
+  if ( tagsize < (uint32_t)mp3bcnt )                  // Tag completely in buffer?
+  {
+    mp3bcnt -= tagsize ;                              // Yes, remove it
+    memcpy ( mp3buff, mp3buff + tagsize, mp3bcnt ) ;  // Shift mp3 data to begin of buffer
+  }
+  else
+  {
+    id3skip = tagsize - mp3bcnt ;                     // Skip rest of tag in next chunks
+    mp3bcnt = 0 ;                                     // Buffer empty
+  }
+  mp3bpnt = mp3buff + mp3bcnt ;                       // Adjust fill pointer
+}
+
+
+//**************************************************************************************************
+//                                  H E L I X P A R S E X I N G                                    *
+//**************************************************************************************************
+// Check if the first MP3 frame is a Xing/Info frame.  This frame contains no audio.  If the       *
+// encoder (LAME or ffmpeg) added its tag, the encoder delay and padding are used to skip the      *
+// silence at the start and the end of the track, so albums play without gaps.                    *
+// The decoder itself adds a delay of 529 samples.  The Xing frame is removed from the buffer.     *
+//**************************************************************************************************
+void helixParseXing()
+{
+  const uint8_t* p = mp3buff ;                        // Frame header
+  bool           mpeg1 = ( ( p[1] & 0x18 ) == 0x18 ) ;
+  bool           mono = ( ( p[3] & 0xC0 ) == 0xC0 ) ;
+  int            q ;                                  // Offset in frame
+  int            len ;                                // Length of the frame
+  uint32_t       flags ;                              // Xing flags
+  uint32_t       frames = 0 ;                         // Number of audio frames
+  int            delay ;                              // Encoder delay in samples
+  int            padding ;                            // Encoder padding in samples
+  int            spf = mpeg1 ? 1152 : 576 ;           // Samples per frame
+  int            hr = halfrate ? 1 : 0 ;              // Output is decimated by 2 in halfrate
+
+  len = MP3GetFrameLength ( mp3buff ) ;
+  q = 4 + ( mpeg1 ? ( mono ? 17 : 32 ) :              // Skip header and side info
+                    ( mono ? 9 : 17 ) ) ;
+  if ( ( p[1] & 0x01 ) == 0 )                         // CRC present?
+  {
+    q += 2 ;                                          // Yes, skip it
+  }
+  if ( ( len < q + 8 ) || ( len > mp3bcnt ) ||        // Frame must be in the buffer
+       ( ( memcmp ( p + q, "Xing", 4 ) != 0 ) &&
+         ( memcmp ( p + q, "Info", 4 ) != 0 ) ) )
+  {
+    return ;                                          // No Xing frame
+  }
+  flags = ( p[q+4] << 24 ) | ( p[q+5] << 16 ) | ( p[q+6] << 8 ) | p[q+7] ;
+  q += 8 ;
+  if ( flags & 0x01 )                                 // Number of frames present?
+  {
+    frames = ( p[q] << 24 ) | ( p[q+1] << 16 ) | ( p[q+2] << 8 ) | p[q+3] ;
+    q += 4 ;
+  }
+  if ( flags & 0x02 )                                 // Skip number of bytes
+  {
+    q += 4 ;
+  }
+  if ( flags & 0x04 )                                 // Skip TOC
+  {
+    q += 100 ;
+  }
+  if ( flags & 0x08 )                                 // Skip quality
+  {
+    q += 4 ;
+  }
+  if ( ( q + 24 <= len ) &&                           // Room for the LAME tag?
+       ( ( memcmp ( p + q, "LAME", 4 ) == 0 ) ||
+         ( memcmp ( p + q, "Lavc", 4 ) == 0 ) ||
+         ( memcmp ( p + q, "Lavf", 4 ) == 0 ) ) )
+  {
+    delay = ( p[q+21] << 4 ) | ( p[q+22] >> 4 ) ;     // 12 bits delay
+    padding = ( ( p[q+22] & 0x0F ) << 8 ) | p[q+23] ; // 12 bits padding
+    gl_skip = ( delay + 529 ) >> hr ;                 // Skip encoder and decoder delay
+    if ( frames )                                     // Length known?
+    {
+      gl_left = ( (int32_t)frames * spf - delay - padding ) >> hr ;
+    }
+    ESP_LOGI ( HTAG, "Gapless: delay %d, padding %d, %d frames",
+               delay, padding, frames ) ;
+  }
+  mp3bcnt -= len ;                                    // Remove the Xing frame
+  memcpy ( mp3buff, mp3buff + len, mp3bcnt ) ;        // Shift mp3 data to begin of buffer
+  mp3bpnt = mp3buff + mp3bcnt ;                       // Adjust fill pointer
+}
+
+
+//**************************************************************************************************
+//                                H E L I X T R I M C O U N T                                      *
+//**************************************************************************************************
+// Count the encoder delay and padding in the next "frames" samples per channel.  Returns the      *
+// number of samples per channel to keep, skip is set to the number to drop before them.           *
+//**************************************************************************************************
+int helixTrimCount ( int frames, int* skip )
+{
+  *skip = 0 ;
+  if ( gl_skip )                                      // Still in the encoder delay?
+  {
+    *skip = ( gl_skip < frames ) ? gl_skip : frames ; // Yes, skip (part of) this frame
+    gl_skip -= *skip ;
+    frames -= *skip ;
+  }
+  if ( gl_left >= 0 )                                 // Length of track known?
+  {
+    if ( frames > gl_left )                           // Yes, in the padding?
+    {
+      frames = gl_left ;                              // Yes, drop the padding
+    }
+    gl_left -= frames ;
+  }
+  return frames ;
+}
+
+
+//**************************************************************************************************
+//                                     H E L I X T R I M                                           *
+//**************************************************************************************************
+// Remove the encoder delay and padding from a decoded frame.  Returns the number of words left.   *
+//**************************************************************************************************
+int helixTrim ( int16_t* pcm, int words, int channels )
+{
+  int skip ;                                          // Samples per channel to skip
+  int frames = helixTrimCount ( words / channels,     // Samples per channel to keep
+                                &skip ) ;
+
+  if ( skip && frames )                               // Samples to move to begin of buffer?
+  {
+    memmove ( pcm, pcm + skip * channels,
+              frames * channels * sizeof(int16_t) ) ;
+  }
+  return frames * channels ;
+}
+
+
+#ifdef HELIX_DUALCORE
+//**************************************************************************************************
+//                             H E L I X S P L I T G R A N U L E S                                 *
+//**************************************************************************************************
+// Stage 1 of an MP3 frame after MP3DecodeHeader: decode the granules (Huffman, dequantize) and    *
+// hand each one over to the output task for stage 2 (IMDCT, synthesis, trim and helixPost).       *
+// With GRANSLOTS buffers stage 1 of a granule runs while the output task does stage 2 of the one  *
+// before.  The cycles waiting for a free buffer are added to wait, they are no load.              *
+//**************************************************************************************************
+int helixSplitGranules ( pcmblock_t* blk, uint32_t* wait )
+{
+  int      grans = MP3GetGranules() ;                 // Granules in this frame, 1 or 2
+  int      ch = ( channels == 1 ) ? 1 : 2 ;           // Channels in the output
+  int      frames = smpwords / ch / grans ;           // Samples per channel in a granule
+  int      n ;                                        // Result of MP3DecodeGranule
+  uint32_t w ;                                        // Start of wait
+
+  for ( int gr = 0 ; gr < grans ; gr++ )
+  {
+    w = ESP.getCycleCount() ;
+    xQueueReceive ( granfree, &blk->gran, portMAX_DELAY ) ; // Wait for a free granule buffer
+    *wait += ESP.getCycleCount() - w ;
+    n = MP3DecodeGranule ( gr, blk->gran ) ;          // Stage 1 of this granule
+    if ( n < 0 )
+    {
+      xQueueSend ( granfree, &blk->gran, 0 ) ;        // Buffer not used
+      blk->gran = NULL ;
+      return n ;
+    }
+    blk->ctx = mp3ctx ;                               // Stage 2 with the same decoder instance
+    blk->words = helixTrimCount ( frames, &blk->skip ) * ch ;
+    blk->mono = ( ch == 1 ) ;
+    blk->samprate = samprate ;
+    blk->start = once && ( gr == 0 ) ;                // First frame of the stream (re)starts I2S
+    blk->rate = ( blk->start ) ? samprate : 0 ;
+    blk->buf = NULL ;
+    xQueueSend ( pcmfull, blk, portMAX_DELAY ) ;
+  }
+  blk->gran = NULL ;
+  return ERR_MP3_NONE ;
+}
+#endif
+
+
+//**************************************************************************************************
+//                                   D E C O D E F R A M E                                         *
+//**************************************************************************************************
+// Decode the frame at the start of mp3buff and send the samples to the output.                    *
+//**************************************************************************************************
+void decodeFrame()
+{
+  int             n ;                                 // Number of samples decoded
+  int             br = 0 ;                            // Bit rate
+  int             bps = 0 ;                           // Bits per sample
+  int             words ;                             // Words left after gapless trim
+  int             ch ;                                // Channels in pcm, 1 or 2
+
+  int      newcnt = mp3bcnt ;                         // Used to get number of bytes converted
+  int16_t* pcm = xfvoice ? xf.pcm : outbuf ;          // Buffer for decoded samples
+  #ifdef HELIX_DUALCORE
+    pcmblock_t blk ;                                  // Frame for output task
+    bool       split = mp3mode && ! xfvoice &&        // MP3 in two stages, see helixOutTask,
+                       ( xf.state == XF_IDLE ) ;      // not while mixing with an old stream
+    uint32_t   wait = 0 ;                             // Cycles waiting for granule buffers
+    blk.t_start = esp_timer_get_time() ;              // Start of latency measurement
+    blk.gran = NULL ;                                 // Not a granule
+    if ( ! split )
+    {
+      helixGranWait() ;                               // Decoder and helixPost not used by output task
+      if ( ! xfvoice )                                // Old stream of crossfade goes to the fifo
+      {
+        xQueueReceive ( pcmfree, &pcm, portMAX_DELAY ) ; // Wait for a free buffer
+      }
+    }
+  #endif
+  uint32_t cycles = ESP.getCycleCount() ;             // For measuring decode time
+  if ( mp3mode )
+  {
+    #ifdef HELIX_DUALCORE
+      if ( split )
+      {
+        n = MP3DecodeHeader ( mp3buff, &newcnt, 0 ) ; // Stage 1, granules follow
+      }
+      else
+    #endif
+    {
+      n = MP3Decode ( mp3buff, &newcnt,               // Decode the frame
+                      pcm, 0 ) ;
+    }
+    if ( n == ERR_MP3_NONE )
+    {
+      if ( once )
+      {
+        samprate = MP3GetSampRate() ;                 // Get sample rate
+        channels = MP3GetChannels() ;                 // Get number of channels
+        br       = MP3GetBitrate() ;                  // Get bit rate
+        bps      = MP3GetBitsPerSample() ;            // Get bits per sample
+        smpwords = MP3GetOutputSamps() ;              // Get number of output samples
+      }
+      #ifdef HELIX_DUALCORE
+        if ( split )
+        {
+          n = helixSplitGranules ( &blk, &wait ) ;    // Huffman and dequantize, to output task
+        }
+      #endif
+    }
+  }
+  else if ( flacmode )
+  {
+    n = FlacDecode ( mp3buff, &newcnt, pcm ) ;        // Decode the next frame or return the rest of it
+    if ( n == ERR_FLAC_NONE )
+    {
+      if ( ( samprate != (uint32_t)FlacGetSampRate() ) ||
+           ( channels != FlacGetChannels() ) )        // New stream or track?
+      {
+        once = true ;                                 // Yes, set samplerate again
+      }
+      smpwords = FlacGetOutputSamps() ;               // Number of samples differs per frame
+      if ( once )
+      {
+        samprate = FlacGetSampRate() ;                // Get sample rate
+        channels = FlacGetChannels() ;                // Get number of channels
+        br       = FlacGetBitrate() ;                 // Get bit rate of first frame
+        bps      = FlacGetBitsPerSample() ;           // Get bits per sample (of the output)
+      }
+    }
+  }
+  else if ( wavmode )
+  {
+    n = WavDecode ( mp3buff, &newcnt, pcm ) ;         // Parse header or copy the next samples
+    if ( n == ERR_WAV_NONE )
+    {
+      if ( ( samprate != (uint32_t)WavGetSampRate() ) ||
+           ( channels != WavGetChannels() ) )         // New track?
+      {
+        once = true ;                                 // Yes, set samplerate again
+      }
+      smpwords = WavGetOutputSamps() ;                // Number of samples differs per call
+      if ( once )
+      {
+        samprate = WavGetSampRate() ;                 // Get sample rate
+        channels = WavGetChannels() ;                 // Get number of channels
+        br       = WavGetBitrate() ;                  // Get bit rate
+        bps      = WavGetBitsPerSample() ;            // Get bits per sample (of the output)
+      }
+    }
+  }
+#ifdef HELIX_OPUS
+  else if ( opusmode )
+  {
+    n = OggOpusDecode ( mp3buff, &newcnt, pcm ) ;     // Decode the next packet or return the rest of it
+    if ( n == ERR_OGGOPUS_NONE )
+    {
+      if ( ( samprate != (uint32_t)OggOpusGetSampRate() ) ||
+           ( channels != OggOpusGetChannels() ) )     // New (chained) stream?
+      {
+        once = true ;                                 // Yes, set samplerate again
+      }
+      smpwords = OggOpusGetOutputSamps() ;            // Number of samples differs per packet
+      if ( once )
+      {
+        samprate = OggOpusGetSampRate() ;             // Get sample rate
+        channels = OggOpusGetChannels() ;             // Get number of channels
+        br       = OggOpusGetBitrate() ;              // Get bit rate of first packet
+        bps      = OggOpusGetBitsPerSample() ;        // Get bits per sample
+      }
+    }
+  }
+#endif
+  else if ( oggmode )
+  {
+    n = VorbisDecode ( mp3buff, &newcnt, pcm ) ;      // Decode the next packet
+    if ( n == ERR_VORBIS_NONE )
+    {
+      if ( ( samprate != (uint32_t)VorbisGetSampRate() ) ||
+           ( channels != VorbisGetChannels() ) )      // New (chained) stream?
+      {
+        once = true ;                                 // Yes, set samplerate again
+      }
+      smpwords = VorbisGetOutputSamps() ;             // Number of samples differs per packet
+      if ( once )
+      {
+        samprate = VorbisGetSampRate() ;              // Get sample rate
+        channels = VorbisGetChannels() ;              // Get number of channels
+        br       = VorbisGetBitrate() ;               // Get nominal bit rate
+        bps      = VorbisGetBitsPerSample() ;         // Get bits per sample
+      }
+    }
+  }
+  else
+  {
+    n = AACDecode ( mp3buff, &newcnt, pcm ) ;         // Decode the frame
+    if ( n == ERR_AAC_NONE )
+    {
+      if ( ( samprate != (uint32_t)AACGetSampRate() ) ||  // LATM may change the AudioSpecificConfig,
+           ( channels != AACGetChannels() ) )         // parametric stereo turns mono into stereo
+      {
+        once = true ;                                 // Yes, set samplerate again
+      }
+      if ( once )
+      {
+        samprate = AACGetSampRate() ;                 // Get sample rate
+        channels = AACGetChannels() ;                 // Get number of channels
+        br       = AACGetBitrate() ;                  // Get bit rate
+        bps      = AACGetBitsPerSample() ;            // Get bits per sample
+        smpwords = AACGetOutputSamps() ;              // Get number of output (16 bit) samples
+      }
+    }
+  }
+  cycles = ESP.getCycleCount() - cycles ;             // Cycles used for this frame
+  #ifdef HELIX_DUALCORE
+    cycles -= wait ;                                  // Not waiting for the output task
+  #endif
+  int hb = mp3bcnt - newcnt ;                         // Number of bytes handled
+  if ( ( mp3mode &&                                   // Bit reservoir not filled yet (after seek)?
+         ( n == ERR_MP3_MAINDATA_UNDERFLOW ) ) ||     // Same code as *_NULL_POINTER of the others
+       ( ( oggmode || flacmode || wavmode ) &&         // Or no complete Ogg packet or FLAC frame yet?
+         ( n == ERR_VORBIS_INDATA_UNDERFLOW ) ) ||
+       ( ! ( mp3mode || oggmode || flacmode || wavmode ) &&
+         ( n == ERR_AAC_INDATA_UNDERFLOW ) &&         // Or LATM frames before the first
+         ( hb > 0 ) ) )                               // StreamMuxConfig skipped?
+  {
+    #ifdef HELIX_DUALCORE
+      if ( ! xfvoice && ! split )
+      {
+        xQueueSend ( pcmfree, &pcm, 0 ) ;             // Buffer not used
+      }
+    #endif
+    mp3bcnt -= hb ;                                   // Frame is in the reservoir now, skip it
+    memmove ( mp3buff, mp3buff + hb, mp3bcnt ) ;
+    mp3bpnt = mp3buff + mp3bcnt ;
+    return ;
+  }
+  if ( ( oggmode || flacmode || wavmode ) &&          // Bad Vorbis/Opus/FLAC/WAV header or packet?
+       ( n < 0 ) && ( n != ERR_VORBIS_NULL_POINTER ) ) // No decoder buffers is fatal, see below
+  {
+    ESP_LOGI ( HTAG, "%sDecode error %d",
+               wavmode ? "Wav" : flacmode ? "Flac" : opusmode ? "OggOpus" : "Vorbis", n ) ;
+    #ifdef HELIX_DUALCORE
+      if ( ! xfvoice && ! split )
+      {
+        xQueueSend ( pcmfree, &pcm, 0 ) ;             // Buffer not used
+      }
+    #endif
+    if ( hb == 0 )                                    // Nothing used, the error would repeat?
+    {
+      hb = mp3bcnt ;                                  // Yes, drop the buffered bytes
+    }
+    mp3bcnt -= hb ;                                   // Skip the packet, the decoder resyncs itself
+    memmove ( mp3buff, mp3buff + hb, mp3bcnt ) ;
+    mp3bpnt = mp3buff + mp3bcnt ;
+    return ;
+  }
+  if ( n < 0 )                                        // Check if decode is okay, a missing buffer
+  {                                                   // (*_NULL_POINTER) also comes here
+    ESP_LOGI ( HTAG, "MP3Decode error %d", n ) ;
+    if ( xfvoice )                                    // Old stream of a crossfade?
+    {
+      xf.eof = true ;                                 // Yes, just stop decoding it
+      mp3bcnt = 0 ;
+      mp3bpnt = mp3buff ;
+      return ;
+    }
+    #ifdef HELIX_DUALCORE
+      if ( ! split )
+      {
+        xQueueSend ( pcmfree, &pcm, 0 ) ;             // Buffer not used
+      }
+    #endif
+    if ( ( xf.state == XF_WAIT ) || ( xf.state == XF_FADE ) )
+    {
+      xf.cuts++ ;                                     // New stream of a crossfade, hard cut:
+      helixXfadeEnd() ;                               // free the old stream first
+    }
+    helixInit ( -1, -1 ) ;                            // Totally wrong, start all over
+    return ;
+  }
+  dec_frames++ ;                                      // Count frames
+  dec_cycles += cycles ;                              // and cycles
+  if ( cycles > dec_maxcycles )                       // New maximum?
+  {
+    dec_maxcycles = cycles ;                          // Yes, remember
+  }
+  if ( xf.state == XF_FADE )                          // Both streams decoded?
+  {
+    xf.cycles += cycles ;                             // Yes, count both for the load check
+  }
+  ch = ( channels == 1 ) ? 1 : 2 ;
+  #ifdef HELIX_DUALCORE
+    blk.start = once ;                                // Output task will (re)start I2S
+    blk.rate = 0 ;                                    // Assume no change of samplerate
+  #endif
+  if ( once && xfvoice )                              // Old stream of a crossfade?
+  {
+    smpbytes = smpwords * 2 ;                         // Yes, output is running already
+    once = false ;
+  }
+  if ( once )
+  {
+    smpbytes = smpwords * 2 ;                         // Number of bytes in outbuf
+    ESP_LOGI ( HTAG, "Bitrate     is %d", br ) ;      // Show decoder parameters
+    ESP_LOGI ( HTAG, "Samprate    is %d", samprate ) ;
+    ESP_LOGI ( HTAG, "Channels    is %d", channels ) ;
+    ESP_LOGI ( HTAG, "Bitpersamp  is %d", bps ) ;
+    ESP_LOGI ( HTAG, "Outputsamps is %d", smpwords ) ;
+    if ( ( xf.state == XF_FADE ) &&                   // Rate changed while mixing?
+         ( samprate != xf.v.samprate ) )
+    {
+      ESP_LOGI ( HTAG, "Crossfade cut, sample rates differ" ) ;
+      xf.cuts++ ;
+      helixXfadeEnd() ;
+    }
+    if ( ( xf.state == XF_WAIT ) && helixXfadeBegin() )  // First frame of new stream, start mixing?
+    {
+      #ifdef HELIX_DUALCORE
+        blk.start = false ;                           // Yes, I2S keeps running at the same rate
+      #endif
+    }
+    else
+    {
+     #ifdef HELIX_DUALCORE
+      if ( samprate )                                 // Output task sets samplerate and starts I2S
+      {
+        blk.rate = samprate ;
+      }
+     #else
+      if ( samprate )                                 // Prevent division by zero
+      {
+        helixSetRate ( samprate ) ;                   // Set samplerate or resampler
+      }
+      helixStartI2S() ;                               // Start I2S output
+     #endif
+    }
+    once = false ;                                    // No need to set samplerate again
+  }
+  if ( ! xfvoice && samprate )                        // Load of the current stream
+  {
+    ld_cycles += cycles ;
+    ld_frames += smpwords / ch ;
+    if ( ld_frames >= samprate )                      // Measured for a second?
+    {
+      uint64_t ld = ld_cycles * 100 /
+                    ( (uint64_t)ld_frames * ESP.getCpuFreqMHz() * 1000000 / samprate ) ;
+      dec_load = ( ld > 255 ) ? 255 : ld ;
+      ld_cycles = 0 ;
+      ld_frames = 0 ;
+    }
+    br_bytes += hb ;                                  // Input bytes per output frame,
+    br_frames += smpwords / ch ;                      // for helixXfadeBytes()
+  }
+  #ifdef HELIX_DUALCORE
+    if ( split )                                      // Granules are with the output task already
+    {
+      mp3bcnt -= hb ;
+      memmove ( mp3buff, mp3buff + hb, mp3bcnt ) ;    // Shift mp3 data to begin of buffer
+      mp3bpnt = mp3buff + mp3bcnt ;
+      return ;
+    }
+  #endif
+  words = smpwords ;                                  // Number of words to output
+  if ( mp3mode && ( gl_skip || ( gl_left >= 0 ) ) )   // Encoder delay or padding to remove?
+  {
+    words = helixTrim ( pcm, smpwords, ch ) ;         // Yes, trim this frame
+  }
+  if ( xfvoice )                                      // Old stream of a crossfade?
+  {
+    helixXfadePush ( pcm, words, ch ) ;               // Yes, keep it for mixing
+  }
+  else
+  {
+    if ( xf.state == XF_FADE )                        // Mix with old stream?
+    {
+      words = helixXfadeMix ( pcm, words, ch ) ;      // Yes, result is stereo
+      ch = 2 ;
+    }
+    helixPost ( pcm, words, ch, samprate ) ;          // Mute or tone control
+    #ifdef HELIX_DUALCORE
+      blk.buf = pcm ;                                 // Hand frame over to output task
+      blk.words = words ;
+      blk.mono = ( ch == 1 ) ;
+      xQueueSend ( pcmfull, &blk, portMAX_DELAY ) ;
+    #else
+      outputBlock ( pcm, words,                       // Send to I2S
+                    ch == 1 ) ;
+    #endif
+    if ( ! mp3mode && ! oggmode && ! flacmode &&      // SBR too heavy?
+         ! wavmode &&
+         helixCheckSBR ( cycles, smpwords, channels, samprate ) )
+    {
+      once = true ;                                   // Yes, get new samplerate from next frame
+    }
+  }
+  mp3bcnt -= hb ;
+  memmove ( mp3buff, mp3buff + hb,                    // Shift mp3 data to begin of buffer
+           mp3bcnt ) ;
+  mp3bpnt = mp3buff +mp3bcnt ;
+}
+
+
+//**************************************************************************************************
+//                                      O G G P R O B E                                            *
+//**************************************************************************************************
+// Find the codec (Vorbis, Opus or FLAC) of an Ogg stream in the first packet of the first        *
+// beginning-of-stream page in mp3buff and get the buffers of that decoder.  Returns false if that *
+// packet is not there yet.                                                                        *
+// Vorbis is assumed if no beginning-of-stream page is found in the first FRAMESIZE bytes.         *
+//**************************************************************************************************
+bool oggProbe()
+{
+  int      i ;                                        // Position of page in mp3buff
+  int      hdr ;                                      // Size of page header and lacing values
+  uint8_t* p ;                                        // Points to page
+  bool     found = false ;                            // Beginning of stream found
+  bool     ok = true ;                                // Decoder buffers allocated
+
+  for ( i = 0 ; ( i + OGG_HDRSIZE ) <= mp3bcnt ; i++ )
+  {
+    p = mp3buff + i ;
+    if ( ( memcmp ( p, "OggS", 4 ) != 0 ) ||          // Beginning-of-stream page?
+         ( ( p[5] & 0x02 ) == 0 ) )
+    {
+      continue ;                                      // No, try next position
+    }
+    hdr = OGG_HDRSIZE + p[26] ;                       // Header and lacing values
+    if ( ( i + hdr + 8 ) > mp3bcnt )                  // Start of first packet in buffer?
+    {
+      return false ;                                  // No, wait for more data
+    }
+    opusmode = ( memcmp ( p + hdr, "OpusHead", 8 ) == 0 ) ;
+    flacmode = ( memcmp ( p + hdr, "\x7F" "FLAC", 5 ) == 0 ) ;
+    found = true ;
+    break ;
+  }
+  if ( ! found && ( mp3bcnt < FRAMESIZE ) )           // Still room to find it?
+  {
+    return false ;                                    // Yes, wait for more data
+  }
+  oggprobe = false ;                                  // Codec is known now
+  #ifdef HELIX_OPUS
+    if ( opusmode )
+    {
+      OggOpusSetHalfRate ( halfrate ) ;               // Decode at 24 kHz for half rate
+      ok = OggOpusDecoder_AllocateBuffers() ;         // Get (and clear) Opus buffers
+    }
+  #else
+    if ( opusmode )
+    {
+      ESP_LOGE ( HTAG, "Opus stream, needs HELIX_OPUS in config.h" ) ;
+      opusmode = false ;                              // Vorbis decoder will skip it
+    }
+  #endif
+  if ( flacmode )
+  {
+    ok = FlacDecoder_AllocateBuffers() ;              // Get (and clear) FLAC state
+    FlacSetOgg ( true ) ;                             // Frames are Ogg packets
+  }
+  else if ( ! opusmode )
+  {
+    ok = VorbisDecoder_AllocateBuffers() ;            // Get (and clear) Vorbis buffers
+  }
+  if ( ! ok )                                         // Decoder will return *_NULL_POINTER
+  {
+    ESP_LOGE ( HTAG, "No RAM for the decoder buffers" ) ;
+  }
+  ESP_LOGI ( HTAG, "Ogg stream, codec is %s",
+             flacmode ? "FLAC" : opusmode ? "Opus" : "Vorbis" ) ;
+  return true ;
+}
+
+
+//**************************************************************************************************
+//                                    P L A Y C H U N K                                            *
+//**************************************************************************************************
+// Play the next 32 bytes.                                                                         *
+//**************************************************************************************************
+void playChunk ( const uint8_t* chunk )
+{
+  int             s ;                                 // Position of syncword
+  bool            more ;                              // Sync not confirmed yet, need more data
+  int             nc = 32 ;                           // Number of bytes in chunk to use
+
+  if ( id3skip )                                      // Still skipping ID3 tag?
+  {
+    if ( id3skip >= 32 )                              // Yes, whole chunk in tag?
+    {
+      id3skip -= 32 ;                                 // Yes, skip complete chunk
+      return ;
+    }
+    chunk += id3skip ;                                // Skip the last part of the tag
+    nc -= id3skip ;
+    id3skip = 0 ;                                     // End of tag reached
+  }
+  if ( mp3bcnt + nc > (int)sizeof(mp3buf0) )         // No room for the chunk?
+  {
+    ESP_LOGE ( HTAG, "Frame buffer full, %d bytes dropped", mp3bcnt ) ;
+    mp3bcnt = 0 ;                                     // Yes, start again with an empty buffer
+    mp3bpnt = mp3buff ;
+    searchFrame = true ;                              // MP3 and AAC search the next frame
+  }
+  memcpy ( mp3bpnt, chunk, nc ) ;                     // Add chunk to frame buffer
+  mp3bcnt += nc ;                                     // Update counter
+  mp3bpnt += nc ;                                     // and pointer
+  if ( oggmode || flacmode || wavmode )               // Ogg, FLAC and WAV do their own framing,
+  {                                                   // no frame sync here
+    int      before ;                                 // Bytes in buffer before decoding a packet
+    uint32_t frames ;                                 // Frames before decoding a packet
+
+    if ( oggprobe && ! oggProbe() )                   // Codec known?
+    {
+      return ;                                        // No, wait for first page
+    }
+    if ( wavmode && ( mp3bcnt < FRAMESIZE ) )         // WAV: collect samples for a longer block
+    {
+      return ;
+    }
+    do
+    {
+      before = mp3bcnt ;
+      frames = dec_frames ;
+      decodeFrame() ;                                 // Decode next packet (if complete)
+    } while ( ( ( mp3bcnt > 0 ) && ( mp3bcnt < before ) ) ||
+              ( dec_frames != frames ) ) ;            // Opus, FLAC and WAV return long blocks in parts
+    return ;
+  }
+  if ( searchFrame && ( mp3bcnt <= 32 ) )             // Start of stream or search?
+  {
+    checkID3() ;                                      // Yes, skip ID3 tag if present
+  }
+  if ( searchFrame && ( mp3bcnt >= FRAMESIZE ) )      // Frame search complete?
+  {
+    if ( mp3mode )
+    {
+      s = MP3FindSyncWord ( mp3buff, mp3bcnt ) ;      // Search for first mp3 frame
+      more = ( s == MP3_SYNC_MOREDATA ) ;
+    }
+    else
+    {
+      s = AACFindSyncWord ( mp3buff, mp3bcnt ) ;      // Search for first aac frame
+      more = ( s == AAC_SYNC_MOREDATA ) ;
+    }
+    if ( more )                                       // Candidate found, but not confirmed yet?
+    {
+      if ( mp3bcnt > SYNCSIZE )                       // Buffer full?
+      {
+        mp3bcnt -= FRAMESIZE ;                        // Yes, no frame starts in the first part,
+        memmove ( mp3buff, mp3buff + FRAMESIZE,       // the next headers of a real one
+                  mp3bcnt ) ;                         // would have been found
+        mp3bpnt = mp3buff + mp3bcnt ;
+      }
+      return ;                                        // Search again with the next chunk
+    }
+    if ( ( searchFrame = ( s < 0 ) ) )                // Sync found?
+    {
+      mp3bcnt = 0 ;                                   // No, reset counter
+      mp3bpnt = mp3buff ;                             // And fillpointer
+      samprate = 0 ;                                  // Still unknown
+      return ;                                        // Return with no effect
+    }
+    else
+    {
+      once = true ;                                   // Get samplerate once
+      ESP_LOGI ( HTAG, "Sync found at 0x%04X", s ) ;
+      if ( s > 0 )
+      {
+        mp3bcnt -= s ;                                // Frame found, update count
+        memcpy ( mp3buff, mp3buff + s, mp3bcnt ) ;    // Shift mp3 data to begin of buffer
+        mp3bpnt = mp3buff + mp3bcnt ;                 // Adjust fill pointer
+      }
+      if ( mp3mode )
+      {
+        helixParseXing() ;                            // Get encoder delay and padding
+      }
+    }
+  }
+  if ( mp3bcnt >= FRAMESIZE )                         // Complete frame in buffer?
+  {
+    decodeFrame() ;                                   // Yes, decode and play it
+  }
+}
+
+
+//**************************************************************************************************
+//                                 H E L I X N E X T T R A C K                                     *
+//**************************************************************************************************
+// The next file on the SD card follows directly in the data queue.  Decode the complete frames    *
+// of the current track that are still in the buffer and start searching for the first frame of   *
+// the next track.  The decoder and I2S keep running, so there is no gap between the tracks.       *
+// The state left in the decoder only affects the samples skipped for the encoder delay.           *
+// A FLAC frame has no length, the last one is complete at the end of the file.  A WAV file starts *
+// with a new header.  If the next track (audio_ct, set by sdfuncs) needs another decoder, playing *
+// starts all over.                                                                                *
+//**************************************************************************************************
+void helixNextTrack()
+{
+  int      len ;                                      // Length of next frame
+  uint32_t frames ;                                   // Frames before decoding a block
+  bool     flac ;                                     // Next track is FLAC
+  bool     wav ;                                      // Next track is WAV
+
+  flac = ( audio_ct.indexOf ( "flac" ) > 0 ) ;        // Type set by sdfuncs
+  wav = ( audio_ct.indexOf ( "wav" ) > 0 ) ;
+
+  while ( mp3mode && ! searchFrame && ( mp3bcnt >= 4 ) )
+  {
+    len = MP3GetFrameLength ( mp3buff ) ;             // Complete frame left?
+    if ( ( len <= 0 ) || ( len > mp3bcnt ) )
+    {
+      break ;                                         // No, rest is padding or ID3v1 tag
+    }
+    decodeFrame() ;                                   // Yes, play it
+  }
+  if ( flacmode )
+  {
+    FlacEndOfStream() ;                               // Last frame is complete now
+  }
+  while ( flacmode || wavmode )
+  {
+    frames = dec_frames ;
+    decodeFrame() ;                                   // Play the rest of the track, in parts
+    if ( dec_frames == frames )
+    {
+      break ;
+    }
+  }
+  if ( ( flac != flacmode ) || ( wav != wavmode ) )   // Other decoder for the next track?
+  {
+    helixInit ( -1, -1 ) ;                            // Yes, no gapless playing
+    return ;
+  }
+  if ( wavmode )
+  {
+    WavDecoder_AllocateBuffers() ;                    // Clear state, parse header of next track
+  }
+  mp3bpnt = mp3buff ;                                 // Reset pointer
+  mp3bcnt = 0 ;                                       // Buffer empty
+  searchFrame = true ;                                // Start searching for frame
+  id3skip = 0 ;                                       // No ID3 tag to skip (yet)
+  gl_skip = 0 ;                                       // No encoder delay known (yet)
+  gl_left = -1 ;                                      // Length unknown
 }
\ No newline at end of file
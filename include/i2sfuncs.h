@@ -0,0 +1,279 @@
+// i2sfuncs.h
+// Output layer for the Helix decoders: I2S to an external DAC or the AC101, SPDIF, or the internal DAC.
+// The legacy I2S driver is used, it has the internal DAC mode.  Its event queue has a TX_DONE event for
+// every DMA buffer sent.
+// The writer never blocks in the driver.  It writes what fits in the DMA buffers and waits for the
+// next "buffer sent" event if there is more, so the decoder is paced by the DMA.
+// The driver of ESP-IDF 4.4 does not report underruns (no TX_Q_OVF event), the writer finds them
+// itself: every TX_DONE takes a buffer of the data written, a buffer sent without enough data left
+// is an underrun.  The counters are only changed by the writer, i2sOutReport() just reads them.
+// The DMA depth is set in msec with HELIX_DMAMS in config.h, in buffers of I2S_DMAFRAMES frames.
+//
+#include <driver/i2s.h>
+
+#ifndef HELIX_DMAMS                                  // May be set in config.h
+  #ifdef DEC_HELIX_SPDIF
+    #define HELIX_DMAMS         35                   // DMA depth in msec, biphase needs 4 times the memory
+  #else
+    #define HELIX_DMAMS         70                   // DMA depth in msec
+  #endif
+#endif
+#define I2S_DMAFRAMES           256                  // Frames per DMA buffer, one event per buffer
+#define I2S_MAXDMABUFS          32                   // Max. number of DMA buffers
+#define I2S_EVQSIZE             64                   // Size of the event queue, the oldest event is lost
+                                                     // if the writer is away for longer
+#ifdef DEC_HELIX_SPDIF
+  #define I2S_FRAMEBYTES        8                    // Bytes per I2S frame, 2 x 32 bits
+#else
+  #define I2S_FRAMEBYTES        4                    // Bytes per I2S frame, 2 x 16 bits
+#endif
+#define I2S_WAITMS              ( HELIX_DMAMS + 100 ) // Max. wait for a DMA event, I2S is stopped if longer
+
+struct i2sout_t                                      // State and statistics of the output
+{
+  int               dmabufs ;                        // Number of DMA buffers
+  uint32_t          rate ;                           // Current I2S sample rate
+  bool              enabled ;                        // Output running
+  int32_t           level ;                          // Bytes written and not yet sent
+  volatile uint32_t sent ;                           // DMA buffers sent
+  volatile uint32_t underruns ;                      // DMA buffers sent without new data
+  volatile uint32_t waits ;                          // Writes that had to wait for DMA
+  volatile uint32_t drops ;                          // Blocks dropped, output stopped or no DMA event
+} ;
+
+static i2sout_t     i2sout ;                         // Output state
+const  char*        ITAG = "i2sfuncs" ;
+static QueueHandle_t i2sevq ;                        // Events of the driver
+
+
+//**************************************************************************************************
+//                                   I 2 S E V E N T S                                             *
+//**************************************************************************************************
+// Handle the events in the queue, only called by the writer.  Waits max. ticks for the first one. *
+// A buffer sent takes I2S_DMAFRAMES frames of the level, if there were less it is an underrun.     *
+// Returns true if a DMA buffer has been sent.                                                     *
+//**************************************************************************************************
+static bool i2sEvents ( TickType_t ticks )
+{
+  i2s_event_t ev ;                                   // Event from the driver
+  bool        sent = false ;                         // Buffer sent seen
+
+  while ( xQueueReceive ( i2sevq, &ev, ticks ) == pdTRUE )
+  {
+    if ( ev.type == I2S_EVENT_TX_DONE )              // DMA buffer sent?
+    {
+      i2sout.sent++ ;                                // Yes, count
+      i2sout.level -= I2S_DMAFRAMES * I2S_FRAMEBYTES ;
+      if ( i2sout.level < 0 )                        // Sent without (enough) new data?
+      {
+        i2sout.underruns++ ;                         // Yes, count
+        i2sout.level = 0 ;
+      }
+      sent = true ;
+    }
+    ticks = 0 ;                                      // Do not wait for the next
+  }
+  return sent ;
+}
+
+
+//**************************************************************************************************
+//                                   I 2 S O U T I N I T                                           *
+//**************************************************************************************************
+// Install the driver and set the pins.  For SPDIF only dout is used, the internal DAC uses the    *
+// fixed pins 25 and 26.  Rate is the initial I2S rate (twice the sample rate for SPDIF).          *
+// Returns false if the driver could not be installed or the pins are not valid.                   *
+//**************************************************************************************************
+bool i2sOutInit ( uint32_t rate, int8_t bck, int8_t lck, int8_t dout )
+{
+  esp_err_t        err ;                             // Result of driver calls
+  i2s_config_t     i2s_config ;                      // I2S configuration
+
+  i2sout.dmabufs = ( rate * HELIX_DMAMS / 1000 +     // Number of DMA buffers for the wanted depth
+                     I2S_DMAFRAMES - 1 ) / I2S_DMAFRAMES ;
+  i2sout.dmabufs = constrain ( i2sout.dmabufs, 2, I2S_MAXDMABUFS ) ;
+  i2sout.rate = rate ;
+  memset ( &i2s_config, 0, sizeof(i2s_config) ) ;                  // Clear config struct
+  i2s_config.mode                   = (i2s_mode_t)(I2S_MODE_MASTER | // I2S mode (5)
+                                          I2S_MODE_TX) ;
+  i2s_config.sample_rate            = rate ;                       // 44100 or HELIX_FIXEDRATE
+  #ifdef DEC_HELIX_SPDIF
+    i2s_config.use_apll               = true ;
+    i2s_config.bits_per_sample        = I2S_BITS_PER_SAMPLE_32BIT ;  // For spdif: biphase and 32 bits
+    #if ESP_ARDUINO_VERSION_MAJOR >= 2                               // New version?
+      i2s_config.communication_format = I2S_COMM_FORMAT_STAND_I2S ;  // Yes, use new definition
+    #else
+      i2s_config.communication_format = (i2s_comm_format_t)(I2S_COMM_FORMAT_I2S | I2S_COMM_FORMAT_I2S_MSB) ;
+    #endif
+  #else
+    i2s_config.bits_per_sample        = I2S_BITS_PER_SAMPLE_16BIT ;  // (16)
+    #if ESP_ARDUINO_VERSION_MAJOR >= 2                               // New version?
+      i2s_config.communication_format = I2S_COMM_FORMAT_STAND_MSB ;  // Yes, use new definition
+    #else
+      i2s_config.communication_format = (i2s_comm_format_t)(I2S_COMM_FORMAT_I2S | I2S_COMM_FORMAT_I2S_MSB) ;
+    #endif
+  #endif
+  //i2s_config.channel_format     = I2S_CHANNEL_FMT_RIGHT_LEFT ;   // = 0
+  i2s_config.intr_alloc_flags     = ESP_INTR_FLAG_LEVEL1 ;         // High interrupt priority
+  i2s_config.dma_buf_count        = i2sout.dmabufs ;
+  i2s_config.dma_buf_len          = I2S_DMAFRAMES ;
+  i2s_config.tx_desc_auto_clear   = true ;                         // clear tx descriptor on underflow
+  #ifdef DEC_HELIX_INT
+    i2s_config.mode = (i2s_mode_t)(I2S_MODE_MASTER |               // Set I2S mode for internal DAC
+                                   I2S_MODE_TX |                   // (4)
+                                   I2S_MODE_DAC_BUILT_IN ) ;       // Enable internal DAC (16)
+    #if ESP_ARDUINO_VERSION_MAJOR < 2
+      i2s_config.communication_format = I2S_COMM_FORMAT_I2S_MSB ;
+    #endif
+  #endif
+  if ( i2s_driver_install ( I2S_NUM_0, &i2s_config,                // Install with event queue
+                            I2S_EVQSIZE, &i2sevq ) != ESP_OK )
+  {
+    ESP_LOGE ( ITAG, "I2S install error!" ) ;
+    return false ;
+  }
+  #ifdef DEC_HELIX_INT                                              // Use internal (8 bit) DAC?
+    ESP_LOGI ( ITAG, "Output to internal DAC" ) ;                   // Show output device
+    err = i2s_set_pin ( I2S_NUM_0, NULL ) ;                         // Yes, default pins for internal DAC
+    i2s_set_dac_mode ( I2S_DAC_CHANNEL_BOTH_EN ) ;
+  #else
+    i2s_pin_config_t pin_config ;
+    #if ESP_ARDUINO_VERSION_MAJOR >= 2
+      pin_config.mck_io_num   = I2S_PIN_NO_CHANGE ;                 // MCK not used
+    #endif
+    pin_config.data_in_num    = I2S_PIN_NO_CHANGE ;
+    #ifdef DEC_HELIX_SPDIF
+      pin_config.bck_io_num   = I2S_PIN_NO_CHANGE ;
+      pin_config.ws_io_num    = I2S_PIN_NO_CHANGE ;
+      pin_config.data_out_num = dout ;
+      ESP_LOGI ( ITAG, "Output to SPDIF, pin %d",                   // Show pin used for output device
+                 pin_config.data_out_num ) ;
+    #else
+      pin_config.bck_io_num   = bck ;                               // This is BCK pin
+      pin_config.ws_io_num    = lck ;                               // This is L(R)CK pin
+      pin_config.data_out_num = dout ;                              // This is DATA output pin
+      ESP_LOGI ( ITAG, "Output to I2S, pins %d, %d and %d",         // Show pins used for output device
+                 pin_config.bck_io_num,                             // This is the BCK (bit clock) pin
+                 pin_config.ws_io_num,                              // This is L(R)CK pin
+                 pin_config.data_out_num ) ;                        // This is DATA output pin
+    #endif
+    err = i2s_set_pin ( I2S_NUM_0, &pin_config ) ;                  // Set I2S pins
+  #endif
+  if ( err != ESP_OK )
+  {
+    ESP_LOGE ( ITAG, "I2S setpin error!" ) ;
+    return false ;
+  }
+  i2s_stop ( I2S_NUM_0 ) ;                                          // Started by i2sOutStart()
+  i2s_zero_dma_buffer ( I2S_NUM_0 ) ;                               // Zero the buffer
+  ESP_LOGI ( ITAG, "%d DMA buffers of %d frames", i2sout.dmabufs, I2S_DMAFRAMES ) ;
+  return true ;
+}
+
+
+//**************************************************************************************************
+//                                  I 2 S O U T S T A R T                                          *
+//**************************************************************************************************
+// Start the output.                                                                               *
+//**************************************************************************************************
+void i2sOutStart()
+{
+  if ( ! i2sout.enabled )                            // Not running yet?
+  {
+    xQueueReset ( i2sevq ) ;                         // No, forget events from before the stop
+    i2sout.level = i2sout.dmabufs *                  // The DMA buffers are sent first
+                   I2S_DMAFRAMES * I2S_FRAMEBYTES ;
+    i2s_start ( I2S_NUM_0 ) ;                        // Start DMA
+    i2sout.enabled = true ;
+  }
+}
+
+
+//**************************************************************************************************
+//                                   I 2 S O U T S T O P                                           *
+//**************************************************************************************************
+// Stop the output.  A writer waiting for DMA gives up after I2S_WAITMS.                           *
+//**************************************************************************************************
+void i2sOutStop()
+{
+  if ( i2sout.enabled )                              // Running?
+  {
+    i2s_stop ( I2S_NUM_0 ) ;                         // Yes, stop DMA
+    i2sout.enabled = false ;
+  }
+}
+
+
+//**************************************************************************************************
+//                                 I 2 S O U T S E T R A T E                                       *
+//**************************************************************************************************
+// Change the I2S sample rate.                                                                    *
+//**************************************************************************************************
+void i2sOutSetRate ( uint32_t rate )
+{
+  if ( rate == i2sout.rate )                         // Change?
+  {
+    return ;                                         // No, nothing to do
+  }
+  i2s_set_sample_rates ( I2S_NUM_0, rate ) ;         // Set samplerate
+  i2sout.rate = rate ;
+}
+
+
+//**************************************************************************************************
+//                                   I 2 S O U T W R I T E                                         *
+//**************************************************************************************************
+// Send a block to the DMA buffers.  The driver is called without waiting.  If not everything      *
+// fits, the next "buffer sent" event is awaited and the rest is tried again.                      *
+// Returns false if the block was (partly) dropped: output stopped or no DMA event in I2S_WAITMS.  *
+//**************************************************************************************************
+bool i2sOutWrite ( const void* buf, size_t len )
+{
+  const uint8_t* p = (const uint8_t*)buf ;           // Next byte to write
+  size_t         bw ;                                // Bytes written by driver
+  bool           waited = false ;                    // Had to wait for DMA
+
+  while ( i2sout.enabled )
+  {
+    i2sEvents ( 0 ) ;                                // Count events of buffers already refilled
+    i2s_write ( I2S_NUM_0, p, len, &bw, 0 ) ;        // Write what fits
+    i2sout.level += bw ;
+    p += bw ;
+    len -= bw ;
+    if ( len == 0 )                                  // All done?
+    {
+      return true ;                                  // Yes
+    }
+    if ( ! waited )                                  // Count waiting writes
+    {
+      i2sout.waits++ ;
+      waited = true ;
+    }
+    if ( ! i2sEvents ( pdMS_TO_TICKS ( I2S_WAITMS ) ) )
+    {
+      break ;                                        // No DMA activity, give up
+    }
+  }
+  i2sout.drops++ ;                                   // Block not (completely) sent
+  return false ;
+}
+
+
+//**************************************************************************************************
+//                                  I 2 S O U T R E P O R T                                        *
+//**************************************************************************************************
+// Show the DMA depth and the statistics since the last report.  The counters belong to the writer, *
+// only the copy of the last report is changed here.                                                *
+//**************************************************************************************************
+void i2sOutReport()
+{
+  static uint32_t last[4] ;                          // Counters at the last report
+  uint32_t        now[4] = { i2sout.sent, i2sout.underruns, i2sout.waits, i2sout.drops } ;
+
+  log_printf ( "I2S: %d DMA buffers (%d msec), %d sent, %d underruns, "
+               "%d writes waited, %d dropped\n",
+               i2sout.dmabufs,
+               i2sout.rate ? (int)( i2sout.dmabufs * I2S_DMAFRAMES * 1000 / i2sout.rate ) : 0,
+               now[0] - last[0], now[1] - last[1], now[2] - last[2], now[3] - last[3] ) ;
+  memcpy ( last, now, sizeof(last) ) ;               // Start new measurement
+}
@@ -8,6 +8,7 @@
  ************************************************************************************/
 
 #include "aac_decoder.h"
+#include "aac_primitives.h"
 
 const uint32_t SQRTHALF             = 0x5a82799a;    /* sqrt(0.5), format = Q31 */
 const uint32_t Q28_2                = 0x20000000;    /* Q28: 2.0 */
@@ -21,6 +22,10 @@ const uint8_t  NUM_TIME_SLOTS       = 16;
 const uint8_t  SAMPLES_PER_SLOT     = 2;             /* RATE in spec */
 const uint8_t  SYNCWORDH            = 0xff;          /* 12-bit syncword */
 const uint8_t  SYNCWORDL            = 0xf0;
+const uint8_t  SYNC_CONFIRM         = 2;             /* number of following ADTS/LOAS headers to check */
+const uint8_t  LOAS_SYNCWORDH       = 0x56;          /* 11-bit LOAS AudioSyncStream syncword */
+const uint8_t  LOAS_SYNCWORDL       = 0xe0;
+const uint8_t  LOAS_HEADER_BYTES    = 64;            /* AudioMuxElement bytes parsed before the payload */
 const uint8_t  NUM_SAMPLE_RATES     = 12;
 const uint8_t  NUM_DEF_CHAN_MAPS    = 8;
 const uint32_t NSAMPS_LONG          = 1024;
@@ -31,6 +36,7 @@ const uint8_t  NWINDOWS_LONG        = 1;
 const uint8_t  NWINDOWS_SHORT       = 8;
 const uint8_t  AAC_MAX_NCHANS       = 2;             /* set to default max number of channels  */
 const uint16_t AAC_MAX_NSAMPS       = 1024;
+const uint16_t AAC_MAX_RAWBLOCK     = 768 * AAC_MAX_NCHANS;  /* max. bytes of a raw data block, 6144 bits per channel */
 const uint8_t  MAX_NCHANS_ELEM      = 2;             /* max number of channels in any single bitstream element */
 const uint8_t  MAX_NUM_PCE_ADIF     = 16;
 const uint8_t  ADIF_COPYID_SIZE     = 9;
@@ -47,6 +53,7 @@ const uint32_t X0_OFF_2             = 0x60000000;    /* Q29:  3.0 */
 const uint32_t Q26_3                = 0x0c000000;    /* Q26:  3.0 */
 const uint8_t  EXT_SBR_DATA         = 0x0d;
 const uint8_t  EXT_SBR_DATA_CRC     = 0x0e;
+const uint8_t  EXTENSION_ID_PS      = 2;             /* SBR extension with parametric stereo data */
 const uint8_t  NUM_SAMPLE_RATES_SBR = 9;             /* downsampled (single-rate) mode unsupported */
 const uint8_t  MAX_NUM_PATCHES      = 5;
 const uint8_t  MAX_QMF_BANDS        = 48;            /* max QMF subbands covered by SBR (4.6.18.3.6) */
@@ -77,64 +84,26 @@ const uint16_t nfftTab[2]           = {64, 512};
 const uint8_t  nfftlog2Tab[2]       = {6, 9};
 const uint8_t  cos4sin4tabOffset[2] = {0, 128};
 
-PSInfoBase_t        *m_PSInfoBase;
-AACDecInfo_t        *m_AACDecInfo;
-AACFrameInfo_t       m_AACFrameInfo;
-ADTSHeader_t         m_fhADTS;
-ADIFHeader_t         m_fhADIF;
-ProgConfigElement_t *m_pce[16];
-PulseInfo_t          m_pulseInfo[2]; // [MAX_NCHANS_ELEM]
-aac_BitStreamInfo_t  m_aac_BitStreamInfo;
-PSInfoSBR_t         *m_PSInfoSBR;
-
-//----------------------------------------------------------------------------------------------------------------------
-inline int MULSHIFT32(int x, int y){
-    int z; z = (int64_t)x * (int64_t)y >> 32;
-    return z;
-}
-inline int CLZ(int x){
-    int numZeros;
-    if(!x) return 32; /* count leading zeros with binary search (function should be 17 ARM instructions total) */
-    numZeros = 1;
-    if (!((unsigned int)x >> 16))    { numZeros += 16; x <<= 16; }
-    if (!((unsigned int)x >> 24))    { numZeros +=  8; x <<=  8; }
-    if (!((unsigned int)x >> 28))    { numZeros +=  4; x <<=  4; }
-    if (!((unsigned int)x >> 30))    { numZeros +=  2; x <<=  2; }
-    numZeros -= ((unsigned int)x >> 31);
-    return numZeros;
-}
-inline int FASTABS(int x){
-    int sign;
-    sign = x >> (sizeof(int) * 8 - 1);
-    x ^= sign; x -= sign; return x;
-}
-inline int64_t MADD64(int64_t sum64, int x, int y){
-    sum64 += (int64_t)x * (int64_t)y;
-    return sum64;
-}
-inline short CLIPTOSHORT(int x){
-    int sign; /* clip to [-32768, 32767] */
-    sign = x >> 31;
-    if (sign != (x >> 15)) x = sign ^ ((1 << 15) - 1);
-    return (short)x;
-}
-inline int CLIP_2N(int y, int n){
-    int sign = y >> 31;
-    if(sign != (y >> n))
-        y = sign ^ ((1 << n) - 1);
-    return y;
-}
-inline int CLIP_2N_SHIFT30(int y, int n){
-    int sign = y >> 31;
-    if(sign != (y >> (30 - n)))
-            y = sign ^ (0x3fffffff);
-    else
-        y = (y << n);
-    return y;
-}
-//----------------------------------------------------------------------------------------------------------------------
-
-const uint32_t cos4sin4tab[128 + 1024] PROGMEM = {
+/* All decoder state lives in an AACDecoder_t.  The decoder always works on the instance m_aac points to,
+ * which is the default instance unless one of the functions with a context argument is running.
+ * m_aac is thread local, so instances can be used by different tasks at the same time (see HELIX_THREAD_LOCAL).
+ */
+AACDecoder_t         m_AACDecoder;
+HELIX_THREAD_LOCAL AACDecoder_t *m_aac = &m_AACDecoder;
+#define m_PSInfoBase           (m_aac->PSInfoBase)
+#define m_AACDecInfo           (m_aac->AACDecInfo)
+#define m_AACFrameInfo         (m_aac->AACFrameInfo)
+#define m_fhADTS               (m_aac->fhADTS)
+#define m_fhADIF               (m_aac->fhADIF)
+#define m_pce                  (m_aac->pce)
+#define m_pulseInfo            (m_aac->pulseInfo)
+#define m_aac_BitStreamInfo    (m_aac->aac_BitStreamInfo)
+#define m_PSInfoSBR            (m_aac->PSInfoSBR)
+#define m_sbrBypass            (m_aac->sbrBypass)
+#define m_prof                 (m_aac->prof)
+
+
+const uint32_t cos4sin4tab[128 + 1024] HELIX_DRAM = {
 /* 128 - format = Q30 * 2^-7 */
 0xbf9bc731, 0xff9b783c, 0xbed5332c, 0xc002c697, 0xbe112251, 0xfe096c8d, 0xbd4f9c30, 0xc00f1c4a,
 0xbc90a83f, 0xfc77ae5e, 0xbbd44dd9, 0xc0254e27, 0xbb1a9443, 0xfae67ba2, 0xba6382a6, 0xc04558c0,
@@ -673,7 +642,7 @@ const uint8_t bitrevtab[17 + 129] PROGMEM = {
 
 const uint8_t uniqueIDTab[8] = {0x5f, 0x4b, 0x43, 0x5f, 0x5f, 0x4a, 0x52, 0x5f};
 
-const uint32_t twidTabOdd[8*6 + 32*6 + 128*6] PROGMEM = {
+const uint32_t twidTabOdd[8*6 + 32*6 + 128*6] HELIX_DRAM = {
     0x40000000, 0x00000000, 0x40000000, 0x00000000, 0x40000000, 0x00000000, 0x539eba45, 0xe7821d59,
     0x4b418bbe, 0xf383a3e2, 0x58c542c5, 0xdc71898d, 0x5a82799a, 0xd2bec333, 0x539eba45, 0xe7821d59,
     0x539eba45, 0xc4df2862, 0x539eba45, 0xc4df2862, 0x58c542c5, 0xdc71898d, 0x3248d382, 0xc13ad060,
@@ -802,7 +771,7 @@ const uint32_t twidTabOdd[8*6 + 32*6 + 128*6] PROGMEM = {
     0xbb771c81, 0x3fd39b5a, 0xc197049e, 0xfe6deaa1, 0x40c7d2bd, 0xc0013bd3, 0xbdb00d71, 0x3ff4e5e0,
 };
 
-const uint32_t twidTabEven[4*6 + 16*6 + 64*6] PROGMEM = {
+const uint32_t twidTabEven[4*6 + 16*6 + 64*6] HELIX_DRAM = {
     0x40000000, 0x00000000, 0x40000000, 0x00000000, 0x40000000, 0x00000000, 0x5a82799a, 0xd2bec333,
     0x539eba45, 0xe7821d59, 0x539eba45, 0xc4df2862, 0x40000000, 0xc0000000, 0x5a82799a, 0xd2bec333,
     0x00000000, 0xd2bec333, 0x00000000, 0xd2bec333, 0x539eba45, 0xc4df2862, 0xac6145bb, 0x187de2a7,
@@ -896,7 +865,7 @@ const HuffInfo_t huffTabSpecInfo[11] PROGMEM = {
     {12, {  0,  0,  0,  2,  6,  7, 16, 59, 55, 95, 43,  6,  0,  0,  0,  0,  0,  0,  0,  0}, 952},
 };
 
-const int huffTabSpec[1241] PROGMEM = {
+const int huffTabSpec[1241] HELIX_DRAM = {
     /* spectrum table 1 [81] (signed) */
     0x0000, 0x0200, 0x0e00, 0x0007, 0x0040, 0x0001, 0x0038, 0x0008, 0x01c0, 0x03c0, 0x0e40, 0x0039, 0x0078, 0x01c8, 0x000f, 0x0240,
     0x003f, 0x0fc0, 0x01f8, 0x0238, 0x0047, 0x0e08, 0x0009, 0x0208, 0x01c1, 0x0048, 0x0041, 0x0e38, 0x0201, 0x0e07, 0x0207, 0x0e01,
@@ -1000,7 +969,7 @@ const int huffTabSpec[1241] PROGMEM = {
  * keeping full table (not using symmetry) to allow sequential access in synth filter inner loop
  * format = Q31
  */
-const uint32_t cTabS[640] PROGMEM = {
+const uint32_t cTabS[640] HELIX_DRAM = {
     0x00000000, 0x0055dba1, 0x01b2e41d, 0x09015651, 0x2e3a7532, 0x6d474e1d, 0xd1c58ace, 0x09015651, 0xfe4d1be3, 0x0055dba1,
     0xffede50e, 0x005b5371, 0x01d78bfc, 0x08d3e41b, 0x2faa221c, 0x6d41d963, 0xd3337b3d, 0x09299ead, 0xfe70b8d1, 0x0050b177,
     0xffed978a, 0x006090c4, 0x01fd3ba0, 0x08a24899, 0x311af3a4, 0x6d32730f, 0xd49fd55f, 0x094d7ec2, 0xfe933dc0, 0x004b6c46,
@@ -1481,7 +1450,7 @@ static const int cos1sin1tab64[34] PROGMEM = {
  * NOTE: cTab[1, 2, ... , 318, 319] = cTab[639, 638, ... 322, 321]
  *   except cTab[384] = -cTab[256], cTab[512] = -cTab[128]
  */
-const uint32_t cTabA[165] PROGMEM = {
+const uint32_t cTabA[165] HELIX_DRAM = {
     0x00000000, 0x0055dba1, 0x01b2e41d, 0x09015651, 0x2e3a7532, 0xffed978a, 0x006090c4, 0x01fd3ba0, 0x08a24899, 0x311af3a4,
     0xfff0065d, 0x006b47fa, 0x024bf7a1, 0x082f552e, 0x33ff670e, 0xffef7b8b, 0x0075fded, 0x029e35b4, 0x07a8127d, 0x36e69691,
     0xffee1650, 0x00807994, 0x02f3e48d, 0x070bbf58, 0x39ce0477, 0xffecc31b, 0x008a7dd7, 0x034d01f0, 0x06593912, 0x3cb41219,
@@ -1538,6 +1507,535 @@ static const int invBandTab[64] PROGMEM = {
     0x023ee090, 0x0234f72c, 0x022b63cc, 0x02222222, 0x02192e2a, 0x02108421, 0x02082082, 0x02000000,
 };
 
+#ifdef AAC_ENABLE_PS
+/* PS Huffman codes, sorted by length: bits 31..27 = length, 26..20 = symbol index, 19..0 = code */
+static const uint32_t psHuff_iiddf1[61] PROGMEM = {
+    0x09e00001, 0x19d00001, 0x19f00002, 0x21c00000, 0x22000001, 0x29b0000c, 0x2a10000d, 0x31a0001c,
+    0x3220001d, 0x3990003c, 0x3a30003d, 0x4180007c, 0x4240007d, 0x4a5000fc, 0x516001fb, 0x517001ff,
+    0x526001fc, 0x595003fb, 0x5a7003fc, 0x5a8003f4, 0x613007ea, 0x614007fb, 0x629007eb, 0x69200fe9,
+    0x6aa00fea, 0x71001fd1, 0x71101fe9, 0x72b01fea, 0x72c01fd6, 0x78f03faf, 0x7ad03fd0, 0x80d07f42,
+    0x80e07fae, 0x82e07faf, 0x82f07f43, 0x8890fe80, 0x88b0fe82, 0x88c0feb8, 0x8b00feb9, 0x8b10fe83,
+    0x8b30fe81, 0x9001feb4, 0x9011feb5, 0x9021fd76, 0x9031fd77, 0x9041fd74, 0x9051fd75, 0x9061fe8a,
+    0x9071fe8b, 0x9081fe88, 0x90a1feb6, 0x9321feb7, 0x9341fe89, 0x9351fe8e, 0x9361fe8f, 0x9371fe8c,
+    0x9381fe8d, 0x9391feb2, 0x93a1feb3, 0x93b1feb0, 0x93c1feb1
+};
+static const uint32_t psHuff_iiddt1[61] PROGMEM = {
+    0x09e00001, 0x11f00000, 0x19d00003, 0x29c0000a, 0x2a00000b, 0x31b00011, 0x32100012, 0x39a00020,
+    0x3a200021, 0x4230004c, 0x4980009a, 0x4990009f, 0x4a40009b, 0x51700139, 0x5250013a, 0x59600278,
+    0x5a600279, 0x5a700270, 0x614004ee, 0x615004f7, 0x628004ef, 0x629004e2, 0x691009c7, 0x692009e9,
+    0x693009ed, 0x6aa009ea, 0x6ab009d8, 0x70f013b7, 0x710013d6, 0x72c013d7, 0x72d013d0, 0x78902718,
+    0x78a02719, 0x78b02764, 0x78c02765, 0x78d0276d, 0x78e027b1, 0x7ae027b2, 0x7af027a2, 0x7b00271a,
+    0x7b10271b, 0x80004ed4, 0x80104ed5, 0x80204ece, 0x80304ecf, 0x80404ecc, 0x80504ed6, 0x80604ed8,
+    0x80704f46, 0x80804f60, 0x83204f66, 0x83304f67, 0x83404f61, 0x83504f47, 0x83604ed9, 0x83704ed7,
+    0x83804ecd, 0x83904ed2, 0x83a04ed3, 0x83b04ed0, 0x83c04ed1
+};
+static const uint32_t psHuff_iiddf0[29] PROGMEM = {
+    0x08e00000, 0x18d00005, 0x18f00004, 0x20c0000d, 0x2100000c, 0x28b0001d, 0x2910001c, 0x30a0003c,
+    0x3120003d, 0x3130003e, 0x3890007e, 0x414000fe, 0x488001fe, 0x507003fe, 0x595007fe, 0x68601ffd,
+    0x69601ffc, 0x71703ffc, 0x71803ffd, 0x78507ffc, 0x79907ffd, 0x8040fffc, 0x8801fffb, 0x8811fffc,
+    0x8821fffd, 0x8831fffa, 0x89a1fffe, 0x91b3fffe, 0x91c3ffff
+};
+static const uint32_t psHuff_iiddt0[29] PROGMEM = {
+    0x08e00000, 0x10d00002, 0x18f00006, 0x20c0000e, 0x2900001e, 0x30b0003e, 0x3910007e, 0x40a000fe,
+    0x492001fe, 0x509003fe, 0x593007fe, 0x60800ffe, 0x69401ffe, 0x71503ffe, 0x78707ffe, 0x8861fffd,
+    0x8961fffc, 0x9807fff9, 0x9817fffa, 0x9827fffb, 0x9977fff8, 0xa03ffff8, 0xa04ffff9, 0xa05ffffa,
+    0xa18ffffb, 0xa19ffffc, 0xa1affffd, 0xa1bffffe, 0xa1cfffff
+};
+static const uint32_t psHuff_iccdf[15] PROGMEM = {
+    0x08700000, 0x10800002, 0x18600006, 0x2090000e, 0x2850001e, 0x30a0003e, 0x3840007e, 0x40b000fe,
+    0x48c001fe, 0x503003fe, 0x58d007fe, 0x60200ffe, 0x68e01ffe, 0x70003fff, 0x70103ffe
+};
+static const uint32_t psHuff_iccdt[15] PROGMEM = {
+    0x08700000, 0x10800002, 0x18600006, 0x2090000e, 0x2850001e, 0x30a0003e, 0x3840007e, 0x40b000fe,
+    0x483001fe, 0x50c003fe, 0x582007fe, 0x60d00ffe, 0x68101ffe, 0x70003ffe, 0x70e03fff
+};
+
+static const uint32_t * const psHuffTab[6] = {
+    psHuff_iiddf1, psHuff_iiddt1, psHuff_iiddf0, psHuff_iiddt0, psHuff_iccdf, psHuff_iccdt
+};
+static const uint8_t psHuffTabSize[6] = {61, 61, 29, 29, 15, 15};
+static const uint8_t psHuffOffset[6]  = {30, 30, 14, 14,  7,  7};
+
+/* number of envelopes [frame class][num_env_idx], number of IID/ICC parameters [mode] */
+static const uint8_t psNumEnvTab[2][4] = {{0, 1, 2, 4}, {1, 2, 3, 4}};
+static const uint8_t psNrParTab[6] = {10, 20, 34, 10, 20, 34};
+
+/* stereo band of each of the 71 hybrid bands (20 band mode) */
+static const uint8_t psKToI[71] PROGMEM = {
+     1,  0,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 14, 15, 15,
+    15, 16, 16, 16, 16, 17, 17, 17, 17, 17, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18,
+    18, 18, 18, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19,
+    19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19
+};
+
+/* all-pass links: delay in slots and offset in apDelay */
+static const uint8_t psApLen[3]    = {3, 4, 5};
+static const uint8_t psApOffset[3] = {0, 3, 7};
+
+/* hybrid analysis filters, format = Q31
+ * psHybrid8[q][n] = g0[n] * exp(-j * 2pi * (q + 0.5) * (n - 6) / 8), 8 complex bands from QMF band 0
+ * psHybrid2[n] = g1[n], 2 real bands from QMF bands 1 and 2, symmetric around n = 6
+ */
+static const uint32_t psHybrid8[8][7][2] PROGMEM = {
+    {{0xff532109, 0x00acdef7}, {0xfee34b5f, 0x02af570f}, {0x00000000, 0x05d1eac2}, {0x038f276e, 0x0897b86d},
+     {0x08f26d36, 0x08f26d36}, {0x0df26407, 0x05c6e77e}, {0x10000000, 0x00000000}},
+    {{0x00acdef7, 0x00acdef7}, {0x02af570f, 0xfee34b5f}, {0x00000000, 0xfa2e153e}, {0xf7684793, 0xfc70d892},
+     {0xf70d92ca, 0x08f26d36}, {0x05c6e77e, 0x0df26407}, {0x10000000, 0x00000000}},
+    {{0x00acdef7, 0xff532109}, {0xfd50a8f1, 0xfee34b5f}, {0x00000000, 0x05d1eac2}, {0x0897b86d, 0xfc70d892},
+     {0xf70d92ca, 0xf70d92ca}, {0xfa391882, 0x0df26407}, {0x10000000, 0x00000000}},
+    {{0xff532109, 0xff532109}, {0x011cb4a1, 0x02af570f}, {0x00000000, 0xfa2e153e}, {0xfc70d892, 0x0897b86d},
+     {0x08f26d36, 0xf70d92ca}, {0xf20d9bf9, 0x05c6e77e}, {0x10000000, 0x00000000}},
+    {{0xff532109, 0x00acdef7}, {0x011cb4a1, 0xfd50a8f1}, {0x00000000, 0x05d1eac2}, {0xfc70d892, 0xf7684793},
+     {0x08f26d36, 0x08f26d36}, {0xf20d9bf9, 0xfa391882}, {0x10000000, 0x00000000}},
+    {{0x00acdef7, 0x00acdef7}, {0xfd50a8f1, 0x011cb4a1}, {0x00000000, 0xfa2e153e}, {0x0897b86d, 0x038f276e},
+     {0xf70d92ca, 0x08f26d36}, {0xfa391882, 0xf20d9bf9}, {0x10000000, 0x00000000}},
+    {{0x00acdef7, 0xff532109}, {0x02af570f, 0x011cb4a1}, {0x00000000, 0x05d1eac2}, {0xf7684793, 0x038f276e},
+     {0xf70d92ca, 0xf70d92ca}, {0x05c6e77e, 0xf20d9bf9}, {0x10000000, 0x00000000}},
+    {{0xff532109, 0xff532109}, {0xfee34b5f, 0xfd50a8f1}, {0x00000000, 0xfa2e153e}, {0x038f276e, 0xf7684793},
+     {0x08f26d36, 0xf70d92ca}, {0x0df26407, 0xfa391882}, {0x10000000, 0x00000000}}
+};
+static const uint32_t psHybrid2[7] PROGMEM = {
+    0x00000000, 0x026e6c90, 0x00000000, 0xf6aa2f25, 0x00000000, 0x2729e766, 0x40000000
+};
+
+/* decorrelation, format = Q30
+ * psPhiFract[k] = exp(-j * pi * 0.39 * fc[k]), psQFract[k][m] = exp(-j * pi * fd[m] * fc[k])
+ *   fd = {0.43, 0.75, 0.347}, fc = center frequency of hybrid band k
+ */
+static const uint32_t psPhiFract[30][2] PROGMEM = {
+    {0x395cdd65, 0x1c61afc3}, {0x3f4039d7, 0x09c3747a}, {0x3f4039d7, 0xf63c8b86}, {0x395cdd65, 0xe39e503d},
+    {0x2e227720, 0xd3a474e7}, {0x1e9c9c2d, 0xc7cbb4c9}, {0x02833b9a, 0xc00ca1a8}, {0xdd48a34b, 0xca3be83f},
+    {0xc4ae61ac, 0xe7f930f8}, {0xc1a724ab, 0x0e738728}, {0xe5a9bfae, 0x3a546e69}, {0x2df5c801, 0x2c89d5d4},
+    {0x397948a7, 0xe3d80961}, {0xf8fa1cf1, 0xc062f197}, {0xc1c4b0f4, 0xf10f3b2d}, {0xdcdccf66, 0x357dde29},
+    {0x266d48f4, 0x332e0890}, {0x3d2bb677, 0xed2e717d}, {0x0303cac6, 0xc0123034}, {0xc4df2862, 0xe7821d59},
+    {0xd4ed5cec, 0x2f561da9}, {0x1df28fe4, 0x388f9db8}, {0x3f5c8c30, 0xf6fb7966}, {0x0cfa7790, 0xc15469d9},
+    {0xc96e57f3, 0xde8f622e}, {0xce0d6d9f, 0x2803f9c6}, {0x14bb101f, 0x3c8ca99b}, {0x3ffdfa8f, 0x01015944},
+    {0x169f54f3, 0xc421af5c}, {0xcf558238, 0xd66f7174}
+};
+static const uint32_t psQFract[30][3][2] PROGMEM = {
+    {{0x37f64d55, 0x1f0d5f63}, {0x2899e64a, 0x317900d6}, {0x3ab9ef75, 0x1970c67e}},
+    {{0x3f16f7f7, 0x0ac17baa}, {0x3d3e82ae, 0x1294062f}, {0x3f681f15, 0x08b1b051}},
+    {{0x3f16f7f7, 0xf53e8456}, {0x3d3e82ae, 0xed6bf9d1}, {0x3f681f15, 0xf74e4faf}},
+    {{0x37f64d55, 0xe0f2a09d}, {0x2899e64a, 0xce86ff2a}, {0x3ab9ef75, 0xe68f3982}},
+    {{0x2a831ca8, 0xd028d2d6}, {0x0645e9af, 0xc04ee4b8}, {0x31b60221, 0xd7b0e223}},
+    {{0x1842651a, 0xc4c6a71a}, {0xe1d4a2c8, 0xc78e9a1d}, {0x2506b398, 0xcbcc415a}},
+    {{0xf87a446c, 0xc0719100}, {0xc13ad060, 0xf383a3e2}, {0x0d3971bd, 0xc161959e}},
+    {{0xd2642169, 0xd31a1bef}, {0xdc71898d, 0x3536cc52}, {0xead780b7, 0xc3993ce2}},
+    {{0xc0555357, 0xf97a11d9}, {0x238e7673, 0x3536cc52}, {0xce9756cc, 0xd7523818}},
+    {{0xca3be83f, 0x22b75cb5}, {0x3ec52fa0, 0xf383a3e2}, {0xc0a8efcf, 0xf6d5430c}},
+    {{0x01015944, 0x3ffdfa8f}, {0xe7821d59, 0xc4df2862}, {0xcdfd5a50, 0x27efe0c1}},
+    {{0x3eab9627, 0x0cfa7790}, {0xe7821d59, 0x3b20d79e}, {0x0c49dc7f, 0x3ecf25fc}},
+    {{0x1a564052, 0xc5ab9197}, {0x3b20d79e, 0xe7821d59}, {0x3d5fbca2, 0x122514d7}},
+    {{0xccd1f770, 0xd992b70c}, {0xc4df2862, 0xe7821d59}, {0x2c7756ed, 0xd1f852c4}},
+    {{0xcf558238, 0x29908e8c}, {0x187de2a7, 0x3b20d79e}, {0xebbed764, 0xc34a2269}},
+    {{0x1df28fe4, 0x388f9db8}, {0x187de2a7, 0xc4df2862}, {0xc0cdc29b, 0xf5e38fd4}},
+    {{0x3dbb4f0a, 0xef1cb436}, {0xc4df2862, 0x187de2a7}, {0xd9d090df, 0x335c3eb2}},
+    {{0xfcfc353a, 0xc0123034}, {0x3b20d79e, 0x187de2a7}, {0x1be28c83, 0x399b1648}},
+    {{0xc0f3f803, 0xf4ff1d16}, {0xe7821d59, 0xc4df2862}, {0x3ff8b424, 0x01e8e8f7}},
+    {{0xe7821d59, 0x3b20d79e}, {0xe7821d59, 0x3b20d79e}, {0x1f459207, 0xc8290682}},
+    {{0x345c90a2, 0x24cce2d4}, {0x3b20d79e, 0xe7821d59}, {0xdcf254de, 0xca7404fd}},
+    {{0x2f561da9, 0xd4ed5cec}, {0xc4df2862, 0xe7821d59}, {0xc05028e5, 0x0652b7e5}},
+    {{0xe04a67ba, 0xc868575d}, {0x187de2a7, 0x3b20d79e}, {0xe828edb8, 0x3b64dde8}},
+    {{0xc2d44989, 0x12d18e83}, {0x187de2a7, 0xc4df2862}, {0x29a41d0a, 0x3099c307}},
+    {{0x0505794d, 0x3fcd7e5c}, {0xc4df2862, 0x187de2a7}, {0x3e58db55, 0xf18c78d8}},
+    {{0x3f5c8c30, 0x0904869a}, {0x3b20d79e, 0x187de2a7}, {0x1003751c, 0xc2092741}},
+    {{0x169f54f3, 0xc421af5c}, {0xe7821d59, 0xc4df2862}, {0xd0760e9d, 0xd5269729}},
+    {{0xca8221d7, 0xdcdccf66}, {0xe7821d59, 0x3b20d79e}, {0xc4069074, 0x16570b54}},
+    {{0xd20a37ff, 0x2c89d5d4}, {0x3b20d79e, 0xe7821d59}, {0xf8141369, 0x3f820345}},
+    {{0x21709dd2, 0x3691a80d}, {0xc4df2862, 0xe7821d59}, {0x34a6246a, 0x2463513f}}
+};
+
+/* all-pass coefficient a[m] * decay slope of hybrid band k, format = Q31 */
+static const uint32_t psAllpassGain[30][3] PROGMEM = {
+    {0x53625ae4, 0x4848aef5, 0x3ea94d15}, {0x53625ae4, 0x4848aef5, 0x3ea94d15}, {0x53625ae4, 0x4848aef5, 0x3ea94d15},
+    {0x53625ae4, 0x4848aef5, 0x3ea94d15}, {0x53625ae4, 0x4848aef5, 0x3ea94d15}, {0x53625ae4, 0x4848aef5, 0x3ea94d15},
+    {0x53625ae4, 0x4848aef5, 0x3ea94d15}, {0x53625ae4, 0x4848aef5, 0x3ea94d15}, {0x53625ae4, 0x4848aef5, 0x3ea94d15},
+    {0x53625ae4, 0x4848aef5, 0x3ea94d15}, {0x53625ae4, 0x4848aef5, 0x3ea94d15}, {0x4f37098c, 0x44ab7302, 0x3b873c6d},
+    {0x4b0bb833, 0x410e370f, 0x38652bc6}, {0x46e066db, 0x3d70fb1d, 0x35431b1f}, {0x42b51583, 0x39d3bf2a, 0x32210a77},
+    {0x3e89c42b, 0x36368338, 0x2efef9d0}, {0x3a5e72d3, 0x32994745, 0x2bdce928}, {0x3633217a, 0x2efc0b52, 0x28bad881},
+    {0x3207d022, 0x2b5ecf60, 0x2598c7d9}, {0x2ddc7eca, 0x27c1936d, 0x2276b732}, {0x29b12d72, 0x2424577a, 0x1f54a68a},
+    {0x2585dc1a, 0x20871b88, 0x1c3295e3}, {0x215a8ac1, 0x1ce9df95, 0x1910853c}, {0x1d2f3969, 0x194ca3a2, 0x15ee7494},
+    {0x1903e811, 0x15af67b0, 0x12cc63ed}, {0x14d896b9, 0x12122bbd, 0x0faa5345}, {0x10ad4561, 0x0e74efcb, 0x0c88429e},
+    {0x0c81f409, 0x0ad7b3d8, 0x096631f6}, {0x0856a2b0, 0x073a77e5, 0x0644214f}, {0x042b5158, 0x039d3bf3, 0x032210a7}
+};
+
+/* mixing matrix h11, h12, h21, h22 [iid + 7 (coarse) or iid + 30 (fine)][icc], format = Q29
+ * psMixA for iccMode 0..2 (rotation with alpha = acos(icc) / 2), psMixB for iccMode 3..5 (table 8.31)
+ */
+static const uint32_t psMixA[46][8][4] PROGMEM = {
+    {{0x028a7548, 0x2d2ef685, 0x00000000, 0x00000000}, {0x0263c983, 0x2d2e5977, 0x00dcef58, 0xff88deb4},
+     {0x0228e0b3, 0x2d2d63f4, 0x0156ab3f, 0xff414660}, {0x0194a11b, 0x2d2ad4bd, 0x01fd48e1, 0xfecada8b},
+     {0x0103d6dc, 0x2d281783, 0x02544e02, 0xfe715dca}, {0x001d7a8b, 0x2d231406, 0x0289ca30, 0xfdf3c964},
+     {0xfea30428, 0x2d17a410, 0x0224e9e0, 0xfd21d79b}, {0xfd7836bc, 0x2cff72ca, 0x003ae594, 0xfbe8a68e}},
+    {{0x05a712a2, 0x2ce681fc, 0x00000000, 0x00000000}, {0x05577f8f, 0x2ce348b7, 0x01d940b3, 0xfeefc9b0},
+     {0x04de09e2, 0x2cde3ebd, 0x02dfcdcf, 0xfe4c3eb0}, {0x03aafc18, 0x2cd0ccd4, 0x044d0eaf, 0xfd3de86b},
+     {0x027ce413, 0x2cc26a72, 0x05136167, 0xfc71d39e}, {0x00969666, 0x2ca8199e, 0x059f3754, 0xfb53d74b},
+     {0xfd5ef0bf, 0x2c6c20d8, 0x050104f1, 0xf9772800}, {0xfa7844bf, 0x2bed8e01, 0x012b8a31, 0xf6b4abb3}},
+    {{0x08dae04d, 0x2c614b41, 0x00000000, 0x00000000}, {0x0868defb, 0x2c58ef67, 0x02c5d73e, 0xfe4c4447},
+     {0x07ba7f0d, 0x2c4bdf42, 0x045278cb, 0xfd46a5a4}, {0x05ff907e, 0x2c29084e, 0x0683905e, 0xfb96bbe0},
+     {0x0448740f, 0x2c03c87c, 0x07c010e1, 0xfa515499}, {0x017cf7f6, 0x2bbfb3ae, 0x08baa262, 0xf88aa252},
+     {0xfc9b56ff, 0x2b24dda4, 0x082dd67f, 0xf5994e49}, {0xf7a52c93, 0x29df85b5, 0x02ef19a2, 0xf14b9503}},
+    {{0x0da5149e, 0x2b26172e, 0x00000000, 0x00000000}, {0x0d0e6fda, 0x2b10cc17, 0x03f6c133, 0xfd52763d},
+     {0x0c274b84, 0x2aef8980, 0x0633e8b9, 0xfbb789cb}, {0x09d7e97e, 0x2a96eeaf, 0x097304f6, 0xf913613e},
+     {0x0786df63, 0x2a385cbf, 0x0b618ccd, 0xf718a743}, {0x03af0294, 0x298bf340, 0x0d2361fd, 0xf459f0ba},
+     {0xfcaa6e30, 0x2805efce, 0x0d3b2fad, 0xefe06c24}, {0xf4581446, 0x24dbfc70, 0x0717fe0c, 0xe99153f1}},
+    {{0x1274fb23, 0x2951ea33, 0x00000000, 0x00000000}, {0x11cb98a5, 0x2928b7e3, 0x04e5ca1c, 0xfc5b57b7},
+     {0x10c6de7b, 0x28e86c6f, 0x07b1a7f6, 0xfa2dd2ba}, {0x0e26ebe5, 0x283d772f, 0x0bd9219d, 0xf69d7b8d},
+     {0x0b7d560d, 0x27878456, 0x0e71d5e2, 0xf3f7cbaa}, {0x06fe4eb0, 0x263d3075, 0x1114ab95, 0xf0580045},
+     {0xfe6d0035, 0x23589c58, 0x1263c374, 0xea996977}, {0xf2d7b91b, 0x1d74a1fd, 0x0cf1a1c0, 0xe305b3ce}},
+    {{0x182614ce, 0x2645f043, 0x00000000, 0x00000000}, {0x177d6e9d, 0x25fc3aa7, 0x059a245b, 0xfb506e2d},
+     {0x1678ddb9, 0x25895ef4, 0x08d7545b, 0xf886fe99}, {0x13d39c54, 0x245907b5, 0x0dc95960, 0xf4037296},
+     {0x111b7e35, 0x2316d504, 0x110b466f, 0xf0b76a11}, {0x0c6bda60, 0x20d26cd0, 0x14b59261, 0xec5045c8},
+     {0x030f7446, 0x1bd2d75c, 0x17f43ca0, 0xe5b817d3}, {0xf4a122cc, 0x1205689d, 0x154de5ca, 0xde3c27a1}},
+    {{0x1c25d2e6, 0x236f9840, 0x00000000, 0x00000000}, {0x1b8bc073, 0x230a25ab, 0x05ca1ffa, 0xfab71e0f},
+     {0x1a9d190b, 0x226c506a, 0x092a6683, 0xf796a457}, {0x182d30dc, 0x20cb9415, 0x0e6a3b71, 0xf293b598},
+     {0x15a62303, 0x1f14c1af, 0x11fd480c, 0xeefaf40d}, {0x113bd0c6, 0x1c048972, 0x1641593c, 0xea4dda73},
+     {0x0823334e, 0x15614e1a, 0x1af220d4, 0xe3bd95b9}, {0xf8f48160, 0x08de7718, 0x1b407b73, 0xddb12116}},
+    {{0x20000000, 0x20000000, 0x00000000, 0x00000000}, {0x1f7df191, 0x1f7df191, 0x05adef8d, 0xfa521073},
+     {0x1eb4026e, 0x1eb4026e, 0x09047cd2, 0xf6fb832e}, {0x1ca140f9, 0x1ca140f9, 0x0e4b5bb5, 0xf1b4a44b},
+     {0x1a763e7f, 0x1a763e7f, 0x11fe5a29, 0xee01a5d7}, {0x16a09e66, 0x16a09e66, 0x16a09e66, 0xe95f619a},
+     {0x0e819b4a, 0x0e819b4a, 0x1c85eab8, 0xe37a1548}, {0x00000000, 0x00000000, 0x20000000, 0xe0000000}},
+    {{0x236f9840, 0x1c25d2e6, 0x00000000, 0x00000000}, {0x230a25ab, 0x1b8bc073, 0x0548e1f1, 0xfa35e006},
+     {0x226c506a, 0x1a9d190b, 0x08695ba9, 0xf6d5997d}, {0x20cb9415, 0x182d30dc, 0x0d6c4a68, 0xf195c48f},
+     {0x1f14c1af, 0x15a62303, 0x11050bf3, 0xee02b7f4}, {0x1c048972, 0x113bd0c6, 0x15b2258d, 0xe9bea6c4},
+     {0x15614e1a, 0x0823334e, 0x1c426a47, 0xe50ddf2c}, {0x08de7718, 0xf8f48160, 0x224edeea, 0xe4bf848d}},
+    {{0x2645f043, 0x182614ce, 0x00000000, 0x00000000}, {0x25fc3aa7, 0x177d6e9d, 0x04af91d3, 0xfa65dba5},
+     {0x25895ef4, 0x1678ddb9, 0x07790167, 0xf728aba5}, {0x245907b5, 0x13d39c54, 0x0bfc8d6a, 0xf236a6a0},
+     {0x2316d504, 0x111b7e35, 0x0f4895ef, 0xeef4b991}, {0x20d26cd0, 0x0c6bda60, 0x13afba38, 0xeb4a6d9f},
+     {0x1bd2d75c, 0x030f7446, 0x1a47e82d, 0xe80bc360}, {0x1205689d, 0xf4a122cc, 0x21c3d85f, 0xeab21a36}},
+    {{0x2951ea33, 0x1274fb23, 0x00000000, 0x00000000}, {0x2928b7e3, 0x11cb98a5, 0x03a4a849, 0xfb1a35e4},
+     {0x28e86c6f, 0x10c6de7b, 0x05d22d46, 0xf84e580a}, {0x283d772f, 0x0e26ebe5, 0x09628473, 0xf426de63},
+     {0x27878456, 0x0b7d560d, 0x0c083456, 0xf18e2a1e}, {0x263d3075, 0x06fe4eb0, 0x0fa7ffbb, 0xeeeb546b},
+     {0x23589c58, 0xfe6d0035, 0x15669689, 0xed9c3c8c}, {0x1d74a1fd, 0xf2d7b91b, 0x1cfa4c32, 0xf30e5e40}},
+    {{0x2b26172e, 0x0da5149e, 0x00000000, 0x00000000}, {0x2b10cc17, 0x0d0e6fda, 0x02ad89c3, 0xfc093ecd},
+     {0x2aef8980, 0x0c274b84, 0x04487635, 0xf9cc1747}, {0x2a96eeaf, 0x09d7e97e, 0x06ec9ec2, 0xf68cfb0a},
+     {0x2a385cbf, 0x0786df63, 0x08e758bd, 0xf49e7333}, {0x298bf340, 0x03af0294, 0x0ba60f46, 0xf2dc9e03},
+     {0x2805efce, 0xfcaa6e30, 0x101f93dc, 0xf2c4d053}, {0x24dbfc70, 0xf4581446, 0x166eac0f, 0xf8e801f4}},
+    {{0x2c614b41, 0x08dae04d, 0x00000000, 0x00000000}, {0x2c58ef67, 0x0868defb, 0x01b3bbb9, 0xfd3a28c2},
+     {0x2c4bdf42, 0x07ba7f0d, 0x02b95a5c, 0xfbad8735}, {0x2c29084e, 0x05ff907e, 0x04694420, 0xf97c6fa2},
+     {0x2c03c87c, 0x0448740f, 0x05aeab67, 0xf83fef1f}, {0x2bbfb3ae, 0x017cf7f6, 0x07755dae, 0xf7455d9e},
+     {0x2b24dda4, 0xfc9b56ff, 0x0a66b1b7, 0xf7d22981}, {0x29df85b5, 0xf7a52c93, 0x0eb46afd, 0xfd10e65e}},
+    {{0x2ce681fc, 0x05a712a2, 0x00000000, 0x00000000}, {0x2ce348b7, 0x05577f8f, 0x01103650, 0xfe26bf4d},
+     {0x2cde3ebd, 0x04de09e2, 0x01b3c150, 0xfd203231}, {0x2cd0ccd4, 0x03aafc18, 0x02c21795, 0xfbb2f151},
+     {0x2cc26a72, 0x027ce413, 0x038e2c62, 0xfaec9e99}, {0x2ca8199e, 0x00969666, 0x04ac28b5, 0xfa60c8ac},
+     {0x2c6c20d8, 0xfd5ef0bf, 0x0688d800, 0xfafefb0f}, {0x2bed8e01, 0xfa7844bf, 0x094b544d, 0xfed475cf}},
+    {{0x2d2ef685, 0x028a7548, 0x00000000, 0x00000000}, {0x2d2e5977, 0x0263c983, 0x0077214c, 0xff2310a8},
+     {0x2d2d63f4, 0x0228e0b3, 0x00beb9a0, 0xfea954c1}, {0x2d2ad4bd, 0x0194a11b, 0x01352575, 0xfe02b71f},
+     {0x2d281783, 0x0103d6dc, 0x018ea236, 0xfdabb1fe}, {0x2d231406, 0x001d7a8b, 0x020c369c, 0xfd7635d0},
+     {0x2d17a410, 0xfea30428, 0x02de2865, 0xfddb1620}, {0x2cff72ca, 0xfd7836bc, 0x04175972, 0xffc51a6c}},
+    {{0x0024a2b4, 0x2d412df9, 0x00000000, 0x00000000}, {0x002255b2, 0x2d412d80, 0x000cc74a, 0xfff973f1},
+     {0x001ed5c3, 0x2d412cc2, 0x0013c871, 0xfff58497}, {0x00160ed7, 0x2d412ac8, 0x001d4035, 0xffef0224},
+     {0x000d887a, 0x2d4128ab, 0x00220b5c, 0xffea1690}, {0x00001754, 0x2d4124cc, 0x0024a2ac, 0xffe32e62},
+     {0xffea8664, 0x2d411bf6, 0x001dae72, 0xffd7a04a}, {0xffdb5d6a, 0x2d410944, 0x00002ea9, 0xffc65cd0}},
+    {{0x004125c6, 0x2d410de8, 0x00000000, 0x00000000}, {0x003d10ed, 0x2d410c68, 0x0016b24f, 0xfff457e8},
+     {0x0036db85, 0x2d410a0f, 0x002323fb, 0xffed5663}, {0x002748c9, 0x2d4103cc, 0x0033f87b, 0xffe1bf67},
+     {0x0018279c, 0x2d40fd18, 0x003c8110, 0xffd8fcd3}, {0x000049dd, 0x2d40f0d2, 0x0041259c, 0xffccb0bb},
+     {0xffd9f49c, 0x2d40d4d1, 0x0034e28d, 0xffb81e1e}, {0xffbedae2, 0x2d40998f, 0x000093bb, 0xff9961b7}},
+    {{0x0073d8ba, 0x2d40a885, 0x00000000, 0x00000000}, {0x006c9ee2, 0x2d40a3c1, 0x0028461f, 0xffeb3a3b},
+     {0x0061a095, 0x2d409c4d, 0x003e5d59, 0xffdebe1f}, {0x00460b71, 0x2d408868, 0x005c45b4, 0xffca16de},
+     {0x002b3c50, 0x2d40731e, 0x006b79e2, 0xffba7a8c}, {0x0000ea13, 0x2d404c25, 0x0073d7cd, 0xffa4909e},
+     {0xffbcce44, 0x2d3ff338, 0x005e5e43, 0xff7fe79b}, {0xff8c2af8, 0x2d3f3706, 0x0001d422, 0xff4922b1}},
+    {{0x00cdfc3e, 0x2d3f67f9, 0x00000000, 0x00000000}, {0x00c13cd1, 0x2d3f58c9, 0x004756af, 0xffdaecfa},
+     {0x00add6d9, 0x2d3f410b, 0x006e7f90, 0xffc4a4a9}, {0x007d24e2, 0x2d3f01ac, 0x00a39cb2, 0xff9fc83c},
+     {0x004dc6ab, 0x2d3ebdd8, 0x00bebcd5, 0xff83ebe9}, {0x0002e6e5, 0x2d3e41b0, 0x00cdf703, 0xff5ccff7},
+     {0xff89fbcf, 0x2d3d2665, 0x00a8d35c, 0xff1b6376}, {0xff3218b0, 0x2d3acee3, 0x0005cda4, 0xfeb9a839}},
+    {{0x016e2ca1, 0x2d3b7300, 0x00000000, 0x00000000}, {0x0157d51f, 0x2d3b425c, 0x007df2a3, 0xffbdaa45},
+     {0x0135d259, 0x2d3af652, 0x00c32d64, 0xff95cc09}, {0x00e05e5b, 0x2d3a2b61, 0x012161fd, 0xff53d8c8},
+     {0x008d1fc8, 0x2d39522c, 0x0151e312, 0xff220091}, {0x00093b8f, 0x2d37c496, 0x016e0ed4, 0xfedc09c4},
+     {0xff32e8e0, 0x2d34396f, 0x012f59c2, 0xfe670413}, {0xfe924a8f, 0x2d2cb9ee, 0x0012759c, 0xfdb8430f}},
+    {{0x028a7548, 0x2d2ef685, 0x00000000, 0x00000000}, {0x0263c983, 0x2d2e5977, 0x00dcef58, 0xff88deb4},
+     {0x0228e0b3, 0x2d2d63f4, 0x0156ab3f, 0xff414660}, {0x0194a11b, 0x2d2ad4bd, 0x01fd48e1, 0xfecada8b},
+     {0x0103d6dc, 0x2d281783, 0x02544e02, 0xfe715dca}, {0x001d7a8b, 0x2d231406, 0x0289ca30, 0xfdf3c964},
+     {0xfea30428, 0x2d17a410, 0x0224e9e0, 0xfd21d79b}, {0xfd7836bc, 0x2cff72ca, 0x003ae594, 0xfbe8a68e}},
+    {{0x03955bce, 0x2d1cdc50, 0x00000000, 0x00000000}, {0x03602de5, 0x2d1b9d5f, 0x0133ccdc, 0xff565e1f},
+     {0x030f1d84, 0x2d19aacc, 0x01ddc89f, 0xfef06df0}, {0x0242ce00, 0x2d147849, 0x02c7b5e9, 0xfe47d846},
+     {0x017ac5db, 0x2d0ee876, 0x034382b5, 0xfdc87b34}, {0x003b45a0, 0x2d04baa9, 0x03937118, 0xfd15cf5f},
+     {0xfe28f388, 0x2ced83a1, 0x03132f50, 0xfbeb525a}, {0xfc724cfb, 0x2cbc6f84, 0x00764bd7, 0xfa2ebd0b}},
+    {{0x050bc779, 0x2cf8fe81, 0x00000000, 0x00000000}, {0x04c39bf4, 0x2cf6742a, 0x01a9bb24, 0xff0e27f9},
+     {0x04557e8d, 0x2cf27b99, 0x029599d7, 0xfe7cd89d}, {0x033f5e94, 0x2ce7e309, 0x03dcb1fc, 0xfd8c9bcd},
+     {0x022e2134, 0x2cdc8cb5, 0x048cfb93, 0xfcd733bc}, {0x0077483f, 0x2cc7ce4d, 0x0506429b, 0xfbd8e570},
+     {0xfd946105, 0x2c988502, 0x046d7957, 0xfa30ae84}, {0xfb0a3fee, 0x2c34a94a, 0x00ed8b90, 0xf7bae063}},
+    {{0x0715804a, 0x2cb26b24, 0x00000000, 0x00000000}, {0x06b59060, 0x2cad39a4, 0x024607fd, 0xfea74b30},
+     {0x0622fe68, 0x2ca51ba7, 0x0389f5f5, 0xfdd83f28}, {0x04afac18, 0x2c8f7417, 0x054ffd71, 0xfc822962},
+     {0x03411aef, 0x2c784ab4, 0x064ad068, 0xfb801d29}, {0x00efcf92, 0x2c4def01, 0x07059349, 0xfa16e560},
+     {0xfcf4f854, 0x2bed7a25, 0x0665a67d, 0xf7be3110}, {0xf929ec1c, 0x2b223e65, 0x01db68e3, 0xf4485e16}},
+    {{0x09e2f672, 0x2c29651e, 0x00000000, 0x00000000}, {0x09678d7f, 0x2c1ecda8, 0x030cae33, 0xfe16bdee},
+     {0x08aaaa63, 0x2c0e4090, 0x04c1e7f3, 0xfcf11143}, {0x06ca2072, 0x2be21e42, 0x072fc085, 0xfb0c8133},
+     {0x04ec8e87, 0x2bb2f207, 0x0892b6bd, 0xf99fc27e}, {0x01df5e7b, 0x2b5cc371, 0x09b526c1, 0xf7a2bcb0},
+     {0xfc7da032, 0x2a98f032, 0x093e2806, 0xf459ac26}, {0xf6d29fc6, 0x28fe46ce, 0x03ad6277, 0xef92fd43}},
+    {{0x0da5149e, 0x2b26172e, 0x00000000, 0x00000000}, {0x0d0e6fda, 0x2b10cc17, 0x03f6c133, 0xfd52763d},
+     {0x0c274b84, 0x2aef8980, 0x0633e8b9, 0xfbb789cb}, {0x09d7e97e, 0x2a96eeaf, 0x097304f6, 0xf913613e},
+     {0x0786df63, 0x2a385cbf, 0x0b618ccd, 0xf718a743}, {0x03af0294, 0x298bf340, 0x0d2361fd, 0xf459f0ba},
+     {0xfcaa6e30, 0x2805efce, 0x0d3b2fad, 0xefe06c24}, {0xf4581446, 0x24dbfc70, 0x0717fe0c, 0xe99153f1}},
+    {{0x10bd1474, 0x2a0ba252, 0x00000000, 0x00000000}, {0x10185146, 0x29ea5c54, 0x0498d0a6, 0xfcb2515a},
+     {0x0f1afe59, 0x29b669de, 0x07362675, 0xfab838f9}, {0x0c8fd108, 0x292c2e59, 0x0b10097c, 0xf77a2a60},
+     {0x09fdfb47, 0x2898e3ea, 0x0d6dd32e, 0xf50f592e}, {0x05ae070f, 0x278d068a, 0x0fbed864, 0xf1bba5db},
+     {0xfd95a158, 0x25324798, 0x10903a38, 0xec65d50a}, {0xf31db0e9, 0x205cfa3d, 0x0aaf8509, 0xe528af6e}},
+    {{0x1446e919, 0x28753a6b, 0x00000000, 0x00000000}, {0x139b1bd2, 0x2842a858, 0x052c6caf, 0xfc01c142},
+     {0x129257ce, 0x27f3c42d, 0x0823b150, 0xf99f869c}, {0x0fe61e60, 0x2722320c, 0x0c95c087, 0xf5bbb478},
+     {0x0d2d1afe, 0x264378c5, 0x0f699810, 0xf2db581b}, {0x088c3f41, 0x24aff878, 0x126322c1, 0xeef1df81},
+     {0xff973c7d, 0x212b6eeb, 0x1445da6f, 0xe8d5c2c5}, {0xf2ee0431, 0x1a141d74, 0x0f809ec1, 0xe1118fd2}},
+    {{0x182614ce, 0x2645f043, 0x00000000, 0x00000000}, {0x177d6e9d, 0x25fc3aa7, 0x059a245b, 0xfb506e2d},
+     {0x1678ddb9, 0x25895ef4, 0x08d7545b, 0xf886fe99}, {0x13d39c54, 0x245907b5, 0x0dc95960, 0xf4037296},
+     {0x111b7e35, 0x2316d504, 0x110b466f, 0xf0b76a11}, {0x0c6bda60, 0x20d26cd0, 0x14b59261, 0xec5045c8},
+     {0x030f7446, 0x1bd2d75c, 0x17f43ca0, 0xe5b817d3}, {0xf4a122cc, 0x1205689d, 0x154de5ca, 0xde3c27a1}},
+    {{0x1c25d2e6, 0x236f9840, 0x00000000, 0x00000000}, {0x1b8bc073, 0x230a25ab, 0x05ca1ffa, 0xfab71e0f},
+     {0x1a9d190b, 0x226c506a, 0x092a6683, 0xf796a457}, {0x182d30dc, 0x20cb9415, 0x0e6a3b71, 0xf293b598},
+     {0x15a62303, 0x1f14c1af, 0x11fd480c, 0xeefaf40d}, {0x113bd0c6, 0x1c048972, 0x1641593c, 0xea4dda73},
+     {0x0823334e, 0x15614e1a, 0x1af220d4, 0xe3bd95b9}, {0xf8f48160, 0x08de7718, 0x1b407b73, 0xddb12116}},
+    {{0x20000000, 0x20000000, 0x00000000, 0x00000000}, {0x1f7df191, 0x1f7df191, 0x05adef8d, 0xfa521073},
+     {0x1eb4026e, 0x1eb4026e, 0x09047cd2, 0xf6fb832e}, {0x1ca140f9, 0x1ca140f9, 0x0e4b5bb5, 0xf1b4a44b},
+     {0x1a763e7f, 0x1a763e7f, 0x11fe5a29, 0xee01a5d7}, {0x16a09e66, 0x16a09e66, 0x16a09e66, 0xe95f619a},
+     {0x0e819b4a, 0x0e819b4a, 0x1c85eab8, 0xe37a1548}, {0x00000000, 0x00000000, 0x20000000, 0xe0000000}},
+    {{0x236f9840, 0x1c25d2e6, 0x00000000, 0x00000000}, {0x230a25ab, 0x1b8bc073, 0x0548e1f1, 0xfa35e006},
+     {0x226c506a, 0x1a9d190b, 0x08695ba9, 0xf6d5997d}, {0x20cb9415, 0x182d30dc, 0x0d6c4a68, 0xf195c48f},
+     {0x1f14c1af, 0x15a62303, 0x11050bf3, 0xee02b7f4}, {0x1c048972, 0x113bd0c6, 0x15b2258d, 0xe9bea6c4},
+     {0x15614e1a, 0x0823334e, 0x1c426a47, 0xe50ddf2c}, {0x08de7718, 0xf8f48160, 0x224edeea, 0xe4bf848d}},
+    {{0x2645f043, 0x182614ce, 0x00000000, 0x00000000}, {0x25fc3aa7, 0x177d6e9d, 0x04af91d3, 0xfa65dba5},
+     {0x25895ef4, 0x1678ddb9, 0x07790167, 0xf728aba5}, {0x245907b5, 0x13d39c54, 0x0bfc8d6a, 0xf236a6a0},
+     {0x2316d504, 0x111b7e35, 0x0f4895ef, 0xeef4b991}, {0x20d26cd0, 0x0c6bda60, 0x13afba38, 0xeb4a6d9f},
+     {0x1bd2d75c, 0x030f7446, 0x1a47e82d, 0xe80bc360}, {0x1205689d, 0xf4a122cc, 0x21c3d85f, 0xeab21a36}},
+    {{0x28753a6b, 0x1446e919, 0x00000000, 0x00000000}, {0x2842a858, 0x139b1bd2, 0x03fe3ebe, 0xfad39351},
+     {0x27f3c42d, 0x129257ce, 0x06607964, 0xf7dc4eb0}, {0x2722320c, 0x0fe61e60, 0x0a444b88, 0xf36a3f79},
+     {0x264378c5, 0x0d2d1afe, 0x0d24a7e5, 0xf09667f0}, {0x24aff878, 0x088c3f41, 0x110e207f, 0xed9cdd3f},
+     {0x212b6eeb, 0xff973c7d, 0x172a3d3b, 0xebba2591}, {0x1a141d74, 0xf2ee0431, 0x1eee702e, 0xf07f613f}},
+    {{0x2a0ba252, 0x10bd1474, 0x00000000, 0x00000000}, {0x29ea5c54, 0x10185146, 0x034daea6, 0xfb672f5a},
+     {0x29b669de, 0x0f1afe59, 0x0547c707, 0xf8c9d98b}, {0x292c2e59, 0x0c8fd108, 0x0885d5a0, 0xf4eff684},
+     {0x2898e3ea, 0x09fdfb47, 0x0af0a6d2, 0xf2922cd2}, {0x278d068a, 0x05ae070f, 0x0e445a25, 0xf041279c},
+     {0x25324798, 0xfd95a158, 0x139a2af6, 0xef6fc5c8}, {0x205cfa3d, 0xf31db0e9, 0x1ad75092, 0xf5507af7}},
+    {{0x2b26172e, 0x0da5149e, 0x00000000, 0x00000000}, {0x2b10cc17, 0x0d0e6fda, 0x02ad89c3, 0xfc093ecd},
+     {0x2aef8980, 0x0c274b84, 0x04487635, 0xf9cc1747}, {0x2a96eeaf, 0x09d7e97e, 0x06ec9ec2, 0xf68cfb0a},
+     {0x2a385cbf, 0x0786df63, 0x08e758bd, 0xf49e7333}, {0x298bf340, 0x03af0294, 0x0ba60f46, 0xf2dc9e03},
+     {0x2805efce, 0xfcaa6e30, 0x101f93dc, 0xf2c4d053}, {0x24dbfc70, 0xf4581446, 0x166eac0f, 0xf8e801f4}},
+    {{0x2c29651e, 0x09e2f672, 0x00000000, 0x00000000}, {0x2c1ecda8, 0x09678d7f, 0x01e94212, 0xfcf351cd},
+     {0x2c0e4090, 0x08aaaa63, 0x030eeebd, 0xfb3e180d}, {0x2be21e42, 0x06ca2072, 0x04f37ecd, 0xf8d03f7b},
+     {0x2bb2f207, 0x04ec8e87, 0x06603d82, 0xf76d4943}, {0x2b5cc371, 0x01df5e7b, 0x085d4350, 0xf64ad93f},
+     {0x2a98f032, 0xfc7da032, 0x0ba653da, 0xf6c1d7fa}, {0x28fe46ce, 0xf6d29fc6, 0x106d02bd, 0xfc529d89}},
+    {{0x2cb26b24, 0x0715804a, 0x00000000, 0x00000000}, {0x2cad39a4, 0x06b59060, 0x0158b4d0, 0xfdb9f803},
+     {0x2ca51ba7, 0x0622fe68, 0x0227c0d8, 0xfc760a0b}, {0x2c8f7417, 0x04afac18, 0x037dd69e, 0xfab0028f},
+     {0x2c784ab4, 0x03411aef, 0x047fe2d7, 0xf9b52f98}, {0x2c4def01, 0x00efcf92, 0x05e91aa0, 0xf8fa6cb7},
+     {0x2bed7a25, 0xfcf4f854, 0x0841cef0, 0xf99a5983}, {0x2b223e65, 0xf929ec1c, 0x0bb7a1ea, 0xfe24971d}},
+    {{0x2cf8fe81, 0x050bc779, 0x00000000, 0x00000000}, {0x2cf6742a, 0x04c39bf4, 0x00f1d807, 0xfe5644dc},
+     {0x2cf27b99, 0x04557e8d, 0x01832763, 0xfd6a6629}, {0x2ce7e309, 0x033f5e94, 0x02736433, 0xfc234e04},
+     {0x2cdc8cb5, 0x022e2134, 0x0328cc44, 0xfb73046d}, {0x2cc7ce4d, 0x0077483f, 0x04271a90, 0xfaf9bd65},
+     {0x2c988502, 0xfd946105, 0x05cf517c, 0xfb9286a9}, {0x2c34a94a, 0xfb0a3fee, 0x08451f9d, 0xff127470}},
+    {{0x2d1cdc50, 0x03955bce, 0x00000000, 0x00000000}, {0x2d1b9d5f, 0x03602de5, 0x00a9a1e1, 0xfecc3324},
+     {0x2d19aacc, 0x030f1d84, 0x010f9210, 0xfe223761}, {0x2d147849, 0x0242ce00, 0x01b827ba, 0xfd384a17},
+     {0x2d0ee876, 0x017ac5db, 0x023784cc, 0xfcbc7d4b}, {0x2d04baa9, 0x003b45a0, 0x02ea30a1, 0xfc6c8ee8},
+     {0x2ced83a1, 0xfe28f388, 0x0414ada6, 0xfcecd0b0}, {0x2cbc6f84, 0xfc724cfb, 0x05d142f5, 0xff89b429}},
+    {{0x2d2ef685, 0x028a7548, 0x00000000, 0x00000000}, {0x2d2e5977, 0x0263c983, 0x0077214c, 0xff2310a8},
+     {0x2d2d63f4, 0x0228e0b3, 0x00beb9a0, 0xfea954c1}, {0x2d2ad4bd, 0x0194a11b, 0x01352575, 0xfe02b71f},
+     {0x2d281783, 0x0103d6dc, 0x018ea236, 0xfdabb1fe}, {0x2d231406, 0x001d7a8b, 0x020c369c, 0xfd7635d0},
+     {0x2d17a410, 0xfea30428, 0x02de2865, 0xfddb1620}, {0x2cff72ca, 0xfd7836bc, 0x04175972, 0xffc51a6c}},
+    {{0x2d3b7300, 0x016e2ca1, 0x00000000, 0x00000000}, {0x2d3b425c, 0x0157d51f, 0x004255bb, 0xff820d5d},
+     {0x2d3af652, 0x0135d259, 0x006a33f7, 0xff3cd29c}, {0x2d3a2b61, 0x00e05e5b, 0x00ac2738, 0xfede9e03},
+     {0x2d39522c, 0x008d1fc8, 0x00ddff6f, 0xfeae1cee}, {0x2d37c496, 0x00093b8f, 0x0123f63c, 0xfe91f12c},
+     {0x2d34396f, 0xff32e8e0, 0x0198fbed, 0xfed0a63e}, {0x2d2cb9ee, 0xfe924a8f, 0x0247bcf1, 0xffed8a64}},
+    {{0x2d3f67f9, 0x00cdfc3e, 0x00000000, 0x00000000}, {0x2d3f58c9, 0x00c13cd1, 0x00251306, 0xffb8a951},
+     {0x2d3f410b, 0x00add6d9, 0x003b5b57, 0xff918070}, {0x2d3f01ac, 0x007d24e2, 0x006037c4, 0xff5c634e},
+     {0x2d3ebdd8, 0x004dc6ab, 0x007c1417, 0xff41432b}, {0x2d3e41b0, 0x0002e6e5, 0x00a33009, 0xff3208fd},
+     {0x2d3d2665, 0xff89fbcf, 0x00e49c8a, 0xff572ca4}, {0x2d3acee3, 0xff3218b0, 0x014657c7, 0xfffa325c}},
+    {{0x2d40a885, 0x0073d8ba, 0x00000000, 0x00000000}, {0x2d40a3c1, 0x006c9ee2, 0x0014c5c5, 0xffd7b9e1},
+     {0x2d409c4d, 0x0061a095, 0x002141e1, 0xffc1a2a7}, {0x2d408868, 0x00460b71, 0x0035e922, 0xffa3ba4c},
+     {0x2d40731e, 0x002b3c50, 0x00458574, 0xff94861e}, {0x2d404c25, 0x0000ea13, 0x005b6f62, 0xff8c2833},
+     {0x2d3ff338, 0xffbcce44, 0x00801865, 0xffa1a1bd}, {0x2d3f3706, 0xff8c2af8, 0x00b6dd4f, 0xfffe2bde}},
+    {{0x2d410de8, 0x004125c6, 0x00000000, 0x00000000}, {0x2d410c68, 0x003d10ed, 0x000ba818, 0xffe94db1},
+     {0x2d410a0f, 0x0036db85, 0x0012a99d, 0xffdcdc05}, {0x2d4103cc, 0x002748c9, 0x001e4099, 0xffcc0785},
+     {0x2d40fd18, 0x0018279c, 0x0027032d, 0xffc37ef0}, {0x2d40f0d2, 0x000049dd, 0x00334f45, 0xffbeda64},
+     {0x2d40d4d1, 0xffd9f49c, 0x0047e1e2, 0xffcb1d73}, {0x2d40998f, 0xffbedae2, 0x00669e49, 0xffff6c45}},
+    {{0x2d412df9, 0x0024a2b4, 0x00000000, 0x00000000}, {0x2d412d80, 0x002255b2, 0x00068c0f, 0xfff338b6},
+     {0x2d412cc2, 0x001ed5c3, 0x000a7b69, 0xffec378f}, {0x2d412ac8, 0x00160ed7, 0x0010fddc, 0xffe2bfcb},
+     {0x2d4128ab, 0x000d887a, 0x0015e970, 0xffddf4a4}, {0x2d4124cc, 0x00001754, 0x001cd19e, 0xffdb5d54},
+     {0x2d411bf6, 0xffea8664, 0x00285fb6, 0xffe2518e}, {0x2d410944, 0xffdb5d6a, 0x0039a330, 0xffffd157}}
+};
+static const uint32_t psMixB[46][8][4] PROGMEM = {
+    {{0x028a7548, 0x2d2ef685, 0x00000000, 0x00000000}, {0x0261b6ad, 0x2d2ef4f1, 0xff1d67c5, 0x000bf1b6},
+     {0x0223a837, 0x2d2ef377, 0xfea10c39, 0x00109dcf}, {0x0187a9ca, 0x2d2ef319, 0xfdf8ad7c, 0x001195a4},
+     {0x00efca30, 0x2d2ef4c8, 0xfda35aa8, 0x000c88e0}, {0x0020a036, 0x2d2ef67b, 0xfd765c51, 0x0001d517},
+     {0x0020a036, 0x2d2ef67b, 0xfd765c51, 0x0001d517}, {0x0020a036, 0x2d2ef67b, 0xfd765c51, 0x0001d517}},
+    {{0x05a712a2, 0x2ce681fc, 0x00000000, 0x00000000}, {0x054e7b0c, 0x2ce65b52, 0xfe0d73be, 0x003aebf8},
+     {0x04c6d24d, 0x2ce63686, 0xfcfa39ae, 0x00525194}, {0x036e6493, 0x2ce62bfa, 0xfb82060e, 0x0057e1cc},
+     {0x021b5ef2, 0x2ce655c5, 0xfac13473, 0x003f02b5}, {0x0049840c, 0x2ce68108, 0xfa5acbbc, 0x00093e3f},
+     {0x0049840c, 0x2ce68108, 0xfa5acbbc, 0x00093e3f}, {0x0049840c, 0x2ce68108, 0xfa5acbbc, 0x00093e3f}},
+    {{0x08dae04d, 0x2c614b41, 0x00000000, 0x00000000}, {0x0855e881, 0x2c6062a3, 0xfd030a53, 0x008fb030},
+     {0x07886020, 0x2c5f7e26, 0xfb585288, 0x00ca4c45}, {0x0574f8eb, 0x2c5f2c1c, 0xf906ba63, 0x00db8e5c},
+     {0x035edb22, 0x2c602da2, 0xf7cfc37a, 0x009f37ed}, {0x007607bb, 0x2c614506, 0xf72832dc, 0x001784ab},
+     {0x007607bb, 0x2c614506, 0xf72832dc, 0x001784ab}, {0x007607bb, 0x2c614506, 0xf72832dc, 0x001784ab}},
+    {{0x0da5149e, 0x2b26172e, 0x00000000, 0x00000000}, {0x0cec9650, 0x2b20fd1c, 0xfb9fcb21, 0x014faf84},
+     {0x0bc9c86c, 0x2b1b9c57, 0xf920da60, 0x01e10dcd}, {0x08b9f491, 0x2b18b31e, 0xf582a8c2, 0x021fbdb4},
+     {0x057ae30b, 0x2b1e9b34, 0xf381033d, 0x01968e78}, {0x00c1ff48, 0x2b25ebb4, 0xf2604f89, 0x003d40e9},
+     {0x00c1ff48, 0x2b25ebb4, 0xf2604f89, 0x003d40e9}, {0x00c1ff48, 0x2b25ebb4, 0xf2604f89, 0x003d40e9}},
+    {{0x1274fb23, 0x2951ea33, 0x00000000, 0x00000000}, {0x11a17621, 0x294107ec, 0xfa8a1acd, 0x02556aed},
+     {0x104cccf3, 0x292d7631, 0xf7576e30, 0x036d6bd9}, {0x0c828b6c, 0x291cf66d, 0xf26dee69, 0x042117b5},
+     {0x081f2d5f, 0x2930c791, 0xef6d118b, 0x03449aab}, {0x0126e265, 0x29511908, 0xed943ad3, 0x00837930},
+     {0x0126e265, 0x29511908, 0xed943ad3, 0x00837930}, {0x0126e265, 0x29511908, 0xed943ad3, 0x00837930}},
+    {{0x182614ce, 0x2645f043, 0x00000000, 0x00000000}, {0x17597846, 0x26161a14, 0xf9d6aa6d, 0x03c70323},
+     {0x160b1d2d, 0x25d6ef46, 0xf6237121, 0x05beadc3}, {0x121b114a, 0x257ca8e0, 0xf0053eae, 0x07b7c8b3},
+     {0x0cd1fcd8, 0x25a204b4, 0xeb890aa3, 0x06f8bce3}, {0x01ffdf9a, 0x2640a513, 0xe7ef2589, 0x01420909},
+     {0x01ffdf9a, 0x2640a513, 0xe7ef2589, 0x01420909}, {0x01ffdf9a, 0x2640a513, 0xe7ef2589, 0x01420909}},
+    {{0x1c25d2e6, 0x236f9840, 0x00000000, 0x00000000}, {0x1b7758af, 0x231b66be, 0xf9d7e891, 0x04d11084},
+     {0x1a5d3eed, 0x22a1bc50, 0xf623cd2f, 0x07819ab7}, {0x1715570e, 0x21abe4f1, 0xefe4754c, 0x0b0ae166},
+     {0x126d358a, 0x21709f73, 0xeab8d064, 0x0bb9981a}, {0x03c1d758, 0x234fb72f, 0xe41aa893, 0x02f7d9d7},
+     {0x03c1d758, 0x234fb72f, 0xe41aa893, 0x02f7d9d7}, {0x03c1d758, 0x234fb72f, 0xe41aa893, 0x02f7d9d7}},
+    {{0x20000000, 0x20000000, 0x00000000, 0x00000000}, {0x1f7df190, 0x1f7df190, 0xfa521072, 0x05adef8e},
+     {0x1eb4026e, 0x1eb4026e, 0xf6fb832e, 0x09047cd2}, {0x1ca140f9, 0x1ca140f9, 0xf1b4a44a, 0x0e4b5bb6},
+     {0x1a763e7f, 0x1a763e7f, 0xee01a5d6, 0x11fe5a2a}, {0x172faafc, 0x172faafc, 0xe9f20dbb, 0x160df245},
+     {0x172faafc, 0x172faafc, 0xe9f20dbb, 0x160df245}, {0x172faafc, 0x172faafc, 0xe9f20dbb, 0x160df245}},
+    {{0x236f9840, 0x1c25d2e6, 0x00000000, 0x00000000}, {0x231b66be, 0x1b7758af, 0xfb2eef7c, 0x0628176f},
+     {0x22a1bc50, 0x1a5d3eed, 0xf87e6549, 0x09dc32d1}, {0x21abe4f1, 0x1715570e, 0xf4f51e9a, 0x101b8ab4},
+     {0x21709f73, 0x126d358a, 0xf44667e6, 0x15472f9c}, {0x234fb72f, 0x03c1d758, 0xfd082629, 0x1be5576d},
+     {0x234fb72f, 0x03c1d758, 0xfd082629, 0x1be5576d}, {0x234fb72f, 0x03c1d758, 0xfd082629, 0x1be5576d}},
+    {{0x2645f043, 0x182614ce, 0x00000000, 0x00000000}, {0x26161a14, 0x17597846, 0xfc38fcdd, 0x06295593},
+     {0x25d6ef46, 0x160b1d2d, 0xfa41523d, 0x09dc8edf}, {0x257ca8e0, 0x121b114a, 0xf848374d, 0x0ffac152},
+     {0x25a204b4, 0x0cd1fcd8, 0xf907431d, 0x1476f55d}, {0x2640a513, 0x01ffdf9a, 0xfebdf6f7, 0x1810da77},
+     {0x2640a513, 0x01ffdf9a, 0xfebdf6f7, 0x1810da77}, {0x2640a513, 0x01ffdf9a, 0xfebdf6f7, 0x1810da77}},
+    {{0x2951ea33, 0x1274fb23, 0x00000000, 0x00000000}, {0x294107ec, 0x11a17621, 0xfdaa9513, 0x0575e533},
+     {0x292d7631, 0x104cccf3, 0xfc929427, 0x08a891d0}, {0x291cf66d, 0x0c828b6c, 0xfbdee84b, 0x0d921197},
+     {0x2930c791, 0x081f2d5f, 0xfcbb6555, 0x1092ee75}, {0x29511908, 0x0126e265, 0xff7c86d0, 0x126bc52d},
+     {0x29511908, 0x0126e265, 0xff7c86d0, 0x126bc52d}, {0x29511908, 0x0126e265, 0xff7c86d0, 0x126bc52d}},
+    {{0x2b26172e, 0x0da5149e, 0x00000000, 0x00000000}, {0x2b20fd1c, 0x0cec9650, 0xfeb0507c, 0x046034df},
+     {0x2b1b9c57, 0x0bc9c86c, 0xfe1ef233, 0x06df25a0}, {0x2b18b31e, 0x08b9f491, 0xfde0424c, 0x0a7d573e},
+     {0x2b1e9b34, 0x057ae30b, 0xfe697188, 0x0c7efcc3}, {0x2b25ebb4, 0x00c1ff48, 0xffc2bf17, 0x0d9fb077},
+     {0x2b25ebb4, 0x00c1ff48, 0xffc2bf17, 0x0d9fb077}, {0x2b25ebb4, 0x00c1ff48, 0xffc2bf17, 0x0d9fb077}},
+    {{0x2c614b41, 0x08dae04d, 0x00000000, 0x00000000}, {0x2c6062a3, 0x0855e881, 0xff704fd0, 0x02fcf5ad},
+     {0x2c5f7e26, 0x07886020, 0xff35b3bb, 0x04a7ad78}, {0x2c5f2c1c, 0x0574f8eb, 0xff2471a4, 0x06f9459d},
+     {0x2c602da2, 0x035edb22, 0xff60c813, 0x08303c86}, {0x2c614506, 0x007607bb, 0xffe87b55, 0x08d7cd24},
+     {0x2c614506, 0x007607bb, 0xffe87b55, 0x08d7cd24}, {0x2c614506, 0x007607bb, 0xffe87b55, 0x08d7cd24}},
+    {{0x2ce681fc, 0x05a712a2, 0x00000000, 0x00000000}, {0x2ce65b52, 0x054e7b0c, 0xffc51408, 0x01f28c42},
+     {0x2ce63686, 0x04c6d24d, 0xffadae6c, 0x0305c652}, {0x2ce62bfa, 0x036e6493, 0xffa81e34, 0x047df9f2},
+     {0x2ce655c5, 0x021b5ef2, 0xffc0fd4b, 0x053ecb8d}, {0x2ce68108, 0x0049840c, 0xfff6c1c1, 0x05a53444},
+     {0x2ce68108, 0x0049840c, 0xfff6c1c1, 0x05a53444}, {0x2ce68108, 0x0049840c, 0xfff6c1c1, 0x05a53444}},
+    {{0x2d2ef685, 0x028a7548, 0x00000000, 0x00000000}, {0x2d2ef4f1, 0x0261b6ad, 0xfff40e4a, 0x00e2983b},
+     {0x2d2ef377, 0x0223a837, 0xffef6231, 0x015ef3c7}, {0x2d2ef319, 0x0187a9ca, 0xffee6a5c, 0x02075284},
+     {0x2d2ef4c8, 0x00efca30, 0xfff37720, 0x025ca558}, {0x2d2ef67b, 0x0020a036, 0xfffe2ae9, 0x0289a3af},
+     {0x2d2ef67b, 0x0020a036, 0xfffe2ae9, 0x0289a3af}, {0x2d2ef67b, 0x0020a036, 0xfffe2ae9, 0x0289a3af}},
+    {{0x0024a2b4, 0x2d412df9, 0x00000000, 0x00000000}, {0x002253db, 0x2d412df9, 0xfff333c6, 0x000009b5},
+     {0x001ed133, 0x2d412df9, 0xffec3074, 0x00000d7e}, {0x001603e3, 0x2d412df9, 0xffe2b78b, 0x00000e3f},
+     {0x000d7804, 0x2d412df9, 0xffddee1e, 0x00000a24}, {0x0001d4f1, 0x2d412df9, 0xffdb6907, 0x0000017b},
+     {0x0001d4f1, 0x2d412df9, 0xffdb6907, 0x0000017b}, {0x0001d4f1, 0x2d412df9, 0xffdb6907, 0x0000017b}},
+    {{0x004125c6, 0x2d410de8, 0x00000000, 0x00000000}, {0x003d0b22, 0x2d410de8, 0xffe93e20, 0x00001eb3},
+     {0x0036cd23, 0x2d410de8, 0xffdcc59c, 0x00002aa9}, {0x00272636, 0x2d410de8, 0xffcbed75, 0x00002d0c},
+     {0x0017f395, 0x2d410de8, 0xffc36a45, 0x00002011}, {0x000341ea, 0x2d410de8, 0xffbeef17, 0x000004af},
+     {0x000341ea, 0x2d410de8, 0xffbeef17, 0x000004af}, {0x000341ea, 0x2d410de8, 0xffbeef17, 0x000004af}},
+    {{0x0073d8ba, 0x2d40a885, 0x00000000, 0x00000000}, {0x006c8cb1, 0x2d40a885, 0xffd788f2, 0x00006111},
+     {0x00617360, 0x2d40a885, 0xffc15c1b, 0x000086e5}, {0x00459e75, 0x2d40a884, 0xffa367f7, 0x00008e74},
+     {0x002a97f1, 0x2d40a885, 0xff944490, 0x00006567}, {0x0005cafc, 0x2d40a885, 0xff8c4c60, 0x00000ed0},
+     {0x0005cafc, 0x2d40a885, 0xff8c4c60, 0x00000ed0}, {0x0005cafc, 0x2d40a885, 0xff8c4c60, 0x00000ed0}},
+    {{0x00cdfc3e, 0x2d3f67f9, 0x00000000, 0x00000000}, {0x00c10405, 0x2d3f67f5, 0xffb81031, 0x000132dd},
+     {0x00ad4969, 0x2d3f67f2, 0xff90a325, 0x0001aa7d}, {0x007bce43, 0x2d3f67f1, 0xff5b5f73, 0x0001c273},
+     {0x004bbfc9, 0x2d3f67f5, 0xff4072ca, 0x000140ad}, {0x000a4d72, 0x2d3f67f9, 0xff3245c1, 0x00002ed8},
+     {0x000a4d72, 0x2d3f67f9, 0xff3245c1, 0x00002ed8}, {0x000a4d72, 0x2d3f67f9, 0xff3245c1, 0x00002ed8}},
+    {{0x016e2ca1, 0x2d3b7300, 0x00000000, 0x00000000}, {0x015725ad, 0x2d3b72d8, 0xff803260, 0x0003c98f},
+     {0x01341bc9, 0x2d3b72b2, 0xff3a2120, 0x000543d6}, {0x00dc2e9d, 0x2d3b72a9, 0xfedb6b54, 0x0005903b},
+     {0x0086bca1, 0x2d3b72d4, 0xfeab83fe, 0x0003f63a}, {0x001253b6, 0x2d3b72ff, 0xfe9248da, 0x0000942e},
+     {0x001253b6, 0x2d3b72ff, 0xfe9248da, 0x0000942e}, {0x001253b6, 0x2d3b72ff, 0xfe9248da, 0x0000942e}},
+    {{0x028a7548, 0x2d2ef685, 0x00000000, 0x00000000}, {0x0261b6ad, 0x2d2ef4f1, 0xff1d67c5, 0x000bf1b6},
+     {0x0223a837, 0x2d2ef377, 0xfea10c39, 0x00109dcf}, {0x0187a9ca, 0x2d2ef319, 0xfdf8ad7c, 0x001195a4},
+     {0x00efca30, 0x2d2ef4c8, 0xfda35aa8, 0x000c88e0}, {0x0020a036, 0x2d2ef67b, 0xfd765c51, 0x0001d517},
+     {0x0020a036, 0x2d2ef67b, 0xfd765c51, 0x0001d517}, {0x0020a036, 0x2d2ef67b, 0xfd765c51, 0x0001d517}},
+    {{0x03955bce, 0x2d1cdc50, 0x00000000, 0x00000000}, {0x035c38cd, 0x2d1cd612, 0xfec14ea3, 0x0017bcef},
+     {0x0305149f, 0x2d1cd033, 0xfe1224fd, 0x00210f0f}, {0x02297b91, 0x2d1cceb0, 0xfd246c7e, 0x00230fa9},
+     {0x01531b13, 0x2d1cd55f, 0xfcab9e5b, 0x0019073d}, {0x002e288f, 0x2d1cdc2a, 0xfc6bcdac, 0x0003a96f},
+     {0x002e288f, 0x2d1cdc2a, 0xfc6bcdac, 0x0003a96f}, {0x002e288f, 0x2d1cdc2a, 0xfc6bcdac, 0x0003a96f}},
+    {{0x050bc779, 0x2cf8fe81, 0x00000000, 0x00000000}, {0x04bc3a9d, 0x2cf8e5f4, 0xfe41b01d, 0x002efe5c},
+     {0x04429493, 0x2cf8ceaf, 0xfd4baa35, 0x0041954f}, {0x030e81bf, 0x2cf8c83f, 0xfbfc32bd, 0x0045dbb1},
+     {0x01e01faa, 0x2cf8e2b2, 0xfb50c2c2, 0x00320317}, {0x0041690b, 0x2cf8fde8, 0xfaf5e0c0, 0x0007546a},
+     {0x0041690b, 0x2cf8fde8, 0xfaf5e0c0, 0x0007546a}, {0x0041690b, 0x2cf8fde8, 0xfaf5e0c0, 0x0007546a}},
+    {{0x0715804a, 0x2cb26b24, 0x00000000, 0x00000000}, {0x06a84e6e, 0x2cb20bce, 0xfd94388d, 0x005c511c},
+     {0x06007873, 0x2cb1afed, 0xfc3ca635, 0x00815d94}, {0x04534bf1, 0x2cb19305, 0xfa63cbe8, 0x008afe4f},
+     {0x02a97140, 0x2cb1fb13, 0xf96f65ed, 0x0064172a}, {0x005d0153, 0x2cb268b8, 0xf8ece2a5, 0x000eb890},
+     {0x005d0153, 0x2cb268b8, 0xf8ece2a5, 0x000eb890}, {0x005d0153, 0x2cb268b8, 0xf8ece2a5, 0x000eb890}},
+    {{0x09e2f672, 0x2c29651e, 0x00000000, 0x00000000}, {0x09512f81, 0x2c27fbd6, 0xfcb170ed, 0x00b2a096},
+     {0x086f01f8, 0x2c26945b, 0xfad73883, 0x00fc4b41}, {0x0621cc27, 0x2c260813, 0xf83ead47, 0x0113c074},
+     {0x03cc2dbf, 0x2c279bc2, 0xf6df32d9, 0x00c8faa3}, {0x008534cd, 0x2c295b14, 0xf6208b8d, 0x001dc7aa},
+     {0x008534cd, 0x2c295b14, 0xf6208b8d, 0x001dc7aa}, {0x008534cd, 0x2c295b14, 0xf6208b8d, 0x001dc7aa}},
+    {{0x0da5149e, 0x2b26172e, 0x00000000, 0x00000000}, {0x0cec9650, 0x2b20fd1c, 0xfb9fcb21, 0x014faf84},
+     {0x0bc9c86c, 0x2b1b9c57, 0xf920da60, 0x01e10dcd}, {0x08b9f491, 0x2b18b31e, 0xf582a8c2, 0x021fbdb4},
+     {0x057ae30b, 0x2b1e9b34, 0xf381033d, 0x01968e78}, {0x00c1ff48, 0x2b25ebb4, 0xf2604f89, 0x003d40e9},
+     {0x00c1ff48, 0x2b25ebb4, 0xf2604f89, 0x003d40e9}, {0x00c1ff48, 0x2b25ebb4, 0xf2604f89, 0x003d40e9}},
+    {{0x10bd1474, 0x2a0ba252, 0x00000000, 0x00000000}, {0x0feff60e, 0x2a0026cb, 0xfae21ab3, 0x01f10c02},
+     {0x0ea80dec, 0x29f350cb, 0xf7ea37cc, 0x02d3219a}, {0x0b1528dc, 0x29ea1725, 0xf374b3b3, 0x03511aae},
+     {0x07173f6e, 0x29f7a29e, 0xf0d6677f, 0x028fd5e7}, {0x00fe73ee, 0x2a0b28b5, 0xef4a7b4b, 0x0065200e},
+     {0x00fe73ee, 0x2a0b28b5, 0xef4a7b4b, 0x0065200e}, {0x00fe73ee, 0x2a0b28b5, 0xef4a7b4b, 0x0065200e}},
+    {{0x1446e919, 0x28753a6b, 0x00000000, 0x00000000}, {0x1370d5ae, 0x285cd271, 0xfa3ca56d, 0x02c69bcc},
+     {0x1215ae5b, 0x283f5dda, 0xf6d451b4, 0x041ee635}, {0x0e235ea4, 0x2821f0a4, 0xf1770453, 0x051eda14},
+     {0x095d92bb, 0x283da67c, 0xee03f575, 0x042f87a3}, {0x015a2ca1, 0x2873c7ee, 0xebc4a52f, 0x00ad22d8},
+     {0x015a2ca1, 0x2873c7ee, 0xebc4a52f, 0x00ad22d8}, {0x015a2ca1, 0x2873c7ee, 0xebc4a52f, 0x00ad22d8}},
+    {{0x182614ce, 0x2645f043, 0x00000000, 0x00000000}, {0x17597846, 0x26161a14, 0xf9d6aa6d, 0x03c70323},
+     {0x160b1d2d, 0x25d6ef46, 0xf6237121, 0x05beadc3}, {0x121b114a, 0x257ca8e0, 0xf0053eae, 0x07b7c8b3},
+     {0x0cd1fcd8, 0x25a204b4, 0xeb890aa3, 0x06f8bce3}, {0x01ffdf9a, 0x2640a513, 0xe7ef2589, 0x01420909},
+     {0x01ffdf9a, 0x2640a513, 0xe7ef2589, 0x01420909}, {0x01ffdf9a, 0x2640a513, 0xe7ef2589, 0x01420909}},
+    {{0x1c25d2e6, 0x236f9840, 0x00000000, 0x00000000}, {0x1b7758af, 0x231b66be, 0xf9d7e891, 0x04d11084},
+     {0x1a5d3eed, 0x22a1bc50, 0xf623cd2f, 0x07819ab7}, {0x1715570e, 0x21abe4f1, 0xefe4754c, 0x0b0ae166},
+     {0x126d358a, 0x21709f73, 0xeab8d064, 0x0bb9981a}, {0x03c1d758, 0x234fb72f, 0xe41aa893, 0x02f7d9d7},
+     {0x03c1d758, 0x234fb72f, 0xe41aa893, 0x02f7d9d7}, {0x03c1d758, 0x234fb72f, 0xe41aa893, 0x02f7d9d7}},
+    {{0x20000000, 0x20000000, 0x00000000, 0x00000000}, {0x1f7df190, 0x1f7df190, 0xfa521072, 0x05adef8e},
+     {0x1eb4026e, 0x1eb4026e, 0xf6fb832e, 0x09047cd2}, {0x1ca140f9, 0x1ca140f9, 0xf1b4a44a, 0x0e4b5bb6},
+     {0x1a763e7f, 0x1a763e7f, 0xee01a5d6, 0x11fe5a2a}, {0x172faafc, 0x172faafc, 0xe9f20dbb, 0x160df245},
+     {0x172faafc, 0x172faafc, 0xe9f20dbb, 0x160df245}, {0x172faafc, 0x172faafc, 0xe9f20dbb, 0x160df245}},
+    {{0x236f9840, 0x1c25d2e6, 0x00000000, 0x00000000}, {0x231b66be, 0x1b7758af, 0xfb2eef7c, 0x0628176f},
+     {0x22a1bc50, 0x1a5d3eed, 0xf87e6549, 0x09dc32d1}, {0x21abe4f1, 0x1715570e, 0xf4f51e9a, 0x101b8ab4},
+     {0x21709f73, 0x126d358a, 0xf44667e6, 0x15472f9c}, {0x234fb72f, 0x03c1d758, 0xfd082629, 0x1be5576d},
+     {0x234fb72f, 0x03c1d758, 0xfd082629, 0x1be5576d}, {0x234fb72f, 0x03c1d758, 0xfd082629, 0x1be5576d}},
+    {{0x2645f043, 0x182614ce, 0x00000000, 0x00000000}, {0x26161a14, 0x17597846, 0xfc38fcdd, 0x06295593},
+     {0x25d6ef46, 0x160b1d2d, 0xfa41523d, 0x09dc8edf}, {0x257ca8e0, 0x121b114a, 0xf848374d, 0x0ffac152},
+     {0x25a204b4, 0x0cd1fcd8, 0xf907431d, 0x1476f55d}, {0x2640a513, 0x01ffdf9a, 0xfebdf6f7, 0x1810da77},
+     {0x2640a513, 0x01ffdf9a, 0xfebdf6f7, 0x1810da77}, {0x2640a513, 0x01ffdf9a, 0xfebdf6f7, 0x1810da77}},
+    {{0x28753a6b, 0x1446e919, 0x00000000, 0x00000000}, {0x285cd271, 0x1370d5ae, 0xfd396434, 0x05c35a93},
+     {0x283f5dda, 0x1215ae5b, 0xfbe119cb, 0x092bae4c}, {0x2821f0a4, 0x0e235ea4, 0xfae125ec, 0x0e88fbad},
+     {0x283da67c, 0x095d92bb, 0xfbd0785d, 0x11fc0a8b}, {0x2873c7ee, 0x015a2ca1, 0xff52dd28, 0x143b5ad1},
+     {0x2873c7ee, 0x015a2ca1, 0xff52dd28, 0x143b5ad1}, {0x2873c7ee, 0x015a2ca1, 0xff52dd28, 0x143b5ad1}},
+    {{0x2a0ba252, 0x10bd1474, 0x00000000, 0x00000000}, {0x2a0026cb, 0x0feff60e, 0xfe0ef3fe, 0x051de54d},
+     {0x29f350cb, 0x0ea80dec, 0xfd2cde66, 0x0815c834}, {0x29ea1725, 0x0b1528dc, 0xfcaee552, 0x0c8b4c4d},
+     {0x29f7a29e, 0x07173f6e, 0xfd702a19, 0x0f299881}, {0x2a0b28b5, 0x00fe73ee, 0xff9adff2, 0x10b584b5},
+     {0x2a0b28b5, 0x00fe73ee, 0xff9adff2, 0x10b584b5}, {0x2a0b28b5, 0x00fe73ee, 0xff9adff2, 0x10b584b5}},
+    {{0x2b26172e, 0x0da5149e, 0x00000000, 0x00000000}, {0x2b20fd1c, 0x0cec9650, 0xfeb0507c, 0x046034df},
+     {0x2b1b9c57, 0x0bc9c86c, 0xfe1ef233, 0x06df25a0}, {0x2b18b31e, 0x08b9f491, 0xfde0424c, 0x0a7d573e},
+     {0x2b1e9b34, 0x057ae30b, 0xfe697188, 0x0c7efcc3}, {0x2b25ebb4, 0x00c1ff48, 0xffc2bf17, 0x0d9fb077},
+     {0x2b25ebb4, 0x00c1ff48, 0xffc2bf17, 0x0d9fb077}, {0x2b25ebb4, 0x00c1ff48, 0xffc2bf17, 0x0d9fb077}},
+    {{0x2c29651e, 0x09e2f672, 0x00000000, 0x00000000}, {0x2c27fbd6, 0x09512f81, 0xff4d5f6a, 0x034e8f13},
+     {0x2c26945b, 0x086f01f8, 0xff03b4bf, 0x0528c77d}, {0x2c260813, 0x0621cc27, 0xfeec3f8c, 0x07c152b9},
+     {0x2c279bc2, 0x03cc2dbf, 0xff37055d, 0x0920cd27}, {0x2c295b14, 0x008534cd, 0xffe23856, 0x09df7473},
+     {0x2c295b14, 0x008534cd, 0xffe23856, 0x09df7473}, {0x2c295b14, 0x008534cd, 0xffe23856, 0x09df7473}},
+    {{0x2cb26b24, 0x0715804a, 0x00000000, 0x00000000}, {0x2cb20bce, 0x06a84e6e, 0xffa3aee4, 0x026bc773},
+     {0x2cb1afed, 0x06007873, 0xff7ea26c, 0x03c359cb}, {0x2cb19305, 0x04534bf1, 0xff7501b1, 0x059c3418},
+     {0x2cb1fb13, 0x02a97140, 0xff9be8d6, 0x06909a13}, {0x2cb268b8, 0x005d0153, 0xfff14770, 0x07131d5b},
+     {0x2cb268b8, 0x005d0153, 0xfff14770, 0x07131d5b}, {0x2cb268b8, 0x005d0153, 0xfff14770, 0x07131d5b}},
+    {{0x2cf8fe81, 0x050bc779, 0x00000000, 0x00000000}, {0x2cf8e5f4, 0x04bc3a9d, 0xffd101a4, 0x01be4fe3},
+     {0x2cf8ceaf, 0x04429493, 0xffbe6ab1, 0x02b455cb}, {0x2cf8c83f, 0x030e81bf, 0xffba244f, 0x0403cd43},
+     {0x2cf8e2b2, 0x01e01faa, 0xffcdfce9, 0x04af3d3e}, {0x2cf8fde8, 0x0041690b, 0xfff8ab96, 0x050a1f40},
+     {0x2cf8fde8, 0x0041690b, 0xfff8ab96, 0x050a1f40}, {0x2cf8fde8, 0x0041690b, 0xfff8ab96, 0x050a1f40}},
+    {{0x2d1cdc50, 0x03955bce, 0x00000000, 0x00000000}, {0x2d1cd612, 0x035c38cd, 0xffe84311, 0x013eb15d},
+     {0x2d1cd033, 0x0305149f, 0xffdef0f1, 0x01eddb03}, {0x2d1cceb0, 0x02297b91, 0xffdcf057, 0x02db9382},
+     {0x2d1cd55f, 0x01531b13, 0xffe6f8c3, 0x035461a5}, {0x2d1cdc2a, 0x002e288f, 0xfffc5691, 0x03943254},
+     {0x2d1cdc2a, 0x002e288f, 0xfffc5691, 0x03943254}, {0x2d1cdc2a, 0x002e288f, 0xfffc5691, 0x03943254}},
+    {{0x2d2ef685, 0x028a7548, 0x00000000, 0x00000000}, {0x2d2ef4f1, 0x0261b6ad, 0xfff40e4a, 0x00e2983b},
+     {0x2d2ef377, 0x0223a837, 0xffef6231, 0x015ef3c7}, {0x2d2ef319, 0x0187a9ca, 0xffee6a5c, 0x02075284},
+     {0x2d2ef4c8, 0x00efca30, 0xfff37720, 0x025ca558}, {0x2d2ef67b, 0x0020a036, 0xfffe2ae9, 0x0289a3af},
+     {0x2d2ef67b, 0x0020a036, 0xfffe2ae9, 0x0289a3af}, {0x2d2ef67b, 0x0020a036, 0xfffe2ae9, 0x0289a3af}},
+    {{0x2d3b7300, 0x016e2ca1, 0x00000000, 0x00000000}, {0x2d3b72d8, 0x015725ad, 0xfffc3671, 0x007fcda0},
+     {0x2d3b72b2, 0x01341bc9, 0xfffabc2a, 0x00c5dee0}, {0x2d3b72a9, 0x00dc2e9d, 0xfffa6fc5, 0x012494ac},
+     {0x2d3b72d4, 0x0086bca1, 0xfffc09c6, 0x01547c02}, {0x2d3b72ff, 0x001253b6, 0xffff6bd2, 0x016db726},
+     {0x2d3b72ff, 0x001253b6, 0xffff6bd2, 0x016db726}, {0x2d3b72ff, 0x001253b6, 0xffff6bd2, 0x016db726}},
+    {{0x2d3f67f9, 0x00cdfc3e, 0x00000000, 0x00000000}, {0x2d3f67f5, 0x00c10405, 0xfffecd23, 0x0047efcf},
+     {0x2d3f67f2, 0x00ad4969, 0xfffe5583, 0x006f5cdb}, {0x2d3f67f1, 0x007bce43, 0xfffe3d8d, 0x00a4a08d},
+     {0x2d3f67f5, 0x004bbfc9, 0xfffebf53, 0x00bf8d36}, {0x2d3f67f9, 0x000a4d72, 0xffffd128, 0x00cdba3f},
+     {0x2d3f67f9, 0x000a4d72, 0xffffd128, 0x00cdba3f}, {0x2d3f67f9, 0x000a4d72, 0xffffd128, 0x00cdba3f}},
+    {{0x2d40a885, 0x0073d8ba, 0x00000000, 0x00000000}, {0x2d40a885, 0x006c8cb1, 0xffff9eef, 0x0028770e},
+     {0x2d40a885, 0x00617360, 0xffff791b, 0x003ea3e5}, {0x2d40a884, 0x00459e75, 0xffff718c, 0x005c9809},
+     {0x2d40a885, 0x002a97f1, 0xffff9a99, 0x006bbb70}, {0x2d40a885, 0x0005cafc, 0xfffff130, 0x0073b3a0},
+     {0x2d40a885, 0x0005cafc, 0xfffff130, 0x0073b3a0}, {0x2d40a885, 0x0005cafc, 0xfffff130, 0x0073b3a0}},
+    {{0x2d410de8, 0x004125c6, 0x00000000, 0x00000000}, {0x2d410de8, 0x003d0b22, 0xffffe14d, 0x0016c1e0},
+     {0x2d410de8, 0x0036cd23, 0xffffd557, 0x00233a64}, {0x2d410de8, 0x00272636, 0xffffd2f4, 0x0034128b},
+     {0x2d410de8, 0x0017f395, 0xffffdfef, 0x003c95bb}, {0x2d410de8, 0x000341ea, 0xfffffb51, 0x004110e9},
+     {0x2d410de8, 0x000341ea, 0xfffffb51, 0x004110e9}, {0x2d410de8, 0x000341ea, 0xfffffb51, 0x004110e9}},
+    {{0x2d412df9, 0x0024a2b4, 0x00000000, 0x00000000}, {0x2d412df9, 0x002253db, 0xfffff64b, 0x000ccc3a},
+     {0x2d412df9, 0x001ed133, 0xfffff282, 0x0013cf8c}, {0x2d412df9, 0x001603e3, 0xfffff1c1, 0x001d4875},
+     {0x2d412df9, 0x000d7804, 0xfffff5dc, 0x002211e2}, {0x2d412df9, 0x0001d4f1, 0xfffffe85, 0x002496f9},
+     {0x2d412df9, 0x0001d4f1, 0xfffffe85, 0x002496f9}, {0x2d412df9, 0x0001d4f1, 0xfffffe85, 0x002496f9}}
+};
+#endif
+
 static const uint32_t poly43lo[5] PROGMEM = { 0x29a0bda9, 0xb02e4828, 0x5957aa1b, 0x236c498d, 0xff581859 };
 static const uint32_t poly43hi[5] PROGMEM = { 0x10852163, 0xd333f6a4, 0x46e9408b, 0x27c2cef0, 0xfef577b4 };
 
@@ -1633,9 +2131,25 @@ static const int negMask[3] = {~0x03, ~0x07, ~0x0f};
  *
  * Return:      false if mot enough memory, otherwise true
  *
+ * Notes:       the buffers are taken from the codec arena if it is free, otherwise from the heap
  **********************************************************************************************************************/
 bool AACDecoder_AllocateBuffers(void){
 
+    // first choice is the codec arena: one static block, no heap fragmentation
+    if(!m_AACDecInfo && CodecArena_Claim(m_aac)) {
+        m_AACDecInfo = (AACDecInfo_t*)        CodecArena_Alloc(m_aac, sizeof(AACDecInfo_t),             "AACDecInfo");
+        m_PSInfoBase = (PSInfoBase_t*)        CodecArena_Alloc(m_aac, sizeof(PSInfoBase_t),             "PSInfoBase");
+        m_pce[0]     = (ProgConfigElement_t*) CodecArena_Alloc(m_aac, sizeof(ProgConfigElement_t) * 16, "ProgConfigElement");
+#ifdef AAC_ENABLE_SBR
+        if(!m_sbrBypass)
+            m_PSInfoSBR = (PSInfoSBR_t*)      CodecArena_Alloc(m_aac, sizeof(PSInfoSBR_t),              "PSInfoSBR");
+#endif
+        if(m_AACDecInfo && m_PSInfoBase && m_pce[0]) {
+            goto nextStep;
+        }
+        AACDecoder_FreeBuffers(); // budget too small (should not happen), use the heap
+    }
+
     if(!m_AACDecInfo)      {m_AACDecInfo   = (AACDecInfo_t*)           malloc(sizeof(AACDecInfo_t));}
     if(!m_PSInfoBase)      {m_PSInfoBase   = (PSInfoBase_t*)           malloc(sizeof(PSInfoBase_t));}
     if(!m_pce[0])          {m_pce[0]       = (ProgConfigElement_t*)    malloc(sizeof(ProgConfigElement_t)*16);}
@@ -1666,11 +2180,15 @@ bool AACDecoder_AllocateBuffers(void){
 
 
 #ifdef AAC_ENABLE_SBR
+    // not needed if SBR is bypassed, the arena has room for it if it holds the other buffers
+    if(!m_PSInfoSBR && !m_sbrBypass && CodecArena_IsOwner(m_aac)) {
+        m_PSInfoSBR = (PSInfoSBR_t*)CodecArena_Alloc(m_aac, sizeof(PSInfoSBR_t), "PSInfoSBR");
+    }
     // can't allocated in PSRAM, because PSRAM ist too slow
-    if(!m_PSInfoSBR) {m_PSInfoSBR   = (PSInfoSBR_t*)malloc(sizeof(PSInfoSBR_t));}
+    if(!m_PSInfoSBR && !m_sbrBypass) {m_PSInfoSBR   = (PSInfoSBR_t*)malloc(sizeof(PSInfoSBR_t));}
 
-    if(!m_PSInfoSBR) {
-        log_e("OOM in SBR, can't allocate %d bytes\n", sizeof(PSInfoSBR_t));
+    if(!m_PSInfoSBR && !m_sbrBypass) {
+        log_e("OOM in SBR, can't allocate %u bytes\n", (unsigned)sizeof(PSInfoSBR_t));
         return false; // ERR_AAC_SBR_INIT;
     }
 #endif
@@ -1686,8 +2204,10 @@ bool AACDecoder_AllocateBuffers(void){
     memset(&m_pulseInfo[0],      0, sizeof(PulseInfo_t) *2);            //Clear PulseInfo
     memset(&m_aac_BitStreamInfo, 0, sizeof(aac_BitStreamInfo_t));       //Clear aac_BitStreamInfo
 #ifdef AAC_ENABLE_SBR
-    memset( m_PSInfoSBR,         0, sizeof(PSInfoSBR_t));               //Clear PSInfoSBR
-    InitSBRState();
+    if(m_PSInfoSBR) {
+        memset( m_PSInfoSBR,     0, sizeof(PSInfoSBR_t));               //Clear PSInfoSBR
+        InitSBRState();
+    }
 #endif
 
     m_AACDecInfo->prevBlockID = AAC_ID_INVALID;
@@ -1755,6 +2275,13 @@ void AACDecoder_FreeBuffers(void) {
 
 //    uint32_t i = ESP.getFreeHeap();
 
+    if(CodecArena_IsOwner(m_aac)) {
+        // buffers are in the codec arena, just give it back
+        m_AACDecInfo = NULL; m_PSInfoBase = NULL; m_pce[0] = NULL; m_PSInfoSBR = NULL;
+        CodecArena_Release(m_aac);
+        return;
+    }
+
     if(m_AACDecInfo)                         {free(m_AACDecInfo);    m_AACDecInfo=NULL;}
     if(m_PSInfoBase)                         {free(m_PSInfoBase);    m_PSInfoBase=NULL;}
     if(m_pce[0])     {for(int i=0; i<16; i++) free(m_pce[i]);        m_pce[0]=NULL;}
@@ -1798,10 +2325,118 @@ bool AACDecoder_IsInit(void) {
 
  **********************************************************************************************************************/
 
+/***********************************************************************************************************************
+ * Function:    AACGetADTSFrameLength
+ *
+ * Description: check a candidate ADTS header and get the length of the frame
+ *
+ * Inputs:      pointer to (at least) 7 bytes of candidate ADTS header
+ *
+ * Outputs:     none
+ *
+ * Return:      number of bytes in the frame, including the header
+ *              -1 if this is not a valid (supported) ADTS header
+ *
+ * Notes:       same checks as UnpackADTSHeader(), but no decoder state is touched
+ *              a frame longer than its raw data blocks (with CRC) can be is rejected, so a false
+ *                header can not make AACFindSyncWord wait for more than a few frames of data
+ **********************************************************************************************************************/
+int AACGetADTSFrameLength(uint8_t *buf)
+{
+    int frameLength;
+
+    if ((buf[0] & SYNCWORDH) != SYNCWORDH || (buf[1] & SYNCWORDL) != SYNCWORDL)
+        return -1;
+    /* layer must be 0, profile LC, valid sample rate index and channel config */
+    if ((buf[1] & 0x06) != 0 || (buf[2] >> 6) != AAC_PROFILE_LC || ((buf[2] >> 2) & 0x0f) >= NUM_SAMPLE_RATES)
+        return -1;
+    frameLength = ((buf[3] & 0x03) << 11) | (buf[4] << 3) | (buf[5] >> 5);
+    if (frameLength < ((buf[1] & 0x01) ? 7 : 9))    /* must at least hold the header (+ CRC) */
+        return -1;
+    if (frameLength > (1 + (buf[6] & 0x03)) * (AAC_MAX_RAWBLOCK + 2) + 9)
+        return -1;
+    return frameLength;
+}
+/***********************************************************************************************************************
+ * Function:    AACGetLOASFrameLength
+ *
+ * Description: check a candidate LOAS header and get the length of the frame
+ *
+ * Inputs:      pointer to (at least) 3 bytes of candidate LOAS header
+ *
+ * Outputs:     none
+ *
+ * Return:      number of bytes in the frame, including the 3 header bytes
+ *              -1 if this is not a LOAS AudioSyncStream header
+ *
+ * Notes:       only one subframe is supported, so the frame is at most one raw data block and
+ *                LOAS_HEADER_BYTES of StreamMuxConfig and payload length
+ **********************************************************************************************************************/
+int AACGetLOASFrameLength(uint8_t *buf)
+{
+    int frameLength;
+
+    if (buf[0] != LOAS_SYNCWORDH || (buf[1] & LOAS_SYNCWORDL) != LOAS_SYNCWORDL)
+        return -1;
+    frameLength = ((buf[1] & 0x1f) << 8) | buf[2];  /* audioMuxLengthBytes */
+    if (frameLength == 0 || frameLength > AAC_MAX_RAWBLOCK + LOAS_HEADER_BYTES)
+        return -1;
+    return frameLength + 3;
+}
+/***********************************************************************************************************************
+ * Function:    FindSyncWord
+ *
+ * Description: AACFindSyncWord, or the search for the next frame inside AACDecode
+ *
+ * Inputs:      buffer to search for sync word
+ *              max number of bytes to search in buffer
+ *              true for AACFindSyncWord, false inside AACDecode
+ *
+ * Return:      as AACFindSyncWord, but if strict is false a candidate that could not be checked
+ *                to the end is returned.  AACDecode gets one frame at a time, after the stream
+ *                has been found by AACFindSyncWord
+ **********************************************************************************************************************/
+static int FindSyncWord(uint8_t *buf, int nBytes, bool strict)
+{
+    int i, len, pos, confirmed;
+    bool loas;
+
+    for (i = 0; i < nBytes - 6; i++) {
+        len = AACGetADTSFrameLength(buf + i);
+        loas = (len < 0);
+        if (loas)
+            len = AACGetLOASFrameLength(buf + i);
+        if (len < 0)
+            continue;
+        confirmed = 0;
+        pos = i;
+        while (confirmed < SYNC_CONFIRM) {
+            if (pos + len + (loas ? 3 : 7) > nBytes)
+                return strict ? AAC_SYNC_MOREDATA : i;
+            pos += len;
+            if (loas) {
+                len = AACGetLOASFrameLength(buf + pos);
+                if (len < 0)
+                    break; /* next header does not line up, false sync */
+                confirmed++;
+                continue;
+            }
+            len = AACGetADTSFrameLength(buf + pos);
+            if (len < 0 || buf[pos + 1] != buf[i + 1] || (buf[pos + 2] & 0xfd) != (buf[i + 2] & 0xfd) ||
+                    ((buf[pos + 3] ^ buf[i + 3]) & 0xf0))
+                break; /* next header does not line up, false sync */
+            confirmed++;
+        }
+        if (confirmed == SYNC_CONFIRM)
+            return i;
+    }
+
+    return -1;
+}
 /***********************************************************************************************************************
  * Function:    AACFindSyncWord
  *
- * Description: locate the next byte-alinged sync word in the raw AAC stream
+ * Description: locate the next valid ADTS or LOAS frame in the raw AAC stream
  *
  * Inputs:      buffer to search for sync word
  *              max number of bytes to search in buffer
@@ -1809,32 +2444,168 @@ bool AACDecoder_IsInit(void) {
  * Outputs:     none
  *
  * Return:      offset to first sync word (bytes from start of buf)
+ *              AAC_SYNC_MOREDATA if the buffer ends before the first candidate is confirmed
  *              -1 if sync not found after searching nBytes
+ *
+ * Notes:       a candidate header is only accepted if the next SYNC_CONFIRM frame headers
+ *                are found where frameLength says they should be, with the same fixed
+ *                header fields (id, profile, sample rate, channel config) for ADTS.  This prevents
+ *                locking on "sync words" in ID3 tags, album art or random data
+ *              the first candidate that is not a false sync decides: if the buffer ends
+ *                before all its headers could be checked, AAC_SYNC_MOREDATA is returned.
+ *                Call again with more data, (SYNC_CONFIRM + 1) max. frames after the
+ *                candidate are always enough
  **********************************************************************************************************************/
 int AACFindSyncWord(uint8_t *buf, int nBytes)
 {
-    int i;
-
-    /* find byte-aligned syncword (12 bits = 0xFFF) */
-    for (i = 0; i < nBytes - 1; i++) {
-        if ( (buf[i+0] & SYNCWORDH) == SYNCWORDH && (buf[i+1] & SYNCWORDL) == SYNCWORDL )
-            return i;
-    }
-
-    return -1;
+    return FindSyncWord(buf, nBytes, true);
 }
 //**************************************************************************************
+static int AACOutputChannels(AACDecInfo_t *decInfo) {
+    /* a mono stream with parametric stereo is decoded to stereo, as long as SBR is decoded */
+    if (decInfo->nChans == 1 && decInfo->sbrEnabled && decInfo->psEnabled)
+        return 2;
+    return decInfo->nChans;
+}
 int AACGetSampRate(){return m_AACDecInfo->sampRate * (m_AACDecInfo->sbrEnabled ? 2 : 1);}
-int AACGetChannels(){return m_AACDecInfo->nChans;}
+int AACGetChannels(){return AACOutputChannels(m_AACDecInfo);}
 int AACGetBitsPerSample(){return 16;}
 int AACGetID() {return m_AACDecInfo->id;} // 0-MPEG4, 1-MPEG2
 uint8_t AACGetProfile() {return (uint8_t)m_AACDecInfo->profile;} // 0-Main, 1-LC, 2-SSR, 3-reserved
-uint8_t AACGetFormat() {return (uint8_t)m_AACDecInfo->format;}   // 0-unknown 1-ADTS 2-ADIF, 3-RAW
-int AACGetOutputSamps(){return m_AACDecInfo->nChans * AAC_MAX_NSAMPS  * (m_AACDecInfo->sbrEnabled ? 2 : 1);}
+uint8_t AACGetFormat() {return (uint8_t)m_AACDecInfo->format;}   // 0-unknown 1-ADTS 2-ADIF, 3-RAW, 4-LOAS
+int AACGetLATMConfigChanges() {return m_AACDecInfo->latmConfigChanges;}
+bool AACGetParametricStereo() {return AACOutputChannels(m_AACDecInfo) > m_AACDecInfo->nChans;}
+int AACGetOutputSamps(){return AACOutputChannels(m_AACDecInfo) * AAC_MAX_NSAMPS  * (m_AACDecInfo->sbrEnabled ? 2 : 1);}
 int AACGetBitrate() {
     uint32_t br = AACGetBitsPerSample() * AACGetChannels() *  AACGetSampRate();
     return (br / m_AACDecInfo->compressionRatio);
 }
+/***********************************************************************************************************************
+ * Function:    AACDecoder_AllocateBuffers, AACFlushCodec, AACDecoder_FreeBuffers, AACSetRawBlockParams,
+ *              AACDecode, AACGet...
+ *
+ * Description: same as the functions without context, but for the decoder instance ctx instead of the default one
+ *
+ * Inputs:      pointer to decoder instance, zero-initialized before first use
+ *              other inputs as in the functions without context
+ *
+ * Notes:       the previous instance is restored on return, so these may be mixed freely with the calls
+ *                without context in the same task
+ **********************************************************************************************************************/
+bool AACDecoder_AllocateBuffers(AACDecoder_t *ctx) {
+    AACDecoder_t *prev = m_aac;
+    bool res;
+
+    m_aac = ctx;
+    res = AACDecoder_AllocateBuffers();
+    m_aac = prev;
+    return res;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int AACFlushCodec(AACDecoder_t *ctx) {
+    AACDecoder_t *prev = m_aac;
+    int err;
+
+    m_aac = ctx;
+    err = AACFlushCodec();
+    m_aac = prev;
+    return err;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void AACDecoder_FreeBuffers(AACDecoder_t *ctx) {
+    AACDecoder_t *prev = m_aac;
+
+    m_aac = ctx;
+    AACDecoder_FreeBuffers();
+    m_aac = prev;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int AACSetRawBlockParams(AACDecoder_t *ctx, int copyLast, int nChans, int sampRateCore, int profile) {
+    AACDecoder_t *prev = m_aac;
+    int err;
+
+    m_aac = ctx;
+    err = AACSetRawBlockParams(copyLast, nChans, sampRateCore, profile);
+    m_aac = prev;
+    return err;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int AACDecode(AACDecoder_t *ctx, uint8_t *inbuf, int *bytesLeft, short *outbuf) {
+    AACDecoder_t *prev = m_aac;
+    int err;
+
+    m_aac = ctx;
+    err = AACDecode(inbuf, bytesLeft, outbuf);
+    m_aac = prev;
+    return err;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int AACGetSampRate(AACDecoder_t *ctx){return ctx->AACDecInfo->sampRate * (ctx->AACDecInfo->sbrEnabled ? 2 : 1);}
+int AACGetChannels(AACDecoder_t *ctx){return AACOutputChannels(ctx->AACDecInfo);}
+int AACGetOutputSamps(AACDecoder_t *ctx){return AACOutputChannels(ctx->AACDecInfo) * AAC_MAX_NSAMPS  *
+                                                (ctx->AACDecInfo->sbrEnabled ? 2 : 1);}
+int AACGetBitrate(AACDecoder_t *ctx) {
+    uint32_t br = AACGetBitsPerSample() * AACGetChannels(ctx) *  AACGetSampRate(ctx);
+    return (br / ctx->AACDecInfo->compressionRatio);
+}
+/***********************************************************************************************************************
+ * Function:    AACDecoder_Select
+ *
+ * Description: select the decoder instance used by the functions without context in the calling task
+ *
+ * Inputs:      pointer to decoder instance, zero-initialized before first use, NULL for the default one
+ *
+ * Outputs:     none
+ *
+ * Return:      the instance selected before, NULL if that was the default one
+ *
+ * Notes:       for a task that switches between streams, like a crossfade with two decoders running at once
+ **********************************************************************************************************************/
+AACDecoder_t *AACDecoder_Select(AACDecoder_t *ctx) {
+    AACDecoder_t *prev = m_aac;
+
+    m_aac = ctx ? ctx : &m_AACDecoder;
+    return (prev == &m_AACDecoder) ? NULL : prev;
+}
+/***********************************************************************************************************************
+ * Function:    AACSetSBRBypass
+ *
+ * Description: switch SBR bypass on or off
+ *
+ * Inputs:      true to bypass SBR
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ *
+ * Notes:       with SBR bypassed the SBR fill elements of HE-AAC streams are ignored and only the core AAC
+ *                is decoded, at half the sample rate and half the number of output samples
+ *              takes effect at the next frame, so AACGetSampRate() and AACGetOutputSamps() must be read again
+ *              if set before AACDecoder_AllocateBuffers() the SBR state is not allocated
+ *              without AAC_ENABLE_SBR, SBR is always bypassed
+ **********************************************************************************************************************/
+void AACSetSBRBypass(bool on) {m_sbrBypass = (on ? 1 : 0);}
+void AACSetSBRBypass(AACDecoder_t *ctx, bool on) {ctx->sbrBypass = (on ? 1 : 0);}
+bool AACGetSBRBypass() {
+#ifdef AAC_ENABLE_SBR
+    return (m_sbrBypass != 0 || m_PSInfoSBR == NULL);
+#else
+    return true;
+#endif
+}
+/***********************************************************************************************************************
+ * Function:    AACGetProfile
+ *
+ * Description: get the number of cycles used by a stage of the decoder since the last AACResetProfile()
+ *
+ * Inputs:      stage, AAC_PROF_BITSTREAM .. AAC_PROF_SBR
+ *
+ * Outputs:     none
+ *
+ * Return:      number of cycles, always 0 without HELIX_PROFILE
+ **********************************************************************************************************************/
+uint64_t AACGetProfile(int stage) {return (stage >= 0 && stage < AAC_PROF_STAGES) ? m_prof[stage] : 0;}
+void AACResetProfile() {memset(m_prof, 0, sizeof(m_prof));}
 /**************************************************************************************
  * Function:    AACSetRawBlockParams
  *
@@ -1886,17 +2657,24 @@ int AACSetRawBlockParams(int copyLast, int nChans, int sampRateCore, int profile
  * Notes:       inbuf pointer and bytesLeft are not updated until whole frame is
  *                successfully decoded, so if ERR_AAC_INDATA_UNDERFLOW is returned
  *                just call AACDecode again with more data in inbuf
+ *              exception: LOAS frames before the first StreamMuxConfig cannot be decoded, they
+ *                are skipped and counted in bytesLeft, also when ERR_AAC_INDATA_UNDERFLOW is returned
+ *              LOAS payloads are realigned in place, so inbuf is modified for that format
  **********************************************************************************************************************/
 int AACDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf)
 {
-    int err, offset, bitOffset, bitsAvail;
+    int err, offset, bitOffset, bitsAvail, frameLength, payloadLength;
     int ch, baseChan, elementChans;
-    uint8_t *inptr;
+    uint8_t *inptr, *payload, *frameEnd = NULL;
+    HELIX_PROF_T(prof);
 
 #ifdef AAC_ENABLE_SBR
     int baseChanSBR, elementChansSBR;
 #endif
 
+    if (!m_AACDecInfo)
+        return ERR_AAC_NULL_POINTER;
+
     /* make local copies (see "Notes" above) */
     inptr = inbuf;
     bitOffset = 0;
@@ -1914,15 +2692,21 @@ int AACDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf)
             if (err)
                 return err;
         } else {
-            /* assume ADTS by default */
-            m_AACDecInfo->format = AAC_FF_ADTS;
+            /* ADTS or LOAS, depending on the first header found */
+            offset = FindSyncWord(inptr, bitsAvail >> 3, false);
+            if (offset < 0)
+                return ERR_AAC_INDATA_UNDERFLOW;
+            if (AACGetLOASFrameLength(inptr + offset) > 0)
+                m_AACDecInfo->format = AAC_FF_LOAS;
+            else
+                m_AACDecInfo->format = AAC_FF_ADTS;
         }
     }
     /* if ADTS, search for start of next frame */
     if (m_AACDecInfo->format == AAC_FF_ADTS) {
         /* can have 1-4 raw data blocks per ADTS frame (header only present for first one) */
         if (m_AACDecInfo->adtsBlocksLeft == 0) {
-            offset = AACFindSyncWord(inptr, bitsAvail >> 3);
+            offset = FindSyncWord(inptr, bitsAvail >> 3, false);
             if (offset < 0)
                 return ERR_AAC_INDATA_UNDERFLOW;
             inptr += offset;
@@ -1940,6 +2724,34 @@ int AACDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf)
             }
         }
         m_AACDecInfo->adtsBlocksLeft--;
+    } else if (m_AACDecInfo->format == AAC_FF_LOAS) {
+        /* one raw data block per LOAS frame, skip frames until a StreamMuxConfig has been seen */
+        do {
+            offset = FindSyncWord(inptr, bitsAvail >> 3, false);
+            if (offset < 0) {
+                *bytesLeft -= (inptr - inbuf);
+                return ERR_AAC_INDATA_UNDERFLOW;
+            }
+            inptr += offset;
+            bitsAvail -= (offset << 3);
+
+            err = UnpackLOASFrame(inptr, bitsAvail >> 3, &frameLength, &payload, &payloadLength);
+            if (err == ERR_AAC_INDATA_UNDERFLOW)
+                *bytesLeft -= (inptr - inbuf);
+            if (err)
+                return err;
+            if (!payload) {
+                inptr += frameLength;
+                bitsAvail -= (frameLength << 3);
+            }
+        } while (!payload);
+        frameEnd = inptr + frameLength;
+        inptr = payload;
+        bitsAvail = payloadLength << 3;
+
+        err = PrepareRawBlock();
+        if (err)
+            return err;
     } else if (m_AACDecInfo->format == AAC_FF_RAW) {
         err = PrepareRawBlock();
         if (err)
@@ -1977,15 +2789,18 @@ int AACDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf)
 
             if (err)
                 return err;
+            HELIX_PROF_ADD(m_prof[AAC_PROF_BITSTREAM], prof);
 
             if (AACDequantize(ch))
                 return ERR_AAC_DEQUANT;
+            HELIX_PROF_ADD(m_prof[AAC_PROF_DEQUANT], prof);
         }
 
         /* mid-side and intensity stereo */
         if (m_AACDecInfo->currBlockID == AAC_ID_CPE) {
             if (StereoProcess())
                 return ERR_AAC_STEREO_PROCESS;
+            HELIX_PROF_ADD(m_prof[AAC_PROF_DEQUANT], prof);
         }
 
         /* PNS, TNS, inverse transform */
@@ -2003,9 +2818,11 @@ int AACDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf)
 
             if (TNSFilter(ch))
                 return ERR_AAC_TNS;
+            HELIX_PROF_ADD(m_prof[AAC_PROF_TNS], prof);
 
             if (IMDCT(ch, baseChan + ch, outbuf))
                 return ERR_AAC_IMDCT;
+            HELIX_PROF_ADD(m_prof[AAC_PROF_IMDCT], prof);
         }
 
 #ifdef AAC_ENABLE_SBR
@@ -2029,12 +2846,14 @@ int AACDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf)
             /* apply SBR */
             if (DecodeSBRData(baseChanSBR, outbuf))
                 return ERR_AAC_SBR_DATA;
+            HELIX_PROF_ADD(m_prof[AAC_PROF_SBR], prof);
 
             baseChanSBR += elementChansSBR;
         }
 #endif
 
     baseChan += elementChans;
+    HELIX_PROF_ADD(m_prof[AAC_PROF_BITSTREAM], prof);   /* remaining element parsing */
     } while (m_AACDecInfo->currBlockID != AAC_ID_END);
 
     /* byte align after each raw_data_block */
@@ -2045,6 +2864,12 @@ int AACDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf)
         if (bitsAvail < 0)
             return ERR_AAC_INDATA_UNDERFLOW;
     }
+    if (frameEnd) {
+        /* LOAS: payload must not run past its length, skip other data and fill bits */
+        if (bitsAvail < 0)
+            return ERR_AAC_INVALID_LOAS_FRAME;
+        inptr = frameEnd;
+    }
 
     m_AACDecInfo->compressionRatio = (float)(AACGetOutputSamps()) * 2 / (inptr - inbuf);
 
@@ -2506,7 +3331,8 @@ int DecodeFillElement()
      */
     if (m_PSInfoBase->fillCount > 0) {
         m_AACDecInfo->fillExtType = (int)((m_PSInfoBase->fillBuf[0] >> 4) & 0x0f);
-        if (m_AACDecInfo->fillExtType == EXT_SBR_DATA || m_AACDecInfo->fillExtType == EXT_SBR_DATA_CRC)
+        if ((m_AACDecInfo->fillExtType == EXT_SBR_DATA || m_AACDecInfo->fillExtType == EXT_SBR_DATA_CRC) &&
+            !m_sbrBypass && m_PSInfoSBR)
             m_AACDecInfo->sbrEnabled = 1;
     }
 #endif
@@ -2607,7 +3433,7 @@ int DecodeNextElement(uint8_t **buf, int *bitOffset, int *bitsAvail)
  *              normalization by -1/N is rolled into tables here (see trigtabs.c)
  *              uses 3-mul, 3-add butterflies instead of 4-mul, 2-add
  **********************************************************************************************************************/
-void PreMultiply(int tabidx, int *zbuf1)
+void HELIX_IRAM PreMultiply(int tabidx, int *zbuf1)
 {
     int i, nmdct, ar1, ai1, ar2, ai2, z1, z2;
     int t, cms2, cps2a, sin2a, cps2b, sin2b;
@@ -2667,7 +3493,7 @@ void PreMultiply(int tabidx, int *zbuf1)
  * Notes:       minimum 1 GB in, 2 GB out - gains 2 int bits
  *              uses 3-mul, 3-add butterflies instead of 4-mul, 2-add
  **********************************************************************************************************************/
-void PostMultiply(int tabidx, int *fft1)
+void HELIX_IRAM PostMultiply(int tabidx, int *fft1)
 {
     int i, nmdct, ar1, ai1, ar2, ai2, skipFactor;
     int t, cms2, cps2, sin2;
@@ -2889,7 +3715,7 @@ void DCT4(int tabidx, int *coef, int gb)
  *
  * Return:      none
  **********************************************************************************************************************/
-void BitReverse(int *inout, int tabidx)
+void HELIX_IRAM BitReverse(int *inout, int tabidx)
 {
     int *part0, *part1;
     int a,b, t;
@@ -2938,7 +3764,7 @@ void BitReverse(int *inout, int tabidx)
  * Notes:       assumes 2 guard bits, gains no integer bits,
  *                guard bits out = guard bits in - 2
  **********************************************************************************************************************/
-void R4FirstPass(int *x, int bg)
+void HELIX_IRAM R4FirstPass(int *x, int bg)
 {
     int ar, ai, br, bi, cr, ci, dr, di;
 
@@ -2984,7 +3810,7 @@ void R4FirstPass(int *x, int bg)
  *                or guard bits in - 2 (if inputs bounded to +/- sqrt(2)/2)
  *              see scaling comments in code
  **********************************************************************************************************************/
-void R8FirstPass(int *x, int bg)
+void HELIX_IRAM R8FirstPass(int *x, int bg)
 {
     int ar, ai, br, bi, cr, ci, dr, di;
     int sr, si, tr, ti, ur, ui, vr, vi;
@@ -3089,7 +3915,7 @@ void R8FirstPass(int *x, int bg)
  *              gbOut = gbIn - 1 (short block) or gbIn - 2 (long block)
  *              uses 3-mul, 3-add butterflies instead of 4-mul, 2-add
  **********************************************************************************************************************/
-void R4Core(int *x, int bg, int gp, int *wtab)
+void HELIX_IRAM R4Core(int *x, int bg, int gp, int *wtab)
 {
     int ar, ai, br, bi, cr, ci, dr, di, tr, ti;
     int wd, ws, wi;
@@ -3203,7 +4029,7 @@ void R4Core(int *x, int bg, int gp, int *wtab)
  *              gains log2(nfft) - 2 int bits total
  *                so gain 7 int bits (LONG), 4 int bits (SHORT)
  **********************************************************************************************************************/
-void R4FFT(int tabidx, int *x)
+void HELIX_IRAM R4FFT(int tabidx, int *x)
 {
     int order = nfftlog2Tab[tabidx];
     int nfft = nfftTab[tabidx];
@@ -4134,6 +4960,11 @@ void DecodeSectionData(int winSequence, int numWinGrp, int maxSFB, uint8_t *sfbC
                 sectLenIncr = GetBits(sectLenBits);
                 sectLen += sectLenIncr;
             } while (sectLenIncr == sectEscapeVal);
+            if (sectLen == 0 || sfb + sectLen > maxSFB) {
+                /* corrupt data, would never end at maxSFB (zero bits are read past the end of the frame) */
+                sectLen = maxSFB - sfb;
+                cb = 0;
+            }
 
             sfb += sectLen;
             while (sectLen--)
@@ -4448,6 +5279,8 @@ int DecodeNoiselessData(uint8_t **buf, int *bitOffset, int *bitsAvail, int ch)
     *buf += ((bitsUsed + *bitOffset) >> 3);
     *bitOffset = ((bitsUsed + *bitOffset) & 0x07);
     *bitsAvail -= bitsUsed;
+    if (*bitsAvail < 0)
+        return ERR_AAC_INDATA_UNDERFLOW;
 
     m_AACDecInfo->sbDeinterleaveReqd[ch] = 0;
     m_AACDecInfo->tnsUsed |= m_PSInfoBase->tnsInfo[ch].tnsDataPresent;    /* set flag if TNS used for any channel */
@@ -4876,6 +5709,237 @@ int PrepareRawBlock()
     return ERR_AAC_NONE;
 }
 
+/***********************************************************************************************************************
+* Function:    LatmGetValue
+*
+* Description: read a LatmGetValue() field (ISO/IEC 14496-3, 1.7.3)
+*
+* Inputs:      bitstream positioned at the field
+*
+* Outputs:     updated bitstream
+*
+* Return:      value, 1 to 4 bytes
+***********************************************************************************************************************/
+unsigned int LatmGetValue()
+{
+    unsigned int value = 0;
+    int i, bytesForValue;
+
+    bytesForValue = GetBits(2);
+    for (i = 0; i <= bytesForValue; i++)
+        value = (value << 8) | GetBits(8);
+
+    return value;
+}
+
+/***********************************************************************************************************************
+* Function:    UnpackAudioSpecificConfig
+*
+* Description: parse the AudioSpecificConfig of a LATM StreamMuxConfig
+*
+* Inputs:      bitstream positioned at the start of the AudioSpecificConfig
+*
+* Outputs:     sample rate index of the AAC core
+*              number of channels
+*              updated bitstream
+*
+* Return:      0 if successful, error code (< 0) if error
+*
+* Notes:       only AAC LC with 1024 sample frames and channel configuration 1 or 2 is supported
+*              explicitly signalled SBR and PS (object types 5 and 29) are accepted, the LC core
+*                is decoded and SBR is found in the fill elements as with ADTS
+***********************************************************************************************************************/
+int UnpackAudioSpecificConfig(int *sampRateIdx, int *nChans)
+{
+    int aot;
+
+    aot = GetBits(5);                                   /* audioObjectType */
+    if (aot == 31)
+        aot = 32 + GetBits(6);
+    *sampRateIdx = GetBits(4);
+    if (*sampRateIdx == 0x0f)                           /* explicit sample rate */
+        return ERR_AAC_LATM_UNSUPPORTED;
+    *nChans = GetBits(4);                               /* channelConfiguration */
+    if (aot == 5 || aot == 29) {
+        if (GetBits(4) == 0x0f)                         /* extensionSamplingFrequencyIndex */
+            GetBits(24);
+        aot = GetBits(5);
+        if (aot == 31)
+            aot = 32 + GetBits(6);
+    }
+    if (aot != AAC_PROFILE_LC + 1 || *sampRateIdx >= NUM_SAMPLE_RATES || *nChans < 1 || *nChans > AAC_MAX_NCHANS)
+        return ERR_AAC_LATM_UNSUPPORTED;
+
+    /* GASpecificConfig */
+    if (GetBits(1))                                     /* frameLengthFlag, 960 sample frames */
+        return ERR_AAC_LATM_UNSUPPORTED;
+    if (GetBits(1))                                     /* dependsOnCoreCoder */
+        GetBits(14);                                    /* coreCoderDelay */
+    GetBits(1);                                         /* extensionFlag, 0 for AAC LC */
+
+    return ERR_AAC_NONE;
+}
+
+/***********************************************************************************************************************
+* Function:    UnpackStreamMuxConfig
+*
+* Description: parse a LATM StreamMuxConfig and switch the decoder to its AudioSpecificConfig
+*
+* Inputs:      bitstream positioned after useSameStreamMux
+*              pointer to the start of the AudioMuxElement (for the length of the AudioSpecificConfig)
+*
+* Outputs:     updated state variables in aacDecInfo
+*              updated bitstream
+*
+* Return:      0 if successful, error code (< 0) if error
+*
+* Notes:       one program with one layer, all streams with the same time framing and one subframe,
+*                which is what DVB and internet radio LATM streams use
+*              a changed configuration (sample rate, channels) is applied without a full reset:
+*                only the overlap buffers and the SBR state are flushed
+***********************************************************************************************************************/
+int UnpackStreamMuxConfig(uint8_t *start)
+{
+    int err, audioMuxVersion, ascLen, bitsUsed, sampRateIdx, nChans, config, esc;
+
+    audioMuxVersion = GetBits(1);
+    if (audioMuxVersion) {
+        if (GetBits(1))                                 /* audioMuxVersionA */
+            return ERR_AAC_LATM_UNSUPPORTED;
+        LatmGetValue();                                 /* taraBufferFullness */
+    }
+    if (GetBits(1) != 1 || GetBits(6) != 0 ||           /* allStreamsSameTimeFraming, numSubFrames */
+        GetBits(4) != 0 || GetBits(3) != 0)             /* numProgram, numLayer */
+        return ERR_AAC_LATM_UNSUPPORTED;
+
+    ascLen = 0;
+    if (audioMuxVersion)
+        ascLen = LatmGetValue();
+    bitsUsed = CalcBitsUsed(start, 0);
+    err = UnpackAudioSpecificConfig(&sampRateIdx, &nChans);
+    if (err)
+        return err;
+    if (audioMuxVersion) {
+        bitsUsed = CalcBitsUsed(start, 0) - bitsUsed;
+        if (bitsUsed > ascLen || CalcBitsUsed(start, 0) + ascLen - bitsUsed > 8 * LOAS_HEADER_BYTES)
+            return ERR_AAC_INVALID_LOAS_FRAME;
+        for (ascLen -= bitsUsed; ascLen > 0; ascLen -= 16)   /* fillBits, backward compatible extensions */
+            GetBits(MIN(ascLen, 16));
+    }
+
+    if (GetBits(3) != 0)                                /* frameLengthType, only variable length payloads */
+        return ERR_AAC_LATM_UNSUPPORTED;
+    GetBits(8);                                         /* latmBufferFullness */
+    if (GetBits(1)) {                                   /* otherDataPresent */
+        if (audioMuxVersion) {
+            LatmGetValue();                             /* otherDataLenBits */
+        } else {
+            do {
+                esc = GetBits(1);
+                GetBits(8);
+            } while (esc && CalcBitsUsed(start, 0) < 8 * LOAS_HEADER_BYTES);
+        }
+    }
+    if (GetBits(1))                                     /* crcCheckPresent */
+        GetBits(8);                                     /* crcCheckSum */
+
+    /* switch to the new configuration, keep the decoder buffers */
+    config = (sampRateIdx << 4) | nChans;
+    if (config != m_AACDecInfo->latmConfig) {
+        if (m_AACDecInfo->latmConfig) {
+            AACFlushCodec();
+#ifdef AAC_ENABLE_SBR
+            if (m_PSInfoSBR)
+                InitSBRState();
+#endif
+            m_AACDecInfo->psEnabled = 0;
+            m_AACDecInfo->latmConfigChanges++;
+        }
+        err = SetRawBlockParams(0, nChans, sampRateTab[sampRateIdx], AAC_PROFILE_LC);
+        if (err)
+            return err;
+        m_AACDecInfo->latmConfig = config;
+        log_i("LATM config: %d Hz, %d channel(s)", m_AACDecInfo->sampRate, m_AACDecInfo->nChans);
+    }
+
+    return ERR_AAC_NONE;
+}
+
+/***********************************************************************************************************************
+* Function:    UnpackLOASFrame
+*
+* Description: parse the header of a LOAS frame (AudioSyncStream with an AudioMuxElement(1)) and locate the payload
+*
+* Inputs:      pointer to the LOAS syncword
+*              number of valid bytes in buf
+*
+* Outputs:     number of bytes in the frame
+*              pointer to the byte aligned raw data block, NULL if the frame has to be skipped
+*                because no StreamMuxConfig was seen yet
+*              number of bytes in the raw data block
+*
+* Return:      0 if successful, error code (< 0) if error
+*
+* Notes:       the payload starts at an arbitrary bit position, it is shifted in place to the
+*                start of the AudioMuxElement, so buf is modified
+*              the header is parsed from a zero-padded copy, the bitstream reader must not run
+*                past the end of a (corrupt) short frame
+***********************************************************************************************************************/
+int UnpackLOASFrame(uint8_t *buf, int nBytes, int *frameLength, uint8_t **payload, int *payloadLength)
+{
+    uint8_t hdr[LOAS_HEADER_BYTES + 16];
+    uint8_t *p;
+    int err, len, tmp, bitsUsed, shift, i, n;
+
+    *payload = NULL;
+    if (nBytes < 3)
+        return ERR_AAC_INDATA_UNDERFLOW;
+    len = AACGetLOASFrameLength(buf);
+    if (len < 0)
+        return ERR_AAC_INVALID_LOAS_FRAME;
+    if (len > nBytes)
+        return ERR_AAC_INDATA_UNDERFLOW;
+    *frameLength = len;
+    buf += 3;
+    len -= 3;
+
+    n = MIN(len, LOAS_HEADER_BYTES);
+    memcpy(hdr, buf, n);
+    memset(hdr + n, 0, sizeof(hdr) - n);
+    SetBitstreamPointer(sizeof(hdr), hdr);
+
+    /* AudioMuxElement(muxConfigPresent = 1) */
+    if (GetBits(1) == 0) {                              /* useSameStreamMux */
+        err = UnpackStreamMuxConfig(hdr);
+        if (err)
+            return err;
+    }
+    if (m_AACDecInfo->latmConfig == 0)
+        return ERR_AAC_NONE;
+
+    /* PayloadLengthInfo, one layer with frameLengthType 0 */
+    *payloadLength = 0;
+    do {
+        tmp = GetBits(8);
+        *payloadLength += tmp;
+    } while (tmp == 255 && CalcBitsUsed(hdr, 0) < 8 * n);
+    bitsUsed = CalcBitsUsed(hdr, 0);
+    if (tmp == 255 || bitsUsed > 8 * n || bitsUsed + 8 * *payloadLength > 8 * len)
+        return ERR_AAC_INVALID_LOAS_FRAME;
+
+    /* PayloadMux, move the raw data block to a byte boundary */
+    p = buf + (bitsUsed >> 3);
+    shift = bitsUsed & 0x07;
+    if (shift) {
+        for (i = 0; i < *payloadLength; i++)
+            buf[i] = (p[i] << shift) | (p[i + 1] >> (8 - shift));
+        p = buf;
+    }
+    *payload = p;
+
+    return ERR_AAC_NONE;
+}
+
 /***********************************************************************************************************************
  * Function:    DequantBlock
  *
@@ -6444,7 +7508,7 @@ void InitSBRState() {
 
     /* clear SBR state structure */
     c = (uint8_t *)m_PSInfoSBR;
-    for (i = 0; i < (int)sizeof(m_PSInfoSBR); i++)
+    for (i = 0; i < (int)sizeof(PSInfoSBR_t); i++)
         *c++ = 0;
 
     /* initialize non-zero state variables */
@@ -6536,6 +7600,7 @@ int DecodeSBRBitstream(int chBase) {
  *              initialized state structs (SBRHdr, SBRGrid, SBRFreq, SBRChan)
  *
  * Outputs:     2048 samples of decoded 16-bit PCM, after SBR
+ *              2048 stereo pairs for a mono stream with parametric stereo (AAC_ENABLE_PS)
  *
  * Return:      0 if successful, error code (< 0) if error
  **********************************************************************************************************************/
@@ -6582,6 +7647,12 @@ int DecodeSBRData(int chBase, short *outbuf) {
         sbrFreq->numQMFBands = 0;
     }
 
+#ifdef AAC_ENABLE_PS
+    /* mono element with parametric stereo, synthesis of left and right channel */
+    int psOut = (m_AACDecInfo->psEnabled && chBlock == 1 && m_AACDecInfo->currBlockID == AAC_ID_FIL &&
+                 m_AACDecInfo->nChans == 1);
+#endif
+
     for(ch = 0; ch < chBlock; ch++) {
         sbrGrid = &(m_PSInfoSBR->sbrGrid[chBase + ch]);
         sbrChan = &(m_PSInfoSBR->sbrChan[chBase + ch]);
@@ -6613,6 +7684,13 @@ int DecodeSBRData(int chBase, short *outbuf) {
             qmfsBands = 32;
             for(l = 0; l < 32; l++) {
                 /* step 4 - synthesis QMF */
+#ifdef AAC_ENABLE_PS
+                if(psOut) {
+                    SynthesisPS(l, qmfsBands, 0, outptr);
+                    outptr += 128;
+                    continue;
+                }
+#endif
                 QMFSynthesis(m_PSInfoSBR->XBuf[l + HF_ADJ][0], m_PSInfoSBR->delayQMFS[chBase + ch],
                         &(m_PSInfoSBR->delayIdxQMFS[chBase + ch]), qmfsBands, outptr, m_AACDecInfo->nChans);
                 outptr += 64 * m_AACDecInfo->nChans;
@@ -6646,9 +7724,21 @@ int DecodeSBRData(int chBase, short *outbuf) {
             AdjustHighFreq(sbrHdr, sbrGrid, sbrFreq, sbrChan, ch);
 
             /* step 4 - synthesis QMF */
+#ifdef AAC_ENABLE_PS
+            if(psOut && m_PSInfoSBR->ps.start)
+                StartPSFrame(MAX(sbrFreq->kStartPrev + sbrFreq->numQMFBandsPrev,
+                                 sbrFreq->kStart + sbrFreq->numQMFBands));
+#endif
             qmfsBands = sbrFreq->kStartPrev + sbrFreq->numQMFBandsPrev;
             for(l = 0; l < sbrGrid->envTimeBorder[0]; l++) {
                 /* if new envelope starts mid-frame, use old settings until start of first envelope in this frame */
+#ifdef AAC_ENABLE_PS
+                if(psOut) {
+                    SynthesisPS(l, qmfsBands, 1, outptr);
+                    outptr += 128;
+                    continue;
+                }
+#endif
                 QMFSynthesis(m_PSInfoSBR->XBuf[l + HF_ADJ][0], m_PSInfoSBR->delayQMFS[chBase + ch],
                         &(m_PSInfoSBR->delayIdxQMFS[chBase + ch]), qmfsBands, outptr, m_AACDecInfo->nChans);
                 outptr += 64 * m_AACDecInfo->nChans;
@@ -6657,11 +7747,21 @@ int DecodeSBRData(int chBase, short *outbuf) {
             qmfsBands = sbrFreq->kStart + sbrFreq->numQMFBands;
             for(; l < 32; l++) {
                 /* use new settings for rest of frame (usually the entire frame, unless the first envelope starts mid-frame) */
+#ifdef AAC_ENABLE_PS
+                if(psOut) {
+                    SynthesisPS(l, qmfsBands, 1, outptr);
+                    outptr += 128;
+                    continue;
+                }
+#endif
                 QMFSynthesis(m_PSInfoSBR->XBuf[l + HF_ADJ][0], m_PSInfoSBR->delayQMFS[chBase + ch],
                         &(m_PSInfoSBR->delayIdxQMFS[chBase + ch]), qmfsBands, outptr, m_AACDecInfo->nChans);
                 outptr += 64 * m_AACDecInfo->nChans;
             }
         }
+#ifdef AAC_ENABLE_PS
+        if(psOut) EndPSFrame();
+#endif
 
         /* save delay */
         for(l = 0; l < HF_GEN; l++) {
@@ -9419,7 +10519,7 @@ void PostMultiply64(int *fft1, int nSampsOut) {
  * Notes:       this is carefully written to be efficient on ARM
  *              use the assembly code version in sbrqmfak.s when building for ARM!
  **********************************************************************************************************************/
-void QMFAnalysisConv(int *cTab, int *delay, int dIdx, int *uBuf) {
+void HELIX_IRAM QMFAnalysisConv(int *cTab, int *delay, int dIdx, int *uBuf) {
 
     int k, dOff;
     int *cPtr0, *cPtr1;
@@ -9577,7 +10677,7 @@ int QMFAnalysis(int *inbuf, int *delay, int *XBuf, int fBitsIn, int *delayIdx, i
  * Notes:       this is carefully written to be efficient on ARM
  *              use the assembly code version in sbrqmfsk.s when building for ARM!
  **********************************************************************************************************************/
-void QMFSynthesisConv(int *cPtr, int *delay, int dIdx, short *outbuf, int nChans) {
+void HELIX_IRAM QMFSynthesisConv(int *cPtr, int *delay, int dIdx, short *outbuf, int nChans) {
 
     int k, dOff0, dOff1;
     U64 sum64;
@@ -10078,13 +11178,16 @@ void CopyCouplingInverseFilterMode(int numNoiseFloorBands, uint8_t *modeLeft, ui
  *                frequency tables)
  *              base output channel (range = [0, nChans-1])
  *
- * Outputs:     updated PSInfoSBR struct (SBRGrid and SBRChan)
+ * Outputs:     updated PSInfoSBR struct (SBRGrid and SBRChan, parametric stereo data with AAC_ENABLE_PS)
  *
  * Return:      none
  **********************************************************************************************************************/
 void UnpackSBRSingleChannel(int chBase) {
 
     int bitsLeft;
+#ifdef AAC_ENABLE_PS
+    int extId, n;
+#endif
     SBRHeader *sbrHdr = &(m_PSInfoSBR->sbrHdr[chBase]);
     SBRGrid *sbrGridL = &(m_PSInfoSBR->sbrGrid[chBase + 0]);
     SBRFreq *sbrFreq = &(m_PSInfoSBR->sbrFreq[chBase]);
@@ -10110,11 +11213,26 @@ void UnpackSBRSingleChannel(int chBase) {
 
         bitsLeft = 8 * m_PSInfoSBR->extendedDataSize;
 
+#ifdef AAC_ENABLE_PS
+        /* parametric stereo, other extensions (and padding) end the list */
+        while(bitsLeft > 7) {
+            extId = GetBits(2);
+            bitsLeft -= 2;
+            if(extId != EXTENSION_ID_PS) break;
+            bitsLeft -= UnpackPSData(bitsLeft);
+        }
+        while(bitsLeft > 0) {
+            n = MIN(bitsLeft, 16);
+            GetBits(n);
+            bitsLeft -= n;
+        }
+#else
         /* get ID, unpack extension info, do whatever is necessary with it... */
         while(bitsLeft > 0) {
             GetBits(8);
             bitsLeft -= 8;
         }
+#endif
     }
 }
 /***********************************************************************************************************************
@@ -10202,3 +11320,628 @@ void UnpackSBRChannelPair(int chBase) {
         }
     }
 }
+
+#ifdef AAC_ENABLE_PS
+/***********************************************************************************************************************
+ * Function:    DecodePSSymbol
+ *
+ * Description: decode one Huffman coded IID or ICC delta (tables 8.B.1 to 8.B.6)
+ *
+ * Inputs:      table index (0/1 = fine IID df/dt, 2/3 = coarse IID df/dt, 4/5 = ICC df/dt)
+ *
+ * Outputs:     none
+ *
+ * Return:      decoded delta value
+ *
+ * Notes:       the fine IID codes are not canonical, so DecodeHuffmanScalar() can not be used
+ *              the codes are searched shortest first, the longest code has 20 bits
+ **********************************************************************************************************************/
+int DecodePSSymbol(int tab) {
+
+    int i, len;
+    uint32_t bitBuf, e;
+    const uint32_t *huffTab = psHuffTab[tab];
+
+    bitBuf = GetBitsNoAdvance(20);
+    for (i = 0; i < psHuffTabSize[tab]; i++) {
+        e = huffTab[i];
+        len = e >> 27;
+        if ((bitBuf >> (20 - len)) == (e & 0xfffff)) {
+            AdvanceBitstream(len);
+            return (int)((e >> 20) & 0x7f) - psHuffOffset[tab];
+        }
+    }
+    return 0;   /* not reached, the code tables are complete */
+}
+/***********************************************************************************************************************
+ * Function:    UnpackPSPar
+ *
+ * Description: unpack the IID or ICC parameters of one envelope
+ *
+ * Inputs:      parameter array [envelope][band]
+ *              number of parameters
+ *              envelope index
+ *              1 if delta coded in time, 0 if delta coded in frequency
+ *              Huffman table index for DecodePSSymbol()
+ *              range of valid values
+ *
+ * Outputs:     parameters of the envelope
+ *
+ * Return:      0 if successful, error code (< 0) if a value is out of range
+ *
+ * Notes:       delta time coding of the first envelope refers to the last envelope of the previous frame
+ **********************************************************************************************************************/
+int UnpackPSPar(int8_t (*par)[34], int nPar, int env, int dt, int tab, int minVal, int maxVal) {
+
+    int b, val, envPrev;
+
+    envPrev = env ? env - 1 : m_PSInfoSBR->ps.numEnvOld - 1;
+    if (envPrev < 0) envPrev = 0;
+
+    val = 0;
+    for (b = 0; b < nPar; b++) {
+        if (dt)
+            val = par[envPrev][b] + DecodePSSymbol(tab);
+        else
+            val += DecodePSSymbol(tab);
+        if (val < minVal || val > maxVal)
+            return ERR_AAC_SBR_BITSTREAM;
+        par[env][b] = val;
+    }
+    return ERR_AAC_NONE;
+}
+/***********************************************************************************************************************
+ * Function:    UnpackPSData
+ *
+ * Description: unpack the parametric stereo extension of a single channel SBR element (ps_data(), table 8.1)
+ *
+ * Inputs:      number of bits left in the SBR extension
+ *
+ * Outputs:     updated PSInfoPS struct
+ *              psEnabled in AACDecInfo set after the first PS header in a mono stream
+ *
+ * Return:      number of bits used, all bits left if the data is invalid
+ *
+ * Notes:       baseline decoder: the IPD/OPD extension is skipped
+ *              if the last envelope does not end at the last QMF slot, an envelope with the same parameters
+ *                is added up to the end of the frame
+ *              invalid data clears the parameters and stops PS processing until the next PS header
+ **********************************************************************************************************************/
+int UnpackPSData(int bitsLeft) {
+
+    int e, b, n, mode, header, frameClass, dt, source, bitsStart, bitsUsed, extBits, maxIID;
+    PSInfoPS_t *ps = &(m_PSInfoSBR->ps);
+
+    bitsStart = CalcBitsUsed(m_AACDecInfo->fillBuf, 0);
+
+    header = GetBits(1);
+    if (header) {
+        ps->enableIID = GetBits(1);
+        if (ps->enableIID) {
+            mode = GetBits(3);
+            if (mode > 5) goto psError;
+            ps->nrIIDPar = psNrParTab[mode];
+            ps->iidQuant = (mode > 2);
+        }
+        ps->enableICC = GetBits(1);
+        if (ps->enableICC) {
+            mode = GetBits(3);
+            if (mode > 5) goto psError;
+            ps->nrICCPar = psNrParTab[mode];
+            ps->iccMode = mode;
+        }
+        ps->enableExt = GetBits(1);
+    }
+
+    frameClass = GetBits(1);
+    ps->numEnvOld = ps->numEnv;
+    ps->numEnv = psNumEnvTab[frameClass][GetBits(2)];
+    ps->borderPos[0] = -1;
+    for (e = 1; e <= ps->numEnv; e++) {
+        if (frameClass) {
+            ps->borderPos[e] = GetBits(5);
+            if (ps->borderPos[e] < ps->borderPos[e - 1]) goto psError;
+        }
+        else {
+            ps->borderPos[e] = e * 32 / ps->numEnv - 1;
+        }
+    }
+
+    maxIID = 7 + 8 * ps->iidQuant;
+    if (ps->enableIID) {
+        for (e = 0; e < ps->numEnv; e++) {
+            dt = GetBits(1);
+            if (UnpackPSPar(ps->iidPar, ps->nrIIDPar, e, dt, (ps->iidQuant ? 0 : 2) + dt, -maxIID, maxIID))
+                goto psError;
+        }
+    }
+    else {
+        memset(ps->iidPar, 0, sizeof(ps->iidPar));
+    }
+    if (ps->enableICC) {
+        for (e = 0; e < ps->numEnv; e++) {
+            dt = GetBits(1);
+            if (UnpackPSPar(ps->iccPar, ps->nrICCPar, e, dt, 4 + dt, 0, 7))
+                goto psError;
+        }
+    }
+    else {
+        memset(ps->iccPar, 0, sizeof(ps->iccPar));
+    }
+
+    if (ps->enableExt) {
+        extBits = GetBits(4);
+        if (extBits == 15) extBits += GetBits(8);
+        for (extBits *= 8; extBits > 0; extBits -= n) {
+            n = MIN(extBits, 16);
+            GetBits(n);
+        }
+    }
+
+    /* add an envelope up to the end of the frame, parameters copied from the last one */
+    if (ps->numEnv == 0 || ps->borderPos[ps->numEnv] < 31) {
+        source = ps->numEnv ? ps->numEnv - 1 : ps->numEnvOld - 1;
+        if (source >= 0 && source != ps->numEnv) {
+            if (ps->enableIID) memcpy(ps->iidPar[ps->numEnv], ps->iidPar[source], sizeof(ps->iidPar[0]));
+            if (ps->enableICC) memcpy(ps->iccPar[ps->numEnv], ps->iccPar[source], sizeof(ps->iccPar[0]));
+        }
+        /* the copy may come from a frame with other quantization */
+        for (b = 0; b < ps->nrIIDPar && ps->enableIID; b++)
+            if (ps->iidPar[ps->numEnv][b] < -maxIID || ps->iidPar[ps->numEnv][b] > maxIID) goto psError;
+        for (b = 0; b < ps->nrICCPar && ps->enableICC; b++)
+            if (ps->iccPar[ps->numEnv][b] < 0 || ps->iccPar[ps->numEnv][b] > 7) goto psError;
+        ps->numEnv++;
+        ps->borderPos[ps->numEnv] = 31;
+    }
+
+    if (header) ps->start = 1;
+
+    bitsUsed = CalcBitsUsed(m_AACDecInfo->fillBuf, 0) - bitsStart;
+    if (bitsUsed <= bitsLeft) {
+        if (ps->start && m_AACDecInfo->nChans == 1) m_AACDecInfo->psEnabled = 1;
+        return bitsUsed;
+    }
+
+psError:
+    ps->start = 0;
+    memset(ps->iidPar, 0, sizeof(ps->iidPar));
+    memset(ps->iccPar, 0, sizeof(ps->iccPar));
+    for (n = bitsLeft - (CalcBitsUsed(m_AACDecInfo->fillBuf, 0) - bitsStart); n > 0; n -= 16)
+        GetBits(MIN(n, 16));
+    return bitsLeft;
+}
+/***********************************************************************************************************************
+ * Function:    MapPSPar
+ *
+ * Description: map 10 or 34 IID or ICC parameters to the 20 stereo bands of the baseline decoder
+ *
+ * Inputs:      parameters of one envelope
+ *              number of parameters (10, 20 or 34)
+ *
+ * Outputs:     20 parameters
+ *
+ * Return:      none
+ **********************************************************************************************************************/
+void MapPSPar(int8_t *parMapped, const int8_t *par, int nPar) {
+
+    int b;
+
+    if (nPar == 34) {
+        parMapped[ 0] = (2 * par[ 0] + par[ 1]) / 3;
+        parMapped[ 1] = (par[ 1] + 2 * par[ 2]) / 3;
+        parMapped[ 2] = (2 * par[ 3] + par[ 4]) / 3;
+        parMapped[ 3] = (par[ 4] + 2 * par[ 5]) / 3;
+        parMapped[ 4] = (par[ 6] + par[ 7]) / 2;
+        parMapped[ 5] = (par[ 8] + par[ 9]) / 2;
+        parMapped[ 6] = par[10];
+        parMapped[ 7] = par[11];
+        parMapped[ 8] = (par[12] + par[13]) / 2;
+        parMapped[ 9] = (par[14] + par[15]) / 2;
+        parMapped[10] = par[16];
+        parMapped[11] = par[17];
+        parMapped[12] = par[18];
+        parMapped[13] = par[19];
+        parMapped[14] = (par[20] + par[21]) / 2;
+        parMapped[15] = (par[22] + par[23]) / 2;
+        parMapped[16] = (par[24] + par[25]) / 2;
+        parMapped[17] = (par[26] + par[27]) / 2;
+        parMapped[18] = (par[28] + par[29] + par[30] + par[31]) / 4;
+        parMapped[19] = (par[32] + par[33]) / 2;
+    }
+    else if (nPar == 10) {
+        for (b = 0; b < 10; b++)
+            parMapped[2 * b] = parMapped[2 * b + 1] = par[b];
+    }
+    else {
+        for (b = 0; b < 20; b++)
+            parMapped[b] = par[b];
+    }
+}
+/***********************************************************************************************************************
+ * Function:    SetupPSEnvelope
+ *
+ * Description: look up the mixing matrix at the end of an envelope and the increment per QMF slot
+ *
+ * Inputs:      envelope index
+ *
+ * Outputs:     hCurr, hStep and hEnd in PSInfoPS struct
+ *
+ * Return:      none
+ *
+ * Notes:       the matrix is interpolated from the end of the previous envelope (zero before the first frame),
+ *                hCurr is incremented before use, so the last slot of the envelope gets the looked up value
+ **********************************************************************************************************************/
+void SetupPSEnvelope(int env) {
+
+    int b, j, t, row, width;
+    int8_t iid[20], icc[20];
+    const uint32_t (*lut)[8][4];
+    PSInfoPS_t *ps = &(m_PSInfoSBR->ps);
+
+    MapPSPar(iid, ps->iidPar[env], ps->nrIIDPar);
+    MapPSPar(icc, ps->iccPar[env], ps->nrICCPar);
+    lut = (ps->iccMode < 3) ? psMixA : psMixB;
+
+    width = ps->borderPos[env + 1] - ps->borderPos[env];
+    if (width < 1) width = 1;
+
+    for (b = 0; b < 20; b++) {
+        row = iid[b] + 7 + 23 * ps->iidQuant;
+        for (j = 0; j < 4; j++) {
+            t = (int)lut[row][icc[b]][j];
+            ps->hCurr[b][j] = ps->hEnd[b][j];
+            ps->hStep[b][j] = (t - ps->hEnd[b][j]) / width;
+            ps->hEnd[b][j] = t;
+        }
+    }
+}
+/***********************************************************************************************************************
+ * Function:    HybridAnalysisPS
+ *
+ * Description: split QMF bands 0, 1 and 2 of one slot into 10 hybrid bands
+ *
+ * Inputs:      QMF slot (range = [0, 31])
+ *              XBuf with 6 look-ahead slots, last 6 slots of the previous frame in PSInfoPS
+ *
+ * Outputs:     10 complex hybrid samples, half the scale of XBuf
+ *
+ * Return:      none
+ *
+ * Notes:       13 tap filters centred at the current slot: complex 8 band filter for QMF band 0 (bands 2 + 5 and
+ *                3 + 4 are combined), real 2 band filter for QMF bands 1 and 2
+ *              input has MIN_GBITS_IN_QMFS guard bits, so the sums of symmetric taps do not overflow
+ **********************************************************************************************************************/
+void HybridAnalysisPS(int l, int (*s)[2]) {
+
+    int i, j, q, n, re, im, reOp, imOp;
+    int x[13][2], t[8][2];
+    PSInfoPS_t *ps = &(m_PSInfoSBR->ps);
+
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < 13; j++) {
+            n = l - 6 + j;
+            if (n < 0) {
+                x[j][0] = ps->hybridDelay[i][n + 6][0];
+                x[j][1] = ps->hybridDelay[i][n + 6][1];
+            }
+            else {
+                x[j][0] = m_PSInfoSBR->XBuf[n + HF_ADJ][i][0];
+                x[j][1] = m_PSInfoSBR->XBuf[n + HF_ADJ][i][1];
+            }
+        }
+
+        if (i == 0) {
+            for (q = 0; q < 8; q++) {
+                const uint32_t (*f)[2] = psHybrid8[q];
+                re = MULSHIFT32((int)f[6][0], x[6][0]);
+                im = MULSHIFT32((int)f[6][0], x[6][1]);
+                for (j = 0; j < 6; j++) {
+                    re += MULSHIFT32((int)f[j][0], x[j][0] + x[12 - j][0]) -
+                          MULSHIFT32((int)f[j][1], x[j][1] - x[12 - j][1]);
+                    im += MULSHIFT32((int)f[j][0], x[j][1] + x[12 - j][1]) +
+                          MULSHIFT32((int)f[j][1], x[j][0] - x[12 - j][0]);
+                }
+                t[q][0] = re;
+                t[q][1] = im;
+            }
+            s[0][0] = t[6][0];           s[0][1] = t[6][1];
+            s[1][0] = t[7][0];           s[1][1] = t[7][1];
+            s[2][0] = t[0][0];           s[2][1] = t[0][1];
+            s[3][0] = t[1][0];           s[3][1] = t[1][1];
+            s[4][0] = t[2][0] + t[5][0]; s[4][1] = t[2][1] + t[5][1];
+            s[5][0] = t[3][0] + t[4][0]; s[5][1] = t[3][1] + t[4][1];
+        }
+        else {
+            re = MULSHIFT32((int)psHybrid2[6], x[6][0]);
+            im = MULSHIFT32((int)psHybrid2[6], x[6][1]);
+            reOp = imOp = 0;
+            for (j = 1; j < 6; j += 2) {
+                reOp += MULSHIFT32((int)psHybrid2[j], x[j][0] + x[12 - j][0]);
+                imOp += MULSHIFT32((int)psHybrid2[j], x[j][1] + x[12 - j][1]);
+            }
+            /* the spectrum of QMF band 1 is mirrored, so its upper half comes first */
+            q = (i == 1) ? 7 : 8;
+            s[q][0] = re + reOp;
+            s[q][1] = im + imOp;
+            q = (i == 1) ? 6 : 9;
+            s[q][0] = re - reOp;
+            s[q][1] = im - imOp;
+        }
+    }
+}
+/***********************************************************************************************************************
+ * Function:    StartPSFrame
+ *
+ * Description: prepare parametric stereo processing of a frame
+ *
+ * Inputs:      number of QMF bands with content
+ *
+ * Outputs:     delay lines above the SBR range cleared, mixing matrix of the first envelope
+ *
+ * Return:      none
+ **********************************************************************************************************************/
+void StartPSFrame(int top) {
+
+    int k;
+    PSInfoPS_t *ps = &(m_PSInfoSBR->ps);
+
+    for (k = top + 7; k < 71; k++) {
+        if (k < 30) {
+            memset(ps->delay2[k], 0, sizeof(ps->delay2[k]));
+            memset(ps->apDelay[k], 0, sizeof(ps->apDelay[k]));
+        }
+        else if (k < 42) {
+            memset(ps->delay14[k - 30], 0, sizeof(ps->delay14[k - 30]));
+        }
+        else {
+            ps->delay1[k - 42][0] = ps->delay1[k - 42][1] = 0;
+        }
+    }
+
+    ps->env = 0;
+    SetupPSEnvelope(0);
+}
+/***********************************************************************************************************************
+ * Function:    EndPSFrame
+ *
+ * Description: keep the last 6 slots of QMF bands 0, 1 and 2 for the hybrid analysis of the next frame
+ *
+ * Inputs:      XBuf of the frame
+ *
+ * Outputs:     hybridDelay in PSInfoPS struct
+ *              mixing matrix at the end of the last envelope
+ *
+ * Return:      none
+ *
+ * Notes:       envelopes of zero width at the end of the frame are not reached by ApplyPS(), but the next
+ *                frame starts from the matrix of the last one
+ **********************************************************************************************************************/
+void EndPSFrame() {
+
+    int i, j;
+    PSInfoPS_t *ps = &(m_PSInfoSBR->ps);
+
+    if (ps->start) {
+        while (ps->env + 1 < ps->numEnv)
+            SetupPSEnvelope(++ps->env);
+    }
+
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < 6; j++) {
+            ps->hybridDelay[i][j][0] = m_PSInfoSBR->XBuf[26 + j + HF_ADJ][i][0];
+            ps->hybridDelay[i][j][1] = m_PSInfoSBR->XBuf[26 + j + HF_ADJ][i][1];
+        }
+    }
+}
+/***********************************************************************************************************************
+ * Function:    ApplyPS
+ *
+ * Description: make a left and right QMF slot from the mono SBR output (baseline decoder, 8.6.4)
+ *
+ * Inputs:      QMF slot (range = [0, 31])
+ *              number of QMF bands with content (range = [0, 64])
+ *              XBuf after SBR, PSInfoPS struct prepared by StartPSFrame()
+ *
+ * Outputs:     XBufL and XBufR in PSInfoPS struct, with MIN_GBITS_IN_QMFS guard bits
+ *              updated transient detection, delay lines and mixing matrix
+ *
+ * Return:      none
+ *
+ * Notes:       hybrid analysis, decorrelation with transient attenuation, mixing with the interpolated matrix
+ *                and hybrid synthesis, per slot so no extra frame buffer is needed
+ *              the hybrid domain has half the scale of XBuf, the mixing output is clipped to keep the
+ *                guard bits of the synthesis filterbank
+ *              the complex tables are Q30, the all-pass gains Q31, the transient gain Q30 and the matrix Q29
+ **********************************************************************************************************************/
+void ApplyPS(int l, int top) {
+
+    int i, k, m, b, q, nBands, sr, si, tr, ti, nr, ni, dr, di, ag, z, r, inv;
+    int s[10][2], gain[20];
+    int *ap, *h, *xl, *xr;
+    int64_t p, peak, smooth, denom, power[20];
+    PSInfoPS_t *ps = &(m_PSInfoSBR->ps);
+    int *xbuf = m_PSInfoSBR->XBuf[l + HF_ADJ][0];
+
+    /* mixing matrix of this slot */
+    while (ps->env + 1 < ps->numEnv && l > ps->borderPos[ps->env + 1])
+        SetupPSEnvelope(++ps->env);
+    for (b = 0; b < 20; b++) {
+        for (i = 0; i < 4; i++)
+            ps->hCurr[b][i] += ps->hStep[b][i];
+    }
+
+    nBands = top + 7;
+    HybridAnalysisPS(l, s);
+
+    /* power per stereo band */
+    memset(power, 0, sizeof(power));
+    for (k = 0; k < nBands; k++) {
+        if (k < 10) {
+            sr = s[k][0];
+            si = s[k][1];
+        }
+        else {
+            sr = xbuf[2 * (k - 7) + 0] >> 1;
+            si = xbuf[2 * (k - 7) + 1] >> 1;
+        }
+        p = MADD64(0, sr, sr);
+        p = MADD64(p, si, si);
+        power[psKToI[k]] += p >> 6;
+    }
+
+    /* transient attenuation: gain = min(1, powerSmooth / (1.5 * peakDecayDiffSmooth)) */
+    for (i = 0; i < 20; i++) {
+        p = power[i];
+        peak = (ps->peakDecayNrg[i] >> 15) * 25098;     /* peak decay factor 0.76592833836465, Q15 */
+        if (peak < p) peak = p;
+        ps->peakDecayNrg[i] = peak;
+        ps->powerSmooth[i] += (p - ps->powerSmooth[i]) >> 2;
+        ps->peakDecayDiffSmooth[i] += (peak - p - ps->peakDecayDiffSmooth[i]) >> 2;
+
+        smooth = ps->powerSmooth[i];
+        denom = ps->peakDecayDiffSmooth[i] + (ps->peakDecayDiffSmooth[i] >> 1);
+        if (denom <= smooth) {
+            gain[i] = 0x40000000;
+            continue;
+        }
+        /* normalize denom to Q31 in [0.5, 1.0), smooth < denom gets the same shift */
+        if (denom >> 31) {
+            z = 32 - CLZ((int)(denom >> 31));
+            denom >>= z;
+            smooth >>= z;
+        }
+        z = CLZ((int)denom) - 1;
+        r = (int)denom << z;
+        inv = InvRNormalized(r);                        /* Q29 */
+        gain[i] = MULSHIFT32((int)smooth << z, inv) << 2;
+    }
+
+    memset(ps->XBufL[0], 0, 3 * 2 * sizeof(int));
+    memset(ps->XBufR[0], 0, 3 * 2 * sizeof(int));
+    for (k = 0; k < nBands; k++) {
+        b = psKToI[k];
+        if (k < 10) {
+            sr = s[k][0];
+            si = s[k][1];
+        }
+        else {
+            sr = xbuf[2 * (k - 7) + 0] >> 1;
+            si = xbuf[2 * (k - 7) + 1] >> 1;
+        }
+
+        /* decorrelated signal */
+        if (k < 30) {
+            /* z^-2, fractional delay and 3 all-pass links */
+            tr = ps->delay2[k][ps->delayIdx2][0];
+            ti = ps->delay2[k][ps->delayIdx2][1];
+            ps->delay2[k][ps->delayIdx2][0] = sr;
+            ps->delay2[k][ps->delayIdx2][1] = si;
+            nr = (MULSHIFT32(tr, (int)psPhiFract[k][0]) - MULSHIFT32(ti, (int)psPhiFract[k][1])) << 2;
+            ni = (MULSHIFT32(tr, (int)psPhiFract[k][1]) + MULSHIFT32(ti, (int)psPhiFract[k][0])) << 2;
+            tr = nr;
+            ti = ni;
+            for (m = 0; m < 3; m++) {
+                ap = ps->apDelay[k][psApOffset[m] + ps->apIdx[m]];
+                ag = (int)psAllpassGain[k][m];
+                nr = ((MULSHIFT32(ap[0], (int)psQFract[k][m][0]) - MULSHIFT32(ap[1], (int)psQFract[k][m][1])) << 2) -
+                     (MULSHIFT32(ag, tr) << 1);
+                ni = ((MULSHIFT32(ap[0], (int)psQFract[k][m][1]) + MULSHIFT32(ap[1], (int)psQFract[k][m][0])) << 2) -
+                     (MULSHIFT32(ag, ti) << 1);
+                ap[0] = CLIP_2N(tr + (MULSHIFT32(ag, nr) << 1), 29);
+                ap[1] = CLIP_2N(ti + (MULSHIFT32(ag, ni) << 1), 29);
+                tr = nr;
+                ti = ni;
+            }
+        }
+        else if (k < 42) {
+            tr = ps->delay14[k - 30][ps->delayIdx14][0];
+            ti = ps->delay14[k - 30][ps->delayIdx14][1];
+            ps->delay14[k - 30][ps->delayIdx14][0] = sr;
+            ps->delay14[k - 30][ps->delayIdx14][1] = si;
+        }
+        else {
+            tr = ps->delay1[k - 42][0];
+            ti = ps->delay1[k - 42][1];
+            ps->delay1[k - 42][0] = sr;
+            ps->delay1[k - 42][1] = si;
+        }
+        dr = MULSHIFT32(gain[b], tr) << 2;
+        di = MULSHIFT32(gain[b], ti) << 2;
+
+        /* mixing: l = h11 * s + h21 * d, r = h12 * s + h22 * d */
+        h = ps->hCurr[b];
+        q = (k < 6) ? 0 : (k < 8) ? 1 : (k < 10) ? 2 : k - 7;
+        xl = ps->XBufL[q];
+        xr = ps->XBufR[q];
+        nr = CLIP_2N(MULSHIFT32(h[0], sr) + MULSHIFT32(h[2], dr), 25) << 3;
+        ni = CLIP_2N(MULSHIFT32(h[0], si) + MULSHIFT32(h[2], di), 25) << 3;
+        if (k < 10) {
+            xl[0] += nr;
+            xl[1] += ni;
+        }
+        else {
+            xl[0] = nr << 1;
+            xl[1] = ni << 1;
+        }
+        nr = CLIP_2N(MULSHIFT32(h[1], sr) + MULSHIFT32(h[3], dr), 25) << 3;
+        ni = CLIP_2N(MULSHIFT32(h[1], si) + MULSHIFT32(h[3], di), 25) << 3;
+        if (k < 10) {
+            xr[0] += nr;
+            xr[1] += ni;
+        }
+        else {
+            xr[0] = nr << 1;
+            xr[1] = ni << 1;
+        }
+    }
+
+    /* hybrid synthesis of QMF bands 0, 1 and 2, sums of up to 6 hybrid bands */
+    for (q = 0; q < 3; q++) {
+        for (i = 0; i < 2; i++) {
+            ps->XBufL[q][i] = CLIP_2N(ps->XBufL[q][i], 28) << 1;
+            ps->XBufR[q][i] = CLIP_2N(ps->XBufR[q][i], 28) << 1;
+        }
+    }
+    for (q = MAX(top, 3); q < 64; q++) {
+        ps->XBufL[q][0] = ps->XBufL[q][1] = 0;
+        ps->XBufR[q][0] = ps->XBufR[q][1] = 0;
+    }
+
+    ps->delayIdx2 ^= 1;
+    ps->delayIdx14 = (ps->delayIdx14 == 13) ? 0 : ps->delayIdx14 + 1;
+    for (m = 0; m < 3; m++)
+        ps->apIdx[m] = (ps->apIdx[m] == psApLen[m] - 1) ? 0 : ps->apIdx[m] + 1;
+}
+/***********************************************************************************************************************
+ * Function:    SynthesisPS
+ *
+ * Description: synthesis QMF of one slot for a mono SBR element with parametric stereo output
+ *
+ * Inputs:      QMF slot (range = [0, 31])
+ *              number of QMF subbands to process (range = [0, 64])
+ *              1 to apply the PS parameters, 0 to copy the mono signal to both channels
+ *              pointer to the output buffer
+ *
+ * Outputs:     64 stereo pairs of 16-bit PCM
+ *
+ * Return:      none
+ *
+ * Notes:       the right channel uses the synthesis delay buffer of the (unused) second channel
+ **********************************************************************************************************************/
+void SynthesisPS(int l, int qmfsBands, int applyPS, short *outbuf) {
+
+    int *inL, *inR;
+    HELIX_PROF_T(prof);
+
+    inL = inR = m_PSInfoSBR->XBuf[l + HF_ADJ][0];
+    if (applyPS && m_PSInfoSBR->ps.start) {
+        ApplyPS(l, qmfsBands);
+        inL = m_PSInfoSBR->ps.XBufL[0];
+        inR = m_PSInfoSBR->ps.XBufR[0];
+    }
+    QMFSynthesis(inR, m_PSInfoSBR->delayQMFS[1], &(m_PSInfoSBR->delayIdxQMFS[1]), qmfsBands, outbuf + 1, 2);
+    HELIX_PROF_ADD(m_prof[AAC_PROF_PS], prof);
+
+    QMFSynthesis(inL, m_PSInfoSBR->delayQMFS[0], &(m_PSInfoSBR->delayIdxQMFS[0]), qmfsBands, outbuf, 2);
+}
+#endif  /* AAC_ENABLE_PS */
@@ -4,9 +4,16 @@
 //#pragma GCC diagnostic ignored "-Wnarrowing"
 
 #include "Arduino.h"
+#include "codec_arena.h"
+#include "helix_placement.h"
 
 #define AAC_ENABLE_MPEG4
 //#define AAC_ENABLE_SBR  // needs additional 60KB Heap,
+//#define AAC_ENABLE_PS   // HE-AAC v2 parametric stereo, needs AAC_ENABLE_SBR and additional 8KB Heap
+
+#if defined(AAC_ENABLE_PS) && !defined(AAC_ENABLE_SBR)
+#error "AAC_ENABLE_PS needs AAC_ENABLE_SBR"
+#endif
 
 #define ASSERT(x) /* do nothing */
 
@@ -24,7 +31,8 @@ enum {
     AAC_FF_Unknown = 0,        /* should be 0 on init */
     AAC_FF_ADTS    = 1,
     AAC_FF_ADIF    = 2,
-    AAC_FF_RAW     =  3
+    AAC_FF_RAW     =  3,
+    AAC_FF_LOAS    =  4        /* LATM AudioMuxElements in a LOAS AudioSyncStream (DVB, some internet radio) */
 };
 
 /* syntactic element type */
@@ -64,9 +72,25 @@ enum {
     ERR_AAC_SBR_NCHANS_TOO_HIGH           = -20,
     ERR_AAC_SBR_SINGLERATE_UNSUPPORTED    = -21,
     ERR_AAC_RAWBLOCK_PARAMS               = -22,
+    ERR_AAC_INVALID_LOAS_FRAME            = -23,
+    ERR_AAC_LATM_UNSUPPORTED              = -24,
     ERR_AAC_UNKNOWN                       = -9999
 };
 
+enum {                  /* extra return value of AACFindSyncWord */
+    AAC_SYNC_MOREDATA                     =  -2   /* first frame not confirmed yet, search again with more data */
+};
+
+enum {                  /* decoder stages for HELIX_PROFILE */
+    AAC_PROF_BITSTREAM                    =   0,  /* headers, elements, noiseless decoding */
+    AAC_PROF_DEQUANT                      =   1,  /* dequantize, stereo processing */
+    AAC_PROF_TNS                          =   2,  /* PNS, short block deinterleave, TNS */
+    AAC_PROF_IMDCT                        =   3,  /* inverse transform */
+    AAC_PROF_SBR                          =   4,  /* SBR bitstream and synthesis */
+    AAC_PROF_PS                           =   5,  /* parametric stereo, included in AAC_PROF_SBR */
+    AAC_PROF_STAGES                       =   6
+};
+
 enum {
     SBR_GRID_FIXFIX = 0,
     SBR_GRID_FIXVAR = 1,
@@ -111,9 +135,12 @@ typedef struct _AACDecInfo_t {
     int   profile;    /* 0: Main profile, 1: LowComplexity (LC), 2: ScalableSamplingRate (SSR), 3: reserved */
     int   format;
     int   sbrEnabled;
+    int   psEnabled;  /* parametric stereo found in a mono stream, output is stereo while SBR is enabled */
     int   tnsUsed;
     int   pnsUsed;
     int   frameCount;
+    int   latmConfig;      /* LOAS: current AudioSpecificConfig (sampRateIdx << 4 | nChans), 0 if none seen yet */
+    int   latmConfigChanges;
 } AACDecInfo_t;
 
 
@@ -364,6 +391,51 @@ typedef struct _PSInfoBase_t {
     int      prevWinShape[2]; // [AAC_MAX_NCHANS]
 } PSInfoBase_t;
 
+/* parametric stereo (HE-AAC v2) state, baseline decoder with 20 stereo bands and 71 hybrid bands */
+typedef struct _PSInfoPS {
+    /* bitstream parameters, see UnpackPSData() */
+    uint8_t  start;                 /* 1 after the first PS header */
+    uint8_t  enableIID;
+    uint8_t  enableICC;
+    uint8_t  enableExt;
+    uint8_t  iidQuant;              /* 0: coarse, 1: fine IID steps */
+    uint8_t  iccMode;               /* 0..2: mixing procedure A, 3..5: mixing procedure B */
+    uint8_t  nrIIDPar;              /* 10, 20 or 34 parameters per envelope */
+    uint8_t  nrICCPar;
+    int      numEnv;                /* including the envelope added up to the end of the frame */
+    int      numEnvOld;
+    int      borderPos[6];          // [PS_MAX_NUM_ENV + 1]
+    int8_t   iidPar[5][34];         // [PS_MAX_NUM_ENV][PS_MAX_NR_IIDICC]
+    int8_t   iccPar[5][34];         // [PS_MAX_NUM_ENV][PS_MAX_NR_IIDICC]
+
+    /* mixing matrix h11, h12, h21, h22 per stereo band, Q29 */
+    int      env;                   /* envelope being interpolated */
+    int      hEnd[20][4];           // [PS_NR_PAR_BANDS][4] value at the end of the envelope
+    int      hCurr[20][4];          // [PS_NR_PAR_BANDS][4]
+    int      hStep[20][4];          // [PS_NR_PAR_BANDS][4] increment per QMF slot
+
+    /* hybrid analysis, last 6 slots of QMF bands 0..2 */
+    int      hybridDelay[3][6][2];
+
+    /* transient detection per stereo band */
+    int64_t  peakDecayNrg[20];
+    int64_t  powerSmooth[20];
+    int64_t  peakDecayDiffSmooth[20];
+
+    /* decorrelation, ring buffers indexed by the slot counters below */
+    int      delayIdx2;
+    int      delayIdx14;
+    int      apIdx[3];
+    int      delay2[30][2][2];      /* z^-2 in front of the all-pass filters, hybrid bands 0..29 */
+    int      apDelay[30][12][2];    /* all-pass links of 3, 4 and 5 slots */
+    int      delay14[12][14][2];    /* hybrid bands 30..41 */
+    int      delay1[29][2];         /* hybrid bands 42..70 */
+
+    /* one slot of left and right QMF samples for the synthesis filterbank */
+    int      XBufL[64][2];
+    int      XBufR[64][2];
+} PSInfoPS_t;
+
 typedef struct _PSInfoSBR {
     /* save for entire file */
     int      frameCount;
@@ -426,8 +498,35 @@ typedef struct _PSInfoSBR {
     int      delayQMFS[2][10 * 128]; // [AAC_MAX_NCHANS][DELAY_SAMPS_QMFS]
     int      XBufDelay[2][8][64][2]; // [AAC_MAX_NCHANS][HF_GEN][64][2]
     int      XBuf[32+8][64][2];
+
+#ifdef AAC_ENABLE_PS
+    PSInfoPS_t  ps;                  /* parametric stereo, mono streams only */
+#endif
 } PSInfoSBR_t;
 
+typedef struct AACDecoder {             /* complete state of one decoder instance */
+    PSInfoBase_t        *PSInfoBase;
+    AACDecInfo_t        *AACDecInfo;
+    AACFrameInfo_t       AACFrameInfo;
+    ADTSHeader_t         fhADTS;
+    ADIFHeader_t         fhADIF;
+    ProgConfigElement_t *pce[16];
+    PulseInfo_t          pulseInfo[2]; // [MAX_NCHANS_ELEM]
+    aac_BitStreamInfo_t  aac_BitStreamInfo;
+    PSInfoSBR_t         *PSInfoSBR;
+    int                  sbrBypass;     /* 1: ignore SBR data, output core AAC at half rate */
+    uint64_t             prof[AAC_PROF_STAGES]; /* cycles per stage, only counted with HELIX_PROFILE */
+} AACDecoder_t;
+
+/* compile-time budget of the buffers in the codec arena, see AACDecoder_AllocateBuffers() */
+#ifdef AAC_ENABLE_SBR
+static const uint32_t AAC_ARENA_BUDGET = CODEC_ARENA_ROUND(sizeof(AACDecInfo_t)) + CODEC_ARENA_ROUND(sizeof(PSInfoBase_t)) +
+                                         CODEC_ARENA_ROUND(sizeof(ProgConfigElement_t) * 16) + CODEC_ARENA_ROUND(sizeof(PSInfoSBR_t));
+#else
+static const uint32_t AAC_ARENA_BUDGET = CODEC_ARENA_ROUND(sizeof(AACDecInfo_t)) + CODEC_ARENA_ROUND(sizeof(PSInfoBase_t)) +
+                                         CODEC_ARENA_ROUND(sizeof(ProgConfigElement_t) * 16);
+#endif
+
 bool AACDecoder_AllocateBuffers(void);
 int AACFlushCodec();
 void AACDecoder_FreeBuffers(void);
@@ -439,11 +538,29 @@ int AACGetSampRate();
 int AACGetChannels();
 int AACGetID(); // 0-MPEG4, 1-MPEG2
 uint8_t AACGetProfile(); // 0-Main, 1-LC, 2-SSR, 3-reserved
-uint8_t AACGetFormat(); // 0-unknown 1-ADTS 2-ADIF, 3-RAW
+uint8_t AACGetFormat(); // 0-unknown 1-ADTS 2-ADIF, 3-RAW, 4-LOAS
+int AACGetLATMConfigChanges();
+bool AACGetParametricStereo(); // mono stream decoded to stereo (HE-AAC v2)
 int AACGetBitsPerSample();
 int AACGetBitrate();
 int AACGetOutputSamps();
 int AACGetBitrate();
+void AACSetSBRBypass(bool on);
+bool AACGetSBRBypass();
+uint64_t AACGetProfile(int stage);
+void AACResetProfile();
+// same functions for a specific decoder instance (zero-initialized AACDecoder_t), functions above use a default one
+bool AACDecoder_AllocateBuffers(AACDecoder_t *ctx);
+int AACFlushCodec(AACDecoder_t *ctx);
+void AACDecoder_FreeBuffers(AACDecoder_t *ctx);
+int AACSetRawBlockParams(AACDecoder_t *ctx, int copyLast, int nChans, int sampRateCore, int profile);
+int AACDecode(AACDecoder_t *ctx, uint8_t *inbuf, int *bytesLeft, short *outbuf);
+int AACGetSampRate(AACDecoder_t *ctx);
+int AACGetChannels(AACDecoder_t *ctx);
+int AACGetOutputSamps(AACDecoder_t *ctx);
+int AACGetBitrate(AACDecoder_t *ctx);
+void AACSetSBRBypass(AACDecoder_t *ctx, bool on);
+AACDecoder_t *AACDecoder_Select(AACDecoder_t *ctx);   // instance for the functions above, NULL is the default one
 void DecodeLPCCoefs(int order, int res, int8_t *filtCoef, int *a, int *b);
 int FilterRegion(int size, int dir, int order, int *audioCoef, int *a, int *hist);
 int TNSFilter(int ch);
@@ -486,12 +603,18 @@ void DecodeICS(int ch);
 int DecodeNoiselessData(uint8_t **buf, int *bitOffset, int *bitsAvail, int ch);
 int DecodeHuffmanScalar(const signed short *huffTab, const HuffInfo_t *huffTabInfo, unsigned int bitBuf, int32_t *val);
 int UnpackADTSHeader(uint8_t **buf, int *bitOffset, int *bitsAvail);
+int AACGetADTSFrameLength(uint8_t *buf);
+int AACGetLOASFrameLength(uint8_t *buf);
 int GetADTSChannelMapping(uint8_t *buf, int bitOffset, int bitsAvail);
 int GetNumChannelsADIF(int nPCE);
 int GetSampleRateIdxADIF(int nPCE);
 int UnpackADIFHeader(uint8_t **buf, int *bitOffset, int *bitsAvail);
 int SetRawBlockParams(int copyLast, int nChans, int sampRate, int profile);
 int PrepareRawBlock();
+unsigned int LatmGetValue();
+int UnpackAudioSpecificConfig(int *sampRateIdx, int *nChans);
+int UnpackStreamMuxConfig(uint8_t *start);
+int UnpackLOASFrame(uint8_t *buf, int nBytes, int *frameLength, uint8_t **payload, int *payloadLength);
 int DequantBlock(int *inbuf, int nSamps, int scale);
 int AACDequantize(int ch);
 int DeinterleaveShortBlocks(int ch);
@@ -581,3 +704,14 @@ void CopyCouplingGrid(SBRGrid *sbrGridLeft, SBRGrid *sbrGridRight);
 void CopyCouplingInverseFilterMode(int numNoiseFloorBands, uint8_t *modeLeft, uint8_t *modeRight);
 void UnpackSBRSingleChannel(int chBase);
 void UnpackSBRChannelPair(int chBase);
+// PS
+int DecodePSSymbol(int tab);
+int UnpackPSPar(int8_t (*par)[34], int nPar, int env, int dt, int tab, int minVal, int maxVal);
+int UnpackPSData(int bitsLeft);
+void MapPSPar(int8_t *parMapped, const int8_t *par, int nPar);
+void SetupPSEnvelope(int env);
+void HybridAnalysisPS(int l, int (*s)[2]);
+void ApplyPS(int l, int top);
+void StartPSFrame(int top);
+void EndPSFrame();
+void SynthesisPS(int l, int qmfsBands, int applyPS, short *outbuf);
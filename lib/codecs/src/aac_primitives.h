@@ -0,0 +1,98 @@
+// aac_primitives.h
+// Fixed-point primitives for the helix AAC decoder.
+// On the ESP32 (Xtensa LX6/LX7) the MUL32_HIGH, NSA and CLAMPS options are used through inline
+// assembly: one instruction each instead of a 64-bit multiply library call or a binary search.
+// Elsewhere (or with -DHELIX_PORTABLE) the portable C reference is used.  Both versions give
+// identical results for all inputs, including 0x80000000.
+#pragma once
+
+#if defined(__XTENSA__) && !defined(HELIX_PORTABLE)
+  #include <xtensa/config/core-isa.h>
+  #if XCHAL_HAVE_MUL32_HIGH && XCHAL_HAVE_NSA
+    #define AAC_XTENSA_PRIMITIVES
+  #endif
+#endif
+
+#ifdef AAC_XTENSA_PRIMITIVES
+//----------------------------------------------------------------------------------------------------------------------
+inline int MULSHIFT32(int x, int y){
+    int z;
+    __asm__ ("mulsh %0, %1, %2" : "=r" (z) : "r" (x), "r" (y));      /* high word of signed 32x32 product */
+    return z;
+}
+inline int CLZ(int x){
+    int numZeros;
+    __asm__ ("nsau %0, %1" : "=r" (numZeros) : "r" (x));               /* gives 32 for x == 0 */
+    return numZeros;
+}
+inline int FASTABS(int x){
+    int y;
+    __asm__ ("abs %0, %1" : "=r" (y) : "r" (x));
+    return y;
+}
+inline int64_t MADD64(int64_t sum64, int x, int y){
+    uint32_t lo;
+    int32_t  hi;
+    __asm__ ("mull  %0, %2, %3\n\t"
+             "mulsh %1, %2, %3" : "=&r" (lo), "=&r" (hi) : "r" (x), "r" (y));
+    return sum64 + (int64_t)(((uint64_t)(uint32_t)hi << 32) | lo);
+}
+#if XCHAL_HAVE_CLAMPS
+inline short CLIPTOSHORT(int x){
+    int y; /* clip to [-32768, 32767] */
+    __asm__ ("clamps %0, %1, 15" : "=r" (y) : "r" (x));
+    return (short)y;
+}
+#define AAC_HAVE_CLIPTOSHORT
+#endif
+#else
+//----------------------------------------------------------------------------------------------------------------------
+inline int MULSHIFT32(int x, int y){
+    int z; z = (int64_t)x * (int64_t)y >> 32;
+    return z;
+}
+inline int CLZ(int x){
+    int numZeros;
+    if(!x) return 32; /* count leading zeros with binary search (function should be 17 ARM instructions total) */
+    numZeros = 1;
+    if (!((unsigned int)x >> 16))    { numZeros += 16; x <<= 16; }
+    if (!((unsigned int)x >> 24))    { numZeros +=  8; x <<=  8; }
+    if (!((unsigned int)x >> 28))    { numZeros +=  4; x <<=  4; }
+    if (!((unsigned int)x >> 30))    { numZeros +=  2; x <<=  2; }
+    numZeros -= ((unsigned int)x >> 31);
+    return numZeros;
+}
+inline int FASTABS(int x){
+    int sign;
+    sign = x >> (sizeof(int) * 8 - 1);
+    x ^= sign; x -= sign; return x;
+}
+inline int64_t MADD64(int64_t sum64, int x, int y){
+    sum64 += (int64_t)x * (int64_t)y;
+    return sum64;
+}
+#endif
+
+#ifndef AAC_HAVE_CLIPTOSHORT
+inline short CLIPTOSHORT(int x){
+    int sign; /* clip to [-32768, 32767] */
+    sign = x >> 31;
+    if (sign != (x >> 15)) x = sign ^ ((1 << 15) - 1);
+    return (short)x;
+}
+#endif
+//----------------------------------------------------------------------------------------------------------------------
+inline int CLIP_2N(int y, int n){
+    int sign = y >> 31;
+    if(sign != (y >> n))
+        y = sign ^ ((1 << n) - 1);
+    return y;
+}
+inline int CLIP_2N_SHIFT30(int y, int n){
+    int sign = y >> 31;
+    if(sign != (y >> (30 - n)))
+            y = sign ^ (0x3fffffff);
+    else
+        y = (y << n);
+    return y;
+}
@@ -0,0 +1,143 @@
+/*
+ * codec_arena.cpp
+ * Static memory arena for the helix MP3, AAC, Vorbis, Opus and FLAC decoder buffers
+ * and the state of the WAV reader.
+ *
+ * The size is the largest of the compile-time budgets of the decoders in the build (m_ARENA_BUDGET in
+ * mp3_decoder.h, AAC_ARENA_BUDGET in aac_decoder.h, VORBIS_ARENA_BUDGET in vorbis_decoder.h,
+ * OGGOPUS_ARENA_BUDGET in oggopus_decoder.h, FLAC_ARENA_BUDGET in flac_decoder.h and WAV_ARENA_BUDGET
+ * in wav_decoder.h).  The Opus budget only counts with HELIX_OPUS, the AAC budget includes SBR and PS
+ * only with AAC_ENABLE_SBR and AAC_ENABLE_PS.
+ * The arena is claimed by one decoder instance at a time.  Other instances fall back to heap allocation.
+ */
+#include "codec_arena.h"
+#include "mp3_decoder.h"
+#include "aac_decoder.h"
+#include "vorbis_decoder.h"
+#include "oggopus_decoder.h"
+#include "flac_decoder.h"
+#include "wav_decoder.h"
+
+#ifdef HELIX_OPUS
+  static const uint32_t OPUS_BUDGET = OGGOPUS_ARENA_BUDGET;
+#else
+  static const uint32_t OPUS_BUDGET = 0;                /* decoder not compiled, see oggopus_decoder.cpp */
+#endif
+
+const size_t CODEC_ARENA_SIZE = MAX(MAX(MAX(m_ARENA_BUDGET, AAC_ARENA_BUDGET), MAX(VORBIS_ARENA_BUDGET, OPUS_BUDGET)),
+                                    MAX(FLAC_ARENA_BUDGET, WAV_ARENA_BUDGET));
+
+typedef struct CodecArenaEntry {
+    const char *name;                                   /* name of the structure, for the report */
+    size_t      size;                                   /* requested number of bytes */
+} CodecArenaEntry_t;
+
+static uint8_t            m_arena[CODEC_ARENA_SIZE] __attribute__((aligned(8)));
+static const void        *m_arenaOwner;                 /* decoder instance using the arena, NULL if free */
+static size_t             m_arenaUsed;                  /* number of bytes handed out */
+static CodecArenaEntry_t  m_arenaEntry[CODEC_ARENA_MAXENTRIES];
+static int                m_arenaEntries;
+
+/***********************************************************************************************************************
+ * Function:    CodecArena_Claim
+ *
+ * Description: claim the arena for a decoder instance
+ *
+ * Inputs:      pointer to the decoder instance
+ *
+ * Outputs:     none
+ *
+ * Return:      true if the arena was free or is already owned by this instance, otherwise false
+ **********************************************************************************************************************/
+bool CodecArena_Claim(const void *owner) {
+    if (m_arenaOwner && m_arenaOwner != owner)
+        return false;
+    if (!m_arenaOwner) {
+        m_arenaOwner = owner;
+        m_arenaUsed = 0;
+        m_arenaEntries = 0;
+    }
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool CodecArena_IsOwner(const void *owner) {
+    return (m_arenaOwner != NULL && m_arenaOwner == owner);
+}
+/***********************************************************************************************************************
+ * Function:    CodecArena_Alloc
+ *
+ * Description: hand out the next block of the arena
+ *
+ * Inputs:      pointer to the decoder instance (must own the arena)
+ *              number of bytes needed
+ *              name of the structure, used in CodecArena_Report()
+ *
+ * Outputs:     none
+ *
+ * Return:      pointer to the block, NULL if not owner or the budget is exceeded
+ *
+ * Notes:       memory is not cleared, the decoders do that themselves
+ **********************************************************************************************************************/
+void *CodecArena_Alloc(const void *owner, size_t size, const char *name) {
+    void *p;
+
+    if (!CodecArena_IsOwner(owner) || m_arenaUsed + CODEC_ARENA_ROUND(size) > CODEC_ARENA_SIZE) {
+        log_e("codec arena: no room for %s (%u bytes)", name, (unsigned)size);
+        return NULL;
+    }
+    p = m_arena + m_arenaUsed;
+    m_arenaUsed += CODEC_ARENA_ROUND(size);
+    if (m_arenaEntries < CODEC_ARENA_MAXENTRIES) {
+        m_arenaEntry[m_arenaEntries].name = name;
+        m_arenaEntry[m_arenaEntries].size = size;
+        m_arenaEntries++;
+    }
+    return p;
+}
+/***********************************************************************************************************************
+ * Function:    CodecArena_Release
+ *
+ * Description: give the arena back, all blocks handed out are invalid after this call
+ *
+ * Inputs:      pointer to the decoder instance
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ **********************************************************************************************************************/
+void CodecArena_Release(const void *owner) {
+    if (!CodecArena_IsOwner(owner))
+        return;
+    m_arenaOwner = NULL;
+    m_arenaUsed = 0;
+    m_arenaEntries = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t CodecArena_Size() {
+    return CODEC_ARENA_SIZE;
+}
+//----------------------------------------------------------------------------------------------------------------------
+size_t CodecArena_Used() {
+    return m_arenaUsed;
+}
+/***********************************************************************************************************************
+ * Function:    CodecArena_Report
+ *
+ * Description: print the arena usage per structure, for the "test" command
+ *
+ * Inputs:      none
+ *
+ * Outputs:     lines on the serial log
+ *
+ * Return:      none
+ **********************************************************************************************************************/
+void CodecArena_Report() {
+    int i;
+
+    log_printf("Codec arena %u bytes (MP3 budget %d, AAC budget %d, Vorbis budget %d, Opus budget %d, "
+               "FLAC budget %d, WAV budget %d), %u in use\n",
+               (unsigned)CODEC_ARENA_SIZE, m_ARENA_BUDGET, AAC_ARENA_BUDGET, VORBIS_ARENA_BUDGET,
+               OPUS_BUDGET, FLAC_ARENA_BUDGET, WAV_ARENA_BUDGET, (unsigned)m_arenaUsed);
+    for (i = 0; i < m_arenaEntries; i++)
+        log_printf("  %-20s %6u\n", m_arenaEntry[i].name, (unsigned)m_arenaEntry[i].size);
+}
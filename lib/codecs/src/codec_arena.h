@@ -0,0 +1,18 @@
+// codec_arena.h
+// One static memory block shared by the helix decoders.
+// Only the decoder that is in use holds the arena, so an MP3 stream does not keep the AAC (and SBR)
+// buffers allocated and the heap is not fragmented by the decoder buffers.
+#pragma once
+
+#include "Arduino.h"
+
+#define CODEC_ARENA_ROUND(n)    (((n) + 7) & ~7)        // All buffers in the arena are 8-byte aligned
+#define CODEC_ARENA_MAXENTRIES  16                      // Max. number of buffers in the arena
+
+bool   CodecArena_Claim(const void *owner);
+bool   CodecArena_IsOwner(const void *owner);
+void  *CodecArena_Alloc(const void *owner, size_t size, const char *name);
+void   CodecArena_Release(const void *owner);
+size_t CodecArena_Size();
+size_t CodecArena_Used();
+void   CodecArena_Report();
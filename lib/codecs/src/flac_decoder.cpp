@@ -0,0 +1,1019 @@
+/*
+ * flac_decoder.cpp
+ * FLAC decoder, see RFC 9639.
+ *
+ * A native FLAC stream starts with "fLaC" and the metadata blocks, the first one is STREAMINFO with the
+ * sample rate, bits per sample and the max. block and frame size.  The other blocks (tags, seek table,
+ * pictures) are skipped.  The frames follow, each starts with a sync code 0xFFF8 or 0xFFF9 and ends
+ * with a CRC-16 over the whole frame.  The frame bytes are collected in the frame buffer with a running
+ * CRC-16, the frame is complete when the CRC is 0 and the next sync code follows.  At the end of a file
+ * FlacEndOfStream() completes the last frame.
+ * In Ogg FLAC the first packet holds a short header and STREAMINFO, the other header packets are the
+ * metadata blocks, then every packet is one frame.  The Ogg pages are handled by ogg_demux.
+ * A frame has one subframe per channel: constant, verbatim, fixed prediction of order 0..4 or LPC of
+ * order 1..32 plus a Rice coded residual.  The prediction is done in place on the residual, in 32 bits
+ * when the coefficients and the sample size allow it, otherwise in 64 bits.
+ */
+#include "flac_decoder.h"
+
+#ifndef MIN
+  #define MIN(a,b)      ((a) < (b) ? (a) : (b))
+#endif
+
+#define FL_MINFRAME     10      /* smallest frame: header, one constant subframe, CRC-16 */
+#define FL_STREAMINFO   34      /* size of the STREAMINFO block */
+
+enum {                                                  /* states of the native stream parser */
+    FL_S_MARKER =       0,                              /* searching for "fLaC" */
+    FL_S_METAHDR =      1,                              /* receiving the header of a metadata block */
+    FL_S_METADATA =     2,                              /* receiving or skipping a metadata block */
+    FL_S_SYNC =         3,                              /* searching for the sync code of a frame */
+    FL_S_FRAME =        4                               /* receiving a frame */
+};
+
+enum {                                                  /* results of FlFeed() */
+    FL_NEED_DATA =      0,                              /* all input used, no complete frame */
+    FL_FRAME =          1                               /* complete frame in the frame buffer */
+};
+
+/* All decoder state lives in a FlacDecoder_t.  The decoder always works on the instance m_flac points to,
+ * which is the default instance unless one of the functions with a context argument is running.
+ */
+FlacDecoder_t         m_FlacDecoder;
+thread_local FlacDecoder_t *m_flac = &m_FlacDecoder;
+#define m_FlacInfo             (m_flac->FlacInfo)
+#define m_frame                (m_flac->frame)
+#define m_frameSize            (m_flac->frameSize)
+#define m_pcm                  (m_flac->pcm)
+#define m_pcmSize              (m_flac->pcmSize)
+#define m_oggMode              (m_flac->oggMode)
+
+static uint64_t m_prof[FLAC_PROF_STAGES];               /* cycles per stage, only counted with HELIX_PROFILE */
+static uint32_t m_profSamps;                            /* samples per channel decoded since the last reset */
+
+typedef struct _FlBits_t {                              /* bit reader for a frame */
+    const uint8_t *buf;
+    uint32_t       pos;                                 /* next bit */
+    uint32_t       bits;                                /* number of bits in buf */
+} FlBits_t;
+
+/* CRC-16 of the frames, polynomial 0x8005, MSB first */
+static const uint16_t m_flCrc16Tab[256] HELIX_DRAM = {
+    0x0000, 0x8005, 0x800f, 0x000a, 0x801b, 0x001e, 0x0014, 0x8011, 0x8033, 0x0036, 0x003c, 0x8039,
+    0x0028, 0x802d, 0x8027, 0x0022, 0x8063, 0x0066, 0x006c, 0x8069, 0x0078, 0x807d, 0x8077, 0x0072,
+    0x0050, 0x8055, 0x805f, 0x005a, 0x804b, 0x004e, 0x0044, 0x8041, 0x80c3, 0x00c6, 0x00cc, 0x80c9,
+    0x00d8, 0x80dd, 0x80d7, 0x00d2, 0x00f0, 0x80f5, 0x80ff, 0x00fa, 0x80eb, 0x00ee, 0x00e4, 0x80e1,
+    0x00a0, 0x80a5, 0x80af, 0x00aa, 0x80bb, 0x00be, 0x00b4, 0x80b1, 0x8093, 0x0096, 0x009c, 0x8099,
+    0x0088, 0x808d, 0x8087, 0x0082, 0x8183, 0x0186, 0x018c, 0x8189, 0x0198, 0x819d, 0x8197, 0x0192,
+    0x01b0, 0x81b5, 0x81bf, 0x01ba, 0x81ab, 0x01ae, 0x01a4, 0x81a1, 0x01e0, 0x81e5, 0x81ef, 0x01ea,
+    0x81fb, 0x01fe, 0x01f4, 0x81f1, 0x81d3, 0x01d6, 0x01dc, 0x81d9, 0x01c8, 0x81cd, 0x81c7, 0x01c2,
+    0x0140, 0x8145, 0x814f, 0x014a, 0x815b, 0x015e, 0x0154, 0x8151, 0x8173, 0x0176, 0x017c, 0x8179,
+    0x0168, 0x816d, 0x8167, 0x0162, 0x8123, 0x0126, 0x012c, 0x8129, 0x0138, 0x813d, 0x8137, 0x0132,
+    0x0110, 0x8115, 0x811f, 0x011a, 0x810b, 0x010e, 0x0104, 0x8101, 0x8303, 0x0306, 0x030c, 0x8309,
+    0x0318, 0x831d, 0x8317, 0x0312, 0x0330, 0x8335, 0x833f, 0x033a, 0x832b, 0x032e, 0x0324, 0x8321,
+    0x0360, 0x8365, 0x836f, 0x036a, 0x837b, 0x037e, 0x0374, 0x8371, 0x8353, 0x0356, 0x035c, 0x8359,
+    0x0348, 0x834d, 0x8347, 0x0342, 0x03c0, 0x83c5, 0x83cf, 0x03ca, 0x83db, 0x03de, 0x03d4, 0x83d1,
+    0x83f3, 0x03f6, 0x03fc, 0x83f9, 0x03e8, 0x83ed, 0x83e7, 0x03e2, 0x83a3, 0x03a6, 0x03ac, 0x83a9,
+    0x03b8, 0x83bd, 0x83b7, 0x03b2, 0x0390, 0x8395, 0x839f, 0x039a, 0x838b, 0x038e, 0x0384, 0x8381,
+    0x0280, 0x8285, 0x828f, 0x028a, 0x829b, 0x029e, 0x0294, 0x8291, 0x82b3, 0x02b6, 0x02bc, 0x82b9,
+    0x02a8, 0x82ad, 0x82a7, 0x02a2, 0x82e3, 0x02e6, 0x02ec, 0x82e9, 0x02f8, 0x82fd, 0x82f7, 0x02f2,
+    0x02d0, 0x82d5, 0x82df, 0x02da, 0x82cb, 0x02ce, 0x02c4, 0x82c1, 0x8243, 0x0246, 0x024c, 0x8249,
+    0x0258, 0x825d, 0x8257, 0x0252, 0x0270, 0x8275, 0x827f, 0x027a, 0x826b, 0x026e, 0x0264, 0x8261,
+    0x0220, 0x8225, 0x822f, 0x022a, 0x823b, 0x023e, 0x0234, 0x8231, 0x8213, 0x0216, 0x021c, 0x8219,
+    0x0208, 0x820d, 0x8207, 0x0202
+};
+/* CRC-8 of the frame headers, polynomial 0x07, MSB first */
+static const uint8_t m_flCrc8Tab[256] = {
+    0x00, 0x07, 0x0e, 0x09, 0x1c, 0x1b, 0x12, 0x15, 0x38, 0x3f, 0x36, 0x31, 0x24, 0x23, 0x2a, 0x2d,
+    0x70, 0x77, 0x7e, 0x79, 0x6c, 0x6b, 0x62, 0x65, 0x48, 0x4f, 0x46, 0x41, 0x54, 0x53, 0x5a, 0x5d,
+    0xe0, 0xe7, 0xee, 0xe9, 0xfc, 0xfb, 0xf2, 0xf5, 0xd8, 0xdf, 0xd6, 0xd1, 0xc4, 0xc3, 0xca, 0xcd,
+    0x90, 0x97, 0x9e, 0x99, 0x8c, 0x8b, 0x82, 0x85, 0xa8, 0xaf, 0xa6, 0xa1, 0xb4, 0xb3, 0xba, 0xbd,
+    0xc7, 0xc0, 0xc9, 0xce, 0xdb, 0xdc, 0xd5, 0xd2, 0xff, 0xf8, 0xf1, 0xf6, 0xe3, 0xe4, 0xed, 0xea,
+    0xb7, 0xb0, 0xb9, 0xbe, 0xab, 0xac, 0xa5, 0xa2, 0x8f, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9d, 0x9a,
+    0x27, 0x20, 0x29, 0x2e, 0x3b, 0x3c, 0x35, 0x32, 0x1f, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0d, 0x0a,
+    0x57, 0x50, 0x59, 0x5e, 0x4b, 0x4c, 0x45, 0x42, 0x6f, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7d, 0x7a,
+    0x89, 0x8e, 0x87, 0x80, 0x95, 0x92, 0x9b, 0x9c, 0xb1, 0xb6, 0xbf, 0xb8, 0xad, 0xaa, 0xa3, 0xa4,
+    0xf9, 0xfe, 0xf7, 0xf0, 0xe5, 0xe2, 0xeb, 0xec, 0xc1, 0xc6, 0xcf, 0xc8, 0xdd, 0xda, 0xd3, 0xd4,
+    0x69, 0x6e, 0x67, 0x60, 0x75, 0x72, 0x7b, 0x7c, 0x51, 0x56, 0x5f, 0x58, 0x4d, 0x4a, 0x43, 0x44,
+    0x19, 0x1e, 0x17, 0x10, 0x05, 0x02, 0x0b, 0x0c, 0x21, 0x26, 0x2f, 0x28, 0x3d, 0x3a, 0x33, 0x34,
+    0x4e, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5c, 0x5b, 0x76, 0x71, 0x78, 0x7f, 0x6a, 0x6d, 0x64, 0x63,
+    0x3e, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2c, 0x2b, 0x06, 0x01, 0x08, 0x0f, 0x1a, 0x1d, 0x14, 0x13,
+    0xae, 0xa9, 0xa0, 0xa7, 0xb2, 0xb5, 0xbc, 0xbb, 0x96, 0x91, 0x98, 0x9f, 0x8a, 0x8d, 0x84, 0x83,
+    0xde, 0xd9, 0xd0, 0xd7, 0xc2, 0xc5, 0xcc, 0xcb, 0xe6, 0xe1, 0xe8, 0xef, 0xfa, 0xfd, 0xf4, 0xf3
+};
+static const uint8_t m_flRateBps[8] = {0, 8, 12, 0, 16, 20, 24, 0};            /* sample size codes, 0 = invalid */
+static const int32_t m_flRates[12] = {0, 88200, 176400, 192000, 8000, 16000,   /* sample rate codes 0..11 */
+                                      22050, 24000, 32000, 44100, 48000, 96000};
+
+//----------------------------------------------------------------------------------------------------------------------
+static uint16_t FlCrc16(uint16_t crc, const uint8_t *p, int len) {
+    while (len--)
+        crc = (crc << 8) ^ m_flCrc16Tab[(crc >> 8) ^ *p++];
+    return crc;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static inline uint32_t FlPeek(const FlBits_t *br) {
+    const uint8_t *p;
+    uint32_t       v;
+    int            s;
+
+    if (br->pos >= br->bits)                            /* beyond the end reads zeros, the callers check pos */
+        return 0;
+    p = br->buf + (br->pos >> 3);
+    v = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    s = br->pos & 7;
+    if (s)
+        v = (v << s) | (p[4] >> (8 - s));
+    return v;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static inline uint32_t FlRead(FlBits_t *br, int n) {   /* n = 0..32 */
+    uint32_t v;
+
+    if (n == 0)
+        return 0;
+    v = FlPeek(br) >> (32 - n);
+    br->pos += n;
+    return v;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static inline int32_t FlReadSigned(FlBits_t *br, int n) {
+    if (n == 0)
+        return 0;
+    return (int32_t)(FlRead(br, n) << (32 - n)) >> (32 - n);
+}
+/***********************************************************************************************************************
+ * Function:    FlStreamInfo
+ *
+ * Description: check the STREAMINFO block and take the stream parameters from it
+ *
+ * Inputs:      the 34 bytes of the block
+ *
+ * Outputs:     sampRate, channels, bps, maxBlock, maxFrame and totalSamples set
+ *
+ * Return:      0 or error code
+ **********************************************************************************************************************/
+static int FlStreamInfo(const uint8_t *si) {
+    FlacInfo_t *vi = m_FlacInfo;
+    int         maxBlock, rate, ch, bps;
+
+    memcpy(vi->streamInfo, si, FL_STREAMINFO);
+    maxBlock = (si[2] << 8) | si[3];
+    rate = (si[10] << 12) | (si[11] << 4) | (si[12] >> 4);
+    ch = ((si[12] >> 1) & 7) + 1;
+    bps = (((si[12] & 1) << 4) | (si[13] >> 4)) + 1;
+    if (maxBlock < 16 || rate == 0)
+        return ERR_FLAC_INVALID_HEADER;
+    if (ch > FLAC_MAXCHANS || bps > FLAC_MAXBPS || bps < 4 || maxBlock > FLAC_MAXBLOCK) {
+        log_e("FLAC: %d channels, %d bits, blocks of %d not supported", ch, bps, maxBlock);
+        return ERR_FLAC_UNSUPPORTED;
+    }
+    vi->maxBlock = maxBlock;
+    vi->maxFrame = (si[7] << 16) | (si[8] << 8) | si[9];
+    vi->sampRate = rate;
+    vi->channels = ch;
+    vi->bps = bps;
+    vi->totalSamples = ((uint64_t)(si[13] & 0x0f) << 32) | ((uint32_t)si[14] << 24) | (si[15] << 16) |
+                       (si[16] << 8) | si[17];
+    return ERR_FLAC_NONE;
+}
+/***********************************************************************************************************************
+ * Function:    FlSetup
+ *
+ * Description: get the frame buffer and the sample buffer for the stream of the last STREAMINFO
+ *
+ * Inputs:      none
+ *
+ * Outputs:     frame and pcm buffers, kept if they are big enough
+ *
+ * Return:      0 or error code
+ *
+ * Notes:       encoders that write the STREAMINFO before the first frame (streams) leave the max. frame size
+ *                at 0, the buffer is then sized for the worst case, a verbatim frame
+ *              in Ogg mode the frame buffer is the packet buffer of the demuxer from now on
+ **********************************************************************************************************************/
+static int FlSetup() {
+    FlacInfo_t *vi = m_FlacInfo;
+    int         need;
+
+    need = vi->maxFrame ? vi->maxFrame + 16 : 64 + vi->maxBlock * vi->channels * (vi->bps + 1) / 8;
+    if (m_frameSize < need) {
+        free(m_frame);
+        m_frame = (uint8_t*)malloc(need + FLAC_PAD);
+        if (!m_frame && psramFound())
+            m_frame = (uint8_t*)ps_malloc(need + FLAC_PAD);
+        m_frameSize = m_frame ? need : 0;
+    }
+    need = vi->maxBlock * vi->channels;
+    if (m_pcmSize < need) {
+        free(m_pcm);
+        m_pcm = (int32_t*)malloc(need * sizeof(int32_t));
+        if (!m_pcm && psramFound())
+            m_pcm = (int32_t*)ps_malloc(need * sizeof(int32_t));
+        m_pcmSize = m_pcm ? need : 0;
+    }
+    if (!m_frame || !m_pcm) {
+        log_e("FLAC: no memory for the frame (%d bytes) or the samples (%d bytes)",
+              vi->maxFrame, need * (int)sizeof(int32_t));
+        return ERR_FLAC_OUT_OF_MEMORY;
+    }
+    if (m_oggMode)
+        OggDemux_SetBuffer(&vi->ogg, m_frame, m_frameSize);
+    vi->blockSamps = vi->outPos = 0;
+    vi->bytes = vi->samples = 0;
+    return ERR_FLAC_NONE;
+}
+/***********************************************************************************************************************
+ * Function:    FlResidual
+ *
+ * Description: decode the Rice coded residual of a subframe
+ *
+ * Inputs:      bit reader, block size, predictor order
+ *
+ * Outputs:     residual in x[order..n-1]
+ *
+ * Return:      false if the data is invalid
+ **********************************************************************************************************************/
+static HELIX_IRAM bool FlResidual(FlBits_t *br, int32_t *x, int n, int order) {
+    int      method, porder, parts, p, cnt, k, esc, i, z;
+    uint32_t v, q, u;
+
+    method = FlRead(br, 2);
+    if (method > 1)
+        return false;
+    esc = method ? 31 : 15;
+    porder = FlRead(br, 4);
+    parts = 1 << porder;
+    if ((n >> porder) << porder != n || (n >> porder) < order)
+        return false;
+    x += order;
+    for (p = 0; p < parts; p++) {
+        cnt = (n >> porder) - (p == 0 ? order : 0);
+        k = FlRead(br, method ? 5 : 4);
+        if (k == esc) {                                 /* escape: samples of k bits, not coded */
+            k = FlRead(br, 5);
+            for (i = 0; i < cnt; i++)
+                x[i] = FlReadSigned(br, k);
+        }
+        else {
+            for (i = 0; i < cnt; i++) {
+                q = 0;                                  /* unary part */
+                while ((v = FlPeek(br)) == 0) {
+                    q += 32;
+                    br->pos += 32;
+                    if (br->pos > br->bits)
+                        return false;
+                }
+                z = __builtin_clz(v);
+                q += z;
+                br->pos += z + 1;
+                u = (q << k) | FlRead(br, k);
+                x[i] = (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+            }
+        }
+        x += cnt;
+        if (br->pos > br->bits)
+            return false;
+    }
+    return true;
+}
+/***********************************************************************************************************************
+ * Function:    FlFixed, FlLpc
+ *
+ * Description: restore the samples of a subframe with fixed or LPC prediction, in place
+ *
+ * Inputs:      warm-up samples in x[0..order-1], residual in x[order..n-1]
+ *              for LPC: coefficients, shift and the number of bits needed for the sum
+ *
+ * Outputs:     samples in x[]
+ *
+ * Return:      none
+ *
+ * Notes:       sums are unsigned where they may wrap, a bad frame then gives bad samples but no overflow
+ **********************************************************************************************************************/
+static HELIX_IRAM void FlFixed(int32_t *x, int n, int order) {
+    int i;
+
+    switch (order) {
+    case 1:
+        for (i = 1; i < n; i++)
+            x[i] = (int32_t)((uint32_t)x[i] + x[i - 1]);
+        break;
+    case 2:
+        for (i = 2; i < n; i++)
+            x[i] = (int32_t)((uint32_t)x[i] + 2u * x[i - 1] - x[i - 2]);
+        break;
+    case 3:
+        for (i = 3; i < n; i++)
+            x[i] = (int32_t)((uint32_t)x[i] + 3u * x[i - 1] - 3u * x[i - 2] + x[i - 3]);
+        break;
+    case 4:
+        for (i = 4; i < n; i++)
+            x[i] = (int32_t)((uint32_t)x[i] + 4u * x[i - 1] - 6u * x[i - 2] + 4u * x[i - 3] - x[i - 4]);
+        break;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+static HELIX_IRAM void FlLpc(int32_t *x, int n, const int32_t *c, int order, int shift, int sumBits) {
+    int      i, j;
+    uint32_t sum;
+    int64_t  sum64;
+
+    if (sumBits <= 32) {
+        for (i = order; i < n; i++) {
+            sum = 0;
+            for (j = 0; j < order; j++)
+                sum += (uint32_t)c[j] * (uint32_t)x[i - 1 - j];
+            x[i] = (int32_t)((uint32_t)x[i] + (uint32_t)((int32_t)sum >> shift));
+        }
+    }
+    else {
+        for (i = order; i < n; i++) {
+            sum64 = 0;
+            for (j = 0; j < order; j++)
+                sum64 += (int64_t)c[j] * x[i - 1 - j];
+            x[i] = (int32_t)((uint32_t)x[i] + (uint32_t)(sum64 >> shift));
+        }
+    }
+}
+/***********************************************************************************************************************
+ * Function:    FlSubframe
+ *
+ * Description: decode one subframe
+ *
+ * Inputs:      bit reader, block size, bits per sample of this channel
+ *
+ * Outputs:     n samples in x[]
+ *
+ * Return:      false if the data is invalid
+ **********************************************************************************************************************/
+static bool FlSubframe(FlBits_t *br, int32_t *x, int n, int bps) {
+    int     type, wasted = 0, order, prec, shift, i, v, bits;
+    int32_t c[32];
+
+    HELIX_PROF_T(t);
+    if (FlRead(br, 1))                                  /* zero bit */
+        return false;
+    type = FlRead(br, 6);
+    if (FlRead(br, 1)) {                                /* wasted bits, unary */
+        for (wasted = 1; !FlRead(br, 1); wasted++)
+            if (wasted >= bps)
+                return false;
+        bps -= wasted;
+    }
+    if (type == 0) {                                    /* constant */
+        v = FlReadSigned(br, bps);
+        for (i = 0; i < n; i++)
+            x[i] = v;
+    }
+    else if (type == 1) {                               /* verbatim */
+        for (i = 0; i < n; i++)
+            x[i] = FlReadSigned(br, bps);
+    }
+    else if (type >= 8 && type <= 12) {                 /* fixed predictor */
+        order = type - 8;
+        if (order > n)
+            return false;
+        for (i = 0; i < order; i++)
+            x[i] = FlReadSigned(br, bps);
+        if (!FlResidual(br, x, n, order))
+            return false;
+        HELIX_PROF_ADD(m_prof[FLAC_PROF_RESIDUAL], t);
+        FlFixed(x, n, order);
+        HELIX_PROF_ADD(m_prof[FLAC_PROF_PREDICT], t);
+    }
+    else if (type >= 32) {                              /* LPC */
+        order = type - 31;
+        if (order > n)
+            return false;
+        for (i = 0; i < order; i++)
+            x[i] = FlReadSigned(br, bps);
+        prec = FlRead(br, 4) + 1;
+        if (prec == 16)
+            return false;
+        shift = FlReadSigned(br, 5);
+        if (shift < 0)                                  /* reserved */
+            return false;
+        for (i = 0; i < order; i++)
+            c[i] = FlReadSigned(br, prec);
+        if (!FlResidual(br, x, n, order))
+            return false;
+        HELIX_PROF_ADD(m_prof[FLAC_PROF_RESIDUAL], t);
+        for (bits = 0; (1 << bits) < order; bits++)     /* ceil(log2(order)) */
+            ;
+        FlLpc(x, n, c, order, shift, bps + prec + bits);
+        HELIX_PROF_ADD(m_prof[FLAC_PROF_PREDICT], t);
+    }
+    else {
+        return false;                                   /* reserved types */
+    }
+    if (wasted)
+        for (i = 0; i < n; i++)
+            x[i] = (int32_t)((uint32_t)x[i] << wasted);
+    return br->pos <= br->bits;
+}
+/***********************************************************************************************************************
+ * Function:    FlDecodeFrame
+ *
+ * Description: decode a complete frame into the sample buffer
+ *
+ * Inputs:      the frame, including the CRC-16 at the end, and its length
+ *
+ * Outputs:     blockSamps samples per channel in pcm, outPos at the start
+ *              sampRate, channels and bps of the frame
+ *
+ * Return:      0 or error code
+ *
+ * Notes:       the CRC-16 of the frame has been checked by the caller
+ **********************************************************************************************************************/
+static int FlDecodeFrame(const uint8_t *f, int len) {
+    FlacInfo_t *vi = m_FlacInfo;
+    FlBits_t    br;
+    int         hl, bsCode, rateCode, assign, ch, bps, n, rate, c, i;
+    uint8_t     crc;
+    int32_t    *l, *r, m, s;
+
+    vi->blockSamps = vi->outPos = 0;
+    if (len < FL_MINFRAME || f[0] != 0xff || (f[1] & 0xfe) != 0xf8 || (f[3] & 1))
+        return ERR_FLAC_INVALID_FRAME;
+    bsCode = f[2] >> 4;
+    rateCode = f[2] & 0x0f;
+    assign = f[3] >> 4;
+    bps = (f[3] >> 1) & 7;
+    bps = bps ? m_flRateBps[bps] : vi->bps;
+    ch = assign < 8 ? assign + 1 : 2;
+    if (bps == 0 || assign > 10 || ch > vi->channels || bsCode == 0 || rateCode == 15)
+        return ERR_FLAC_INVALID_FRAME;
+    hl = 5;                                             /* frame or sample number, UTF-8 coded */
+    for (i = 0x40; (f[4] & 0x80) && (f[4] & i) && i > 1; i >>= 1)
+        hl++;
+    if (hl > 11 || hl + 8 > len)
+        return ERR_FLAC_INVALID_FRAME;
+    if (bsCode == 1)
+        n = 192;
+    else if (bsCode <= 5)
+        n = 576 << (bsCode - 2);
+    else if (bsCode == 6)
+        n = f[hl++] + 1;
+    else if (bsCode == 7) {
+        n = ((f[hl] << 8) | f[hl + 1]) + 1;
+        hl += 2;
+    }
+    else
+        n = 256 << (bsCode - 8);
+    if (rateCode == 0)
+        rate = vi->sampRate;
+    else if (rateCode < 12)
+        rate = m_flRates[rateCode];
+    else if (rateCode == 12)
+        rate = f[hl++] * 1000;
+    else {
+        rate = (f[hl] << 8) | f[hl + 1];
+        rate *= rateCode == 14 ? 10 : 1;
+        hl += 2;
+    }
+    for (crc = 0, i = 0; i < hl; i++)
+        crc = m_flCrc8Tab[crc ^ f[i]];
+    if (crc != f[hl++] || n > vi->maxBlock || rate == 0)
+        return ERR_FLAC_INVALID_FRAME;
+    br.buf = f + hl;
+    br.pos = 0;
+    br.bits = (len - hl - 2) * 8;
+    for (c = 0; c < ch; c++) {                          /* the side channel has one bit more */
+        if (!FlSubframe(&br, m_pcm + c * vi->maxBlock, n,
+                        bps + ((assign == 8 || assign == 10) && c == 1) + (assign == 9 && c == 0)))
+            return ERR_FLAC_INVALID_FRAME;
+    }
+    HELIX_PROF_T(t);
+    l = m_pcm;
+    r = m_pcm + vi->maxBlock;
+    switch (assign) {
+    case 8:                                             /* left, side */
+        for (i = 0; i < n; i++)
+            r[i] = (int32_t)((uint32_t)l[i] - r[i]);
+        break;
+    case 9:                                             /* side, right */
+        for (i = 0; i < n; i++)
+            l[i] = (int32_t)((uint32_t)l[i] + r[i]);
+        break;
+    case 10:                                            /* mid, side */
+        for (i = 0; i < n; i++) {
+            s = r[i];
+            m = (int32_t)((uint32_t)l[i] << 1) | (s & 1);
+            l[i] = (int32_t)((uint32_t)m + s) >> 1;
+            r[i] = (int32_t)((uint32_t)m - s) >> 1;
+        }
+        break;
+    }
+    HELIX_PROF_ADD(m_prof[FLAC_PROF_OUTPUT], t);
+    vi->sampRate = rate;
+    vi->channels = ch;
+    vi->bps = bps;
+    vi->blockSamps = n;
+    vi->frames++;
+    vi->bytes += len;
+    vi->samples += n;
+    m_profSamps += n;
+    return ERR_FLAC_NONE;
+}
+/***********************************************************************************************************************
+ * Function:    FlOutput
+ *
+ * Description: convert samples of the decoded block to 16 bits, interleaved
+ *
+ * Inputs:      number of samples per channel, from outPos on
+ *
+ * Outputs:     samples in out[]
+ *
+ * Return:      none
+ *
+ * Notes:       more than 16 bits are shifted down, the lowest bits are dropped: the output is the same as
+ *                that of other decoders with 16 bits output (libFLAC, FFmpeg) and can be checked bit exact
+ **********************************************************************************************************************/
+static HELIX_IRAM void FlOutput(short *out, int n) {
+    FlacInfo_t    *vi = m_FlacInfo;
+    const int32_t *x;
+    int            ch = vi->channels, shift = vi->bps - 16, c, i;
+
+    for (c = 0; c < ch; c++) {
+        x = m_pcm + c * vi->maxBlock + vi->outPos;
+        if (shift <= 0) {
+            for (i = 0; i < n; i++)
+                out[i * ch + c] = (short)((uint32_t)x[i] << -shift);
+        }
+        else {
+            for (i = 0; i < n; i++)
+                out[i * ch + c] = (short)(x[i] >> shift);
+        }
+    }
+}
+/***********************************************************************************************************************
+ * Function:    FlFeed
+ *
+ * Description: take the next part of a native FLAC stream until a frame is complete
+ *
+ * Inputs:      stream data and number of bytes
+ *
+ * Outputs:     number of bytes used
+ *              frame in the frame buffer, fill bytes
+ *
+ * Return:      FL_FRAME, FL_NEED_DATA or error code
+ *
+ * Notes:       the two sync bytes of the next frame end the current one, they are put back in the frame
+ *                buffer at the next call
+ *              a 0xFFF8 inside a frame after a CRC of 0 ends the frame too early, this shows as a bad frame
+ **********************************************************************************************************************/
+static HELIX_IRAM int FlFeed(const uint8_t *in, int len, int *used) {
+    FlacInfo_t *vi = m_FlacInfo;
+    int         i = 0, n, err;
+    uint8_t     b;
+    uint16_t    crc;
+
+    *used = 0;
+    if (vi->nextSync >= 0) {                            /* start the frame after the last one */
+        m_frame[0] = 0xff;
+        m_frame[1] = vi->nextSync;
+        vi->fill = 2;
+        vi->crc = FlCrc16(0, m_frame, 2);
+        vi->prevFF = false;
+        vi->nextSync = -1;
+    }
+    while (i < len) {
+        switch (vi->state) {
+        case FL_S_MARKER:
+            b = in[i++];
+            if (b == (uint8_t)"fLaC"[vi->match]) {
+                if (++vi->match == 4) {
+                    vi->state = FL_S_METAHDR;
+                    vi->metaFill = 0;
+                    vi->headers = 0;
+                }
+            }
+            else {
+                vi->match = (b == 'f');
+            }
+            break;
+        case FL_S_METAHDR:
+            vi->metaHdr[vi->metaFill++] = in[i++];
+            if (vi->metaFill == 4) {
+                vi->metaLeft = (vi->metaHdr[1] << 16) | (vi->metaHdr[2] << 8) | vi->metaHdr[3];
+                vi->metaFill = 0;
+                vi->state = FL_S_METADATA;
+            }
+            break;
+        case FL_S_METADATA:
+            n = MIN((uint32_t)(len - i), vi->metaLeft);
+            if ((vi->metaHdr[0] & 0x7f) == 0) {         /* STREAMINFO, the others are skipped */
+                if (vi->metaFill + n > FL_STREAMINFO)
+                    n = FL_STREAMINFO - vi->metaFill;   /* n is 0 if the block is longer */
+                memcpy(vi->hdrPacket + vi->metaFill, in + i, n);
+                vi->metaFill += n;
+                if (n == 0)
+                    n = MIN((uint32_t)(len - i), vi->metaLeft);
+            }
+            i += n;
+            vi->metaLeft -= n;
+            break;
+        case FL_S_SYNC:
+            b = in[i++];
+            if (vi->prevFF && (b & 0xfe) == 0xf8) {
+                m_frame[0] = 0xff;
+                m_frame[1] = b;
+                vi->fill = 2;
+                vi->crc = FlCrc16(0, m_frame, 2);
+                vi->prevFF = false;
+                vi->state = FL_S_FRAME;
+            }
+            else {
+                vi->prevFF = (b == 0xff);
+            }
+            break;
+        default:                                        /* FL_S_FRAME */
+            crc = vi->crc;
+            while (i < len) {
+                b = in[i++];
+                if (vi->prevFF && (b & 0xfe) == 0xf8 && vi->crcFF == 0 && vi->fill > FL_MINFRAME) {
+                    vi->fill--;                         /* the 0xFF belongs to the next frame */
+                    vi->nextSync = b;
+                    vi->crc = 0;
+                    *used = i;
+                    return FL_FRAME;
+                }
+                if (vi->fill >= m_frameSize) {          /* too long, no frame */
+                    vi->lostSync++;
+                    vi->state = FL_S_SYNC;
+                    vi->prevFF = (b == 0xff);
+                    break;
+                }
+                vi->prevFF = (b == 0xff);
+                if (vi->prevFF)
+                    vi->crcFF = crc;
+                m_frame[vi->fill++] = b;
+                crc = (crc << 8) ^ m_flCrc16Tab[(crc >> 8) ^ b];
+            }
+            vi->crc = crc;
+            break;
+        }
+        if (vi->state == FL_S_METADATA && vi->metaLeft == 0) {
+            err = ERR_FLAC_NONE;
+            if ((vi->metaHdr[0] & 0x7f) == 0) {
+                err = vi->metaFill < FL_STREAMINFO ? ERR_FLAC_INVALID_HEADER : FlStreamInfo(vi->hdrPacket);
+                if (err == ERR_FLAC_NONE)
+                    err = FlSetup();
+                vi->headers = (err == ERR_FLAC_NONE);
+            }
+            else if ((vi->metaHdr[0] & 0x80) && !vi->headers) {
+                err = ERR_FLAC_INVALID_HEADER;          /* no STREAMINFO */
+            }
+            if (err != ERR_FLAC_NONE) {
+                vi->state = FL_S_MARKER;                /* skip the stream */
+                vi->match = 0;
+                *used = i;
+                return err;
+            }
+            if (vi->metaHdr[0] & 0x80) {                /* last metadata block */
+                vi->state = FL_S_SYNC;
+                vi->prevFF = false;
+            }
+            else {
+                vi->state = FL_S_METAHDR;
+            }
+            vi->metaFill = 0;
+        }
+    }
+    *used = i;
+    return FL_NEED_DATA;
+}
+/***********************************************************************************************************************
+ * Function:    FlPacket
+ *
+ * Description: handle the packet in the packet buffer of the demuxer, Ogg mode
+ *
+ * Inputs:      none
+ *
+ * Outputs:     pcm filled for an audio packet
+ *
+ * Return:      0 or error code
+ *
+ * Notes:       the first packet is 0x7F "FLAC", version, number of header packets, "fLaC" and STREAMINFO
+ *              a new stream (chained Ogg, next track on internet radio) starts all over
+ **********************************************************************************************************************/
+static int FlPacket() {
+    FlacInfo_t    *vi = m_FlacInfo;
+    OggDemux_t    *d = &vi->ogg;
+    const uint8_t *pkt = d->pkt;
+    int            len = d->pktLen, err;
+
+    if (d->pktBos) {
+        if (len < 13 + 4 + FL_STREAMINFO || memcmp(pkt, "\x7f" "FLAC", 5) != 0 || memcmp(pkt + 9, "fLaC", 4) != 0)
+            return ERR_FLAC_NONE;                       /* other codec, not followed */
+        OggDemux_Follow(d, d->pktSerial);
+        vi->headers = 0;
+        vi->skip = true;
+        if (pkt[5] != 1)                                /* major version of the mapping */
+            return ERR_FLAC_UNSUPPORTED;
+        if ((pkt[13] & 0x7f) != 0)
+            return ERR_FLAC_INVALID_HEADER;
+        if ((err = FlStreamInfo(pkt + 17)) != 0 ||      /* pkt is invalid after FlSetup() */
+            (err = FlSetup()) != 0)
+            return err;
+        vi->headers = 1;
+        vi->skip = false;
+        return ERR_FLAC_NONE;
+    }
+    if (vi->skip || vi->headers == 0 || len < 2 || pkt[0] != 0xff || (pkt[1] & 0xfe) != 0xf8)
+        return ERR_FLAC_NONE;                           /* not followed or a metadata block */
+    if (d->pktTrunc) {
+        vi->lostSync++;
+        return ERR_FLAC_INVALID_FRAME;
+    }
+    if (FlCrc16(0, pkt, len) != 0) {
+        vi->crcErrors++;
+        return ERR_FLAC_INVALID_FRAME;
+    }
+    return FlDecodeFrame(pkt, len);
+}
+/***********************************************************************************************************************
+ * Function:    FlacDecoder_AllocateBuffers
+ *
+ * Description: allocate the buffers of the FLAC decoder
+ *
+ * Inputs:      none
+ *
+ * Outputs:     none
+ *
+ * Return:      false if not enough memory, otherwise true
+ *
+ * Notes:       the state is taken from the codec arena if it is free, otherwise from the heap
+ *              the frame and sample buffers are allocated when STREAMINFO arrives, they are kept for the
+ *                next stream
+ **********************************************************************************************************************/
+bool FlacDecoder_AllocateBuffers(void) {
+    if (!m_FlacInfo && CodecArena_Claim(m_flac)) {
+        m_FlacInfo = (FlacInfo_t*)CodecArena_Alloc(m_flac, sizeof(FlacInfo_t), "FlacInfo");
+        if (!m_FlacInfo)
+            CodecArena_Release(m_flac);                 /* budget too small (should not happen), use the heap */
+    }
+    if (!m_FlacInfo)
+        m_FlacInfo = (FlacInfo_t*)malloc(sizeof(FlacInfo_t));
+    if (!m_FlacInfo && psramFound()) {
+        m_FlacInfo = (FlacInfo_t*)ps_malloc(sizeof(FlacInfo_t));
+        if (m_FlacInfo)
+            log_i("FLAC buffers allocated in PSRAM");
+    }
+    if (!m_FlacInfo) {
+        log_e("not enough memory to allocate flac decoder buffers");
+        return false;
+    }
+    memset(m_FlacInfo, 0, sizeof(FlacInfo_t));
+    m_FlacInfo->nextSync = -1;
+    OggDemux_Init(&m_FlacInfo->ogg);
+    OggDemux_SetBuffer(&m_FlacInfo->ogg, m_FlacInfo->hdrPacket, FLAC_HDRPACKET);
+    return true;
+}
+/***********************************************************************************************************************
+ * Function:    FlacDecoder_FreeBuffers
+ *
+ * Description: free the state, the frame and the sample buffers of the FLAC decoder
+ *
+ * Inputs:      none
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ **********************************************************************************************************************/
+void FlacDecoder_FreeBuffers(void) {
+    free(m_frame);
+    free(m_pcm);
+    m_frame = NULL;
+    m_pcm = NULL;
+    m_frameSize = m_pcmSize = 0;
+    if (CodecArena_IsOwner(m_flac)) {
+        m_FlacInfo = NULL;                              /* buffers are in the codec arena, just give it back */
+        CodecArena_Release(m_flac);
+        return;
+    }
+    if (m_FlacInfo) {
+        free(m_FlacInfo);
+        m_FlacInfo = NULL;
+    }
+}
+/***********************************************************************************************************************
+ * Function:    FlacDecode
+ *
+ * Description: take the next part of a FLAC stream and decode the frames in it
+ *
+ * Inputs:      native or Ogg FLAC data and number of bytes
+ *
+ * Outputs:     number of bytes not used
+ *              PCM samples (FlacGetOutputSamps), 16 bits, interleaved if stereo
+ *
+ * Return:      ERR_FLAC_NONE if there are samples, call again with the rest of the data
+ *              ERR_FLAC_INDATA_UNDERFLOW if all data is used without new samples
+ *              other error codes for a bad header or frame, call again with the rest of the data
+ *
+ * Notes:       the data may be cut anywhere
+ *              a block is returned over several calls, these use no input, so the caller must go on calling
+ *                as long as there are samples
+ **********************************************************************************************************************/
+int FlacDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf) {
+    FlacInfo_t *vi = m_FlacInfo;
+    int         used, res, n;
+
+    if (!vi)
+        return ERR_FLAC_NULL_POINTER;
+    vi->outSamps = 0;
+    for (;;) {
+        if (vi->outPos < vi->blockSamps) {              /* samples of the last frame left */
+            HELIX_PROF_T(t);
+            n = MIN(vi->blockSamps - vi->outPos, FLAC_MAXOUT);
+            FlOutput(outbuf, n);
+            vi->outPos += n;
+            vi->outSamps = n;
+            HELIX_PROF_ADD(m_prof[FLAC_PROF_OUTPUT], t);
+            return ERR_FLAC_NONE;
+        }
+        if (vi->eos) {                                  /* end of file, decode the last frame */
+            vi->eos = false;
+            res = (vi->state == FL_S_FRAME && vi->nextSync < 0 && vi->fill > FL_MINFRAME && vi->crc == 0) ?
+                  FL_FRAME : FL_NEED_DATA;
+            vi->state = FL_S_MARKER;                    /* a new file may follow */
+            vi->match = 0;
+            vi->nextSync = -1;
+        }
+        else {
+            HELIX_PROF_T(t);
+            if (m_oggMode)
+                res = OggDemux_Feed(&vi->ogg, inbuf, *bytesLeft, &used) == OGG_PACKET ? FL_FRAME : FL_NEED_DATA;
+            else
+                res = FlFeed(inbuf, *bytesLeft, &used);
+            inbuf += used;
+            *bytesLeft -= used;
+            HELIX_PROF_ADD(m_prof[FLAC_PROF_FRAMING], t);
+            if (res < 0)
+                return res;
+        }
+        if (res == FL_NEED_DATA)
+            return ERR_FLAC_INDATA_UNDERFLOW;
+        res = m_oggMode ? FlPacket() : FlDecodeFrame(m_frame, vi->fill);
+        if (res != ERR_FLAC_NONE)
+            return res;
+    }
+}
+/***********************************************************************************************************************
+ * Function:    FlacEndOfStream
+ *
+ * Description: tell the decoder that the file has ended
+ *
+ * Inputs:      none
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ *
+ * Notes:       the last frame of a native stream is complete now, it is decoded by the next FlacDecode()
+ *                calls, after the samples of the previous frame
+ *              the decoder then waits for "fLaC" of a next file
+ **********************************************************************************************************************/
+void FlacEndOfStream() {
+    if (m_FlacInfo && !m_oggMode)
+        m_FlacInfo->eos = true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int FlacGetSampRate() {return m_FlacInfo->sampRate;}
+int FlacGetChannels() {return m_FlacInfo->channels;}
+int FlacGetBitsPerSample() {return 16;}
+int FlacGetOutputSamps() {return m_FlacInfo->outSamps * m_FlacInfo->channels;}
+int FlacGetBitrate() {
+    FlacInfo_t *vi = m_FlacInfo;
+
+    if (vi->samples == 0)
+        return 0;
+    return (int)((uint64_t)vi->bytes * 8 * vi->sampRate / vi->samples);
+}
+/***********************************************************************************************************************
+ * Function:    FlacSetOgg
+ *
+ * Description: select native FLAC or Ogg FLAC input
+ *
+ * Inputs:      true for Ogg FLAC
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ *
+ * Notes:       call after FlacDecoder_AllocateBuffers(), before the first data
+ **********************************************************************************************************************/
+void FlacSetOgg(bool on) {m_oggMode = on;}
+/***********************************************************************************************************************
+ * Function:    FlacGetProfile
+ *
+ * Description: get the number of cycles used by a stage of the decoder since the last FlacResetProfile()
+ *
+ * Inputs:      stage, FLAC_PROF_FRAMING .. FLAC_PROF_OUTPUT
+ *
+ * Outputs:     none
+ *
+ * Return:      number of cycles, always 0 without HELIX_PROFILE
+ **********************************************************************************************************************/
+uint64_t FlacGetProfile(int stage) {return (stage >= 0 && stage < FLAC_PROF_STAGES) ? m_prof[stage] : 0;}
+void FlacResetProfile() {memset(m_prof, 0, sizeof(m_prof)); m_profSamps = 0;}
+/***********************************************************************************************************************
+ * Function:    FlacReport
+ *
+ * Description: print the stream parameters, the buffers and the frame statistics, for the "test" command
+ *
+ * Inputs:      none
+ *
+ * Outputs:     lines on the serial log
+ *
+ * Return:      none
+ *
+ * Notes:       the input rate is what the SD card or the network has to deliver
+ *              with HELIX_PROFILE also the cycles per second of audio and the speed against real time
+ **********************************************************************************************************************/
+void FlacReport() {
+    FlacInfo_t *vi = m_FlacInfo;
+    int         br;
+
+    if (!vi)
+        return;
+    br = FlacGetBitrate();
+    log_printf("FLAC: %s, %d bits, max. block %d, frame buffer %d bytes, samples %d bytes\n",
+               m_oggMode ? "Ogg" : "native", vi->bps, vi->maxBlock, m_frameSize,
+               m_pcmSize * (int)sizeof(int32_t));
+    log_printf("FLAC: %d frames, %d CRC errors, %d lost syncs, input %d kB/s\n",
+               vi->frames, vi->crcErrors, vi->lostSync, br / 8000);
+    if (m_oggMode)
+        log_printf("FLAC: %d pages, %d CRC errors, %d packets lost\n",
+                   vi->ogg.pages, vi->ogg.crcErrors, vi->ogg.lostPackets);
+    #ifdef HELIX_PROFILE
+        uint64_t total = 0;
+        uint32_t perSec;
+        int      i;
+
+        for (i = 0; i < FLAC_PROF_STAGES; i++)
+            total += m_prof[i];
+        if (m_profSamps && total) {
+            perSec = (uint32_t)(total * vi->sampRate / m_profSamps);
+            log_printf("FLAC: %d cycles per second of audio, %d times real time\n",
+                       perSec, (int)((uint64_t)ESP.getCpuFreqMHz() * 1000000 / perSec));
+        }
+    #endif
+}
+/***********************************************************************************************************************
+ * Function:    FlacDecoder_AllocateBuffers, FlacDecoder_FreeBuffers, FlacDecode, FlacGet...
+ *
+ * Description: same as the functions without context, but for the decoder instance ctx instead of the default one
+ *
+ * Inputs:      pointer to decoder instance, zero-initialized before first use
+ *              other inputs as in the functions without context
+ *
+ * Notes:       the previous instance is restored on return, so these may be mixed freely with the calls
+ *                without context in the same task
+ **********************************************************************************************************************/
+bool FlacDecoder_AllocateBuffers(FlacDecoder_t *ctx) {
+    FlacDecoder_t *prev = m_flac;
+    bool res;
+
+    m_flac = ctx;
+    res = FlacDecoder_AllocateBuffers();
+    m_flac = prev;
+    return res;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void FlacDecoder_FreeBuffers(FlacDecoder_t *ctx) {
+    FlacDecoder_t *prev = m_flac;
+
+    m_flac = ctx;
+    FlacDecoder_FreeBuffers();
+    m_flac = prev;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int FlacDecode(FlacDecoder_t *ctx, uint8_t *inbuf, int *bytesLeft, short *outbuf) {
+    FlacDecoder_t *prev = m_flac;
+    int err;
+
+    m_flac = ctx;
+    err = FlacDecode(inbuf, bytesLeft, outbuf);
+    m_flac = prev;
+    return err;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void FlacEndOfStream(FlacDecoder_t *ctx) {
+    if (ctx->FlacInfo && !ctx->oggMode)
+        ctx->FlacInfo->eos = true;
+}
+int FlacGetSampRate(FlacDecoder_t *ctx) {return ctx->FlacInfo->sampRate;}
+int FlacGetChannels(FlacDecoder_t *ctx) {return ctx->FlacInfo->channels;}
+int FlacGetOutputSamps(FlacDecoder_t *ctx) {return ctx->FlacInfo->outSamps * ctx->FlacInfo->channels;}
+int FlacGetBitrate(FlacDecoder_t *ctx) {
+    FlacDecoder_t *prev = m_flac;
+    int br;
+
+    m_flac = ctx;
+    br = FlacGetBitrate();
+    m_flac = prev;
+    return br;
+}
+void FlacSetOgg(FlacDecoder_t *ctx, bool on) {ctx->oggMode = on;}
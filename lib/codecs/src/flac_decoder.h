@@ -0,0 +1,109 @@
+// flac_decoder.h
+// FLAC decoder for the helix builds, see RFC 9639.  Takes native FLAC (files on the SD card, FLAC
+// over HTTP) or Ogg FLAC (internet radio) in pieces of any size.
+// A native FLAC frame has no length field, its end is found when the next frame header follows
+// directly after a correct CRC-16.  So one complete frame is buffered before it is decoded, in a
+// heap buffer of the max. frame size of the STREAMINFO block.  The decoded block is returned in
+// parts of at most FLAC_MAXOUT samples per channel.
+// Sources with more than 16 bits are shifted down to 16 bits.  Up to 2 channels,
+// 24 bits and blocks of FLAC_MAXBLOCK samples are supported, that is every "subset" stream.
+#pragma once
+
+#include "Arduino.h"
+#include "codec_arena.h"
+#include "helix_placement.h"
+#include "ogg_demux.h"
+
+#define FLAC_MAXCHANS       2                           // Max. number of channels
+#define FLAC_MAXBLOCK       16384                       // Max. block size (subset limit above 48 kHz)
+#define FLAC_MAXBPS         24                          // Max. bits per sample
+#define FLAC_MAXOUT         1152                        // Max. samples per channel per call
+#define FLAC_HDRPACKET      64                          // Buffer for the Ogg header packets, before STREAMINFO
+#define FLAC_PAD            8                           // Extra bytes after the frame buffer for the bit reader
+
+enum {
+    ERR_FLAC_NONE                         =   0,
+    ERR_FLAC_INDATA_UNDERFLOW             =  -1,        /* all input used, no new PCM */
+    ERR_FLAC_NULL_POINTER                 =  -2,
+    ERR_FLAC_OUT_OF_MEMORY                =  -3,        /* no room for the frame or sample buffers */
+    ERR_FLAC_INVALID_HEADER               =  -4,
+    ERR_FLAC_UNSUPPORTED                  =  -6,        /* stream is skipped */
+    ERR_FLAC_INVALID_FRAME                =  -7
+};
+
+enum {                  /* decoder stages for HELIX_PROFILE */
+    FLAC_PROF_FRAMING                     =   0,        /* metadata, frame sync, CRC */
+    FLAC_PROF_RESIDUAL                    =   1,        /* Rice coded residual */
+    FLAC_PROF_PREDICT                     =   2,        /* fixed and LPC prediction */
+    FLAC_PROF_OUTPUT                      =   3,        /* inter-channel decorrelation, 16 bits */
+    FLAC_PROF_STAGES                      =   4
+};
+
+typedef struct _FlacInfo_t {
+    OggDemux_t ogg;
+    int       state;            /* see FL_S_... in flac_decoder.cpp */
+    int       match;            /* bytes of "fLaC" seen */
+    uint8_t   metaHdr[4];       /* header of the current metadata block */
+    int       metaFill;
+    uint32_t  metaLeft;         /* bytes of the metadata block still to come */
+    uint8_t   streamInfo[34];
+    int       headers;          /* Ogg: 1 after the first header packet */
+    bool      skip;             /* stream not supported */
+    int       sampRate;         /* of the last frame */
+    int       channels;
+    int       bps;              /* bits per sample of the source */
+    int       maxBlock;         /* from STREAMINFO */
+    int       maxFrame;
+    uint64_t  totalSamples;     /* 0 if unknown */
+    int       fill;             /* bytes in the frame buffer */
+    uint16_t  crc;              /* CRC-16 of the frame buffer */
+    uint16_t  crcFF;            /* CRC-16 before the last 0xFF byte */
+    bool      prevFF;           /* last byte was 0xFF */
+    int       nextSync;         /* second byte of the next frame, -1 if none */
+    bool      eos;              /* end of the file, the buffered frame is complete */
+    int       blockSamps;       /* samples per channel of the decoded block */
+    int       outPos;           /* next sample to return */
+    int       outSamps;         /* samples per channel of the last call */
+    uint32_t  frames;           /* statistics for the "test" command */
+    uint32_t  crcErrors;
+    uint32_t  lostSync;
+    uint32_t  bytes;            /* frame bytes and samples of the stream, for the bitrate */
+    uint32_t  samples;
+    uint8_t   hdrPacket[FLAC_HDRPACKET];
+} FlacInfo_t;
+
+typedef struct _FlacDecoder_t {
+    FlacInfo_t    *FlacInfo;
+    uint8_t       *frame;       /* frame buffer, also the Ogg packet buffer, FLAC_PAD bytes more */
+    int            frameSize;
+    int32_t       *pcm;         /* decoded block, maxBlock samples per channel, channel after channel */
+    int            pcmSize;     /* number of samples in the pcm buffer */
+    bool           oggMode;     /* input is Ogg FLAC */
+} FlacDecoder_t;
+
+/* compile-time budget of the buffers in the codec arena, see FlacDecoder_AllocateBuffers() */
+static const uint32_t FLAC_ARENA_BUDGET = CODEC_ARENA_ROUND(sizeof(FlacInfo_t));
+
+bool FlacDecoder_AllocateBuffers(void);
+void FlacDecoder_FreeBuffers(void);
+int FlacDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf);
+void FlacEndOfStream();
+int FlacGetSampRate();
+int FlacGetChannels();
+int FlacGetBitsPerSample();
+int FlacGetBitrate();
+int FlacGetOutputSamps();
+void FlacSetOgg(bool on);
+uint64_t FlacGetProfile(int stage);
+void FlacResetProfile();
+void FlacReport();
+// same functions for a specific decoder instance (zero-initialized FlacDecoder_t), functions above use a default one
+bool FlacDecoder_AllocateBuffers(FlacDecoder_t *ctx);
+void FlacDecoder_FreeBuffers(FlacDecoder_t *ctx);
+int FlacDecode(FlacDecoder_t *ctx, uint8_t *inbuf, int *bytesLeft, short *outbuf);
+void FlacEndOfStream(FlacDecoder_t *ctx);
+int FlacGetSampRate(FlacDecoder_t *ctx);
+int FlacGetChannels(FlacDecoder_t *ctx);
+int FlacGetOutputSamps(FlacDecoder_t *ctx);
+int FlacGetBitrate(FlacDecoder_t *ctx);
+void FlacSetOgg(FlacDecoder_t *ctx, bool on);
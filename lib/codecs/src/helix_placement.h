@@ -0,0 +1,51 @@
+// helix_placement.h
+// Placement of the hot functions and tables of the helix decoders.
+// The profile is set with HELIX_PLACEMENT in config.h or as a build flag (-DHELIX_PLACEMENT=1):
+//   0 - everything in flash, executed/read through the cache (default, no IRAM/DRAM cost)
+//   1 - hot kernels (Huffman, IMDCT, polyphase, FFT, QMF) in IRAM
+//   2 - as 1, plus the most used tables (Huffman, polyphase, twiddles) in DRAM
+// The flash cache is shared with SPIFFS and OTA, so placing the kernels in RAM gives a more
+// constant decode time.  Use the "test" command to see the cycles per frame.
+// Cost of profile 2 in DRAM (tables, moved out of flash): MP3 15236 bytes, AAC 15620 (18840 with
+// SBR), Vorbis 5120, FLAC 512, SPDIF encoder 512.  The IRAM of profile 1 is about 11 kB for MP3 and
+// 2 kB for AAC (4 kB with SBR), see the linker map (-Wl,-Map in platformio.ini) for the exact size.
+#pragma once
+
+#if __has_include("config.h")
+  #include "config.h"
+#endif
+
+#ifndef HELIX_PLACEMENT
+  #define HELIX_PLACEMENT 0
+#endif
+
+#if HELIX_PLACEMENT >= 1
+  #define HELIX_IRAM    IRAM_ATTR                       // Hot function in IRAM
+#else
+  #define HELIX_IRAM
+#endif
+
+#if HELIX_PLACEMENT >= 2
+  #define HELIX_DRAM    DRAM_ATTR                       // Hot table in DRAM
+#else
+  #define HELIX_DRAM    PROGMEM
+#endif
+
+// The current decoder instance of the MP3 and AAC decoders (m_mp3, m_aac) is thread local, so two
+// tasks can decode at the same time.  On the ESP32 the address of the pointer is then computed from
+// the THREADPTR register instead of loaded as a constant.  A build that decodes in one task only can use -DHELIX_THREAD_LOCAL=
+// for a plain global pointer; tests/host/bench_decode_notls measures the difference.
+#ifndef HELIX_THREAD_LOCAL
+  #define HELIX_THREAD_LOCAL    thread_local
+#endif
+
+// With HELIX_PROFILE the cycles of each decoder stage are counted, shown by the "test" command.
+// HELIX_PROF_T starts a measurement, HELIX_PROF_ADD adds the cycles since then to a counter and
+// starts the next one.  Without HELIX_PROFILE the macros generate no code.
+#ifdef HELIX_PROFILE
+  #define HELIX_PROF_T(t)       uint32_t t = ESP.getCycleCount()
+  #define HELIX_PROF_ADD(c, t)  { uint32_t n_ = ESP.getCycleCount(); (c) += n_ - (t); (t) = n_; }
+#else
+  #define HELIX_PROF_T(t)
+  #define HELIX_PROF_ADD(c, t)
+#endif
@@ -19,25 +19,37 @@ const uint8_t  m_IMDCT_SCALE            =2;   // additional scaling (by sqrt(2))
 const uint8_t  m_NGRANS_MPEG1           =2;
 const uint8_t  m_NGRANS_MPEG2           =1;
 const uint32_t m_SQRTHALF               =0x5a82799a;  // sqrt(0.5) in Q31 format
+const uint8_t  m_SYNC_CONFIRM           =2;   // number of following frame headers to check in MP3FindSyncWord
 
 
-MP3FrameInfo_t *m_MP3FrameInfo;
-SFBandTable_t m_SFBandTable;
-StereoMode_t m_sMode;  /* mono/stereo mode */
-MPEGVersion_t m_MPEGVersion;  /* version ID */
-FrameHeader_t *m_FrameHeader;
-SideInfoSub_t m_SideInfoSub[m_MAX_NGRAN][m_MAX_NCHAN];
-SideInfo_t *m_SideInfo;
-CriticalBandInfo_t m_CriticalBandInfo[m_MAX_NCHAN];  /* filled in dequantizer, used in joint stereo reconstruction */
-DequantInfo_t *m_DequantInfo;
-HuffmanInfo_t *m_HuffmanInfo;
-IMDCTInfo_t *m_IMDCTInfo;
-ScaleFactorInfoSub_t m_ScaleFactorInfoSub[m_MAX_NGRAN][m_MAX_NCHAN];
-ScaleFactorJS_t *m_ScaleFactorJS;
-SubbandInfo_t *m_SubbandInfo;
-MP3DecInfo_t *m_MP3DecInfo;
-
-const unsigned short huffTable[4242] PROGMEM = {
+/* All decoder state lives in an MP3Decoder_t.  The decoder always works on the instance m_mp3 points to,
+ * which is the default instance unless one of the functions with a context argument is running.
+ * m_mp3 is thread local, so instances can be used by different tasks at the same time (see HELIX_THREAD_LOCAL).
+ */
+MP3Decoder_t m_MP3Decoder;
+HELIX_THREAD_LOCAL MP3Decoder_t *m_mp3 = &m_MP3Decoder;
+#define m_MP3FrameInfo         (m_mp3->MP3FrameInfo)
+#define m_SFBandTable          (m_mp3->SFBandTable)
+#define m_sMode                (m_mp3->sMode)
+#define m_MPEGVersion          (m_mp3->MPEGVersion)
+#define m_FrameHeader          (m_mp3->FrameHeader)
+#define m_SideInfoSub          (m_mp3->SideInfoSub)
+#define m_SideInfo             (m_mp3->SideInfo)
+#define m_CriticalBandInfo     (m_mp3->CriticalBandInfo)
+#define m_DequantInfo          (m_mp3->DequantInfo)
+#define m_HuffmanInfo          (m_mp3->HuffmanInfo)
+#define m_IMDCTInfo            (m_mp3->IMDCTInfo)
+#define m_ScaleFactorInfoSub   (m_mp3->ScaleFactorInfoSub)
+#define m_ScaleFactorJS        (m_mp3->ScaleFactorJS)
+#define m_SubbandInfo          (m_mp3->SubbandInfo)
+#define m_MP3DecInfo           (m_mp3->MP3DecInfo)
+#define m_halfRate             (m_mp3->halfRate)
+#define m_prof                 (m_mp3->prof)
+#define m_mainPtr              (m_mp3->mainPtr)
+#define m_mainBitOffset        (m_mp3->mainBitOffset)
+#define m_mainBits             (m_mp3->mainBits)
+
+constexpr unsigned short huffTable[4242] HELIX_DRAM = {
     /* huffTable01[9] */
     0xf003, 0x3112, 0x3101, 0x2011, 0x2011, 0x1000, 0x1000, 0x1000, 0x1000,
     /* huffTable02[65] */
@@ -415,6 +427,75 @@ const unsigned short huffTable[4242] PROGMEM = {
     0x2901, 0x1091, 0x1091, 0xf001, 0x1b22, 0x1a52, 0xf001, 0x15a2, 0x1b12, 0xf001, 0x11b2, 0x1962,
     0xf001, 0x1a42, 0x1872, 0xf001, 0x1801, 0x1081, 0xf001, 0x1701, 0x1071,
 };
+
+/* First level lookup for the big values tables, see DecodeHuffmanPairs().
+ * One entry per m_HUFF_FASTBITS bit prefix of the bitstream, computed at compile time from huffTable, so it
+ *   cannot disagree with it.  An entry resolves the code word and the sign bits of x and y in one step:
+ *   bits 12..15 = total number of bits used (0 = not resolved within the prefix, use the normal table walk)
+ *   bits  0..3  = |x|, bit 4 = sign of x, bits 5..8 = |y|, bit 9 = sign of y
+ * Values of 15 in the linbits tables need the escape bits, these entries are 0 as well.
+ */
+static const uint8_t m_HUFF_FASTBITS = 8;
+static const uint8_t m_HUFF_FASTTABS = 10;
+
+/* n bits of prefix p, starting at bit pos (counted from the MSB) */
+constexpr unsigned HuffFastBits(unsigned p, int pos, int n) {
+    return (p >> (m_HUFF_FASTBITS - pos - n)) & ((1u << n) - 1);
+}
+/* pack a decoded pair, pos = number of bits used by the code word, the sign bits follow */
+constexpr uint16_t HuffFastPair(int x, int y, unsigned p, int pos, bool linBits) {
+    return ((linBits && (x == 15 || y == 15)) || (pos + (x ? 1 : 0) + (y ? 1 : 0) > m_HUFF_FASTBITS)) ? 0 :
+           (uint16_t)(((pos + (x ? 1 : 0) + (y ? 1 : 0)) << 12) |
+                      x | (x ? HuffFastBits(p, pos, 1) << 4 : 0) |
+                      (y << 5) | (y ? HuffFastBits(p, pos + (x ? 1 : 0), 1) << 9 : 0));
+}
+/* look at code word cw found in a level with m index bits, pos bits of prefix p were used before this level */
+constexpr uint16_t HuffFastCode(int t, unsigned short cw, int m, unsigned p, int pos, bool linBits);
+/* walk the level starting at huffTable[t] */
+constexpr uint16_t HuffFastLevel(int t, unsigned p, int pos, bool linBits) {
+    return ((huffTable[t] & 0x0f) <= m_HUFF_FASTBITS - pos) ?
+           HuffFastCode(t, huffTable[t + 1 + HuffFastBits(p, pos, huffTable[t] & 0x0f)], huffTable[t] & 0x0f,
+                        p, pos, linBits) :
+           /* index reaches beyond the prefix: short codes are repeated for every value of the missing bits */
+           HuffFastCode(t, huffTable[t + 1 + (HuffFastBits(p, pos, m_HUFF_FASTBITS - pos) <<
+                                              ((huffTable[t] & 0x0f) - (m_HUFF_FASTBITS - pos)))],
+                        huffTable[t] & 0x0f, p, pos, linBits);
+}
+constexpr uint16_t HuffFastCode(int t, unsigned short cw, int m, unsigned p, int pos, bool linBits) {
+    return ((cw >> 12) == 0) ?
+                ((m > m_HUFF_FASTBITS - pos) ? 0 : HuffFastLevel(t + cw, p, pos + m, linBits)) :   /* next level */
+           ((int)(cw >> 12) > m_HUFF_FASTBITS - pos) ? 0 :                                        /* too long */
+           HuffFastPair((cw >> 4) & 0x0f, (cw >> 8) & 0x0f, p, pos + (cw >> 12), linBits);
+}
+
+typedef struct HuffFastTable {
+    uint16_t tab[m_HUFF_FASTTABS][1 << m_HUFF_FASTBITS];
+} HuffFastTable_t;
+
+template<int... I> struct HuffFastSeq {};
+template<int N, int... I> struct HuffFastMakeSeq : HuffFastMakeSeq<N - 1, N - 1, I...> {};
+template<int... I> struct HuffFastMakeSeq<0, I...> { typedef HuffFastSeq<I...> type; };
+
+template<int... I> constexpr HuffFastTable_t HuffFastMake(HuffFastSeq<I...>) {
+    return {{ { HuffFastLevel(m_HUFF_OFFSET_07, I, 0, false)... },
+              { HuffFastLevel(m_HUFF_OFFSET_08, I, 0, false)... },
+              { HuffFastLevel(m_HUFF_OFFSET_09, I, 0, false)... },
+              { HuffFastLevel(m_HUFF_OFFSET_10, I, 0, false)... },
+              { HuffFastLevel(m_HUFF_OFFSET_11, I, 0, false)... },
+              { HuffFastLevel(m_HUFF_OFFSET_12, I, 0, false)... },
+              { HuffFastLevel(m_HUFF_OFFSET_13, I, 0, false)... },
+              { HuffFastLevel(m_HUFF_OFFSET_15, I, 0, false)... },
+              { HuffFastLevel(m_HUFF_OFFSET_16, I, 0, true)...  },
+              { HuffFastLevel(m_HUFF_OFFSET_24, I, 0, true)...  } }};
+}
+
+constexpr HuffFastTable_t huffFast HELIX_DRAM = HuffFastMake(HuffFastMakeSeq<1 << m_HUFF_FASTBITS>::type());
+
+/* row in huffFast for each Huffman table, -1 if none */
+const int8_t huffFastRow[m_HUFF_PAIRTABS] PROGMEM = {
+    -1, -1, -1, -1, -1, -1, -1,  0,  1,  2,  3,  4,  5,  6, -1,  7,
+     8,  8,  8,  8,  8,  8,  8,  8,  9,  9,  9,  9,  9,  9,  9,  9,
+};
 /* pow(2,-i/4) * pow(j,4/3) for i=0..3 j=0..15, Q25 format */
 const int pow43_14[4][16] PROGMEM = { /* Q28 */
 {   0x00000000, 0x10000000, 0x285145f3, 0x453a5cdb, 0x0cb2ff53, 0x111989d6,
@@ -446,7 +527,7 @@ const int pow43[48] PROGMEM = {
     0x70416360, 0x72d7e8b0, 0x75722ef9, 0x78102b85, 0x7ab1d3ec, 0x7d571e09,
 };
 
-const uint32_t polyCoef[264] PROGMEM = {
+const uint32_t polyCoef[264] HELIX_DRAM = {
     /* shuffled vs. original from 0, 1, ... 15 to 0, 15, 2, 13, ... 14, 1 */
     0x00000000, 0x00000074, 0x00000354, 0x0000072c, 0x00001fd4, 0x00005084, 0x000066b8, 0x000249c4,
     0x00049478, 0xfffdb63c, 0x000066b8, 0xffffaf7c, 0x00001fd4, 0xfffff8d4, 0x00000354, 0xffffff8c,
@@ -572,7 +653,7 @@ const int/*short*/slotTab[3][3][15] PROGMEM = {
     },
 };
 
-const uint32_t imdctWin[4][36] PROGMEM = {
+const uint32_t imdctWin[4][36] HELIX_DRAM = {
     {
     0x02aace8b, 0x07311c28, 0x0a868fec, 0x0c913b52, 0x0d413ccd, 0x0c913b52, 0x0a868fec, 0x07311c28,
     0x02aace8b, 0xfd16d8dd, 0xf6a09e66, 0xef7a6275, 0xe7dbc161, 0xe0000000, 0xd8243e9f, 0xd0859d8b,
@@ -1151,7 +1232,7 @@ int UnpackScaleFactors( unsigned char *buf, int *bitOffset, int bitsAvail, int g
  **********************************************************************************************************************/
 
 /***********************************************************************************************************************
- * Function:    MP3FindSyncWord
+ * Function:    MP3FindRawSync
  *
  * Description: locate the next byte-alinged sync word in the raw mp3 stream
  *
@@ -1162,8 +1243,10 @@ int UnpackScaleFactors( unsigned char *buf, int *bitOffset, int bitsAvail, int g
  *
  * Return:      offset to first sync word (bytes from start of buf)
  *              -1 if sync not found after searching nBytes
+ *
+ * Notes:       no check on the rest of the header, see MP3FindSyncWord() for that
  **********************************************************************************************************************/
-int MP3FindSyncWord(unsigned char *buf, int nBytes) {
+int MP3FindRawSync(unsigned char *buf, int nBytes) {
     int i;
 
     /* find byte-aligned syncword - need 12 (MPEG 1,2) or 11 (MPEG 2.5) matching bits */
@@ -1175,6 +1258,89 @@ int MP3FindSyncWord(unsigned char *buf, int nBytes) {
 
     return -1;
 }
+/***********************************************************************************************************************
+ * Function:    MP3GetFrameLength
+ *
+ * Description: check a candidate frame header and compute the length of the frame
+ *
+ * Inputs:      pointer to (at least) 4 bytes of candidate frame header
+ *
+ * Outputs:     none
+ *
+ * Return:      number of bytes in the frame, including header and pad byte
+ *              0 if the header is valid but the frame is free bitrate (length unknown)
+ *              -1 if this is not a valid layer 3 frame header
+ *
+ * Notes:       same checks as UnpackFrameHeader(), but no decoder state is touched
+ **********************************************************************************************************************/
+int MP3GetFrameLength(unsigned char *buf) {
+    int verIdx, brIdx, srIdx;
+    MPEGVersion_t ver;
+
+    if ((buf[0] & m_SYNCWORDH) != m_SYNCWORDH || (buf[1] & m_SYNCWORDL) != m_SYNCWORDL)  return -1;
+    verIdx = (buf[1] >> 3) & 0x03;
+    ver = (MPEGVersion_t) (verIdx == 0 ? MPEG25 : ((verIdx & 0x01) ? MPEG1 : MPEG2));
+    brIdx = (buf[2] >> 4) & 0x0f;
+    srIdx = (buf[2] >> 2) & 0x03;
+    /* layer 3 only, no reserved samplerate, bitrate or emphasis */
+    if (((buf[1] >> 1) & 0x03) != 1 || srIdx == 3 || brIdx == 15 || (buf[3] & 0x03) == 2) return -1;
+    if (brIdx == 0)
+        return 0;
+    return (int) slotTab[ver][srIdx][brIdx] + ((buf[2] >> 1) & 0x01);
+}
+/***********************************************************************************************************************
+ * Function:    MP3FindSyncWord
+ *
+ * Description: locate the next valid frame in the raw mp3 stream
+ *
+ * Inputs:      buffer to search for sync word
+ *              max number of bytes to search in buffer
+ *
+ * Outputs:     none
+ *
+ * Return:      offset to first sync word (bytes from start of buf)
+ *              MP3_SYNC_MOREDATA if the buffer ends before the first candidate is confirmed
+ *              -1 if sync not found after searching nBytes
+ *
+ * Notes:       a candidate header is only accepted if the next m_SYNC_CONFIRM frame headers
+ *                are found where the frame length says they should be, with the same
+ *                version, layer, CRC flag and sample rate.  This prevents locking on
+ *                "sync words" in ID3 tags, album art or random data
+ *              the first candidate that is not a false sync decides: if the buffer ends
+ *                before all its headers could be checked, MP3_SYNC_MOREDATA is returned.
+ *                Call again with more data, (m_SYNC_CONFIRM + 1) max. frames after the
+ *                candidate are always enough
+ **********************************************************************************************************************/
+int MP3FindSyncWord(unsigned char *buf, int nBytes) {
+    int i, len, pos, confirmed;
+
+    for (i = 0; i < nBytes - 3; i++) {
+        len = MP3GetFrameLength(buf + i);
+        if (len < 0)
+            continue;
+        if (len == 0) {
+            /* free bitrate, a matching next header is the best we can do */
+            if (MP3FindFreeSync(buf + i + 4, buf + i, nBytes - i - 4) >= 0)
+                return i;
+            continue;
+        }
+        confirmed = 0;
+        pos = i;
+        while (confirmed < m_SYNC_CONFIRM) {
+            if (pos + len + 4 > nBytes)
+                return MP3_SYNC_MOREDATA;
+            pos += len;
+            len = MP3GetFrameLength(buf + pos);
+            if (len <= 0 || buf[pos + 1] != buf[i + 1] || (buf[pos + 2] & 0x0c) != (buf[i + 2] & 0x0c))
+                break; /* next header does not line up, false sync */
+            confirmed++;
+        }
+        if (confirmed == m_SYNC_CONFIRM)
+            return i;
+    }
+
+    return -1;
+}
 /***********************************************************************************************************************
  * Function:    MP3FindFreeSync
  *
@@ -1204,12 +1370,12 @@ int MP3FindFreeSync(unsigned char *buf, unsigned char firstFH[4], int nBytes){
     unsigned char *bufPtr = buf;
 
     /* loop until we either:
-     *  - run out of nBytes (FindMP3SyncWord() returns -1)
+     *  - run out of nBytes (MP3FindRawSync() returns -1)
      *  - find the next valid frame header (sync word, version, layer, CRC flag, bitrate, and sample rate
      *      in next header must match current header)
      */
     while (1) {
-        offset = MP3FindSyncWord(bufPtr, nBytes);
+        offset = MP3FindRawSync(bufPtr, nBytes);
         bufPtr += offset;
         if (offset < 0) {
             return -1;
@@ -1254,10 +1420,10 @@ void MP3GetLastFrameInfo() {
     else{
         m_MP3FrameInfo->bitrate=m_MP3DecInfo->bitrate;
         m_MP3FrameInfo->nChans=m_MP3DecInfo->nChans;
-        m_MP3FrameInfo->samprate=m_MP3DecInfo->samprate;
+        m_MP3FrameInfo->samprate=m_MP3DecInfo->samprate >> m_halfRate;
         m_MP3FrameInfo->bitsPerSample=16;
         m_MP3FrameInfo->outputSamps=m_MP3DecInfo->nChans
-                * (int) samplesPerFrameTab[m_MPEGVersion][m_MP3DecInfo->layer-1];
+                * ((int) samplesPerFrameTab[m_MPEGVersion][m_MP3DecInfo->layer-1] >> m_halfRate);
         m_MP3FrameInfo->layer=m_MP3DecInfo->layer;
         m_MP3FrameInfo->version=m_MPEGVersion;
     }
@@ -1267,6 +1433,43 @@ int MP3GetChannels(){return m_MP3FrameInfo->nChans;}
 int MP3GetBitsPerSample(){return m_MP3FrameInfo->bitsPerSample;}
 int MP3GetBitrate(){return m_MP3FrameInfo->bitrate;}
 int MP3GetOutputSamps(){return m_MP3FrameInfo->outputSamps;}
+int MP3GetSampRate(MP3Decoder_t *ctx){return ctx->MP3FrameInfo->samprate;}
+int MP3GetChannels(MP3Decoder_t *ctx){return ctx->MP3FrameInfo->nChans;}
+int MP3GetBitsPerSample(MP3Decoder_t *ctx){return ctx->MP3FrameInfo->bitsPerSample;}
+int MP3GetBitrate(MP3Decoder_t *ctx){return ctx->MP3FrameInfo->bitrate;}
+int MP3GetOutputSamps(MP3Decoder_t *ctx){return ctx->MP3FrameInfo->outputSamps;}
+/***********************************************************************************************************************
+ * Function:    MP3SetHalfRate
+ *
+ * Description: switch half rate decoding on or off
+ *
+ * Inputs:      true for half rate
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ *
+ * Notes:       in half rate mode only subbands 0..15 go through the IMDCT and the synthesis filterbank
+ *                computes only the even output samples, so the output has half the sample rate and a
+ *                bandwidth of samprate/4.  MP3GetSampRate() and MP3GetOutputSamps() report the halved values.
+ *              meant for outputs that cannot reproduce high frequencies anyway (internal 8 bit DAC),
+ *                change it only between streams
+ **********************************************************************************************************************/
+void MP3SetHalfRate(bool on){m_halfRate = (on ? 1 : 0);}
+void MP3SetHalfRate(MP3Decoder_t *ctx, bool on){ctx->halfRate = (on ? 1 : 0);}
+/***********************************************************************************************************************
+ * Function:    MP3GetProfile
+ *
+ * Description: get the number of cycles used by a stage of the decoder since the last MP3ResetProfile()
+ *
+ * Inputs:      stage, MP3_PROF_HEADER .. MP3_PROF_SUBBAND
+ *
+ * Outputs:     none
+ *
+ * Return:      number of cycles, always 0 without HELIX_PROFILE
+ **********************************************************************************************************************/
+uint64_t MP3GetProfile(int stage){return (stage >= 0 && stage < MP3_PROF_STAGES) ? m_prof[stage] : 0;}
+void MP3ResetProfile(){memset(m_prof, 0, sizeof(m_prof));}
 /***********************************************************************************************************************
  * Function:    MP3GetNextFrameInfo
  *
@@ -1302,32 +1505,27 @@ int MP3GetNextFrameInfo(unsigned char *buf) {
  **********************************************************************************************************************/
 void MP3ClearBadFrame( short *outbuf) {
     int i;
+    if (outbuf == NULL)
+        return;
     for (i = 0; i < m_MP3DecInfo->nGrans * m_MP3DecInfo->nGranSamps * m_MP3DecInfo->nChans; i++)
         outbuf[i] = 0;
 }
 /***********************************************************************************************************************
- * Function:    MP3Decode
+ * Function:    DecodeHeader
  *
- * Description: decode one frame of MP3 data
+ * Description: unpack frame header and side info, fill the main data buffer (bit reservoir)
  *
- * Inputs:      number of valid bytes remaining in inbuf
- *              pointer to outbuf, big enough to hold one frame of decoded PCM samples
- *              flag indicating whether MP3 data is normal MPEG format (useSize = 0)
- *              or reformatted as "self-contained" frames (useSize = 1)
+ * Inputs:      as MP3Decode, outbuf may be NULL
  *
- * Outputs:     PCM data in outbuf, interleaved LRLRLR... if stereo
- *              number of output samples = nGrans * nGranSamps * nChans
- *              updated inbuf pointer, updated bytesLeft
+ * Outputs:     start of the main data in m_mainPtr, m_mainBitOffset and m_mainBits
+ *              updated bytesLeft
  *
  * Return:      error code, defined in mp3dec.h (0 means no error, < 0 means error)
- *
- * Notes:       switching useSize on and off between frames in the same stream
- *                is not supported (bit reservoir is not maintained if useSize on)
  **********************************************************************************************************************/
-int MP3Decode( unsigned char *inbuf, int *bytesLeft, short *outbuf, int useSize){
-    int offset, bitOffset, mainBits, gr, ch, fhBytes, siBytes, freeFrameBytes;
-    int prevBitOffset, sfBlockBits, huffBlockBits;
+static int DecodeHeader(unsigned char *inbuf, int *bytesLeft, short *outbuf, int useSize){
+    int fhBytes, siBytes, freeFrameBytes;
     unsigned char *mainPtr;
+    HELIX_PROF_T(prof);
 
     /* unpack frame header */
     fhBytes = UnpackFrameHeader(inbuf);
@@ -1408,59 +1606,199 @@ int MP3Decode( unsigned char *inbuf, int *bytesLeft, short *outbuf, int useSize)
             return ERR_MP3_MAINDATA_UNDERFLOW;
         }
     }
-    bitOffset = 0;
-    mainBits = m_MP3DecInfo->mainDataBytes * 8;
+    m_mainPtr = mainPtr;
+    m_mainBitOffset = 0;
+    m_mainBits = m_MP3DecInfo->mainDataBytes * 8;
+    HELIX_PROF_ADD(m_prof[MP3_PROF_HEADER], prof);
+    return ERR_MP3_NONE;
+}
 
-    /* decode one complete frame */
-    for (gr = 0; gr < m_MP3DecInfo->nGrans; gr++) {
-        for (ch = 0; ch < m_MP3DecInfo->nChans; ch++) {
-            /* unpack scale factors and compute size of scale factor block */
-            prevBitOffset = bitOffset;
-            offset = UnpackScaleFactors( mainPtr, &bitOffset,
-                    mainBits, gr, ch);
-            sfBlockBits = 8 * offset - prevBitOffset + bitOffset;
-            huffBlockBits = m_MP3DecInfo->part23Length[gr][ch] - sfBlockBits;
-            mainPtr += offset;
-            mainBits -= sfBlockBits;
-
-            if (offset < 0 || mainBits < huffBlockBits) {
-                MP3ClearBadFrame(outbuf);
-                return ERR_MP3_INVALID_SCALEFACT;
-            }
-            /* decode Huffman code words */
-            prevBitOffset = bitOffset;
-            offset = DecodeHuffman( mainPtr, &bitOffset, huffBlockBits, gr, ch);
-            if (offset < 0) {
-                MP3ClearBadFrame( outbuf);
-                return ERR_MP3_INVALID_HUFFCODES;
-            }
-            mainPtr += offset;
-            mainBits -= (8 * offset - prevBitOffset + bitOffset);
-        }
-        /* dequantize coefficients, decode stereo, reorder short blocks */
-        if (MP3Dequantize( gr) < 0) {
+/***********************************************************************************************************************
+ * Function:    DecodeGranule
+ *
+ * Description: unpack scale factors, decode Huffman code words and dequantize one granule, all channels
+ *
+ * Inputs:      index of granule, after DecodeHeader and DecodeGranule for the granules before it
+ *              outbuf to clear on errors, may be NULL
+ *
+ * Outputs:     dequantized coefficients in m_HuffmanInfo->huffDecBuf
+ *              main data of the next granule in m_mainPtr, m_mainBitOffset and m_mainBits
+ *
+ * Return:      error code, defined in mp3dec.h (0 means no error, < 0 means error)
+ **********************************************************************************************************************/
+static int DecodeGranule(int gr, short *outbuf){
+    int offset, ch, prevBitOffset, sfBlockBits, huffBlockBits;
+    HELIX_PROF_T(prof);
+
+    for (ch = 0; ch < m_MP3DecInfo->nChans; ch++) {
+        /* unpack scale factors and compute size of scale factor block */
+        prevBitOffset = m_mainBitOffset;
+        offset = UnpackScaleFactors( m_mainPtr, &m_mainBitOffset,
+                m_mainBits, gr, ch);
+        sfBlockBits = 8 * offset - prevBitOffset + m_mainBitOffset;
+        huffBlockBits = m_MP3DecInfo->part23Length[gr][ch] - sfBlockBits;
+        m_mainPtr += offset;
+        m_mainBits -= sfBlockBits;
+
+        if (offset < 0 || m_mainBits < huffBlockBits) {
             MP3ClearBadFrame(outbuf);
-            return ERR_MP3_INVALID_DEQUANTIZE;
+            return ERR_MP3_INVALID_SCALEFACT;
+        }
+        /* decode Huffman code words */
+        prevBitOffset = m_mainBitOffset;
+        offset = DecodeHuffman( m_mainPtr, &m_mainBitOffset, huffBlockBits, gr, ch);
+        if (offset < 0) {
+            MP3ClearBadFrame( outbuf);
+            return ERR_MP3_INVALID_HUFFCODES;
         }
+        m_mainPtr += offset;
+        m_mainBits -= (8 * offset - prevBitOffset + m_mainBitOffset);
+    }
+    HELIX_PROF_ADD(m_prof[MP3_PROF_HUFFMAN], prof);
+    /* dequantize coefficients, decode stereo, reorder short blocks */
+    if (MP3Dequantize( gr) < 0) {
+        MP3ClearBadFrame(outbuf);
+        return ERR_MP3_INVALID_DEQUANTIZE;
+    }
+    HELIX_PROF_ADD(m_prof[MP3_PROF_DEQUANT], prof);
+    return ERR_MP3_NONE;
+}
+/***********************************************************************************************************************
+ * Function:    BlockCutoff
+ *
+ * Description: number of long blocks of a mixed block, for the IMDCT
+ **********************************************************************************************************************/
+static int BlockCutoff(){
+    return m_SFBandTable.l[(m_MPEGVersion == MPEG1 ? 8 : 6)] / 18; /* same as 3* num short sfb's in spec */
+}
+/***********************************************************************************************************************
+ * Function:    MP3Decode
+ *
+ * Description: decode one frame of MP3 data
+ *
+ * Inputs:      number of valid bytes remaining in inbuf
+ *              pointer to outbuf, big enough to hold one frame of decoded PCM samples
+ *              flag indicating whether MP3 data is normal MPEG format (useSize = 0)
+ *              or reformatted as "self-contained" frames (useSize = 1)
+ *
+ * Outputs:     PCM data in outbuf, interleaved LRLRLR... if stereo
+ *              number of output samples = nGrans * nGranSamps * nChans
+ *              updated inbuf pointer, updated bytesLeft
+ *
+ * Return:      error code, defined in mp3dec.h (0 means no error, < 0 means error)
+ *
+ * Notes:       switching useSize on and off between frames in the same stream
+ *                is not supported (bit reservoir is not maintained if useSize on)
+ **********************************************************************************************************************/
+int MP3Decode( unsigned char *inbuf, int *bytesLeft, short *outbuf, int useSize){
+    int err, gr, ch, blockCutoff;
+
+    err = DecodeHeader(inbuf, bytesLeft, outbuf, useSize);
+    if (err)
+        return err;
+    blockCutoff = BlockCutoff();
+
+    /* decode one complete frame */
+    for (gr = 0; gr < m_MP3DecInfo->nGrans; gr++) {
+        err = DecodeGranule(gr, outbuf);
+        if (err)
+            return err;
+        HELIX_PROF_T(prof);
 
         /* alias reduction, inverse MDCT, overlap-add, frequency inversion */
         for (ch = 0; ch < m_MP3DecInfo->nChans; ch++) {
-            if (IMDCT( gr, ch) < 0) {
+            if (IMDCT(m_HuffmanInfo->huffDecBuf[ch], &m_HuffmanInfo->nonZeroBound[ch], m_HuffmanInfo->gb[ch],
+                      &m_SideInfoSub[gr][ch], blockCutoff, ch) < 0) {
                 MP3ClearBadFrame(outbuf);
                 return ERR_MP3_INVALID_IMDCT;
             }
         }
+        HELIX_PROF_ADD(m_prof[MP3_PROF_IMDCT], prof);
         /* subband transform - if stereo, interleaves pcm LRLRLR */
         if (Subband(
-                outbuf + gr * m_MP3DecInfo->nGranSamps * m_MP3DecInfo->nChans)
-                < 0) {
+                outbuf + gr * (m_MP3DecInfo->nGranSamps >> m_halfRate) * m_MP3DecInfo->nChans,
+                m_MP3DecInfo->nChans) < 0) {
             MP3ClearBadFrame(outbuf);
             return ERR_MP3_INVALID_SUBBAND;
         }
+        HELIX_PROF_ADD(m_prof[MP3_PROF_SUBBAND], prof);
     }
     MP3GetLastFrameInfo();
     return ERR_MP3_NONE;
 }
+/***********************************************************************************************************************
+ * Function:    MP3DecodeHeader, MP3DecodeGranule, MP3GetGranules
+ *
+ * Description: stage 1 of decoding in two stages: frame header, side info and bit reservoir of one frame, then
+ *                scale factors, Huffman code words and dequantizing of every granule of that frame
+ *
+ * Inputs:      as MP3Decode (MP3DecodeHeader)
+ *              index of granule, 0 .. MP3GetGranules() - 1 in order, and buffer for its data (MP3DecodeGranule)
+ *
+ * Outputs:     updated bytesLeft, frame info as after MP3Decode (MP3DecodeHeader)
+ *              everything stage 2 needs for the granule in gran (MP3DecodeGranule)
+ *
+ * Return:      error code, as MP3Decode (MP3DecodeHeader, MP3DecodeGranule)
+ *              number of granules in the frame, 1 or 2 (MP3GetGranules)
+ *
+ * Notes:       stage 2 (MP3SynthGranule) only uses gran and the IMDCT and subband state, so the stages may run
+ *                at the same time in two tasks on the same decoder instance
+ **********************************************************************************************************************/
+int MP3DecodeHeader(unsigned char *inbuf, int *bytesLeft, int useSize){
+    int err;
+
+    err = DecodeHeader(inbuf, bytesLeft, NULL, useSize);
+    if (err == ERR_MP3_NONE)
+        MP3GetLastFrameInfo();
+    return err;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int MP3DecodeGranule(int gr, MP3Granule_t *gran){
+    int err, ch;
+
+    err = DecodeGranule(gr, NULL);
+    if (err)
+        return err;
+    for (ch = 0; ch < m_MP3DecInfo->nChans; ch++) {
+        memcpy(gran->coef[ch], m_HuffmanInfo->huffDecBuf[ch], sizeof(gran->coef[ch]));
+        gran->sis[ch] = m_SideInfoSub[gr][ch];
+        gran->nonZeroBound[ch] = m_HuffmanInfo->nonZeroBound[ch];
+        gran->gb[ch] = m_HuffmanInfo->gb[ch];
+    }
+    gran->blockCutoff = BlockCutoff();
+    gran->nChans = m_MP3DecInfo->nChans;
+    return ERR_MP3_NONE;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int MP3GetGranules(){return m_MP3DecInfo->nGrans;}
+/***********************************************************************************************************************
+ * Function:    MP3SynthGranule
+ *
+ * Description: stage 2 of decoding in two stages: alias reduction, IMDCT, overlap-add and polyphase synthesis of
+ *                one granule of MP3DecodeGranule
+ *
+ * Inputs:      data of the granule, the granules of a stream in the order of decoding
+ *              pointer to outbuf for nGranSamps samples per channel (half of that at half rate)
+ *
+ * Outputs:     PCM data in outbuf, interleaved LRLRLR... if stereo
+ *              gran->coef is used as work buffer
+ *
+ * Return:      error code, as MP3Decode
+ **********************************************************************************************************************/
+int MP3SynthGranule(MP3Granule_t *gran, short *outbuf){
+    int ch;
+    HELIX_PROF_T(prof);
+
+    for (ch = 0; ch < gran->nChans; ch++) {
+        if (IMDCT(gran->coef[ch], &gran->nonZeroBound[ch], gran->gb[ch], &gran->sis[ch], gran->blockCutoff, ch) < 0)
+            return ERR_MP3_INVALID_IMDCT;
+    }
+    HELIX_PROF_ADD(m_prof[MP3_PROF_IMDCT], prof);
+    if (Subband(outbuf, gran->nChans) < 0)
+        return ERR_MP3_INVALID_SUBBAND;
+    HELIX_PROF_ADD(m_prof[MP3_PROF_SUBBAND], prof);
+    return ERR_MP3_NONE;
+}
 
 /***********************************************************************************************************************
  * Function:    MP3Decoder_ClearBuffer
@@ -1508,9 +1846,29 @@ void MP3Decoder_ClearBuffer(void) {
  * Return:      pointer to MP3DecInfo structure (initialized with pointers to all
  *                the internal buffers needed for decoding)
  *
+ * Notes:       the buffers are taken from the codec arena if it is free, otherwise from the heap
  **********************************************************************************************************************/
 bool MP3Decoder_AllocateBuffers(void) {
 
+    // first choice is the codec arena: one static block, no heap fragmentation
+    if(!m_MP3DecInfo && CodecArena_Claim(m_mp3)) {
+        m_MP3DecInfo   = (MP3DecInfo_t*)    CodecArena_Alloc(m_mp3, sizeof(MP3DecInfo_t),    "MP3DecInfo");
+        m_FrameHeader  = (FrameHeader_t*)   CodecArena_Alloc(m_mp3, sizeof(FrameHeader_t),   "FrameHeader");
+        m_SideInfo     = (SideInfo_t*)      CodecArena_Alloc(m_mp3, sizeof(SideInfo_t),      "SideInfo");
+        m_ScaleFactorJS= (ScaleFactorJS_t*) CodecArena_Alloc(m_mp3, sizeof(ScaleFactorJS_t), "ScaleFactorJS");
+        m_HuffmanInfo  = (HuffmanInfo_t*)   CodecArena_Alloc(m_mp3, sizeof(HuffmanInfo_t),   "HuffmanInfo");
+        m_DequantInfo  = (DequantInfo_t*)   CodecArena_Alloc(m_mp3, sizeof(DequantInfo_t),   "DequantInfo");
+        m_IMDCTInfo    = (IMDCTInfo_t*)     CodecArena_Alloc(m_mp3, sizeof(IMDCTInfo_t),     "IMDCTInfo");
+        m_SubbandInfo  = (SubbandInfo_t*)   CodecArena_Alloc(m_mp3, sizeof(SubbandInfo_t),   "SubbandInfo");
+        m_MP3FrameInfo = (MP3FrameInfo_t*)  CodecArena_Alloc(m_mp3, sizeof(MP3FrameInfo_t),  "MP3FrameInfo");
+        if(m_MP3DecInfo && m_FrameHeader && m_SideInfo && m_ScaleFactorJS && m_HuffmanInfo &&
+           m_DequantInfo && m_IMDCTInfo && m_SubbandInfo && m_MP3FrameInfo) {
+            MP3Decoder_ClearBuffer();
+            return true; // success, all buffers in the arena
+        }
+        MP3Decoder_FreeBuffers(); // budget too small (should not happen), use the heap
+    }
+
     // try first SRAM because its faster than PSRAM
 
 
@@ -1576,6 +1934,14 @@ void MP3Decoder_FreeBuffers()
 {
 //    uint32_t i = ESP.getFreeHeap();
 
+    if(CodecArena_IsOwner(m_mp3)) {
+        // buffers are in the codec arena, just give it back
+        m_MP3DecInfo = NULL; m_FrameHeader = NULL; m_SideInfo = NULL; m_ScaleFactorJS = NULL; m_HuffmanInfo = NULL;
+        m_DequantInfo = NULL; m_IMDCTInfo = NULL; m_SubbandInfo = NULL; m_MP3FrameInfo = NULL;
+        CodecArena_Release(m_mp3);
+        return;
+    }
+
     if(m_MP3DecInfo)        {free(m_MP3DecInfo);      m_MP3DecInfo=NULL;}
     if(m_FrameHeader)       {free(m_FrameHeader);     m_FrameHeader=NULL;}
     if(m_SideInfo)          {free(m_SideInfo);        m_SideInfo=NULL;}
@@ -1588,6 +1954,94 @@ void MP3Decoder_FreeBuffers()
 
 //    log_i("MP3Decoder: %lu bytes memory was freed", ESP.getFreeHeap() - i);
 }
+/***********************************************************************************************************************
+ * Function:    MP3Decoder_AllocateBuffers, MP3Decoder_FreeBuffers, MP3Decode, MP3DecodeHeader, MP3DecodeGranule,
+ *              MP3SynthGranule
+ *
+ * Description: same as the functions above, but for the decoder instance ctx instead of the default one
+ *
+ * Inputs:      pointer to decoder instance, zero-initialized before first use
+ *              other inputs as above
+ *
+ * Notes:       the previous instance is restored on return, so these may be mixed freely with the calls
+ *                without context in the same task
+ **********************************************************************************************************************/
+bool MP3Decoder_AllocateBuffers(MP3Decoder_t *ctx) {
+    MP3Decoder_t *prev = m_mp3;
+    bool res;
+
+    m_mp3 = ctx;
+    res = MP3Decoder_AllocateBuffers();
+    m_mp3 = prev;
+    return res;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void MP3Decoder_FreeBuffers(MP3Decoder_t *ctx) {
+    MP3Decoder_t *prev = m_mp3;
+
+    m_mp3 = ctx;
+    MP3Decoder_FreeBuffers();
+    m_mp3 = prev;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int MP3Decode(MP3Decoder_t *ctx, unsigned char *inbuf, int *bytesLeft, short *outbuf, int useSize) {
+    MP3Decoder_t *prev = m_mp3;
+    int err;
+
+    m_mp3 = ctx;
+    err = MP3Decode(inbuf, bytesLeft, outbuf, useSize);
+    m_mp3 = prev;
+    return err;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int MP3DecodeHeader(MP3Decoder_t *ctx, unsigned char *inbuf, int *bytesLeft, int useSize) {
+    MP3Decoder_t *prev = m_mp3;
+    int err;
+
+    m_mp3 = ctx;
+    err = MP3DecodeHeader(inbuf, bytesLeft, useSize);
+    m_mp3 = prev;
+    return err;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int MP3DecodeGranule(MP3Decoder_t *ctx, int gr, MP3Granule_t *gran) {
+    MP3Decoder_t *prev = m_mp3;
+    int err;
+
+    m_mp3 = ctx;
+    err = MP3DecodeGranule(gr, gran);
+    m_mp3 = prev;
+    return err;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int MP3SynthGranule(MP3Decoder_t *ctx, MP3Granule_t *gran, short *outbuf) {
+    MP3Decoder_t *prev = m_mp3;
+    int err;
+
+    m_mp3 = ctx;
+    err = MP3SynthGranule(gran, outbuf);
+    m_mp3 = prev;
+    return err;
+}
+/***********************************************************************************************************************
+ * Function:    MP3Decoder_Select
+ *
+ * Description: select the decoder instance used by the functions without context in the calling task
+ *
+ * Inputs:      pointer to decoder instance, zero-initialized before first use, NULL for the default one
+ *
+ * Outputs:     none
+ *
+ * Return:      the instance selected before, NULL if that was the default one
+ *
+ * Notes:       for a task that switches between streams, like a crossfade with two decoders running at once
+ **********************************************************************************************************************/
+MP3Decoder_t *MP3Decoder_Select(MP3Decoder_t *ctx) {
+    MP3Decoder_t *prev = m_mp3;
+
+    m_mp3 = ctx ? ctx : &m_MP3Decoder;
+    return (prev == &m_MP3Decoder) ? NULL : prev;
+}
 
 /***********************************************************************************************************************
  * H U F F M A N N
@@ -1614,11 +2068,12 @@ void MP3Decoder_FreeBuffers()
  *                necessarily all linBits outputs for x,y > 15)
  **********************************************************************************************************************/
 // no improvement with section=data
-int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset){
+int HELIX_IRAM DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset){
     int i, x, y;
     int cachedBits, padBits, len, startBits, linBits, maxBits, minBits;
     HuffTabType_t tabType;
     unsigned short cw, *tBase, *tCurr;
+    const uint16_t *fTab;
     unsigned int cache;
 
     if (nVals <= 0)
@@ -1724,6 +2179,7 @@ int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsigned ch
         return (startBits - bitsLeft);
     } else if (tabType == loopLinbits || tabType == loopNoLinbits) {
         tCurr = tBase;
+        fTab = huffFast.tab[huffFastRow[tabIdx]];
         padBits = 0;
         while (nVals > 0) {
             /* refill cache - assumes cachedBits <= 16 */
@@ -1751,6 +2207,19 @@ int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsigned ch
 
             /* largest maxBits = 9, plus 2 for sign bits, so make sure cache has at least 11 bits */
             while (nVals > 0 && cachedBits >= 11) {
+                /* most code words (with sign bits) are resolved by the first level lookup */
+                cw = (tCurr == tBase) ? pgm_read_word(&fTab[cache >> (32 - m_HUFF_FASTBITS)]) : 0;
+                if (cw) {
+                    len = cw >> 12;
+                    cachedBits -= len;
+                    cache <<= len;
+                    if (cachedBits < padBits)
+                        return -1;
+                    *xy++ = (cw & 0x0f) | ((unsigned int)(cw & 0x0010) << 27);
+                    *xy++ = ((cw >> 5) & 0x0f) | ((unsigned int)(cw & 0x0200) << 22);
+                    nVals -= 2;
+                    continue;
+                }
                 maxBits = (int)( (((unsigned short)(pgm_read_word(&tCurr[0]))) >>  0) & 0x000f);
                 cw = pgm_read_word(&tCurr[(cache >> (32 - maxBits)) + 1]);
                 len=(int)( (((unsigned short)(cw)) >> 12) & 0x000f);
@@ -1852,7 +2321,7 @@ int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsigned ch
  * Notes:        si_huff.bit tests every vwxy output in both quad tables
  **********************************************************************************************************************/
 // no improvement with section=data
-int DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset){
+int HELIX_IRAM DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset){
     int i, v, w, x, y;
     int len, maxBits, cachedBits, padBits;
     unsigned int cache;
@@ -2946,7 +3415,7 @@ int FreqInvertRescale(int *y, int *xPrev, int blockIdx, int es){
 
 
 /* require at least 3 guard bits in x[] to ensure no overflow */
-void idct9(int *x) {
+void HELIX_IRAM idct9(int *x) {
     int a1, a2, a3, a4, a5, a6, a7, a8, a9;
     int a10, a11, a12, a13, a14, a15, a16, a17, a18;
     int a19, a20, a21, a22, a23, a24, a25, a26, a27;
@@ -3058,7 +3527,7 @@ void idct9(int *x) {
  **********************************************************************************************************************/
 // barely faster in RAM
 
-int IMDCT36(int *xCurr, int *xPrev, int *y, int btCurr, int btPrev, int blockIdx, int gb){
+int HELIX_IRAM IMDCT36(int *xCurr, int *xPrev, int *y, int btCurr, int btPrev, int blockIdx, int gb){
     int i, es, xBuf[18], xPrevWin[18];
     int acc1, acc2, s, d, t, mOut;
     int xo, xe, c, *xp, yLo, yHi;
@@ -3414,37 +3883,38 @@ int HybridTransform(int *xCurr, int *xPrev, int y[m_BLOCK_SIZE][m_NBANDS], SideI
  *
  * Description: do alias reduction, inverse MDCT, overlap-add, and frequency inversion
  *
- * Inputs:      MP3DecInfo structure filled by UnpackFrameHeader(), UnpackSideInfo(),
- *                UnpackScaleFactors(), and DecodeHuffman() (for this granule, channel)
- *                includes PCM samples in overBuf (from last call to IMDCT) for OLA
- *              index of current granule and channel
+ * Inputs:      dequantized coefficients, nonZeroBound, guard bits and side info of one granule and channel,
+ *                from UnpackScaleFactors(), DecodeHuffman() and MP3Dequantize()
+ *              number of long blocks of a mixed block
+ *              index of channel, PCM samples in overBuf (from last call to IMDCT) for OLA
  *
  * Outputs:     PCM samples in outBuf, for input to subband transform
  *              PCM samples in overBuf, for OLA next time
- *              updated hi->nonZeroBound index for this channel
+ *              updated nonZeroBound for this channel, coef is used as work buffer
  *
  * Return:      0 on success,  -1 if null input pointers
  **********************************************************************************************************************/
 // a bit faster in RAM
 /*__attribute__ ((section (".data")))*/
-int IMDCT( int gr, int ch) {
-    int nBfly, blockCutoff;
+int IMDCT(int *coef, int *nonZeroBound, int gb, SideInfoSub_t *sis, int blockCutoff, int ch) {
+    int nBfly;
     BlockCount_t bc;
 
-    /* m_SideInfo is an array of up to 4 structs, stored as gr0ch0, gr0ch1, gr1ch0, gr1ch1 */
     /* anti-aliasing done on whole long blocks only
      * for mixed blocks, nBfly always 1, except 3 for 8 kHz MPEG 2.5 (see sfBandTab)
      *   nLongBlocks = number of blocks with (possibly) non-zero power
      *   nBfly = number of butterflies to do (nLongBlocks - 1, unless no long blocks)
      */
-    blockCutoff = m_SFBandTable.l[(m_MPEGVersion == MPEG1 ? 8 : 6)] / 18; /* same as 3* num short sfb's in spec */
-    if (m_SideInfoSub[gr][ch].blockType != 2) {
+    if (m_halfRate && *nonZeroBound > (m_NBANDS / 2) * 18)
+        *nonZeroBound = (m_NBANDS / 2) * 18;  /* half rate: upper 16 subbands are not used */
+    if (sis->blockType != 2) {
         /* all long transforms */
-        int x=(m_HuffmanInfo->nonZeroBound[ch] + 7) / 18 + 1;
-        bc.nBlocksLong=(x<32 ? x : 32);
+        int x=(*nonZeroBound + 7) / 18 + 1;
+        int maxBlocks = m_NBANDS >> m_halfRate;
+        bc.nBlocksLong=(x<maxBlocks ? x : maxBlocks);
         //bc.nBlocksLong = MIN((hi->nonZeroBound[ch] + 7) / 18 + 1, 32);
         nBfly = bc.nBlocksLong - 1;
-    } else if (m_SideInfoSub[gr][ch].blockType == 2 && m_SideInfoSub[gr][ch].mixedBlock) {
+    } else if (sis->blockType == 2 && sis->mixedBlock) {
         /* mixed block - long transforms until cutoff, then short transforms */
         bc.nBlocksLong = blockCutoff;
         nBfly = bc.nBlocksLong - 1;
@@ -3454,25 +3924,25 @@ int IMDCT( int gr, int ch) {
         nBfly = 0;
     }
 
-    AntiAlias(m_HuffmanInfo->huffDecBuf[ch], nBfly);
-    int x=m_HuffmanInfo->nonZeroBound[ch];
+    AntiAlias(coef, nBfly);
+    int x=*nonZeroBound;
     int y=nBfly * 18 + 8;
-    m_HuffmanInfo->nonZeroBound[ch]=(x>y ? x: y);
+    *nonZeroBound=(x>y ? x: y);
 
-    assert(m_HuffmanInfo->nonZeroBound[ch] <= m_MAX_NSAMP);
+    assert(*nonZeroBound <= m_MAX_NSAMP);
 
     /* for readability, use a struct instead of passing a million parameters to HybridTransform() */
-    bc.nBlocksTotal = (m_HuffmanInfo->nonZeroBound[ch] + 17) / 18;
+    bc.nBlocksTotal = (*nonZeroBound + 17) / 18;
     bc.nBlocksPrev = m_IMDCTInfo->numPrevIMDCT[ch];
     bc.prevType = m_IMDCTInfo->prevType[ch];
     bc.prevWinSwitch = m_IMDCTInfo->prevWinSwitch[ch];
     /* where WINDOW switches (not nec. transform) */
-    bc.currWinSwitch = (m_SideInfoSub[gr][ch].mixedBlock ? blockCutoff : 0);
-    bc.gbIn = m_HuffmanInfo->gb[ch];
+    bc.currWinSwitch = (sis->mixedBlock ? blockCutoff : 0);
+    bc.gbIn = gb;
 
-    m_IMDCTInfo->numPrevIMDCT[ch] = HybridTransform(m_HuffmanInfo->huffDecBuf[ch], m_IMDCTInfo->overBuf[ch],
-            m_IMDCTInfo->outBuf[ch], &m_SideInfoSub[gr][ch], &bc);
-    m_IMDCTInfo->prevType[ch] = m_SideInfoSub[gr][ch].blockType;
+    m_IMDCTInfo->numPrevIMDCT[ch] = HybridTransform(coef, m_IMDCTInfo->overBuf[ch],
+            m_IMDCTInfo->outBuf[ch], sis, &bc);
+    m_IMDCTInfo->prevType[ch] = sis->blockType;
     m_IMDCTInfo->prevWinSwitch[ch] = bc.currWinSwitch; /* 0 means not a mixed block (either all short or all long) */
     m_IMDCTInfo->gb[ch] = bc.gbOut;
 
@@ -3491,16 +3961,16 @@ int IMDCT( int gr, int ch) {
  *
  * Description: do subband transform on all the blocks in one granule, all channels
  *
- * Inputs:      filled MP3DecInfo structure, after calling IMDCT for all channels
+ * Inputs:      number of channels, after calling IMDCT for all channels
  *              vbuf[ch] and vindex[ch] must be preserved between calls
  *
  * Outputs:     decoded PCM data, interleaved LRLRLR... if stereo
  *
  * Return:      0 on success,  -1 if null input pointers
  **********************************************************************************************************************/
-int Subband( short *pcmBuf) {
+int Subband( short *pcmBuf, int nChans) {
     int b;
-    if (m_MP3DecInfo->nChans == 2) {
+    if (nChans == 2) {
         /* stereo */
         for (b = 0; b < m_BLOCK_SIZE; b++) {
             FDCT32(m_IMDCTInfo->outBuf[0][b], m_SubbandInfo->vbuf + 0 * 32, m_SubbandInfo->vindex,
@@ -3511,7 +3981,7 @@ int Subband( short *pcmBuf) {
                     m_SubbandInfo->vbuf + m_SubbandInfo->vindex + m_VBUF_LENGTH * (b & 0x01),
                     polyCoef);
             m_SubbandInfo->vindex = (m_SubbandInfo->vindex - (b & 0x01)) & 7;
-            pcmBuf += (2 * m_NBANDS);
+            pcmBuf += (2 * m_NBANDS) >> m_halfRate;
         }
     } else {
         /* mono */
@@ -3522,7 +3992,7 @@ int Subband( short *pcmBuf) {
                     m_SubbandInfo->vbuf + m_SubbandInfo->vindex + m_VBUF_LENGTH * (b & 0x01),
                     polyCoef);
             m_SubbandInfo->vindex = (m_SubbandInfo->vindex - (b & 0x01)) & 7;
-            pcmBuf += m_NBANDS;
+            pcmBuf += m_NBANDS >> m_halfRate;
         }
     }
 
@@ -3558,7 +4028,7 @@ int Subband( short *pcmBuf) {
  *                combinations of max pos/max neg values in x[]
  **********************************************************************************************************************/
 // about 1ms faster in RAM
-void FDCT32(int *buf, int *dest, int offset, int oddBlock, int gb){
+void HELIX_IRAM FDCT32(int *buf, int *dest, int offset, int oddBlock, int gb){
     int i, s, tmp, es;
     const uint32_t *cptr = m_dcttab;
     int a0, a1, a2, a3, a4, a5, a6, a7;
@@ -3738,17 +4208,18 @@ short ClipToShort(int x, int fracBits){
  *                (see additional scaling comments below)
  *
  * Outputs:     32 samples of one channel of decoded PCM data, (i.e. Q16.0)
+ *              16 samples (the even ones) in half rate mode
  *
  * Return:      none
  **********************************************************************************************************************/
-void PolyphaseMono(short *pcm, int *vbuf, const uint32_t *coefBase){
-    int i;
+void HELIX_IRAM PolyphaseMono(short *pcm, int *vbuf, const uint32_t *coefBase){
+    int i, h = m_halfRate;
     const uint32_t *coef;
     int *vb1;
     int vLo, vHi, c1, c2;
     uint64_t sum1L, sum2L, rndVal;
 
-    rndVal = (uint64_t)( 1ULL << ((m_DQ_FRACBITS_OUT - 2 - 2 - 1) - 1 + (32 - m_CSHIFT)) );
+    rndVal = (uint64_t)( 1ULL << ((m_DQ_FRACBITS_OUT - 2 - 2 - 15) - 1 + (32 - m_CSHIFT)) );
 
     /* special case, output sample 0 */
     coef = coefBase;
@@ -3767,15 +4238,20 @@ void PolyphaseMono(short *pcm, int *vbuf, const uint32_t *coefBase){
     for(int j=0; j<8; j++){
         c1=*coef; coef++; vLo=*(vb1+(j)); sum1L = MADD64(sum1L, vLo,  c1); // 0...7
     }
-    *(pcm + 16) = ClipToShort((int)SAR64(sum1L, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
+    *(pcm + (16 >> h)) = ClipToShort((int)SAR64(sum1L, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
 
     /* main convolution loop: sum1L = samples 1, 2, 3, ... 15   sum2L = samples 31, 30, ... 17 */
     coef = coefBase + 16;
     vb1 = vbuf + 64;
-    pcm++;
 
     /* right now, the compiler creates bad asm from this... */
     for (i = 15; i > 0; i--) {
+        if (h && (i & 0x01)) {
+            /* half rate: odd samples are not needed */
+            coef += 16;
+            vb1 += 64;
+            continue;
+        }
         sum1L = sum2L = rndVal;
         for(int j=0; j<8; j++){
             c1=*coef; coef++; c2=*coef; coef++; vLo=*(vb1+(j)); vHi = *(vb1+(23-(j)));
@@ -3783,9 +4259,8 @@ void PolyphaseMono(short *pcm, int *vbuf, const uint32_t *coefBase){
             sum1L=MADD64(sum1L, vHi, -c2); sum2L = MADD64(sum2L, vHi,  c1);
         }
         vb1 += 64;
-        *(pcm)       = ClipToShort((int)SAR64(sum1L, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
-        *(pcm + 2*i) = ClipToShort((int)SAR64(sum2L, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
-        pcm++;
+        *(pcm + ((16 - i) >> h)) = ClipToShort((int)SAR64(sum1L, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
+        *(pcm + ((16 + i) >> h)) = ClipToShort((int)SAR64(sum2L, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
     }
 }
 /***********************************************************************************************************************
@@ -3801,13 +4276,14 @@ void PolyphaseMono(short *pcm, int *vbuf, const uint32_t *coefBase){
  *                (see additional scaling comments below)
  *
  * Outputs:     32 samples of two channels of decoded PCM data, (i.e. Q16.0)
+ *              16 samples (the even ones) in half rate mode
  *
  * Return:      none
  *
  * Notes:       interleaves PCM samples LRLRLR...
  **********************************************************************************************************************/
-void PolyphaseStereo(short *pcm, int *vbuf, const uint32_t *coefBase){
-    int i;
+void HELIX_IRAM PolyphaseStereo(short *pcm, int *vbuf, const uint32_t *coefBase){
+    int i, h = m_halfRate;
     const uint32_t *coef;
     int *vb1;
     int vLo, vHi, c1, c2;
@@ -3838,16 +4314,21 @@ void PolyphaseStereo(short *pcm, int *vbuf, const uint32_t *coefBase){
         c1=*coef; coef++; vLo = *(vb1+(j)); sum1L = MADD64(sum1L, vLo,  c1);
         vLo = *(vb1+32+(j)); sum1R = MADD64(sum1R, vLo,  c1);
     }
-    *(pcm + 2*16 + 0) = ClipToShort((int)SAR64(sum1L, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
-    *(pcm + 2*16 + 1) = ClipToShort((int)SAR64(sum1R, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
+    *(pcm + 2*(16 >> h) + 0) = ClipToShort((int)SAR64(sum1L, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
+    *(pcm + 2*(16 >> h) + 1) = ClipToShort((int)SAR64(sum1R, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
 
     /* main convolution loop: sum1L = samples 1, 2, 3, ... 15   sum2L = samples 31, 30, ... 17 */
     coef = coefBase + 16;
     vb1 = vbuf + 64;
-    pcm += 2;
 
     /* right now, the compiler creates bad asm from this... */
     for (i = 15; i > 0; i--) {
+        if (h && (i & 0x01)) {
+            /* half rate: odd samples are not needed */
+            coef += 16;
+            vb1 += 64;
+            continue;
+        }
         sum1L = sum2L = rndVal;
         sum1R = sum2R = rndVal;
 
@@ -3860,10 +4341,9 @@ void PolyphaseStereo(short *pcm, int *vbuf, const uint32_t *coefBase){
             sum1R=MADD64(sum1R, vHi, -c2); sum2R=MADD64(sum2R, vHi,  c1);
         }
         vb1 += 64;
-        *(pcm + 0)         = ClipToShort((int)SAR64(sum1L, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
-        *(pcm + 1)         = ClipToShort((int)SAR64(sum1R, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
-        *(pcm + 2*2*i + 0) = ClipToShort((int)SAR64(sum2L, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
-        *(pcm + 2*2*i + 1) = ClipToShort((int)SAR64(sum2R, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
-        pcm += 2;
+        *(pcm + 2*((16 - i) >> h) + 0) = ClipToShort((int)SAR64(sum1L, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
+        *(pcm + 2*((16 - i) >> h) + 1) = ClipToShort((int)SAR64(sum1R, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
+        *(pcm + 2*((16 + i) >> h) + 0) = ClipToShort((int)SAR64(sum2L, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
+        *(pcm + 2*((16 + i) >> h) + 1) = ClipToShort((int)SAR64(sum2R, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
     }
 }
@@ -4,6 +4,8 @@
 
 #include "Arduino.h"
 #include "assert.h"
+#include "codec_arena.h"
+#include "helix_placement.h"
 
 static const uint8_t  m_HUFF_PAIRTABS          =32;
 static const uint8_t  m_BLOCK_SIZE             =18;
@@ -34,6 +36,19 @@ enum {
     ERR_UNKNOWN =                  -9999
 };
 
+enum {                  /* extra return value of MP3FindSyncWord */
+    MP3_SYNC_MOREDATA =            -2   /* first frame not confirmed yet, search again with more data */
+};
+
+enum {                  /* decoder stages for HELIX_PROFILE */
+    MP3_PROF_HEADER =               0,  /* frame header, side info, bit reservoir */
+    MP3_PROF_HUFFMAN =              1,  /* scale factors and Huffman decoding */
+    MP3_PROF_DEQUANT =              2,  /* dequantize, stereo processing */
+    MP3_PROF_IMDCT =                3,  /* alias reduction, IMDCT, overlap-add */
+    MP3_PROF_SUBBAND =              4,  /* polyphase synthesis */
+    MP3_PROF_STAGES =               5
+};
+
 typedef struct MP3FrameInfo {
     int bitrate;
     int nChans;
@@ -198,6 +213,46 @@ typedef struct MP3DecInfo {
     int part23Length[m_MAX_NGRAN][m_MAX_NCHAN];
 } MP3DecInfo_t;
 
+typedef struct MP3Decoder {             /* complete state of one decoder instance */
+    MP3FrameInfo_t *MP3FrameInfo;
+    SFBandTable_t SFBandTable;
+    StereoMode_t sMode;                 /* mono/stereo mode */
+    MPEGVersion_t MPEGVersion;          /* version ID */
+    FrameHeader_t *FrameHeader;
+    SideInfoSub_t SideInfoSub[m_MAX_NGRAN][m_MAX_NCHAN];
+    SideInfo_t *SideInfo;
+    CriticalBandInfo_t CriticalBandInfo[m_MAX_NCHAN];  /* filled in dequantizer, used in joint stereo reconstruction */
+    DequantInfo_t *DequantInfo;
+    HuffmanInfo_t *HuffmanInfo;
+    IMDCTInfo_t *IMDCTInfo;
+    ScaleFactorInfoSub_t ScaleFactorInfoSub[m_MAX_NGRAN][m_MAX_NCHAN];
+    ScaleFactorJS_t *ScaleFactorJS;
+    SubbandInfo_t *SubbandInfo;
+    MP3DecInfo_t *MP3DecInfo;
+    int halfRate;                       /* 1: synthesize subbands 0..15 only, output at half the sample rate */
+    uint64_t prof[MP3_PROF_STAGES];     /* cycles per stage, only counted with HELIX_PROFILE */
+    unsigned char *mainPtr;             /* main data of the granule to decode next, see MP3DecodeHeader */
+    int mainBitOffset;
+    int mainBits;
+} MP3Decoder_t;
+
+typedef struct MP3Granule {             /* frequency domain data of one granule, output of stage 1 (MP3DecodeGranule) */
+    int coef[m_MAX_NCHAN][m_MAX_NSAMP]; /* dequantized coefficients, input of the IMDCT (stage 2, MP3SynthGranule) */
+    SideInfoSub_t sis[m_MAX_NCHAN];     /* block type and mixed block flag per channel */
+    int nonZeroBound[m_MAX_NCHAN];      /* last non-zero coefficient + 1 */
+    int gb[m_MAX_NCHAN];                /* guard bits in coef */
+    int blockCutoff;                    /* end of the long blocks of a mixed block */
+    int nChans;
+} MP3Granule_t;
+
+/* compile-time budget of the buffers in the codec arena, see MP3Decoder_AllocateBuffers() */
+static const uint32_t m_ARENA_BUDGET =
+    CODEC_ARENA_ROUND(sizeof(MP3DecInfo_t))    + CODEC_ARENA_ROUND(sizeof(FrameHeader_t))   +
+    CODEC_ARENA_ROUND(sizeof(SideInfo_t))      + CODEC_ARENA_ROUND(sizeof(ScaleFactorJS_t)) +
+    CODEC_ARENA_ROUND(sizeof(HuffmanInfo_t))   + CODEC_ARENA_ROUND(sizeof(DequantInfo_t))   +
+    CODEC_ARENA_ROUND(sizeof(IMDCTInfo_t))     + CODEC_ARENA_ROUND(sizeof(SubbandInfo_t))   +
+    CODEC_ARENA_ROUND(sizeof(MP3FrameInfo_t));
+
 
 
 
@@ -467,6 +522,29 @@ int  MP3GetChannels();
 int  MP3GetBitsPerSample();
 int  MP3GetBitrate();
 int  MP3GetOutputSamps();
+void MP3SetHalfRate(bool on);
+
+// decoding in two stages, for example on two cores: MP3DecodeHeader, then MP3DecodeGranule for granule 0 .. MP3GetGranules()-1
+// (bitstream, Huffman, dequantize), each granule goes to MP3SynthGranule (IMDCT, polyphase synthesis) in the same order
+int  MP3DecodeHeader(unsigned char *inbuf, int *bytesLeft, int useSize);
+int  MP3DecodeGranule(int gr, MP3Granule_t *gran);
+int  MP3GetGranules();
+int  MP3SynthGranule(MP3Granule_t *gran, short *outbuf);
+
+// same functions for a specific decoder instance (zero-initialized MP3Decoder_t), functions above use a default one
+bool MP3Decoder_AllocateBuffers(MP3Decoder_t *ctx);
+void MP3Decoder_FreeBuffers(MP3Decoder_t *ctx);
+int  MP3Decode(MP3Decoder_t *ctx, unsigned char *inbuf, int *bytesLeft, short *outbuf, int useSize);
+int  MP3GetSampRate(MP3Decoder_t *ctx);
+int  MP3GetChannels(MP3Decoder_t *ctx);
+int  MP3GetBitsPerSample(MP3Decoder_t *ctx);
+int  MP3GetBitrate(MP3Decoder_t *ctx);
+int  MP3GetOutputSamps(MP3Decoder_t *ctx);
+void MP3SetHalfRate(MP3Decoder_t *ctx, bool on);
+int  MP3DecodeHeader(MP3Decoder_t *ctx, unsigned char *inbuf, int *bytesLeft, int useSize);
+int  MP3DecodeGranule(MP3Decoder_t *ctx, int gr, MP3Granule_t *gran);
+int  MP3SynthGranule(MP3Decoder_t *ctx, MP3Granule_t *gran, short *outbuf);
+MP3Decoder_t *MP3Decoder_Select(MP3Decoder_t *ctx);   // instance for the functions above, NULL is the default one
 
 //internally used
 void MP3Decoder_ClearBuffer(void);
@@ -486,14 +564,18 @@ int UnpackFrameHeader(unsigned char *buf);
 int UnpackSideInfo(unsigned char *buf);
 int DecodeHuffman( unsigned char *buf, int *bitOffset, int huffBlockBits, int gr, int ch);
 int MP3Dequantize( int gr);
-int IMDCT( int gr, int ch);
+int IMDCT(int *coef, int *nonZeroBound, int gb, SideInfoSub_t *sis, int blockCutoff, int ch);
 int UnpackScaleFactors( unsigned char *buf, int *bitOffset, int bitsAvail, int gr, int ch);
-int Subband(short *pcmBuf);
+int Subband(short *pcmBuf, int nChans);
 short ClipToShort(int x, int fracBits);
 void RefillBitstreamCache(BitStreamInfo_t *bsi);
 void UnpackSFMPEG1(BitStreamInfo_t *bsi, SideInfoSub_t *sis, ScaleFactorInfoSub_t *sfis, int *scfsi, int gr, ScaleFactorInfoSub_t *sfisGr0);
 void UnpackSFMPEG2(BitStreamInfo_t *bsi, SideInfoSub_t *sis, ScaleFactorInfoSub_t *sfis, int gr, int ch, int modeExt, ScaleFactorJS_t *sfjs);
 int MP3FindFreeSync(unsigned char *buf, unsigned char firstFH[4], int nBytes);
+int MP3FindRawSync(unsigned char *buf, int nBytes);
+int MP3GetFrameLength(unsigned char *buf);
+uint64_t MP3GetProfile(int stage);
+void MP3ResetProfile();
 void MP3ClearBadFrame( short *outbuf);
 int DecodeHuffmanPairs(int *xy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset);
 int DecodeHuffmanQuads(int *vwxy, int nVals, int tabIdx, int bitsLeft, unsigned char *buf, int bitOffset);
@@ -0,0 +1,252 @@
+/*
+ * ogg_demux.cpp
+ * Ogg page demultiplexer, see RFC 3533.
+ *
+ * A page is a 27 byte header, up to 255 lacing values and the segments described by them.  A
+ * packet is a sequence of segments ending with a segment shorter than 255 bytes, it may continue
+ * on the next page.  Only the header and the lacing values are stored, the segment data go
+ * straight into the packet buffer of the decoder.
+ * The CRC of a page is known at the end of the page only, when its packets have been handed to
+ * the decoder already.  A CRC error makes the packet that continues on the next page invalid,
+ * the decoders check the packets themselves.
+ */
+#include "ogg_demux.h"
+
+#ifndef MIN
+  #define MIN(a,b)      ((a) < (b) ? (a) : (b))
+#endif
+
+enum {
+    OGG_S_CAPTURE =     0,                              /* searching for "OggS" */
+    OGG_S_HEADER =      1,                              /* receiving header and lacing values */
+    OGG_S_DATA =        2                               /* receiving segments */
+};
+
+/* CRC-32 with polynomial 0x04c11db7, 4 bits at a time */
+static const uint32_t m_oggCrcTab[16] = {
+    0x00000000, 0x04c11db7, 0x09823b6e, 0x0d4326d9, 0x130476dc, 0x17c56b6b, 0x1a864db2, 0x1e475005,
+    0x2608edb8, 0x22c9f00f, 0x2f8ad6d6, 0x2b4bcb61, 0x350c9b64, 0x31cd86d3, 0x3c8ea00a, 0x384fbdbd
+};
+
+static uint32_t OggCrc(uint32_t crc, const uint8_t *buf, int len) {
+    while (len-- > 0) {
+        crc = (crc << 4) ^ m_oggCrcTab[(crc >> 28) ^ (*buf >> 4)];
+        crc = (crc << 4) ^ m_oggCrcTab[(crc >> 28) ^ (*buf++ & 0x0f)];
+    }
+    return crc;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static uint32_t OggLE32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+/***********************************************************************************************************************
+ * Function:    OggDemux_Init
+ *
+ * Description: start searching for a page, no stream is followed
+ *
+ * Inputs:      demuxer
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ *
+ * Notes:       the packet buffer and the statistics are kept
+ **********************************************************************************************************************/
+void OggDemux_Init(OggDemux_t *d) {
+    d->state = OGG_S_CAPTURE;
+    d->fill = 0;
+    d->following = false;
+    d->collect = false;
+    d->pktLen = 0;
+    d->pktOpen = false;
+    d->pktReady = false;
+    d->pktTrunc = false;
+    d->pktLost = false;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OggDemux_SetBuffer(OggDemux_t *d, uint8_t *buf, int size) {
+    d->pkt = buf;
+    d->pktSize = size;
+}
+/***********************************************************************************************************************
+ * Function:    OggDemux_Follow
+ *
+ * Description: collect the packets of the logical stream with this serial number from now on
+ *
+ * Inputs:      demuxer
+ *              serial number, normally the pktSerial of a packet with pktBos set
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ **********************************************************************************************************************/
+void OggDemux_Follow(OggDemux_t *d, uint32_t serial) {
+    d->serial = serial;
+    d->following = true;
+    d->seqNo = d->pageSeq + 1;
+}
+/***********************************************************************************************************************
+ * Function:    OggStartPage
+ *
+ * Description: header and lacing values are complete, decide what to do with the segments
+ *
+ * Inputs:      demuxer
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ *
+ * Notes:       packets are collected from beginning-of-stream pages (for the decoder to choose a stream) and
+ *                from the pages of the followed stream
+ **********************************************************************************************************************/
+static void OggStartPage(OggDemux_t *d) {
+    static const uint8_t zero[4] = {0, 0, 0, 0};
+    uint8_t  type = d->page[5];
+    uint32_t serial = OggLE32(d->page + 14);
+    int      nseg = d->page[26];
+
+    d->crc = OggCrc(0, d->page, 22);                    /* CRC field counts as zero */
+    d->crc = OggCrc(d->crc, zero, 4);
+    d->crc = OggCrc(d->crc, d->page + 26, 1 + nseg);
+    d->granule = (int64_t)OggLE32(d->page + 6) | ((int64_t)OggLE32(d->page + 10) << 32);
+    d->pageSeq = OggLE32(d->page + 18);
+    d->pages++;
+    d->seg = 0;
+    d->segLeft = nseg ? d->page[OGG_HDRSIZE] : 0;
+    d->state = OGG_S_DATA;
+    if (type & 0x02) {                                  /* beginning of a stream, always one complete packet */
+        d->collect = true;
+        d->pktLen = 0;
+        d->pktOpen = false;
+        d->pktLost = false;
+        d->pktTrunc = false;
+        return;
+    }
+    d->collect = (d->following && serial == d->serial);
+    if (!d->collect)
+        return;
+    if (d->pageSeq != d->seqNo && d->pktOpen)           /* page lost, middle of packet missing */
+        d->pktLost = true;
+    d->seqNo = d->pageSeq + 1;
+    if (type & 0x01) {                                  /* page starts with the rest of a packet */
+        if (!d->pktOpen) {                              /* but we do not have the start */
+            d->pktOpen = true;
+            d->pktLost = true;
+        }
+    }
+    else if (d->pktOpen) {                              /* previous packet was never finished */
+        d->lostPackets++;
+        d->pktLen = 0;
+        d->pktOpen = false;
+        d->pktLost = false;
+        d->pktTrunc = false;
+    }
+}
+/***********************************************************************************************************************
+ * Function:    OggDemux_Feed
+ *
+ * Description: take the next part of the stream
+ *
+ * Inputs:      demuxer
+ *              stream data and number of bytes
+ *
+ * Outputs:     number of bytes used
+ *              packet in the packet buffer if OGG_PACKET is returned
+ *
+ * Return:      OGG_PACKET after the last byte of a packet, call again with the rest of the input
+ *              OGG_NEED_DATA if all input is used
+ *
+ * Notes:       the packet is valid until the next call, packets without a start are discarded here
+ *              a packet that does not fit in the buffer is truncated (pktTrunc set)
+ **********************************************************************************************************************/
+int OggDemux_Feed(OggDemux_t *d, const uint8_t *in, int len, int *used) {
+    int     i = 0, n, need;
+    uint8_t lace;
+
+    if (d->pktReady) {                                  /* decoder is done with the last packet */
+        d->pktReady = false;
+        d->pktLen = 0;
+        d->pktTrunc = false;
+    }
+    for (;;) {
+        if (d->state == OGG_S_DATA && d->segLeft == 0) {
+            if (d->seg == d->page[26]) {                /* end of page */
+                if (d->crc != OggLE32(d->page + 22)) {
+                    d->crcErrors++;
+                    if (d->pktOpen)
+                        d->pktLost = true;              /* packet continues with bad data */
+                }
+                d->state = OGG_S_CAPTURE;
+                d->fill = 0;
+                continue;
+            }
+            lace = d->page[OGG_HDRSIZE + d->seg++];     /* end of segment, also for empty ones */
+            if (d->seg < d->page[26])
+                d->segLeft = d->page[OGG_HDRSIZE + d->seg];
+            if (!d->collect)
+                continue;
+            d->pktOpen = (lace == 255);
+            if (d->pktOpen)
+                continue;
+            if (d->pktLost) {                           /* end of a packet we do not have completely */
+                d->lostPackets++;
+                d->pktLost = false;
+                d->pktLen = 0;
+                d->pktTrunc = false;
+                continue;
+            }
+            d->pktBos = (d->page[5] & 0x02) != 0;
+            d->pktEos = (d->page[5] & 0x04) != 0;
+            d->pktSerial = OggLE32(d->page + 14);
+            d->pktGranule = d->granule;
+            d->pktReady = true;
+            *used = i;
+            return OGG_PACKET;
+        }
+        if (i >= len)
+            break;
+        switch (d->state) {
+        case OGG_S_CAPTURE:
+            if (in[i] == (uint8_t)"OggS"[d->fill]) {
+                d->page[d->fill++] = in[i];
+                if (d->fill == 4)
+                    d->state = OGG_S_HEADER;
+            }
+            else {
+                d->fill = (in[i] == 'O');
+                d->page[0] = 'O';
+            }
+            i++;
+            break;
+        case OGG_S_HEADER:
+            need = (d->fill < OGG_HDRSIZE) ? OGG_HDRSIZE : OGG_HDRSIZE + d->page[26];
+            n = MIN(len - i, need - d->fill);
+            memcpy(d->page + d->fill, in + i, n);
+            d->fill += n;
+            i += n;
+            if (d->fill == OGG_HDRSIZE && d->page[4] != 0) {
+                d->state = OGG_S_CAPTURE;               /* unknown version, false capture pattern */
+                d->fill = 0;
+            }
+            else if (d->fill == OGG_HDRSIZE + d->page[26]) {
+                OggStartPage(d);
+            }
+            break;
+        default:
+            n = MIN(len - i, d->segLeft);
+            if (d->collect && !d->pktLost) {
+                need = MIN(n, d->pktSize - d->pktLen);
+                if (need < n)
+                    d->pktTrunc = true;
+                memcpy(d->pkt + d->pktLen, in + i, need);
+                d->pktLen += need;
+            }
+            d->crc = OggCrc(d->crc, in + i, n);
+            d->segLeft -= n;
+            i += n;
+            break;
+        }
+    }
+    *used = i;
+    return OGG_NEED_DATA;
+}
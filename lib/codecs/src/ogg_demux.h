@@ -0,0 +1,52 @@
+// ogg_demux.h
+// Ogg page demultiplexer for the decoders of Ogg streams.
+// The stream is taken apart while it comes in, in pieces of any size, so no page buffer is needed.
+// Only the packets of one logical stream are collected, in a buffer given by the decoder.
+// The decoder chooses the stream: the first packet of every beginning-of-stream page is passed to
+// it, the decoder calls OggDemux_Follow() for the stream it can decode.  A chained stream (internet
+// radio starts a new logical stream for every track) is followed the same way.
+#pragma once
+
+#include "Arduino.h"
+
+#define OGG_MAXSEGS     255                             // Max. number of lacing values in a page
+#define OGG_HDRSIZE     27                              // Size of page header without lacing values
+
+enum {
+    OGG_NEED_DATA =     0,                              /* all input used, no complete packet */
+    OGG_PACKET =        1                               /* complete packet in the packet buffer */
+};
+
+typedef struct OggDemux {
+    uint8_t   page[OGG_HDRSIZE + OGG_MAXSEGS];          /* header and lacing values of current page */
+    int       fill;                                     /* bytes received of page[] */
+    int       state;                                    /* see OGG_S_... in ogg_demux.cpp */
+    int       seg;                                      /* index of current lacing value */
+    int       segLeft;                                  /* bytes left in current segment */
+    uint32_t  crc;                                      /* CRC of the page so far */
+    uint32_t  serial;                                   /* serial number of the followed stream */
+    uint32_t  pageSeq;                                  /* sequence number of current page */
+    uint32_t  seqNo;                                    /* expected sequence number of next page */
+    int64_t   granule;                                  /* granule position of current page */
+    bool      following;                                /* a stream has been chosen */
+    bool      collect;                                  /* collect the data of the current page */
+    uint8_t  *pkt;                                      /* packet buffer, set by the decoder */
+    int       pktSize;                                  /* size of packet buffer */
+    int       pktLen;                                   /* bytes in packet buffer */
+    bool      pktOpen;                                  /* packet continues in the next segment */
+    bool      pktReady;                                 /* packet has been handed to the decoder */
+    bool      pktBos;                                   /* packet is the first of a beginning-of-stream page */
+    bool      pktEos;                                   /* packet ends on the end-of-stream page */
+    bool      pktTrunc;                                 /* packet did not fit in the buffer */
+    bool      pktLost;                                  /* start of packet is lost, discard it */
+    uint32_t  pktSerial;                                /* serial number of the stream of the packet */
+    int64_t   pktGranule;                               /* granule position of the page the packet ends on */
+    uint32_t  pages;                                    /* statistics for the "test" command */
+    uint32_t  crcErrors;
+    uint32_t  lostPackets;
+} OggDemux_t;
+
+void     OggDemux_Init(OggDemux_t *d);
+void     OggDemux_SetBuffer(OggDemux_t *d, uint8_t *buf, int size);
+void     OggDemux_Follow(OggDemux_t *d, uint32_t serial);
+int      OggDemux_Feed(OggDemux_t *d, const uint8_t *in, int len, int *used);
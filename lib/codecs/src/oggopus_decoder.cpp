@@ -0,0 +1,461 @@
+/*
+ * oggopus_decoder.cpp
+ * Ogg Opus decoder, the Ogg layer of RFC 7845 around libopus.
+ *
+ * An Ogg Opus stream starts with two header packets, the identification header "OpusHead" on a
+ * beginning-of-stream page and the comment header "OpusTags".  Every following packet is one Opus
+ * packet of 2.5 to 60 ms, it is decoded completely into pcm[] and returned in blocks of at most
+ * OGGOPUS_MAXOUT samples per channel, so a 40 or 60 ms packet takes 2 or 3 calls.
+ * The pre-skip of the header (the encoder delay, normally 312 samples) is dropped at the start of
+ * every stream, the last packet is cut at the granule position of the end-of-stream page.  The
+ * output gain of the header is applied by libopus.
+ * The decoder runs at complexity 0, in libopus 1.5 and later this switches off the neural packet
+ * loss concealment and enhancement.  Otherwise the decode time is set by the encoder (SILK, CELT or
+ * hybrid mode, see the "test" command).  With half rate the packets are decoded at 24 kHz.
+ */
+#include "oggopus_decoder.h"
+
+#ifdef HELIX_OPUS
+
+#include <opus.h>
+
+#ifndef MIN
+  #define MIN(a,b)      ((a) < (b) ? (a) : (b))
+#endif
+
+/* All decoder state lives in an OggOpusDecoder_t.  The decoder always works on the instance m_oggopus points to,
+ * which is the default instance unless one of the functions with a context argument is running.
+ */
+OggOpusDecoder_t      m_OggOpusDecoder;
+thread_local OggOpusDecoder_t *m_oggopus = &m_OggOpusDecoder;
+#define m_OggOpusInfo          (m_oggopus->OggOpusInfo)
+#define m_opus                 (m_oggopus->opus)
+#define m_opusChannels         (m_oggopus->opusChannels)
+#define m_halfRate             (m_oggopus->halfRate)
+
+static uint64_t m_prof[OGGOPUS_PROF_STAGES];            /* cycles per stage, only counted with HELIX_PROFILE */
+static uint32_t m_profSamps;                            /* samples per channel decoded since the last reset */
+
+//----------------------------------------------------------------------------------------------------------------------
+static int OpLE16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void OpFreeState() {
+    if (m_opus) {
+        free(m_opus);
+        m_opus = NULL;
+    }
+    m_opusChannels = 0;
+}
+/***********************************************************************************************************************
+ * Function:    OpParseHead
+ *
+ * Description: parse the identification header and prepare libopus for the stream
+ *
+ * Inputs:      packet and its length
+ *
+ * Outputs:     channels, sampRate, preSkip and gain set
+ *
+ * Return:      0 or error code
+ *
+ * Notes:       the libopus state is kept if the next stream has the same number of channels
+ **********************************************************************************************************************/
+static int OpParseHead(const uint8_t *pkt, int len) {
+    OggOpusInfo_t *vi = m_OggOpusInfo;
+    int            ch, family, size;
+
+    if (len < 19)
+        return ERR_OGGOPUS_INVALID_HEADER;
+    if (pkt[8] & 0xf0)                                  /* major version, only 0 is known */
+        return ERR_OGGOPUS_UNSUPPORTED;
+    ch = pkt[9];
+    family = pkt[18];
+    if (ch == 0)
+        return ERR_OGGOPUS_INVALID_HEADER;
+    if (ch > OGGOPUS_MAXCHANS)
+        return ERR_OGGOPUS_UNSUPPORTED;
+    if (family == 1) {                                  /* Vorbis order, fine if it is one stream */
+        if (len < 21 + ch)
+            return ERR_OGGOPUS_INVALID_HEADER;
+        if (pkt[19] != 1 || pkt[20] != ch - 1)
+            return ERR_OGGOPUS_UNSUPPORTED;
+    }
+    else if (family != 0) {
+        return ERR_OGGOPUS_UNSUPPORTED;
+    }
+    vi->channels = ch;
+    vi->sampRate = m_halfRate ? OGGOPUS_RATE / 2 : OGGOPUS_RATE;
+    vi->preSkip = OpLE16(pkt + 10) * vi->sampRate / OGGOPUS_RATE;
+    vi->gain = (int16_t)OpLE16(pkt + 16);
+    if (m_opusChannels != ch) {
+        OpFreeState();
+        size = opus_decoder_get_size(ch);
+        m_opus = (OpusDecoder*)malloc(size);
+        if (!m_opus && psramFound())
+            m_opus = (OpusDecoder*)ps_malloc(size);
+        if (!m_opus) {
+            log_e("Opus: no memory for the decoder state (%d bytes)", size);
+            return ERR_OGGOPUS_OUT_OF_MEMORY;
+        }
+        m_opusChannels = ch;
+    }
+    if (opus_decoder_init(m_opus, vi->sampRate, ch) != OPUS_OK)
+        return ERR_OGGOPUS_UNSUPPORTED;
+    opus_decoder_ctl(m_opus, OPUS_SET_GAIN(vi->gain));
+    opus_decoder_ctl(m_opus, OPUS_SET_COMPLEXITY(0));   /* older versions return OPUS_UNIMPLEMENTED */
+    return ERR_OGGOPUS_NONE;
+}
+/***********************************************************************************************************************
+ * Function:    OpAudio
+ *
+ * Description: decode an audio packet into pcm[]
+ *
+ * Inputs:      packet and its length
+ *
+ * Outputs:     pcmSamps and pcmPos set, pcmPos is after the pre-skip
+ *
+ * Return:      0 or error code
+ **********************************************************************************************************************/
+static int OpAudio(const uint8_t *pkt, int len) {
+    OggOpusInfo_t *vi = m_OggOpusInfo;
+    int            n, config;
+
+    n = opus_packet_get_nb_samples(pkt, len, vi->sampRate);
+    if (n <= 0 || n > OGGOPUS_MAXFRAME * vi->sampRate / OGGOPUS_RATE) {
+        vi->badPackets++;                               /* 80 to 120 ms packets are not supported */
+        return ERR_OGGOPUS_INVALID_PACKET;
+    }
+    n = opus_decode(m_opus, pkt, len, vi->pcm, OGGOPUS_MAXFRAME, 0);
+    if (n < 0) {
+        vi->badPackets++;
+        return ERR_OGGOPUS_INVALID_PACKET;
+    }
+    config = pkt[0] >> 3;                               /* TOC byte: 0..11 SILK, 12..15 hybrid, 16..31 CELT */
+    vi->modePackets[config < 12 ? 0 : config < 16 ? 1 : 2]++;
+    vi->bytes += len;
+    vi->samples += n;
+    m_profSamps += n;
+    vi->pcmSamps = n;
+    vi->pcmPos = MIN(vi->preSkip, n);
+    vi->preSkip -= vi->pcmPos;
+    return ERR_OGGOPUS_NONE;
+}
+/***********************************************************************************************************************
+ * Function:    OpTrimEnd
+ *
+ * Description: cut the last packet of a stream at the granule position of the end-of-stream page
+ *
+ * Inputs:      pcmSamps and pcmPos of the packet just decoded
+ *
+ * Outputs:     pcmSamps without the samples after the end of the stream
+ *
+ * Return:      none
+ *
+ * Notes:       the encoder pads the last packet, the granule position tells how much of it is real, see
+ *                section 4.5 of RFC 7845, the granules count at 48 kHz and include the pre-skip
+ *              the first packet that ends on a page starts at the granule position of the page before
+ **********************************************************************************************************************/
+static void OpTrimEnd() {
+    OggOpusInfo_t *vi = m_OggOpusInfo;
+    OggDemux_t    *d = &vi->ogg;
+    int64_t        cut;
+
+    if (d->pktGranule != vi->granule) {                 /* first packet that ends on this page */
+        vi->pos = vi->granule;
+        vi->granule = d->pktGranule;
+    }
+    vi->pos += (int64_t)vi->pcmSamps * OGGOPUS_RATE / vi->sampRate;
+    if (d->pktEos && vi->pos > d->pktGranule) {         /* padding after the end of the stream */
+        cut = (vi->pos - d->pktGranule) * vi->sampRate / OGGOPUS_RATE;
+        vi->pcmSamps -= (int)MIN(cut, (int64_t)(vi->pcmSamps - vi->pcmPos));
+        vi->pos = d->pktGranule;
+    }
+}
+/***********************************************************************************************************************
+ * Function:    OpPacket
+ *
+ * Description: handle the packet in the packet buffer of the demuxer
+ *
+ * Inputs:      none
+ *
+ * Outputs:     pcm[] filled for an audio packet
+ *
+ * Return:      0 or error code
+ *
+ * Notes:       a new Opus stream (chained Ogg, next track on internet radio) starts with its identification
+ *                header on a beginning-of-stream page, the decoder starts all over then
+ **********************************************************************************************************************/
+static int OpPacket() {
+    OggOpusInfo_t *vi = m_OggOpusInfo;
+    OggDemux_t    *d = &vi->ogg;
+    const uint8_t *pkt = d->pkt;
+    int            len = d->pktLen, err;
+
+    if (d->pktBos) {
+        if (len < 8 || memcmp(pkt, "OpusHead", 8) != 0)
+            return ERR_OGGOPUS_NONE;                    /* other codec, not followed */
+        OggDemux_Follow(d, d->pktSerial);
+        vi->headers = 0;
+        vi->skip = false;
+        vi->pcmSamps = vi->pcmPos = 0;
+        vi->bytes = vi->samples = 0;
+        vi->granule = vi->pos = 0;
+        if ((err = OpParseHead(pkt, len)) != 0) {
+            vi->skip = true;
+            return err;
+        }
+        vi->headers = 1;
+        return ERR_OGGOPUS_NONE;
+    }
+    if (vi->skip || len == 0)
+        return ERR_OGGOPUS_NONE;
+    switch (vi->headers) {
+    case 0:                                             /* joined in the middle of a stream */
+        return ERR_OGGOPUS_NONE;
+    case 1:
+        if (len < 8 || memcmp(pkt, "OpusTags", 8) != 0) {
+            vi->skip = true;
+            return ERR_OGGOPUS_INVALID_HEADER;
+        }
+        vi->headers = 2;                                /* comments are not used, may be truncated */
+        return ERR_OGGOPUS_NONE;
+    default:
+        if (d->pktTrunc) {
+            vi->badPackets++;
+            return ERR_OGGOPUS_INVALID_PACKET;
+        }
+        if ((err = OpAudio(pkt, len)) == ERR_OGGOPUS_NONE)
+            OpTrimEnd();
+        return err;
+    }
+}
+/***********************************************************************************************************************
+ * Function:    OggOpusDecoder_AllocateBuffers
+ *
+ * Description: allocate the buffers of the Ogg Opus decoder
+ *
+ * Inputs:      none
+ *
+ * Outputs:     none
+ *
+ * Return:      false if not enough memory, otherwise true
+ *
+ * Notes:       the buffers are taken from the codec arena if it is free, otherwise from the heap
+ *              the libopus state is allocated when the identification header of a stream arrives
+ **********************************************************************************************************************/
+bool OggOpusDecoder_AllocateBuffers(void) {
+    if (!m_OggOpusInfo && CodecArena_Claim(m_oggopus)) {
+        m_OggOpusInfo = (OggOpusInfo_t*)CodecArena_Alloc(m_oggopus, sizeof(OggOpusInfo_t), "OggOpusInfo");
+        if (!m_OggOpusInfo)
+            CodecArena_Release(m_oggopus);              /* budget too small (should not happen), use the heap */
+    }
+    if (!m_OggOpusInfo)
+        m_OggOpusInfo = (OggOpusInfo_t*)malloc(sizeof(OggOpusInfo_t));
+    if (!m_OggOpusInfo && psramFound()) {
+        m_OggOpusInfo = (OggOpusInfo_t*)ps_malloc(sizeof(OggOpusInfo_t));
+        if (m_OggOpusInfo)
+            log_i("Opus buffers allocated in PSRAM");
+    }
+    if (!m_OggOpusInfo) {
+        log_e("not enough memory to allocate opus decoder buffers");
+        return false;
+    }
+    memset(m_OggOpusInfo, 0, sizeof(OggOpusInfo_t));
+    OggDemux_Init(&m_OggOpusInfo->ogg);
+    OggDemux_SetBuffer(&m_OggOpusInfo->ogg, m_OggOpusInfo->packet, OGGOPUS_MAXPACKET);
+    return true;
+}
+/***********************************************************************************************************************
+ * Function:    OggOpusDecoder_FreeBuffers
+ *
+ * Description: free the buffers and the libopus state of the Ogg Opus decoder
+ *
+ * Inputs:      none
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ **********************************************************************************************************************/
+void OggOpusDecoder_FreeBuffers(void) {
+    OpFreeState();
+    if (CodecArena_IsOwner(m_oggopus)) {
+        m_OggOpusInfo = NULL;                           /* buffers are in the codec arena, just give it back */
+        CodecArena_Release(m_oggopus);
+        return;
+    }
+    if (m_OggOpusInfo) {
+        free(m_OggOpusInfo);
+        m_OggOpusInfo = NULL;
+    }
+}
+/***********************************************************************************************************************
+ * Function:    OggOpusDecode
+ *
+ * Description: take the next part of an Ogg Opus stream and decode the packets in it
+ *
+ * Inputs:      Ogg stream data and number of bytes
+ *
+ * Outputs:     number of bytes not used
+ *              PCM samples (OggOpusGetOutputSamps), interleaved if stereo
+ *
+ * Return:      ERR_OGGOPUS_NONE if there are samples, call again with the rest of the data
+ *              ERR_OGGOPUS_INDATA_UNDERFLOW if all data is used without new samples
+ *              other error codes for a bad header or packet, call again with the rest of the data
+ *
+ * Notes:       the data may be cut anywhere, pages and packets are collected over the calls
+ *              the samples of a long packet are returned over several calls, these use no input, so the
+ *                caller must go on calling as long as there are samples
+ **********************************************************************************************************************/
+int OggOpusDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf) {
+    OggOpusInfo_t *vi = m_OggOpusInfo;
+    int            used, res, err, n;
+
+    if (!vi)
+        return ERR_OGGOPUS_NULL_POINTER;
+    vi->outSamps = 0;
+    for (;;) {
+        if (vi->pcmPos < vi->pcmSamps) {                /* samples of the last packet left */
+            n = MIN(vi->pcmSamps - vi->pcmPos, OGGOPUS_MAXOUT);
+            memcpy(outbuf, vi->pcm + vi->pcmPos * vi->channels, n * vi->channels * sizeof(short));
+            vi->pcmPos += n;
+            vi->outSamps = n;
+            return ERR_OGGOPUS_NONE;
+        }
+        HELIX_PROF_T(t);
+        res = OggDemux_Feed(&vi->ogg, inbuf, *bytesLeft, &used);
+        inbuf += used;
+        *bytesLeft -= used;
+        HELIX_PROF_ADD(m_prof[OGGOPUS_PROF_OGG], t);
+        if (res == OGG_NEED_DATA)
+            return ERR_OGGOPUS_INDATA_UNDERFLOW;
+        err = OpPacket();
+        HELIX_PROF_ADD(m_prof[OGGOPUS_PROF_DECODE], t);
+        if (err != ERR_OGGOPUS_NONE)
+            return err;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+int OggOpusGetSampRate() {return m_OggOpusInfo->sampRate;}
+int OggOpusGetChannels() {return m_OggOpusInfo->channels;}
+int OggOpusGetBitsPerSample() {return 16;}
+int OggOpusGetOutputSamps() {return m_OggOpusInfo->outSamps * m_OggOpusInfo->channels;}
+int OggOpusGetBitrate() {
+    OggOpusInfo_t *vi = m_OggOpusInfo;
+
+    if (vi->samples == 0)
+        return 0;
+    return (int)((uint64_t)vi->bytes * 8 * vi->sampRate / vi->samples);
+}
+/***********************************************************************************************************************
+ * Function:    OggOpusSetHalfRate
+ *
+ * Description: switch half rate decoding on or off
+ *
+ * Inputs:      true for half rate
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ *
+ * Notes:       with half rate libopus decodes at 24 kHz, with a bandwidth of 12 kHz
+ *              takes effect at the identification header of the next stream
+ **********************************************************************************************************************/
+void OggOpusSetHalfRate(bool on) {m_halfRate = on;}
+/***********************************************************************************************************************
+ * Function:    OggOpusGetProfile
+ *
+ * Description: get the number of cycles used by a stage of the decoder since the last OggOpusResetProfile()
+ *
+ * Inputs:      stage, OGGOPUS_PROF_OGG or OGGOPUS_PROF_DECODE
+ *
+ * Outputs:     none
+ *
+ * Return:      number of cycles, always 0 without HELIX_PROFILE
+ **********************************************************************************************************************/
+uint64_t OggOpusGetProfile(int stage) {return (stage >= 0 && stage < OGGOPUS_PROF_STAGES) ? m_prof[stage] : 0;}
+void OggOpusResetProfile() {memset(m_prof, 0, sizeof(m_prof)); m_profSamps = 0;}
+/***********************************************************************************************************************
+ * Function:    OggOpusReport
+ *
+ * Description: print the stream parameters, the Opus modes and the Ogg statistics, for the "test" command
+ *
+ * Inputs:      none
+ *
+ * Outputs:     lines on the serial log
+ *
+ * Return:      none
+ *
+ * Notes:       with HELIX_PROFILE also the cycles per 20 ms of audio, whatever the packet duration is
+ **********************************************************************************************************************/
+void OggOpusReport() {
+    OggOpusInfo_t *vi = m_OggOpusInfo;
+
+    if (!vi)
+        return;
+    log_printf("Opus: gain %d/256 dB, state %d bytes, packets SILK %d, hybrid %d, CELT %d, %d bad\n",
+               vi->gain, m_opus ? opus_decoder_get_size(m_opusChannels) : 0,
+               vi->modePackets[0], vi->modePackets[1], vi->modePackets[2], vi->badPackets);
+    log_printf("Opus: %d pages, %d CRC errors, %d packets lost\n",
+               vi->ogg.pages, vi->ogg.crcErrors, vi->ogg.lostPackets);
+    #ifdef HELIX_PROFILE
+        if (m_profSamps)
+            log_printf("Opus: %d cycles per 20 ms\n",
+                       (int)((m_prof[OGGOPUS_PROF_OGG] + m_prof[OGGOPUS_PROF_DECODE]) *
+                             (vi->sampRate / 50) / m_profSamps));
+    #endif
+}
+/***********************************************************************************************************************
+ * Function:    OggOpusDecoder_AllocateBuffers, OggOpusDecoder_FreeBuffers, OggOpusDecode, OggOpusGet...
+ *
+ * Description: same as the functions without context, but for the decoder instance ctx instead of the default one
+ *
+ * Inputs:      pointer to decoder instance, zero-initialized before first use
+ *              other inputs as in the functions without context
+ *
+ * Notes:       the previous instance is restored on return, so these may be mixed freely with the calls
+ *                without context in the same task
+ **********************************************************************************************************************/
+bool OggOpusDecoder_AllocateBuffers(OggOpusDecoder_t *ctx) {
+    OggOpusDecoder_t *prev = m_oggopus;
+    bool res;
+
+    m_oggopus = ctx;
+    res = OggOpusDecoder_AllocateBuffers();
+    m_oggopus = prev;
+    return res;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void OggOpusDecoder_FreeBuffers(OggOpusDecoder_t *ctx) {
+    OggOpusDecoder_t *prev = m_oggopus;
+
+    m_oggopus = ctx;
+    OggOpusDecoder_FreeBuffers();
+    m_oggopus = prev;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int OggOpusDecode(OggOpusDecoder_t *ctx, uint8_t *inbuf, int *bytesLeft, short *outbuf) {
+    OggOpusDecoder_t *prev = m_oggopus;
+    int err;
+
+    m_oggopus = ctx;
+    err = OggOpusDecode(inbuf, bytesLeft, outbuf);
+    m_oggopus = prev;
+    return err;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int OggOpusGetSampRate(OggOpusDecoder_t *ctx) {return ctx->OggOpusInfo->sampRate;}
+int OggOpusGetChannels(OggOpusDecoder_t *ctx) {return ctx->OggOpusInfo->channels;}
+int OggOpusGetOutputSamps(OggOpusDecoder_t *ctx) {return ctx->OggOpusInfo->outSamps * ctx->OggOpusInfo->channels;}
+int OggOpusGetBitrate(OggOpusDecoder_t *ctx) {
+    OggOpusDecoder_t *prev = m_oggopus;
+    int br;
+
+    m_oggopus = ctx;
+    br = OggOpusGetBitrate();
+    m_oggopus = prev;
+    return br;
+}
+void OggOpusSetHalfRate(OggOpusDecoder_t *ctx, bool on) {ctx->halfRate = on;}
+
+#endif // HELIX_OPUS
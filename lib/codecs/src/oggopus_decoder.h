@@ -0,0 +1,92 @@
+// oggopus_decoder.h
+// Ogg Opus decoder for the helix builds, see RFC 7845 (Ogg encapsulation) and RFC 6716 (Opus).
+// The Opus packets are decoded by libopus, built in fixed point.  This part handles the Ogg pages,
+// the identification header (channels, pre-skip, output gain) and cuts the decoded packets into
+// blocks of at most OGGOPUS_MAXOUT samples for the output.  Only the channel mapping families 0
+// and 1 with one stream are supported, that is mono and stereo.
+// The state of the Ogg layer and the PCM of one packet are in the codec arena, the state of
+// libopus (about 14 kB per channel) is allocated on the heap when the identification header is seen.
+// Only compiled with HELIX_OPUS, use the esp32-opus environment of platformio.ini, which has libopus.
+#pragma once
+
+#include "Arduino.h"
+#include "codec_arena.h"
+#include "helix_placement.h"
+#include "ogg_demux.h"
+
+#define OGGOPUS_MAXCHANS    2                           // Max. number of channels
+#define OGGOPUS_RATE        48000                       // Sample rate of Opus, also of the pre-skip and granules
+#define OGGOPUS_MAXFRAME    2880                        // Max. samples per channel in a packet (60 ms)
+#define OGGOPUS_MAXOUT      960                         // Max. samples per channel per call (20 ms)
+#define OGGOPUS_MAXPACKET   4096                        // Max. packet size (60 ms at 510 kbps)
+
+enum {
+    ERR_OGGOPUS_NONE                      =   0,
+    ERR_OGGOPUS_INDATA_UNDERFLOW          =  -1,        /* all input used, no new PCM */
+    ERR_OGGOPUS_NULL_POINTER              =  -2,
+    ERR_OGGOPUS_OUT_OF_MEMORY             =  -3,        /* no room for the libopus state */
+    ERR_OGGOPUS_INVALID_HEADER            =  -4,
+    ERR_OGGOPUS_UNSUPPORTED               =  -6,        /* stream is skipped until the next one starts */
+    ERR_OGGOPUS_INVALID_PACKET            =  -7
+};
+
+enum {                  /* decoder stages for HELIX_PROFILE */
+    OGGOPUS_PROF_OGG                      =   0,        /* Ogg pages, headers */
+    OGGOPUS_PROF_DECODE                   =   1,        /* libopus, SILK and/or CELT */
+    OGGOPUS_PROF_STAGES                   =   2
+};
+
+struct OpusDecoder;                                     /* state of libopus, see opus.h */
+
+typedef struct _OggOpusInfo_t {
+    OggDemux_t ogg;
+    int       channels;
+    int       sampRate;         /* decoding rate, 48000 or 24000 for half rate */
+    int       preSkip;          /* samples per channel still to drop at the start of the stream */
+    int       gain;             /* output gain from the header, Q8 dB */
+    int       headers;          /* header packets received, audio follows after 2 */
+    bool      skip;             /* stream not supported, wait for the next one */
+    int       pcmSamps;         /* samples per channel in pcm[] */
+    int       pcmPos;           /* next sample to return */
+    int       outSamps;         /* samples per channel of the last call */
+    int64_t   granule;          /* granule position of the last page with a packet end, at 48 kHz */
+    int64_t   pos;              /* end of the last packet, at 48 kHz and with the pre-skip, like the granules */
+    uint32_t  bytes;            /* audio bytes and samples of the stream, for the bitrate */
+    uint32_t  samples;
+    uint32_t  modePackets[3];   /* packets decoded with SILK, hybrid and CELT */
+    uint32_t  badPackets;       /* packets rejected by libopus */
+    uint8_t   packet[OGGOPUS_MAXPACKET];
+    short     pcm[OGGOPUS_MAXFRAME * OGGOPUS_MAXCHANS];
+} OggOpusInfo_t;
+
+typedef struct _OggOpusDecoder_t {
+    OggOpusInfo_t *OggOpusInfo;
+    OpusDecoder   *opus;        /* libopus state on the heap */
+    int            opusChannels; /* channels of the state */
+    bool           halfRate;    /* decode at 24 kHz */
+} OggOpusDecoder_t;
+
+/* compile-time budget of the buffers in the codec arena, see OggOpusDecoder_AllocateBuffers() */
+static const uint32_t OGGOPUS_ARENA_BUDGET = CODEC_ARENA_ROUND(sizeof(OggOpusInfo_t));
+
+bool OggOpusDecoder_AllocateBuffers(void);
+void OggOpusDecoder_FreeBuffers(void);
+int OggOpusDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf);
+int OggOpusGetSampRate();
+int OggOpusGetChannels();
+int OggOpusGetBitsPerSample();
+int OggOpusGetBitrate();
+int OggOpusGetOutputSamps();
+void OggOpusSetHalfRate(bool on);
+uint64_t OggOpusGetProfile(int stage);
+void OggOpusResetProfile();
+void OggOpusReport();
+// same functions for a specific decoder instance (zero-initialized OggOpusDecoder_t), functions above use a default one
+bool OggOpusDecoder_AllocateBuffers(OggOpusDecoder_t *ctx);
+void OggOpusDecoder_FreeBuffers(OggOpusDecoder_t *ctx);
+int OggOpusDecode(OggOpusDecoder_t *ctx, uint8_t *inbuf, int *bytesLeft, short *outbuf);
+int OggOpusGetSampRate(OggOpusDecoder_t *ctx);
+int OggOpusGetChannels(OggOpusDecoder_t *ctx);
+int OggOpusGetOutputSamps(OggOpusDecoder_t *ctx);
+int OggOpusGetBitrate(OggOpusDecoder_t *ctx);
+void OggOpusSetHalfRate(OggOpusDecoder_t *ctx, bool on);
@@ -0,0 +1,200 @@
+/*
+ * resampler.cpp
+ * Polyphase sample rate converter for the helix decoders.
+ *
+ * The output rate is fixed (HELIX_FIXEDRATE), so only the input rates of the streams matter.
+ * The usual pairs reduce to small ratios, for example for 48 kHz output:
+ *   44100 -> 48000  L/M = 160/147      32000 -> 48000  L/M = 3/2
+ *   22050 -> 48000  L/M = 320/147      24000 -> 48000  L/M = 2/1
+ * and for 44.1 kHz output:
+ *   48000 -> 44100  L/M = 147/160      32000 -> 44100  L/M = 441/320
+ *   22050 -> 44100  L/M = 2/1          24000 -> 44100  L/M = 147/80
+ * The prototype filter is a Kaiser windowed sinc of RS_TAPS * L taps with the cutoff just below
+ * half the lower of both rates.  It is computed once per input rate and stored per phase, so
+ * every output sample costs RS_TAPS multiply-accumulates per channel.
+ */
+#include "resampler.h"
+
+#define RS_CUTOFF       0.91f                           // Cutoff as part of the lower Nyquist frequency
+#define RS_BETA         7.0f                            // Kaiser window parameter
+
+static int16_t  *m_coef;                                /* L * RS_TAPS coefficients, phase by phase */
+static int       m_coefPhases;                          /* number of phases m_coef is allocated for */
+static uint32_t  m_inRate, m_outRate;                   /* current conversion */
+static int       m_L, m_M;                              /* in * L = out * M */
+static int       m_phase;                               /* next output time after last input, in 1/L input samples */
+static int       m_idx;                                 /* position of the newest sample in m_delay */
+static int16_t   m_delay[RS_CHANNELS][2 * RS_TAPS];     /* input history, written twice to avoid wrapping */
+
+/***********************************************************************************************************************
+ * Function:    BesselI0
+ *
+ * Description: modified Bessel function of the first kind, order 0, for the Kaiser window
+ **********************************************************************************************************************/
+static float BesselI0(float x) {
+    float sum = 1.0f, term = 1.0f;
+    int   k;
+
+    for (k = 1; k < 32 && term > sum * 1e-7f; k++) {
+        term *= (x * x) / (4.0f * k * k);
+        sum += term;
+    }
+    return sum;
+}
+/***********************************************************************************************************************
+ * Function:    Resampler_Init
+ *
+ * Description: set up the conversion from inRate to outRate and clear the history
+ *
+ * Inputs:      input and output sample rate
+ *
+ * Outputs:     none
+ *
+ * Return:      true if the conversion is possible (also if the rates are equal), false if the ratio needs
+ *              more than RS_MAXPHASES phases or there is no memory for the coefficients
+ *
+ * Notes:       the coefficients are only computed again if the ratio has changed
+ **********************************************************************************************************************/
+bool Resampler_Init(uint32_t inRate, uint32_t outRate) {
+    uint32_t a, b, t;
+    int      L, M, n, p, k, N;
+    float    fc, x, w, h, i0b, sum;
+    float    *ph;
+
+    memset(m_delay, 0, sizeof(m_delay));
+    m_idx = 0;
+    if (inRate == 0 || outRate == 0)
+        return false;
+    for (a = inRate, b = outRate; b; t = a % b, a = b, b = t)  /* greatest common divisor */
+        ;
+    L = outRate / a;
+    M = inRate / a;
+    m_phase = L;                                        /* first input sample needed */
+    if (inRate == m_inRate && outRate == m_outRate)
+        return true;                                    /* table still valid */
+    m_inRate = m_outRate = 0;
+    m_L = m_M = 1;
+    if (L == M)
+        return true;                                    /* nothing to do */
+    if (L > RS_MAXPHASES) {
+        log_e("resampler: %d -> %d Hz needs %d phases", inRate, outRate, L);
+        return false;
+    }
+    if (L > m_coefPhases) {
+        free(m_coef);
+        m_coefPhases = 0;
+        m_coef = (int16_t *)malloc(L * RS_TAPS * sizeof(int16_t));
+        if (!m_coef) {
+            log_e("resampler: no memory for %d phases", L);
+            return false;
+        }
+        m_coefPhases = L;
+    }
+    ph = (float *)malloc(RS_TAPS * sizeof(float));     /* one phase in floating point */
+    if (!ph)
+        return false;
+    N = L * RS_TAPS;
+    fc = RS_CUTOFF * 0.5f * (float)(inRate < outRate ? inRate : outRate) / ((float)inRate * L);
+    i0b = BesselI0(RS_BETA);
+    for (p = 0; p < L; p++) {
+        sum = 0.0f;
+        for (k = 0; k < RS_TAPS; k++) {
+            n = p + k * L;                              /* tap n of the prototype filter */
+            x = (float)n - (float)(N - 1) * 0.5f;
+            h = (x == 0.0f) ? 2.0f * fc : sinf(2.0f * (float)M_PI * fc * x) / ((float)M_PI * x);
+            w = 2.0f * (float)n / (float)(N - 1) - 1.0f;
+            h *= BesselI0(RS_BETA * sqrtf(1.0f - w * w)) / i0b;
+            ph[k] = h;
+            sum += h;
+        }
+        /* every phase gets a DC gain of exactly 1, otherwise the phases modulate the signal */
+        sum = (sum != 0.0f) ? (float)(1 << RS_COEFBITS) / sum : 0.0f;
+        for (k = 0; k < RS_TAPS; k++)
+            m_coef[p * RS_TAPS + k] = (int16_t)lrintf(ph[k] * sum);
+    }
+    free(ph);
+    m_L = L;
+    m_M = M;
+    m_inRate = inRate;
+    m_outRate = outRate;
+    log_i("resampler: %d -> %d Hz, L/M = %d/%d", inRate, outRate, L, M);
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool Resampler_Active() {
+    return (m_L != m_M);
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t Resampler_InRate() {
+    return m_inRate;
+}
+/***********************************************************************************************************************
+ * Function:    Resampler_Process
+ *
+ * Description: convert a block of PCM samples
+ *
+ * Inputs:      input samples, interleaved if channels is 2
+ *              number of input frames (samples per channel)
+ *              number of channels (1 or 2)
+ *              output buffer for maxOut frames
+ *
+ * Outputs:     output frames, interleaved like the input
+ *              number of input frames used
+ *
+ * Return:      number of output frames
+ *
+ * Notes:       stops when the output buffer is full, call again with the rest of the input
+ **********************************************************************************************************************/
+int Resampler_Process(const int16_t *in, int inFrames, int channels, int16_t *out, int maxOut, int *used) {
+    int            i = 0, n = 0, ch, k;
+    int32_t        acc;
+    const int16_t  *c, *d;
+
+    if (channels > RS_CHANNELS)
+        channels = RS_CHANNELS;
+    for (;;) {
+        while (m_phase < m_L) {                         /* outputs before the next input sample */
+            if (n >= maxOut) {
+                *used = i;
+                return n;
+            }
+            c = m_coef + m_phase * RS_TAPS;
+            for (ch = 0; ch < channels; ch++) {
+                d = m_delay[ch] + m_idx;
+                acc = 1 << (RS_COEFBITS - 1);           /* rounding */
+                for (k = 0; k < RS_TAPS; k++)
+                    acc += c[k] * d[k];
+                acc >>= RS_COEFBITS;
+                if (acc > 32767)
+                    acc = 32767;
+                else if (acc < -32768)
+                    acc = -32768;
+                *out++ = (int16_t)acc;
+            }
+            n++;
+            m_phase += m_M;
+        }
+        if (i >= inFrames)
+            break;
+        m_idx = m_idx ? m_idx - 1 : RS_TAPS - 1;        /* newest sample first */
+        for (ch = 0; ch < channels; ch++)
+            m_delay[ch][m_idx] = m_delay[ch][m_idx + RS_TAPS] = in[ch];
+        in += channels;
+        i++;
+        m_phase -= m_L;
+    }
+    *used = i;
+    return n;
+}
+/***********************************************************************************************************************
+ * Function:    Resampler_Free
+ *
+ * Description: give the coefficient memory back
+ **********************************************************************************************************************/
+void Resampler_Free() {
+    free(m_coef);
+    m_coef = NULL;
+    m_coefPhases = 0;
+    m_inRate = m_outRate = 0;
+    m_L = m_M = 1;
+}
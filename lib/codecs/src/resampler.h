@@ -0,0 +1,19 @@
+// resampler.h
+// Polyphase sample rate converter for the helix decoders.
+// Converts the decoded PCM to one fixed output rate, so the I2S clock never has to change.
+// The ratio in/out is reduced to L/M (in * L = out * M).  One FIR filter of RS_TAPS taps is
+// computed for each of the L phases when the input rate changes.
+#pragma once
+
+#include "Arduino.h"
+
+#define RS_TAPS         24                              // Taps per phase
+#define RS_MAXPHASES    448                             // Max. value of L, 441 is needed for 32 -> 44.1 kHz
+#define RS_COEFBITS     14                              // Fraction bits of the coefficients
+#define RS_CHANNELS     2                               // Max. number of channels
+
+bool     Resampler_Init(uint32_t inRate, uint32_t outRate);
+bool     Resampler_Active();
+int      Resampler_Process(const int16_t *in, int inFrames, int channels, int16_t *out, int maxOut, int *used);
+void     Resampler_Free();
+uint32_t Resampler_InRate();
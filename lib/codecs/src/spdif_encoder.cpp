@@ -0,0 +1,233 @@
+/*
+ * spdif_encoder.cpp
+ * Block encoder for S/PDIF output through I2S.
+ * The biphase mark coding leans heavily on
+ * https://github.com/earlephilhower/ESP8266Audio/blob/master/src/AudioOutputSPDIF.cpp
+ *
+ * A subframe has 32 time slots: preamble (0..3), aux (4..7), audio LSB first (8..27) and the V, U, C and P
+ * bits (28..31).  In biphase mark code every slot is 2 cells, so a subframe is 64 cells or two I2S words,
+ * sent MSB first:
+ *   word 0:  VUCP cells of the previous subframe (8), preamble (8), slots 4..11 (16)
+ *   word 1:  slots 12..19 (16), slots 20..27 (16)
+ * Every 8 data bits are looked up in m_bmc.  The entries end with a low cell, an entry is inverted if the next
+ * one starts low.  The parity bit makes every subframe end low, so the preamble is always the same pattern.
+ * With 16 bits samples the LSB of the 24 bits word (slot 4) is set to make the parity of the data even,
+ * then the VUCP cells only depend on the C bit.  With 24 bits samples the VUCP cells are corrected for odd
+ * parity of the data.
+ * The VUCP cells and the preamble of every subframe of the 192 frames block are kept in m_tmpl, built by
+ * Spdif_SetFormat from the channel status.
+ */
+#include "spdif_encoder.h"
+
+#define SPDIF_PRE_B         0xE8                        // Preamble B, left channel, frame 0 of the block
+#define SPDIF_PRE_M         0xE2                        // Preamble M, left channel, other frames
+#define SPDIF_PRE_W         0xE4                        // Preamble W, right channel
+#define SPDIF_VUCP_C0       0xCC                        // V, U, C and P cells, C = 0, even data parity
+#define SPDIF_VUCP_C1       0xCA                        // V, U, C and P cells, C = 1, even data parity
+#define SPDIF_VUCP_ODD      0xFE000000                  // Correction of the VUCP cells for odd data parity
+
+/* BMC (Biphase Mark Coded) values (bit order reversed, i.e. LSB first) */
+static const uint16_t m_bmc[256] HELIX_DRAM = {
+    0xcccc, 0x4ccc, 0x2ccc, 0xaccc, 0x34cc, 0xb4cc, 0xd4cc, 0x54cc, // 00..07
+    0x32cc, 0xb2cc, 0xd2cc, 0x52cc, 0xcacc, 0x4acc, 0x2acc, 0xaacc, // 08..0F
+    0x334c, 0xb34c, 0xd34c, 0x534c, 0xcb4c, 0x4b4c, 0x2b4c, 0xab4c, // 10..17
+    0xcd4c, 0x4d4c, 0x2d4c, 0xad4c, 0x354c, 0xb54c, 0xd54c, 0x554c, // 18..1F
+    0x332c, 0xb32c, 0xd32c, 0x532c, 0xcb2c, 0x4b2c, 0x2b2c, 0xab2c, // 20..27
+    0xcd2c, 0x4d2c, 0x2d2c, 0xad2c, 0x352c, 0xb52c, 0xd52c, 0x552c, // 28..2F
+    0xccac, 0x4cac, 0x2cac, 0xacac, 0x34ac, 0xb4ac, 0xd4ac, 0x54ac, // 30..37
+    0x32ac, 0xb2ac, 0xd2ac, 0x52ac, 0xcaac, 0x4aac, 0x2aac, 0xaaac, // 38..3F
+    0x3334, 0xb334, 0xd334, 0x5334, 0xcb34, 0x4b34, 0x2b34, 0xab34, // 40..47
+    0xcd34, 0x4d34, 0x2d34, 0xad34, 0x3534, 0xb534, 0xd534, 0x5534, // 48..4F
+    0xccb4, 0x4cb4, 0x2cb4, 0xacb4, 0x34b4, 0xb4b4, 0xd4b4, 0x54b4, // 50..57
+    0x32b4, 0xb2b4, 0xd2b4, 0x52b4, 0xcab4, 0x4ab4, 0x2ab4, 0xaab4, // 58..5F
+    0xccd4, 0x4cd4, 0x2cd4, 0xacd4, 0x34d4, 0xb4d4, 0xd4d4, 0x54d4, // 60..67
+    0x32d4, 0xb2d4, 0xd2d4, 0x52d4, 0xcad4, 0x4ad4, 0x2ad4, 0xaad4, // 68..6F
+    0x3354, 0xb354, 0xd354, 0x5354, 0xcb54, 0x4b54, 0x2b54, 0xab54, // 70..77
+    0xcd54, 0x4d54, 0x2d54, 0xad54, 0x3554, 0xb554, 0xd554, 0x5554, // 78..7F
+    0x3332, 0xb332, 0xd332, 0x5332, 0xcb32, 0x4b32, 0x2b32, 0xab32, // 80..87
+    0xcd32, 0x4d32, 0x2d32, 0xad32, 0x3532, 0xb532, 0xd532, 0x5532, // 88..8F
+    0xccb2, 0x4cb2, 0x2cb2, 0xacb2, 0x34b2, 0xb4b2, 0xd4b2, 0x54b2, // 90..97
+    0x32b2, 0xb2b2, 0xd2b2, 0x52b2, 0xcab2, 0x4ab2, 0x2ab2, 0xaab2, // 98..9F
+    0xccd2, 0x4cd2, 0x2cd2, 0xacd2, 0x34d2, 0xb4d2, 0xd4d2, 0x54d2, // A0..A7
+    0x32d2, 0xb2d2, 0xd2d2, 0x52d2, 0xcad2, 0x4ad2, 0x2ad2, 0xaad2, // A8..AF
+    0x3352, 0xb352, 0xd352, 0x5352, 0xcb52, 0x4b52, 0x2b52, 0xab52, // B0..B7
+    0xcd52, 0x4d52, 0x2d52, 0xad52, 0x3552, 0xb552, 0xd552, 0x5552, // B8..BF
+    0xccca, 0x4cca, 0x2cca, 0xacca, 0x34ca, 0xb4ca, 0xd4ca, 0x54ca, // C0..C7
+    0x32ca, 0xb2ca, 0xd2ca, 0x52ca, 0xcaca, 0x4aca, 0x2aca, 0xaaca, // C8..CF
+    0x334a, 0xb34a, 0xd34a, 0x534a, 0xcb4a, 0x4b4a, 0x2b4a, 0xab4a, // D0..D7
+    0xcd4a, 0x4d4a, 0x2d4a, 0xad4a, 0x354a, 0xb54a, 0xd54a, 0x554a, // D8..DF
+    0x332a, 0xb32a, 0xd32a, 0x532a, 0xcb2a, 0x4b2a, 0x2b2a, 0xab2a, // E0..E7
+    0xcd2a, 0x4d2a, 0x2d2a, 0xad2a, 0x352a, 0xb52a, 0xd52a, 0x552a, // E8..EF
+    0xccaa, 0x4caa, 0x2caa, 0xacaa, 0x34aa, 0xb4aa, 0xd4aa, 0x54aa, // F0..F7
+    0x32aa, 0xb2aa, 0xd2aa, 0x52aa, 0xcaaa, 0x4aaa, 0x2aaa, 0xaaaa  // F8..FF
+};
+
+/* sample frequency code of channel status bits 24..27, other rates are sent as "not indicated" */
+static const struct {
+    uint32_t rate;
+    uint8_t  code;
+} m_fsCode[] = {
+    { 44100, 0x00 }, { 48000, 0x02 }, { 32000, 0x03 }, { 22050, 0x04 }, { 24000, 0x06 },
+    { 88200, 0x08 }, { 96000, 0x0A }, { 176400, 0x0C }, { 192000, 0x0E }
+};
+
+static uint16_t  m_tmpl[SPDIF_FRAMES][2];               /* VUCP cells of previous subframe and preamble, L and R */
+static uint8_t   m_cs[SPDIF_CSBYTES];                   /* channel status, bit n is sent in frame n */
+static uint32_t  m_rate;                                /* sample rate, 0 if not set yet */
+static int       m_bits;                                /* 16 or 24 */
+static int       m_frame;                               /* next frame in the channel status block */
+static uint32_t  m_odd;                                 /* correction of the VUCP cells of the last subframe */
+
+/***********************************************************************************************************************
+ * Function:    Spdif_SetFormat
+ *
+ * Description: build the channel status block and the subframe templates for a sample rate and word length
+ *
+ * Inputs:      sample rate in Hz
+ *              bits per sample, 16 or 24
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ *
+ * Notes:       consumer format, linear PCM, no pre-emphasis, copying permitted, general category, clock accuracy
+ *              level II.  The position in the block is kept, so a change does not disturb the receiver.
+ *              The VUCP cells of the last subframe are sent with the next block, they keep the C bit of the old
+ *              channel status.
+ **********************************************************************************************************************/
+void Spdif_SetFormat(uint32_t rate, int bits) {
+    int      f, i, c, cPrev;
+    uint8_t  fs = 0x01;
+    uint16_t vucp = m_tmpl[m_frame][0];                 /* VUCP cells of the last subframe, old channel status */
+
+    bits = (bits == 24) ? 24 : 16;
+    if (rate == m_rate && bits == m_bits)
+        return;
+    for (i = 0; i < (int)(sizeof(m_fsCode) / sizeof(m_fsCode[0])); i++) {
+        if (m_fsCode[i].rate == rate)
+            fs = m_fsCode[i].code;
+    }
+    memset(m_cs, 0, sizeof(m_cs));
+    m_cs[0] = 0x04;                                     /* consumer, PCM, no copyright asserted, no emphasis */
+    m_cs[3] = fs;                                       /* sample frequency, clock accuracy level II */
+    m_cs[4] = (bits == 24) ? 0x0B : 0x02;               /* max. 24 bits, 24 bits or max. 20 bits, 16 bits */
+    for (f = 0; f < SPDIF_FRAMES; f++) {
+        c = (m_cs[f >> 3] >> (f & 7)) & 1;
+        i = (f + SPDIF_FRAMES - 1) % SPDIF_FRAMES;      /* the right subframe before this left one */
+        cPrev = (m_cs[i >> 3] >> (i & 7)) & 1;
+        m_tmpl[f][0] = ((cPrev ? SPDIF_VUCP_C1 : SPDIF_VUCP_C0) << 8) | (f ? SPDIF_PRE_M : SPDIF_PRE_B);
+        m_tmpl[f][1] = ((c ? SPDIF_VUCP_C1 : SPDIF_VUCP_C0) << 8) | SPDIF_PRE_W;
+    }
+    if (m_rate)
+        m_odd ^= (uint32_t)((vucp ^ m_tmpl[m_frame][0]) & 0xFF00) << 16;
+    m_rate = rate;
+    m_bits = bits;
+    log_i("spdif: %d Hz, %d bits", rate, bits);
+}
+/***********************************************************************************************************************
+ * Function:    Spdif_Encode16
+ *
+ * Description: convert a block of 16 bits stereo samples to S/PDIF subframes
+ *
+ * Inputs:      interleaved samples, left first
+ *              number of frames (samples per channel)
+ *              output buffer for SPDIF_WORDS words per frame
+ *
+ * Outputs:     I2S words
+ *
+ * Return:      number of words in the output buffer
+ *
+ * Notes:       gives the same words as the former per sample encoder, apart from the C bits
+ **********************************************************************************************************************/
+HELIX_IRAM int Spdif_Encode16(const int16_t *in, int frames, uint32_t *out) {
+    const uint16_t *t;
+    uint16_t        hi, lo, aux;
+    uint32_t        odd;
+    int             i, c, f;
+
+    if (!m_rate)
+        Spdif_SetFormat(44100, 16);
+    odd = m_odd;                                        /* correction after 24 bits samples or a new format */
+    f = m_frame;
+    for (i = 0; i < frames; i++) {
+        t = m_tmpl[f];
+        for (c = 0; c < 2; c++) {
+            hi = m_bmc[(uint8_t)(*in >> 8)];            /* convert high byte of sample */
+            lo = m_bmc[(uint8_t)*in++];                 /* convert low byte of sample */
+            lo ^= ~((int16_t)hi) >> 16;                 /* invert if the high byte starts low */
+            aux = 0xb333 ^ (((uint32_t)((int16_t)lo)) >> 17); /* slot 4 set if needed for even parity */
+            *out++ = (((uint32_t)t[c] << 16) | aux) ^ odd;
+            *out++ = ((uint32_t)lo << 16) | hi;
+            odd = 0;
+        }
+        if (++f == SPDIF_FRAMES)
+            f = 0;
+    }
+    if (frames > 0)
+        m_odd = 0;
+    m_frame = f;
+    return frames * SPDIF_WORDS;
+}
+/***********************************************************************************************************************
+ * Function:    Spdif_Encode24
+ *
+ * Description: convert a block of 24 bits stereo samples to S/PDIF subframes
+ *
+ * Inputs:      interleaved samples, left first, right aligned and sign extended to 32 bits
+ *              number of frames (samples per channel)
+ *              output buffer for SPDIF_WORDS words per frame
+ *
+ * Outputs:     I2S words
+ *
+ * Return:      number of words in the output buffer
+ *
+ * Notes:       the inversions are done from the high byte down.  If the low byte then starts low, the data has
+ *              odd parity: all three are inverted and the VUCP cells in the next subframe are corrected.
+ **********************************************************************************************************************/
+HELIX_IRAM int Spdif_Encode24(const int32_t *in, int frames, uint32_t *out) {
+    const uint16_t *t;
+    uint16_t        hi, mid, lo, inv;
+    uint32_t        odd;
+    int32_t         s;
+    int             i, c, f;
+
+    if (!m_rate)
+        Spdif_SetFormat(44100, 24);
+    odd = m_odd;
+    f = m_frame;
+    for (i = 0; i < frames; i++) {
+        t = m_tmpl[f];
+        for (c = 0; c < 2; c++) {
+            s = *in++;
+            hi = m_bmc[(uint8_t)(s >> 16)];
+            mid = m_bmc[(uint8_t)(s >> 8)];
+            lo = m_bmc[(uint8_t)s];
+            mid ^= ~((int16_t)hi) >> 16;
+            lo ^= ~((int16_t)mid) >> 16;
+            inv = ~((int16_t)lo) >> 16;                 /* 0xFFFF if the low byte starts low */
+            *out++ = (((uint32_t)t[c] << 16) | (uint16_t)(lo ^ inv)) ^ odd;
+            *out++ = ((uint32_t)(uint16_t)(mid ^ inv) << 16) | (uint16_t)(hi ^ inv);
+            odd = inv ? SPDIF_VUCP_ODD : 0;
+        }
+        if (++f == SPDIF_FRAMES)
+            f = 0;
+    }
+    m_odd = odd;
+    m_frame = f;
+    return frames * SPDIF_WORDS;
+}
+/***********************************************************************************************************************
+ * Function:    Spdif_Report
+ *
+ * Description: print the format and the first 5 bytes of the channel status, for the "test" command
+ *
+ * Inputs:      none
+ *
+ * Outputs:     a line on the serial log
+ *
+ * Return:      none
+ **********************************************************************************************************************/
+void Spdif_Report() {
+    log_printf("SPDIF output %d Hz, %d bits, channel status %02X %02X %02X %02X %02X\n",
+               m_rate, m_bits, m_cs[0], m_cs[1], m_cs[2], m_cs[3], m_cs[4]);
+}
@@ -0,0 +1,19 @@
+// spdif_encoder.h
+// Block encoder for S/PDIF (IEC 60958 consumer) output through I2S.
+// A stereo PCM block is converted to biphase mark coded subframes in one pass.  Every subframe takes
+// two 32 bits I2S words, so the I2S clock runs at twice the sample rate with 32 bits per channel.
+// The 192 frames channel status block (sample rate, word length, copy permitted) is built when the
+// format changes and stored together with the preambles as one template per subframe.
+#pragma once
+
+#include "Arduino.h"
+#include "helix_placement.h"
+
+#define SPDIF_FRAMES        192                         // Frames in a channel status block
+#define SPDIF_WORDS         4                           // I2S words per stereo frame
+#define SPDIF_CSBYTES       (SPDIF_FRAMES / 8)          // Bytes of channel status
+
+void     Spdif_SetFormat(uint32_t rate, int bits);
+int      Spdif_Encode16(const int16_t *in, int frames, uint32_t *out);
+int      Spdif_Encode24(const int32_t *in, int frames, uint32_t *out);
+void     Spdif_Report();
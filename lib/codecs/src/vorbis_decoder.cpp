@@ -0,0 +1,1847 @@
+/*
+ * vorbis_decoder.cpp
+ * Integer Vorbis I decoder.
+ *
+ * Fixed point formats:
+ *   codebook values, residue       Q16
+ *   floor curve                    Q31, inverse dB table
+ *   spectrum                       Q28 (VB_SPECBITS)
+ *   IMDCT output, overlap          Q20 (VORBIS_QBITS), full scale is 1.0
+ * The IMDCT is not normalized, as in libvorbis.  Its input is scaled per block so that no sum in the
+ * FFT can overflow, quiet blocks keep the full precision of the spectrum.  It is computed as a DCT-IV of n/2 points with a
+ * complex FFT of n/4 points.  The window is applied while the output is made, only the part where
+ * two blocks overlap needs multiplications.
+ * The codewords are decoded bit by bit with a binary tree of 4 bytes per used entry.  The values
+ * of lookup type 1 books (all books of libvorbis) are computed when an entry is decoded, so a book
+ * takes no more memory than its tree.
+ */
+#include "vorbis_decoder.h"
+
+#ifndef MIN
+  #define MIN(a,b)      ((a) < (b) ? (a) : (b))
+#endif
+
+#define VB_LEAF         0x8000                          /* tree: child is a leaf, entry in the low bits */
+#define VB_NONE         0xFFFF                          /* tree: no codeword */
+#define VB_MAXDIMS      16                              /* max. dimensions of a book with values */
+#define VB_TWSIZE       1024                            /* IMDCT size (n/2) of the twiddle table */
+#define VB_SPECBITS     28                              /* fraction bits of the spectrum */
+
+/* All decoder state lives in a VorbisDecoder_t.  The decoder always works on the instance m_vorbis points to,
+ * which is the default instance unless one of the functions with a context argument is running.
+ */
+VorbisDecoder_t      m_VorbisDecoder;
+thread_local VorbisDecoder_t *m_vorbis = &m_VorbisDecoder;
+#define m_VorbisInfo           (m_vorbis->VorbisInfo)
+#define m_pool                 (m_vorbis->pool)
+#define m_poolSize             (m_vorbis->poolSize)
+#define m_books                (m_vorbis->books)
+#define m_floors               (m_vorbis->floors)
+#define m_residues             (m_vorbis->residues)
+#define m_mappings             (m_vorbis->mappings)
+#define m_modes                (m_vorbis->modes)
+#define m_window               (m_vorbis->window)
+#define m_nBooks               (m_vorbis->nBooks)
+#define m_nFloors              (m_vorbis->nFloors)
+#define m_nResidues            (m_vorbis->nResidues)
+#define m_nMappings            (m_vorbis->nMappings)
+#define m_nModes               (m_vorbis->nModes)
+
+static uint64_t m_prof[VORBIS_PROF_STAGES];             /* cycles per stage, only counted with HELIX_PROFILE */
+
+typedef struct _VbReader_t {
+    const uint8_t *buf;
+    int            bits;                                /* number of bits in buf */
+    int            pos;                                 /* next bit to read */
+    bool           eop;                                 /* tried to read past the end of the packet */
+} VbReader_t;
+
+typedef struct _VbParse_t {                             /* state while the setup header is parsed */
+    VbReader_t     br;
+    uint8_t       *pool;                                /* NULL in the measure pass */
+    size_t         used;                                /* bytes taken from the pool (or needed) */
+    uint8_t       *scratch;                             /* one item in the measure pass */
+    VbCodebook_t  *books;
+    int            nBooks;
+    int            nFloors;
+    int            nResidues;
+    int            nMappings;
+} VbParse_t;
+
+typedef struct _VbAssign_t {                            /* codeword assignment of one book */
+    uint32_t       avail[33];                           /* first free codeword per length, MSB aligned */
+    int            used;                                /* number of entries with a codeword */
+    int            firstEntry;                          /* entry and length of the first codeword */
+    int            firstLen;
+    uint16_t      *tree;                                /* NULL if only counting */
+    int            nodes;
+    int            maxNodes;
+} VbAssign_t;
+
+/* floor 1 inverse dB table, 1.0649863^(i-255) in Q31 */
+static const int32_t m_vbInvDB[256] HELIX_DRAM = {
+    0x000000e5, 0x000000f4, 0x00000103, 0x00000114, 0x00000126, 0x00000139, 0x0000014e, 0x00000163,
+    0x0000017a, 0x00000193, 0x000001ad, 0x000001c9, 0x000001e7, 0x00000206, 0x00000228, 0x0000024c,
+    0x00000272, 0x0000029b, 0x000002c6, 0x000002f4, 0x00000326, 0x0000035a, 0x00000392, 0x000003cd,
+    0x0000040c, 0x00000450, 0x00000497, 0x000004e4, 0x00000535, 0x0000058c, 0x000005e8, 0x0000064a,
+    0x000006b3, 0x00000722, 0x00000799, 0x00000817, 0x0000089e, 0x0000092d, 0x000009c6, 0x00000a69,
+    0x00000b16, 0x00000bce, 0x00000c92, 0x00000d64, 0x00000e42, 0x00000f30, 0x0000102c, 0x00001139,
+    0x00001258, 0x00001389, 0x000014ce, 0x00001628, 0x00001799, 0x00001921, 0x00001ac3, 0x00001c81,
+    0x00001e5b, 0x00002054, 0x0000226e, 0x000024aa, 0x0000270c, 0x00002996, 0x00002c4a, 0x00002f2b,
+    0x0000323b, 0x0000357f, 0x000038f9, 0x00003cad, 0x0000409e, 0x000044d1, 0x0000494a, 0x00004e0e,
+    0x00005320, 0x00005887, 0x00005e48, 0x00006468, 0x00006aef, 0x000071e2, 0x00007948, 0x0000812a,
+    0x0000898f, 0x0000927f, 0x00009c05, 0x0000a628, 0x0000b0f4, 0x0000bc74, 0x0000c8b4, 0x0000d5bf,
+    0x0000e3a2, 0x0000f26e, 0x0001022f, 0x000112f6, 0x000124d4, 0x000137dc, 0x00014c20, 0x000161b6,
+    0x000178b2, 0x0001912d, 0x0001ab3f, 0x0001c703, 0x0001e495, 0x00020413, 0x0002259c, 0x00024954,
+    0x00026f5e, 0x000297e0, 0x0002c305, 0x0002f0f7, 0x000321e6, 0x00035602, 0x00038d82, 0x0003c89d,
+    0x00040790, 0x00044a99, 0x000491fe, 0x0004de07, 0x00052f00, 0x0005853d, 0x0005e114, 0x000642e3,
+    0x0006ab0e, 0x000719fd, 0x00079022, 0x00080df4, 0x000893f4, 0x000922a9, 0x0009baa4, 0x000a5c80,
+    0x000b08e0, 0x000bc074, 0x000c83f6, 0x000d542d, 0x000e31eb, 0x000f1e13, 0x00101994, 0x0011256c,
+    0x001242ad, 0x00137277, 0x0014b5ff, 0x00160e8e, 0x00177d81, 0x0019044c, 0x001aa47d, 0x001c5fba,
+    0x001e37c5, 0x00202e7d, 0x002245e1, 0x0024800f, 0x0026df4c, 0x002965fe, 0x002c16b8, 0x002ef433,
+    0x00320159, 0x00354143, 0x0038b73d, 0x003c66ca, 0x004053a8, 0x004481d4, 0x0048f58c, 0x004db355,
+    0x0052bfff, 0x005820ab, 0x005ddacd, 0x0063f437, 0x006a7319, 0x00715e0b, 0x0078bc14, 0x008094af,
+    0x0088efd1, 0x0091d5f6, 0x009b5029, 0x00a56806, 0x00b027ce, 0x00bb9a6a, 0x00c7cb7a, 0x00d4c75c,
+    0x00e29b40, 0x00f15530, 0x0101041f, 0x0111b7f7, 0x012381af, 0x01367355, 0x014aa023, 0x01601c96,
+    0x0176fe7e, 0x018f5d14, 0x01a95116, 0x01c4f4de, 0x01e26479, 0x0201bdcb, 0x022320a6, 0x0246aeee,
+    0x026c8cbd, 0x0294e082, 0x02bfd32f, 0x02ed905d, 0x031e467a, 0x035226fb, 0x03896688, 0x03c43d38,
+    0x0402e6c7, 0x0445a2d1, 0x048cb516, 0x04d865bb, 0x05290198, 0x057eda81, 0x05da479c, 0x063ba5bb,
+    0x06a357b5, 0x0711c6cf, 0x07876325, 0x0804a41c, 0x088a08db, 0x091818ce, 0x09af642c, 0x0a50848c,
+    0x0afc1d81, 0x0bb2dd3d, 0x0c757d46, 0x0d44c331, 0x0e218168, 0x0f0c9802, 0x1006f5a8, 0x11119884,
+    0x122d8f44, 0x135bfa2d, 0x149e0c41, 0x15f50c76, 0x176256ff, 0x18e75eb2, 0x1a85ae7e, 0x1c3eeafb,
+    0x1e14d418, 0x200946df, 0x221e3f5b, 0x2455da99, 0x26b258d3, 0x29361fb2, 0x2be3bcc1, 0x2ebde804,
+    0x31c786bb, 0x3503ae51, 0x3875a77d, 0x3c20f19a, 0x40094633, 0x44329cca, 0x48a12ede, 0x4d597c39,
+    0x52604f7e, 0x57bac304, 0x5d6e460c, 0x6380a23c, 0x69f80185, 0x70daf465, 0x7830788e, 0x7fffffff
+};
+
+/* cos and sin of pi*m/1024 in Q31, m = 0..511, for the pre- and post-twiddle and the FFT */
+static const int32_t m_vbTwiddle[VB_TWSIZE] HELIX_DRAM = {
+    0x7fffffff, 0x00000000, 0x7fffd886, 0x006487e3, 0x7fff6216, 0x00c90f88, 0x7ffe9cb2, 0x012d96b1,
+    0x7ffd885a, 0x01921d20, 0x7ffc250f, 0x01f6a297, 0x7ffa72d1, 0x025b26d7, 0x7ff871a2, 0x02bfa9a4,
+    0x7ff62182, 0x03242abf, 0x7ff38274, 0x0388a9ea, 0x7ff09478, 0x03ed26e6, 0x7fed5791, 0x0451a177,
+    0x7fe9cbc0, 0x04b6195d, 0x7fe5f108, 0x051a8e5c, 0x7fe1c76b, 0x057f0035, 0x7fdd4eec, 0x05e36ea9,
+    0x7fd8878e, 0x0647d97c, 0x7fd37153, 0x06ac406f, 0x7fce0c3e, 0x0710a345, 0x7fc85854, 0x077501be,
+    0x7fc25596, 0x07d95b9e, 0x7fbc040a, 0x083db0a7, 0x7fb563b3, 0x08a2009a, 0x7fae7495, 0x09064b3a,
+    0x7fa736b4, 0x096a9049, 0x7f9faa15, 0x09cecf89, 0x7f97cebd, 0x0a3308bd, 0x7f8fa4b0, 0x0a973ba5,
+    0x7f872bf3, 0x0afb6805, 0x7f7e648c, 0x0b5f8d9f, 0x7f754e80, 0x0bc3ac35, 0x7f6be9d4, 0x0c27c389,
+    0x7f62368f, 0x0c8bd35e, 0x7f5834b7, 0x0cefdb76, 0x7f4de451, 0x0d53db92, 0x7f434563, 0x0db7d376,
+    0x7f3857f6, 0x0e1bc2e4, 0x7f2d1c0e, 0x0e7fa99e, 0x7f2191b4, 0x0ee38766, 0x7f15b8ee, 0x0f475bff,
+    0x7f0991c4, 0x0fab272b, 0x7efd1c3c, 0x100ee8ad, 0x7ef05860, 0x1072a048, 0x7ee34636, 0x10d64dbd,
+    0x7ed5e5c6, 0x1139f0cf, 0x7ec8371a, 0x119d8941, 0x7eba3a39, 0x120116d5, 0x7eabef2c, 0x1264994e,
+    0x7e9d55fc, 0x12c8106f, 0x7e8e6eb2, 0x132b7bf9, 0x7e7f3957, 0x138edbb1, 0x7e6fb5f4, 0x13f22f58,
+    0x7e5fe493, 0x145576b1, 0x7e4fc53e, 0x14b8b17f, 0x7e3f57ff, 0x151bdf86, 0x7e2e9cdf, 0x157f0086,
+    0x7e1d93ea, 0x15e21445, 0x7e0c3d29, 0x16451a83, 0x7dfa98a8, 0x16a81305, 0x7de8a670, 0x170afd8d,
+    0x7dd6668f, 0x176dd9de, 0x7dc3d90d, 0x17d0a7bc, 0x7db0fdf8, 0x183366e9, 0x7d9dd55a, 0x18961728,
+    0x7d8a5f40, 0x18f8b83c, 0x7d769bb5, 0x195b49ea, 0x7d628ac6, 0x19bdcbf3, 0x7d4e2c7f, 0x1a203e1b,
+    0x7d3980ec, 0x1a82a026, 0x7d24881b, 0x1ae4f1d6, 0x7d0f4218, 0x1b4732ef, 0x7cf9aef0, 0x1ba96335,
+    0x7ce3ceb2, 0x1c0b826a, 0x7ccda169, 0x1c6d9053, 0x7cb72724, 0x1ccf8cb3, 0x7ca05ff1, 0x1d31774d,
+    0x7c894bde, 0x1d934fe5, 0x7c71eaf9, 0x1df5163f, 0x7c5a3d50, 0x1e56ca1e, 0x7c4242f2, 0x1eb86b46,
+    0x7c29fbee, 0x1f19f97b, 0x7c116853, 0x1f7b7481, 0x7bf88830, 0x1fdcdc1b, 0x7bdf5b94, 0x203e300d,
+    0x7bc5e290, 0x209f701c, 0x7bac1d31, 0x21009c0c, 0x7b920b89, 0x2161b3a0, 0x7b77ada8, 0x21c2b69c,
+    0x7b5d039e, 0x2223a4c5, 0x7b420d7a, 0x22847de0, 0x7b26cb4f, 0x22e541af, 0x7b0b3d2c, 0x2345eff8,
+    0x7aef6323, 0x23a6887f, 0x7ad33d45, 0x24070b08, 0x7ab6cba4, 0x24677758, 0x7a9a0e50, 0x24c7cd33,
+    0x7a7d055b, 0x25280c5e, 0x7a5fb0d8, 0x2588349d, 0x7a4210d8, 0x25e845b6, 0x7a24256f, 0x26483f6c,
+    0x7a05eead, 0x26a82186, 0x79e76ca7, 0x2707ebc7, 0x79c89f6e, 0x27679df4, 0x79a98715, 0x27c737d3,
+    0x798a23b1, 0x2826b928, 0x796a7554, 0x288621b9, 0x794a7c12, 0x28e5714b, 0x792a37fe, 0x2944a7a2,
+    0x7909a92d, 0x29a3c485, 0x78e8cfb2, 0x2a02c7b8, 0x78c7aba2, 0x2a61b101, 0x78a63d11, 0x2ac08026,
+    0x78848414, 0x2b1f34eb, 0x786280bf, 0x2b7dcf17, 0x78403329, 0x2bdc4e6f, 0x781d9b65, 0x2c3ab2b9,
+    0x77fab989, 0x2c98fbba, 0x77d78daa, 0x2cf72939, 0x77b417df, 0x2d553afc, 0x7790583e, 0x2db330c7,
+    0x776c4edb, 0x2e110a62, 0x7747fbce, 0x2e6ec792, 0x77235f2d, 0x2ecc681e, 0x76fe790e, 0x2f29ebcc,
+    0x76d94989, 0x2f875262, 0x76b3d0b4, 0x2fe49ba7, 0x768e0ea6, 0x3041c761, 0x76680376, 0x309ed556,
+    0x7641af3d, 0x30fbc54d, 0x761b1211, 0x3158970e, 0x75f42c0b, 0x31b54a5e, 0x75ccfd42, 0x3211df04,
+    0x75a585cf, 0x326e54c7, 0x757dc5ca, 0x32caab6f, 0x7555bd4c, 0x3326e2c3, 0x752d6c6c, 0x3382fa88,
+    0x7504d345, 0x33def287, 0x74dbf1ef, 0x343aca87, 0x74b2c884, 0x34968250, 0x7489571c, 0x34f219a8,
+    0x745f9dd1, 0x354d9057, 0x74359cbd, 0x35a8e625, 0x740b53fb, 0x36041ad9, 0x73e0c3a3, 0x365f2e3b,
+    0x73b5ebd1, 0x36ba2014, 0x738acc9e, 0x3714f02a, 0x735f6626, 0x376f9e46, 0x7333b883, 0x37ca2a30,
+    0x7307c3d0, 0x382493b0, 0x72db8828, 0x387eda8e, 0x72af05a7, 0x38d8fe93, 0x72823c67, 0x3932ff87,
+    0x72552c85, 0x398cdd32, 0x7227d61c, 0x39e6975e, 0x71fa3949, 0x3a402dd2, 0x71cc5626, 0x3a99a057,
+    0x719e2cd2, 0x3af2eeb7, 0x716fbd68, 0x3b4c18ba, 0x71410805, 0x3ba51e29, 0x71120cc5, 0x3bfdfecd,
+    0x70e2cbc6, 0x3c56ba70, 0x70b34525, 0x3caf50da, 0x708378ff, 0x3d07c1d6, 0x70536771, 0x3d600d2c,
+    0x7023109a, 0x3db832a6, 0x6ff27497, 0x3e10320d, 0x6fc19385, 0x3e680b2c, 0x6f906d84, 0x3ebfbdcd,
+    0x6f5f02b2, 0x3f1749b8, 0x6f2d532c, 0x3f6eaeb8, 0x6efb5f12, 0x3fc5ec98, 0x6ec92683, 0x401d0321,
+    0x6e96a99d, 0x4073f21d, 0x6e63e87f, 0x40cab958, 0x6e30e34a, 0x4121589b, 0x6dfd9a1c, 0x4177cfb1,
+    0x6dca0d14, 0x41ce1e65, 0x6d963c54, 0x42244481, 0x6d6227fa, 0x427a41d0, 0x6d2dd027, 0x42d0161e,
+    0x6cf934fc, 0x4325c135, 0x6cc45698, 0x437b42e1, 0x6c8f351c, 0x43d09aed, 0x6c59d0a9, 0x4425c923,
+    0x6c242960, 0x447acd50, 0x6bee3f62, 0x44cfa740, 0x6bb812d1, 0x452456bd, 0x6b81a3cd, 0x4578db93,
+    0x6b4af279, 0x45cd358f, 0x6b13fef5, 0x4621647d, 0x6adcc964, 0x46756828, 0x6aa551e9, 0x46c9405c,
+    0x6a6d98a4, 0x471cece7, 0x6a359db9, 0x47706d93, 0x69fd614a, 0x47c3c22f, 0x69c4e37a, 0x4816ea86,
+    0x698c246c, 0x4869e665, 0x69532442, 0x48bcb599, 0x6919e320, 0x490f57ee, 0x68e06129, 0x4961cd33,
+    0x68a69e81, 0x49b41533, 0x686c9b4b, 0x4a062fbd, 0x683257ab, 0x4a581c9e, 0x67f7d3c5, 0x4aa9dba2,
+    0x67bd0fbd, 0x4afb6c98, 0x67820bb7, 0x4b4ccf4d, 0x6746c7d8, 0x4b9e0390, 0x670b4444, 0x4bef092d,
+    0x66cf8120, 0x4c3fdff4, 0x66937e91, 0x4c9087b1, 0x66573cbb, 0x4ce10034, 0x661abbc5, 0x4d31494b,
+    0x65ddfbd3, 0x4d8162c4, 0x65a0fd0b, 0x4dd14c6e, 0x6563bf92, 0x4e210617, 0x6526438f, 0x4e708f8f,
+    0x64e88926, 0x4ebfe8a5, 0x64aa907f, 0x4f0f1126, 0x646c59bf, 0x4f5e08e3, 0x642de50d, 0x4faccfab,
+    0x63ef3290, 0x4ffb654d, 0x63b0426d, 0x5049c999, 0x637114cc, 0x5097fc5e, 0x6331a9d4, 0x50e5fd6d,
+    0x62f201ac, 0x5133cc94, 0x62b21c7b, 0x518169a5, 0x6271fa69, 0x51ced46e, 0x62319b9d, 0x521c0cc2,
+    0x61f1003f, 0x5269126e, 0x61b02876, 0x52b5e546, 0x616f146c, 0x53028518, 0x612dc447, 0x534ef1b5,
+    0x60ec3830, 0x539b2af0, 0x60aa7050, 0x53e73097, 0x60686ccf, 0x5433027d, 0x60262dd6, 0x547ea073,
+    0x5fe3b38d, 0x54ca0a4b, 0x5fa0fe1f, 0x55153fd4, 0x5f5e0db3, 0x556040e2, 0x5f1ae274, 0x55ab0d46,
+    0x5ed77c8a, 0x55f5a4d2, 0x5e93dc1f, 0x56400758, 0x5e50015d, 0x568a34a9, 0x5e0bec6e, 0x56d42c99,
+    0x5dc79d7c, 0x571deefa, 0x5d8314b1, 0x57677b9d, 0x5d3e5237, 0x57b0d256, 0x5cf95638, 0x57f9f2f8,
+    0x5cb420e0, 0x5842dd54, 0x5c6eb258, 0x588b9140, 0x5c290acc, 0x58d40e8c, 0x5be32a67, 0x591c550e,
+    0x5b9d1154, 0x59646498, 0x5b56bfbd, 0x59ac3cfd, 0x5b1035cf, 0x59f3de12, 0x5ac973b5, 0x5a3b47ab,
+    0x5a82799a, 0x5a82799a, 0x5a3b47ab, 0x5ac973b5, 0x59f3de12, 0x5b1035cf, 0x59ac3cfd, 0x5b56bfbd,
+    0x59646498, 0x5b9d1154, 0x591c550e, 0x5be32a67, 0x58d40e8c, 0x5c290acc, 0x588b9140, 0x5c6eb258,
+    0x5842dd54, 0x5cb420e0, 0x57f9f2f8, 0x5cf95638, 0x57b0d256, 0x5d3e5237, 0x57677b9d, 0x5d8314b1,
+    0x571deefa, 0x5dc79d7c, 0x56d42c99, 0x5e0bec6e, 0x568a34a9, 0x5e50015d, 0x56400758, 0x5e93dc1f,
+    0x55f5a4d2, 0x5ed77c8a, 0x55ab0d46, 0x5f1ae274, 0x556040e2, 0x5f5e0db3, 0x55153fd4, 0x5fa0fe1f,
+    0x54ca0a4b, 0x5fe3b38d, 0x547ea073, 0x60262dd6, 0x5433027d, 0x60686ccf, 0x53e73097, 0x60aa7050,
+    0x539b2af0, 0x60ec3830, 0x534ef1b5, 0x612dc447, 0x53028518, 0x616f146c, 0x52b5e546, 0x61b02876,
+    0x5269126e, 0x61f1003f, 0x521c0cc2, 0x62319b9d, 0x51ced46e, 0x6271fa69, 0x518169a5, 0x62b21c7b,
+    0x5133cc94, 0x62f201ac, 0x50e5fd6d, 0x6331a9d4, 0x5097fc5e, 0x637114cc, 0x5049c999, 0x63b0426d,
+    0x4ffb654d, 0x63ef3290, 0x4faccfab, 0x642de50d, 0x4f5e08e3, 0x646c59bf, 0x4f0f1126, 0x64aa907f,
+    0x4ebfe8a5, 0x64e88926, 0x4e708f8f, 0x6526438f, 0x4e210617, 0x6563bf92, 0x4dd14c6e, 0x65a0fd0b,
+    0x4d8162c4, 0x65ddfbd3, 0x4d31494b, 0x661abbc5, 0x4ce10034, 0x66573cbb, 0x4c9087b1, 0x66937e91,
+    0x4c3fdff4, 0x66cf8120, 0x4bef092d, 0x670b4444, 0x4b9e0390, 0x6746c7d8, 0x4b4ccf4d, 0x67820bb7,
+    0x4afb6c98, 0x67bd0fbd, 0x4aa9dba2, 0x67f7d3c5, 0x4a581c9e, 0x683257ab, 0x4a062fbd, 0x686c9b4b,
+    0x49b41533, 0x68a69e81, 0x4961cd33, 0x68e06129, 0x490f57ee, 0x6919e320, 0x48bcb599, 0x69532442,
+    0x4869e665, 0x698c246c, 0x4816ea86, 0x69c4e37a, 0x47c3c22f, 0x69fd614a, 0x47706d93, 0x6a359db9,
+    0x471cece7, 0x6a6d98a4, 0x46c9405c, 0x6aa551e9, 0x46756828, 0x6adcc964, 0x4621647d, 0x6b13fef5,
+    0x45cd358f, 0x6b4af279, 0x4578db93, 0x6b81a3cd, 0x452456bd, 0x6bb812d1, 0x44cfa740, 0x6bee3f62,
+    0x447acd50, 0x6c242960, 0x4425c923, 0x6c59d0a9, 0x43d09aed, 0x6c8f351c, 0x437b42e1, 0x6cc45698,
+    0x4325c135, 0x6cf934fc, 0x42d0161e, 0x6d2dd027, 0x427a41d0, 0x6d6227fa, 0x42244481, 0x6d963c54,
+    0x41ce1e65, 0x6dca0d14, 0x4177cfb1, 0x6dfd9a1c, 0x4121589b, 0x6e30e34a, 0x40cab958, 0x6e63e87f,
+    0x4073f21d, 0x6e96a99d, 0x401d0321, 0x6ec92683, 0x3fc5ec98, 0x6efb5f12, 0x3f6eaeb8, 0x6f2d532c,
+    0x3f1749b8, 0x6f5f02b2, 0x3ebfbdcd, 0x6f906d84, 0x3e680b2c, 0x6fc19385, 0x3e10320d, 0x6ff27497,
+    0x3db832a6, 0x7023109a, 0x3d600d2c, 0x70536771, 0x3d07c1d6, 0x708378ff, 0x3caf50da, 0x70b34525,
+    0x3c56ba70, 0x70e2cbc6, 0x3bfdfecd, 0x71120cc5, 0x3ba51e29, 0x71410805, 0x3b4c18ba, 0x716fbd68,
+    0x3af2eeb7, 0x719e2cd2, 0x3a99a057, 0x71cc5626, 0x3a402dd2, 0x71fa3949, 0x39e6975e, 0x7227d61c,
+    0x398cdd32, 0x72552c85, 0x3932ff87, 0x72823c67, 0x38d8fe93, 0x72af05a7, 0x387eda8e, 0x72db8828,
+    0x382493b0, 0x7307c3d0, 0x37ca2a30, 0x7333b883, 0x376f9e46, 0x735f6626, 0x3714f02a, 0x738acc9e,
+    0x36ba2014, 0x73b5ebd1, 0x365f2e3b, 0x73e0c3a3, 0x36041ad9, 0x740b53fb, 0x35a8e625, 0x74359cbd,
+    0x354d9057, 0x745f9dd1, 0x34f219a8, 0x7489571c, 0x34968250, 0x74b2c884, 0x343aca87, 0x74dbf1ef,
+    0x33def287, 0x7504d345, 0x3382fa88, 0x752d6c6c, 0x3326e2c3, 0x7555bd4c, 0x32caab6f, 0x757dc5ca,
+    0x326e54c7, 0x75a585cf, 0x3211df04, 0x75ccfd42, 0x31b54a5e, 0x75f42c0b, 0x3158970e, 0x761b1211,
+    0x30fbc54d, 0x7641af3d, 0x309ed556, 0x76680376, 0x3041c761, 0x768e0ea6, 0x2fe49ba7, 0x76b3d0b4,
+    0x2f875262, 0x76d94989, 0x2f29ebcc, 0x76fe790e, 0x2ecc681e, 0x77235f2d, 0x2e6ec792, 0x7747fbce,
+    0x2e110a62, 0x776c4edb, 0x2db330c7, 0x7790583e, 0x2d553afc, 0x77b417df, 0x2cf72939, 0x77d78daa,
+    0x2c98fbba, 0x77fab989, 0x2c3ab2b9, 0x781d9b65, 0x2bdc4e6f, 0x78403329, 0x2b7dcf17, 0x786280bf,
+    0x2b1f34eb, 0x78848414, 0x2ac08026, 0x78a63d11, 0x2a61b101, 0x78c7aba2, 0x2a02c7b8, 0x78e8cfb2,
+    0x29a3c485, 0x7909a92d, 0x2944a7a2, 0x792a37fe, 0x28e5714b, 0x794a7c12, 0x288621b9, 0x796a7554,
+    0x2826b928, 0x798a23b1, 0x27c737d3, 0x79a98715, 0x27679df4, 0x79c89f6e, 0x2707ebc7, 0x79e76ca7,
+    0x26a82186, 0x7a05eead, 0x26483f6c, 0x7a24256f, 0x25e845b6, 0x7a4210d8, 0x2588349d, 0x7a5fb0d8,
+    0x25280c5e, 0x7a7d055b, 0x24c7cd33, 0x7a9a0e50, 0x24677758, 0x7ab6cba4, 0x24070b08, 0x7ad33d45,
+    0x23a6887f, 0x7aef6323, 0x2345eff8, 0x7b0b3d2c, 0x22e541af, 0x7b26cb4f, 0x22847de0, 0x7b420d7a,
+    0x2223a4c5, 0x7b5d039e, 0x21c2b69c, 0x7b77ada8, 0x2161b3a0, 0x7b920b89, 0x21009c0c, 0x7bac1d31,
+    0x209f701c, 0x7bc5e290, 0x203e300d, 0x7bdf5b94, 0x1fdcdc1b, 0x7bf88830, 0x1f7b7481, 0x7c116853,
+    0x1f19f97b, 0x7c29fbee, 0x1eb86b46, 0x7c4242f2, 0x1e56ca1e, 0x7c5a3d50, 0x1df5163f, 0x7c71eaf9,
+    0x1d934fe5, 0x7c894bde, 0x1d31774d, 0x7ca05ff1, 0x1ccf8cb3, 0x7cb72724, 0x1c6d9053, 0x7ccda169,
+    0x1c0b826a, 0x7ce3ceb2, 0x1ba96335, 0x7cf9aef0, 0x1b4732ef, 0x7d0f4218, 0x1ae4f1d6, 0x7d24881b,
+    0x1a82a026, 0x7d3980ec, 0x1a203e1b, 0x7d4e2c7f, 0x19bdcbf3, 0x7d628ac6, 0x195b49ea, 0x7d769bb5,
+    0x18f8b83c, 0x7d8a5f40, 0x18961728, 0x7d9dd55a, 0x183366e9, 0x7db0fdf8, 0x17d0a7bc, 0x7dc3d90d,
+    0x176dd9de, 0x7dd6668f, 0x170afd8d, 0x7de8a670, 0x16a81305, 0x7dfa98a8, 0x16451a83, 0x7e0c3d29,
+    0x15e21445, 0x7e1d93ea, 0x157f0086, 0x7e2e9cdf, 0x151bdf86, 0x7e3f57ff, 0x14b8b17f, 0x7e4fc53e,
+    0x145576b1, 0x7e5fe493, 0x13f22f58, 0x7e6fb5f4, 0x138edbb1, 0x7e7f3957, 0x132b7bf9, 0x7e8e6eb2,
+    0x12c8106f, 0x7e9d55fc, 0x1264994e, 0x7eabef2c, 0x120116d5, 0x7eba3a39, 0x119d8941, 0x7ec8371a,
+    0x1139f0cf, 0x7ed5e5c6, 0x10d64dbd, 0x7ee34636, 0x1072a048, 0x7ef05860, 0x100ee8ad, 0x7efd1c3c,
+    0x0fab272b, 0x7f0991c4, 0x0f475bff, 0x7f15b8ee, 0x0ee38766, 0x7f2191b4, 0x0e7fa99e, 0x7f2d1c0e,
+    0x0e1bc2e4, 0x7f3857f6, 0x0db7d376, 0x7f434563, 0x0d53db92, 0x7f4de451, 0x0cefdb76, 0x7f5834b7,
+    0x0c8bd35e, 0x7f62368f, 0x0c27c389, 0x7f6be9d4, 0x0bc3ac35, 0x7f754e80, 0x0b5f8d9f, 0x7f7e648c,
+    0x0afb6805, 0x7f872bf3, 0x0a973ba5, 0x7f8fa4b0, 0x0a3308bd, 0x7f97cebd, 0x09cecf89, 0x7f9faa15,
+    0x096a9049, 0x7fa736b4, 0x09064b3a, 0x7fae7495, 0x08a2009a, 0x7fb563b3, 0x083db0a7, 0x7fbc040a,
+    0x07d95b9e, 0x7fc25596, 0x077501be, 0x7fc85854, 0x0710a345, 0x7fce0c3e, 0x06ac406f, 0x7fd37153,
+    0x0647d97c, 0x7fd8878e, 0x05e36ea9, 0x7fdd4eec, 0x057f0035, 0x7fe1c76b, 0x051a8e5c, 0x7fe5f108,
+    0x04b6195d, 0x7fe9cbc0, 0x0451a177, 0x7fed5791, 0x03ed26e6, 0x7ff09478, 0x0388a9ea, 0x7ff38274,
+    0x03242abf, 0x7ff62182, 0x02bfa9a4, 0x7ff871a2, 0x025b26d7, 0x7ffa72d1, 0x01f6a297, 0x7ffc250f,
+    0x01921d20, 0x7ffd885a, 0x012d96b1, 0x7ffe9cb2, 0x00c90f88, 0x7fff6216, 0x006487e3, 0x7fffd886
+};
+
+/* cos and sin of pi/(4*M) in Q31 for M = 32 .. 1024 */
+static const int32_t m_vbEdge[12] = {
+    0x7ff62182, 0x03242abf, 0x7ffd885a, 0x01921d20, 0x7fff6216, 0x00c90f88, 0x7fffd886, 0x006487e3,
+    0x7ffff621, 0x003243f5, 0x7ffffd88, 0x001921fb
+};
+
+/***********************************************************************************************************************
+ * B I T S T R E A M
+ **********************************************************************************************************************/
+static void VbReaderInit(VbReader_t *br, const uint8_t *buf, int len) {
+    br->buf = buf;
+    br->bits = len * 8;
+    br->pos = 0;
+    br->eop = false;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static inline int VbBit(VbReader_t *br) {
+    int b;
+
+    if (br->pos >= br->bits) {
+        br->eop = true;
+        return -1;
+    }
+    b = (br->buf[br->pos >> 3] >> (br->pos & 7)) & 1;
+    br->pos++;
+    return b;
+}
+/***********************************************************************************************************************
+ * Function:    VbRead
+ *
+ * Description: read an unsigned value from the packet, least significant bit first
+ *
+ * Inputs:      reader
+ *              number of bits, 0..32
+ *
+ * Outputs:     eop set if the packet is too short
+ *
+ * Return:      value, 0 at the end of the packet
+ **********************************************************************************************************************/
+static uint32_t VbRead(VbReader_t *br, int n) {
+    uint32_t v = 0;
+    int      i = 0, off, take;
+
+    if (br->pos + n > br->bits) {
+        br->eop = true;
+        br->pos = br->bits;
+        return 0;
+    }
+    while (i < n) {
+        off = br->pos & 7;
+        take = MIN(8 - off, n - i);
+        v |= (uint32_t)((br->buf[br->pos >> 3] >> off) & ((1 << take) - 1)) << i;
+        i += take;
+        br->pos += take;
+    }
+    return v;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static int VbIlog(uint32_t v) {
+    int n = 0;
+
+    while (v) {
+        n++;
+        v >>= 1;
+    }
+    return n;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static inline int32_t VbMul31(int32_t a, int32_t b) {
+    return (int32_t)(((int64_t)a * b + 0x40000000) >> 31);
+}
+/***********************************************************************************************************************
+ * Function:    VbDecodeEntry
+ *
+ * Description: decode one codeword
+ *
+ * Inputs:      reader
+ *              codebook
+ *
+ * Outputs:     none
+ *
+ * Return:      entry number, -1 at the end of the packet or for a code that is not in the book
+ **********************************************************************************************************************/
+static HELIX_IRAM int VbDecodeEntry(VbReader_t *br, const VbCodebook_t *cb) {
+    const uint16_t *tree = cb->tree;
+    uint16_t        c, node = 0;
+    int             b;
+
+    if (!tree)
+        return -1;
+    for (;;) {
+        if ((b = VbBit(br)) < 0)
+            return -1;
+        c = tree[node * 2 + b];
+        if (c & VB_LEAF)
+            return (c == VB_NONE) ? -1 : (c & ~VB_LEAF);
+        node = c;
+    }
+}
+/***********************************************************************************************************************
+ * Function:    VbEntryValues
+ *
+ * Description: get the vector of a codebook entry
+ *
+ * Inputs:      codebook with lookup type 1 or 2
+ *              entry number
+ *
+ * Outputs:     dims values in Q16
+ *
+ * Return:      none
+ **********************************************************************************************************************/
+static HELIX_IRAM void VbEntryValues(const VbCodebook_t *cb, int e, int32_t *v) {
+    int32_t last = 0;
+    int     k, div = 1;
+
+    if (cb->lookup == 1) {
+        for (k = 0; k < cb->dims; k++) {
+            v[k] = cb->values[(e / div) % cb->lookupValues] + last;
+            if (cb->sequenceP)
+                last = v[k];
+            div *= cb->lookupValues;
+        }
+    }
+    else {
+        memcpy(v, cb->values + e * cb->dims, cb->dims * sizeof(int32_t));
+    }
+}
+/***********************************************************************************************************************
+ * S E T U P   H E A D E R
+ *
+ * The setup header is parsed twice.  The first (measure) pass finds the size of the pool, the items are parsed into
+ * a scratch buffer and the arrays are not stored.  The second pass fills the pool.
+ **********************************************************************************************************************/
+static void *VbAlloc(VbParse_t *p, size_t size) {
+    void *r = NULL;
+
+    size = (size + 7) & ~7;
+    if (p->pool) {
+        r = p->pool + p->used;
+        memset(r, 0, size);
+    }
+    p->used += size;
+    return r;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void *VbItem(VbParse_t *p, void *item, size_t size) {
+    if (item)
+        return item;
+    memset(p->scratch, 0, size);                        /* measure pass */
+    return p->scratch;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static double VbFloat32(uint32_t x) {
+    double m = x & 0x1fffff;
+
+    if (x & 0x80000000)
+        m = -m;
+    return ldexp(m, (int)((x & 0x7fe00000) >> 21) - 788);
+}
+//----------------------------------------------------------------------------------------------------------------------
+static int32_t VbQ16(double v) {                        /* limited to +-2048, 8 passes of residue cannot overflow */
+    v *= 65536.0;
+    if (v > 134217728.0)
+        return 134217728;
+    if (v < -134217728.0)
+        return -134217728;
+    return (int32_t)lround(v);
+}
+//----------------------------------------------------------------------------------------------------------------------
+static bool VbPowLE(int base, int exp, int limit) {     /* base^exp <= limit */
+    uint64_t p = 1;
+
+    while (exp-- > 0) {
+        p *= base;
+        if (p > (uint64_t)limit)
+            return false;
+    }
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static int VbLookup1Values(int entries, int dims) {     /* largest r with r^dims <= entries */
+    int r = (int)floor(pow((double)entries, 1.0 / dims));
+
+    while (VbPowLE(r + 1, dims, entries))
+        r++;
+    while (r > 0 && !VbPowLE(r, dims, entries))
+        r--;
+    return r;
+}
+/***********************************************************************************************************************
+ * Function:    VbAssign
+ *
+ * Description: give an entry the first free codeword of its length
+ *
+ * Inputs:      assignment state
+ *              entry number and codeword length
+ *
+ * Outputs:     codeword added to the tree if there is one
+ *
+ * Return:      0 or ERR_VORBIS_INVALID_SETUP if the book is overspecified
+ *
+ * Notes:       the codewords are assigned in order of entry number, every codeword is the lowest (MSB first) one
+ *                that is not a prefix of or prefixed by an earlier one, see the Vorbis I specification 3.2.1
+ **********************************************************************************************************************/
+static int VbAssign(VbAssign_t *a, int entry, int len) {
+    uint32_t  code;
+    uint16_t *c;
+    int       z = len, i, node;
+
+    if (len > 32)
+        return ERR_VORBIS_INVALID_SETUP;
+    if (a->used == 0) {                                 /* first codeword is all zeros */
+        code = 0;
+        for (i = 1; i <= len; i++)
+            a->avail[i] = 1U << (32 - i);
+        a->firstEntry = entry;
+        a->firstLen = len;
+    }
+    else {
+        while (z > 0 && !a->avail[z])
+            z--;
+        if (z == 0)
+            return ERR_VORBIS_INVALID_SETUP;
+        code = a->avail[z];
+        a->avail[z] = 0;
+        for (i = len; i > z; i--)
+            a->avail[i] = code + (1U << (32 - i));
+    }
+    a->used++;
+    if (!a->tree)
+        return 0;
+    node = 0;
+    for (i = 0; i < len; i++) {
+        c = &a->tree[node * 2 + ((code >> (31 - i)) & 1)];
+        if (i == len - 1) {
+            if (*c != VB_NONE)
+                return ERR_VORBIS_INVALID_SETUP;
+            *c = VB_LEAF | entry;
+        }
+        else {
+            if (*c == VB_NONE) {
+                if (a->nodes >= a->maxNodes)
+                    return ERR_VORBIS_INVALID_SETUP;
+                *c = a->nodes++;
+            }
+            else if (*c & VB_LEAF) {
+                return ERR_VORBIS_INVALID_SETUP;
+            }
+            node = *c;
+        }
+    }
+    return 0;
+}
+/***********************************************************************************************************************
+ * Function:    VbCodewords
+ *
+ * Description: read the codeword lengths of a book and assign the codewords
+ *
+ * Inputs:      reader at the "ordered" flag
+ *              codebook with entries set
+ *              assignment state, with the tree if it must be built
+ *
+ * Outputs:     reader after the lengths
+ *
+ * Return:      0 or error code
+ **********************************************************************************************************************/
+static int VbCodewords(VbReader_t *br, const VbCodebook_t *cb, VbAssign_t *a) {
+    int e = 0, len, n, i, err, sparse;
+
+    if (VbRead(br, 1)) {                                /* ordered: runs of entries with the same length */
+        len = VbRead(br, 5) + 1;
+        while (e < cb->entries) {
+            n = VbRead(br, VbIlog(cb->entries - e));
+            if (br->eop || e + n > cb->entries)
+                return ERR_VORBIS_INVALID_SETUP;
+            for (i = 0; i < n; i++) {
+                if ((err = VbAssign(a, e++, len)) != 0)
+                    return err;
+            }
+            len++;
+        }
+    }
+    else {
+        sparse = VbRead(br, 1);
+        for (e = 0; e < cb->entries; e++) {
+            if (sparse && !VbRead(br, 1))
+                continue;                               /* entry not used */
+            len = VbRead(br, 5) + 1;
+            if ((err = VbAssign(a, e, len)) != 0)
+                return err;
+        }
+    }
+    if (br->eop)
+        return ERR_VORBIS_INVALID_SETUP;
+    if (a->used > 1) {
+        for (i = 1; i <= 32; i++) {
+            if (a->avail[i])                            /* underpopulated, rejected by libvorbis too */
+                return ERR_VORBIS_INVALID_SETUP;
+        }
+    }
+    return 0;
+}
+/***********************************************************************************************************************
+ * Function:    VbParseCodebook
+ *
+ * Description: parse one codebook, build its tree and values
+ *
+ * Inputs:      parse state
+ *              codebook to fill, zeroed
+ *
+ * Outputs:     codebook
+ *
+ * Return:      0 or error code
+ *
+ * Notes:       a book with one entry has a chain of nodes with equal children, the codeword length is skipped
+ *                whatever the bits are, as libvorbis does
+ **********************************************************************************************************************/
+static int VbParseCodebook(VbParse_t *p, VbCodebook_t *cb) {
+    VbReader_t *br = &p->br;
+    VbAssign_t  a;
+    double      vmin, delta, v, last;
+    int         start, end, nodes, bits, n, i, m, err;
+
+    if (VbRead(br, 24) != 0x564342)
+        return ERR_VORBIS_INVALID_SETUP;
+    cb->dims = VbRead(br, 16);
+    cb->entries = VbRead(br, 24);
+    if (cb->dims == 0 || cb->entries == 0)
+        return ERR_VORBIS_INVALID_SETUP;
+    if (cb->entries >= VB_LEAF - 1)
+        return ERR_VORBIS_UNSUPPORTED;
+    start = br->pos;
+    memset(&a, 0, sizeof(a));                           /* count the codewords */
+    if ((err = VbCodewords(br, cb, &a)) != 0)
+        return err;
+    end = br->pos;
+    nodes = (a.used == 1) ? a.firstLen : a.used - 1;
+    cb->tree = (uint16_t*)VbAlloc(p, nodes * 2 * sizeof(uint16_t));
+    if (cb->tree) {
+        memset(cb->tree, 0xff, nodes * 2 * sizeof(uint16_t));
+        if (a.used == 1) {
+            for (i = 0; i < nodes; i++) {
+                cb->tree[i * 2] = (i == nodes - 1) ? (VB_LEAF | a.firstEntry) : i + 1;
+                cb->tree[i * 2 + 1] = cb->tree[i * 2];
+            }
+        }
+        else if (a.used > 1) {
+            memset(&a, 0, sizeof(a));                   /* read the lengths again, now build the tree */
+            a.tree = cb->tree;
+            a.nodes = 1;
+            a.maxNodes = nodes;
+            br->pos = start;
+            if ((err = VbCodewords(br, cb, &a)) != 0)
+                return err;
+        }
+    }
+    br->pos = end;
+    cb->lookup = VbRead(br, 4);
+    if (cb->lookup == 0)
+        return br->eop ? ERR_VORBIS_INVALID_SETUP : 0;
+    if (cb->lookup > 2)
+        return ERR_VORBIS_INVALID_SETUP;
+    if (cb->dims > VB_MAXDIMS)
+        return ERR_VORBIS_UNSUPPORTED;
+    vmin = VbFloat32(VbRead(br, 32));
+    delta = VbFloat32(VbRead(br, 32));
+    bits = VbRead(br, 4) + 1;
+    cb->sequenceP = VbRead(br, 1);
+    if (cb->lookup == 1) {
+        n = VbLookup1Values(cb->entries, cb->dims);
+        if (n == 0)
+            return ERR_VORBIS_INVALID_SETUP;
+        cb->lookupValues = n;
+    }
+    else {
+        n = cb->entries * cb->dims;
+    }
+    cb->values = (int32_t*)VbAlloc(p, n * sizeof(int32_t));
+    last = 0.0;
+    for (i = 0; i < n; i++) {
+        m = VbRead(br, bits);
+        if (!cb->values)
+            continue;
+        v = m * delta + vmin;
+        if (cb->lookup == 2 && cb->sequenceP) {         /* lookup 1 values are accumulated when decoded */
+            if (i % cb->dims == 0)
+                last = 0.0;
+            v += last;
+            last = v;
+        }
+        cb->values[i] = VbQ16(v);
+    }
+    return br->eop ? ERR_VORBIS_INVALID_SETUP : 0;
+}
+/***********************************************************************************************************************
+ * Function:    VbParseFloor
+ *
+ * Description: parse one floor configuration
+ *
+ * Inputs:      parse state
+ *              floor to fill, zeroed
+ *
+ * Outputs:     floor with the points sorted and their neighbours found
+ *
+ * Return:      0 or error code, floor type 0 is not supported
+ **********************************************************************************************************************/
+static int VbParseFloor(VbParse_t *p, VbFloor1_t *f) {
+    VbReader_t *br = &p->br;
+    int         type, maxClass = -1, c, i, j, k, rangeBits;
+
+    type = VbRead(br, 16);
+    if (type == 0)
+        return ERR_VORBIS_UNSUPPORTED;
+    if (type != 1)
+        return ERR_VORBIS_INVALID_SETUP;
+    f->partitions = VbRead(br, 5);
+    for (i = 0; i < f->partitions; i++) {
+        f->partClass[i] = VbRead(br, 4);
+        if (f->partClass[i] > maxClass)
+            maxClass = f->partClass[i];
+    }
+    for (c = 0; c <= maxClass; c++) {
+        f->classDims[c] = VbRead(br, 3) + 1;
+        f->classSubs[c] = VbRead(br, 2);
+        f->classMaster[c] = -1;
+        if (f->classSubs[c]) {
+            f->classMaster[c] = VbRead(br, 8);
+            if (f->classMaster[c] >= p->nBooks)
+                return ERR_VORBIS_INVALID_SETUP;
+        }
+        for (j = 0; j < (1 << f->classSubs[c]); j++) {
+            f->subBooks[c][j] = (int)VbRead(br, 8) - 1;
+            if (f->subBooks[c][j] >= p->nBooks)
+                return ERR_VORBIS_INVALID_SETUP;
+        }
+    }
+    f->multiplier = VbRead(br, 2) + 1;
+    rangeBits = VbRead(br, 4);
+    f->x[0] = 0;
+    f->x[1] = 1 << rangeBits;
+    f->values = 2;
+    for (i = 0; i < f->partitions; i++) {
+        for (j = 0; j < f->classDims[f->partClass[i]]; j++) {
+            if (f->values >= VORBIS_MAXPOSTS)
+                return ERR_VORBIS_INVALID_SETUP;
+            f->x[f->values++] = VbRead(br, rangeBits);
+        }
+    }
+    for (i = 0; i < f->values; i++) {                   /* insertion sort of the point numbers */
+        for (j = i; j > 0 && f->x[f->sorted[j - 1]] > f->x[i]; j--)
+            f->sorted[j] = f->sorted[j - 1];
+        f->sorted[j] = i;
+    }
+    for (i = 1; i < f->values; i++) {
+        if (f->x[f->sorted[i]] == f->x[f->sorted[i - 1]])
+            return ERR_VORBIS_INVALID_SETUP;
+    }
+    for (i = 2; i < f->values; i++) {                   /* neighbours among the points before this one */
+        f->low[i] = 0;
+        f->high[i] = 1;
+        for (k = 0; k < i; k++) {
+            if (f->x[k] < f->x[i] && f->x[k] > f->x[f->low[i]])
+                f->low[i] = k;
+            if (f->x[k] > f->x[i] && f->x[k] < f->x[f->high[i]])
+                f->high[i] = k;
+        }
+    }
+    return br->eop ? ERR_VORBIS_INVALID_SETUP : 0;
+}
+/***********************************************************************************************************************
+ * Function:    VbParseResidue
+ *
+ * Description: parse one residue configuration
+ *
+ * Inputs:      parse state
+ *              residue to fill, zeroed
+ *
+ * Outputs:     residue
+ *
+ * Return:      0 or error code
+ *
+ * Notes:       the books are checked in the second pass, when they are stored
+ **********************************************************************************************************************/
+static int VbParseResidue(VbParse_t *p, VbResidue_t *r) {
+    VbReader_t *br = &p->br;
+    VorbisInfo_t *vi = m_VorbisInfo;
+    uint8_t     cascade[64];
+    int         c, j, b, actual, parts;
+
+    r->type = VbRead(br, 16);
+    if (r->type > 2)
+        return ERR_VORBIS_INVALID_SETUP;
+    r->begin = VbRead(br, 24);
+    r->end = VbRead(br, 24);
+    r->partSize = VbRead(br, 24) + 1;
+    r->classifications = VbRead(br, 6) + 1;
+    r->classBook = VbRead(br, 8);
+    if (r->classBook >= p->nBooks)
+        return ERR_VORBIS_INVALID_SETUP;
+    for (c = 0; c < r->classifications; c++) {
+        cascade[c] = VbRead(br, 3);
+        if (VbRead(br, 1))
+            cascade[c] |= VbRead(br, 5) << 3;
+    }
+    r->books = (int16_t(*)[8])VbAlloc(p, r->classifications * 8 * sizeof(int16_t));
+    for (c = 0; c < r->classifications; c++) {
+        for (j = 0; j < 8; j++) {
+            b = -1;
+            if (cascade[c] & (1 << j)) {
+                b = VbRead(br, 8);
+                if (b >= p->nBooks)
+                    return ERR_VORBIS_INVALID_SETUP;
+                if (p->books && (p->books[b].lookup == 0 || p->books[b].dims > VB_MAXDIMS))
+                    return ERR_VORBIS_INVALID_SETUP;
+            }
+            if (r->books)
+                r->books[c][j] = b;
+        }
+    }
+    if (p->books) {                                     /* classifications of the largest block must fit */
+        if (!p->books[r->classBook].tree)
+            return ERR_VORBIS_INVALID_SETUP;
+        actual = vi->blockSize[1] / 2 * ((r->type == 2) ? vi->channels : 1);
+        parts = (MIN(r->end, actual) - MIN(r->begin, actual)) / r->partSize;
+        if (parts + p->books[r->classBook].dims > VORBIS_MAXPARTS)
+            return ERR_VORBIS_UNSUPPORTED;
+    }
+    return br->eop ? ERR_VORBIS_INVALID_SETUP : 0;
+}
+/***********************************************************************************************************************
+ * Function:    VbParseMapping
+ *
+ * Description: parse one mapping
+ *
+ * Inputs:      parse state
+ *              mapping to fill, zeroed
+ *
+ * Outputs:     mapping
+ *
+ * Return:      0 or error code
+ **********************************************************************************************************************/
+static int VbParseMapping(VbParse_t *p, VbMapping_t *m) {
+    VbReader_t *br = &p->br;
+    int         channels = m_VorbisInfo->channels;
+    int         i, bits, mag, ang;
+
+    if (VbRead(br, 16) != 0)
+        return ERR_VORBIS_INVALID_SETUP;
+    m->submaps = VbRead(br, 1) ? VbRead(br, 4) + 1 : 1;
+    if (VbRead(br, 1)) {
+        m->couplingSteps = VbRead(br, 8) + 1;
+        m->coupling = (uint8_t*)VbAlloc(p, m->couplingSteps * 2);
+        bits = VbIlog(channels - 1);
+        for (i = 0; i < m->couplingSteps; i++) {
+            mag = VbRead(br, bits);
+            ang = VbRead(br, bits);
+            if (mag == ang || mag >= channels || ang >= channels)
+                return ERR_VORBIS_INVALID_SETUP;
+            if (m->coupling) {
+                m->coupling[i * 2] = mag;
+                m->coupling[i * 2 + 1] = ang;
+            }
+        }
+    }
+    if (VbRead(br, 2) != 0)
+        return ERR_VORBIS_INVALID_SETUP;
+    if (m->submaps > 1) {
+        for (i = 0; i < channels; i++) {
+            m->mux[i] = VbRead(br, 4);
+            if (m->mux[i] >= m->submaps)
+                return ERR_VORBIS_INVALID_SETUP;
+        }
+    }
+    for (i = 0; i < m->submaps; i++) {
+        VbRead(br, 8);                                  /* time configuration, unused */
+        m->floor[i] = VbRead(br, 8);
+        m->residue[i] = VbRead(br, 8);
+        if (m->floor[i] >= p->nFloors || m->residue[i] >= p->nResidues)
+            return ERR_VORBIS_INVALID_SETUP;
+    }
+    return br->eop ? ERR_VORBIS_INVALID_SETUP : 0;
+}
+/***********************************************************************************************************************
+ * Function:    VbParseSetup
+ *
+ * Description: parse the setup header, one pass
+ *
+ * Inputs:      parse state, reader at the start of the packet
+ *
+ * Outputs:     in the second pass: the pool is filled and the decoder instance points into it
+ *
+ * Return:      0 or error code
+ **********************************************************************************************************************/
+static int VbParseSetup(VbParse_t *p) {
+    VorbisInfo_t *vi = m_VorbisInfo;
+    VbReader_t   *br = &p->br;
+    VbFloor1_t   *floors;
+    VbResidue_t  *residues;
+    VbMapping_t  *mappings;
+    VbMode_t     *modes, *mode;
+    int32_t      *window[2];
+    int           i, k, n, nModes, err;
+
+    VbRead(br, 8);                                      /* packet type and "vorbis", checked by caller */
+    br->pos = 7 * 8;
+    p->nBooks = VbRead(br, 8) + 1;
+    p->books = (VbCodebook_t*)VbAlloc(p, p->nBooks * sizeof(VbCodebook_t));
+    for (i = 0; i < p->nBooks; i++) {
+        err = VbParseCodebook(p, (VbCodebook_t*)VbItem(p, p->books ? &p->books[i] : NULL, sizeof(VbCodebook_t)));
+        if (err)
+            return err;
+    }
+    n = VbRead(br, 6) + 1;                              /* time domain transforms, placeholders */
+    for (i = 0; i < n; i++) {
+        if (VbRead(br, 16) != 0)
+            return ERR_VORBIS_INVALID_SETUP;
+    }
+    p->nFloors = VbRead(br, 6) + 1;
+    floors = (VbFloor1_t*)VbAlloc(p, p->nFloors * sizeof(VbFloor1_t));
+    for (i = 0; i < p->nFloors; i++) {
+        if ((err = VbParseFloor(p, (VbFloor1_t*)VbItem(p, floors ? &floors[i] : NULL, sizeof(VbFloor1_t)))) != 0)
+            return err;
+    }
+    p->nResidues = VbRead(br, 6) + 1;
+    residues = (VbResidue_t*)VbAlloc(p, p->nResidues * sizeof(VbResidue_t));
+    for (i = 0; i < p->nResidues; i++) {
+        if ((err = VbParseResidue(p, (VbResidue_t*)VbItem(p, residues ? &residues[i] : NULL, sizeof(VbResidue_t)))) != 0)
+            return err;
+    }
+    p->nMappings = VbRead(br, 6) + 1;
+    mappings = (VbMapping_t*)VbAlloc(p, p->nMappings * sizeof(VbMapping_t));
+    for (i = 0; i < p->nMappings; i++) {
+        if ((err = VbParseMapping(p, (VbMapping_t*)VbItem(p, mappings ? &mappings[i] : NULL, sizeof(VbMapping_t)))) != 0)
+            return err;
+    }
+    nModes = VbRead(br, 6) + 1;
+    modes = (VbMode_t*)VbAlloc(p, nModes * sizeof(VbMode_t));
+    for (i = 0; i < nModes; i++) {
+        mode = (VbMode_t*)VbItem(p, modes ? &modes[i] : NULL, sizeof(VbMode_t));
+        mode->blockFlag = VbRead(br, 1);
+        if (VbRead(br, 16) != 0 || VbRead(br, 16) != 0)
+            return ERR_VORBIS_INVALID_SETUP;
+        mode->mapping = VbRead(br, 8);
+        if (mode->mapping >= p->nMappings)
+            return ERR_VORBIS_INVALID_SETUP;
+    }
+    if (VbRead(br, 1) != 1 || br->eop)                  /* framing bit */
+        return ERR_VORBIS_INVALID_SETUP;
+    for (k = 0; k < 2; k++) {                           /* window slopes for the short and the long overlap */
+        n = vi->blockSize[k] / 2;
+        window[k] = (int32_t*)VbAlloc(p, n * sizeof(int32_t));
+        if (!window[k])
+            continue;
+        for (i = 0; i < n; i++) {
+            double s = sin((i + 0.5) / n * M_PI / 2);
+            window[k][i] = (int32_t)MIN(sin(M_PI / 2 * s * s) * 2147483648.0, 2147483647.0);
+        }
+    }
+    if (p->pool) {
+        m_books = p->books;
+        m_nBooks = p->nBooks;
+        m_floors = floors;
+        m_nFloors = p->nFloors;
+        m_residues = residues;
+        m_nResidues = p->nResidues;
+        m_mappings = mappings;
+        m_nMappings = p->nMappings;
+        m_modes = modes;
+        m_nModes = nModes;
+        m_window[0] = window[0];
+        m_window[1] = window[1];
+    }
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static void VbFreeSetup() {
+    if (m_pool)
+        free(m_pool);
+    m_pool = NULL;
+    m_poolSize = 0;
+    m_books = NULL;
+    m_floors = NULL;
+    m_residues = NULL;
+    m_mappings = NULL;
+    m_modes = NULL;
+    m_window[0] = m_window[1] = NULL;
+    m_nBooks = m_nFloors = m_nResidues = m_nMappings = m_nModes = 0;
+}
+/***********************************************************************************************************************
+ * Function:    VbSetup
+ *
+ * Description: measure the setup header, allocate the pool and fill it
+ *
+ * Inputs:      setup header packet
+ *
+ * Outputs:     decoder instance ready for audio packets
+ *
+ * Return:      0 or error code
+ *
+ * Notes:       the pool is one heap block, PSRAM is used if the heap is too small
+ **********************************************************************************************************************/
+static int VbSetup(const uint8_t *pkt, int len) {
+    VbParse_t p;
+    uint8_t  *pool;
+    int       err;
+
+    VbFreeSetup();
+    memset(&p, 0, sizeof(p));
+    p.scratch = m_VorbisInfo->packet;                   /* not in use, the setup is in the union */
+    VbReaderInit(&p.br, pkt, len);
+    if ((err = VbParseSetup(&p)) != 0)
+        return err;
+    pool = (uint8_t*)malloc(p.used);
+    if (!pool && psramFound())
+        pool = (uint8_t*)ps_malloc(p.used);
+    if (!pool) {
+        log_e("Vorbis: no room for the setup (%d bytes)", (int)p.used);
+        return ERR_VORBIS_OUT_OF_MEMORY;
+    }
+    memset(&p, 0, sizeof(p));
+    p.pool = pool;
+    VbReaderInit(&p.br, pkt, len);
+    if ((err = VbParseSetup(&p)) != 0) {
+        free(pool);
+        VbFreeSetup();
+        return err;
+    }
+    m_pool = pool;
+    m_poolSize = p.used;
+    return 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static bool VbIsHeader(const uint8_t *pkt, int len, int type) {
+    return (len >= 7 && pkt[0] == type && memcmp(pkt + 1, "vorbis", 6) == 0);
+}
+/***********************************************************************************************************************
+ * Function:    VbParseIdent
+ *
+ * Description: parse the identification header
+ *
+ * Inputs:      packet
+ *
+ * Outputs:     stream parameters in VorbisInfo
+ *
+ * Return:      0 or error code
+ **********************************************************************************************************************/
+static int VbParseIdent(const uint8_t *pkt, int len) {
+    VorbisInfo_t *vi = m_VorbisInfo;
+    VbReader_t    br;
+    int           framing;
+
+    VbReaderInit(&br, pkt, len);
+    br.pos = 7 * 8;
+    if (VbRead(&br, 32) != 0)                           /* version */
+        return ERR_VORBIS_INVALID_HEADER;
+    vi->channels = VbRead(&br, 8);
+    vi->sampRate = VbRead(&br, 32);
+    vi->bitrateMax = (int32_t)VbRead(&br, 32);
+    vi->bitrateNom = (int32_t)VbRead(&br, 32);
+    vi->bitrateMin = (int32_t)VbRead(&br, 32);
+    vi->blockSize[0] = 1 << VbRead(&br, 4);
+    vi->blockSize[1] = 1 << VbRead(&br, 4);
+    framing = VbRead(&br, 1);
+    if (br.eop || !framing || vi->channels == 0 || vi->sampRate <= 0 || vi->blockSize[0] < 64 ||
+        vi->blockSize[1] < vi->blockSize[0] || vi->blockSize[1] > 8192)
+        return ERR_VORBIS_INVALID_HEADER;
+    if (vi->channels > VORBIS_MAXCHANS || vi->blockSize[1] > VORBIS_MAXBLOCK) {
+        log_e("Vorbis: %d channels, block size %d not supported", vi->channels, vi->blockSize[1]);
+        return ERR_VORBIS_UNSUPPORTED;
+    }
+    return 0;
+}
+/***********************************************************************************************************************
+ * F L O O R
+ **********************************************************************************************************************/
+static int VbRenderPoint(int x0, int y0, int x1, int y1, int x) {
+    int dy = y1 - y0, off = abs(dy) * (x - x0) / (x1 - x0);
+
+    return (dy < 0) ? y0 - off : y0 + off;
+}
+/***********************************************************************************************************************
+ * Function:    VbFloorDecode
+ *
+ * Description: decode the floor of a channel and compute the final Y values of its points
+ *
+ * Inputs:      reader
+ *              floor
+ *              channel
+ *
+ * Outputs:     floorY and floorStep of the channel
+ *
+ * Return:      false if the floor is unused (channel is silent in this block)
+ **********************************************************************************************************************/
+static bool VbFloorDecode(VbReader_t *br, const VbFloor1_t *f, int ch) {
+    static const int16_t ranges[4] = {256, 128, 86, 64};
+    int16_t *y = m_VorbisInfo->floorY[ch];
+    uint8_t *step = m_VorbisInfo->floorStep[ch];
+    int      range, bits, off = 2, i, j, c, cbits, csub, cval, book, v, lo, hi, pred, highroom, lowroom, room;
+
+    if (!VbRead(br, 1))
+        return false;
+    range = ranges[f->multiplier - 1];
+    bits = VbIlog(range - 1);
+    y[0] = VbRead(br, bits);
+    y[1] = VbRead(br, bits);
+    for (i = 0; i < f->partitions; i++) {
+        c = f->partClass[i];
+        cbits = f->classSubs[c];
+        csub = (1 << cbits) - 1;
+        cval = 0;
+        if (cbits && (cval = VbDecodeEntry(br, &m_books[f->classMaster[c]])) < 0)
+            return false;
+        for (j = 0; j < f->classDims[c]; j++) {
+            book = f->subBooks[c][cval & csub];
+            cval >>= cbits;
+            v = 0;
+            if (book >= 0 && (v = VbDecodeEntry(br, &m_books[book])) < 0)
+                return false;
+            y[off++] = v;
+        }
+    }
+    if (br->eop)
+        return false;
+    step[0] = step[1] = 1;                              /* amplitude value synthesis */
+    for (i = 2; i < f->values; i++) {
+        lo = f->low[i];
+        hi = f->high[i];
+        pred = VbRenderPoint(f->x[lo], y[lo], f->x[hi], y[hi], f->x[i]);
+        v = y[i];
+        highroom = range - pred;
+        lowroom = pred;
+        room = MIN(highroom, lowroom) * 2;
+        if (v) {
+            step[lo] = step[hi] = step[i] = 1;
+            if (v >= room)
+                y[i] = (highroom > lowroom) ? v - lowroom + pred : pred - v + highroom - 1;
+            else
+                y[i] = (v & 1) ? pred - ((v + 1) >> 1) : pred + (v >> 1);
+        }
+        else {
+            step[i] = 0;
+            y[i] = pred;
+        }
+    }
+    for (i = 0; i < f->values; i++) {
+        if (y[i] < 0)
+            y[i] = 0;
+        else if (y[i] >= range)
+            y[i] = range - 1;
+    }
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static inline int32_t VbFloorMul(int32_t v, int32_t f) {     /* residue Q16 * floor Q31 = spectrum, saturated */
+    int64_t r = ((int64_t)v * f) >> (16 + 31 - VB_SPECBITS);
+
+    return (r > INT32_MAX) ? INT32_MAX : (r < -INT32_MAX) ? -INT32_MAX : (int32_t)r;
+}
+//----------------------------------------------------------------------------------------------------------------------
+static HELIX_IRAM void VbRenderLine(int x0, int y0, int x1, int y1, int32_t *v, int n) {
+    int dy = y1 - y0, adx = x1 - x0, ady = abs(dy), base = dy / adx, sy = (dy < 0) ? base - 1 : base + 1;
+    int x = x0, y = y0, err = 0;
+
+    ady -= abs(base) * adx;
+    if (x1 > n)
+        x1 = n;
+    if (x >= x1)
+        return;
+    v[x] = VbFloorMul(v[x], m_vbInvDB[y]);
+    for (x++; x < x1; x++) {
+        err += ady;
+        if (err >= adx) {
+            err -= adx;
+            y += sy;
+        }
+        else {
+            y += base;
+        }
+        v[x] = VbFloorMul(v[x], m_vbInvDB[y]);
+    }
+}
+/***********************************************************************************************************************
+ * Function:    VbFloorCurve
+ *
+ * Description: multiply the residue of a channel with its floor curve
+ *
+ * Inputs:      floor
+ *              channel, floorY and floorStep decoded
+ *              residue in Q16, n/2 values
+ *
+ * Outputs:     spectrum in Q28
+ *
+ * Return:      none
+ **********************************************************************************************************************/
+static void VbFloorCurve(const VbFloor1_t *f, int ch, int32_t *v, int n2) {
+    const int16_t *y = m_VorbisInfo->floorY[ch];
+    const uint8_t *step = m_VorbisInfo->floorStep[ch];
+    int            lx = 0, ly = y[0] * f->multiplier, i, j;
+
+    for (j = 1; j < f->values; j++) {
+        i = f->sorted[j];
+        if (step[i]) {
+            VbRenderLine(lx, ly, f->x[i], y[i] * f->multiplier, v, n2);
+            lx = f->x[i];
+            ly = y[i] * f->multiplier;
+        }
+    }
+    if (lx < n2)
+        VbRenderLine(lx, ly, n2, ly, v, n2);
+}
+/***********************************************************************************************************************
+ * R E S I D U E
+ **********************************************************************************************************************/
+static HELIX_IRAM int VbPartition(VbReader_t *br, const VbResidue_t *r, const VbCodebook_t *cb, int off,
+                                  int32_t **vec, int j, int nv) {
+    int32_t  val[VB_MAXDIMS];
+    int32_t *v = vec[j] + off;
+    int      dims = cb->dims, size = r->partSize, step, i, k, e;
+
+    if (r->type == 0) {                                 /* values interleaved over the partition */
+        step = size / dims;
+        for (i = 0; i < step; i++) {
+            if ((e = VbDecodeEntry(br, cb)) < 0)
+                return -1;
+            VbEntryValues(cb, e, val);
+            for (k = 0; k < dims; k++)
+                v[i + k * step] += val[k];
+        }
+    }
+    else if (r->type == 1 || nv == 1) {                 /* values in order */
+        for (i = 0; i < size; ) {
+            if ((e = VbDecodeEntry(br, cb)) < 0)
+                return -1;
+            VbEntryValues(cb, e, val);
+            for (k = 0; k < dims && i < size; k++)
+                v[i++] += val[k];
+        }
+    }
+    else {                                              /* type 2, values of both channels interleaved */
+        for (i = off; i < off + size; ) {
+            if ((e = VbDecodeEntry(br, cb)) < 0)
+                return -1;
+            VbEntryValues(cb, e, val);
+            for (k = 0; k < dims && i < off + size; k++, i++)
+                vec[i & 1][i >> 1] += val[k];
+        }
+    }
+    return 0;
+}
+/***********************************************************************************************************************
+ * Function:    VbResidueDecode
+ *
+ * Description: decode the residue vectors of the channels of a submap
+ *
+ * Inputs:      reader
+ *              residue configuration
+ *              number of vectors, the vectors (cleared) and their do-not-decode flags
+ *              n/2
+ *
+ * Outputs:     vectors in Q16
+ *
+ * Return:      none
+ *
+ * Notes:       at the end of the packet the rest of the residue is zero, this is not an error
+ **********************************************************************************************************************/
+static void VbResidueDecode(VbReader_t *br, const VbResidue_t *r, int nv, int32_t **vec, const bool *dnd, int n2) {
+    VorbisInfo_t       *vi = m_VorbisInfo;
+    const VbCodebook_t *cbc = &m_books[r->classBook];
+    int                 actual, begin, end, parts, cw, nc, pass, pc, i, j, temp, b;
+    bool                any = false;
+
+    actual = (r->type == 2) ? n2 * nv : n2;
+    begin = MIN((int)r->begin, actual);
+    end = MIN((int)r->end, actual);
+    parts = (end - begin) / r->partSize;
+    for (j = 0; j < nv; j++)
+        any |= !dnd[j];
+    if (parts <= 0 || !any)
+        return;
+    cw = cbc->dims;
+    nc = (r->type == 2) ? 1 : nv;                       /* type 2 is one vector */
+    for (pass = 0; pass < 8; pass++) {
+        for (pc = 0; pc < parts; ) {
+            if (pass == 0) {
+                for (j = 0; j < nc; j++) {
+                    if (r->type != 2 && dnd[j])
+                        continue;
+                    if ((temp = VbDecodeEntry(br, cbc)) < 0)
+                        return;
+                    for (i = cw - 1; i >= 0; i--) {
+                        vi->classes[j][pc + i] = temp % r->classifications;
+                        temp /= r->classifications;
+                    }
+                }
+            }
+            for (i = 0; i < cw && pc < parts; i++, pc++) {
+                for (j = 0; j < nc; j++) {
+                    if (r->type != 2 && dnd[j])
+                        continue;
+                    b = r->books[vi->classes[j][pc]][pass];
+                    if (b >= 0 && VbPartition(br, r, &m_books[b], begin + pc * r->partSize, vec, j, nv) < 0)
+                        return;
+                }
+            }
+        }
+    }
+}
+/***********************************************************************************************************************
+ * I M D C T
+ **********************************************************************************************************************/
+static inline void VbTwiddle(int idx, int32_t *c, int32_t *s) {
+    *c = m_vbTwiddle[idx * 2];
+    *s = m_vbTwiddle[idx * 2 + 1];
+}
+/***********************************************************************************************************************
+ * Function:    VbDCT4
+ *
+ * Description: DCT-IV in place, z[k] = sum(x[j] * cos(pi / M * (j + 1/2) * (k + 1/2)))
+ *
+ * Inputs:      M values, sum of the absolute values below 2^31
+ *              M, 32 .. 1024
+ *
+ * Outputs:     M values, same format
+ *
+ * Return:      none
+ *
+ * Notes:       pre-twiddle with exp(-i*pi*(4n+1)/(4M)), complex FFT of M/2 points, post-twiddle with
+ *                exp(-i*pi*n/M), all in place
+ **********************************************************************************************************************/
+static HELIX_IRAM void VbDCT4(int32_t *x, int M) {
+    const int32_t *edge;
+    int      K = M >> 1, stride = VB_TWSIZE / M, n, m, i, j, k, size, half, tstep, t, bit;
+    int32_t  c, s, ec, es, ac, as, r0, i0, r1, i1, tr, ti;
+
+    for (edge = m_vbEdge, n = 32; n < M; n <<= 1)
+        edge += 2;
+    ec = edge[0];
+    es = edge[1];
+    for (n = 0; n < K / 2; n++) {                       /* pre-twiddle, pairs n and K-1-n */
+        m = K - 1 - n;
+        r0 = x[2 * n];
+        i0 = x[2 * m + 1];
+        r1 = x[2 * m];
+        i1 = x[2 * n + 1];
+        VbTwiddle(n * stride, &c, &s);
+        ac = VbMul31(c, ec) - VbMul31(s, es);
+        as = VbMul31(s, ec) + VbMul31(c, es);
+        x[2 * n]     = VbMul31(r0, ac) + VbMul31(i0, as);
+        x[2 * n + 1] = VbMul31(i0, ac) - VbMul31(r0, as);
+        VbTwiddle(m * stride, &c, &s);
+        ac = VbMul31(c, ec) - VbMul31(s, es);
+        as = VbMul31(s, ec) + VbMul31(c, es);
+        x[2 * m]     = VbMul31(r1, ac) + VbMul31(i1, as);
+        x[2 * m + 1] = VbMul31(i1, ac) - VbMul31(r1, as);
+    }
+    for (i = 0, j = 0; i < K; i++) {                    /* bit reversal */
+        if (i < j) {
+            tr = x[2 * i];
+            ti = x[2 * i + 1];
+            x[2 * i] = x[2 * j];
+            x[2 * i + 1] = x[2 * j + 1];
+            x[2 * j] = tr;
+            x[2 * j + 1] = ti;
+        }
+        for (bit = K >> 1; j & bit; bit >>= 1)
+            j ^= bit;
+        j |= bit;
+    }
+    for (size = 2; size <= K; size <<= 1) {             /* radix 2 butterflies */
+        half = size >> 1;
+        tstep = K / size;
+        for (j = 0; j < half; j++) {
+            t = j * tstep;                              /* exp(-2*pi*i*t/K) */
+            if (t < K / 4) {
+                VbTwiddle(4 * t * stride, &c, &s);
+            }
+            else {
+                VbTwiddle(4 * (t - K / 4) * stride, &s, &c);
+                c = -c;
+            }
+            for (k = j; k < K; k += size) {
+                r1 = x[2 * (k + half)];
+                i1 = x[2 * (k + half) + 1];
+                tr = VbMul31(r1, c) + VbMul31(i1, s);
+                ti = VbMul31(i1, c) - VbMul31(r1, s);
+                r0 = x[2 * k];
+                i0 = x[2 * k + 1];
+                x[2 * k] = r0 + tr;
+                x[2 * k + 1] = i0 + ti;
+                x[2 * (k + half)] = r0 - tr;
+                x[2 * (k + half) + 1] = i0 - ti;
+            }
+        }
+    }
+    for (n = 0; n < K / 2; n++) {                       /* post-twiddle and reorder, pairs n and K-1-n */
+        m = K - 1 - n;
+        VbTwiddle(n * stride, &c, &s);
+        r0 = VbMul31(x[2 * n], c) + VbMul31(x[2 * n + 1], s);
+        i0 = VbMul31(x[2 * n + 1], c) - VbMul31(x[2 * n], s);
+        VbTwiddle(m * stride, &c, &s);
+        r1 = VbMul31(x[2 * m], c) + VbMul31(x[2 * m + 1], s);
+        i1 = VbMul31(x[2 * m + 1], c) - VbMul31(x[2 * m], s);
+        x[2 * n] = r0;
+        x[2 * n + 1] = -i1;
+        x[2 * m] = r1;
+        x[2 * m + 1] = -i0;
+    }
+}
+/***********************************************************************************************************************
+ * Function:    VbIMDCT
+ *
+ * Description: scale the spectrum, transform it and scale the result to Q20
+ *
+ * Inputs:      M values in Q28
+ *              M
+ *
+ * Outputs:     M values of the DCT-IV in Q20, see VbLeft() and VbRight() for the IMDCT output
+ *
+ * Return:      none
+ *
+ * Notes:       no value in the FFT can be larger than the sum of the absolute input values, the input is shifted
+ *                so that this sum fits in 30 bits (at most 2 bits up)
+ **********************************************************************************************************************/
+static HELIX_IRAM void VbIMDCT(int32_t *x, int M) {
+    int64_t sum = 0, v;
+    int     sh = -2, i;
+
+    for (i = 0; i < M; i++)
+        sum += abs(x[i]);
+    while (sh < 0 && (sum << -sh) >= (1LL << 30))
+        sh++;
+    while ((sum >> (sh > 0 ? sh : 0)) >= (1LL << 30))
+        sh++;
+    if (sh < 0) {
+        for (i = 0; i < M; i++)
+            x[i] *= 1 << -sh;
+    }
+    else if (sh > 0) {
+        for (i = 0; i < M; i++)
+            x[i] = (int32_t)(((int64_t)x[i] + (1 << (sh - 1))) >> sh);
+    }
+    VbDCT4(x, M);
+    sh = VB_SPECBITS - VORBIS_QBITS - sh;               /* bits to drop for Q20 */
+    for (i = 0; i < M; i++) {
+        v = (sh > 0) ? ((int64_t)x[i] + (1 << (sh - 1))) >> sh : (int64_t)x[i] * (1LL << -sh);
+        x[i] = (v > INT32_MAX) ? INT32_MAX : (v < -INT32_MAX) ? -INT32_MAX : (int32_t)v;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+static inline int32_t VbLeft(const int32_t *z, int M, int i) {     /* IMDCT output i, i < M */
+    return (i < M / 2) ? z[M / 2 + i] : -z[3 * M / 2 - 1 - i];
+}
+//----------------------------------------------------------------------------------------------------------------------
+static inline int32_t VbRight(const int32_t *z, int M, int j) {    /* IMDCT output M + j, j < M */
+    return (j < M / 2) ? -z[M / 2 - 1 - j] : -z[j - M / 2];
+}
+//----------------------------------------------------------------------------------------------------------------------
+static inline short VbClip(int64_t v) {                 /* Q20 to 16 bits */
+    v = (v + (1 << (VORBIS_QBITS - 16))) >> (VORBIS_QBITS - 15);
+    if (v > 32767)
+        return 32767;
+    if (v < -32768)
+        return -32768;
+    return (short)v;
+}
+/***********************************************************************************************************************
+ * Function:    VbOverlapAdd
+ *
+ * Description: window the IMDCT output of a channel, add the overlap of the previous block and save the new overlap
+ *
+ * Inputs:      channel, DCT-IV output in spec
+ *              number of channels
+ *              size of current and previous block, previous is not 0
+ *
+ * Outputs:     prevN/4 + n/4 samples per channel, interleaved
+ *              new overlap
+ *
+ * Return:      none
+ *
+ * Notes:       the window follows from the sizes of the blocks, the flags in the packet are not needed
+ **********************************************************************************************************************/
+static HELIX_IRAM void VbOverlapAdd(int ch, int nch, int n, int pn, short *out) {
+    VorbisInfo_t  *vi = m_VorbisInfo;
+    const int32_t *z = vi->u.pcm.spec[ch];
+    int32_t       *ov = vi->u.pcm.overlap[ch];
+    const int32_t *w;
+    int            M = n / 2, L, a, ls, i, k;
+
+    if (pn == vi->blockSize[1] && n == vi->blockSize[1]) {
+        L = vi->blockSize[1] / 2;
+        w = m_window[1];
+    }
+    else {
+        L = vi->blockSize[0] / 2;
+        w = m_window[0];
+    }
+    a = pn / 4 - L / 2;                                 /* previous block alone */
+    for (i = 0; i < a; i++, out += nch)
+        *out = VbClip(ov[i]);
+    ls = n / 4 - L / 2;                                 /* both blocks, windowed */
+    for (k = 0; k < L; k++, out += nch)
+        *out = VbClip((int64_t)VbMul31(ov[a + k], w[L - 1 - k]) + VbMul31(VbLeft(z, M, ls + k), w[k]));
+    for (i = n / 4 + L / 2; i < M; i++, out += nch)     /* current block alone */
+        *out = VbClip(VbLeft(z, M, i));
+}
+/***********************************************************************************************************************
+ * Function:    VbAudio
+ *
+ * Description: decode an audio packet
+ *
+ * Inputs:      packet
+ *
+ * Outputs:     PCM samples, outSamps set
+ *
+ * Return:      0 or error code
+ **********************************************************************************************************************/
+static int VbAudio(const uint8_t *pkt, int len, short *outbuf) {
+    VorbisInfo_t      *vi = m_VorbisInfo;
+    VbReader_t         br;
+    const VbMode_t    *mode;
+    const VbMapping_t *map;
+    int32_t           *vec[VORBIS_MAXCHANS], *mag, *ang, m, a;
+    bool               noResidue[VORBIS_MAXCHANS], dnd[VORBIS_MAXCHANS];
+    int                modeNum, n, n2, ch, s, nv, i, j, k;
+
+    HELIX_PROF_T(t);
+    VbReaderInit(&br, pkt, len);
+    VbRead(&br, 1);                                     /* packet type, 0 for audio */
+    modeNum = VbRead(&br, VbIlog(m_nModes - 1));
+    if (br.eop || modeNum >= m_nModes)
+        return ERR_VORBIS_INVALID_PACKET;
+    mode = &m_modes[modeNum];
+    map = &m_mappings[mode->mapping];
+    n = vi->blockSize[mode->blockFlag];
+    n2 = n / 2;
+    if (mode->blockFlag)
+        VbRead(&br, 2);                                 /* window flags, the sizes of the blocks are known */
+    for (ch = 0; ch < vi->channels; ch++) {
+        vi->floorUsed[ch] = VbFloorDecode(&br, &m_floors[map->floor[map->mux[ch]]], ch);
+        noResidue[ch] = !vi->floorUsed[ch];
+    }
+    HELIX_PROF_ADD(m_prof[VORBIS_PROF_FLOOR], t);
+    for (i = 0; i < map->couplingSteps; i++) {          /* coupled channels are both decoded or both not */
+        if (!noResidue[map->coupling[i * 2]] || !noResidue[map->coupling[i * 2 + 1]])
+            noResidue[map->coupling[i * 2]] = noResidue[map->coupling[i * 2 + 1]] = false;
+    }
+    for (ch = 0; ch < vi->channels; ch++)
+        memset(vi->u.pcm.spec[ch], 0, n2 * sizeof(int32_t));
+    for (s = 0; s < map->submaps; s++) {
+        nv = 0;
+        for (ch = 0; ch < vi->channels; ch++) {
+            if (map->mux[ch] == s) {
+                vec[nv] = vi->u.pcm.spec[ch];
+                dnd[nv++] = noResidue[ch];
+            }
+        }
+        if (nv)
+            VbResidueDecode(&br, &m_residues[map->residue[s]], nv, vec, dnd, n2);
+    }
+    for (i = map->couplingSteps - 1; i >= 0; i--) {     /* inverse coupling, magnitude/angle to left/right */
+        mag = vi->u.pcm.spec[map->coupling[i * 2]];
+        ang = vi->u.pcm.spec[map->coupling[i * 2 + 1]];
+        for (j = 0; j < n2; j++) {
+            m = mag[j];
+            a = ang[j];
+            if (m > 0) {
+                if (a > 0) {
+                    ang[j] = m - a;
+                }
+                else {
+                    ang[j] = m;
+                    mag[j] = m + a;
+                }
+            }
+            else {
+                if (a > 0) {
+                    ang[j] = m + a;
+                }
+                else {
+                    ang[j] = m;
+                    mag[j] = m - a;
+                }
+            }
+        }
+    }
+    HELIX_PROF_ADD(m_prof[VORBIS_PROF_RESIDUE], t);
+    for (ch = 0; ch < vi->channels; ch++) {
+        if (vi->floorUsed[ch])
+            VbFloorCurve(&m_floors[map->floor[map->mux[ch]]], ch, vi->u.pcm.spec[ch], n2);
+        else
+            memset(vi->u.pcm.spec[ch], 0, n2 * sizeof(int32_t));
+    }
+    HELIX_PROF_ADD(m_prof[VORBIS_PROF_FLOOR], t);
+    for (ch = 0; ch < vi->channels; ch++) {
+        VbIMDCT(vi->u.pcm.spec[ch], n2);
+        if (vi->prevN)
+            VbOverlapAdd(ch, vi->channels, n, vi->prevN, outbuf + ch);
+        for (k = 0; k < n2; k++)                        /* right half is the overlap of the next block */
+            vi->u.pcm.overlap[ch][k] = VbRight(vi->u.pcm.spec[ch], n2, k);
+    }
+    vi->outSamps = vi->prevN ? vi->prevN / 4 + n / 4 : 0;
+    vi->prevN = n;
+    HELIX_PROF_ADD(m_prof[VORBIS_PROF_IMDCT], t);
+    return ERR_VORBIS_NONE;
+}
+/***********************************************************************************************************************
+ * Function:    VbTrimEnd
+ *
+ * Description: cut the last block of a stream at the granule position of the end-of-stream page
+ *
+ * Inputs:      outSamps of the packet just decoded
+ *
+ * Outputs:     outSamps without the samples after the end of the stream
+ *
+ * Return:      none
+ *
+ * Notes:       the encoder pads the last block, the granule position tells how much of it is real, see
+ *                section A.2 of the Vorbis I specification
+ *              the first packet that ends on a page starts at the granule position of the page before
+ **********************************************************************************************************************/
+static void VbTrimEnd(void) {
+    VorbisInfo_t *vi = m_VorbisInfo;
+    OggDemux_t   *d = &vi->ogg;
+
+    if (d->pktGranule != vi->granule) {                 /* first packet that ends on this page */
+        vi->pos = vi->granule;
+        vi->granule = d->pktGranule;
+    }
+    vi->pos += vi->outSamps;
+    if (d->pktEos && vi->pos > d->pktGranule) {         /* padding after the end of the stream */
+        vi->outSamps -= (int)MIN(vi->pos - d->pktGranule, (int64_t)vi->outSamps);
+        vi->pos = d->pktGranule;
+    }
+}
+/***********************************************************************************************************************
+ * Function:    VbPacket
+ *
+ * Description: handle a complete packet from the Ogg demultiplexer
+ *
+ * Inputs:      packet in the packet buffer of the demultiplexer
+ *
+ * Outputs:     PCM samples, outSamps set if there are any
+ *
+ * Return:      0 or error code
+ *
+ * Notes:       a new Vorbis stream (chained Ogg, next track on internet radio) starts with its identification
+ *                header on a beginning-of-stream page, the decoder starts all over then
+ **********************************************************************************************************************/
+static int VbPacket(short *outbuf) {
+    VorbisInfo_t  *vi = m_VorbisInfo;
+    OggDemux_t    *d = &vi->ogg;
+    const uint8_t *pkt = d->pkt;
+    int            len = d->pktLen, err;
+
+    vi->outSamps = 0;
+    if (d->pktBos) {
+        if (!VbIsHeader(pkt, len, 1))
+            return ERR_VORBIS_NONE;                     /* other codec, not followed */
+        OggDemux_Follow(d, d->pktSerial);
+        OggDemux_SetBuffer(d, vi->packet, VORBIS_MAXPACKET);
+        vi->headers = 0;
+        vi->prevN = 0;
+        vi->granule = vi->pos = 0;                      /* the header pages have granule position 0 */
+        vi->skip = false;
+        if ((err = VbParseIdent(pkt, len)) != 0) {
+            vi->skip = true;
+            return err;
+        }
+        vi->headers = 1;
+        return ERR_VORBIS_NONE;
+    }
+    if (vi->skip || len == 0)
+        return ERR_VORBIS_NONE;
+    switch (vi->headers) {
+    case 0:                                             /* joined in the middle of a stream */
+        return ERR_VORBIS_NONE;
+    case 1:
+        if (!VbIsHeader(pkt, len, 3)) {
+            vi->skip = true;
+            return ERR_VORBIS_INVALID_HEADER;
+        }
+        vi->headers = 2;                                /* comments are not used, setup header is next */
+        OggDemux_SetBuffer(d, vi->u.setup, VORBIS_MAXSETUP);
+        return ERR_VORBIS_NONE;
+    case 2:
+        OggDemux_SetBuffer(d, vi->packet, VORBIS_MAXPACKET);
+        if (!VbIsHeader(pkt, len, 5)) {
+            vi->skip = true;
+            return ERR_VORBIS_INVALID_HEADER;
+        }
+        err = d->pktTrunc ? ERR_VORBIS_UNSUPPORTED : VbSetup(pkt, len);
+        if (err) {
+            log_e("Vorbis: setup header error %d", err);
+            vi->skip = true;
+            return err;
+        }
+        vi->headers = 3;
+        vi->prevN = 0;
+        return ERR_VORBIS_NONE;
+    default:
+        if (pkt[0] & 1)                                 /* header packet, ignored */
+            return ERR_VORBIS_NONE;
+        if ((err = VbAudio(pkt, len, outbuf)) == ERR_VORBIS_NONE)
+            VbTrimEnd();
+        return err;
+    }
+}
+/***********************************************************************************************************************
+ * Function:    VorbisDecoder_AllocateBuffers
+ *
+ * Description: allocate the buffers of the Vorbis decoder
+ *
+ * Inputs:      none
+ *
+ * Outputs:     none
+ *
+ * Return:      false if not enough memory, otherwise true
+ *
+ * Notes:       the buffers are taken from the codec arena if it is free, otherwise from the heap
+ *              the setup pool is allocated when the setup header of a stream arrives
+ **********************************************************************************************************************/
+bool VorbisDecoder_AllocateBuffers(void) {
+    if (!m_VorbisInfo && CodecArena_Claim(m_vorbis)) {
+        m_VorbisInfo = (VorbisInfo_t*)CodecArena_Alloc(m_vorbis, sizeof(VorbisInfo_t), "VorbisInfo");
+        if (!m_VorbisInfo)
+            CodecArena_Release(m_vorbis);               /* budget too small (should not happen), use the heap */
+    }
+    if (!m_VorbisInfo)
+        m_VorbisInfo = (VorbisInfo_t*)malloc(sizeof(VorbisInfo_t));
+    if (!m_VorbisInfo && psramFound()) {
+        m_VorbisInfo = (VorbisInfo_t*)ps_malloc(sizeof(VorbisInfo_t));
+        if (m_VorbisInfo)
+            log_i("Vorbis buffers allocated in PSRAM");
+    }
+    if (!m_VorbisInfo) {
+        log_e("not enough memory to allocate vorbis decoder buffers");
+        return false;
+    }
+    VbFreeSetup();                                      /* setup of a previous stream */
+    memset(m_VorbisInfo, 0, sizeof(VorbisInfo_t));
+    OggDemux_Init(&m_VorbisInfo->ogg);
+    OggDemux_SetBuffer(&m_VorbisInfo->ogg, m_VorbisInfo->packet, VORBIS_MAXPACKET);
+    return true;
+}
+/***********************************************************************************************************************
+ * Function:    VorbisDecoder_FreeBuffers
+ *
+ * Description: free the buffers and the setup pool of the Vorbis decoder
+ *
+ * Inputs:      none
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ **********************************************************************************************************************/
+void VorbisDecoder_FreeBuffers(void) {
+    VbFreeSetup();
+    if (CodecArena_IsOwner(m_vorbis)) {
+        m_VorbisInfo = NULL;                            /* buffers are in the codec arena, just give it back */
+        CodecArena_Release(m_vorbis);
+        return;
+    }
+    if (m_VorbisInfo) {
+        free(m_VorbisInfo);
+        m_VorbisInfo = NULL;
+    }
+}
+/***********************************************************************************************************************
+ * Function:    VorbisDecode
+ *
+ * Description: take the next part of an Ogg Vorbis stream and decode the packets in it
+ *
+ * Inputs:      Ogg stream data and number of bytes
+ *
+ * Outputs:     number of bytes not used
+ *              PCM samples (VorbisGetOutputSamps), interleaved if stereo
+ *
+ * Return:      ERR_VORBIS_NONE after a packet that produced samples, call again with the rest of the data
+ *              ERR_VORBIS_INDATA_UNDERFLOW if all data is used without new samples
+ *              other error codes for a bad header or packet, call again with the rest of the data
+ *
+ * Notes:       the data may be cut anywhere, pages and packets are collected over the calls
+ **********************************************************************************************************************/
+int VorbisDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf) {
+    VorbisInfo_t *vi = m_VorbisInfo;
+    int           used, res, err;
+
+    if (!vi)
+        return ERR_VORBIS_NULL_POINTER;
+    for (;;) {
+        HELIX_PROF_T(t);
+        res = OggDemux_Feed(&vi->ogg, inbuf, *bytesLeft, &used);
+        inbuf += used;
+        *bytesLeft -= used;
+        HELIX_PROF_ADD(m_prof[VORBIS_PROF_OGG], t);
+        if (res == OGG_NEED_DATA)
+            return ERR_VORBIS_INDATA_UNDERFLOW;
+        if ((err = VbPacket(outbuf)) != ERR_VORBIS_NONE)
+            return err;
+        if (vi->outSamps)
+            return ERR_VORBIS_NONE;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+int VorbisGetSampRate() {return m_VorbisInfo->sampRate;}
+int VorbisGetChannels() {return m_VorbisInfo->channels;}
+int VorbisGetBitsPerSample() {return 16;}
+int VorbisGetOutputSamps() {return m_VorbisInfo->outSamps * m_VorbisInfo->channels;}
+int VorbisGetBitrate() {
+    if (m_VorbisInfo->bitrateNom > 0)
+        return m_VorbisInfo->bitrateNom;
+    if (m_VorbisInfo->bitrateMax > 0)
+        return m_VorbisInfo->bitrateMax;
+    return (m_VorbisInfo->bitrateMin > 0) ? m_VorbisInfo->bitrateMin : 0;
+}
+/***********************************************************************************************************************
+ * Function:    VorbisGetProfile
+ *
+ * Description: get the number of cycles used by a stage of the decoder since the last VorbisResetProfile()
+ *
+ * Inputs:      stage, VORBIS_PROF_OGG .. VORBIS_PROF_IMDCT
+ *
+ * Outputs:     none
+ *
+ * Return:      number of cycles, always 0 without HELIX_PROFILE
+ **********************************************************************************************************************/
+uint64_t VorbisGetProfile(int stage) {return (stage >= 0 && stage < VORBIS_PROF_STAGES) ? m_prof[stage] : 0;}
+void VorbisResetProfile() {memset(m_prof, 0, sizeof(m_prof));}
+/***********************************************************************************************************************
+ * Function:    VorbisReport
+ *
+ * Description: print the stream parameters and the Ogg statistics, for the "test" command
+ *
+ * Inputs:      none
+ *
+ * Outputs:     lines on the serial log
+ *
+ * Return:      none
+ **********************************************************************************************************************/
+void VorbisReport() {
+    VorbisInfo_t *vi = m_VorbisInfo;
+
+    if (!vi)
+        return;
+    log_printf("Vorbis: blocks %d/%d, setup %d bytes, %d pages, %d CRC errors, %d packets lost\n",
+               vi->blockSize[0], vi->blockSize[1], (int)m_poolSize,
+               vi->ogg.pages, vi->ogg.crcErrors, vi->ogg.lostPackets);
+}
+/***********************************************************************************************************************
+ * Function:    VorbisDecoder_AllocateBuffers, VorbisDecoder_FreeBuffers, VorbisDecode, VorbisGet...
+ *
+ * Description: same as the functions without context, but for the decoder instance ctx instead of the default one
+ *
+ * Inputs:      pointer to decoder instance, zero-initialized before first use
+ *              other inputs as in the functions without context
+ *
+ * Notes:       the previous instance is restored on return, so these may be mixed freely with the calls
+ *                without context in the same task
+ **********************************************************************************************************************/
+bool VorbisDecoder_AllocateBuffers(VorbisDecoder_t *ctx) {
+    VorbisDecoder_t *prev = m_vorbis;
+    bool res;
+
+    m_vorbis = ctx;
+    res = VorbisDecoder_AllocateBuffers();
+    m_vorbis = prev;
+    return res;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void VorbisDecoder_FreeBuffers(VorbisDecoder_t *ctx) {
+    VorbisDecoder_t *prev = m_vorbis;
+
+    m_vorbis = ctx;
+    VorbisDecoder_FreeBuffers();
+    m_vorbis = prev;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int VorbisDecode(VorbisDecoder_t *ctx, uint8_t *inbuf, int *bytesLeft, short *outbuf) {
+    VorbisDecoder_t *prev = m_vorbis;
+    int err;
+
+    m_vorbis = ctx;
+    err = VorbisDecode(inbuf, bytesLeft, outbuf);
+    m_vorbis = prev;
+    return err;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int VorbisGetSampRate(VorbisDecoder_t *ctx) {return ctx->VorbisInfo->sampRate;}
+int VorbisGetChannels(VorbisDecoder_t *ctx) {return ctx->VorbisInfo->channels;}
+int VorbisGetOutputSamps(VorbisDecoder_t *ctx) {return ctx->VorbisInfo->outSamps * ctx->VorbisInfo->channels;}
+int VorbisGetBitrate(VorbisDecoder_t *ctx) {
+    VorbisDecoder_t *prev = m_vorbis;
+    int br;
+
+    m_vorbis = ctx;
+    br = VorbisGetBitrate();
+    m_vorbis = prev;
+    return br;
+}
@@ -0,0 +1,158 @@
+// vorbis_decoder.h
+// Integer Ogg Vorbis decoder for the helix builds, see the Vorbis I specification.
+// Floor type 1 and residue types 0, 1 and 2 are supported, for 1 or 2 channels and block sizes up
+// to 2048.  This covers the streams of libvorbis and aoTuV, floor type 0 is not used by any
+// encoder since 2000 and is rejected.
+// The decoder takes the Ogg stream in pieces of any size.  The state and the buffers of one packet
+// are in the codec arena.  The codebooks, floors and residues of the setup header are in one heap
+// block of the exact size, measured in a first pass over the setup header.
+#pragma once
+
+#include "Arduino.h"
+#include "codec_arena.h"
+#include "helix_placement.h"
+#include "ogg_demux.h"
+
+#define VORBIS_MAXCHANS     2                           // Max. number of channels
+#define VORBIS_MAXBLOCK     2048                        // Max. block size
+#define VORBIS_MAXPOSTS     65                          // Max. number of floor 1 points (spec limit)
+#define VORBIS_MAXPARTS     512                         // Max. number of residue partitions
+#define VORBIS_MAXPACKET    4096                        // Max. audio packet size (512 kbps)
+#define VORBIS_MAXSETUP     16384                       // Max. size of the setup header
+#define VORBIS_QBITS        20                          // Fraction bits of spectrum and PCM before rounding
+
+enum {
+    ERR_VORBIS_NONE                       =   0,
+    ERR_VORBIS_INDATA_UNDERFLOW           =  -1,        /* all input used, no new PCM */
+    ERR_VORBIS_NULL_POINTER               =  -2,
+    ERR_VORBIS_OUT_OF_MEMORY              =  -3,        /* no room for the setup */
+    ERR_VORBIS_INVALID_HEADER             =  -4,
+    ERR_VORBIS_INVALID_SETUP              =  -5,
+    ERR_VORBIS_UNSUPPORTED                =  -6,        /* stream is skipped until the next one starts */
+    ERR_VORBIS_INVALID_PACKET             =  -7
+};
+
+enum {                  /* decoder stages for HELIX_PROFILE */
+    VORBIS_PROF_OGG                       =   0,        /* Ogg pages, headers */
+    VORBIS_PROF_FLOOR                     =   1,        /* floor decode and curve */
+    VORBIS_PROF_RESIDUE                   =   2,        /* residue decode, inverse coupling */
+    VORBIS_PROF_IMDCT                     =   3,        /* inverse transform, overlap-add */
+    VORBIS_PROF_STAGES                    =   4
+};
+
+typedef struct _VbCodebook_t {
+    uint16_t *tree;             /* 2 children per node, VB_LEAF | entry for a leaf, VB_NONE for an unused code */
+    int32_t  *values;           /* lookup 1: the values of one dimension, lookup 2: all values, Q16 */
+    int32_t   entries;
+    uint16_t  dims;
+    uint16_t  lookupValues;     /* lookup 1: number of values per dimension */
+    uint8_t   lookup;           /* lookup type 0, 1 or 2 */
+    uint8_t   sequenceP;        /* values are cumulative */
+} VbCodebook_t;
+
+typedef struct _VbFloor1_t {
+    uint8_t   partitions;
+    uint8_t   partClass[32];
+    uint8_t   classDims[16];
+    uint8_t   classSubs[16];
+    int16_t   classMaster[16];
+    int16_t   subBooks[16][8];
+    uint8_t   multiplier;
+    uint8_t   values;           /* number of points, including the 2 end points */
+    uint16_t  x[VORBIS_MAXPOSTS];
+    uint8_t   sorted[VORBIS_MAXPOSTS];  /* point numbers in order of x */
+    uint8_t   low[VORBIS_MAXPOSTS];     /* low and high neighbour of every point */
+    uint8_t   high[VORBIS_MAXPOSTS];
+} VbFloor1_t;
+
+typedef struct _VbResidue_t {
+    uint8_t   type;
+    uint8_t   classifications;
+    uint8_t   classBook;
+    int32_t   begin;
+    int32_t   end;
+    int32_t   partSize;
+    int16_t (*books)[8];        /* book per classification and pass, -1 if none */
+} VbResidue_t;
+
+typedef struct _VbMapping_t {
+    uint8_t   submaps;
+    uint16_t  couplingSteps;
+    uint8_t  *coupling;         /* magnitude and angle channel of every step */
+    uint8_t   mux[VORBIS_MAXCHANS];
+    uint8_t   floor[16];
+    uint8_t   residue[16];
+} VbMapping_t;
+
+typedef struct _VbMode_t {
+    uint8_t   blockFlag;
+    uint8_t   mapping;
+} VbMode_t;
+
+typedef struct _VorbisInfo_t {
+    OggDemux_t ogg;
+    int       channels;
+    int       sampRate;
+    int       bitrateMax;
+    int       bitrateNom;
+    int       bitrateMin;
+    int       blockSize[2];
+    int       headers;          /* header packets received, audio follows after 3 */
+    bool      skip;             /* stream not supported, wait for the next one */
+    int       prevN;            /* size of the previous block, 0 at the start of a stream */
+    int       outSamps;         /* samples per channel of the last packet */
+    int64_t   granule;          /* granule position of the page of the last audio packet */
+    int64_t   pos;              /* samples per channel decoded up to the end of the last packet */
+    bool      floorUsed[VORBIS_MAXCHANS];
+    int16_t   floorY[VORBIS_MAXCHANS][VORBIS_MAXPOSTS];
+    uint8_t   floorStep[VORBIS_MAXCHANS][VORBIS_MAXPOSTS];
+    uint8_t   classes[VORBIS_MAXCHANS][VORBIS_MAXPARTS];
+    uint8_t   packet[VORBIS_MAXPACKET] __attribute__((aligned(8)));   /* also scratch for the setup parser */
+    union {                     /* the setup header is only needed before the first audio packet */
+        struct {
+            int32_t spec[VORBIS_MAXCHANS][VORBIS_MAXBLOCK / 2];     /* spectrum, then IMDCT output */
+            int32_t overlap[VORBIS_MAXCHANS][VORBIS_MAXBLOCK / 2];  /* right half of previous block */
+        } pcm;
+        uint8_t setup[VORBIS_MAXSETUP];
+    } u;
+} VorbisInfo_t;
+
+typedef struct _VorbisDecoder_t {
+    VorbisInfo_t  *VorbisInfo;
+    uint8_t       *pool;        /* codebooks, floors, residues, mappings, modes and windows */
+    size_t         poolSize;
+    VbCodebook_t  *books;
+    VbFloor1_t    *floors;
+    VbResidue_t   *residues;
+    VbMapping_t   *mappings;
+    VbMode_t      *modes;
+    int32_t       *window[2];   /* rising slope for the short and long overlap, Q31 */
+    int            nBooks;
+    int            nFloors;
+    int            nResidues;
+    int            nMappings;
+    int            nModes;
+} VorbisDecoder_t;
+
+/* compile-time budget of the buffers in the codec arena, see VorbisDecoder_AllocateBuffers() */
+static const uint32_t VORBIS_ARENA_BUDGET = CODEC_ARENA_ROUND(sizeof(VorbisInfo_t));
+
+bool VorbisDecoder_AllocateBuffers(void);
+void VorbisDecoder_FreeBuffers(void);
+int VorbisDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf);
+int VorbisGetSampRate();
+int VorbisGetChannels();
+int VorbisGetBitsPerSample();
+int VorbisGetBitrate();
+int VorbisGetOutputSamps();
+uint64_t VorbisGetProfile(int stage);
+void VorbisResetProfile();
+void VorbisReport();
+// same functions for a specific decoder instance (zero-initialized VorbisDecoder_t), functions above use a default one
+bool VorbisDecoder_AllocateBuffers(VorbisDecoder_t *ctx);
+void VorbisDecoder_FreeBuffers(VorbisDecoder_t *ctx);
+int VorbisDecode(VorbisDecoder_t *ctx, uint8_t *inbuf, int *bytesLeft, short *outbuf);
+int VorbisGetSampRate(VorbisDecoder_t *ctx);
+int VorbisGetChannels(VorbisDecoder_t *ctx);
+int VorbisGetOutputSamps(VorbisDecoder_t *ctx);
+int VorbisGetBitrate(VorbisDecoder_t *ctx);
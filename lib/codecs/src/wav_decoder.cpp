@@ -0,0 +1,371 @@
+/*
+ * wav_decoder.cpp
+ * RIFF/WAVE reader.
+ *
+ * A WAVE file is "RIFF", the size of the rest and "WAVE", followed by chunks of an 8 byte header (4 character
+ * id and size, little endian) and the data, plus a pad byte if the size is odd.  The "fmt " chunk describes the
+ * samples, the "data" chunk holds them.  Tags (LIST), "fact" and other chunks may come before and after these,
+ * they are skipped by their size, so the file is never searched or read twice.
+ * The input is parsed as it arrives, in pieces of any size.  Only whole sample frames are taken from the data
+ * chunk, a partial frame at the end of the input is left for the next call.
+ * Streams and unfinished recordings often have a size of 0 or 0xFFFFFFFF in the "data" chunk, then the samples
+ * go on until the end of the file.  RF64 files have these sizes in a "ds64" chunk, they are played the same way.
+ */
+#include "wav_decoder.h"
+
+#ifndef MIN
+  #define MIN(a,b)      ((a) < (b) ? (a) : (b))
+#endif
+
+#define WV_UNKNOWN      0xFFFFFFFF                      /* size of the data chunk is not known */
+#define WV_FMT_PCM      0x0001                          /* format tags in the fmt chunk */
+#define WV_FMT_EXT      0xFFFE                          /* WAVE_FORMAT_EXTENSIBLE, sub format follows */
+
+enum {                                                  /* states of the parser */
+    WV_S_RIFF =         0,                              /* receiving the 12 byte RIFF header */
+    WV_S_CHUNK =        1,                              /* receiving a chunk header */
+    WV_S_FMT =          2,                              /* receiving the fmt chunk */
+    WV_S_SKIP =         3,                              /* skipping an unknown chunk */
+    WV_S_DATA =         4,                              /* copying samples */
+    WV_S_END =          5                               /* after the data or a bad header, ignore the rest */
+};
+
+/* All decoder state lives in a WavDecoder_t.  The decoder always works on the instance m_wav points to,
+ * which is the default instance unless one of the functions with a context argument is running.
+ */
+WavDecoder_t          m_WavDecoder;
+thread_local WavDecoder_t *m_wav = &m_WavDecoder;
+#define m_WavInfo              (m_wav->WavInfo)
+
+//----------------------------------------------------------------------------------------------------------------------
+static inline uint32_t WvLe16(const uint8_t *p) {return p[0] | (p[1] << 8);}
+static inline uint32_t WvLe32(const uint8_t *p) {return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);}
+/***********************************************************************************************************************
+ * Function:    WvCollect
+ *
+ * Description: copy input bytes to the header buffer until it holds a given number of bytes
+ *
+ * Inputs:      input, number of input bytes, number of bytes wanted in the header buffer
+ *
+ * Outputs:     bytes in hdr[]
+ *
+ * Return:      number of input bytes used
+ **********************************************************************************************************************/
+static int WvCollect(const uint8_t *in, int len, int want) {
+    WavInfo_t *wi = m_WavInfo;
+    int        n = MIN(want - wi->fill, len);
+
+    memcpy(wi->hdr + wi->fill, in, n);
+    wi->fill += n;
+    return n;
+}
+/***********************************************************************************************************************
+ * Function:    WvFormat
+ *
+ * Description: check the fmt chunk and take the sample format from it
+ *
+ * Inputs:      fmt chunk in hdr[], fill bytes of it
+ *
+ * Outputs:     channels, sampRate, bps and blockAlign
+ *
+ * Return:      ERR_WAV_NONE or ERR_WAV_UNSUPPORTED
+ *
+ * Notes:       for WAVE_FORMAT_EXTENSIBLE the container size is used, of the samples the upper 16 bits are used
+ **********************************************************************************************************************/
+static int WvFormat() {
+    WavInfo_t *wi = m_WavInfo;
+    uint8_t   *f = wi->hdr;
+    uint32_t   tag;
+
+    if (wi->fill < 16)
+        return ERR_WAV_UNSUPPORTED;
+    tag = WvLe16(f);
+    if (tag == WV_FMT_EXT && wi->fill >= 26)
+        tag = WvLe16(f + 24);                           /* first 2 bytes of the sub format GUID */
+    wi->channels = WvLe16(f + 2);
+    wi->sampRate = WvLe32(f + 4);
+    wi->blockAlign = WvLe16(f + 12);
+    wi->bps = WvLe16(f + 14);
+    if (tag != WV_FMT_PCM || wi->channels < 1 || wi->channels > WAV_MAXCHANS || wi->sampRate <= 0 ||
+        (wi->bps != 8 && wi->bps != 16 && wi->bps != 24 && wi->bps != 32) ||
+        wi->blockAlign != wi->channels * wi->bps / 8) {
+        log_e("WAV format %04X, %d channels, %d bits not supported", tag, wi->channels, wi->bps);
+        return ERR_WAV_UNSUPPORTED;
+    }
+    wi->fmtSeen = true;
+    return ERR_WAV_NONE;
+}
+/***********************************************************************************************************************
+ * Function:    WvChunk
+ *
+ * Description: handle a complete chunk header
+ *
+ * Inputs:      chunk header in hdr[]
+ *
+ * Outputs:     next state, chunkLeft or dataLeft
+ *
+ * Return:      ERR_WAV_NONE or ERR_WAV_INVALID_HEADER for samples without a fmt chunk
+ **********************************************************************************************************************/
+static int WvChunk() {
+    WavInfo_t *wi = m_WavInfo;
+    uint32_t   size = WvLe32(wi->hdr + 4);
+
+    wi->fill = 0;
+    if (memcmp(wi->hdr, "data", 4) == 0) {
+        if (!wi->fmtSeen)
+            return ERR_WAV_INVALID_HEADER;
+        wi->dataLeft = size ? size : WV_UNKNOWN;
+        wi->state = WV_S_DATA;
+        return ERR_WAV_NONE;
+    }
+    wi->chunkLeft = (size == WV_UNKNOWN) ? size : size + (size & 1);
+    wi->state = memcmp(wi->hdr, "fmt ", 4) == 0 ? WV_S_FMT : WV_S_SKIP;
+    return ERR_WAV_NONE;
+}
+/***********************************************************************************************************************
+ * Function:    WvOutput
+ *
+ * Description: convert sample frames to 16 bits, interleaved
+ *
+ * Inputs:      input samples, number of sample frames
+ *
+ * Outputs:     samples in out[]
+ *
+ * Return:      none
+ *
+ * Notes:       16 bits are copied as they are, 8 bits are unsigned, of 24 and 32 bits the upper 16 bits are used
+ *                as in the FLAC decoder
+ **********************************************************************************************************************/
+static HELIX_IRAM void WvOutput(const uint8_t *in, short *out, int n) {
+    WavInfo_t *wi = m_WavInfo;
+    int        i, step = wi->bps / 8;
+
+    n *= wi->channels;
+    switch (wi->bps) {
+        case 16:
+            memcpy(out, in, n * 2);                     /* little endian, like the I2S output */
+            break;
+        case 8:
+            for (i = 0; i < n; i++)
+                out[i] = (short)((in[i] ^ 0x80) << 8);  /* unsigned to signed */
+            break;
+        default:                                        /* 24 and 32 bits, use the upper 16 bits */
+            in += step - 2;
+            for (i = 0; i < n; i++, in += step)
+                out[i] = (short)(in[0] | (in[1] << 8));
+            break;
+    }
+}
+/***********************************************************************************************************************
+ * Function:    WavDecoder_AllocateBuffers
+ *
+ * Description: allocate the state of the WAV reader and prepare it for a new file
+ *
+ * Inputs:      none
+ *
+ * Outputs:     none
+ *
+ * Return:      false if not enough memory, otherwise true
+ *
+ * Notes:       the state is taken from the codec arena if it is free, otherwise from the heap
+ *              may be called again for the next file, the state is then just cleared
+ **********************************************************************************************************************/
+bool WavDecoder_AllocateBuffers(void) {
+    if (!m_WavInfo && CodecArena_Claim(m_wav)) {
+        m_WavInfo = (WavInfo_t*)CodecArena_Alloc(m_wav, sizeof(WavInfo_t), "WavInfo");
+        if (!m_WavInfo)
+            CodecArena_Release(m_wav);                  /* budget too small (should not happen), use the heap */
+    }
+    if (!m_WavInfo)
+        m_WavInfo = (WavInfo_t*)malloc(sizeof(WavInfo_t));
+    if (!m_WavInfo && psramFound())
+        m_WavInfo = (WavInfo_t*)ps_malloc(sizeof(WavInfo_t));
+    if (!m_WavInfo) {
+        log_e("not enough memory to allocate wav buffers");
+        return false;
+    }
+    memset(m_WavInfo, 0, sizeof(WavInfo_t));
+    return true;
+}
+/***********************************************************************************************************************
+ * Function:    WavDecoder_FreeBuffers
+ *
+ * Description: free the state of the WAV reader
+ *
+ * Inputs:      none
+ *
+ * Outputs:     none
+ *
+ * Return:      none
+ **********************************************************************************************************************/
+void WavDecoder_FreeBuffers(void) {
+    if (CodecArena_IsOwner(m_wav)) {
+        m_WavInfo = NULL;                               /* state is in the codec arena, just give it back */
+        CodecArena_Release(m_wav);
+        return;
+    }
+    if (m_WavInfo) {
+        free(m_WavInfo);
+        m_WavInfo = NULL;
+    }
+}
+/***********************************************************************************************************************
+ * Function:    WavDecode
+ *
+ * Description: take the next part of a WAVE file, parse the header chunks and return the samples
+ *
+ * Inputs:      WAVE data and number of bytes
+ *
+ * Outputs:     number of bytes not used
+ *              PCM samples (WavGetOutputSamps), 16 bits, interleaved if stereo
+ *
+ * Return:      ERR_WAV_NONE if there are samples, call again with the rest of the data
+ *              ERR_WAV_INDATA_UNDERFLOW if the data is used without new samples, less than one sample frame
+ *                may be left over
+ *              ERR_WAV_INVALID_HEADER or ERR_WAV_UNSUPPORTED once, the rest of the file is ignored
+ *
+ * Notes:       at most WAV_MAXOUT samples per channel are returned per call
+ **********************************************************************************************************************/
+int WavDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf) {
+    WavInfo_t *wi = m_WavInfo;
+    int        n, res;
+
+    if (!wi)
+        return ERR_WAV_NULL_POINTER;
+    wi->outSamps = 0;
+    while (*bytesLeft > 0) {
+        n = 0;
+        res = ERR_WAV_NONE;
+        switch (wi->state) {
+            case WV_S_RIFF:
+                n = WvCollect(inbuf, *bytesLeft, 12);
+                if (wi->fill < 12)
+                    break;
+                if ((memcmp(wi->hdr, "RIFF", 4) && memcmp(wi->hdr, "RF64", 4)) || memcmp(wi->hdr + 8, "WAVE", 4))
+                    res = ERR_WAV_INVALID_HEADER;
+                wi->fill = 0;
+                wi->state = WV_S_CHUNK;
+                break;
+            case WV_S_CHUNK:
+                n = WvCollect(inbuf, *bytesLeft, 8);
+                if (wi->fill == 8)
+                    res = WvChunk();
+                break;
+            case WV_S_FMT:
+                n = MIN((uint32_t)*bytesLeft, wi->chunkLeft);
+                if (wi->fill < WAV_FMTSIZE)
+                    WvCollect(inbuf, n, WAV_FMTSIZE);
+                wi->chunkLeft -= n;
+                if (wi->chunkLeft == 0) {
+                    res = WvFormat();
+                    wi->fill = 0;
+                    wi->state = WV_S_CHUNK;
+                }
+                break;
+            case WV_S_SKIP:
+                n = MIN((uint32_t)*bytesLeft, wi->chunkLeft);
+                wi->chunkLeft -= n;
+                wi->skipped += n;
+                if (wi->chunkLeft == 0)
+                    wi->state = WV_S_CHUNK;
+                break;
+            case WV_S_DATA:
+                n = MIN((uint32_t)*bytesLeft, wi->dataLeft) / wi->blockAlign;
+                if (n == 0) {
+                    if (wi->dataLeft >= (uint32_t)wi->blockAlign)
+                        return ERR_WAV_INDATA_UNDERFLOW;    /* partial frame, wait for the rest */
+                    wi->state = WV_S_END;               /* data chunk shorter than one frame */
+                    break;
+                }
+                n = MIN(n, WAV_MAXOUT);
+                WvOutput(inbuf, outbuf, n);
+                wi->outSamps = n;
+                n *= wi->blockAlign;
+                if (wi->dataLeft != WV_UNKNOWN)
+                    wi->dataLeft -= n;
+                if (wi->dataLeft < (uint32_t)wi->blockAlign)
+                    wi->state = WV_S_END;               /* trailing chunks are not needed */
+                wi->bytes += n;
+                *bytesLeft -= n;
+                return ERR_WAV_NONE;
+            default:
+                n = *bytesLeft;
+                break;
+        }
+        inbuf += n;
+        *bytesLeft -= n;
+        if (res != ERR_WAV_NONE) {
+            wi->state = WV_S_END;
+            return res;
+        }
+    }
+    return ERR_WAV_INDATA_UNDERFLOW;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int WavGetSampRate() {return m_WavInfo->sampRate;}
+int WavGetChannels() {return m_WavInfo->channels;}
+int WavGetBitsPerSample() {return 16;}
+int WavGetOutputSamps() {return m_WavInfo->outSamps * m_WavInfo->channels;}
+int WavGetBitrate() {return m_WavInfo->sampRate * m_WavInfo->blockAlign * 8;}
+/***********************************************************************************************************************
+ * Function:    WavReport
+ *
+ * Description: print the format and the statistics of the file, for the "test" command
+ *
+ * Inputs:      none
+ *
+ * Outputs:     lines on the serial log
+ *
+ * Return:      none
+ **********************************************************************************************************************/
+void WavReport() {
+    WavInfo_t *wi = m_WavInfo;
+
+    if (!wi)
+        return;
+    log_printf("WAV: %d bits, %d bytes of samples played, %d bytes of other chunks skipped, input %d kB/s\n",
+               wi->bps, wi->bytes, wi->skipped, WavGetBitrate() / 8000);
+}
+/***********************************************************************************************************************
+ * Function:    WavDecoder_AllocateBuffers, WavDecoder_FreeBuffers, WavDecode, WavGet...
+ *
+ * Description: same as the functions without context, but for the decoder instance ctx instead of the default one
+ *
+ * Inputs:      pointer to decoder instance, zero-initialized before first use
+ *              other inputs as in the functions without context
+ *
+ * Notes:       the previous instance is restored on return, so these may be mixed freely with the calls
+ *                without context in the same task
+ **********************************************************************************************************************/
+bool WavDecoder_AllocateBuffers(WavDecoder_t *ctx) {
+    WavDecoder_t *prev = m_wav;
+    bool res;
+
+    m_wav = ctx;
+    res = WavDecoder_AllocateBuffers();
+    m_wav = prev;
+    return res;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void WavDecoder_FreeBuffers(WavDecoder_t *ctx) {
+    WavDecoder_t *prev = m_wav;
+
+    m_wav = ctx;
+    WavDecoder_FreeBuffers();
+    m_wav = prev;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int WavDecode(WavDecoder_t *ctx, uint8_t *inbuf, int *bytesLeft, short *outbuf) {
+    WavDecoder_t *prev = m_wav;
+    int err;
+
+    m_wav = ctx;
+    err = WavDecode(inbuf, bytesLeft, outbuf);
+    m_wav = prev;
+    return err;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int WavGetSampRate(WavDecoder_t *ctx) {return ctx->WavInfo->sampRate;}
+int WavGetChannels(WavDecoder_t *ctx) {return ctx->WavInfo->channels;}
+int WavGetOutputSamps(WavDecoder_t *ctx) {return ctx->WavInfo->outSamps * ctx->WavInfo->channels;}
+int WavGetBitrate(WavDecoder_t *ctx) {return ctx->WavInfo->sampRate * ctx->WavInfo->blockAlign * 8;}
@@ -0,0 +1,64 @@
+// wav_decoder.h
+// RIFF/WAVE reader for the helix builds.  There is nothing to decode: the chunks of the header are
+// parsed as they come in, the PCM samples of the "data" chunk are copied to the output, 8, 24 and
+// 32 bits are converted to 16 bits.  Up to 2 channels, any sample rate.
+// Other chunks (LIST, fact, cue, ...) are skipped by their length, before and after the data.
+// WAVE_FORMAT_EXTENSIBLE with PCM samples and RF64 (no sizes in the RIFF header) are accepted.
+#pragma once
+
+#include "Arduino.h"
+#include "codec_arena.h"
+#include "helix_placement.h"
+
+#define WAV_MAXCHANS        2                           // Max. number of channels
+#define WAV_MAXOUT          1152                        // Max. samples per channel per call
+#define WAV_FMTSIZE         40                          // Bytes of the fmt chunk used (extensible format)
+
+enum {
+    ERR_WAV_NONE                          =   0,
+    ERR_WAV_INDATA_UNDERFLOW              =  -1,        /* all input used, no new PCM */
+    ERR_WAV_NULL_POINTER                  =  -2,
+    ERR_WAV_INVALID_HEADER                =  -4,        /* not RIFF/WAVE or no fmt chunk */
+    ERR_WAV_UNSUPPORTED                   =  -6         /* not PCM, more than 2 channels, ... */
+};
+
+typedef struct _WavInfo_t {
+    int       state;            /* see WV_S_... in wav_decoder.cpp */
+    uint8_t   hdr[WAV_FMTSIZE]; /* RIFF header, chunk header or the fmt chunk */
+    int       fill;             /* bytes in hdr */
+    uint32_t  chunkLeft;        /* bytes of the current chunk still to collect or skip */
+    uint32_t  dataLeft;         /* bytes of samples still to come, 0xFFFFFFFF if not known */
+    bool      fmtSeen;
+    int       channels;
+    int       sampRate;
+    int       bps;              /* bits per sample of the file */
+    int       blockAlign;       /* bytes per sample frame */
+    int       outSamps;         /* samples per channel of the last call */
+    uint32_t  bytes;            /* sample bytes played */
+    uint32_t  skipped;          /* bytes of other chunks skipped */
+} WavInfo_t;
+
+typedef struct _WavDecoder_t {
+    WavInfo_t     *WavInfo;
+} WavDecoder_t;
+
+/* compile-time budget of the buffers in the codec arena, see WavDecoder_AllocateBuffers() */
+static const uint32_t WAV_ARENA_BUDGET = CODEC_ARENA_ROUND(sizeof(WavInfo_t));
+
+bool WavDecoder_AllocateBuffers(void);
+void WavDecoder_FreeBuffers(void);
+int WavDecode(uint8_t *inbuf, int *bytesLeft, short *outbuf);
+int WavGetSampRate();
+int WavGetChannels();
+int WavGetBitsPerSample();
+int WavGetBitrate();
+int WavGetOutputSamps();
+void WavReport();
+// same functions for a specific decoder instance (zero-initialized WavDecoder_t), functions above use a default one
+bool WavDecoder_AllocateBuffers(WavDecoder_t *ctx);
+void WavDecoder_FreeBuffers(WavDecoder_t *ctx);
+int WavDecode(WavDecoder_t *ctx, uint8_t *inbuf, int *bytesLeft, short *outbuf);
+int WavGetSampRate(WavDecoder_t *ctx);
+int WavGetChannels(WavDecoder_t *ctx);
+int WavGetOutputSamps(WavDecoder_t *ctx);
+int WavGetBitrate(WavDecoder_t *ctx);
@@ -157,16 +157,30 @@
   AC101 dac ;                                             // AC101 controls
 #endif
 #if defined(DEC_HELIX)
-  #include <driver/i2s.h>                                 // Driver for I2S output
+  #include "i2sfuncs.h"                                   // Driver for I2S output
   #include "mp3_decoder.h"                                // Yes, include libhelix_HMP3DECODER
   #include "aac_decoder.h"                                // and libhelix_HAACDECODER
+  #include "vorbis_decoder.h"                             // and the Ogg Vorbis decoder
+  #include "oggopus_decoder.h"                            // and the Ogg Opus decoder (HELIX_OPUS)
+  #include "flac_decoder.h"                               // and the FLAC decoder
+  #include "wav_decoder.h"                                // and the WAV reader
   #include "helixfuncs.h"                                 // Helix functions
 #else
   #include "VS1053.h"                                     // Driver for VS1053
 #endif
+#include "driftfuncs.h"                                   // Clock drift compensation
 #define MAXKEYS           200                             // Max. number of NVS keys in table
 #define FSIF              true                            // Format SPIFFS if not existing
-#define QSIZ              400                             // Number of entries in the MP3 stream queue
+#ifndef QSIZ                                              // May be set in config.h
+  #define QSIZ            400                             // Number of entries in the MP3 stream queue
+#endif
+#define SDCHUNKS          16                              // Max. number of queue entries per SD read
+#ifdef HELIX_OPUS
+  #define PLAYSTACK       12000                           // Stack size of playtask, libopus needs more
+#else
+  #define PLAYSTACK       2400                            // Stack size of playtask, crossfade adds a level
+#endif
+#define XFQSIZ            100                             // Number of entries in the crossfade queue
 #define NVSBUFSIZE        150                             // Max size of a string in NVS
 // Access point name if connection to WiFi network fails.  Also the hostname for WiFi and OTA.
 // Note that the password of an AP must be at least as long as 8 characters.
@@ -199,7 +213,7 @@ void        chomp ( String &str ) ;
 String      nvsgetstr ( const char* key ) ;
 bool        nvssearch ( const char* key ) ;
 void        sdfuncs() ;
-void        stop_mp3client () ;
+void        stop_mp3client ( bool stopsong = true ) ;
 void        tftset ( uint16_t inx, const char *str ) ;
 void        tftset ( uint16_t inx, String& str ) ;
 void        playtask ( void* parameter ) ;                 // Task to play the stream on VS1053 or HELIX decoder
@@ -225,13 +239,26 @@ bool        readhostfrompref ( int16_t preset, String* host, String* hsym = NULL
 //
 
 enum qdata_type { QDATA, QSTARTSONG, QSTOPSONG,       // datatyp in qdata_struct,
-                  QSTOPTASK } ;
+                  QSTOPTASK, QNEXTSONG, QSEEKSONG,
+                  QFADESONG } ;
 struct qdata_struct                                   // Data in queue for playtask (dataqueue)
 {
   qdata_type                          datatyp ;       // Identifier
   __attribute__((aligned(4))) uint8_t buf[32] ;       // Buffer for chunk of mp3 data
 } ;
 
+struct xfsrc_struct                                   // Old station of a crossfade, see handleFadeData
+{
+  bool                                chunked ;       // Same as the globals, taken over at handover
+  int                                 chunksize ;
+  int                                 chunkcount ;
+  int                                 metaint ;
+  int                                 datacount ;
+  int                                 metacount ;     // Bytes of metadata to skip, -1 for length byte
+  qdata_struct                        chunk ;         // Chunk to fill for fadequeue
+  uint8_t*                            qp ;            // Pointer in chunk
+} ;
+
 struct ini_struct
 {
   String         mqttbroker ;                         // The name of the MQTT broker server
@@ -323,6 +350,7 @@ preset_info_t        presetinfo ;                        // Info about the curre
 ini_struct           ini_block ;                         // Holds configurable data
 AsyncWebServer       cmdserver ( 80 ) ;                  // Instance of embedded webserver, port 80
 AsyncClient*         mp3client = NULL ;                  // An instance of the mp3 client
+AsyncClient*         fadeclient = NULL ;                 // Client of the old station during a crossfade
 WiFiClient           wmqttclient ;                       // An instance for mqtt
 PubSubClient         mqttclient ( wmqttclient ) ;        // Client for MQTT subscriber
 TaskHandle_t         maintask ;                          // Taskhandle for main task
@@ -332,8 +360,15 @@ hw_timer_t*          timer = NULL ;                      // For timer
 char                 timetxt[9] ;                        // Converted timeinfo
 const qdata_struct   stopcmd = {QSTOPSONG} ;             // Command for radio/SD
 const qdata_struct   startcmd = {QSTARTSONG} ;           // Command for radio/SD
+const qdata_struct   seekcmd = {QSEEKSONG} ;             // Command for SD
+const qdata_struct   fadecmd = {QFADESONG} ;             // Command for playtask, rest of old stream in fadequeue
 QueueHandle_t        radioqueue = 0 ;                    // Queue for icecast commands
 QueueHandle_t        dataqueue = 0 ;                     // Queue for mp3 datastream
+QueueHandle_t        fadequeue = 0 ;                     // Queue for old stream during a crossfade
+xfsrc_struct         xfsrc ;                             // Parse state of old station
+volatile uint8_t     xfswap = 0 ;                        // Handover of mp3client: 1 requested, 2 busy, 3 done
+portMUX_TYPE         xfmux = portMUX_INITIALIZER_UNLOCKED ; // Protects xfswap
+int16_t              lnpreset = -1 ;                     // Preset of the loudness measurement, -1 if none
 QueueHandle_t        sdqueue = 0 ;                       // For commands to sdfuncs
 qdata_struct         outchunk ;                          // Data to queue
 qdata_struct         inchunk ;                           // Data from queue
@@ -1362,11 +1397,15 @@ void setdatamode ( datamode_t newmode )
 //**************************************************************************************************
 //                                    S T O P _ M P 3 C L I E N T                                  *
 //**************************************************************************************************
-// Disconnect from the server.                                                                     *
+// Disconnect from the server.  With stopsong false, the playtask is not told to stop, for example *
+// when a crossfade is waiting for the new station.                                                *
 //**************************************************************************************************
-void stop_mp3client ()
+void stop_mp3client ( bool stopsong )
 {
-  queueToPt ( QSTOPSONG ) ;                        // Queue a request to stop the song
+  if ( stopsong )
+  {
+    queueToPt ( QSTOPSONG ) ;                      // Queue a request to stop the song
+  }
   while ( mp3client && mp3client->connected() )    // Client active and connected?
   {
     ESP_LOGI ( TAG, "Stopping client" ) ;          // Yes, stop connection to host
@@ -1377,6 +1416,142 @@ void stop_mp3client ()
 }
 
 
+#ifdef DEC_HELIX
+//**************************************************************************************************
+//                                      X F A D E S W A P                                          *
+//**************************************************************************************************
+// Hand the connection to the current station over to fadeclient for a crossfade.  Called by       *
+// handleData() between two bytes, so the parse state can be taken over.  The data still in the   *
+// dataqueue is played first, then QFADESONG tells the playtask to continue with fadequeue.        *
+//**************************************************************************************************
+void xfadeSwap()
+{
+  AsyncClient* c = mp3client ;                          // Client of the current station
+
+  xfsrc.chunked = chunked ;                             // Take over the parse state
+  xfsrc.chunksize = 0 ;
+  xfsrc.chunkcount = chunkcount ;
+  xfsrc.metaint = metaint ;
+  xfsrc.datacount = datacount ;
+  xfsrc.metacount = 0 ;                                 // Assume in data
+  if ( datamode == METADATA )                           // In metadata?
+  {
+    xfsrc.metacount = ( metalinebfx < 0 ) ? -1 : metacount ;
+  }
+  xfsrc.chunk = outchunk ;                              // Bytes of the chunk being filled
+  xfsrc.chunk.datatyp = QDATA ;
+  xfsrc.qp = xfsrc.chunk.buf + ( outqp - outchunk.buf ) ;
+  outqp = outchunk.buf ;                                // New station starts with an empty chunk
+  mp3client = fadeclient ;                              // Swap the clients
+  fadeclient = c ;
+  xQueueSend ( dataqueue, &fadecmd, 200 ) ;             // In sequence with the data of old station
+}
+
+
+//**************************************************************************************************
+//                                      X F A D E R A D I O                                        *
+//**************************************************************************************************
+// Keep the current station playing in the background for a crossfade to the new one.  The        *
+// handover is done by handleData().  Returns false if there is no crossfade, the caller must      *
+// stop the current station then.                                                                  *
+//**************************************************************************************************
+bool xfadeRadio()
+{
+  int tries = 100 ;                                     // Wait max. 1 second for data
+
+  if ( ( fadeclient == NULL ) ||                        // Crossfade possible?
+       ! ( datamode & ( DATA | METADATA ) ) ||
+       ! mp3client->connected() ||
+       fadeclient->connected() ||
+       ! helixXfadeReady() )
+  {
+    return false ;                                      // No
+  }
+  xQueueReset ( fadequeue ) ;                           // Remove data of an earlier fade
+  helixXfadeArm ( 0, false ) ;                          // Full length, cut if not possible
+  xfswap = 1 ;                                          // Request handover
+  while ( ( xfswap == 1 ) && tries-- )
+  {
+    vTaskDelay ( 10 / portTICK_PERIOD_MS ) ;            // Wait for next data of station
+  }
+  portENTER_CRITICAL ( &xfmux ) ;
+  if ( xfswap == 1 )                                    // Still not done?
+  {
+    xfswap = 0 ;                                        // No, cancel
+  }
+  portEXIT_CRITICAL ( &xfmux ) ;
+  while ( xfswap == 2 )                                 // Handover in progress?
+  {
+    vTaskDelay ( 1 ) ;                                  // Yes, wait for it
+  }
+  if ( xfswap == 0 )                                    // Cancelled?
+  {
+    ESP_LOGI ( TAG, "No crossfade, no data from station" ) ;
+    helixXfadeEnd() ;                                   // Not sent to playtask yet
+    return false ;
+  }
+  xfswap = 0 ;
+  ESP_LOGI ( TAG, "Old station continues for crossfade" ) ;
+  return true ;
+}
+
+
+//**************************************************************************************************
+//                                   L O U D N E S S G E T                                         *
+//**************************************************************************************************
+// Get the loudness of a preset as measured before, in 0.1 LUFS.  "lufs" holds one character per   *
+// preset: 'A' is -60 LUFS up to 'z' for -3 LUFS, '.' is not measured.                             *
+//**************************************************************************************************
+int16_t loudnessGet ( int16_t preset )
+{
+  String lmap ;                                         // Loudness of all presets
+
+  if ( ( preset < 0 ) || ! nvssearch ( "lufs" ) )       // Loudness known?
+  {
+    return LN_UNKNOWN ;                                 // No
+  }
+  lmap = nvsgetstr ( "lufs" ) ;
+  if ( ( preset >= (int16_t)lmap.length() ) ||          // Measured for this preset?
+       ( lmap[preset] < 'A' ) || ( lmap[preset] > 'z' ) )
+  {
+    return LN_UNKNOWN ;                                 // No
+  }
+  return ( lmap[preset] - 'A' - 60 ) * 10 ;
+}
+
+
+//**************************************************************************************************
+//                                  L O U D N E S S S A V E                                        *
+//**************************************************************************************************
+// Store the loudness measured for the current preset in "lufs", see loudnessGet.  NVS is only     *
+// written if the contents changes.                                                                *
+//**************************************************************************************************
+void loudnessSave()
+{
+  String  lmap ;                                        // Loudness of all presets
+  int16_t l = helixLoudMeasured() ;                     // Loudness of current stream
+  char    c ;                                           // Code for this preset
+
+  if ( ( lnpreset < 0 ) || ( lnpreset >= NVSBUFSIZE - 1 ) || // Preset that fits in "lufs"?
+       ( l == LN_UNKNOWN ) )                            // and measured long enough?
+  {
+    return ;                                            // No, nothing to save
+  }
+  c = 'A' + constrain ( lround ( l / 10.0 ) + 60, 0, 'z' - 'A' ) ;
+  if ( nvssearch ( "lufs" ) )
+  {
+    lmap = nvsgetstr ( "lufs" ) ;                       // Loudness of other presets
+  }
+  while ( (int16_t)lmap.length() <= lnpreset )          // Extend to this preset
+  {
+    lmap += '.' ;
+  }
+  lmap.setCharAt ( lnpreset, c ) ;
+  nvssetstr ( "lufs", lmap ) ;                          // Save if changed
+}
+#endif
+
+
 //**************************************************************************************************
 //                                    C O N N E C T T O H O S T                                    *
 //**************************************************************************************************
@@ -1394,8 +1569,35 @@ bool connecttohost()
   size_t      len ;                                  // Length of GET request
   bool        res = false ;                          // Function result, assume bad result
 
+#ifdef DEC_HELIX
+  if ( ! xfadeRadio() )                              // Keep old station for a crossfade?
+  {
+    stop_mp3client ( ! helixXfadeBusy() ) ;          // No, disconnect, but keep a running crossfade
+  }
+#else
   stop_mp3client() ;                                 // Disconnect if still connected
+#endif
   chomp ( presetinfo.host ) ;                        // Do some filtering
+#ifdef DEC_HELIX
+  sprintf ( getreq, "sbr_%02d", presetinfo.preset ) ; // SBR mode forced for this preset?
+  if ( ( presetinfo.station_state == ST_PRESET ) &&
+       nvssearch ( getreq ) )
+  {
+    helixSetSBRMode ( nvsgetstr ( getreq ).c_str(),  // Yes, use it for this stream
+                      true ) ;
+  }
+  else
+  {
+    helixSetSBRMode ( NULL, true ) ;                 // No, use "sbr" setting
+  }
+  loudnessSave() ;                                   // Keep loudness of the previous preset
+  lnpreset = -1 ;                                    // Loudness for this preset known?
+  if ( presetinfo.station_state == ST_PRESET )
+  {
+    lnpreset = presetinfo.preset ;
+  }
+  helixLoudNext ( loudnessGet ( lnpreset ), false ) ; // Gain to start with, measured again
+#endif
   hostwoext = presetinfo.host ;                      // Assume host does not have extension
   ESP_LOGI ( TAG, "Connect to host %s",
              presetinfo.host.c_str() ) ;
@@ -2414,6 +2616,79 @@ void fillkeylist()
 }
 
 
+#ifdef DEC_HELIX
+//**************************************************************************************************
+//                                   H A N D L E F A D E D A T A                                   *
+//**************************************************************************************************
+// Data of the old station during a crossfade.  Same as handlebyte_ch() for DATA and METADATA, but *
+// the metadata is skipped and the chunks go to fadequeue.  While mixing, the playtask only takes  *
+// what it needs, so the data is dropped if the queue is full, otherwise the new station would be  *
+// blocked as well.                                                                                *
+//**************************************************************************************************
+void handleFadeData ( const uint8_t* p, size_t len )
+{
+  uint8_t b ;                                           // Next byte
+
+  while ( len-- )
+  {
+    b = *p++ ;
+    if ( xfsrc.chunked )                                // Chunked transfer?
+    {
+      if ( xfsrc.chunkcount == 0 )                      // Expecting a new chunkcount?
+      {
+        if ( b == '\n' )                                // LF?
+        {
+          xfsrc.chunkcount = xfsrc.chunksize ;          // Yes, set new count
+          xfsrc.chunksize = 0 ;
+        }
+        else if ( b != '\r' )                           // Hexadecimal character?
+        {
+          b = toupper ( b ) - '0' ;
+          if ( b > 9 )
+          {
+            b = b - 7 ;                                 // Translate A..F to 10..15
+          }
+          xfsrc.chunksize = ( xfsrc.chunksize << 4 ) + b ;
+        }
+        continue ;
+      }
+      xfsrc.chunkcount-- ;
+    }
+    if ( xfsrc.metacount )                              // In metadata?
+    {
+      if ( xfsrc.metacount < 0 )                        // Yes, length byte?
+      {
+        xfsrc.metacount = b * 16 ;                      // Yes, bytes to skip
+      }
+      else
+      {
+        xfsrc.metacount-- ;
+      }
+      if ( xfsrc.metacount == 0 )                       // End of metadata?
+      {
+        xfsrc.datacount = xfsrc.metaint ;               // Yes, data follows
+      }
+      continue ;
+    }
+    *xfsrc.qp++ = b ;
+    if ( xfsrc.qp == ( xfsrc.chunk.buf + sizeof(xfsrc.chunk.buf) ) )   // Chunk full?
+    {
+      if ( helixXfadeBusy() )                           // Still needed?
+      {
+        xQueueSend ( fadequeue, &xfsrc.chunk,           // Yes, to playtask
+                     helixXfadeMixing() ? 0 : 200 ) ;
+      }
+      xfsrc.qp = xfsrc.chunk.buf ;
+    }
+    if ( xfsrc.metaint && ( --xfsrc.datacount == 0 ) )  // End of datablock?
+    {
+      xfsrc.metacount = -1 ;                            // Yes, length of metadata is next
+    }
+  }
+}
+#endif
+
+
 //**************************************************************************************************
 //                                       H A N D L E D A T A                                       *
 //**************************************************************************************************
@@ -2426,8 +2701,35 @@ void handleData ( void* arg, AsyncClient* client, void *data, size_t len )
   uint8_t* p = (uint8_t*)data ;                         // Treat as an array of bytes
 
   // ESP_LOGI ( TAG, "Data received, %d bytes", len ) ;
+#ifdef DEC_HELIX
+  if ( client == fadeclient )                           // Old station of a crossfade?
+  {
+    handleFadeData ( p, len ) ;                         // Yes, to fadequeue
+    return ;
+  }
+#endif
   while ( len-- )
   {
+#ifdef DEC_HELIX
+    if ( ( xfswap == 1 ) &&                             // Handover for crossfade requested?
+         ! ( chunked && ( chunkcount == 0 ) ) )         // Not in the middle of a chunk size?
+    {
+      bool go ;
+      portENTER_CRITICAL ( &xfmux ) ;
+      if ( ( go = ( xfswap == 1 ) ) )                   // Not cancelled in the meantime?
+      {
+        xfswap = 2 ;                                    // Yes, handover busy
+      }
+      portEXIT_CRITICAL ( &xfmux ) ;
+      if ( go )
+      {
+        xfadeSwap() ;                                   // Give this client to fadeclient
+        xfswap = 3 ;                                    // Handover done
+        handleFadeData ( p, len + 1 ) ;                 // Rest of the data is for the old stream
+        return ;
+      }
+    }
+#endif
     handlebyte_ch ( *p++ ) ;                            // Handle next byte
   }
 }
@@ -2637,6 +2939,10 @@ void setup()
                              sizeof ( qdata_type ) ) ;
   dataqueue = xQueueCreate  ( QSIZ,                      // Create queue for data communication
                              sizeof ( qdata_struct ) ) ;
+  #ifdef DEC_HELIX
+    fadequeue = xQueueCreate ( XFQSIZ,                   // Create queue for old stream of crossfade
+                               sizeof ( qdata_struct ) ) ;
+  #endif
   p = "Connect to network" ;                             // Show progress
   ESP_LOGI ( TAG, "%s", p ) ;
   tftlog ( p, true ) ;                                   // On TFT too
@@ -2666,6 +2972,14 @@ void setup()
     mp3client->onDisconnect ( &onDisConnect ) ;          // Set callback on disconnect
     mp3client->onError ( &onError ) ;                    // Set callback on error
     mp3client->onTimeout ( &onTimeout ) ;                // Set callback on time-out
+    #ifdef DEC_HELIX
+      fadeclient = new AsyncClient ;                     // Second client, for crossfade between stations
+      fadeclient->onData ( &handleData ) ;               // Same callbacks, handleData checks the client
+      fadeclient->onConnect ( &onConnect ) ;
+      fadeclient->onDisconnect ( &onDisConnect ) ;
+      fadeclient->onError ( &onError ) ;
+      fadeclient->onTimeout ( &onTimeout ) ;
+    #endif
     mqtt_on = ( ini_block.mqttbroker.length() > 0 ) &&   // Use MQTT if broker specified
               ( ini_block.mqttbroker != "none" ) ;
     #ifdef ENABLEOTA
@@ -2750,7 +3064,7 @@ void setup()
   xTaskCreatePinnedToCore (
     playtask,                                             // Task to play data in dataqueue.
     "Playtask",                                           // Name of task.
-    2100,                                                 // Stack size of task
+    PLAYSTACK,                                            // Stack size of task
     NULL,                                                 // parameter of the task
     2,                                                    // priority of the task
     &xplaytask,                                           // Task handle to keep track of created task
@@ -3024,6 +3338,9 @@ void handleSaveReq()
   nvssetstr ( "tonehf", String ( ini_block.rtone[1] ) ) ; // Save current tonehf
   nvssetstr ( "tonela", String ( ini_block.rtone[2] ) ) ; // Save current tonela
   nvssetstr ( "tonelf", String ( ini_block.rtone[3] ) ) ; // Save current tonelf
+  #ifdef DEC_HELIX
+    loudnessSave() ;                                      // Save loudness of current preset
+  #endif
 }
 
 
@@ -3269,6 +3586,8 @@ void chk_enc()
 //**************************************************************************************************
 void spfuncs()
 {
+  static uint8_t driftcount = 0 ;                               // Count 100 msec ticks for drift control
+
   if ( spftrigger )                                             // Will be set every 100 msec
   {
     spftrigger = false ;                                        // Reset trigger
@@ -3299,6 +3618,13 @@ void spfuncs()
       reqtone = false ;
       player_setTone ( ini_block.rtone ) ;                      // Set SCI_BASS to requested value
     }
+    if ( ++driftcount == 10 )                                   // Once a second
+    {
+      driftcount = 0 ;
+      driftControl ( datamode & ( DATA | METADATA ),            // Trim rate for network streams
+                     uxQueueMessagesWaiting ( dataqueue ),
+                     QSIZ, sizeof(outchunk.buf), mbitrate ) ;
+    }
     if ( time_req )                                             // Time to refresh timetxt?
     {
       if ( NetworkFound )                                       // Yes, time available?
@@ -3365,6 +3691,14 @@ void radiofuncs()
         break ;
     }
   }
+#ifdef DEC_HELIX
+  if ( fadeclient && fadeclient->connected() &&                   // Old station of a crossfade
+       ! helixXfadeBusy() )                                       // not needed anymore?
+  {
+    ESP_LOGI ( TAG, "Stop old station" ) ;
+    fadeclient->abort() ;                                         // Yes, disconnect
+  }
+#endif
 }
 
 
@@ -3423,6 +3757,15 @@ void loop()
       log_printf ( sformat, pcTaskGetTaskName ( xsdtask ),
                  uxTaskGetStackHighWaterMark ( xsdtask ) ) ;
     #endif
+    #ifdef HELIX_DUALCORE
+      log_printf ( sformat, pcTaskGetTaskName ( xouttask ),
+                 uxTaskGetStackHighWaterMark ( xouttask ) ) ;
+    #endif
+    #ifdef DEC_HELIX
+      CodecArena_Report() ;                         // Show memory used by decoder
+      helixReport() ;                               // Show decoder load
+    #endif
+    driftReport() ;                                 // Show drift compensation
     log_printf ( "ADC reading is %d, filtered %d\n", adcvalraw, adcval ) ;
     log_printf ( "%d IR interrupts seen\n", ir_intcount ) ;
     if ( pin_exists ( ini_block.sd_detect_pin ) )
@@ -3686,6 +4029,13 @@ void handlebyte_ch ( uint8_t b )
                     bitrate, metaint ) ;
           setdatamode ( DATA ) ;                        // Expecting data now
           datacount = metaint ;                         // Number of bytes before first metadata
+#ifdef DEC_HELIX
+          if ( helixXfadeBusy() )                       // Old station still in the dataqueue?
+          {
+            xQueueSend ( dataqueue, &startcmd, 200 ) ;  // Yes, start in sequence
+            return ;
+          }
+#endif
           queueToPt ( QSTARTSONG ) ;                    // Queue a request to start song
         }
       }
@@ -3986,6 +4336,8 @@ const char* analyzeCmd ( const char* str )
 //   track      = songname                  // Select MP3 track from SD card                       *
 //   trackinx   = n                         // Select MP3 track by index from SD card.             *
 //   random                                 // Select random mP3 track                             *
+//   seek       = 90                        // Go to position in seconds in current MP3 track      *
+//   skip       = -10                       // Skip seconds forward or (negative) backward         *
 //   preset_00  = <mp3 stream>              // Specify station for a preset 00-max *)              *
 //   volume     = 95                        // Percentage between 0 and 100                        *
 //   upvolume   = 2                         // Add percentage to current volume                    *
@@ -4017,6 +4369,13 @@ const char* analyzeCmd ( const char* str )
 //   reset                                  // Restart the ESP32                                   *
 //   bat0       = 2318                      // ADC value for an empty battery                      *
 //   bat100     = 2916                      // ADC value for a fully charged battery               *
+//   rate       = <ppm2>                    // Fine tune output rate (0.5 ppm), drift control off  *
+//   drift      = <0/1>                     // Compensate clock drift of streams, default 1        *
+//   halfrate   = <0/1>                     // Helix: decode MP3 at half sample rate (saves CPU)   *
+//   sbr        = <off/on/auto>             // Helix: decoding of SBR in HE-AAC streams            *
+//   sbr_00     = <off/on/auto>             // Helix: same, but for one preset                     *
+//   crossfade  = <0..8>                    // Helix: crossfade between tracks/stations in seconds *
+//   loudness   = <-30..-10>                // Helix: normalize loudness (LUFS), 0 is off          *
 //  Commands marked with "*)" are sensible during initialization only                              *
 //**************************************************************************************************
 const char* analyzeCmd ( const char* par, const char* val )
@@ -4122,6 +4481,13 @@ const char* analyzeCmd ( const char* par, const char* val )
                getCurrentSDFileName() ) ;
     myQueueSend ( sdqueue, &startcmd ) ;              // Signal SDfuncs()
   }
+  else if ( ( argument == "seek" ) ||                 // Seek in MP3 track?
+            ( argument == "skip" ) )
+  {
+    seekreq = ivalue ;                                // Yes, set position or skip
+    seekrel = ( argument == "skip" ) ;
+    myQueueSend ( sdqueue, &seekcmd ) ;               // Signal SDfuncs()
+  }
 #endif
   else if ( ( value.length() > 0 ) &&
             ( argument == "station" ) )               // Station in the form address:port
@@ -4190,7 +4556,14 @@ const char* analyzeCmd ( const char* par, const char* val )
   }
   else if ( argument == "rate" )                      // Rate command?
   {
-    player_AdjustRate ( ivalue ) ;                    // Yes, adjust
+    driftSetMode ( false ) ;                          // Yes, manual setting, no drift control
+    player_AdjustRate ( ivalue ) ;                    // Adjust
+  }
+  else if ( argument == "drift" )                     // Drift control?
+  {
+    driftSetMode ( ivalue != 0 ) ;                    // Yes, switch on or off
+    sprintf ( reply, "Drift control %s",
+              ivalue ? "on" : "off" ) ;
   }
   else if ( argument.startsWith ( "mqtt" ) )          // Parameter fo MQTT?
   {
@@ -4246,6 +4619,36 @@ const char* analyzeCmd ( const char* par, const char* val )
       ini_block.bat0 = ivalue ;                       // Yes, set it
     }
   }
+#ifdef DEC_HELIX
+  else if ( argument == "halfrate" )                  // Half rate decoding?
+  {
+    helixSetHalfRate ( ivalue != 0 ) ;                // Yes, set for next stream
+    sprintf ( reply, "Half rate decoding %s",
+              ivalue ? "on" : "off" ) ;
+  }
+  else if ( argument.startsWith ( "sbr" ) )           // SBR mode?
+  {
+    if ( argument == "sbr" )                          // Default for all streams?
+    {
+      helixSetSBRMode ( value.c_str(), false ) ;      // Yes, set for next stream
+    }                                                 // sbr_xx is read in connecttohost
+    sprintf ( reply, "SBR mode %s", value.c_str() ) ;
+  }
+  else if ( argument == "crossfade" )                 // Crossfade length?
+  {
+    helixSetCrossfade ( ivalue ) ;                    // Yes, set for next change of track or station
+    sprintf ( reply, "Crossfade %d seconds", ivalue ) ;
+  }
+  else if ( argument == "loudness" )                  // Loudness normalization?
+  {
+    helixSetLoudness ( ivalue ) ;                     // Yes, set target
+    sprintf ( reply, "Loudness target %d LUFS", ivalue ) ;
+  }
+  else if ( argument == "lufs" )                      // Loudness of the presets?
+  {
+    strcpy ( reply, "Loudness of presets" ) ;         // Yes, read in connecttohost
+  }
+#endif
   else
   {
     sprintf ( reply, "%s called with illegal parameter: %s",
@@ -4349,6 +4752,7 @@ void playtask ( void * parameter )
 {
   // static bool once = true ;                                      // Show chunk once  #if defined(DEC_VS1053) || defined(DEC_VS1003)
   bool VS_okay ;                                                    // VS isw okay or not
+  bool wav = false ;                                                // Current SD track is WAV
 
   ESP_LOGI ( TAG, "Starting VS1053 playtask.." ) ;
   VS_okay = VS1053_begin ( ini_block.vs_cs_pin,                     // Make instance of player and initialize
@@ -4389,8 +4793,17 @@ void playtask ( void * parameter )
             mqttpub.trigger ( MQTT_PLAYING ) ;                        // Request publishing to MQTT
             vs1053player->setVolume ( ini_block.reqvol ) ;            // Unmute
             vs1053player->startSong() ;                               // START, start player
+            wav = ( audio_ct.indexOf ( "wav" ) > 0 ) ;                // WAV from SD?
             // once = true ;
             break ;
+          case QNEXTSONG:                                             // Next SD track follows directly
+            if ( wav || ( audio_ct.indexOf ( "wav" ) > 0 ) )          // WAV before or after?
+            {
+              vs1053player->stopSong() ;                              // Yes, end of file for the chip,
+              vs1053player->startSong() ;                             // next file starts with a header
+              wav = ( audio_ct.indexOf ( "wav" ) > 0 ) ;
+            }
+            break ;
           case QSTOPSONG:
             ESP_LOGI ( TAG, "QSTOPSONG" ) ;
             playingstat = 0 ;                                         // Status for MQTT
@@ -4427,47 +4840,10 @@ void playtask ( void * parameter )
 //**************************************************************************************************
 void playtask ( void * parameter )
 {
-  esp_err_t        pinss_err = ESP_FAIL ;                            // Result of i2s_set_pin
-  i2s_config_t     i2s_config ;                                      // I2S configuration
+  bool             i2sok ;                                           // Result of i2sOutInit
   bool             playing = false ;                                 // Are we playing or not?
+  bool             first ;                                           // First chunk from fadequeue
 
-  memset ( &i2s_config, 0, sizeof(i2s_config) ) ;                    // Clear config struct
-  i2s_config.mode                   = (i2s_mode_t)(I2S_MODE_MASTER | // I2S mode (5)
-                                          I2S_MODE_TX) ;
-  #ifdef DEC_HELIX_SPDIF
-    i2s_config.use_apll               = true ;
-    i2s_config.sample_rate            = 44100 * 2 ;                  // For spdif: biphase and 32 bits
-    i2s_config.bits_per_sample        = I2S_BITS_PER_SAMPLE_32BIT ;  // and 32 bits
-    #if ESP_ARDUINO_VERSION_MAJOR >= 2                               // New version?
-      i2s_config.communication_format = I2S_COMM_FORMAT_STAND_I2S ;  // Yes, use new definition
-    #else
-      i2s_config.communication_format = (i2s_comm_format_t)(I2S_COMM_FORMAT_I2S | I2S_COMM_FORMAT_I2S_MSB) ;
-    #endif
-  #else
-    i2s_config.sample_rate            = 44100 ;                      // 44100
-    i2s_config.bits_per_sample        = I2S_BITS_PER_SAMPLE_16BIT ;  // (16)
-    #if ESP_ARDUINO_VERSION_MAJOR >= 2                               // New version?
-      i2s_config.communication_format = I2S_COMM_FORMAT_STAND_MSB ;  // Yes, use new definition
-    #else
-      i2s_config.communication_format = (i2s_comm_format_t)(I2S_COMM_FORMAT_I2S | I2S_COMM_FORMAT_I2S_MSB) ;
-    #endif
-  #endif
-  //i2s_config.channel_format     = I2S_CHANNEL_FMT_RIGHT_LEFT ;   // = 0
-  i2s_config.intr_alloc_flags     = ESP_INTR_FLAG_LEVEL1 ;         // High interrupt priority
-  i2s_config.dma_buf_count        = 12 ;
-  i2s_config.dma_buf_len          = 256 ;
-  i2s_config.tx_desc_auto_clear   = true ;                         // clear tx descriptor on underflow
-  //i2s_config.fixed_mclk         = 0 ;                            // No (pin for) MCLK
-  //i2s_config.mclk_multiple      = I2S_MCLK_MULTIPLE_DEFAULT ;    // = 0
-  //i2s_config.bits_per_chan      = I2S_BITS_PER_CHAN_DEFAULT ;    // = 0
-  #ifdef DEC_HELIX_INT
-    i2s_config.mode = (i2s_mode_t)(I2S_MODE_MASTER |               // Set I2S mode for internal DAC
-                                   I2S_MODE_TX |                   // (4)
-                                   I2S_MODE_DAC_BUILT_IN ) ;       // Enable internal DAC (16)
-    #if ESP_ARDUINO_VERSION_MAJOR < 2
-      i2s_config.communication_format = I2S_COMM_FORMAT_I2S_MSB ;
-    #endif
-  #endif
   ESP_LOGI ( TAG, "Starting I2S playtask.." ) ;
   #ifdef DEC_HELIX_AI                                              // For AI board?
     #define IIC_DATA 33                                            // Yes, use these I2C signals
@@ -4479,52 +4855,50 @@ void playtask ( void * parameter )
     pinMode ( GPIO_PA_EN, OUTPUT ) ;
     digitalWrite ( GPIO_PA_EN, HIGH ) ;
   #endif
-  MP3Decoder_AllocateBuffers() ;                                    // Init HELIX buffers
-  AACDecoder_AllocateBuffers() ;                                    // Init HELIX buffers
-  if ( i2s_driver_install ( I2S_NUM_0, &i2s_config, 0, NULL ) != ESP_OK )
-  {
-    ESP_LOGE ( TAG, "I2S install error!" ) ;
-  }
-  #ifdef DEC_HELIX_INT                                              // Use internal (8 bit) DAC?
-    ESP_LOGI ( TAG, "Output to internal DAC" ) ;                    // Show output device
-    pinss_err = i2s_set_pin ( I2S_NUM_0, NULL ) ;                   // Yes, default pins for internal DAC
-    i2s_set_dac_mode ( I2S_DAC_CHANNEL_BOTH_EN ) ;
+  #ifdef DEC_HELIX_SPDIF
+    i2sok = i2sOutInit ( I2SRATE * 2, -1, -1,                       // For spdif: biphase and 32 bits
+                         ini_block.i2s_spdif_pin ) ;
   #else
-    i2s_pin_config_t pin_config ;
-    #if ESP_ARDUINO_VERSION_MAJOR >= 2
-      pin_config.mck_io_num   = I2S_PIN_NO_CHANGE ;                 // MCK not used
-    #endif
-    pin_config.data_in_num    = I2S_PIN_NO_CHANGE ;
-    #ifdef DEC_HELIX_SPDIF
-      pin_config.bck_io_num   = I2S_PIN_NO_CHANGE ;
-      pin_config.ws_io_num    = I2S_PIN_NO_CHANGE ;
-      pin_config.data_out_num = ini_block.i2s_spdif_pin ;
-      pin_config.data_in_num  = I2S_PIN_NO_CHANGE ;
-      ESP_LOGI ( TAG, "Output to SPDIF, pin %d",                    // Show pin used for output device
-                 pin_config.data_out_num ) ;
-    #else
-      pin_config.bck_io_num   = ini_block.i2s_bck_pin ;             // This is BCK pin
-      pin_config.ws_io_num    = ini_block.i2s_lck_pin ;             // This is L(R)CK pin
-      pin_config.data_out_num = ini_block.i2s_din_pin ;             // This is DATA output pin
-      ESP_LOGI ( TAG, "Output to I2S, pins %d, %d and %d",          // Show pins used for output device
-                 pin_config.bck_io_num,                             // This is the BCK (bit clock) pin
-                 pin_config.ws_io_num,                              // This is L(R)CK pin
-                 pin_config.data_out_num ) ;                        // This is DATA output pin
-    #endif
-    pinss_err = i2s_set_pin ( I2S_NUM_0, &pin_config ) ;            // Set I2S pins
+    i2sok = i2sOutInit ( I2SRATE,                                   // 44100 or HELIX_FIXEDRATE
+                         ini_block.i2s_bck_pin,                     // This is the BCK (bit clock) pin
+                         ini_block.i2s_lck_pin,                     // This is L(R)CK pin
+                         ini_block.i2s_din_pin ) ;                  // This is DATA output pin
   #endif
-  i2s_zero_dma_buffer ( I2S_NUM_0 ) ;                               // Zero the buffer
-  if ( pinss_err != ESP_OK )                                        // Check error condition
+  if ( ! i2sok )                                                    // Check error condition
   {
-    ESP_LOGE ( TAG, "I2S setpin error!" ) ;                         // Rport bad pins
+    ESP_LOGE ( TAG, "I2S output error!" ) ;                         // Report bad pins
     while ( true)                                                   // Forever..
     {
       xQueueReceive ( dataqueue, &inchunk, 500 ) ;                  // Ignore all chunk from queue
     }
   }
+  helixSetGain() ;                                                  // Output gain for the current volume
+  #ifdef HELIX_DUALCORE
+    helixStartOutput() ;                                            // Start output stage on core 1
+  #endif
   while ( true )
   {
-    if ( xQueueReceive ( dataqueue, &inchunk, 5 ) == pdTRUE )       // Command/data from queue?
+    first = true ;
+    while ( helixXfadeWant ( first ) &&                             // Old stream of a crossfade first
+            ( xQueueReceive ( fadequeue, &inchunk, 0 ) == pdTRUE ) )
+    {
+      first = false ;
+      helixXfadeChunk ( ( inchunk.datatyp == QDATA ) ?              // Data or end of old stream
+                        inchunk.buf : NULL ) ;
+    }
+    if ( helixXfadeHold() &&                                        // Rest of old SD track first?
+         ( ( xQueuePeek ( dataqueue, &inchunk, 0 ) != pdTRUE ) ||   // Unless a command is waiting
+           ( inchunk.datatyp == QDATA ) ) )
+    {
+      if ( xQueueReceive ( fadequeue, &inchunk, 5 ) == pdTRUE )     // Yes, wait for it
+      {
+        helixXfadeChunk ( ( inchunk.datatyp == QDATA ) ?
+                          inchunk.buf : NULL ) ;
+      }
+      continue ;
+    }
+    if ( xQueueReceive ( dataqueue, &inchunk,                       // Command/data from queue?
+                         helixXfadeBusy() ? 1 : 5 ) == pdTRUE )     // Short wait if fadequeue is used
     {
       switch ( inchunk.datatyp )                                    // Yes, what kind of command?
       {
@@ -4540,23 +4914,42 @@ void playtask ( void * parameter )
           playing = true ;                                          // Set local status to playing
           playingstat = 1 ;                                         // Status for MQTT
           mqttpub.trigger ( MQTT_PLAYING ) ;                        // Request publishing to MQTT
-          helixInit ( ini_block.shutdown_pin,                       // Enable amplifier output
-                      ini_block.shutdownx_pin ) ;                   // Init framebuffering
+          if ( ! helixXfadeStart ( ini_block.shutdown_pin,          // Crossfade from old stream?
+                                   ini_block.shutdownx_pin ) )
+          {
+            helixInit ( ini_block.shutdown_pin,                     // No, enable amplifier output
+                        ini_block.shutdownx_pin ) ;                 // Init framebuffering
+          }
+          helixLoudStart() ;                                        // Gain for loudness of new stream
+          break ;
+        case QFADESONG:
+          ESP_LOGI ( TAG, "Playtask crossfade" ) ;
+          helixXfadeArmed() ;                                       // Old stream from fadequeue now
           break ;
         case QSTOPSONG:
           ESP_LOGI ( TAG, "Playtask stop song" ) ;
           playing = false ;                                         // Reset local play status
           playingstat = 0 ;                                         // Status for MQTT
-          i2s_stop ( I2S_NUM_0 ) ;                                  // Stop DAC
+          helixStop() ;                                             // Stop DAC
           mqttpub.trigger ( MQTT_PLAYING ) ;                        // Request publishing to MQTT
           //vTaskDelay ( 500 / portTICK_PERIOD_MS ) ;               // Pause for a short time
           break ;
         case QSTOPTASK:
           ESP_LOGI ( TAG, "Stop Playtask" ) ;
           playing = false ;                                         // Reset local play status
-          i2s_stop ( I2S_NUM_0 ) ;                                  // Stop DAC
+          helixStop() ;                                             // Let output task finish, stop DAC
+          #ifdef HELIX_DUALCORE
+            vTaskDelete ( xouttask ) ;                              // and stop output task
+          #endif
           vTaskDelete ( NULL ) ;                                    // Stop task
           break ;
+        case QNEXTSONG:
+          if ( playing )                                            // Next SD track follows directly
+          {
+            helixNextTrack() ;                                      // Finish current track, no gap
+            helixLoudStart() ;                                      // Gain for loudness of next track
+          }
+          break ;
         default:
           break ;
       }
@@ -4566,6 +4959,40 @@ void playtask ( void * parameter )
 #endif
 
 
+#ifdef SDCARD
+//**************************************************************************************************
+//                                   Q U E U E S D B L O C K                                       *
+//**************************************************************************************************
+// Split a block read from SD into chunks and send them to a queue with enough free entries.       *
+// If scan is set, the seek index of the current file is extended.                                 *
+//**************************************************************************************************
+void queueSDblock ( QueueHandle_t q, const uint8_t* block, size_t n, bool scan )
+{
+  size_t m ;                                                      // Number of bytes in a chunk
+
+  for ( size_t i = 0 ; i < n ; i += m )                           // Split into chunks
+  {
+    m = n - i ;                                                   // Bytes left
+    if ( m >= sizeof(outchunk.buf) )                              // Complete chunk?
+    {
+      m = sizeof(outchunk.buf) ;                                  // Yes
+    }
+    else
+    {
+      memset ( outchunk.buf + m, 0,                               // No, clear rest
+               sizeof(outchunk.buf) - m ) ;
+    }
+    memcpy ( outchunk.buf, block + i, m ) ;
+    xQueueSend ( q, &outchunk, 0 ) ;                              // Send to queue
+    if ( scan )
+    {
+      seekScan ( outchunk.buf, m ) ;                              // Extend seek index
+    }
+  }
+}
+#endif
+
+
 //**************************************************************************************************
 //                                     S D F U N C S                                               *
 //**************************************************************************************************
@@ -4578,21 +5005,123 @@ void sdfuncs()
   qdata_type          sdcmd ;                                     // Command from sdqueue
   static bool         openfile = false ;                          // Open input file available
   static bool         autoplay = true ;                           // Play next after end
+  static uint8_t      sdblock[SDCHUNKS*sizeof(outchunk.buf)] ;    // Data of one read from SD
   size_t              n ;                                         // Number of bytes read from SD
+  UBaseType_t         spaces ;                                    // Free entries in dataqueue
+  #ifdef DEC_HELIX
+    static File       xffile ;                                    // Old track during a crossfade
+    static int        xflength = 0 ;                              // Bytes of old track still to read
+    static bool       xfasked = false ;                           // Crossfade checked for this track
+    uint32_t          xfbytes ;                                   // Bytes for a crossfade
+    uint32_t          xfrate ;                                    // Bytes per second
+    uint32_t          xfms ;                                      // Length of the crossfade
 
+    if ( xffile )                                                 // Old track of a crossfade open?
+    {
+      if ( ! helixXfadeBusy() )                                   // Crossfade ended early?
+      {
+        xflength = 0 ;                                            // Yes, rest is not needed
+      }
+      while ( ( xflength > 0 ) &&                                 // Read until eof or fadequeue full
+              ( ( spaces = uxQueueSpacesAvailable ( fadequeue ) ) > 0 ) )
+      {
+        if ( spaces > SDCHUNKS )
+        {
+          spaces = SDCHUNKS ;
+        }
+        n = xffile.read ( sdblock, spaces * sizeof(outchunk.buf) ) ;
+        queueSDblock ( fadequeue, sdblock, n, false ) ;           // No seek index for the old track
+        xflength -= n ;
+        if ( n == 0 )                                             // Read error?
+        {
+          xflength = 0 ;                                          // Yes, treat as end of file
+        }
+        if ( xflength <= 0 )                                      // End of old track?
+        {
+          outchunk.datatyp = QSTOPSONG ;                          // Yes, tell playtask
+          xQueueSend ( fadequeue, &outchunk, 200 ) ;
+          outchunk.datatyp = QDATA ;
+        }
+      }
+      if ( xflength <= 0 )
+      {
+        ESP_LOGI ( TAG, "Close old track" ) ;
+        xffile.close() ;
+      }
+    }
+  #endif
   if ( openfile )
   {
     while ( ( mp3filelength > 0 ) &&                              // Read until eof or dataqueue full
-            ( uxQueueSpacesAvailable ( dataqueue ) > 0 ) )
+            ( ( spaces = uxQueueSpacesAvailable ( dataqueue ) ) > 0 ) )
     {
-      n = mp3file.read ( outchunk.buf, sizeof(outchunk.buf) ) ;   // Read a block of data
-      if ( n < sizeof(outchunk.buf) )                             // Incomplete chunk?
-      {
-        memset ( outchunk.buf + n, 0,                             // Yes, clear rest
-                 sizeof(outchunk.buf) - n ) ;
+      if ( spaces > SDCHUNKS )                                    // Read several chunks at once,
+      {                                                           // fewer and longer SPI transfers
+        spaces = SDCHUNKS ;
       }
-      xQueueSend ( dataqueue, &outchunk, 0 ) ;                    // Send to queue
+      n = mp3file.read ( sdblock, spaces * sizeof(outchunk.buf) ) ; // Read a block of data
+      queueSDblock ( dataqueue, sdblock, n, true ) ;              // Send to queue, extend seek index
       mp3filelength -= n ;                                        // Compute rest in file
+      #ifdef DEC_HELIX
+        xfbytes = helixXfadeBytes ( 0 ) ;                         // Bytes for crossfade, 0 if off
+        if ( autoplay && ! xffile && ! xfasked &&                 // Time for a crossfade to next track?
+             ( mp3filelength > 0 ) && ( (uint32_t)mp3filelength <= xfbytes ) )
+        {
+          xfrate = helixXfadeBytes ( 1000 ) ;
+          xfms = (uint64_t)mp3filelength * 1000 / xfrate ;        // Rest of this track in msec
+          xfasked = true ;                                        // Check once per track
+          if ( ( xfms >= XF_MINMS ) && helixXfadeReady() )
+          {
+            xffile = mp3file ;                                    // Rest of this track is read from xffile
+            xflength = mp3filelength ;
+            getNextSDFileName() ;                                 // Select next track
+            if ( connecttofile_SD() )                             // Open it, sets mp3file and mp3filelength
+            {
+              ESP_LOGI ( TAG, "Crossfade to track %s",
+                         getCurrentSDFileName() ) ;
+              audio_ct = String ( SDcontentType (                 // MP3, WAV or FLAC, for the playtask
+                                    getCurrentSDFileName() ) ) ;
+              xQueueReset ( fadequeue ) ;                         // Remove data of an earlier fade
+              helixXfadeArm ( xfms, true ) ;                      // Old track is played to the end
+              xQueueSend ( dataqueue, &fadecmd, 200 ) ;           // Rest of old track in fadequeue
+              xQueueSend ( dataqueue, &startcmd, 200 ) ;          // Start of new track, in sequence
+              xfasked = false ;                                   // Not checked for the new track
+              continue ;                                          // Keep reading
+            }
+            mp3file = xffile ;                                    // Could not open, keep old track
+            mp3filelength = xflength ;
+            xffile = File() ;
+            xflength = 0 ;
+            autoplay = false ;                                    // Next track would fail as well
+          }
+        }
+      #endif
+      if ( mp3filelength == 0 )                                   // End of file?
+      {
+        seekSave ( getCurrentSDFileName() ) ;                     // Yes, cache seek index
+      }
+      if ( ( mp3filelength == 0 ) && autoplay )                   // End of file, continue with next?
+      {
+        ESP_LOGI ( TAG, "EOF, gapless to next track" ) ;
+        close_SDCARD() ;                                          // Close this file
+        getNextSDFileName() ;                                     // Select next track
+        if ( connecttofile_SD() )                                 // Open it, sets mp3filelength
+        {
+          ESP_LOGI ( TAG, "File opened, track = %s",
+                     getCurrentSDFileName() ) ;
+          audio_ct = String ( SDcontentType (                     // MP3, WAV or FLAC, for the playtask
+                                getCurrentSDFileName() ) ) ;
+          #ifdef DEC_HELIX
+            xfasked = false ;                                     // Crossfade not checked for this track
+          #endif
+          outchunk.datatyp = QNEXTSONG ;                          // Mark the change of track
+          xQueueSend ( dataqueue, &outchunk, 200 ) ;              // in sequence with the data
+          outchunk.datatyp = QDATA ;
+          continue ;                                              // Keep reading
+        }
+        openfile = false ;                                        // Could not open next file
+        autoplay = false ;                                        // Normal stop below
+      }
       if ( mp3filelength == 0 )                                   // End of file?
       {
         vTaskDelay ( 500 / portTICK_PERIOD_MS ) ;                 // Give some time to finish song
@@ -4619,12 +5148,20 @@ void sdfuncs()
           close_SDCARD() ;                                        // Clode file
         }
         queueToPt ( QSTOPSONG ) ;                                 // Tell playtask to stop song
+        #ifdef DEC_HELIX
+          xflength = 0 ;                                          // Old track of a crossfade not needed
+          xfasked = false ;
+          loudnessSave() ;                                        // Keep loudness of the last preset
+          lnpreset = -1 ;
+          helixLoudNext ( LN_UNKNOWN, false ) ;                   // Unless the track has tags
+        #endif
         if ( ( openfile = connecttofile_SD() ) )                  // Yes, connect to file, set mp3filelength
         {
           ESP_LOGI ( TAG, "File opened, track = %s",
                      getCurrentSDFileName() ) ;
           ESP_LOGI ( TAG, "File length is %d", mp3filelength ) ;
-          audio_ct = String ( "audio/mpeg" ) ;                    // Force mp3 mode
+          audio_ct = String ( SDcontentType (                     // MP3, WAV or FLAC mode
+                                getCurrentSDFileName() ) ) ;
           myQueueSend ( radioqueue, &stopcmd ) ;                  // Stop playing icecast station
           radiofuncs() ;                                          // Allow radiofuncs to react
           queueToPt ( QSTARTSONG ) ;                              // Tell playtask
@@ -4635,6 +5172,12 @@ void sdfuncs()
           ESP_LOGI ( TAG, "Error opening file" ) ;
         }
         break ;
+      case QSEEKSONG:                                             // Seek in the song?
+        if ( openfile )                                           // Only if playing
+        {
+          seekSD ( seekreq, seekrel ) ;                           // Yes, go to new position
+        }
+        break ;
       case QSTOPSONG:                                             // Stop the song?
         if ( openfile )                                           // Still playing?
         {
@@ -4642,6 +5185,9 @@ void sdfuncs()
           mp3filelength = 0 ;                                     // Yes, force end of file
           autoplay = false ;                                      // Stop autoplay
         }
+        #ifdef DEC_HELIX
+          xflength = 0 ;                                          // Old track of a crossfade not needed
+        #endif
       default:
         break ;
     }
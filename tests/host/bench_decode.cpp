@@ -0,0 +1,87 @@
+// bench_decode.cpp
+// Decode time of the files in corpus/refs.txt on the host.  Every file is decoded RUNS times, the
+// fastest run counts.  Only the time in the decode calls is measured, see hostdecode.cpp.
+// Not a test: the numbers are for comparing two versions of a decoder on the same machine, for
+// example "bench_decode > new.txt" against the output of a build of the old sources.
+// MP3 files are also decoded at half the sample rate, as "<file> half".  So are AAC files with
+// SBR bypassed in bench_decode_ps, the build with AAC_ENABLE_SBR.  Files of the corpus given as
+// arguments are measured instead of those of refs.txt, like "bench_decode_ps aac_he_v2.aac".
+#include "hostdecode.h"
+
+#define RUNS  50                                      // Number of runs per file
+
+
+//**************************************************************************************************
+//                                           B E N C H                                             *
+//**************************************************************************************************
+// Measure and print the decode time of one file of the corpus.                                    *
+//**************************************************************************************************
+static void bench ( const char* name )
+{
+  std::vector<uint8_t> buf = readFile ( name ) ;
+  const char*          codec = strrchr ( name, '.' ) + 1 ;
+  decoded_t            d ;                            // Result of decoding
+  uint64_t             best ;                         // Fastest run in ns
+  char                 label[80] ;                    // File name and mode
+  int                  modes = 1 ;                    // 2 if there is a half rate mode
+
+  if ( strcmp ( codec, "mp3" ) == 0 )
+  {
+    modes = 2 ;
+  }
+  #ifdef AAC_ENABLE_SBR
+    if ( strcmp ( codec, "aac" ) == 0 )
+    {
+      modes = 2 ;                                     // SBR bypassed
+    }
+  #endif
+  for ( int half = 0 ; half < modes ; half++ )
+  {
+    best = UINT64_MAX ;
+    for ( int run = 0 ; run < RUNS ; run++ )
+    {
+      std::vector<uint8_t> copy ( buf ) ;             // Decoders may write into the input
+      decodeBuffer ( codec, copy.data(), copy.size(), d, 0, half ) ;
+      best = min ( best, d.cycles ) ;
+    }
+    snprintf ( label, sizeof(label), "%s%s", name, half ? " half" : "" ) ;
+    printf ( "%-24s %7d %10.0f %8.0fx\n", label, d.frames, (double)best / d.frames,
+             d.pcm.size() / d.channels / (double)d.rate / ( best / 1e9 ) ) ;
+  }
+}
+
+
+//**************************************************************************************************
+//                                             M A I N                                             *
+//**************************************************************************************************
+int main ( int argc, char* argv[] )
+{
+  FILE*       f ;                                     // refs.txt
+  char        line[256] ;                             // One line of refs.txt
+  char        name[64] ;                              // File name in refs.txt
+  std::string path = std::string ( CORPUS ) + "/refs.txt" ;
+
+  printf ( "%-24s %7s %10s %9s\n", "file", "frames", "ns/frame", "realtime" ) ;
+  if ( argc > 1 )
+  {
+    for ( int i = 1 ; i < argc ; i++ )
+    {
+      bench ( argv[i] ) ;
+    }
+    return 0 ;
+  }
+  if ( ( f = fopen ( path.c_str(), "r" ) ) == NULL )
+  {
+    printf ( "Cannot open %s\n", path.c_str() ) ;
+    return 1 ;
+  }
+  while ( fgets ( line, sizeof(line), f ) )
+  {
+    if ( ( sscanf ( line, "%63s", name ) == 1 ) && ( name[0] != '#' ) )
+    {
+      bench ( name ) ;
+    }
+  }
+  fclose ( f ) ;
+  return 0 ;
+}
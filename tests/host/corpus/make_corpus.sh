@@ -0,0 +1,95 @@
+#!/bin/sh
+# make_corpus.sh
+# Recreate the test files of the corpus and print the reference values for refs.txt.
+# The files in git are the reference, run this only to add a file: other versions of FFmpeg and
+# LAME give other files.  The hash column of refs.txt is the output of "test_decode -p", the
+# frames and RMS columns are from the FFmpeg decoder (astats filter), without trimming the
+# encoder delay and padding.
+# The test signal has a vibrato tone, a switched high tone, clicks (short blocks) and some noise,
+# different in both channels.
+set -e
+FF="${FFMPEG:-ffmpeg} -hide_banner -loglevel error -y"
+SIG="aevalsrc=exprs='0.25*sin(2*PI*(220+30*sin(2*PI*3*t))*t)+0.12*sin(2*PI*2637*t)*lt(mod(t\,0.5)\,0.2)+0.5*lt(mod(t\,0.37)\,0.003)+0.05*(random(0)*2-1)|0.2*sin(2*PI*330*t)+0.1*sin(2*PI*6000*t+sin(2*PI*5*t))+0.4*lt(mod(t+0.1\,0.41)\,0.003)+0.05*(random(1)*2-1)':s=44100:d=1.5"
+
+$FF -f lavfi -i "$SIG" -c:a pcm_s16le /tmp/corpus_src.wav
+$FF -f lavfi -i "$SIG" -c:a pcm_s24le /tmp/corpus_src24.wav
+SRC="-i /tmp/corpus_src.wav"
+SRC24="-i /tmp/corpus_src24.wav"
+
+$FF $SRC -c:a libmp3lame -b:a 128k                mp3_44k_stereo.mp3    # MPEG-1, joint stereo
+$FF $SRC -ar 22050 -c:a libmp3lame -b:a 48k       mp3_22k_stereo.mp3    # MPEG-2
+$FF $SRC -ac 1 -ar 22050 -c:a libmp3lame -q:a 5   mp3_22k_mono.mp3      # MPEG-2, VBR
+$FF $SRC -c:a aac -b:a 96k -f adts                aac_44k_stereo.aac    # ADTS, LC
+$FF $SRC -ac 1 -ar 22050 -c:a aac -b:a 32k -f adts aac_22k_mono.aac     # ADTS, LC with PNS
+
+# The same AAC frames in LOAS/LATM, a StreamMuxConfig every 20 frames, for test_latm
+$FF -i aac_44k_stereo.aac -c:a copy -f latm        aac_44k_stereo.latm
+$FF -i aac_22k_mono.aac -c:a copy -f latm          aac_22k_mono.latm
+
+# Ogg Vorbis, and a chained stream of a mono and a stereo track, like internet radio sends
+$FF $SRC -c:a libvorbis -q:a 3                     vorbis_44k_stereo.ogg
+$FF $SRC -ac 1 -ar 22050 -c:a libvorbis -q:a 0     vorbis_22k_mono.ogg
+$FF $SRC -t 0.5 -ac 1 -ar 22050 -c:a libvorbis -q:a 2 /tmp/corpus_c1.ogg
+$FF $SRC -ss 0.5 -t 0.5 -c:a libvorbis -q:a 2      /tmp/corpus_c2.ogg
+cat /tmp/corpus_c1.ogg /tmp/corpus_c2.ogg > vorbis_chained.ogg
+
+# Ogg Opus for test_oggopus (at 48 kHz, the only rate of the helix build), also chained
+$FF $SRC -ar 48000 -c:a libopus -b:a 96k           opus_48k_stereo.opus
+$FF $SRC -ac 1 -ar 48000 -c:a libopus -b:a 24k -application voip opus_48k_mono.opus
+$FF $SRC -t 0.5 -ac 1 -ar 48000 -c:a libopus -b:a 32k /tmp/corpus_c1.opus
+$FF $SRC -ss 0.5 -t 0.5 -ar 48000 -c:a libopus -b:a 64k /tmp/corpus_c2.opus
+cat /tmp/corpus_c1.opus /tmp/corpus_c2.opus > opus_chained.opus
+
+# FLAC for test_flac, native and Ogg, 16 and 24 bits.  Short, the noise makes lossless files large
+$FF $SRC -t 0.3 -c:a flac                          flac_44k_16.flac
+$FF $SRC -t 0.3 -ac 1 -ar 22050 -c:a flac -f ogg   flac_22k_16.oga
+$FF $SRC24 -t 0.2 -c:a flac -sample_fmt s32        flac_44k_24.flac
+$FF $SRC24 -t 0.2 -ac 1 -ar 48000 -c:a flac -sample_fmt s32 -f ogg flac_48k_24.oga
+
+# Files for test_gapless: mp3_44k_stereo.mp3 split at frame 30000, both tracks with a LAME tag
+$FF $SRC -af atrim=end_sample=30000 -c:a libmp3lame -b:a 128k gapless_a.mp3
+$FF $SRC -af atrim=start_sample=30000,asetpts=N/SR/TB -c:a libmp3lame -b:a 128k gapless_b.mp3
+
+# Files for test_sync
+$FF $SRC -t 0.5 -ac 1 -ar 11025 -c:a libmp3lame -b:a 16k sync_mpeg25.mp3  # MPEG-2.5 is not supported
+python3 make_sync.py
+
+# HE-AAC v2 for test_ps: SBR and PS data added to an AAC LC mono stream, FFmpeg has no encoder
+$FF $SRC -ac 1 -ar 22050 -c:a aac -b:a 32k -f adts /tmp/corpus_core.aac
+python3 make_ps.py /tmp/corpus_core.aac aac_he_v2.aac
+
+# Reference frames and levels
+for f in mp3_* aac_[24]* vorbis_[24]* flac_* ; do
+  ${FFMPEG:-ffmpeg} -hide_banner -flags2 skip_manual -i "$f" -af astats -f null - 2>&1 | awk -v f="$f" '
+        /Overall/                   { all = 1 }
+        /RMS level dB/ && ! all     { rms = rms " " $NF }
+        /Number of samples/         { n = $NF }
+        END                 { print f, n, rms }'
+done
+
+# FLAC is lossless: the hash of the FFmpeg output with 16 bits must be the hash of refs.txt
+for f in flac_* ; do
+  ${FFMPEG:-ffmpeg} -hide_banner -loglevel error -i "$f" -f s16le - | python3 -c '
+import sys
+h = 2166136261
+for b in sys.stdin.buffer.read():
+    h = ( ( h ^ b ) * 16777619 ) & 0xFFFFFFFF
+print ( sys.argv[1], "%08x" % h )' "$f"
+done
+
+# Level of every block of 4096 frames of the Vorbis and Opus files, for vorbis_blocks.txt and
+# opus_blocks.txt.  Opus is decoded with libopus, like the radio does.
+for f in vorbis_44k_stereo.ogg vorbis_22k_mono.ogg opus_48k_stereo.opus opus_48k_mono.opus ; do
+  DEC="" ; case "$f" in *.opus) DEC="-c:a libopus" ;; esac
+  ${FFMPEG:-ffmpeg} -hide_banner -loglevel error $DEC -i "$f" -af "asetnsamples=n=4096:p=0,astats=metadata=1:reset=1,ametadata=mode=print:file=-" -f null - | awk -v f="$f" '
+        /^frame/                    { if ( l != "" ) printf "%-24s %6d %s\n", f, b++, l ; l = "" }
+        /\.[12]\.RMS_level/         { split ( $0, a, "=" ) ; l = l sprintf ( " %8.3f", a[2] ) }
+        END                         { printf "%-24s %6d %s\n", f, b, l }'
+done
+
+# The same for ps_blocks.txt, with a third level: that of (left+right)/2, which depends on the
+# correlation of both channels
+${FFMPEG:-ffmpeg} -hide_banner -loglevel error -i aac_he_v2.aac -af "pan=3c|c0=c0|c1=c1|c2=0.5*c0+0.5*c1,asetnsamples=n=4096:p=0,astats=metadata=1:reset=1,ametadata=mode=print:file=-" -f null - | awk -v f=aac_he_v2.aac '
+        /^frame/                    { if ( l != "" ) printf "%-24s %6d %s\n", f, b++, l ; l = "" }
+        /\.[123]\.RMS_level/        { split ( $0, a, "=" ) ; l = l sprintf ( " %8.3f", a[2] ) }
+        END                         { printf "%-24s %6d %s\n", f, b, l }'
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+# make_ps.py
+# Make the HE-AAC v2 file of the PS test (test_ps.cpp).  FFmpeg has no HE-AAC encoder, so the
+# SBR and PS data are added to an AAC LC mono stream at 22050 Hz made by make_corpus.sh: every
+# ADTS frame gets a fill element with an SBR extension (ISO/IEC 14496-3, 4.4.2.8) in front of
+# its END element.  SBR and PS are signalled implicitly, as in most internet radio streams.
+#  - SBR: a flat envelope at 44100 Hz with a level that changes per frame, a low noise floor.
+#  - PS: the stream has 3 parts with other parameters in 20 bands: panned to the left with full
+#    correlation, in the middle without correlation, and a pan and correlation that change over
+#    the bands.
+# The output of FFmpeg for this file is the reference.
+import struct
+import sys
+
+# SBR header: start and stop frequency, the default scales.  With these the frequency tables at
+# 44100 Hz have NHIGH bands in high resolution and NQ noise floor bands (4.6.18.3).
+START_FREQ = 5
+STOP_FREQ = 9
+NHIGH = 16
+NQ = 3
+
+# PS Huffman codes (length, code) for differences in frequency direction, table 8.B.1 and 8.B.7
+IID_DF0 = list ( zip ( [17, 17, 17, 17, 16, 15, 13, 10, 9, 7, 6, 5, 4, 3, 1, 3, 4, 5, 6, 6, 8, 11, 13,
+                        14, 14, 15, 17, 18, 18],
+                       [0x1FFFB, 0x1FFFC, 0x1FFFD, 0x1FFFA, 0xFFFC, 0x7FFC, 0x1FFD, 0x3FE, 0x1FE,
+                        0x7E, 0x3C, 0x1D, 0xD, 0x5, 0x0, 0x4, 0xC, 0x1C, 0x3D, 0x3E, 0xFE, 0x7FE,
+                        0x1FFC, 0x3FFC, 0x3FFD, 0x7FFD, 0x1FFFE, 0x3FFFE, 0x3FFFF] ) )
+ICC_DF = list ( zip ( [14, 14, 12, 10, 7, 5, 3, 1, 2, 4, 6, 8, 9, 11, 13],
+                      [0x3FFF, 0x3FFE, 0xFFE, 0x3FE, 0x7E, 0x1E, 0x6, 0x0, 0x2, 0xE, 0x3E, 0xFE,
+                       0x1FE, 0x7FE, 0x1FFE] ) )
+
+
+class Bits :
+    """Bit writer, most significant bit first."""
+    def __init__ ( self ) :
+        self.bits = []
+
+    def put ( self, n, value ) :
+        self.bits += [( value >> ( n - 1 - i ) ) & 1 for i in range ( n )]
+
+    def code ( self, lencode ) :
+        self.put ( *lencode )
+
+    def __len__ ( self ) :
+        return len ( self.bits )
+
+
+def psData ( part, band ) :
+    """IID and ICC index of a band in part 0, 1 or 2 of the stream."""
+    if part == 0 :
+        return 4, 0                                             # +10 dB to the left, correlated
+    if part == 1 :
+        return 0, 5                                             # Middle, no correlation
+    return round ( -7 + 14 * band / 19 ), band // 3 % 8         # Pan and correlation over the bands
+
+
+def ps ( part ) :
+    """ps_data() with a header, one envelope, IID and ICC in 20 bands, coded in frequency."""
+    b = Bits()
+    b.put ( 1, 1 )                                              # enable_ps_header
+    b.put ( 1, 1 ) ; b.put ( 3, 1 )                             # enable_iid, iid_mode 1: 20 bands
+    b.put ( 1, 1 ) ; b.put ( 3, 1 )                             # enable_icc, icc_mode 1: 20 bands
+    b.put ( 1, 0 )                                              # enable_ext
+    b.put ( 1, 0 ) ; b.put ( 2, 1 )                             # frame_class FIX, 1 envelope
+    for table, which, offset in ( ( IID_DF0, 0, 14 ), ( ICC_DF, 1, 7 ) ) :
+        b.put ( 1, 0 )                                          # iid_dt / icc_dt: in frequency
+        prev = 0
+        for band in range ( 20 ) :
+            val = psData ( part, band )[which]
+            b.code ( table[val - prev + offset] )
+            prev = val
+    return b
+
+
+def sbr ( frame, part ) :
+    """Fill element with the SBR extension of a mono frame."""
+    s = Bits()
+    s.put ( 1, 1 )                                              # bs_header_flag
+    s.put ( 1, 1 ) ; s.put ( 4, START_FREQ ) ; s.put ( 4, STOP_FREQ )   # amp_res, start, stop
+    s.put ( 3, 0 ) ; s.put ( 2, 0 ) ; s.put ( 1, 0 ) ; s.put ( 1, 0 )   # xover, reserved, no extra
+    s.put ( 1, 0 )                                              # bs_data_extra
+    s.put ( 2, 0 ) ; s.put ( 2, 0 ) ; s.put ( 1, 1 )            # FIXFIX, 1 envelope, high resolution
+    s.put ( 1, 0 ) ; s.put ( 1, 0 )                             # envelope and noise in frequency
+    for _ in range ( NQ ) :
+        s.put ( 2, 0 )                                          # bs_invf_mode
+    s.put ( 7, 30 + frame % 8 )                                 # envelope, 1.5 dB steps (1 envelope)
+    for _ in range ( NHIGH - 1 ) :
+        s.put ( 2, 0 )                                          # no change, "00" in f_huffman_env_1_5dB
+    s.put ( 5, 14 )                                             # noise floor
+    for _ in range ( NQ - 1 ) :
+        s.put ( 1, 0 )                                          # no change, "0" in f_huffman_env_3_0dB
+    s.put ( 1, 0 )                                              # bs_add_harmonic_flag
+    p = ps ( part )
+    size = ( 2 + len ( p ) + 7 ) // 8                           # Extension with its id, in bytes
+    s.put ( 1, 1 )                                              # bs_extended_data
+    if size < 15 :
+        s.put ( 4, size )
+    else :
+        s.put ( 4, 15 ) ; s.put ( 8, size - 15 )
+    s.put ( 2, 2 )                                              # EXTENSION_ID_PS
+    s.bits += p.bits + [0] * ( 8 * size - 2 - len ( p ) )
+    count = ( 4 + len ( s ) + 7 ) // 8                          # Fill element payload in bytes
+    f = Bits()
+    f.put ( 3, 6 )                                              # ID_FIL
+    if count < 15 :
+        f.put ( 4, count )
+    else :
+        f.put ( 4, 15 ) ; f.put ( 8, count - 14 )
+    f.put ( 4, 13 )                                             # EXT_SBR_DATA
+    f.bits += s.bits + [0] * ( 8 * count - 4 - len ( s ) )
+    return f.bits
+
+
+core = open ( sys.argv[1], "rb" ).read()
+out = bytearray()
+frames = []
+pos = 0
+while pos + 7 <= len ( core ) :
+    flen = ( ( core[pos+3] & 3 ) << 11 ) | ( core[pos+4] << 3 ) | ( core[pos+5] >> 5 )
+    frames.append ( core[pos:pos + flen] )
+    pos += flen
+for n, frame in enumerate ( frames ) :
+    assert frame[1] & 1, "ADTS with CRC"
+    bits = [( byte >> ( 7 - i ) ) & 1 for byte in frame[7:] for i in range ( 8 )]
+    end = len ( bits ) - bits[::-1].index ( 1 ) - 3             # END is the last "111"
+    assert bits[end:end+3] == [1, 1, 1]
+    bits = bits[:end] + sbr ( n, 3 * n // len ( frames ) ) + [1, 1, 1]
+    bits += [0] * ( -len ( bits ) % 8 )
+    data = bytes ( int ( "".join ( map ( str, bits[i:i+8] ) ), 2 ) for i in range ( 0, len ( bits ), 8 ) )
+    flen = 7 + len ( data )
+    hdr = bytearray ( frame[:7] )
+    hdr[3] = ( hdr[3] & 0xFC ) | ( flen >> 11 )
+    hdr[4] = ( flen >> 3 ) & 0xFF
+    hdr[5] = ( ( flen & 7 ) << 5 ) | ( hdr[5] & 0x1F )
+    out += hdr + data
+open ( sys.argv[2], "wb" ).write ( out )
+print ( sys.argv[2], len ( frames ), "frames" )
@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+# make_sync.py
+# Make the files of the sync test (test_sync.cpp) from the files made by make_corpus.sh.
+# Each file has data before the first real frame with "sync words" that look like frame headers:
+#  - single headers, and chains of two headers at the right distance (one confirmation),
+#  - in an ID3v2 tag with a picture (sync_id3_art.mp3) or just before the stream (sync_junk.*).
+# The first real frame is at the length of the added data, the decoded output must be the same
+# as that of the original file.
+import random
+import struct
+
+random.seed ( 2026 )
+
+
+def junk ( size, header, framelen ) :
+    """Random bytes with false headers, none of them followed by two more."""
+    buf = bytearray ( random.getrandbits ( 8 ) for _ in range ( size ) )
+    pos = 16
+    while pos + 97 + 2 * framelen + 16 < size :
+        buf[pos:pos + len ( header )] = header                  # Single false header
+        chain = pos + 97
+        buf[chain:chain + len ( header )] = header              # Chain of two
+        buf[chain + framelen:chain + framelen + len ( header )] = header
+        buf[chain + 2 * framelen] = 0x00                        # No third header
+        pos += framelen // 2 + 211
+    return bytes ( buf )
+
+
+def skipid3 ( data ) :
+    """The data after the ID3v2 tag."""
+    if data[:3] != b"ID3" :
+        return data
+    size = ( data[6] << 21 ) | ( data[7] << 14 ) | ( data[8] << 7 ) | data[9]
+    return data[10 + size:]
+
+
+def synchsafe ( n ) :
+    return bytes ( [( n >> 21 ) & 0x7F, ( n >> 14 ) & 0x7F, ( n >> 7 ) & 0x7F, n & 0x7F] )
+
+
+def adts ( framelen ) :
+    """ADTS header of an AAC LC stereo frame at 44.1 kHz."""
+    return bytes ( [0xFF, 0xF1, 0x50, 0x80 | ( framelen >> 11 ),
+                    ( framelen >> 3 ) & 0xFF, ( ( framelen & 7 ) << 5 ) | 0x1F, 0xFC] )
+
+
+mp3 = skipid3 ( open ( "mp3_44k_stereo.mp3", "rb" ).read() )
+aac = open ( "aac_44k_stereo.aac", "rb" ).read()
+mp3hdr = bytes ( [0xFF, 0xFB, 0x90, 0x44] )                     # MPEG-1 layer 3, 128 kbps, 44.1 kHz
+mp3len = 417
+
+# ID3v2.3 tag with an APIC frame ("image/jpeg", front cover) full of false headers
+pic = b"\x00image/jpeg\x00\x03\x00" + b"\xFF\xD8\xFF\xE0" + junk ( 3000, mp3hdr, mp3len )
+tag = b"APIC" + struct.pack ( ">I", len ( pic ) ) + b"\x00\x00" + pic
+tag = b"ID3\x03\x00\x00" + synchsafe ( len ( tag ) ) + tag
+open ( "sync_id3_art.mp3", "wb" ).write ( tag + mp3 )
+print ( "sync_id3_art.mp3", len ( tag ) )
+
+pre = junk ( 2000, mp3hdr, mp3len )
+open ( "sync_junk.mp3", "wb" ).write ( pre + mp3 )
+print ( "sync_junk.mp3", len ( pre ) )
+
+pre = junk ( 1500, adts ( 300 ), 300 )
+open ( "sync_junk.aac", "wb" ).write ( pre + aac )
+print ( "sync_junk.aac", len ( pre ) )
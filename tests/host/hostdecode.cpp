@@ -0,0 +1,302 @@
+// hostdecode.cpp
+// Decode a complete file of the corpus with the helix decoders.
+#include "hostdecode.h"
+#include "mp3_decoder.h"
+#include "aac_decoder.h"
+#include "vorbis_decoder.h"
+#include "flac_decoder.h"
+#include "wav_decoder.h"
+
+static int16_t outbuf[4096 * 2] ;                       // Max. output of one frame: HE-AAC stereo
+
+//**************************************************************************************************
+//                                       A D D F R A M E                                           *
+//**************************************************************************************************
+// Add the samples of a decoded frame to the result.                                               *
+//**************************************************************************************************
+static void addFrame ( decoded_t& d, int words, int rate, int channels )
+{
+  d.pcm.insert ( d.pcm.end(), outbuf, outbuf + words ) ;
+  d.rate = rate ;
+  d.channels = channels ;
+  d.frames++ ;
+}
+
+
+//**************************************************************************************************
+//                                       D E C O D E M P 3                                         *
+//**************************************************************************************************
+// Decode an MP3 stream, at half the sample rate if half is set.  After a decode error the next    *
+// frame is searched.                                                                              *
+//**************************************************************************************************
+static void decodeMp3 ( uint8_t* buf, int len, decoded_t& d, bool half )
+{
+  int      pos ;                                      // Position of the next frame
+  int      left ;                                     // Bytes left after decoding
+  int      n ;                                        // Result of MP3Decode
+  uint32_t t ;                                        // Start of decode
+
+  MP3Decoder_AllocateBuffers() ;
+  MP3SetHalfRate ( half ) ;
+  pos = d.sync = MP3FindSyncWord ( buf, len ) ;
+  while ( ( pos >= 0 ) && ( pos < len ) )
+  {
+    left = len - pos ;
+    t = ESP.getCycleCount() ;
+    n = MP3Decode ( buf + pos, &left, outbuf, 0 ) ;
+    d.cycles += ESP.getCycleCount() - t ;
+    pos = len - left ;
+    if ( n == ERR_MP3_NONE )
+    {
+      addFrame ( d, MP3GetOutputSamps(), MP3GetSampRate(), MP3GetChannels() ) ;
+    }
+    else if ( n == ERR_MP3_INDATA_UNDERFLOW )         // Incomplete frame at the end
+    {
+      break ;
+    }
+    else if ( n != ERR_MP3_MAINDATA_UNDERFLOW )       // Bit reservoir not filled is no error
+    {
+      d.errors++ ;
+      n = MP3FindSyncWord ( buf + pos + 1, len - pos - 1 ) ;
+      pos = ( n < 0 ) ? -1 : pos + 1 + n ;
+    }
+  }
+  MP3Decoder_FreeBuffers() ;
+}
+
+
+//**************************************************************************************************
+//                                       D E C O D E A A C                                         *
+//**************************************************************************************************
+// Decode an ADTS or LOAS stream, with SBR bypassed (core AAC at half the sample rate of HE-AAC)   *
+// if half is set.  After a decode error the next frame is searched.                               *
+//**************************************************************************************************
+static void decodeAac ( uint8_t* buf, int len, decoded_t& d, bool half )
+{
+  int      pos ;                                      // Position of the next frame
+  int      left ;                                     // Bytes left after decoding
+  int      n ;                                        // Result of AACDecode
+  uint32_t t ;                                        // Start of decode
+
+  AACSetSBRBypass ( half ) ;                          // Before the allocation of the SBR state
+  AACDecoder_AllocateBuffers() ;
+  pos = d.sync = AACFindSyncWord ( buf, len ) ;
+  while ( ( pos >= 0 ) && ( pos < len ) )
+  {
+    left = len - pos ;
+    t = ESP.getCycleCount() ;
+    n = AACDecode ( buf + pos, &left, outbuf ) ;
+    d.cycles += ESP.getCycleCount() - t ;
+    if ( n == ERR_AAC_NONE )
+    {
+      addFrame ( d, AACGetOutputSamps(), AACGetSampRate(), AACGetChannels() ) ;
+    }
+    else if ( n == ERR_AAC_INDATA_UNDERFLOW )         // LOAS frames before the first config
+    {                                                 // are skipped, else end of data
+      if ( len - left == pos )
+      {
+        break ;
+      }
+    }
+    else
+    {
+      d.errors++ ;
+      n = AACFindSyncWord ( buf + pos + 1, len - pos - 1 ) ;
+      left = ( n < 0 ) ? 0 : len - pos - 1 - n ;
+    }
+    pos = len - left ;
+  }
+  AACDecoder_FreeBuffers() ;
+}
+
+
+//**************************************************************************************************
+//                                    D E C O D E V O R B I S                                      *
+//**************************************************************************************************
+// Decode an Ogg Vorbis stream.  The decoder does its own framing, it gets the data in chunks of   *
+// "chunk" bytes and is called until it has used them.                                             *
+//**************************************************************************************************
+static void decodeVorbis ( uint8_t* buf, int len, decoded_t& d, int chunk )
+{
+  int      pos = 0 ;                                  // Start of the next chunk
+  int      end ;                                      // End of the chunk
+  int      left ;                                     // Bytes left after decoding
+  int      n ;                                        // Result of VorbisDecode
+  uint32_t t ;                                        // Start of decode
+
+  VorbisDecoder_AllocateBuffers() ;
+  d.sync = 0 ;
+  while ( pos < len )
+  {
+    end = ( chunk > 0 ) ? min ( len, pos + chunk ) : len ;
+    do
+    {
+      left = end - pos ;
+      t = ESP.getCycleCount() ;
+      n = VorbisDecode ( buf + pos, &left, outbuf ) ;
+      d.cycles += ESP.getCycleCount() - t ;
+      pos = end - left ;
+      if ( n == ERR_VORBIS_NONE )
+      {
+        addFrame ( d, VorbisGetOutputSamps(), VorbisGetSampRate(), VorbisGetChannels() ) ;
+      }
+      else if ( n != ERR_VORBIS_INDATA_UNDERFLOW )
+      {
+        d.errors++ ;
+      }
+    } while ( ( n != ERR_VORBIS_INDATA_UNDERFLOW ) && ( pos < end ) ) ;
+    pos = end ;
+  }
+  VorbisDecoder_FreeBuffers() ;
+}
+
+
+//**************************************************************************************************
+//                                      D E C O D E F L A C                                        *
+//**************************************************************************************************
+// Decode a native or Ogg FLAC stream, in chunks like decodeVorbis.  A decoded block is returned   *
+// in parts, each call with output counts as a frame.  At the end of the data the last frame of a  *
+// native stream is completed by FlacEndOfStream, like helixNextTrack does.                        *
+//**************************************************************************************************
+static void decodeFlac ( uint8_t* buf, int len, decoded_t& d, int chunk, bool ogg )
+{
+  int      pos = 0 ;                                  // Start of the next chunk
+  int      end ;                                      // End of the chunk
+  int      left ;                                     // Bytes left after decoding
+  int      n ;                                        // Result of FlacDecode
+  uint32_t t ;                                        // Start of decode
+
+  FlacDecoder_AllocateBuffers() ;
+  FlacSetOgg ( ogg ) ;
+  d.sync = 0 ;
+  for ( int last = 0 ; last < 2 ; last++ )            // Data, then the end of the stream
+  {
+    if ( last )
+    {
+      FlacEndOfStream() ;                             // Last frame is complete now
+    }
+    do
+    {
+      end = ( chunk > 0 ) ? min ( len, pos + chunk ) : len ;
+      do                                              // Until the chunk is used and
+      {                                               // all parts of a block are returned
+        left = end - pos ;
+        t = ESP.getCycleCount() ;
+        n = FlacDecode ( buf + pos, &left, outbuf ) ;
+        d.cycles += ESP.getCycleCount() - t ;
+        pos = end - left ;
+        if ( n == ERR_FLAC_NONE )
+        {
+          addFrame ( d, FlacGetOutputSamps(), FlacGetSampRate(), FlacGetChannels() ) ;
+        }
+        else if ( n != ERR_FLAC_INDATA_UNDERFLOW )
+        {
+          d.errors++ ;
+        }
+      } while ( n != ERR_FLAC_INDATA_UNDERFLOW ) ;
+      pos = end ;
+    } while ( pos < len ) ;
+  }
+  FlacDecoder_FreeBuffers() ;
+}
+
+
+//**************************************************************************************************
+//                                       D E C O D E W A V                                         *
+//**************************************************************************************************
+// Read a WAV stream in chunks, like playChunk the bytes not used (part of a sample frame) are     *
+// given again with the next chunk.                                                                *
+//**************************************************************************************************
+static void decodeWav ( uint8_t* buf, int len, decoded_t& d, int chunk )
+{
+  int      pos = 0 ;                                  // First byte not used
+  int      end = 0 ;                                  // End of the bytes received
+  int      left ;                                     // Bytes left after decoding
+  int      n ;                                        // Result of WavDecode
+  uint32_t t ;                                        // Start of decode
+
+  WavDecoder_AllocateBuffers() ;
+  d.sync = 0 ;
+  while ( end < len )
+  {
+    end = ( chunk > 0 ) ? min ( len, end + chunk ) : len ;
+    do                                                // Until the samples received are returned
+    {
+      left = end - pos ;
+      t = ESP.getCycleCount() ;
+      n = WavDecode ( buf + pos, &left, outbuf ) ;
+      d.cycles += ESP.getCycleCount() - t ;
+      pos = end - left ;
+      if ( n == ERR_WAV_NONE )
+      {
+        addFrame ( d, WavGetOutputSamps(), WavGetSampRate(), WavGetChannels() ) ;
+      }
+      else if ( n != ERR_WAV_INDATA_UNDERFLOW )
+      {
+        d.errors++ ;
+      }
+    } while ( n != ERR_WAV_INDATA_UNDERFLOW ) ;
+  }
+  WavDecoder_FreeBuffers() ;
+}
+
+
+//**************************************************************************************************
+//                                     D E C O D E B U F F E R                                     *
+//**************************************************************************************************
+// Decode a stream in memory.  codec is the extension of the file name: "mp3", "aac", "latm" (AAC  *
+// in LOAS), "ogg" (Vorbis), "flac", "oga" (Ogg FLAC) or "wav".                                    *
+// Ogg, FLAC and WAV are given to the decoder in chunks of "chunk" bytes, all at once if 0.        *
+// If half is set MP3 is decoded at half the sample rate and SBR of HE-AAC is bypassed.            *
+//**************************************************************************************************
+bool decodeBuffer ( const char* codec, uint8_t* buf, int len, decoded_t& d, int chunk, bool half )
+{
+  d.pcm.clear() ;
+  d.rate = d.channels = d.frames = d.errors = 0 ;
+  d.sync = -1 ;
+  d.cycles = 0 ;
+  if ( strcmp ( codec, "mp3" ) == 0 )
+  {
+    decodeMp3 ( buf, len, d, half ) ;
+  }
+  else if ( ( strcmp ( codec, "aac" ) == 0 ) || ( strcmp ( codec, "latm" ) == 0 ) )
+  {
+    decodeAac ( buf, len, d, half ) ;
+  }
+  else if ( strcmp ( codec, "ogg" ) == 0 )
+  {
+    decodeVorbis ( buf, len, d, chunk ) ;
+  }
+  else if ( ( strcmp ( codec, "flac" ) == 0 ) || ( strcmp ( codec, "oga" ) == 0 ) )
+  {
+    decodeFlac ( buf, len, d, chunk, codec[0] == 'o' ) ;
+  }
+  else if ( strcmp ( codec, "wav" ) == 0 )
+  {
+    decodeWav ( buf, len, d, chunk ) ;
+  }
+  else
+  {
+    printf ( "No decoder for %s\n", codec ) ;
+    return false ;
+  }
+  return true ;
+}
+
+
+//**************************************************************************************************
+//                                       D E C O D E F I L E                                       *
+//**************************************************************************************************
+// Decode a file of the corpus.                                                                    *
+//**************************************************************************************************
+bool decodeFile ( const std::string& name, decoded_t& d )
+{
+  std::vector<uint8_t> buf = readFile ( name ) ;
+  size_t               dot = name.rfind ( '.' ) ;
+
+  if ( buf.empty() || ( dot == std::string::npos ) )
+  {
+    return false ;
+  }
+  return decodeBuffer ( name.c_str() + dot + 1, buf.data(), buf.size(), d ) ;
+}
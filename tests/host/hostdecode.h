@@ -0,0 +1,21 @@
+// hostdecode.h
+// Decode a complete file of the corpus with the helix decoders, the way helixfuncs.h feeds them:
+// find the first frame, then decode frame by frame.  The codec follows from the extension.
+#pragma once
+
+#include "hosttest.h"
+
+struct decoded_t
+{
+  std::vector<int16_t> pcm ;                            // Interleaved samples
+  int                  rate ;                           // Sample rate of the last frame
+  int                  channels ;                       // Channels of the last frame
+  int                  frames ;                         // Number of frames (packets) decoded
+  int                  errors ;                         // Number of decode errors
+  int                  sync ;                           // Offset of the first frame
+  uint64_t             cycles ;                         // Time spent in the decoder
+} ;
+
+bool decodeBuffer ( const char* codec, uint8_t* buf, int len, decoded_t& d, int chunk = 0,
+                    bool half = false ) ;
+bool decodeFile ( const std::string& name, decoded_t& d ) ;
@@ -0,0 +1,105 @@
+// hosttest.h
+// Helpers for the host tests of the codecs.  Each test is a program that prints one line per
+// check and returns the number of failed checks, so ctest sees a failure as a non-zero exit code.
+// CORPUS is set by CMakeLists.txt to the directory with the test files.
+#pragma once
+
+#include "Arduino.h"
+#include <stdarg.h>
+#include <vector>
+#include <string>
+
+static int checks_failed = 0 ;                          // Number of failed checks
+
+//**************************************************************************************************
+//                                          C H E C K                                              *
+//**************************************************************************************************
+// Report the result of one check.  The format and arguments describe the measured values.        *
+//**************************************************************************************************
+#define CHECK(ok, ...)  check ( ( ok ), #ok, __VA_ARGS__ )
+
+inline bool check ( bool ok, const char* cond, const char* format, ... )
+{
+  va_list args ;
+
+  printf ( "%s ", ok ? "ok  " : "FAIL" ) ;
+  va_start ( args, format ) ;
+  vprintf ( format, args ) ;
+  va_end ( args ) ;
+  if ( ! ok )
+  {
+    printf ( "  [%s]", cond ) ;
+    checks_failed++ ;
+  }
+  printf ( "\n" ) ;
+  return ok ;
+}
+
+
+//**************************************************************************************************
+//                                       R E A D F I L E                                           *
+//**************************************************************************************************
+// Read a file of the corpus.  An empty vector is returned if the file cannot be read.             *
+//**************************************************************************************************
+inline std::vector<uint8_t> readFile ( const std::string& name )
+{
+  std::vector<uint8_t> buf ;
+  std::string          path = std::string ( CORPUS ) + "/" + name ;
+  FILE*                f = fopen ( path.c_str(), "rb" ) ;
+  uint8_t              tmp[4096] ;
+  size_t               n ;
+
+  if ( f == NULL )
+  {
+    printf ( "Cannot open %s\n", path.c_str() ) ;
+    return buf ;
+  }
+  while ( ( n = fread ( tmp, 1, sizeof(tmp), f ) ) > 0 )
+  {
+    buf.insert ( buf.end(), tmp, tmp + n ) ;
+  }
+  fclose ( f ) ;
+  return buf ;
+}
+
+
+//**************************************************************************************************
+//                                       P C M H A S H                                             *
+//**************************************************************************************************
+// FNV-1a hash of the samples, as little endian 16 bit words.  Used to see if the output of a     *
+// decoder is bit exact with the reference.                                                        *
+//**************************************************************************************************
+inline uint32_t pcmHash ( const std::vector<int16_t>& pcm )
+{
+  uint32_t h = 2166136261u ;                            // FNV offset basis
+
+  for ( size_t i = 0 ; i < pcm.size() ; i++ )
+  {
+    h = ( h ^ ( pcm[i] & 0xFF ) ) * 16777619u ;         // FNV prime
+    h = ( h ^ ( ( pcm[i] >> 8 ) & 0xFF ) ) * 16777619u ;
+  }
+  return h ;
+}
+
+
+//**************************************************************************************************
+//                                        P C M R M S                                              *
+//**************************************************************************************************
+// RMS level in dBFS of one channel, over "frames" frames.  The sum of the squares is divided by  *
+// the given number of frames, not by the number of frames in pcm.  So extra silence at the start *
+// or end (decoder delay) does not change the level.                                               *
+//**************************************************************************************************
+inline double pcmRms ( const std::vector<int16_t>& pcm, int channels, int ch, size_t frames )
+{
+  double sum = 0.0 ;
+
+  for ( size_t i = ch ; i < pcm.size() ; i += channels )
+  {
+    sum += (double)pcm[i] * pcm[i] ;
+  }
+  if ( sum == 0.0 )
+  {
+    return -200.0 ;                                     // Digital silence
+  }
+  return 10.0 * log10 ( sum / frames / ( 32768.0 * 32768.0 ) ) ;
+}
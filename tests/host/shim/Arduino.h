@@ -0,0 +1,44 @@
+// Arduino.h
+// Minimal replacement of the ESP32 Arduino core for building the codecs on a PC.
+// Only what lib/codecs/src uses is here: flash attributes, PSRAM allocation, logging and the
+// ESP object.  Everything is compiled in RAM and PSRAM is never "found".
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+using std::min ;
+using std::max ;
+
+#define PROGMEM
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define pgm_read_byte(a)        (*(const uint8_t*)(a))
+#define pgm_read_word(a)        (*(const uint16_t*)(a))
+#define pgm_read_dword(a)       (*(const uint32_t*)(a))
+
+#define log_printf(...)         printf ( __VA_ARGS__ )
+#define log_e(format, ...)      printf ( "E: " format "\n", ##__VA_ARGS__ )
+#define log_w(format, ...)      printf ( "W: " format "\n", ##__VA_ARGS__ )
+#define log_i(format, ...)      logNone ( format, ##__VA_ARGS__ )
+#define ESP_LOGE(tag, format, ...) printf ( "E: %s: " format "\n", tag, ##__VA_ARGS__ )
+#define ESP_LOGI(tag, format, ...) logNone ( format, ##__VA_ARGS__ )
+
+inline void logNone ( const char*, ... ) __attribute__ ( ( format ( printf, 1, 2 ) ) ) ;
+inline void logNone ( const char*, ... ) {}             // Info is not printed, format is checked
+
+#define ps_malloc               malloc
+#define ps_calloc               calloc
+inline bool psramFound() { return false ; }
+
+struct EspClass                                         // The ESP object, see host.cpp
+{
+  uint32_t getCycleCount() ;
+  uint32_t getCpuFreqMHz() { return 1000 ; }
+  uint32_t getFreeHeap()   { return 0 ; }
+} ;
+extern EspClass ESP ;
@@ -0,0 +1,113 @@
+// helixhost.cpp
+// Definitions for helixhost.h.  I2S output is collected in memory.  A queue is a deque with a
+// mutex, a task is a detached thread.  Queues are never deleted: a task may still wait on one at
+// the exit of the test.
+#include "helixhost.h"
+#include <time.h>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+struct queue_t                                          // A FreeRTOS queue
+{
+  std::mutex                        mtx ;
+  std::condition_variable           cv ;
+  std::deque<std::vector<uint8_t> > items ;
+  size_t                            n ;                 // Max. number of items
+  size_t                            size ;              // Size of an item
+} ;
+
+String               audio_ct ;
+bool                 muteflag ;
+std::vector<int16_t> i2s_out ;
+uint32_t             i2s_rate ;
+size_t               host_heap_free = 100000 ;
+size_t               host_heap_block = 100000 ;
+
+size_t        heap_caps_get_free_size ( int )                           { return host_heap_free ; }
+size_t        heap_caps_get_largest_free_block ( int )                  { return host_heap_block ; }
+void          pinMode ( int, int )                                      {}
+void          digitalWrite ( int, int )                                 {}
+void          i2sOutSetRate ( uint32_t rate )                           { i2s_rate = rate ; }
+void          i2sOutStart()                                             {}
+void          i2sOutStop()                                              {}
+void          i2sOutReport()                                            {}
+
+int64_t esp_timer_get_time()
+{
+  struct timespec ts ;
+
+  clock_gettime ( CLOCK_MONOTONIC, &ts ) ;
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000 ;
+}
+
+QueueHandle_t xQueueCreate ( int n, int size )
+{
+  queue_t* q = new queue_t ;
+
+  q->n = n ;
+  q->size = size ;
+  return q ;
+}
+
+int xQueueSend ( QueueHandle_t h, const void* item, uint32_t wait )
+{
+  queue_t*                     q = (queue_t*)h ;
+  std::unique_lock<std::mutex> lock ( q->mtx ) ;
+  const uint8_t*               p = (const uint8_t*)item ;
+
+  if ( ! q->cv.wait_for ( lock, std::chrono::milliseconds ( wait ),
+                          [q] { return q->items.size() < q->n ; } ) )
+  {
+    return 0 ;                                          // Still full
+  }
+  q->items.push_back ( std::vector<uint8_t> ( p, p + q->size ) ) ;
+  q->cv.notify_all() ;
+  return pdTRUE ;
+}
+
+int xQueueReceive ( QueueHandle_t h, void* item, uint32_t wait )
+{
+  queue_t*                     q = (queue_t*)h ;
+  std::unique_lock<std::mutex> lock ( q->mtx ) ;
+
+  if ( ! q->cv.wait_for ( lock, std::chrono::milliseconds ( wait ),
+                          [q] { return ! q->items.empty() ; } ) )
+  {
+    return 0 ;                                          // Still empty
+  }
+  memcpy ( item, q->items.front().data(), q->size ) ;
+  q->items.pop_front() ;
+  q->cv.notify_all() ;
+  return pdTRUE ;
+}
+
+int uxQueueMessagesWaiting ( QueueHandle_t h )
+{
+  queue_t*                    q = (queue_t*)h ;
+  std::lock_guard<std::mutex> lock ( q->mtx ) ;
+
+  return (int)q->items.size() ;
+}
+
+void vTaskDelay ( int ticks )
+{
+  std::this_thread::sleep_for ( std::chrono::milliseconds ( ticks * portTICK_PERIOD_MS ) ) ;
+}
+
+int xTaskCreatePinnedToCore ( void ( *task ) ( void* ), const char*, int, void* par, int,
+                              TaskHandle_t*, int )
+{
+  std::thread ( task, par ).detach() ;
+  return pdTRUE ;
+}
+
+bool i2sOutWrite ( const void* buf, size_t len )
+{
+  const int16_t* p = (const int16_t*)buf ;
+
+  i2s_out.insert ( i2s_out.end(), p, p + len / 2 ) ;
+  return true ;
+}
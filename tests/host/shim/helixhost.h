@@ -0,0 +1,64 @@
+// helixhost.h
+// What include/helixfuncs.h needs from main.cpp, FreeRTOS, the IDF and i2sfuncs.h, for tests of
+// the PCM processing (tone, loudness, drift) on a PC.  Include before helixfuncs.h.
+// The output of outputSample() is collected in i2s_out, see helixhost.cpp.  Queues are real and
+// a task is a thread, for tests of the dual core pipeline (HELIX_DUALCORE).
+#pragma once
+
+#include "Arduino.h"
+#include <string>
+#include <vector>
+#include "mp3_decoder.h"
+#include "aac_decoder.h"
+#include "vorbis_decoder.h"
+#include "oggopus_decoder.h"
+#include "flac_decoder.h"
+#include "wav_decoder.h"
+
+struct String                                           // The part of the Arduino String used
+{
+  std::string s ;
+  String ( const char* c = "" ) : s ( c ) {}
+  int         indexOf ( const char* x ) const { size_t p = s.find ( x ) ;
+                                                return ( p == std::string::npos ) ? -1 : (int)p ; }
+  const char* c_str() const { return s.c_str() ; }
+} ;
+
+typedef void* QueueHandle_t ;
+typedef void* TaskHandle_t ;
+typedef int   BaseType_t ;
+#define pdTRUE                  1
+#define portMAX_DELAY           0xFFFFFFFF
+#define portTICK_PERIOD_MS      1
+#define OUTPUT                  1
+#define HIGH                    1
+#define LOW                     0
+#define MALLOC_CAP_INTERNAL     1
+#define constrain(x,lo,hi)      ( (x) < (lo) ? (lo) : ( (x) > (hi) ? (hi) : (x) ) )
+#define map(x,a,b,c,d)          ( ( (x) - (a) ) * ( (d) - (c) ) / ( (b) - (a) ) + (c) )
+
+QueueHandle_t xQueueCreate ( int n, int size ) ;
+int           xQueueSend ( QueueHandle_t q, const void* item, uint32_t wait ) ;
+int           xQueueReceive ( QueueHandle_t q, void* item, uint32_t wait ) ;
+int           uxQueueMessagesWaiting ( QueueHandle_t q ) ;
+void          vTaskDelay ( int ticks ) ;
+int           xTaskCreatePinnedToCore ( void ( *task ) ( void* ), const char* name, int stack,
+                                        void* par, int prio, TaskHandle_t* handle, int core ) ;
+int64_t       esp_timer_get_time() ;
+size_t        heap_caps_get_free_size ( int caps ) ;        // Returns host_heap_free
+size_t        heap_caps_get_largest_free_block ( int caps ) ;   // Returns host_heap_block
+void          pinMode ( int pin, int mode ) ;
+void          digitalWrite ( int pin, int level ) ;
+
+bool          i2sOutWrite ( const void* buf, size_t len ) ;    // Appends to i2s_out
+void          i2sOutSetRate ( uint32_t rate ) ;
+void          i2sOutStart() ;
+void          i2sOutStop() ;
+void          i2sOutReport() ;
+
+extern String                audio_ct ;                 // Globals of main.cpp
+extern bool                  muteflag ;
+extern std::vector<int16_t>  i2s_out ;                  // Everything written to I2S
+extern uint32_t              i2s_rate ;                 // Last rate set
+extern size_t                host_heap_free ;           // Free heap, set by a test
+extern size_t                host_heap_block ;          // Largest free block, set by a test
@@ -0,0 +1,19 @@
+// host.cpp
+// The parts of the Arduino shim that need a definition.
+#include "Arduino.h"
+#include <time.h>
+
+EspClass ESP ;
+
+//**************************************************************************************************
+//                                  G E T C Y C L E C O U N T                                      *
+//**************************************************************************************************
+// The "cycles" on the host are nanoseconds of the monotonic clock, getCpuFreqMHz() is 1000.       *
+//**************************************************************************************************
+uint32_t EspClass::getCycleCount()
+{
+  struct timespec ts ;
+
+  clock_gettime ( CLOCK_MONOTONIC, &ts ) ;
+  return (uint32_t)( (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec ) ;
+}
@@ -0,0 +1,71 @@
+// test_decode.cpp
+// Decode every file of corpus/refs.txt and compare the output with the reference:
+//  - the hash of the PCM must be the same, the decoders are bit exact with the last accepted
+//    version.  A change of the output must be explained and the hash updated.
+//  - the RMS level of each channel must be within RMS_TOL dB of the level of the same file
+//    decoded by FFmpeg, so the hash is not just a record of a wrong output.
+// With "-p" the values of this decoder are printed in the format of refs.txt.
+#include "hostdecode.h"
+
+#define RMS_TOL  0.05                                 // Max. difference of the level in dB
+
+//**************************************************************************************************
+//                                             M A I N                                             *
+//**************************************************************************************************
+int main ( int argc, char* argv[] )
+{
+  FILE*       f ;                                     // refs.txt
+  char        line[256] ;                             // One line of refs.txt
+  char        name[64] ;                              // File name in refs.txt
+  int         rate, channels ;                        // Reference format
+  unsigned    frames ;                                // Length of the reference output
+  unsigned    hash ;                                  // Reference hash
+  double      rms[2] ;                                // Reference levels
+  int         n ;                                     // Number of fields
+  decoded_t   d ;                                     // Result of decoding
+  bool        print = ( argc > 1 ) && ( strcmp ( argv[1], "-p" ) == 0 ) ;
+  std::string path = std::string ( CORPUS ) + "/refs.txt" ;
+
+  if ( ( f = fopen ( path.c_str(), "r" ) ) == NULL )
+  {
+    printf ( "Cannot open %s\n", path.c_str() ) ;
+    return 1 ;
+  }
+  while ( fgets ( line, sizeof(line), f ) )
+  {
+    n = sscanf ( line, "%63s %d %d %u %x %lf %lf", name, &rate, &channels, &frames,
+                 &hash, &rms[0], &rms[1] ) ;
+    if ( ( n < 6 ) || ( name[0] == '#' ) )
+    {
+      continue ;                                      // Comment or empty line
+    }
+    if ( ! decodeFile ( name, d ) )
+    {
+      CHECK ( false, "%s: cannot decode", name ) ;
+      continue ;
+    }
+    if ( print )
+    {
+      printf ( "%-24s %5d %d %7u %08x", name, d.rate, d.channels, frames, pcmHash ( d.pcm ) ) ;
+      for ( int ch = 0 ; ch < d.channels ; ch++ )
+      {
+        printf ( " %8.3f", pcmRms ( d.pcm, d.channels, ch, frames ) ) ;
+      }
+      printf ( "\n" ) ;
+      continue ;
+    }
+    CHECK ( ( d.rate == rate ) && ( d.channels == channels ) && ( d.errors == 0 ),
+            "%s: %d Hz, %d channels, %d frames, %d errors", name, d.rate, d.channels,
+            d.frames, d.errors ) ;
+    CHECK ( pcmHash ( d.pcm ) == hash, "%s: hash %08x, reference %08x", name,
+            pcmHash ( d.pcm ), hash ) ;
+    for ( int ch = 0 ; ( ch < channels ) && ( ch < n - 5 ) ; ch++ )
+    {
+      double level = pcmRms ( d.pcm, d.channels, ch, frames ) ;
+      CHECK ( fabs ( level - rms[ch] ) <= RMS_TOL, "%s: channel %d level %.3f dB, reference %.3f dB",
+              name, ch, level, rms[ch] ) ;
+    }
+  }
+  fclose ( f ) ;
+  return checks_failed ;
+}
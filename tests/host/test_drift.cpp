@@ -0,0 +1,210 @@
+// test_drift.cpp
+// Test of the clock drift compensation: driftControl (driftfuncs.h) and the frame slip of the
+// Helix output (helixSlip, outputFrames and outputBlock of helixfuncs.h).
+//  - outputFrames drops or inserts one frame for every block size and never reads a frame after
+//    the end of the block.  The frames after the block hold a value that must not show up.
+//  - A rate trim of player_AdjustRate drops or inserts the right number of frames.
+//  - Closed loop: a sender with a clock that is off by up to 250 ppm fills the stream queue, with
+//    network jitter.  The player takes frames at its own clock with the slip of helixSlip.  The
+//    queue must never run empty or overflow, and the drift estimate must reach the real drift.
+#include "hosttest.h"
+#include "helixhost.h"
+#include "helixfuncs.h"
+#include "driftfuncs.h"
+
+#define PAD        -32768                             // Padding to flush i2sbuf, not in the tests
+#define FENCE      30000                              // Value of the frames after a block
+#define RATE       44100                              // Frames per second
+#define KBPS       128                                // Bitrate of the simulated stream
+#define QSIZ       400                                // Queue of main.cpp: 400 chunks of 32 bytes
+#define CHUNK      32
+#define JITTER     0.2                                // Max. network delay in seconds
+#define HOURS      12                                 // Length of a closed loop simulation
+#define EST_TOL    5.0                                // Max. error of the drift estimate in ppm
+
+
+//**************************************************************************************************
+//                                          F L U S H                                              *
+//**************************************************************************************************
+// Get all samples out of i2sbuf, return the samples written since i2s_out had "start" samples.    *
+//**************************************************************************************************
+static std::vector<int16_t> flush ( size_t start )
+{
+  size_t n = i2s_out.size() ;
+
+  while ( i2s_out.size() == n )                       // Pad until the buffer is sent
+  {
+    outputSample ( PAD ) ;
+  }
+  while ( i2s_out.back() == PAD )                     // Remove the padding
+  {
+    i2s_out.pop_back() ;
+  }
+  std::vector<int16_t> res ( i2s_out.begin() + start, i2s_out.end() ) ;
+  i2s_out.clear() ;
+  return res ;
+}
+
+
+//**************************************************************************************************
+//                                       S L I P T E S T                                           *
+//**************************************************************************************************
+// One block of a ramp through outputFrames with slip.  Returns true if the output has the right   *
+// number of frames, is stereo, and only has values of the block.                                 *
+//**************************************************************************************************
+static bool slipTest ( int frames, bool mono, int slip )
+{
+  int                  ch = mono ? 1 : 2 ;
+  std::vector<int16_t> buf ( ( frames + 2 ) * ch, FENCE ) ;
+  int                  expect = frames ;              // Number of output frames
+  bool                 ok ;
+
+  for ( int f = 0 ; f < frames ; f++ )
+  {
+    for ( int c = 0 ; c < ch ; c++ )
+    {
+      buf[f*ch+c] = ( c ? -20 : 20 ) * ( f + 1 ) ;   // Right channel is negative
+    }
+  }
+  if ( frames > 1 )                                   // Slip needs 2 frames
+  {
+    expect -= slip ;
+  }
+  outputFrames ( buf.data(), frames, mono, slip ) ;
+  std::vector<int16_t> out = flush ( 0 ) ;
+  ok = ( (int)out.size() == 2 * expect ) ;
+  for ( size_t i = 0 ; ok && ( i < out.size() ) ; i += 2 )
+  {
+    int l = out[i] ;
+    int r = mono ? -out[i+1] : out[i+1] ;             // Mono: right equals left
+    ok = ( l >= 20 ) && ( l <= 20 * frames ) && ( r <= -20 ) && ( r >= -20 * frames ) ;
+    ok = ok && ( i == 0 || l >= out[i-2] ) ;          // Still a ramp
+  }
+  return ok ;
+}
+
+
+//**************************************************************************************************
+//                                       T R I M T E S T                                           *
+//**************************************************************************************************
+// Send "secs" seconds of stereo frames in blocks of "block" frames through outputBlock with a     *
+// trim of ppm.  Returns the number of output frames minus the number of input frames.            *
+//**************************************************************************************************
+static long trimTest ( int ppm, int block, int secs )
+{
+  std::vector<int16_t> buf ( 2 * block, 1000 ) ;
+  long                 in = 0 ;
+  long                 out = 0 ;
+
+  slip_acc = 0 ;
+  player_AdjustRate ( 2 * ppm ) ;
+  for ( ; in < (long)secs * RATE ; in += block )
+  {
+    outputBlock ( buf.data(), 2 * block, false ) ;
+    out += i2s_out.size() / 2 ;                       // Count and forget the output
+    i2s_out.clear() ;
+  }
+  out += flush ( 0 ).size() / 2 ;
+  player_AdjustRate ( 0 ) ;
+  return out - in ;
+}
+
+
+//**************************************************************************************************
+//                                       S I M U L A T E                                           *
+//**************************************************************************************************
+// Closed loop with a sender that is "ppm" faster than the player, for HOURS hours.  Every second  *
+// the sender adds its frames, delayed by a random network delay, the player takes RATE frames     *
+// plus the slip and driftControl sees the queue.  Returns the number of seconds the queue was     *
+// empty or full, the worst fill and the drift estimate at the end.                               *
+//**************************************************************************************************
+static int simulate ( double ppm, double& lo, double& hi, float& est )
+{
+  const double bpf = KBPS * 1000.0 / 8 / RATE ;       // Bytes per frame
+  const double qbytes = QSIZ * CHUNK ;                // Size of the queue
+  double       sent = qbytes / 2 ;                    // Bytes sent, starts with a half full queue
+  double       arrived = sent ;                       // Bytes that have arrived
+  double       played = 0.0 ;                         // Bytes taken by the player
+  uint32_t     seed = 2026 ;
+  int          bad = 0 ;
+
+  driftSetMode ( true ) ;
+  slip_acc = 0 ;
+  lo = qbytes ;
+  hi = 0.0 ;
+  for ( long t = 0 ; t < HOURS * 3600L ; t++ )
+  {
+    long   frames = 0 ;                               // Input frames used by the player
+    double q ;                                        // Bytes in the queue
+
+    sent += RATE * ( 1.0 + ppm * 1e-6 ) * bpf ;       // Sender clock
+    seed = seed * 1664525 + 1013904223 ;
+    arrived = max ( arrived, sent - RATE * bpf * JITTER * ( seed >> 8 ) / 16777216.0 ) ;
+    for ( int out = 0 ; out < RATE ; out += 1152 )    // Player clock: RATE output frames
+    {
+      int n = min ( 1152, RATE - out ) ;
+      frames += n + helixSlip ( n ) ;                 // A dropped frame is one more input frame
+    }
+    played += frames * bpf ;
+    q = arrived - played ;
+    if ( ( q < 0.0 ) || ( q > qbytes ) )              // Underrun or overflow?
+    {
+      bad++ ;
+      q = max ( 0.0, min ( qbytes, q ) ) ;            // Yes, stall or drop packets
+      played = arrived - q ;
+    }
+    if ( t > DRIFT_SETTLE )
+    {
+      lo = min ( lo, q ) ;
+      hi = max ( hi, q ) ;
+    }
+    driftControl ( true, (int)( q / CHUNK ), QSIZ, CHUNK, KBPS ) ;
+  }
+  est = drift.integ ;
+  lo = lo / bpf / RATE ;                              // In seconds of audio
+  hi = hi / bpf / RATE ;
+  return bad ;
+}
+
+
+//**************************************************************************************************
+//                                             M A I N                                             *
+//**************************************************************************************************
+int main()
+{
+  static const int    blocks[] = { 1, 2, 3, 4, 5, 1152 } ;
+  static const double drifts[] = { -250, -100, -20, 0, 20, 100, 250 } ;
+
+  player_setVolume ( 100 ) ;                          // Output gain 1
+  for ( int frames : blocks )
+  {
+    for ( int mono = 0 ; mono < 2 ; mono++ )
+    {
+      bool ok = slipTest ( frames, mono, 0 ) ;
+      bool drop = slipTest ( frames, mono, 1 ) ;
+      bool ins = slipTest ( frames, mono, -1 ) ;
+      CHECK ( ok && drop && ins, "%4d frames %s: no slip %s, drop %s, insert %s", frames,
+              mono ? "mono  " : "stereo", ok ? "ok" : "BAD", drop ? "ok" : "BAD", ins ? "ok" : "BAD" ) ;
+    }
+  }
+  for ( int ppm : { 300, -300, 50 } )
+  {
+    for ( int block : { 2, 1152 } )
+    {
+      long d = trimTest ( ppm, block, 10 ) ;
+      long e = -(long)ppm * 10 * RATE / 1000000 ;     // Positive trim is faster: drop frames
+      CHECK ( labs ( d - e ) <= 1, "trim %+4d ppm, blocks of %4d: %+ld frames in 10 s, expected %+ld",
+              ppm, block, d, e ) ;
+    }
+  }
+  for ( double ppm : drifts )
+  {
+    double lo, hi ;
+    float  est ;
+    int    bad = simulate ( ppm, lo, hi, est ) ;
+    CHECK ( ( bad == 0 ) && ( fabs ( est - ppm ) <= EST_TOL ),
+            "sender %+4.0f ppm: queue %.2f..%.2f s of %.2f s, %d s empty or full, estimate %+.1f ppm",
+            ppm, lo, hi, QSIZ * CHUNK * 8.0 / KBPS / 1000, bad, est ) ;
+  }
+  return checks_failed ;
+}
@@ -0,0 +1,60 @@
+// test_flac.cpp
+// Test of the FLAC decoder (flac_decoder.cpp) with the FLAC files of corpus/refs.txt: native FLAC
+// (.flac) and Ogg FLAC (.oga), with 16 and 24 bits, mono and stereo, see make_corpus.sh.
+//  - The output must be bit exact.  FLAC is lossless and more than 16 bits are shifted down, so
+//    the hash of refs.txt is also that of the output of FFmpeg with 16 bits.
+//  - The same output for every size of the pieces the stream comes in: one byte, the chunks of 32
+//    bytes of playChunk, a block of the SD card and the whole file at once.
+//  - The sample rate, the channels and the number of frames of FFmpeg, without errors.
+// The decode time on the host is printed.
+#include "hostdecode.h"
+
+static const int chunks[] = { 0, 1, 7, 32, 512 } ;    // Sizes of the pieces, 0 is all at once
+
+
+//**************************************************************************************************
+//                                             M A I N                                             *
+//**************************************************************************************************
+int main()
+{
+  std::string path = std::string ( CORPUS ) + "/refs.txt" ;
+  FILE*       f = fopen ( path.c_str(), "r" ) ;
+  char        line[256] ;                             // One line of refs.txt
+  char        name[64] ;                              // File name in refs.txt
+  int         rate, channels ;                        // Reference format
+  unsigned    frames ;                                // Length of the reference output
+  unsigned    hash ;                                  // Reference hash
+  decoded_t   d ;                                     // Result of decoding
+  int         files = 0 ;                             // FLAC files tested
+
+  if ( f == NULL )
+  {
+    printf ( "Cannot open %s\n", path.c_str() ) ;
+    return 1 ;
+  }
+  while ( fgets ( line, sizeof(line), f ) )
+  {
+    if ( ( sscanf ( line, "%63s %d %d %u %x", name, &rate, &channels, &frames, &hash ) != 5 ) ||
+         ( strncmp ( name, "flac_", 5 ) != 0 ) )
+    {
+      continue ;                                      // Comment or other codec
+    }
+    std::vector<uint8_t> buf = readFile ( name ) ;
+    const char*          ext = strrchr ( name, '.' ) + 1 ;
+    for ( int chunk : chunks )
+    {
+      decodeBuffer ( ext, buf.data(), buf.size(), d, chunk ) ;
+      CHECK ( ( d.rate == rate ) && ( d.channels == channels ) && ( d.errors == 0 ) &&
+              ( d.pcm.size() == (size_t)frames * channels ) && ( pcmHash ( d.pcm ) == hash ),
+              "%s in pieces of %d bytes: %d Hz, %d channels, %d frames, %d errors, hash %08x, "
+              "reference %08x", name, chunk ? chunk : (int)buf.size(), d.rate, d.channels,
+              (int)d.pcm.size() / max ( d.channels, 1 ), d.errors, pcmHash ( d.pcm ), hash ) ;
+    }
+    printf ( "info: %s %.0f times real time on the host\n", name,
+             frames * 1e9 / rate / max ( d.cycles, (uint64_t)1 ) ) ;
+    files++ ;
+  }
+  fclose ( f ) ;
+  CHECK ( files == 4, "%d FLAC files in refs.txt", files ) ;
+  return checks_failed ;
+}
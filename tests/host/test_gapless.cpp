@@ -0,0 +1,139 @@
+// test_gapless.cpp
+// Test of gapless playback of MP3 tracks (helixParseXing, helixTrim and helixNextTrack of
+// helixfuncs.h).  gapless_a.mp3 and gapless_b.mp3 are the signal of mp3_44k_stereo.mp3, split at
+// frame SPLIT and encoded apart, see make_corpus.sh.  Both tracks are sent through playChunk in
+// chunks of 32 bytes like sdfuncs does, with helixNextTrack between them.  The output must match
+// the output of the unsplit file:
+//  - The same number of frames: the length of the signal, without encoder delay and padding.
+//  - No shift: the best match of each track with the unsplit output is at lag 0.
+//  - The same samples, apart from the coding noise.  Also around the split.
+// The same at half rate (8 bit DAC), where the trim is done on the decimated output.
+#include "hosttest.h"
+#include "helixhost.h"
+#include "helixfuncs.h"
+
+#define PAD        -32768                             // Padding to flush i2sbuf
+#define LENGTH     66150                              // Frames in the signal, 1.5 s at 44.1 kHz
+#define SPLIT      30000                              // First frame of gapless_b.mp3
+#define MAXLAG     1200                               // Largest shift searched, > encoder delay
+#define MIN_SNR    15.0                               // Min. SNR of split against unsplit in dB
+
+
+//**************************************************************************************************
+//                                           P L A Y                                               *
+//**************************************************************************************************
+// Play files from the corpus as tracks on the SD card, return all output.  helixNextTrack is also *
+// called after the last track, so the frames left in the buffer are played.                       *
+//**************************************************************************************************
+static std::vector<int16_t> play ( const std::vector<std::string>& names, bool half )
+{
+  uint8_t chunk[32] ;
+  size_t  n ;
+
+  i2s_out.clear() ;
+  audio_ct = "audio/mpeg" ;
+  helixSetHalfRate ( half ) ;
+  helixInit ( -1, -1 ) ;
+  for ( const std::string& name : names )
+  {
+    std::vector<uint8_t> buf = readFile ( name ) ;
+    for ( size_t i = 0 ; i < buf.size() ; i += 32 )
+    {
+      n = min ( (size_t)32, buf.size() - i ) ;
+      memset ( chunk, 0, sizeof(chunk) ) ;            // Last chunk is padded with zeroes
+      memcpy ( chunk, &buf[i], n ) ;
+      playChunk ( chunk ) ;
+    }
+    helixNextTrack() ;                                // QNEXTSONG after the data of the file
+  }
+  n = i2s_out.size() ;
+  while ( i2s_out.size() == n )                       // Pad until i2sbuf is sent
+  {
+    outputSample ( PAD ) ;
+  }
+  while ( i2s_out.back() == PAD )                     // Remove the padding
+  {
+    i2s_out.pop_back() ;
+  }
+  return i2s_out ;
+}
+
+
+//**************************************************************************************************
+//                                        B E S T L A G                                            *
+//**************************************************************************************************
+// Shift of frames [from, to> of a (left channel) against b with the highest correlation.          *
+//**************************************************************************************************
+static int bestLag ( const std::vector<int16_t>& a, const std::vector<int16_t>& b, int from, int to )
+{
+  int    best = 0 ;
+  double bestsum = -1e300 ;
+
+  for ( int lag = -MAXLAG ; lag <= MAXLAG ; lag++ )
+  {
+    double sum = 0.0 ;
+    for ( int i = max ( from, -lag ) ; i < to && ( i + lag ) < (int)b.size() / 2 ; i++ )
+    {
+      sum += (double)a[2*i] * b[2*(i+lag)] ;
+    }
+    if ( sum > bestsum )
+    {
+      bestsum = sum ;
+      best = lag ;
+    }
+  }
+  return best ;
+}
+
+
+//**************************************************************************************************
+//                                            S N R                                                *
+//**************************************************************************************************
+// Signal to noise ratio in dB of a against reference b over frames [from, to>, both channels.     *
+//**************************************************************************************************
+static double snr ( const std::vector<int16_t>& a, const std::vector<int16_t>& b, int from, int to )
+{
+  double s = 0.0, e = 0.0 ;
+
+  for ( int i = 2 * from ; i < 2 * to ; i++ )
+  {
+    s += (double)b[i] * b[i] ;
+    e += (double)( a[i] - b[i] ) * ( a[i] - b[i] ) ;
+  }
+  return 10.0 * log10 ( s / ( e + 1.0 ) ) ;
+}
+
+
+//**************************************************************************************************
+//                                             M A I N                                             *
+//**************************************************************************************************
+int main()
+{
+  player_setVolume ( 100 ) ;                          // Output gain 1
+  for ( int half = 0 ; half < 2 ; half++ )
+  {
+    const char*          hr = half ? "half rate" : "full rate" ;
+    int                  len = LENGTH >> half ;       // Expected length
+    int                  split = SPLIT >> half ;
+    std::vector<int16_t> whole = play ( { "mp3_44k_stereo.mp3" }, half ) ;
+    std::vector<int16_t> parts = play ( { "gapless_a.mp3", "gapless_b.mp3" }, half ) ;
+    int                  la, lb ;                     // Shift of both tracks
+
+    CHECK ( ( (int)whole.size() == 2 * len ) && ( (int)parts.size() == 2 * len ),
+            "%s: %d frames unsplit, %d split, expected %d", hr,
+            (int)whole.size() / 2, (int)parts.size() / 2, len ) ;
+    if ( ( (int)whole.size() != 2 * len ) || ( (int)parts.size() != 2 * len ) )
+    {
+      continue ;
+    }
+    la = bestLag ( parts, whole, 0, split ) ;
+    lb = bestLag ( parts, whole, split, len ) ;
+    CHECK ( ( la == 0 ) && ( lb == 0 ), "%s: shift of first track %d, of second track %d frames",
+            hr, la, lb ) ;
+    double all = snr ( parts, whole, 0, len ) ;
+    double edge = snr ( parts, whole, split - 1024, split + 1024 ) ;
+    CHECK ( ( all >= MIN_SNR ) && ( edge >= MIN_SNR ),
+            "%s: split against unsplit %.1f dB SNR, %.1f dB around the split", hr, all, edge ) ;
+  }
+  return checks_failed ;
+}
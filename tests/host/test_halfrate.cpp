@@ -0,0 +1,95 @@
+// test_halfrate.cpp
+// Test of MP3 decoding at half the sample rate (MP3SetHalfRate of mp3_decoder.cpp) with
+// mp3_44k_stereo.mp3.  The reference is the output at the full rate, low pass filtered at a
+// quarter of the sample rate and decimated: sample j of the half rate output is sample 2 * j.
+//  - Half the sample rate and half the samples of the full rate, the same channels, no errors.
+//  - The difference with the reference is at least MIN_SNR dB below the signal.  The half rate
+//    output has no subbands above a quarter of the rate, the rest of the difference is the
+//    transition band of the filter bank of MP3 against that of the reference filter.
+// The decode time at both rates is printed.
+#include "hostdecode.h"
+
+#define MP3FILE    "mp3_44k_stereo.mp3"
+#define TAPS       128                                // Half the length of the reference filter
+#define MIN_SNR    35.0                               // Min. signal to difference ratio in dB
+
+
+//**************************************************************************************************
+//                                       D E C I M A T E                                           *
+//**************************************************************************************************
+// Low pass filter stereo samples at a quarter of the sample rate (windowed sinc, Blackman window) *
+// and keep every other frame, starting with frame "phase".                                        *
+//**************************************************************************************************
+static std::vector<double> decimate ( const std::vector<int16_t>& x, int phase )
+{
+  std::vector<double> h ( 2 * TAPS + 1 ) ;
+  std::vector<double> y ;
+  int                 n = x.size() / 2 ;              // Frames
+  double              t, w ;
+
+  for ( int k = -TAPS ; k <= TAPS ; k++ )
+  {
+    t = k * M_PI / 2.0 ;                              // Cut off at fs / 4
+    w = 0.42 + 0.5 * cos ( M_PI * k / TAPS ) + 0.08 * cos ( 2.0 * M_PI * k / TAPS ) ;
+    h[k + TAPS] = w * ( ( k == 0 ) ? 0.5 : sin ( t ) / ( M_PI * k ) ) ;
+  }
+  for ( int i = phase ; i < n ; i += 2 )
+  {
+    for ( int ch = 0 ; ch < 2 ; ch++ )
+    {
+      double s = 0.0 ;
+      for ( int k = max ( -TAPS, i - n + 1 ) ; k <= min ( TAPS, i ) ; k++ )
+      {
+        s += h[k + TAPS] * x[2 * ( i - k ) + ch] ;
+      }
+      y.push_back ( s ) ;
+    }
+  }
+  return y ;
+}
+
+
+//**************************************************************************************************
+//                                             S N R                                               *
+//**************************************************************************************************
+// Ratio of signal and difference in dB.  TAPS frames at both ends are not counted.                *
+//**************************************************************************************************
+static double snr ( const std::vector<int16_t>& x, const std::vector<double>& ref )
+{
+  double sig = 0.0 ;
+  double err = 0.0 ;
+  size_t n = min ( x.size(), ref.size() ) ;
+
+  for ( size_t i = 2 * TAPS ; i + 2 * TAPS < n ; i++ )
+  {
+    sig += ref[i] * ref[i] ;
+    err += ( x[i] - ref[i] ) * ( x[i] - ref[i] ) ;
+  }
+  return 10.0 * log10 ( sig / max ( err, 1e-9 ) ) ;
+}
+
+
+//**************************************************************************************************
+//                                             M A I N                                             *
+//**************************************************************************************************
+int main()
+{
+  std::vector<uint8_t> buf = readFile ( MP3FILE ) ;
+  decoded_t            full, half ;
+  double               s0, s1 ;
+
+  decodeBuffer ( "mp3", buf.data(), buf.size(), full ) ;
+  decodeBuffer ( "mp3", buf.data(), buf.size(), half, 0, true ) ;
+  CHECK ( ( half.rate * 2 == full.rate ) && ( half.channels == 2 ) && ( full.channels == 2 ) &&
+          ( half.errors == 0 ) && ( half.frames == full.frames ) &&
+          ( half.pcm.size() * 2 == full.pcm.size() ), "%s half rate: %d Hz, %d samples, full "
+          "rate %d Hz, %d samples", MP3FILE, half.rate, (int)half.pcm.size(), full.rate,
+          (int)full.pcm.size() ) ;
+  s0 = snr ( half.pcm, decimate ( full.pcm, 0 ) ) ;
+  s1 = snr ( half.pcm, decimate ( full.pcm, 1 ) ) ;
+  CHECK ( ( s0 >= MIN_SNR ) && ( s0 > s1 ), "%s half rate: %.1f dB from the decimated full rate, "
+          "%.1f dB with the odd frames", MP3FILE, s0, s1 ) ;
+  printf ( "info: decode time full rate %.0f ns/frame, half rate %.0f ns/frame\n",
+           (double)full.cycles / full.frames, (double)half.cycles / half.frames ) ;
+  return checks_failed ;
+}
@@ -0,0 +1,171 @@
+// test_huffman.cpp
+// Test of DecodeHuffmanPairs (MP3 big values) with the first level lookup table huffFast against a
+// plain walk of huffTable, one bit at a time.  Random bitstreams are decoded with every table, at
+// every bit offset, with enough and with too few bits.  If the bits hold all values, the decoder
+// must give the same values and bit count as the reference.  If not, it is not checked: like the
+// original helix code (809d9fb gives the same results), the decoder may decode the last pairs from
+// the zero padding after the end instead of returning -1.  DecodeHuffman checks the bit count.
+// The tables are static in mp3_decoder.cpp, so this test compiles its own copy of that file (and
+// mp3_decoder.h) in a namespace.  The headers it includes are included before, outside of it.
+#include "hosttest.h"
+#include "assert.h"
+#include "codec_arena.h"
+#include "helix_placement.h"
+
+namespace helix
+{
+  #include "mp3_decoder.cpp"
+}
+
+#define CALLS   5000                                  // Random calls per table
+#define MAXVALS 576                                   // Max. number of values in one call
+
+using helix::huffTable ;
+using helix::huffTabOffset ;
+using helix::huffTabLookup ;
+
+struct bits_t                                         // Bit reader of the reference
+{
+  const uint8_t* buf ;                                // Start of the data
+  int            pos ;                                // Bit position in buf
+  int            end ;                                // First bit after the data
+} ;
+
+
+//**************************************************************************************************
+//                                          G E T B I T S                                          *
+//**************************************************************************************************
+// Read n bits MSB first.  Bits after the end of the stream read as 0, like the padding of the     *
+// decoder, the caller checks the position against the end.                                        *
+//**************************************************************************************************
+static int getBits ( bits_t& b, int n )
+{
+  int v = 0 ;
+
+  while ( n-- )
+  {
+    v <<= 1 ;
+    if ( b.pos < b.end )
+    {
+      v |= ( b.buf[b.pos >> 3] >> ( 7 - ( b.pos & 7 ) ) ) & 1 ;
+    }
+    b.pos++ ;
+  }
+  return v ;
+}
+
+
+//**************************************************************************************************
+//                                        R E F P A I R S                                          *
+//**************************************************************************************************
+// Reference for DecodeHuffmanPairs: walk the levels of the table with the bits of the stream,     *
+// then read the linbits and the sign bits.  Values are sign and magnitude, sign in bit 31.        *
+// Returns the number of bits used, -1 if the stream ends before the last pair is complete.        *
+//**************************************************************************************************
+static int refPairs ( int* xy, int nVals, int tabIdx, int bitsLeft, const uint8_t* buf, int bitOffset )
+{
+  bits_t          b = { buf, bitOffset, bitOffset + bitsLeft } ;
+  int             linBits = huffTabLookup[tabIdx].linBits ;
+  int             tabType = huffTabLookup[tabIdx].tabType ;
+  const uint16_t* tBase = huffTable + huffTabOffset[tabIdx] ;
+
+  for ( int i = 0 ; i < nVals ; i += 2 )
+  {
+    const uint16_t* level = tBase ;                   // Start of the current level
+    uint16_t        cw ;                              // Code word entry
+    int             v[2] ;                            // x and y
+    int             m ;                               // Index bits of a level
+
+    if ( tabType == helix::noBits )
+    {
+      xy[i] = xy[i+1] = 0 ;
+      continue ;
+    }
+    while ( true )
+    {
+      m = level[0] & 0x0f ;
+      cw = level[1 + getBits ( b, m )] ;
+      b.pos -= m ;                                    // Code may be shorter than the index
+      if ( cw >> 12 )                                 // Code word complete?
+      {
+        b.pos += cw >> 12 ;                           // Yes, skip its bits
+        break ;
+      }
+      b.pos += m ;                                    // No, jump to next level
+      level += cw ;
+    }
+    v[0] = ( cw >> 4 ) & 0x0f ;
+    v[1] = ( cw >> 8 ) & 0x0f ;
+    for ( int k = 0 ; k < 2 ; k++ )
+    {
+      if ( ( v[k] == 15 ) && ( tabType == helix::loopLinbits ) )
+      {
+        v[k] += getBits ( b, linBits ) ;              // Escape
+      }
+      if ( v[k] && getBits ( b, 1 ) )                 // Sign bit
+      {
+        v[k] |= 0x80000000 ;
+      }
+      xy[i+k] = v[k] ;
+    }
+    if ( b.pos > b.end )                              // Used bits after the end?
+    {
+      return -1 ;
+    }
+  }
+  return b.pos - bitOffset ;
+}
+
+
+//**************************************************************************************************
+//                                             M A I N                                             *
+//**************************************************************************************************
+int main()
+{
+  static uint8_t pool[65536] ;                        // Random bits, a call uses a part
+  const int      maxbytes = MAXVALS * 8 ;             // Max. 2 * 19 + 2 * 13 bits per pair
+  int            xy[MAXVALS], ref[MAXVALS] ;
+  uint32_t       seed = 2026 ;
+  int            tables = 0 ;                         // Number of tables tested
+
+  for ( size_t i = 0 ; i < sizeof(pool) ; i++ )
+  {
+    seed = seed * 1664525 + 1013904223 ;
+    pool[i] = seed >> 24 ;
+  }
+  for ( int t = 0 ; t < helix::m_HUFF_PAIRTABS ; t++ )
+  {
+    int diff = 0 ;                                    // Calls with different results
+    int ok = 0 ;                                      // Calls with enough bits
+
+    if ( huffTabLookup[t].tabType == helix::invalidTab )
+    {
+      continue ;
+    }
+    for ( int call = 0 ; call < CALLS ; call++ )
+    {
+      seed = seed * 1664525 + 1013904223 ;
+      uint8_t* stream = pool + ( seed >> 8 ) % ( sizeof(pool) - maxbytes ) ;
+      seed = seed * 1664525 + 1013904223 ;
+      int nVals = 2 * ( 1 + ( seed >> 8 ) % ( MAXVALS / 2 ) ) ;
+      int bitOffset = seed & 7 ;
+      seed = seed * 1664525 + 1013904223 ;
+      int bitsLeft = ( seed >> 8 ) % ( 8 * maxbytes - 8 ) ;  // Often too few
+      int r = helix::DecodeHuffmanPairs ( xy, nVals, t, bitsLeft, stream, bitOffset ) ;
+      int e = refPairs ( ref, nVals, t, bitsLeft, stream, bitOffset ) ;
+      if ( e < 0 )                                    // Stream too short?
+      {
+        continue ;                                    // Yes, not checked
+      }
+      if ( ( r != e ) || memcmp ( xy, ref, nVals * sizeof(int) ) )
+      {
+        diff++ ;
+      }
+      ok++ ;
+    }
+    CHECK ( ( diff == 0 ) && ( ok > 0 ), "table %2d: %d of %d complete calls differ", t, diff, ok ) ;
+    tables++ ;
+  }
+  CHECK ( tables == 30, "%d tables tested", tables ) ;
+  return checks_failed ;
+}
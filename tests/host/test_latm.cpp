@@ -0,0 +1,125 @@
+// test_latm.cpp
+// Test of the LATM/LOAS transport of the AAC decoder (aac_decoder.cpp).  The LOAS files of the
+// corpus are the ADTS files with the same raw blocks, muxed by FFmpeg with a StreamMuxConfig every
+// SMC_INTERVAL frames, see make_corpus.sh.
+//  - A LOAS stream must decode exactly like the ADTS stream with the same raw blocks.
+//  - Joined in the middle (internet radio), the frames up to the next StreamMuxConfig are skipped
+//    without errors.  After that the output is that of the ADTS stream joined at the same frame.
+//    Not that of the whole stream: the noise of PNS depends on the frames before.
+//  - A change of the config in the stream (mono 22050 Hz, then stereo 44100 Hz) is applied without
+//    a reset of the decoder.  The mono part is the same as the mono stream alone, the stereo part
+//    has the same length and level as the stereo stream alone (PNS noise differs again).
+#include "hostdecode.h"
+
+#define SMC_INTERVAL  20                              // Frames per StreamMuxConfig of FFmpeg
+#define LEVEL_TOL     0.01                            // Max. level difference in dB
+
+static const char* const files[][2] =
+{
+  { "aac_44k_stereo.latm", "aac_44k_stereo.aac" },
+  { "aac_22k_mono.latm",   "aac_22k_mono.aac" }
+} ;
+
+
+//**************************************************************************************************
+//                                     F R A M E S B E F O R E                                     *
+//**************************************************************************************************
+// Number of LOAS frames that start before offset pos: AudioSyncStream, 11 bits sync word 0x2B7    *
+// and 13 bits length after the 3 byte header.                                                     *
+//**************************************************************************************************
+static int framesBefore ( const std::vector<uint8_t>& buf, int pos )
+{
+  int n = 0 ;
+
+  for ( int p = 0 ; p < pos ; p += 3 + ( ( ( buf[p+1] & 0x1F ) << 8 ) | buf[p+2] ) )
+  {
+    n++ ;
+  }
+  return n ;
+}
+
+
+//**************************************************************************************************
+//                                      A D T S O F F S E T                                        *
+//**************************************************************************************************
+// Offset of ADTS frame n, the frame length is in 13 bits of the header.                           *
+//**************************************************************************************************
+static int adtsOffset ( const std::vector<uint8_t>& buf, int n )
+{
+  int p = 0 ;
+
+  while ( n-- > 0 )
+  {
+    p += ( ( buf[p+3] & 0x03 ) << 11 ) | ( buf[p+4] << 3 ) | ( buf[p+5] >> 5 ) ;
+  }
+  return p ;
+}
+
+
+//**************************************************************************************************
+//                                             M A I N                                             *
+//**************************************************************************************************
+int main()
+{
+  for ( auto& f : files )
+  {
+    decoded_t d, ref ;
+
+    decodeFile ( f[0], d ) ;
+    decodeFile ( f[1], ref ) ;
+    CHECK ( ( d.sync == 0 ) && ( d.errors == 0 ) && ( d.rate == ref.rate ) &&
+            ( d.channels == ref.channels ) && ( d.frames == ref.frames ) && ( d.pcm == ref.pcm ),
+            "%s: %d Hz, %d channels, %d frames, %d errors, %s %s", f[0], d.rate, d.channels,
+            d.frames, d.errors, ( d.pcm == ref.pcm ) ? "same output as" : "DIFFERENT from", f[1] ) ;
+  }
+  // Join the stereo stream at a few places in the middle
+  {
+    std::vector<uint8_t> buf = readFile ( files[0][0] ) ;
+    std::vector<uint8_t> adts = readFile ( files[0][1] ) ;
+    decoded_t            whole ;
+    bool                 ok = true ;
+    int                  most = 0 ;                   // Most frames skipped after the start
+
+    decodeFile ( files[0][1], whole ) ;
+    for ( int start : { 1, 1000, 5000, 9999 } )
+    {
+      std::vector<uint8_t> part ( buf.begin() + start, buf.end() ) ;   // The decoder changes it
+      decoded_t            d, ref ;
+      int                  first ;                    // First frame with output
+
+      decodeBuffer ( "latm", part.data(), part.size(), d ) ;
+      first = whole.frames - d.frames ;
+      decodeBuffer ( "aac", &adts[adtsOffset ( adts, first )], adts.size() - adtsOffset ( adts, first ),
+                     ref ) ;
+      ok = ok && ( d.errors == 0 ) && ( d.frames > 1 ) && ( d.channels == 2 ) && ( d.pcm == ref.pcm ) ;
+      most = max ( most, first - framesBefore ( buf, start ) ) ;
+    }
+    CHECK ( ok && ( most <= SMC_INTERVAL ), "joined in the middle: no errors, at most %d frames "
+            "skipped, then the output of ADTS joined at that frame", most ) ;
+  }
+  // Change of the config: the mono stream, followed by the stereo stream
+  {
+    std::vector<uint8_t> buf = readFile ( files[1][0] ) ;
+    std::vector<uint8_t> b = readFile ( files[0][0] ) ;
+    decoded_t            d, mono, stereo ;
+
+    buf.insert ( buf.end(), b.begin(), b.end() ) ;
+    decodeBuffer ( "latm", buf.data(), buf.size(), d ) ;
+    decodeFile ( files[1][1], mono ) ;
+    decodeFile ( files[0][1], stereo ) ;
+    bool same = ( d.pcm.size() == mono.pcm.size() + stereo.pcm.size() ) &&
+                std::equal ( mono.pcm.begin(), mono.pcm.end(), d.pcm.begin() ) ;
+    std::vector<int16_t> part ( d.pcm.begin() + min ( d.pcm.size(), mono.pcm.size() ), d.pcm.end() ) ;
+    double diff = 0.0 ;                               // Level difference of the stereo part
+    for ( int ch = 0 ; ch < 2 ; ch++ )
+    {
+      diff = max ( diff, fabs ( pcmRms ( part, 2, ch, part.size() / 2 ) -
+                                pcmRms ( stereo.pcm, 2, ch, stereo.pcm.size() / 2 ) ) ) ;
+    }
+    CHECK ( ( d.errors == 0 ) && ( d.rate == 44100 ) && ( d.channels == 2 ) && same &&
+            ( d.frames == mono.frames + stereo.frames ) && ( diff <= LEVEL_TOL ),
+            "config change: %d frames, %d errors, mono part %s, stereo part %.4f dB from the stereo "
+            "stream", d.frames, d.errors, same ? "the same" : "DIFFERENT", diff ) ;
+  }
+  return checks_failed ;
+}
@@ -0,0 +1,241 @@
+// test_loudness.cpp
+// Test of the loudness meter of helixfuncs.h (helixLoudMeter, helixLoudBlock, helixLoudIntegrate)
+// against a reference of ITU-R BS.1770-4 in double precision: K-weighting at the full sample rate,
+// blocks of 400 ms with 75% overlap and the gates of EBU R128.
+//  - The cases 1..5 of EBU Tech 3341 (stereo sines with known loudness) must give the expected
+//    integrated loudness within the tolerance of Tech 3341 (0.1 LU), with the meter and with the
+//    reference.  A mono stream is counted as played on two speakers.
+//  - Sines of 60 Hz to 10 kHz and pink noise must give the loudness of the reference within
+//    MAX_DIFF LU.  The meter runs at half the sample rate on every other frame.
+// At 44100 and 48000 Hz, the samples are given in blocks of 1152 frames like an MP3 decoder does.
+#include "hosttest.h"
+#include "helixhost.h"
+#include "helixfuncs.h"
+
+#define EBU_TOL    0.1                                // Tolerance of EBU Tech 3341 in LU
+#define MAX_DIFF   0.15                               // Max. difference meter - reference in LU
+#define CHUNK      1152                               // Frames per call of helixLoudMeter
+
+struct segment_t                                      // Part of a test signal: 1 kHz sine
+{
+  double      db ;                                    // Level in dBFS
+  double      secs ;                                  // Length
+} ;
+
+struct ebucase_t                                      // Test case of EBU Tech 3341
+{
+  const char* name ;
+  int         ch ;                                    // Channels
+  double      lufs ;                                  // Expected loudness
+  segment_t   seg[5] ;                                // Parts of the signal, end at secs 0
+} ;
+
+static const ebucase_t ebucases[] =
+{
+  { "3341-1 -23 dBFS",            2, -23.0, { { -23, 20 } } },
+  { "3341-2 -33 dBFS",            2, -33.0, { { -33, 20 } } },
+  { "3341-3 -36/-23/-36",         2, -23.0, { { -36, 10 }, { -23, 60 }, { -36, 10 } } },
+  { "3341-4 -72/-36/-23/-36/-72", 2, -23.0, { { -72, 10 }, { -36, 10 }, { -23, 60 }, { -36, 10 },
+                                              { -72, 10 } } },
+  { "3341-5 -26/-20/-26",         2, -23.0, { { -26, 20 }, { -20, 20.1 }, { -26, 20 } } },
+  { "mono -23 dBFS",              1, -23.0, { { -23, 20 } } }
+} ;
+
+
+//**************************************************************************************************
+//                                          S I N E                                                *
+//**************************************************************************************************
+// Add secs seconds of a sine of f Hz at db dBFS, the same on all channels, to v.                  *
+//**************************************************************************************************
+static void sine ( std::vector<int16_t>& v, int ch, double rate, double f, double db, double secs )
+{
+  double a = 32767.0 * pow ( 10.0, db / 20.0 ) ;
+  size_t n = (size_t)( secs * rate ) ;
+  size_t o = v.size() / ch ;                          // Phase continues
+
+  for ( size_t i = 0 ; i < n ; i++ )
+  {
+    int16_t x = (int16_t)lround ( a * sin ( 2.0 * M_PI * f * ( o + i ) / rate ) ) ;
+    for ( int c = 0 ; c < ch ; c++ )
+    {
+      v.push_back ( x ) ;
+    }
+  }
+}
+
+
+//**************************************************************************************************
+//                                          P I N K                                                *
+//**************************************************************************************************
+// Stereo pink noise (filter of P. Kellet on white noise), different in both channels.             *
+//**************************************************************************************************
+static void pink ( std::vector<int16_t>& v, double rate, double secs, double scale )
+{
+  double   p[2][7] = { { 0 } } ;                      // Filter state per channel
+  uint32_t seed = 1 ;
+  size_t   n = (size_t)( secs * rate ) ;
+
+  for ( size_t i = 0 ; i < n ; i++ )
+  {
+    for ( int c = 0 ; c < 2 ; c++ )
+    {
+      seed = seed * 1664525 + 1013904223 ;            // LCG of Numerical Recipes
+      double  w = (int32_t)seed / 2147483648.0 ;      // White, -1..1
+      double* b = p[c] ;
+      b[0] = 0.99886 * b[0] + w * 0.0555179 ;
+      b[1] = 0.99332 * b[1] + w * 0.0750759 ;
+      b[2] = 0.96900 * b[2] + w * 0.1538520 ;
+      b[3] = 0.86650 * b[3] + w * 0.3104856 ;
+      b[4] = 0.55000 * b[4] + w * 0.5329522 ;
+      b[5] = -0.7616 * b[5] - w * 0.0168980 ;
+      double o = b[0] + b[1] + b[2] + b[3] + b[4] + b[5] + b[6] + w * 0.5362 ;
+      b[6] = w * 0.115926 ;
+      v.push_back ( (int16_t)max ( -32768.0, min ( 32767.0, o * scale ) ) ) ;
+    }
+  }
+}
+
+
+//**************************************************************************************************
+//                                     R E F E R E N C E                                           *
+//**************************************************************************************************
+// Integrated loudness in LUFS by ITU-R BS.1770-4, in double precision at the full sample rate.    *
+//**************************************************************************************************
+static double reference ( const std::vector<int16_t>& s, int ch, double rate )
+{
+  double              b[2][3], a[2][2] ;              // K-weighting, high shelf and high pass
+  double              K, Q, Vh, Vb, a0 ;
+  size_t              n = s.size() / ch ;
+  std::vector<double> y2 ( n, 0.0 ) ;                 // Sum of the weighted squares per frame
+  std::vector<double> ms ;                            // Mean square per block
+  size_t              blk = (size_t)( 0.4 * rate ) ;  // 400 ms blocks
+  double              gate = -70.0 ;                  // Absolute gate first
+  double              l = 0.0 ;
+
+  K  = tan ( M_PI * 1681.974450955533 / rate ) ;
+  Q  = 0.7071752369554196 ;
+  Vh = pow ( 10.0, 3.999843853973347 / 20.0 ) ;
+  Vb = pow ( Vh, 0.4996667741545416 ) ;
+  a0 = 1.0 + K / Q + K * K ;
+  b[0][0] = ( Vh + Vb * K / Q + K * K ) / a0 ;
+  b[0][1] = 2.0 * ( K * K - Vh ) / a0 ;
+  b[0][2] = ( Vh - Vb * K / Q + K * K ) / a0 ;
+  a[0][0] = 2.0 * ( K * K - 1.0 ) / a0 ;
+  a[0][1] = ( 1.0 - K / Q + K * K ) / a0 ;
+  K  = tan ( M_PI * 38.13547087602444 / rate ) ;
+  Q  = 0.5003270373238773 ;
+  a0 = 1.0 + K / Q + K * K ;
+  b[1][0] = 1.0 ;
+  b[1][1] = -2.0 ;
+  b[1][2] = 1.0 ;
+  a[1][0] = 2.0 * ( K * K - 1.0 ) / a0 ;
+  a[1][1] = ( 1.0 - K / Q + K * K ) / a0 ;
+  for ( int c = 0 ; c < ch ; c++ )
+  {
+    double st[2][4] = { { 0 } } ;                     // x[n-1], x[n-2], y[n-1], y[n-2]
+    for ( size_t i = 0 ; i < n ; i++ )
+    {
+      double x = s[i * ch + c] / 32768.0 ;
+      for ( int k = 0 ; k < 2 ; k++ )
+      {
+        double y = b[k][0] * x + b[k][1] * st[k][0] + b[k][2] * st[k][1] -
+                   a[k][0] * st[k][2] - a[k][1] * st[k][3] ;
+        st[k][1] = st[k][0] ;
+        st[k][0] = x ;
+        st[k][3] = st[k][2] ;
+        st[k][2] = y ;
+        x = y ;
+      }
+      y2[i] += x * x * ( ( ch == 1 ) ? 2.0 : 1.0 ) ;  // Mono on two speakers
+    }
+  }
+  for ( size_t i = 0 ; i + blk <= n ; i += blk / 4 )  // 75% overlap
+  {
+    double sum = 0.0 ;
+    for ( size_t j = 0 ; j < blk ; j++ )
+    {
+      sum += y2[i + j] ;
+    }
+    ms.push_back ( sum / blk ) ;
+  }
+  for ( int pass = 0 ; pass < 2 ; pass++ )            // Absolute and relative gate
+  {
+    double sum = 0.0 ;
+    int    cnt = 0 ;
+    for ( double m : ms )
+    {
+      if ( ( m > 0.0 ) && ( -0.691 + 10.0 * log10 ( m ) > gate ) )
+      {
+        sum += m ;
+        cnt++ ;
+      }
+    }
+    l = -0.691 + 10.0 * log10 ( sum / cnt ) ;
+    gate = l - 10.0 ;
+  }
+  return l ;
+}
+
+
+//**************************************************************************************************
+//                                         M E T E R                                               *
+//**************************************************************************************************
+// Integrated loudness in LUFS of the meter of helixfuncs.h, fed like helixPost does.              *
+//**************************************************************************************************
+static double meter ( const std::vector<int16_t>& s, int ch, uint32_t rate )
+{
+  helixSetLoudness ( -23 ) ;                          // Meter on
+  helixLoudStart() ;                                  // Clear it
+  for ( size_t i = 0 ; i < s.size() ; i += CHUNK * ch )
+  {
+    int words = (int)min ( (size_t)CHUNK * ch, s.size() - i ) ;
+    helixLoudMeter ( (int16_t*)&s[i], words, ch, rate ) ;
+  }
+  return helixLoudIntegrate() / 10.0 ;
+}
+
+
+//**************************************************************************************************
+//                                             M A I N                                             *
+//**************************************************************************************************
+int main()
+{
+  static const uint32_t rates[] = { 44100, 48000 } ;
+  static const double   freqs[] = { 60, 100, 500, 2000, 5000, 8000, 10000 } ;
+
+  for ( uint32_t rate : rates )
+  {
+    for ( const ebucase_t& e : ebucases )
+    {
+      std::vector<int16_t> v ;
+      for ( int i = 0 ; ( i < 5 ) && ( e.seg[i].secs > 0 ) ; i++ )
+      {
+        sine ( v, e.ch, rate, 1000.0, e.seg[i].db, e.seg[i].secs ) ;
+      }
+      double m = meter ( v, e.ch, rate ) ;
+      double r = reference ( v, e.ch, rate ) ;
+      CHECK ( ( fabs ( m - e.lufs ) <= EBU_TOL ) && ( fabs ( r - e.lufs ) <= EBU_TOL ),
+              "%5d Hz %-28s expected %6.1f LUFS, meter %6.2f, reference %6.2f", rate, e.name,
+              e.lufs, m, r ) ;
+    }
+    double worst = 0.0 ;                              // Largest difference with the reference
+    for ( double f : freqs )
+    {
+      std::vector<int16_t> v ;
+      sine ( v, 2, rate, f, -20.0, 20.0 ) ;
+      worst = max ( worst, fabs ( meter ( v, 2, rate ) - reference ( v, 2, rate ) ) ) ;
+    }
+    CHECK ( worst <= MAX_DIFF, "%5d Hz sines of 60..10000 Hz: meter within %.2f LU of the "
+            "reference", rate, worst ) ;
+    for ( double scale : { 3000.0, 300.0 } )
+    {
+      std::vector<int16_t> v ;
+      pink ( v, rate, 30.0, scale ) ;
+      double m = meter ( v, 2, rate ) ;
+      double r = reference ( v, 2, rate ) ;
+      CHECK ( fabs ( m - r ) <= MAX_DIFF, "%5d Hz pink noise: meter %6.2f LUFS, reference %6.2f",
+              rate, m, r ) ;
+    }
+  }
+  return checks_failed ;
+}
@@ -0,0 +1,194 @@
+// test_oggopus.cpp
+// Test of the Ogg layer of the Ogg Opus decoder (oggopus_decoder.cpp, ogg_demux.cpp) against
+// FFmpeg with libopus.  Only built if the libopus of the system is found, see CMakeLists.txt.
+// libopus itself is tested by its own conformance test (RFC 6716 and RFC 8251 vectors).
+//  - The level of every block of 4096 frames must be within BLOCK_TOL dB of the level of the same
+//    block decoded by FFmpeg (corpus/opus_blocks.txt).
+//  - The number of frames must be the number of FFmpeg: the pre-skip is dropped at the start, the
+//    last packet is cut at the granule position of the last page.
+//  - The output must not depend on how the stream is cut in pieces.
+//  - A chained stream (a mono and a stereo track) gives both tracks with their own format.
+//  - Half rate gives half the frames at 24 kHz, with about the same level.
+#include "hosttest.h"
+#include "oggopus_decoder.h"
+
+#define BLOCK      4096                               // Frames per block of opus_blocks.txt
+#define BLOCK_TOL  0.01                               // Max. difference of the level in dB
+#define HALF_TOL   0.5                                // Max. level difference at half rate in dB
+
+struct opfile_t
+{
+  const char* name ;                                  // File in the corpus
+  int         channels ;
+  int         frames ;                                // Number of frames of FFmpeg
+} ;
+
+static const opfile_t files[] =
+{
+  { "opus_48k_stereo.opus", 2, 72000 },
+  { "opus_48k_mono.opus",   1, 72000 }
+} ;
+
+struct optrack_t
+{
+  int                  rate ;                         // Format of the track
+  int                  channels ;
+  std::vector<int16_t> pcm ;
+} ;
+
+
+//**************************************************************************************************
+//                                         D E C O D E                                             *
+//**************************************************************************************************
+// Decode a stream in pieces of "chunk" bytes.  Every change of the format starts a new track.     *
+// Returns the number of decode errors.                                                            *
+//**************************************************************************************************
+static int decode ( const std::vector<uint8_t>& buf, int chunk, bool half,
+                    std::vector<optrack_t>& tracks )
+{
+  static int16_t out[OGGOPUS_MAXOUT * OGGOPUS_MAXCHANS] ;
+  int            errors = 0 ;
+  int            left, pos = 0, r ;
+
+  tracks.clear() ;
+  OggOpusDecoder_AllocateBuffers() ;
+  OggOpusSetHalfRate ( half ) ;
+  while ( pos < (int)buf.size() )
+  {
+    left = min ( chunk, (int)buf.size() - pos ) ;
+    int end = pos + left ;
+    while ( ( r = OggOpusDecode ( (uint8_t*)&buf[pos], &left, out ) ) != ERR_OGGOPUS_INDATA_UNDERFLOW )
+    {
+      pos = end - left ;
+      if ( r != ERR_OGGOPUS_NONE )
+      {
+        errors++ ;
+        continue ;
+      }
+      if ( tracks.empty() || ( tracks.back().channels != OggOpusGetChannels() ) ||
+           ( tracks.back().rate != OggOpusGetSampRate() ) )
+      {
+        tracks.push_back ( optrack_t() ) ;            // New format, next track
+        tracks.back().rate = OggOpusGetSampRate() ;
+        tracks.back().channels = OggOpusGetChannels() ;
+      }
+      tracks.back().pcm.insert ( tracks.back().pcm.end(), out, out + OggOpusGetOutputSamps() ) ;
+    }
+    pos = end ;
+  }
+  OggOpusDecoder_FreeBuffers() ;
+  return errors ;
+}
+
+
+//**************************************************************************************************
+//                                      B L O C K L E V E L                                        *
+//**************************************************************************************************
+// RMS level in dBFS of one channel of block b, over the frames that are in the block.             *
+//**************************************************************************************************
+static double blockLevel ( const optrack_t& t, int b, int ch )
+{
+  size_t               first = (size_t)b * BLOCK * t.channels ;
+  size_t               last = min ( t.pcm.size(), first + BLOCK * t.channels ) ;
+  std::vector<int16_t> part ( t.pcm.begin() + first, t.pcm.begin() + last ) ;
+
+  return pcmRms ( part, t.channels, ch, part.size() / t.channels ) ;
+}
+
+
+//**************************************************************************************************
+//                                             M A I N                                             *
+//**************************************************************************************************
+int main()
+{
+  static const int chunks[] = { 1, 7, 32, 100, 4096 } ;
+  std::string      path = std::string ( CORPUS ) + "/opus_blocks.txt" ;
+  FILE*            f = fopen ( path.c_str(), "r" ) ;
+  char             line[256] ;
+  char             name[64] ;
+  int              block ;
+  double           rms[2] ;
+  int              n ;
+
+  if ( f == NULL )
+  {
+    printf ( "Cannot open %s\n", path.c_str() ) ;
+    return 1 ;
+  }
+  for ( const opfile_t& v : files )
+  {
+    std::vector<uint8_t>   buf = readFile ( v.name ) ;
+    std::vector<optrack_t> d, h ;
+    int                    errors = decode ( buf, buf.size(), false, d ) ;
+    double                 worst = 0.0 ;              // Largest difference of a block level
+    int                    blocks = 0 ;               // Blocks compared
+    bool                   same = true ;              // Output independent of the chunk size
+    int                    frames = 0 ;
+
+    if ( d.size() == 1 )
+    {
+      frames = d[0].pcm.size() / d[0].channels ;
+    }
+    CHECK ( ( d.size() == 1 ) && ( frames == v.frames ) && ( d[0].rate == 48000 ) &&
+            ( d[0].channels == v.channels ) && ( errors == 0 ),
+            "%s: %d track(s), %d frames, FFmpeg %d, %d errors", v.name, (int)d.size(), frames,
+            v.frames, errors ) ;
+    if ( d.size() != 1 )
+    {
+      continue ;
+    }
+    rewind ( f ) ;
+    while ( fgets ( line, sizeof(line), f ) )
+    {
+      n = sscanf ( line, "%63s %d %lf %lf", name, &block, &rms[0], &rms[1] ) ;
+      if ( ( n < 3 ) || ( name[0] == '#' ) || strcmp ( name, v.name ) )
+      {
+        continue ;
+      }
+      for ( int ch = 0 ; ch < n - 2 ; ch++ )
+      {
+        worst = max ( worst, fabs ( blockLevel ( d[0], block, ch ) - rms[ch] ) ) ;
+      }
+      blocks++ ;
+    }
+    CHECK ( ( blocks > 0 ) && ( worst <= BLOCK_TOL ), "%s: %d blocks within %.4f dB of FFmpeg",
+            v.name, blocks, worst ) ;
+    for ( int chunk : chunks )
+    {
+      std::vector<optrack_t> c ;
+      decode ( buf, chunk, false, c ) ;
+      same = same && ( c.size() == 1 ) && ( c[0].pcm == d[0].pcm ) ;
+    }
+    CHECK ( same, "%s: same output for chunks of 1..4096 bytes", v.name ) ;
+    errors = decode ( buf, buf.size(), true, h ) ;
+    if ( h.size() == 1 )
+    {
+      double full = pcmRms ( d[0].pcm, v.channels, 0, v.frames ) ;
+      double half = pcmRms ( h[0].pcm, v.channels, 0, h[0].pcm.size() / v.channels ) ;
+      CHECK ( ( h[0].rate == 24000 ) && ( (int)h[0].pcm.size() == v.frames / 2 * v.channels ) &&
+              ( fabs ( half - full ) <= HALF_TOL ) && ( errors == 0 ),
+              "%s: half rate %d Hz, %d frames, level %.2f dB from full rate", v.name, h[0].rate,
+              (int)h[0].pcm.size() / v.channels, half - full ) ;
+    }
+    else
+    {
+      CHECK ( false, "%s: half rate gives %d tracks", v.name, (int)h.size() ) ;
+    }
+  }
+  fclose ( f ) ;
+  // Chained stream: 0.5 s mono, then 0.5 s stereo, both at 48 kHz
+  {
+    std::vector<uint8_t>   buf = readFile ( "opus_chained.opus" ) ;
+    std::vector<optrack_t> t ;
+    int                    errors = decode ( buf, 100, false, t ) ;   // Pieces of 100 bytes
+
+    CHECK ( ( t.size() == 2 ) && ( errors == 0 ) &&
+            ( t[0].channels == 1 ) && ( t[0].pcm.size() == 24000 ) &&
+            ( t[1].channels == 2 ) && ( t[1].pcm.size() == 2 * 24000 ),
+            "chained: %d tracks, %d ch %d frames, then %d ch %d frames, %d errors", (int)t.size(),
+            t.size() > 0 ? t[0].channels : 0, t.size() > 0 ? (int)t[0].pcm.size() / t[0].channels : 0,
+            t.size() > 1 ? t[1].channels : 0, t.size() > 1 ? (int)t[1].pcm.size() / t[1].channels : 0,
+            errors ) ;
+  }
+  return checks_failed ;
+}
@@ -0,0 +1,243 @@
+// test_pipeline.cpp
+// Test of MP3 decoding in two stages (MP3DecodeHeader, MP3DecodeGranule and MP3SynthGranule of
+// mp3_decoder.cpp) and of the dual core pipeline of helixfuncs.h that uses it (HELIX_DUALCORE).
+// This file is built twice, as test_pipeline without and as test_pipeline_dual with
+// HELIX_DUALCORE, see CMakeLists.txt.
+//  - Stage 1 in this thread and stage 2 in another, with GRANSLOTS granule buffers between them,
+//    must give the same samples as MP3Decode.  For MPEG-1 (2 granules per frame) and MPEG-2 (1
+//    granule), at the full and at half the sample rate.
+//  - mp3_44k_stereo.mp3 sent through playChunk must give the same output with and without
+//    HELIX_DUALCORE: PLAY_HASH at the full rate and PLAY_HASH_HALF at half rate.  The gapless
+//    trim of the encoder delay is done by the output task then.  With HELIX_DUALCORE every
+//    granule must have gone through stage 2 in the output task.
+// The load of both stages and the latency of the pipeline are printed, on the host the output is
+// not paced by I2S.
+#include "hosttest.h"
+#include "helixhost.h"
+#include "helixfuncs.h"
+#include <thread>
+
+#define PAD             -32768                        // Padding to flush i2sbuf
+#define PLAY_HASH       0xa830a5c5                    // Output of playChunk, full rate
+#define PLAY_HASH_HALF  0xe43ea1c5                    // Output of playChunk, half rate
+
+struct granmsg_t                                      // Granule for stage 2, NULL is the end
+{
+  MP3Granule_t* gran ;
+  int           words ;                               // Samples of the granule
+} ;
+
+static QueueHandle_t        gfull ;                   // Granules for stage 2
+static QueueHandle_t        gfree ;                   // Granule buffers given back by stage 2
+static MP3Decoder_t*        gctx ;                    // Decoder instance of both stages
+static std::vector<int16_t> spcm ;                    // Output of stage 2
+static uint64_t             s1_cycles ;               // Time in stage 1, waits excluded
+static uint64_t             s2_cycles ;               // Time in stage 2
+
+
+//**************************************************************************************************
+//                                         S T A G E 2                                             *
+//**************************************************************************************************
+// Thread for the IMDCT and synthesis of the granules in gfull.                                    *
+//**************************************************************************************************
+static void stage2()
+{
+  granmsg_t m ;
+  int16_t   out[m_MAX_NSAMP*2] ;
+  uint32_t  t ;
+
+  MP3Decoder_Select ( gctx ) ;                        // Same instance as stage 1
+  while ( xQueueReceive ( gfull, &m, portMAX_DELAY ) && m.gran )
+  {
+    t = ESP.getCycleCount() ;
+    if ( MP3SynthGranule ( m.gran, out ) == ERR_MP3_NONE )
+    {
+      spcm.insert ( spcm.end(), out, out + m.words ) ;
+    }
+    s2_cycles += ESP.getCycleCount() - t ;
+    xQueueSend ( gfree, &m.gran, portMAX_DELAY ) ;
+  }
+}
+
+
+//**************************************************************************************************
+//                                         D E C O D E                                             *
+//**************************************************************************************************
+// Decode an MP3 file in one stage (MP3Decode) or in two stages, with stage 2 in another thread.   *
+// Like decodeMp3 of hostdecode.cpp the next frame is searched after an error.                     *
+//**************************************************************************************************
+static std::vector<int16_t> decode ( std::vector<uint8_t>& buf, bool half, bool split )
+{
+  static MP3Granule_t  grans[GRANSLOTS] ;
+  static int16_t       out[m_MAX_NGRAN*m_MAX_NSAMP*2] ;
+  std::vector<int16_t> pcm ;
+  std::thread          worker ;
+  int                  len = buf.size() ;
+  int                  pos ;                          // Position of the next frame
+  int                  left ;                         // Bytes left after decoding
+  int                  n ;                            // Result of the decoder
+  uint32_t             t ;                            // Start of stage 1
+  uint32_t             w ;                            // Start of a wait for a granule buffer
+  granmsg_t            m ;
+
+  gctx = (MP3Decoder_t*)calloc ( 1, sizeof(MP3Decoder_t) ) ;
+  MP3Decoder_Select ( gctx ) ;
+  MP3Decoder_AllocateBuffers() ;
+  MP3SetHalfRate ( half ) ;
+  if ( split )
+  {
+    gfull = xQueueCreate ( GRANSLOTS, sizeof(granmsg_t) ) ;
+    gfree = xQueueCreate ( GRANSLOTS, sizeof(MP3Granule_t*) ) ;
+    for ( int i = 0 ; i < GRANSLOTS ; i++ )
+    {
+      m.gran = &grans[i] ;
+      xQueueSend ( gfree, &m.gran, 0 ) ;
+    }
+    spcm.clear() ;
+    worker = std::thread ( stage2 ) ;
+  }
+  pos = MP3FindSyncWord ( &buf[0], len ) ;
+  while ( ( pos >= 0 ) && ( pos < len ) )
+  {
+    left = len - pos ;
+    t = ESP.getCycleCount() ;
+    if ( split )
+    {
+      n = MP3DecodeHeader ( &buf[pos], &left, 0 ) ;
+      for ( int gr = 0 ; ( n == ERR_MP3_NONE ) && ( gr < MP3GetGranules() ) ; gr++ )
+      {
+        w = ESP.getCycleCount() ;
+        xQueueReceive ( gfree, &m.gran, portMAX_DELAY ) ;
+        t += ESP.getCycleCount() - w ;                // Not counted
+        n = MP3DecodeGranule ( gr, m.gran ) ;
+        m.words = MP3GetOutputSamps() / MP3GetGranules() ;
+        if ( n == ERR_MP3_NONE )
+        {
+          xQueueSend ( gfull, &m, portMAX_DELAY ) ;
+        }
+        else
+        {
+          xQueueSend ( gfree, &m.gran, 0 ) ;          // Buffer not used
+        }
+      }
+    }
+    else
+    {
+      n = MP3Decode ( &buf[pos], &left, out, 0 ) ;
+      if ( n == ERR_MP3_NONE )
+      {
+        pcm.insert ( pcm.end(), out, out + MP3GetOutputSamps() ) ;
+      }
+    }
+    s1_cycles += ESP.getCycleCount() - t ;
+    pos = len - left ;
+    if ( n == ERR_MP3_INDATA_UNDERFLOW )              // Incomplete frame at the end
+    {
+      break ;
+    }
+    else if ( ( n != ERR_MP3_NONE ) && ( n != ERR_MP3_MAINDATA_UNDERFLOW ) )
+    {
+      n = MP3FindSyncWord ( &buf[pos + 1], len - pos - 1 ) ;
+      pos = ( n < 0 ) ? -1 : pos + 1 + n ;
+    }
+  }
+  if ( split )
+  {
+    m.gran = NULL ;                                   // End of stage 2
+    xQueueSend ( gfull, &m, portMAX_DELAY ) ;
+    worker.join() ;
+    pcm = spcm ;
+  }
+  MP3Decoder_FreeBuffers() ;
+  MP3Decoder_Select ( NULL ) ;
+  free ( gctx ) ;
+  return pcm ;
+}
+
+
+//**************************************************************************************************
+//                                           P L A Y                                               *
+//**************************************************************************************************
+// Play a file of the corpus through playChunk in chunks of 32 bytes, return all output.           *
+//**************************************************************************************************
+static std::vector<int16_t> play ( const std::string& name, bool half )
+{
+  std::vector<uint8_t> buf = readFile ( name ) ;
+  uint8_t              chunk[32] ;
+  size_t               n ;
+
+  i2s_out.clear() ;
+  audio_ct = "audio/mpeg" ;
+  helixSetHalfRate ( half ) ;
+  helixInit ( -1, -1 ) ;
+  for ( size_t i = 0 ; i < buf.size() ; i += 32 )
+  {
+    n = min ( (size_t)32, buf.size() - i ) ;
+    memset ( chunk, 0, sizeof(chunk) ) ;              // Last chunk is padded with zeroes
+    memcpy ( chunk, &buf[i], n ) ;
+    playChunk ( chunk ) ;
+  }
+  helixNextTrack() ;                                  // Play the frames left in the buffer
+  helixStop() ;                                       // Wait for the output task
+  n = i2s_out.size() ;
+  while ( i2s_out.size() == n )                       // Pad until i2sbuf is sent
+  {
+    outputSample ( PAD ) ;
+  }
+  while ( i2s_out.back() == PAD )                     // Remove the padding
+  {
+    i2s_out.pop_back() ;
+  }
+  return i2s_out ;
+}
+
+
+//**************************************************************************************************
+//                                             M A I N                                             *
+//**************************************************************************************************
+int main()
+{
+  static const char* files[] = { "mp3_44k_stereo.mp3", "mp3_22k_mono.mp3" } ;
+
+  for ( const char* name : files )
+  {
+    std::vector<uint8_t> buf = readFile ( name ) ;
+    for ( int half = 0 ; half < 2 ; half++ )
+    {
+      s1_cycles = 0 ;
+      s2_cycles = 0 ;
+      std::vector<int16_t> ref = decode ( buf, half, false ) ;
+      uint64_t             one = s1_cycles ;
+      s1_cycles = 0 ;
+      std::vector<int16_t> two = decode ( buf, half, true ) ;
+      CHECK ( ( ref.size() > 0 ) && ( two == ref ), "%s%s: two stages %d samples, MP3Decode %d, "
+              "bit exact", name, half ? " half rate" : "", (int)two.size(), (int)ref.size() ) ;
+      printf ( "info: %s%s: one stage %.0f us, stage 1 %.0f us, stage 2 %.0f us\n", name,
+               half ? " half rate" : "", one / 1000.0, s1_cycles / 1000.0, s2_cycles / 1000.0 ) ;
+    }
+  }
+  #ifdef HELIX_DUALCORE
+    helixStartOutput() ;                              // Output task in a thread
+  #endif
+  for ( int half = 0 ; half < 2 ; half++ )
+  {
+    uint32_t expect = half ? PLAY_HASH_HALF : PLAY_HASH ;
+    std::vector<int16_t> out = play ( "mp3_44k_stereo.mp3", half ) ;
+    CHECK ( pcmHash ( out ) == expect, "playChunk%s: %d samples, hash %08x, expected %08x",
+            half ? " half rate" : "", (int)out.size(), pcmHash ( out ), expect ) ;
+    #ifdef HELIX_DUALCORE
+      CHECK ( ( out_frames > 0 ) && ( syn_cycles > 0 ), "dual core%s: %d blocks by the output "
+              "task, stage 2 in it", half ? " half rate" : "", out_frames ) ;
+      printf ( "info: stage 1 %.0f us, output task %.0f us (stage 2 %.0f us), latency %d us "
+               "average, %d max\n", dec_cycles / 1000.0, out_cycles / 1000.0,
+               syn_cycles / 1000.0, (int)( lat_total / out_frames ), (int)lat_max ) ;
+      out_frames = 0 ;
+      out_cycles = 0 ;
+      syn_cycles = 0 ;
+      lat_total = 0 ;
+      lat_max = 0 ;
+      dec_cycles = 0 ;
+    #endif
+  }
+  return checks_failed ;
+}
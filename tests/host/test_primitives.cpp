@@ -0,0 +1,104 @@
+// test_primitives.cpp
+// Test of the fixed-point primitives of the AAC decoder (aac_primitives.h) against the definition
+// of the Xtensa instructions they stand for: MULSH (high word of the signed 64-bit product), MULL,
+// NSAU (32 for 0), ABS (0x80000000 stays 0x80000000) and CLAMPS.  On the host the portable C is
+// tested; both versions must give these results for every input, so the decoder is bit exact on
+// either.  The inputs are the edge values and random numbers of all magnitudes.
+#include "hosttest.h"
+#include "aac_primitives.h"
+
+#define RANDOMS  2000000                              // Number of random inputs per primitive
+
+static uint32_t seed = 2026 ;
+
+
+//**************************************************************************************************
+//                                          R A N D O M                                            *
+//**************************************************************************************************
+// Random 32 bit number with a random number of significant bits, so small values are tested too.  *
+//**************************************************************************************************
+static int random32()
+{
+  uint32_t r ;
+
+  seed = seed * 1664525 + 1013904223 ;                // LCG of Numerical Recipes
+  r = seed ;
+  seed = seed * 1664525 + 1013904223 ;
+  return (int)r >> ( seed >> 27 ) ;                   // Shift 0..31, keeps the sign
+}
+
+
+//**************************************************************************************************
+//                                        R E F E R E N C E S                                      *
+//**************************************************************************************************
+// The results the instructions give.                                                              *
+//**************************************************************************************************
+static int refMulsh ( int x, int y )
+{
+  return (int)( (uint64_t)( (int64_t)x * y ) >> 32 ) ;
+}
+
+static int refNsau ( int x )
+{
+  return x ? __builtin_clz ( x ) : 32 ;
+}
+
+static int refAbs ( int x )
+{
+  return ( x < 0 ) ? (int)( 0u - (uint32_t)x ) : x ;  // Wraps for 0x80000000
+}
+
+static int refClamps ( int x, int n )
+{
+  return max ( -( 1 << n ), min ( ( 1 << n ) - 1, x ) ) ;
+}
+
+
+//**************************************************************************************************
+//                                             M A I N                                             *
+//**************************************************************************************************
+int main()
+{
+  static const int edges[] = { 0, 1, -1, 2, -2, 0x7FFF, 0x8000, -0x8000, -0x8001, 0xFFFF,
+                               0x3FFFFFFF, 0x40000000, -0x40000000, 0x7FFFFFFE, 0x7FFFFFFF,
+                               (int)0x80000000, (int)0x80000001 } ;
+  std::vector<int> in ( edges, edges + sizeof(edges) / sizeof(edges[0]) ) ;
+  int              bad[6] = { 0 } ;                   // Differences per primitive
+  int64_t          sum = 0, refsum = 0 ;              // MADD64 accumulators
+
+  for ( int i = 0 ; i < RANDOMS ; i++ )
+  {
+    in.push_back ( random32() ) ;
+  }
+  for ( size_t i = 0 ; i < in.size() ; i++ )
+  {
+    int x = in[i] ;
+    int y = in[( i * 7 + 3 ) % in.size()] ;           // Other input of the pair
+
+    bad[0] += ( MULSHIFT32 ( x, y ) != refMulsh ( x, y ) ) ;
+    bad[1] += ( CLZ ( x ) != refNsau ( x ) ) ;
+    bad[2] += ( FASTABS ( x ) != refAbs ( x ) ) ;
+    bad[3] += ( CLIPTOSHORT ( x ) != refClamps ( x, 15 ) ) ;
+    bad[4] += ( CLIP_2N ( x, ( i % 30 ) + 1 ) != refClamps ( x, ( i % 30 ) + 1 ) ) ;
+    sum = MADD64 ( sum, x, y ) ;
+    refsum = (int64_t)( (uint64_t)refsum + (uint64_t)( (int64_t)x * y ) ) ;
+    bad[5] += ( sum != refsum ) ;
+  }
+  for ( size_t i = 0 ; i < sizeof(edges) / sizeof(edges[0]) ; i++ )
+  {
+    for ( size_t j = 0 ; j < sizeof(edges) / sizeof(edges[0]) ; j++ )
+    {
+      bad[0] += ( MULSHIFT32 ( edges[i], edges[j] ) != refMulsh ( edges[i], edges[j] ) ) ;
+    }
+  }
+  CHECK ( bad[0] == 0, "MULSHIFT32: %d differences from MULSH", bad[0] ) ;
+  CHECK ( bad[1] == 0, "CLZ: %d differences from NSAU", bad[1] ) ;
+  CHECK ( bad[2] == 0, "FASTABS: %d differences from ABS", bad[2] ) ;
+  CHECK ( bad[3] == 0, "CLIPTOSHORT: %d differences from CLAMPS 15", bad[3] ) ;
+  CHECK ( bad[4] == 0, "CLIP_2N: %d differences from CLAMPS n", bad[4] ) ;
+  CHECK ( bad[5] == 0, "MADD64: %d differences from MULL/MULSH sum", bad[5] ) ;
+  CHECK ( ( MULSHIFT32 ( (int)0x80000000, (int)0x80000000 ) == 0x40000000 ) &&
+          ( FASTABS ( (int)0x80000000 ) == (int)0x80000000 ) && ( CLZ ( 0 ) == 32 ) &&
+          ( CLZ ( -1 ) == 0 ), "0x80000000 and 0" ) ;
+  return checks_failed ;
+}
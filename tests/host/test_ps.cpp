@@ -0,0 +1,100 @@
+// test_ps.cpp
+// Test of the parametric stereo (PS) of the AAC decoder (aac_decoder.cpp) against FFmpeg.  The
+// codecs are built with AAC_ENABLE_SBR and AAC_ENABLE_PS for this test, see CMakeLists.txt.
+// FFmpeg has no HE-AAC encoder, aac_he_v2.aac is made by make_ps.py: an AAC LC mono stream with
+// SBR and PS data added, in 3 parts with other IID (pan) and ICC (correlation) in 20 bands.
+//  - The stream must give stereo at 44100 Hz, 2048 frames for every AAC frame, without errors.
+//  - The level of both channels and of (left+right)/2 of every block of 4096 frames must be within
+//    BLOCK_TOL dB of FFmpeg (corpus/ps_blocks.txt).  The level of the sum depends on the
+//    correlation of the channels, so this checks the pan and the decorrelation.
+// The samples themselves are not compared: in the SBR bands the phase of the output of the helix
+// decoder and FFmpeg differs, also for the same stream without PS.  The level in these bands is
+// the same.
+// The memory of PS and the time per frame on the host are printed, the cycles on the ESP32 are
+// in the report of HELIX_PROFILE.
+#include "hostdecode.h"
+#include "aac_decoder.h"
+
+#define BLOCK      4096                               // Frames per block of ps_blocks.txt
+#define BLOCK_TOL  0.02                               // Max. difference of the level in dB
+#define NFRAMES    34                                 // AAC frames in aac_he_v2.aac
+#define MIN_DIFF   5.0                                // Min. level difference of L and R in part 0
+
+
+//**************************************************************************************************
+//                                      B L O C K L E V E L                                        *
+//**************************************************************************************************
+// RMS level in dBFS of block b.  Channel 0 and 1 are left and right, 2 is (left+right)/2.         *
+//**************************************************************************************************
+static double blockLevel ( const decoded_t& d, int b, int ch )
+{
+  size_t               first = (size_t)b * BLOCK * 2 ;
+  size_t               last = min ( d.pcm.size(), first + BLOCK * 2 ) ;
+  std::vector<int16_t> part ;
+
+  if ( ch < 2 )
+  {
+    part.assign ( d.pcm.begin() + first, d.pcm.begin() + last ) ;
+    return pcmRms ( part, 2, ch, part.size() / 2 ) ;
+  }
+  for ( size_t i = first ; i < last ; i += 2 )
+  {
+    part.push_back ( ( d.pcm[i] + d.pcm[i+1] ) / 2 ) ;
+  }
+  return pcmRms ( part, 1, 0, part.size() ) ;
+}
+
+
+//**************************************************************************************************
+//                                             M A I N                                             *
+//**************************************************************************************************
+int main()
+{
+  std::string path = std::string ( CORPUS ) + "/ps_blocks.txt" ;
+  FILE*       f = fopen ( path.c_str(), "r" ) ;
+  char        line[256] ;
+  char        name[64] ;
+  int         block ;
+  double      rms[3] ;
+  decoded_t   d ;
+  double      worst = 0.0 ;                           // Largest difference of a block level
+  int         blocks = 0 ;                            // Blocks compared
+  double      pan ;                                   // Left minus right in block 1 (part 0)
+
+  if ( f == NULL )
+  {
+    printf ( "Cannot open %s\n", path.c_str() ) ;
+    return 1 ;
+  }
+  decodeFile ( "aac_he_v2.aac", d ) ;
+  CHECK ( ( d.rate == 44100 ) && ( d.channels == 2 ) && ( d.frames == NFRAMES ) &&
+          ( (int)d.pcm.size() == NFRAMES * 2048 * 2 ) && ( d.errors == 0 ),
+          "aac_he_v2.aac: %d Hz, %d channels, %d frames, %d samples, %d errors", d.rate, d.channels,
+          d.frames, (int)d.pcm.size(), d.errors ) ;
+  if ( d.channels != 2 )
+  {
+    fclose ( f ) ;
+    return checks_failed ;
+  }
+  while ( fgets ( line, sizeof(line), f ) )
+  {
+    if ( ( sscanf ( line, "%63s %d %lf %lf %lf", name, &block, &rms[0], &rms[1], &rms[2] ) != 5 ) ||
+         ( name[0] == '#' ) )
+    {
+      continue ;
+    }
+    for ( int ch = 0 ; ch < 3 ; ch++ )
+    {
+      worst = max ( worst, fabs ( blockLevel ( d, block, ch ) - rms[ch] ) ) ;
+    }
+    blocks++ ;
+  }
+  fclose ( f ) ;
+  CHECK ( ( blocks > 0 ) && ( worst <= BLOCK_TOL ), "aac_he_v2.aac: %d blocks within %.4f dB of "
+          "FFmpeg (left, right and sum)", blocks, worst ) ;
+  pan = blockLevel ( d, 1, 0 ) - blockLevel ( d, 1, 1 ) ;
+  CHECK ( pan >= MIN_DIFF, "part 0 panned to the left: %.2f dB", pan ) ;
+  printf ( "info: PS state %d bytes, AAC arena %d bytes, %.1f us per frame on the host\n",
+           (int)sizeof(PSInfoPS_t), (int)AAC_ARENA_BUDGET, d.cycles / 1000.0 / d.frames ) ;
+  return checks_failed ;
+}
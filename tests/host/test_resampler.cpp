@@ -0,0 +1,251 @@
+// test_resampler.cpp
+// Test of the sample rate converter (resampler.cpp) with sines, for the conversions of the
+// HELIX_FIXEDRATE setting.  The level of a tone is measured with a Hann windowed DFT at its
+// frequency, so the wanted tone and the alias or image products are measured apart.
+//  - Passband: a tone up to PASS_EDGE of the lower Nyquist frequency keeps its level.
+//  - Aliases: for a lower output rate, a tone above the output Nyquist frequency folds back with
+//    the gain of the prototype filter, computed here in double precision.  The filter has its
+//    transition band above RS_CUTOFF (0.91) of the lower Nyquist frequency, so for 48 -> 44.1 kHz
+//    the aliases of 22.3..24 kHz land at 21.8..20.1 kHz, only 21..48 dB down.
+//  - Images: for a higher output rate, the image of a tone (at inRate - f) is removed.
+//  - The number of output frames is inFrames * L / M, also in small blocks with a full output
+//    buffer, and the result does not depend on the block size.
+//  - Equal rates need no conversion.
+#include "hosttest.h"
+#include "resampler.h"
+
+#define PASS_EDGE    0.75                             // Part of the lower Nyquist that is flat
+#define PASS_TOL     0.1                              // Max. passband error in dB
+#define STOP_MIN     60.0                             // Min. attenuation of images in dB
+#define ALIAS_TOL    0.5                              // Max. error of the alias level in dB
+#define CUTOFF       0.91                             // RS_CUTOFF and RS_BETA of resampler.cpp
+#define BETA         7.0
+#define LEVEL        -6.0                             // Level of the test tones in dBFS
+
+struct ratetest_t
+{
+  uint32_t    in ;                                    // Input rate
+  uint32_t    out ;                                   // Output rate
+  int         L, M ;                                  // Expected ratio
+} ;
+
+static const ratetest_t tests[] =
+{
+  { 44100, 48000, 160, 147 },
+  { 22050, 48000, 320, 147 },
+  { 32000, 48000,   3,   2 },
+  { 24000, 48000,   2,   1 },
+  { 48000, 44100, 147, 160 },
+  { 32000, 44100, 441, 320 },
+  { 22050, 44100,   2,   1 }
+} ;
+
+
+//**************************************************************************************************
+//                                       C O N V E R T                                             *
+//**************************************************************************************************
+// Convert stereo pcm in blocks of "block" input frames into an output buffer of "room" frames,   *
+// like outputBlock does.  Output that is waiting when the input ends is collected at the end.    *
+//**************************************************************************************************
+static std::vector<int16_t> convert ( const std::vector<int16_t>& in, int block, int room )
+{
+  std::vector<int16_t> out, buf ( 2 * room ) ;
+  int                  frames = in.size() / 2 ;
+  int                  used, n ;
+
+  for ( int i = 0 ; i < frames ; i += block )
+  {
+    const int16_t* p = &in[2*i] ;
+    int            left = min ( block, frames - i ) ;
+
+    while ( left > 0 )
+    {
+      n = Resampler_Process ( p, left, 2, buf.data(), room, &used ) ;
+      out.insert ( out.end(), buf.begin(), buf.begin() + 2 * n ) ;
+      p += 2 * used ;
+      left -= used ;
+    }
+  }
+  while ( ( n = Resampler_Process ( NULL, 0, 2, buf.data(), room, &used ) ) > 0 )
+  {
+    out.insert ( out.end(), buf.begin(), buf.begin() + 2 * n ) ;   // Output still waiting
+  }
+  return out ;
+}
+
+
+//**************************************************************************************************
+//                                          S I N E                                                *
+//**************************************************************************************************
+// One second of a stereo sine of frequency f at LEVEL dBFS, right channel inverted.              *
+//**************************************************************************************************
+static std::vector<int16_t> sine ( double f, uint32_t rate )
+{
+  std::vector<int16_t> pcm ( 2 * rate ) ;
+  double               a = 32768.0 * pow ( 10.0, LEVEL / 20.0 ) ;
+
+  for ( uint32_t i = 0 ; i < rate ; i++ )
+  {
+    pcm[2*i] = (int16_t)lround ( a * sin ( 2 * M_PI * f * i / rate ) ) ;
+    pcm[2*i+1] = -pcm[2*i] ;
+  }
+  return pcm ;
+}
+
+
+//**************************************************************************************************
+//                                          T O N E                                                *
+//**************************************************************************************************
+// Level in dBFS of the component at frequency f of one channel, Hann window over the second half  *
+// of pcm, so the filter has settled.                                                              *
+//**************************************************************************************************
+static double tone ( const std::vector<int16_t>& pcm, int ch, double f, uint32_t rate )
+{
+  size_t frames = pcm.size() / 2 ;
+  size_t start = frames / 2 ;
+  size_t n = frames - start ;
+  double re = 0.0, im = 0.0, a ;
+
+  for ( size_t i = 0 ; i < n ; i++ )
+  {
+    double w = 0.5 - 0.5 * cos ( 2 * M_PI * i / n ) ;  // Hann, coherent gain 0.5
+    double x = pcm[2 * ( start + i ) + ch] * w ;
+    re += x * cos ( 2 * M_PI * f * ( start + i ) / rate ) ;
+    im += x * sin ( 2 * M_PI * f * ( start + i ) / rate ) ;
+  }
+  a = 2.0 * sqrt ( re * re + im * im ) / ( 0.5 * n ) ;
+  return 20.0 * log10 ( a / 32768.0 + 1e-12 ) ;
+}
+
+
+//**************************************************************************************************
+//                                       B E S S E L I 0                                           *
+//**************************************************************************************************
+// Modified Bessel function of the first kind, order 0, for the Kaiser window.                    *
+//**************************************************************************************************
+static double besselI0 ( double x )
+{
+  double sum = 1.0, term = 1.0 ;
+
+  for ( int k = 1 ; k < 50 ; k++ )
+  {
+    term *= ( x * x ) / ( 4.0 * k * k ) ;
+    sum += term ;
+  }
+  return sum ;
+}
+
+
+//**************************************************************************************************
+//                                         D E S I G N                                             *
+//**************************************************************************************************
+// Gain in dB at frequency f (at the input rate) of the prototype filter of resampler.cpp: a       *
+// Kaiser windowed sinc of RS_TAPS * L taps, in double precision.                                  *
+//**************************************************************************************************
+static double design ( const ratetest_t& t, double f )
+{
+  int    N = t.L * RS_TAPS ;
+  double fc = CUTOFF * 0.5 * min ( t.in, t.out ) / ( (double)t.in * t.L ) ;
+  double re = 0.0, im = 0.0, dc = 0.0 ;
+
+  for ( int n = 0 ; n < N ; n++ )
+  {
+    double x = n - ( N - 1 ) * 0.5 ;
+    double w = 2.0 * n / ( N - 1 ) - 1.0 ;
+    double h = ( x == 0.0 ) ? 2.0 * fc : sin ( 2 * M_PI * fc * x ) / ( M_PI * x ) ;
+    h *= besselI0 ( BETA * sqrt ( 1.0 - w * w ) ) ;
+    re += h * cos ( 2 * M_PI * f / ( (double)t.in * t.L ) * x ) ;
+    im += h * sin ( 2 * M_PI * f / ( (double)t.in * t.L ) * x ) ;
+    dc += h ;
+  }
+  return 10.0 * log10 ( ( re * re + im * im ) / ( dc * dc ) ) ;
+}
+
+
+//**************************************************************************************************
+//                                             M A I N                                             *
+//**************************************************************************************************
+int main()
+{
+  for ( const ratetest_t& t : tests )
+  {
+    double nyq = min ( t.in, t.out ) / 2.0 ;          // Lower Nyquist frequency
+    double perr = 0.0, pfreq = 0.0 ;                  // Largest passband error and its frequency
+    double worst = 200.0, wfreq = 0.0 ;               // Smallest rejection and its frequency
+    double aerr = 0.0 ;                               // Largest error of the alias level
+    double right = 0.0 ;                              // Largest difference between channels
+
+    CHECK ( Resampler_Init ( t.in, t.out ) && Resampler_Active(),
+            "%5d -> %5d Hz: conversion set up", t.in, t.out ) ;
+    for ( double f = 100.0 ; f <= PASS_EDGE * nyq ; f += 0.05 * nyq )
+    {
+      Resampler_Init ( t.in, t.out ) ;
+      std::vector<int16_t> out = convert ( sine ( f, t.in ), 1152, 4096 ) ;
+      double               g = tone ( out, 0, f, t.out ) - LEVEL ;
+      if ( fabs ( g ) > perr )
+      {
+        perr = fabs ( g ) ;
+        pfreq = f ;
+      }
+      right = max ( right, fabs ( tone ( out, 1, f, t.out ) - LEVEL - g ) ) ;
+    }
+    CHECK ( ( perr <= PASS_TOL ) && ( right <= 0.001 ),
+            "%5d -> %5d Hz: passband to %5.0f Hz within %.3f dB (at %5.0f Hz), channels %.4f dB apart",
+            t.in, t.out, PASS_EDGE * nyq, perr, pfreq, right ) ;
+    if ( t.out < t.in )                               // Downsampling: aliases of high tones
+    {
+      for ( double f = t.out / 2.0 + 250.0 ; f < t.in / 2.0 ; f += 250.0 )
+      {
+        Resampler_Init ( t.in, t.out ) ;
+        std::vector<int16_t> out = convert ( sine ( f, t.in ), 1152, 4096 ) ;
+        double               r = LEVEL - tone ( out, 0, t.out - f, t.out ) ;
+        aerr = max ( aerr, fabs ( r + design ( t, f ) ) ) ;
+        if ( r < worst )
+        {
+          worst = r ;
+          wfreq = f ;
+        }
+      }
+      CHECK ( aerr <= ALIAS_TOL, "%5d -> %5d Hz: aliases of %5.0f..%5.0f Hz %.1f dB or more down "
+              "(at %5.0f Hz), within %.2f dB of the design", t.in, t.out, t.out / 2.0 + 250.0,
+              t.in / 2.0, worst, wfreq, aerr ) ;
+    }
+    else                                              // Upsampling: images of the passband
+    {
+      for ( double f = 100.0 ; f <= PASS_EDGE * nyq ; f += 0.05 * nyq )
+      {
+        double img = t.in - f ;                       // First image
+        Resampler_Init ( t.in, t.out ) ;
+        std::vector<int16_t> out = convert ( sine ( f, t.in ), 1152, 4096 ) ;
+        if ( img > t.out / 2.0 )                      // Above the output Nyquist: folds back
+        {
+          img = t.out - img ;
+        }
+        double r = LEVEL - tone ( out, 0, img, t.out ) ;
+        if ( r < worst )
+        {
+          worst = r ;
+          wfreq = f ;
+        }
+      }
+      CHECK ( worst >= STOP_MIN, "%5d -> %5d Hz: images of the passband at least %.1f dB down (of %5.0f Hz)",
+              t.in, t.out, worst, wfreq ) ;
+    }
+    // Frame count and independence of the block size
+    {
+      std::vector<int16_t> in = sine ( 1000.0, t.in ) ;
+      Resampler_Init ( t.in, t.out ) ;
+      std::vector<int16_t> a = convert ( in, 1152, 4096 ) ;
+      Resampler_Init ( t.in, t.out ) ;
+      std::vector<int16_t> b = convert ( in, 37, 5 ) ;    // Small blocks, output buffer often full
+      long                 expect = (long)t.in * t.L / t.M ;
+      long                 got = a.size() / 2 ;
+      CHECK ( ( labs ( got - expect ) <= 1 ) && ( a == b ),
+              "%5d -> %5d Hz: %ld frames for %d, expected %ld, %s of the block size",
+              t.in, t.out, got, t.in, expect, ( a == b ) ? "independent" : "DEPENDS on" ) ;
+    }
+  }
+  CHECK ( Resampler_Init ( 44100, 44100 ) && ! Resampler_Active(), "44100 -> 44100 Hz: no conversion" ) ;
+  Resampler_Free() ;
+  return checks_failed ;
+}
@@ -0,0 +1,154 @@
+// test_sbr.cpp
+// Test of the SBR bypass of the AAC decoder (AACSetSBRBypass of aac_decoder.cpp) and of the SBR
+// modes of helixfuncs.h (helixSetSBRMode, helixChooseSBR and helixCheckSBR).  Built with the
+// codecs of codecs_ps (AAC_ENABLE_SBR and AAC_ENABLE_PS), see CMakeLists.txt.
+//  - aac_he_v2.aac (HE-AAC v2, see test_ps.cpp) with SBR bypassed gives the mono core AAC at
+//    22050 Hz, 1024 frames for every AAC frame, without errors.  The level is within CORE_TOL dB
+//    of that of (left+right)/2 of the decoded SBR and PS.
+//  - "off" always bypasses SBR, "on" never.  "auto" bypasses SBR if the free internal RAM is
+//    below SBR_MINHEAP when the stream starts, a mode for the preset overrides the default.
+//  - "auto" bypasses SBR after SBR_TESTFRAMES HE-AAC frames that take more than SBR_MAXLOAD
+//    percent of the frame time on average, not at SBR_MAXLOAD percent.  Core AAC frames and the
+//    other modes are not measured.
+//  - Through playChunk the stream plays at 44100 Hz with SBR and at 22050 Hz without, with half
+//    the frames of the output with SBR, at most one AAC frame apart.
+#include "hostdecode.h"
+#include "helixhost.h"
+#include "helixfuncs.h"
+
+#define HEFILE     "aac_he_v2.aac"
+#define NFRAMES    34                                 // AAC frames in aac_he_v2.aac
+#define CORE_TOL   3.0                                // Max. level difference core - SBR in dB
+#define PAD        -32768                             // Padding to flush i2sbuf
+
+
+//**************************************************************************************************
+//                                           P L A Y                                               *
+//**************************************************************************************************
+// Play HEFILE through playChunk in chunks of 32 bytes, return the number of frames sent to I2S.   *
+//**************************************************************************************************
+static int play()
+{
+  std::vector<uint8_t> buf = readFile ( HEFILE ) ;
+  uint8_t              chunk[32] ;
+  size_t               n ;
+
+  i2s_out.clear() ;
+  i2s_rate = 0 ;
+  audio_ct = "audio/aacp" ;
+  helixInit ( -1, -1 ) ;
+  for ( size_t i = 0 ; i < buf.size() ; i += 32 )
+  {
+    n = min ( (size_t)32, buf.size() - i ) ;
+    memset ( chunk, 0, sizeof(chunk) ) ;              // Last chunk is padded with zeroes
+    memcpy ( chunk, &buf[i], n ) ;
+    playChunk ( chunk ) ;
+  }
+  helixNextTrack() ;
+  n = i2s_out.size() ;
+  while ( i2s_out.size() == n )                       // Pad until i2sbuf is sent
+  {
+    outputSample ( PAD ) ;
+  }
+  while ( i2s_out.back() == PAD )                     // Remove the padding
+  {
+    i2s_out.pop_back() ;
+  }
+  return i2s_out.size() / 2 ;
+}
+
+
+//**************************************************************************************************
+//                                         C H O O S E                                             *
+//**************************************************************************************************
+// Start a stream with "free" bytes of free internal RAM, return true if SBR is bypassed.          *
+//**************************************************************************************************
+static bool choose ( size_t free )
+{
+  host_heap_free = free ;
+  helixChooseSBR() ;
+  return sbrbypass && AACGetSBRBypass() ;
+}
+
+
+//**************************************************************************************************
+//                                             M A I N                                             *
+//**************************************************************************************************
+int main()
+{
+  std::vector<uint8_t> buf = readFile ( HEFILE ) ;
+  std::vector<int16_t> mix ;                          // (left+right)/2 of the SBR output
+  decoded_t            full, core ;
+  double               lfull, lcore ;                 // Levels in dBFS
+  uint32_t             budget ;                       // Cycles of an HE-AAC frame at 44100 Hz
+  uint32_t             limit ;                        // SBR_MAXLOAD percent of that
+  int                  early = 0 ;                    // Bypass before SBR_TESTFRAMES frames
+  int                  frames ;
+  int                  fon ;                          // Frames played through playChunk with SBR
+
+  decodeBuffer ( "aac", buf.data(), buf.size(), full ) ;
+  decodeBuffer ( "aac", buf.data(), buf.size(), core, 0, true ) ;
+  CHECK ( ( core.rate == 22050 ) && ( core.channels == 1 ) && ( core.frames == NFRAMES ) &&
+          ( (int)core.pcm.size() == NFRAMES * 1024 ) && ( core.errors == 0 ),
+          HEFILE " SBR bypassed: %d Hz, %d channels, %d frames, %d samples, %d errors", core.rate,
+          core.channels, core.frames, (int)core.pcm.size(), core.errors ) ;
+  for ( size_t i = 0 ; i + 1 < full.pcm.size() ; i += 2 )
+  {
+    mix.push_back ( ( full.pcm[i] + full.pcm[i+1] ) / 2 ) ;
+  }
+  lfull = pcmRms ( mix, 1, 0, mix.size() ) ;
+  lcore = pcmRms ( core.pcm, 1, 0, core.pcm.size() ) ;
+  CHECK ( ( full.rate == 44100 ) && ( full.channels == 2 ) &&
+          ( fabs ( lcore - lfull ) <= CORE_TOL ),
+          HEFILE " SBR bypassed: level %.1f dBFS, with SBR and PS %.1f dBFS at %d Hz", lcore,
+          lfull, full.rate ) ;
+  printf ( "info: decode time with SBR and PS %.0f ns/frame, SBR bypassed %.0f ns/frame\n",
+           (double)full.cycles / full.frames, (double)core.cycles / core.frames ) ;
+
+  helixSetSBRMode ( "off", false ) ;
+  CHECK ( choose ( 1000000 ), "mode off: SBR bypassed with enough RAM" ) ;
+  helixSetSBRMode ( "on", false ) ;
+  CHECK ( ! choose ( 0 ), "mode on: SBR decoded without free RAM" ) ;
+  helixSetSBRMode ( "auto", false ) ;
+  CHECK ( choose ( SBR_MINHEAP - 1 ) && ! choose ( SBR_MINHEAP ), "mode auto: SBR bypassed "
+          "below %d bytes of free RAM, decoded at %d", SBR_MINHEAP, SBR_MINHEAP ) ;
+  helixSetSBRMode ( "on", true ) ;
+  CHECK ( ! choose ( 0 ), "mode on for the preset overrides auto" ) ;
+  helixSetSBRMode ( NULL, true ) ;
+  CHECK ( choose ( 0 ), "mode for the preset removed: auto again" ) ;
+
+  budget = (uint64_t)2048 * ESP.getCpuFreqMHz() * 1000000 / 44100 ;
+  limit = (uint64_t)budget * SBR_MAXLOAD / 100 ;
+  choose ( SBR_MINHEAP ) ;                            // Auto, decoded
+  for ( int i = 0 ; i < 2 * SBR_TESTFRAMES ; i++ )
+  {
+    early += helixCheckSBR ( limit, 2048 * 2, 2, 44100 ) ;
+    early += helixCheckSBR ( 4 * budget, 1024 * 2, 2, 44100 ) ;   // Core AAC, not measured
+  }
+  CHECK ( ! early && ! sbrbypass, "mode auto: SBR decoded at %d%% load", SBR_MAXLOAD ) ;
+  for ( frames = 1 ; frames <= SBR_TESTFRAMES ; frames++ )
+  {
+    if ( helixCheckSBR ( limit + 1, 2048 * 2, 2, 44100 ) )
+    {
+      break ;
+    }
+  }
+  CHECK ( ( frames == SBR_TESTFRAMES ) && sbrbypass && AACGetSBRBypass(), "mode auto: SBR "
+          "bypassed after %d frames above %d%% load", frames, SBR_MAXLOAD ) ;
+  helixSetSBRMode ( "on", false ) ;
+  choose ( SBR_MINHEAP ) ;
+  for ( int i = 0 ; i < 2 * SBR_TESTFRAMES ; i++ )
+  {
+    early += helixCheckSBR ( 2 * budget, 2048 * 2, 2, 44100 ) ;
+  }
+  CHECK ( ! early && ! sbrbypass, "mode on: SBR decoded at 200%% load" ) ;
+
+  host_heap_free = 1000000 ;
+  fon = play() ;
+  CHECK ( i2s_rate == 44100, "playChunk mode on: %d Hz, %d frames", i2s_rate, fon ) ;
+  helixSetSBRMode ( "off", false ) ;
+  frames = play() ;
+  CHECK ( ( i2s_rate == 22050 ) && ( abs ( 2 * frames - fon ) <= 2048 ), "playChunk mode off: "
+          "%d Hz, %d frames", i2s_rate, frames ) ;
+  return checks_failed ;
+}
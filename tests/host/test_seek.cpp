@@ -0,0 +1,346 @@
+// test_seek.cpp
+// Test of seeking in MP3 files on the SD card (include/SDseek.h).  The file is in memory, the
+// offsets of all frames are found with MP3GetFrameLength of the helix decoder.
+//  - Index: mp3_44k_stereo.mp3 (CBR) with its LAME tag made unreadable.  The index is built by
+//    seekScan from the data read for playing, in chunks of 32 bytes.  Every entry is the offset of
+//    frame i * step, seekFrameToOff gives the exact offset of every frame, seekOffToFrame the frame
+//    back within 1.  The index is saved and loaded from the cache on the "SD card".
+//  - seekScan completion: the index is complete at the end of the file and at an ID3v1 tag, not
+//    at garbage in the middle of the file.
+//  - seekAdd: when the index is full every second entry is removed and the step is doubled, the
+//    remaining entries are still the offset of frame i * step.
+//  - Xing TOC: mp3_22k_mono.mp3 (VBR).  seekFrameToOff interpolates the TOC within 1 byte of the
+//    exact interpolation, seekOffToFrame is its reverse within 1 frame.  Both are within TOC_FRAMES
+//    of the real frame, the TOC of a file of 60 frames has about the resolution of a frame.
+//  - seekSD: the data still in the queue and in the frame buffer of the decoder is not played yet.
+#include <map>                                        // Before helixhost.h, it defines map()
+#include "hosttest.h"
+#include "helixhost.h"
+
+#define DEC_HELIX                                     // Frame buffer in helixfuncs.h
+#define FILE_WRITE "w"
+#define TOC_FRAMES 2                                  // Max. error of the TOC in frames
+
+//**************************************************************************************************
+// What SDseek.h needs from SDcard.h, helixfuncs.h and main.cpp.  A file is a vector in memory.   *
+//**************************************************************************************************
+struct File
+{
+  std::vector<uint8_t>* d ;                           // Contents, NULL if not open
+  size_t                pos ;
+  File ( std::vector<uint8_t>* v = NULL ) : d ( v ), pos ( 0 ) {}
+  operator bool() const { return d != NULL ; }
+  size_t size() const { return d->size() ; }
+  size_t position() const { return pos ; }
+  bool   seek ( size_t p ) { pos = min ( p, d->size() ) ; return true ; }
+  void   close() {}
+  size_t read ( uint8_t* b, size_t n )
+  {
+    n = min ( n, d->size() - pos ) ;
+    memcpy ( b, d->data() + pos, n ) ;
+    pos += n ;
+    return n ;
+  }
+  size_t write ( const uint8_t* b, size_t n )
+  {
+    d->insert ( d->end(), b, b + n ) ;
+    return n ;
+  }
+} ;
+
+struct SDClass
+{
+  std::map<std::string, std::vector<uint8_t> > files ;
+  File open ( const String& name, const char* mode = "r" )
+  {
+    if ( *mode == 'w' )
+    {
+      files[name.s].clear() ;                         // Create or truncate
+    }
+    return ( files.count ( name.s ) ) ? File ( &files[name.s] ) : File() ;
+  }
+  bool mkdir ( const char* ) { return true ; }
+} ;
+
+enum qdata_type { QDATA, QSTARTSONG, QSTOPSONG } ;
+struct qdata_struct
+{
+  qdata_type datatyp ;
+  uint8_t    buf[32] ;
+} ;
+
+static SDClass                 SD ;
+static File                    mp3file ;
+static int                     mp3filelength ;
+static int                     mp3bcnt ;              // Bytes in the frame buffer
+static QueueHandle_t           dataqueue ;
+const char*                    STAG = "SDcard" ;
+static std::vector<qdata_type> commands ;             // Given to queueToPt
+
+uint32_t millis() { return 0 ; }
+void     queueToPt ( qdata_type func ) { commands.push_back ( func ) ; }
+
+#include "SDseek.h"
+
+
+//**************************************************************************************************
+//                                        O F F S E T S                                            *
+//**************************************************************************************************
+// Offsets of all frames of a file from start, with MP3GetFrameLength.  The end of the last frame  *
+// is added.                                                                                       *
+//**************************************************************************************************
+static std::vector<uint32_t> offsets ( std::vector<uint8_t>& buf, uint32_t start )
+{
+  std::vector<uint32_t> offs ;
+  uint32_t              p = start ;
+  int                   len ;
+
+  while ( ( p + 4 <= buf.size() ) && ( ( len = MP3GetFrameLength ( &buf[p] ) ) > 0 ) &&
+          ( p + len <= buf.size() ) )
+  {
+    offs.push_back ( p ) ;
+    p += len ;
+  }
+  offs.push_back ( p ) ;
+  return offs ;
+}
+
+
+//**************************************************************************************************
+//                                           O P E N                                               *
+//**************************************************************************************************
+// "Open" a file in memory like SDcard.h does: positioned after the ID3 tag, seekInit called.      *
+// Returns the size of the ID3 tag.                                                                *
+//**************************************************************************************************
+static uint32_t open ( std::vector<uint8_t>& buf, const char* path )
+{
+  uint32_t id3 = 0 ;
+
+  if ( memcmp ( buf.data(), "ID3", 3 ) == 0 )
+  {
+    id3 = 10 + ( ( buf[6] << 21 ) | ( buf[7] << 14 ) | ( buf[8] << 7 ) | buf[9] ) ;
+  }
+  mp3file = File ( &buf ) ;
+  mp3file.seek ( id3 ) ;
+  seekInit ( path ) ;
+  return id3 ;
+}
+
+
+//**************************************************************************************************
+//                                           P L A Y                                               *
+//**************************************************************************************************
+// Read the rest of the file in chunks of 32 bytes and give them to seekScan, like the SD task.    *
+//**************************************************************************************************
+static void play()
+{
+  uint8_t chunk[32] ;
+  size_t  n ;
+
+  while ( ( n = mp3file.read ( chunk, sizeof(chunk) ) ) > 0 )
+  {
+    seekScan ( chunk, n ) ;
+  }
+}
+
+
+//**************************************************************************************************
+//                                      T E S T I N D E X                                          *
+//**************************************************************************************************
+static void testIndex()
+{
+  std::vector<uint8_t>  buf = readFile ( "mp3_44k_stereo.mp3" ) ;
+  std::vector<uint32_t> offs ;
+  uint32_t              frames ;
+  uint32_t              off ;
+  int                   bad = 0 ;
+  int                   far = 0 ;
+  bool                  exact ;
+
+  buf[44+36] = 'X' ;                                  // "Info" of the LAME tag becomes "Xnfo"
+  offs = offsets ( buf, open ( buf, "/a.mp3" ) ) ;
+  frames = offs.size() - 1 ;
+  CHECK ( sk.ok && ! sk.toc && ! sk.cached && sk.scan && ( sk.start == offs[0] ) &&
+          ( sk.rate == 44100 ) && ( sk.spf == 1152 ), "CBR: first frame at %d, %d Hz, index "
+          "while playing", sk.start, sk.rate ) ;
+  play() ;
+  for ( uint32_t i = 0 ; i < sk.nidx ; i++ )
+  {
+    bad += ( sk.idx[i] != offs[i * sk.step] ) ;
+  }
+  CHECK ( sk.complete && ( sk.frames == frames ) && ( sk.step == SEEK_STEP ) &&
+          ( sk.nidx == ( frames + SEEK_STEP - 1 ) / SEEK_STEP ) && ( bad == 0 ),
+          "CBR: index of %d frames complete, %d entries, %d wrong", sk.frames, sk.nidx, bad ) ;
+  bad = 0 ;
+  for ( uint32_t f = 0 ; f < frames ; f++ )
+  {
+    off = seekFrameToOff ( f, &exact ) ;
+    bad += ( ! exact ) || ( off != offs[f] ) ;
+    far += abs ( (int)seekOffToFrame ( offs[f] ) - (int)f ) > 1 ;
+  }
+  CHECK ( bad == 0, "CBR: seekFrameToOff exact for %d of %d frames", frames - bad, frames ) ;
+  CHECK ( far == 0, "CBR: seekOffToFrame within 1 for %d of %d frames", frames - far, frames ) ;
+  seekSave ( "/a.mp3" ) ;
+  open ( buf, "/a.mp3" ) ;
+  CHECK ( sk.cached && ! sk.scan && ( sk.nidx == ( frames + SEEK_STEP - 1 ) / SEEK_STEP ) &&
+          ( sk.frames == frames ) && ( sk.idx[sk.nidx - 1] == offs[( sk.nidx - 1 ) * SEEK_STEP] ),
+          "CBR: index loaded from %s, %d entries", seekCacheName ( "/a.mp3" ).c_str(), sk.nidx ) ;
+  buf.push_back ( 0 ) ;                               // Other size
+  open ( buf, "/a.mp3" ) ;
+  CHECK ( ! sk.cached && sk.scan, "CBR: cached index not used for a file of another size" ) ;
+}
+
+
+//**************************************************************************************************
+//                                    T E S T C O M P L E T E                                      *
+//**************************************************************************************************
+// seekScan must see the end of the audio at the end of the file or at an ID3v1 tag, not at a      *
+// frame that is not valid in the middle of the file.                                              *
+//**************************************************************************************************
+static void testComplete()
+{
+  std::vector<uint8_t>  buf = readFile ( "mp3_44k_stereo.mp3" ) ;
+  std::vector<uint8_t>  tag ( 128, ' ' ) ;
+  std::vector<uint32_t> offs ;
+  uint32_t              frames ;
+  uint32_t              est ;                         // Estimated number of frames
+
+  buf[44+36] = 'X' ;                                  // No TOC
+  offs = offsets ( buf, 44 ) ;
+  frames = offs.size() - 1 ;
+  buf.resize ( offs.back() ) ;                        // Only complete frames
+  memcpy ( tag.data(), "TAG", 3 ) ;
+  buf.insert ( buf.end(), tag.begin(), tag.end() ) ;
+  open ( buf, "/b.mp3" ) ;
+  play() ;
+  CHECK ( sk.complete && ! sk.scan && ( sk.frames == frames ), "ID3v1 tag: index complete, %d "
+          "frames of %d", sk.frames, frames ) ;
+  buf.insert ( buf.begin() + offs[frames / 2], 1000, 0x55 ) ;   // Garbage in the middle
+  open ( buf, "/c.mp3" ) ;
+  est = sk.frames ;
+  play() ;
+  CHECK ( ! sk.complete && ! sk.scan && ( sk.frames == est ) && ( sk.kframe == frames / 2 - 1 ),
+          "garbage after frame %d: index not complete, last frame %d, length estimated", frames / 2,
+          sk.kframe ) ;
+}
+
+
+//**************************************************************************************************
+//                                       T E S T A D D                                             *
+//**************************************************************************************************
+// Fill the index beyond SEEK_MAXIDX entries with seekAdd, frame f is at offset 1000 * f + 7.     *
+//**************************************************************************************************
+static void testAdd()
+{
+  uint32_t n = SEEK_MAXIDX * SEEK_STEP * 2 + 100 ;    // Frames, the step is doubled twice
+  int      bad = 0 ;
+
+  memset ( &sk, 0, sizeof(sk) ) ;
+  sk.step = SEEK_STEP ;
+  for ( uint32_t f = 0 ; f < n ; f++ )
+  {
+    seekAdd ( f, 1000 * f + 7 ) ;
+    seekAdd ( f / 2, 1 ) ;                            // Not the next entry, ignored
+  }
+  for ( uint32_t i = 0 ; i < sk.nidx ; i++ )
+  {
+    bad += ( sk.idx[i] != 1000 * i * sk.step + 7 ) ;
+  }
+  CHECK ( ( sk.step == SEEK_STEP * 4 ) && ( sk.nidx == ( n + sk.step - 1 ) / sk.step ) &&
+          ( sk.nidx <= SEEK_MAXIDX ) && ( bad == 0 ), "seekAdd %d frames: step %d, %d entries, "
+          "%d wrong", n, sk.step, sk.nidx, bad ) ;
+}
+
+
+//**************************************************************************************************
+//                                       T E S T T O C                                             *
+//**************************************************************************************************
+static void testToc()
+{
+  std::vector<uint8_t>  buf = readFile ( "mp3_22k_mono.mp3" ) ;
+  std::vector<uint32_t> offs ;
+  uint32_t              frames ;
+  uint32_t              off ;
+  double                p, a, b, x ;                  // Exact interpolation of the TOC
+  int                   i ;
+  int                   err = 0 ;                     // Largest error, bytes
+  int                   rev = 0 ;                     // Largest error of the reverse, frames
+  int                   far = 0 ;                     // Largest error to the real frame
+  int                   ffar = 0 ;                    // Same for the reverse
+  int                   g ;                           // Real frame at an offset
+  bool                  exact ;
+
+  offs = offsets ( buf, open ( buf, "/d.mp3" ) ) ;
+  frames = offs.size() - 1 ;
+  CHECK ( sk.ok && sk.toc && ! sk.scan && ( sk.rate == 22050 ) && ( sk.spf == 576 ) &&
+          ( abs ( (int)sk.frames - (int)frames ) <= 1 ), "VBR: Xing TOC, %d frames, %d in the "
+          "file, %d Hz", sk.frames, frames, sk.rate ) ;
+  for ( uint32_t f = 0 ; f < sk.frames ; f++ )
+  {
+    off = seekFrameToOff ( f, &exact ) ;
+    p = f * 100.0 / sk.frames ;
+    i = min ( (int)p, 99 ) ;
+    a = sk.tocbuf[i] ;
+    b = ( i < 99 ) ? sk.tocbuf[i+1] : 256.0 ;
+    x = sk.start + ( a + ( b - a ) * ( p - i ) ) * sk.bytes / 256.0 ;
+    err = max ( err, (int)fabs ( off - x ) ) ;
+    rev = max ( rev, abs ( (int)seekOffToFrame ( off ) - (int)f ) ) ;
+    for ( g = 0 ; ( g < (int)frames - 1 ) && ( offs[g + 1] <= off ) ; g++ ) ;
+    far = max ( far, abs ( g - (int)f ) ) ;
+    ffar = max ( ffar, abs ( (int)seekOffToFrame ( offs[f] ) - (int)f ) ) ;
+  }
+  CHECK ( ( err <= 1 ) && ( rev <= 1 ), "VBR: TOC interpolation within %d bytes, reverse within "
+          "%d frames", err, rev ) ;
+  CHECK ( ( far <= TOC_FRAMES ) && ( ffar <= TOC_FRAMES ), "VBR: seekFrameToOff within %d frames "
+          "of the real frame, seekOffToFrame within %d", far, ffar ) ;
+}
+
+
+//**************************************************************************************************
+//                                       T E S T S E E K                                           *
+//**************************************************************************************************
+// Skip 0 seconds with 3 chunks in the queue and 500 bytes in the frame buffer: the frame played   *
+// now is found.                                                                                   *
+//**************************************************************************************************
+static void testSeek()
+{
+  std::vector<uint8_t>  buf = readFile ( "mp3_44k_stereo.mp3" ) ;
+  std::vector<uint32_t> offs ;
+  qdata_struct          q = { QDATA, { 0 } } ;
+  uint32_t              pos ;                         // Read position
+  uint32_t              played ;                      // Offset now playing
+
+  buf[44+36] = 'X' ;                                  // No TOC, index while playing
+  offs = offsets ( buf, open ( buf, "/e.mp3" ) ) ;
+  play() ;                                            // Complete index
+  dataqueue = xQueueCreate ( 10, sizeof(qdata_struct) ) ;
+  for ( int i = 0 ; i < 3 ; i++ )
+  {
+    xQueueSend ( dataqueue, &q, 0 ) ;
+  }
+  mp3bcnt = 500 ;
+  played = offs[40] ;
+  pos = played + 3 * sizeof(q.buf) + mp3bcnt ;
+  mp3file.seek ( pos ) ;
+  commands.clear() ;
+  seekSD ( 0, true ) ;
+  CHECK ( ( sk.fnum == seekOffToFrame ( played ) ) && ( sk.next == offs[sk.fnum] ) &&
+          ( mp3file.position() == sk.next - sk.prime ) && ( commands.size() == 2 ) &&
+          ( commands[0] == QSTOPSONG ) && ( commands[1] == QSTARTSONG ), "seekSD: read at %d, "
+          "queue and frame buffer not played, restarted at frame %d, offset %d", pos, sk.fnum,
+          sk.next ) ;
+}
+
+
+//**************************************************************************************************
+//                                             M A I N                                             *
+//**************************************************************************************************
+int main()
+{
+  testIndex() ;
+  testComplete() ;
+  testAdd() ;
+  testToc() ;
+  testSeek() ;
+  return checks_failed ;
+}
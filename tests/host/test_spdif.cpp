@@ -0,0 +1,290 @@
+// test_spdif.cpp
+// Test of the S/PDIF encoder (spdif_encoder.cpp) with a reference decoder that works on the cells
+// of the biphase mark code, as a receiver does (IEC 60958-1).  All output of the encoder is one
+// stream, the position in the channel status block is counted from the first frame.
+//  - Every subframe starts with the right preamble: B for the left channel of frame 0 of the
+//    192 frames block, M for other left channels, W for the right channel.
+//  - Every time slot after the preamble starts with a transition, the parity of slots 4..31 is
+//    even, the V (valid) and U (user) bits are 0.
+//  - The audio word is the sample.  With 16 bits samples only slot 4 (LSB) may be set, for parity.
+//  - The C bits of a block are the channel status of the format set (IEC 60958-3): consumer, PCM,
+//    copying permitted, no pre-emphasis, the code of the sample rate and the word length.
+// The samples are random and the edge values, in blocks of other sizes, for 16 and 24 bits and
+// with changes of the format in the middle of a block.
+#include "hosttest.h"
+#include "spdif_encoder.h"
+
+#define MAXFRAMES  1000                               // Largest block given to the encoder
+
+struct expect_t                                       // What a subframe must contain
+{
+  int32_t  sample ;                                   // 16 or 24 bits sample
+  int      bits ;                                     // 16 or 24
+  uint32_t rate ;                                     // Format set for this frame
+  int      fmtbits ;                                  // Word length of the format set
+} ;
+
+static std::vector<uint32_t> words ;                  // All output of the encoder
+static std::vector<expect_t> expected ;               // One for every subframe
+static uint32_t              cur_rate = 44100 ;       // Format set, the default of the encoder
+static int                   cur_bits = 16 ;
+static uint32_t              seed = 2026 ;
+
+
+//**************************************************************************************************
+//                                          R A N D O M                                            *
+//**************************************************************************************************
+// Random sample of "bits" bits, one in 16 is an edge value.                                       *
+//**************************************************************************************************
+static int32_t random ( int bits )
+{
+  static const int32_t edges[] = { 0, -1, 1, 0x7FFFFF, -0x800000, 0x555555, -0x555556, 0x100 } ;
+  int32_t              r ;
+
+  seed = seed * 1664525 + 1013904223 ;                // LCG of Numerical Recipes
+  if ( ( seed >> 28 ) == 0 )
+  {
+    r = edges[( seed >> 8 ) & 7] ;
+  }
+  else
+  {
+    r = (int32_t)seed >> 8 ;                          // 24 bits
+  }
+  return ( bits == 16 ) ? (int32_t)(int16_t)( r >> 8 ) : r ;
+}
+
+
+//**************************************************************************************************
+//                                          E N C O D E                                            *
+//**************************************************************************************************
+// Encode random frames with Spdif_Encode16 or Spdif_Encode24, keep the output and expectations.   *
+//**************************************************************************************************
+static void encode ( int bits, int frames )
+{
+  static int16_t  in16[2 * MAXFRAMES] ;
+  static int32_t  in24[2 * MAXFRAMES] ;
+  static uint32_t out[SPDIF_WORDS * MAXFRAMES] ;
+  int             n ;
+
+  for ( int i = 0 ; i < 2 * frames ; i++ )
+  {
+    in24[i] = random ( bits ) ;
+    in16[i] = in24[i] ;
+    expected.push_back ( { in24[i], bits, cur_rate, cur_bits } ) ;
+  }
+  if ( bits == 16 )
+  {
+    n = Spdif_Encode16 ( in16, frames, out ) ;
+  }
+  else
+  {
+    n = Spdif_Encode24 ( in24, frames, out ) ;
+  }
+  words.insert ( words.end(), out, out + n ) ;
+}
+
+
+//**************************************************************************************************
+//                                       S E T F O R M A T                                         *
+//**************************************************************************************************
+static void setFormat ( uint32_t rate, int bits )
+{
+  Spdif_SetFormat ( rate, bits ) ;
+  cur_rate = rate ;
+  cur_bits = bits ;
+}
+
+
+//**************************************************************************************************
+//                                     C H A N N E L B I T                                         *
+//**************************************************************************************************
+// Channel status bit n (0..191) of a format, from the tables of IEC 60958-3 in the order of the   *
+// standard: the first character of a field is its lowest bit number.                             *
+//**************************************************************************************************
+static int channelBit ( uint32_t rate, int bits, int n )
+{
+  static const struct { uint32_t rate ; const char* code ; } fs[] =
+  {
+    { 44100, "0000" }, { 48000, "0100" }, { 32000, "1100" }, { 22050, "0010" }, { 24000, "0110" },
+    { 88200, "0001" }, { 96000, "0101" }, { 176400, "0011" }, { 192000, "0111" }
+  } ;
+  const char* code = "1000" ;                         // Not indicated
+
+  for ( auto& f : fs )
+  {
+    if ( f.rate == rate )
+    {
+      code = f.code ;
+    }
+  }
+  if ( n == 2 )                                       // Copying permitted
+  {
+    return 1 ;
+  }
+  if ( ( n >= 24 ) && ( n <= 27 ) )                   // Sampling frequency
+  {
+    return code[n - 24] == '1' ;
+  }
+  if ( ( n >= 32 ) && ( n <= 35 ) )                   // Word length: max. 24 bits 24, max. 20 bits 16
+  {
+    return ( ( bits == 24 ) ? "1101" : "0100" )[n - 32] == '1' ;
+  }
+  return 0 ;                                          // Consumer, PCM, no emphasis, mode 0,
+}                                                     // general category, clock level II
+
+
+//**************************************************************************************************
+//                                            C E L L                                              *
+//**************************************************************************************************
+// Cell n of the output, the I2S words are sent MSB first.                                         *
+//**************************************************************************************************
+static int cell ( size_t n )
+{
+  return ( words[n / 32] >> ( 31 - n % 32 ) ) & 1 ;
+}
+
+
+//**************************************************************************************************
+//                                          D E C O D E                                            *
+//**************************************************************************************************
+// Decode subframe k of the output and check it against expected[k].  The first subframe starts   *
+// at cell 8, after the VUCP cells of the subframe before.  Returns an error message or NULL.     *
+//**************************************************************************************************
+static const char* decode ( size_t k )
+{
+  static const uint8_t pre[3] = { 0xE8, 0xE2, 0xE4 } ; // B, M and W after a low cell
+  const expect_t&      e = expected[k] ;
+  size_t               c0 = 8 + 64 * k ;              // First cell of the subframe
+  int                  frame = k / 2 ;
+  int                  level = cell ( c0 - 1 ) ;      // Level before the preamble
+  int                  p = 0 ;                        // Preamble
+  int                  ones = 0 ;                     // For the parity
+  uint32_t             data = 0 ;                     // Slots 4..27
+  int                  slot[32] ;
+
+  for ( int i = 0 ; i < 8 ; i++ )
+  {
+    p = ( p << 1 ) | ( cell ( c0 + i ) ^ level ) ;
+  }
+  if ( p != pre[( k & 1 ) ? 2 : ( frame % SPDIF_FRAMES ) ? 1 : 0] )
+  {
+    return "wrong preamble" ;
+  }
+  level = cell ( c0 + 7 ) ;
+  for ( int s = 4 ; s < 32 ; s++ )
+  {
+    int a = cell ( c0 + 2 * s ) ;
+    int b = cell ( c0 + 2 * s + 1 ) ;
+    if ( a == level )
+    {
+      return "no transition at the start of a slot" ;
+    }
+    slot[s] = ( a != b ) ;
+    ones += slot[s] ;
+    level = b ;
+  }
+  if ( ones & 1 )
+  {
+    return "odd parity" ;
+  }
+  if ( slot[28] || slot[29] )
+  {
+    return "V or U bit set" ;
+  }
+  for ( int s = 27 ; s >= 4 ; s-- )
+  {
+    data = ( data << 1 ) | slot[s] ;
+  }
+  if ( e.bits == 16 )
+  {
+    if ( ( (int32_t)( data << 8 ) >> 16 ) != e.sample || ( data & 0xFE ) )
+    {
+      return "wrong 16 bits sample" ;
+    }
+  }
+  else if ( ( (int32_t)( data << 8 ) >> 8 ) != e.sample )
+  {
+    return "wrong 24 bits sample" ;
+  }
+  if ( slot[30] != channelBit ( e.rate, e.fmtbits, frame % SPDIF_FRAMES ) )
+  {
+    return "wrong C bit" ;
+  }
+  return NULL ;
+}
+
+
+//**************************************************************************************************
+//                                        C H E C K P A R T                                        *
+//**************************************************************************************************
+// Decode subframes [from, to> and report the number of bad ones and the first error.              *
+//**************************************************************************************************
+static void checkPart ( const char* name, size_t from, size_t to )
+{
+  char        first[80] = "" ;
+  int         bad = 0 ;
+
+  for ( size_t k = from ; k < to ; k++ )
+  {
+    const char* err = decode ( k ) ;
+    if ( err )
+    {
+      if ( bad++ == 0 )
+      {
+        snprintf ( first, sizeof(first), ", first: %s in subframe %d", err, (int)k ) ;
+      }
+    }
+  }
+  CHECK ( ( bad == 0 ) && ( to > from ), "%s: %d subframes, %d bad%s", name, (int)( to - from ),
+          bad, first ) ;
+}
+
+
+//**************************************************************************************************
+//                                             M A I N                                             *
+//**************************************************************************************************
+int main()
+{
+  static const int      chunks[] = { 1, 7, 191, 192, 500, 1000, 2, 64 } ;
+  static const uint32_t rates[] = { 44100, 48000, 32000, 22050, 24000, 88200, 96000, 176400,
+                                    192000, 11025 } ;
+  size_t                part[5] ;                     // First subframe of every part
+
+  part[0] = 0 ;                                       // 16 bits, format not set: 44100 Hz
+  for ( int n : chunks )
+  {
+    encode ( 16, n ) ;
+  }
+  part[1] = expected.size() ;                         // 24 bits
+  setFormat ( 48000, 24 ) ;
+  for ( int n : chunks )
+  {
+    encode ( 24, n ) ;
+  }
+  part[2] = expected.size() ;                         // Changes of the format within a block,
+  for ( int i = 0 ; i < 100 ; i++ )                   // 16 bits after odd parity of 24 bits
+  {
+    setFormat ( 96000, 24 ) ;
+    encode ( 24, 1 + i % 5 ) ;
+    setFormat ( 44100, 16 ) ;
+    encode ( 16, 1 + i % 3 ) ;
+  }
+  part[3] = expected.size() ;                         // All rates, a full block each
+  for ( uint32_t rate : rates )
+  {
+    for ( int bits = 16 ; bits <= 24 ; bits += 8 )
+    {
+      setFormat ( rate, bits ) ;
+      encode ( bits, SPDIF_FRAMES + 13 ) ;
+    }
+  }
+  part[4] = expected.size() ;
+  encode ( 16, 1 ) ;                                  // The VUCP cells of the last subframe
+  checkPart ( "16 bits", part[0], part[1] ) ;
+  checkPart ( "24 bits", part[1], part[2] ) ;
+  checkPart ( "format changes in a block", part[2], part[3] ) ;
+  checkPart ( "channel status of all rates", part[3], part[4] ) ;
+  CHECK ( words.size() == expected.size() * 2, "%d words for %d subframes", (int)words.size(),
+          (int)expected.size() ) ;
+  return checks_failed ;
+}
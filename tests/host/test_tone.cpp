@@ -0,0 +1,146 @@
+// test_tone.cpp
+// Test of the bass/treble tone control of helixfuncs.h (helixToneShelf, helixTone).
+//  - The coefficients must give the shelf of the Audio EQ cookbook: the full gain at DC (bass) or
+//    at Nyquist (treble), 0 dB at the other end and half the gain at the corner frequency.
+//  - The fixed point filter must have the response of its coefficients, measured with sines.
+//  - A tone setting of 0 dB must leave the samples untouched, a boost must saturate, not wrap.
+#include "hosttest.h"
+#include "helixhost.h"
+#include "helixfuncs.h"
+
+#define COEF_TOL   0.01                               // Max. error of the coefficients in dB
+#define GAIN_TOL   0.05                               // Max. error of the filter in dB
+
+struct tonetest_t
+{
+  uint8_t     nib[4] ;                                // Setting, see player_setTone
+  int         filt ;                                  // Filter that is on, 0 = treble, 1 = bass
+  double      db ;                                    // Gain of the shelf
+  double      freq ;                                  // Corner frequency
+} ;
+
+static const tonetest_t tests[] =
+{
+  { {  7,  3,  0,  0 }, 0,  10.5,  3000 },            // Treble +10.5 dB above 3 kHz
+  { {  8, 10,  0,  0 }, 0, -12.0, 10000 },            // Treble -12 dB above 10 kHz
+  { {  0,  0, 15, 10 }, 1,  15.0,   100 },            // Bass +15 dB below 100 Hz
+  { {  0,  0,  6, 15 }, 1,   6.0,   150 }             // Bass +6 dB below 150 Hz
+} ;
+
+
+//**************************************************************************************************
+//                                      R E S P O N S E                                            *
+//**************************************************************************************************
+// Gain in dB of a biquad at frequency f, from the fixed point coefficients.                       *
+//**************************************************************************************************
+static double response ( const biquad_t& b, double f, double rate )
+{
+  const double q = (double)( 1 << TONE_QBITS ) ;
+  double       w = 2.0 * M_PI * f / rate ;
+  double       nr = b.b0 / q + b.b1 / q * cos ( w ) + b.b2 / q * cos ( 2 * w ) ;
+  double       ni = -b.b1 / q * sin ( w ) - b.b2 / q * sin ( 2 * w ) ;
+  double       dr = 1.0 + b.a1 / q * cos ( w ) + b.a2 / q * cos ( 2 * w ) ;
+  double       di = -b.a1 / q * sin ( w ) - b.a2 / q * sin ( 2 * w ) ;
+
+  return 10.0 * log10 ( ( nr * nr + ni * ni ) / ( dr * dr + di * di ) ) ;
+}
+
+
+//**************************************************************************************************
+//                                       M E A S U R E                                             *
+//**************************************************************************************************
+// Send a stereo sine through helixTone in blocks like playChunk does, return the gain in dB of    *
+// the left channel after the filter has settled.  The right channel has the same signal.          *
+//**************************************************************************************************
+static double measure ( double f, double rate, double db )
+{
+  int                  n = (int)rate ;                // 1 second
+  int                  per = (int)lround ( rate / f * round ( f / 4 ) ) ;  // About 0.25 s, whole periods
+  std::vector<int16_t> in ( 2 * n ), out ;
+  double               a = 32767.0 * pow ( 10.0, db / 20.0 ) ;
+
+  for ( int i = 0 ; i < n ; i++ )
+  {
+    in[2*i] = in[2*i+1] = (int16_t)lround ( a * sin ( 2 * M_PI * f * i / rate ) ) ;
+  }
+  out = in ;
+  for ( int i = 0 ; i < n ; i += 1152 )
+  {
+    helixTone ( &out[2*i], 2 * min ( 1152, n - i ), 2 ) ;
+  }
+  std::vector<int16_t> tin ( in.end() - 2 * per, in.end() ) ;
+  std::vector<int16_t> tout ( out.end() - 2 * per, out.end() ) ;
+  return pcmRms ( tout, 2, 0, per ) - pcmRms ( tin, 2, 0, per ) ;
+}
+
+
+//**************************************************************************************************
+//                                             M A I N                                             *
+//**************************************************************************************************
+int main()
+{
+  static const uint32_t rates[] = { 44100, 48000 } ;
+  static const double   freqs[] = { 40, 100, 300, 1000, 3000, 6000, 10000, 16000 } ;
+
+  for ( uint32_t rate : rates )
+  {
+    for ( const tonetest_t& t : tests )
+    {
+      player_setTone ( (uint8_t*)t.nib ) ;
+      helixToneSetup ( rate ) ;
+      const biquad_t& b = tonefilt[t.filt] ;
+      double          full = response ( b, t.filt ? 0.0 : rate / 2.0, rate ) ;
+      double          flat = response ( b, t.filt ? rate / 2.0 : 0.0, rate ) ;
+      double          corner = response ( b, t.freq, rate ) ;
+      double          err = 0.0 ;                     // Largest error of the filter
+
+      CHECK ( b.on && ! tonefilt[1 - t.filt].on &&
+              ( fabs ( full - t.db ) <= COEF_TOL ) && ( fabs ( flat ) <= COEF_TOL ) &&
+              ( fabs ( corner - t.db / 2 ) <= COEF_TOL ),
+              "%5d Hz %s %+5.1f dB at %5.0f Hz: %+.3f / %+.3f / %+.3f dB at end / other end / corner",
+              rate, t.filt ? "bass  " : "treble", t.db, t.freq, full, flat, corner ) ;
+      for ( double f : freqs )
+      {
+        double g = measure ( f, rate, -20.0 ) - response ( b, f, rate ) ;
+        err = max ( err, fabs ( g ) ) ;
+      }
+      CHECK ( err <= GAIN_TOL, "%5d Hz %s %+5.1f dB: filter within %.3f dB of its coefficients",
+              rate, t.filt ? "bass  " : "treble", t.db, err ) ;
+    }
+  }
+  // No tone: the samples must not change
+  {
+    static const uint8_t off[4] = { 0, 5, 0, 10 } ;
+    std::vector<int16_t> pcm ;
+    player_setTone ( (uint8_t*)off ) ;
+    helixToneSetup ( 44100 ) ;
+    for ( int i = 0 ; i < 4000 ; i++ )
+    {
+      pcm.push_back ( (int16_t)( i * 7919 ) ) ;
+    }
+    std::vector<int16_t> in ( pcm ) ;
+    helixTone ( pcm.data(), pcm.size(), 2 ) ;
+    CHECK ( ! tonefilt[0].on && ! tonefilt[1].on && ( pcm == in ), "0 dB: output equals input" ) ;
+  }
+  // Bass boost of a full scale 40 Hz sine: saturates at the limits, never wraps around
+  {
+    static const uint8_t boost[4] = { 0, 0, 15, 10 } ;
+    std::vector<int16_t> pcm ;
+    int                  step = 0 ;                   // Largest step between two samples
+    player_setTone ( (uint8_t*)boost ) ;
+    helixToneSetup ( 44100 ) ;
+    for ( int i = 0 ; i < 44100 ; i++ )
+    {
+      pcm.push_back ( (int16_t)lround ( 32000 * sin ( 2 * M_PI * 40 * i / 44100.0 ) ) ) ;
+    }
+    helixTone ( pcm.data(), pcm.size(), 1 ) ;
+    for ( size_t i = 1 ; i < pcm.size() ; i++ )       // A wrap is a step of about 65536
+    {
+      step = max ( step, abs ( pcm[i] - pcm[i-1] ) ) ;
+    }
+    CHECK ( ( step < 2000 ) && ( *std::max_element ( pcm.begin(), pcm.end() ) == 32767 ) &&
+            ( *std::min_element ( pcm.begin(), pcm.end() ) == -32768 ),
+            "+15 dB bass, full scale: saturated, largest step %d", step ) ;
+  }
+  return checks_failed ;
+}
@@ -0,0 +1,133 @@
+// test_vorbis.cpp
+// Test of the Ogg Vorbis decoder (vorbis_decoder.cpp, ogg_demux.cpp) against FFmpeg, which decodes
+// Vorbis in floating point.  test_decode checks the hash and the level of the whole files.
+//  - The level of every block of 4096 frames must be within BLOCK_TOL dB of the level of the same
+//    block decoded by FFmpeg (corpus/vorbis_blocks.txt), so an error in one block is seen.
+//  - The number of frames must be the number of FFmpeg: the last block is cut at the granule
+//    position of the last page.
+//  - The output must not depend on how the stream is cut in pieces.
+//  - A chained stream (a mono and a stereo track) gives both tracks with their own format.
+#include "hostdecode.h"
+#include "vorbis_decoder.h"
+
+#define BLOCK      4096                               // Frames per block of vorbis_blocks.txt
+#define BLOCK_TOL  0.01                               // Max. difference of the level in dB
+
+struct vbfile_t
+{
+  const char* name ;                                  // File in the corpus
+  int         frames ;                                // Number of frames of FFmpeg
+} ;
+
+static const vbfile_t files[] =
+{
+  { "vorbis_44k_stereo.ogg", 66150 },
+  { "vorbis_22k_mono.ogg",   33075 }
+} ;
+
+
+//**************************************************************************************************
+//                                      B L O C K L E V E L                                        *
+//**************************************************************************************************
+// RMS level in dBFS of one channel of block b, over the frames that are in the block.             *
+//**************************************************************************************************
+static double blockLevel ( const decoded_t& d, int b, int ch )
+{
+  size_t               first = (size_t)b * BLOCK * d.channels ;
+  size_t               last = min ( d.pcm.size(), first + BLOCK * d.channels ) ;
+  std::vector<int16_t> part ( d.pcm.begin() + first, d.pcm.begin() + last ) ;
+
+  return pcmRms ( part, d.channels, ch, part.size() / d.channels ) ;
+}
+
+
+//**************************************************************************************************
+//                                             M A I N                                             *
+//**************************************************************************************************
+int main()
+{
+  static const int chunks[] = { 1, 7, 32, 100, 4096 } ;
+  std::string      path = std::string ( CORPUS ) + "/vorbis_blocks.txt" ;
+  FILE*            f = fopen ( path.c_str(), "r" ) ;
+  char             line[256] ;
+  char             name[64] ;
+  int              block ;
+  double           rms[2] ;
+  int              n ;
+
+  if ( f == NULL )
+  {
+    printf ( "Cannot open %s\n", path.c_str() ) ;
+    return 1 ;
+  }
+  for ( const vbfile_t& v : files )
+  {
+    std::vector<uint8_t> buf = readFile ( v.name ) ;
+    decoded_t            d ;
+    double               worst = 0.0 ;                // Largest difference of a block level
+    int                  blocks = 0 ;                 // Blocks compared
+    bool                 same = true ;                // Output independent of the chunk size
+
+    decodeBuffer ( "ogg", buf.data(), buf.size(), d ) ;
+    CHECK ( ( (int)d.pcm.size() == v.frames * d.channels ) && ( d.errors == 0 ),
+            "%s: %d frames, FFmpeg %d, %d errors", v.name, (int)d.pcm.size() / max ( 1, d.channels ),
+            v.frames, d.errors ) ;
+    rewind ( f ) ;
+    while ( fgets ( line, sizeof(line), f ) )
+    {
+      n = sscanf ( line, "%63s %d %lf %lf", name, &block, &rms[0], &rms[1] ) ;
+      if ( ( n < 3 ) || ( name[0] == '#' ) || strcmp ( name, v.name ) )
+      {
+        continue ;
+      }
+      for ( int ch = 0 ; ch < n - 2 ; ch++ )
+      {
+        worst = max ( worst, fabs ( blockLevel ( d, block, ch ) - rms[ch] ) ) ;
+      }
+      blocks++ ;
+    }
+    CHECK ( ( blocks > 0 ) && ( worst <= BLOCK_TOL ), "%s: %d blocks within %.4f dB of FFmpeg",
+            v.name, blocks, worst ) ;
+    for ( int chunk : chunks )
+    {
+      decoded_t c ;
+      decodeBuffer ( "ogg", buf.data(), buf.size(), c, chunk ) ;
+      same = same && ( c.pcm == d.pcm ) ;
+    }
+    CHECK ( same, "%s: same output for chunks of 1..4096 bytes", v.name ) ;
+  }
+  fclose ( f ) ;
+  // Chained stream: 0.5 s mono at 22050 Hz, then 0.5 s stereo at 44100 Hz
+  {
+    std::vector<uint8_t> buf = readFile ( "vorbis_chained.ogg" ) ;
+    int                  format[2][3] = { { 0 } } ;   // Rate, channels and frames of both tracks
+    int                  track = -1 ;
+    int                  left, pos = 0, r ;
+    static int16_t       out[VORBIS_MAXBLOCK * VORBIS_MAXCHANS] ;
+
+    VorbisDecoder_AllocateBuffers() ;
+    while ( pos < (int)buf.size() )
+    {
+      left = min ( 100, (int)buf.size() - pos ) ;     // Pieces of 100 bytes
+      int end = pos + left ;
+      while ( ( r = VorbisDecode ( &buf[pos], &left, out ) ) == ERR_VORBIS_NONE )
+      {
+        pos = end - left ;
+        if ( ( track < 0 ) || ( format[track][0] != VorbisGetSampRate() ) )
+        {
+          track = min ( track + 1, 1 ) ;              // New format, next track
+          format[track][0] = VorbisGetSampRate() ;
+          format[track][1] = VorbisGetChannels() ;
+        }
+        format[track][2] += VorbisGetOutputSamps() / VorbisGetChannels() ;
+      }
+      pos = end ;
+    }
+    VorbisDecoder_FreeBuffers() ;
+    CHECK ( ( format[0][0] == 22050 ) && ( format[0][1] == 1 ) && ( format[0][2] == 11025 ) &&
+            ( format[1][0] == 44100 ) && ( format[1][1] == 2 ) && ( format[1][2] == 22050 ),
+            "chained: %d Hz %d ch %d frames, then %d Hz %d ch %d frames", format[0][0], format[0][1],
+            format[0][2], format[1][0], format[1][1], format[1][2] ) ;
+  }
+  return checks_failed ;
+}
@@ -0,0 +1,277 @@
+// test_wav.cpp
+// Test of the WAV reader (wav_decoder.cpp) with files made here, and of WAV through playChunk.
+//  - The chunks are walked by their length: LIST and fact chunks before the data, chunks of odd
+//    length with their pad byte, the fmt chunk of WAVE_FORMAT_EXTENSIBLE, chunks after the data.
+//  - 16 bits are copied, 8 bits (unsigned) become (x - 128) << 8, of 24 and 32 bits the upper 16
+//    bits are used.  The output must be exactly that, with the sample rate and the channels of
+//    the fmt chunk.
+//  - A data chunk that is not a whole number of frames gives the whole frames without an error,
+//    one that is shorter than one frame gives nothing, not even an empty block.
+//  - Float samples and 3 channels give one ERR_WAV_UNSUPPORTED and no samples.
+//  - The same output for every size of the pieces the file comes in.
+//  - Through playChunk the output is the same as that of the reader.  Garbage, a chunk of 4 GB
+//    and a bad fmt chunk never let the frame buffer of helixfuncs.h overflow.
+#include "hostdecode.h"
+#include "helixhost.h"
+#include "helixfuncs.h"
+
+#define PAD        -32768                             // Padding to flush i2sbuf
+#define FRAMES     3000                               // Frames per file, more than WAV_MAXOUT
+#define GARBAGE    20000                              // Bytes of garbage through playChunk
+
+struct wavcase_t                                      // A WAV file to make and read
+{
+  const char* name ;
+  int         tag ;                                   // 1 PCM, 3 float, 0xFFFE extensible
+  int         bits ;                                  // Bits per sample (container)
+  int         ch ;                                    // Channels
+  int         rate ;                                  // Sample rate
+  int         frames ;                                // Whole frames of the data chunk
+  bool        extra ;                                 // LIST and fact chunks before the data
+  int         partial ;                               // Bytes of a partial frame after the frames
+  int         errors ;                                // Expected errors
+} ;
+
+static const wavcase_t cases[] =
+{
+  { "16 bits stereo",                         1,      16, 2, 44100, FRAMES, false, 0, 0 },
+  { "16 bits mono, LIST and fact chunks",     1,      16, 1, 22050, FRAMES, true,  0, 0 },
+  { "8 bits mono",                            1,       8, 1,  8000, FRAMES, false, 0, 0 },
+  { "8 bits stereo, data of odd length",      1,       8, 2, 11025, FRAMES, true,  1, 0 },
+  { "24 bits stereo",                         1,      24, 2, 48000, FRAMES, false, 0, 0 },
+  { "24 bits stereo, WAVE_FORMAT_EXTENSIBLE", 0xFFFE, 24, 2, 96000, FRAMES, true,  0, 0 },
+  { "32 bits mono, WAVE_FORMAT_EXTENSIBLE",   0xFFFE, 32, 1, 44100, FRAMES, false, 0, 0 },
+  { "32 bits stereo",                         1,      32, 2, 32000, FRAMES, true,  0, 0 },
+  { "data not a whole number of frames",      1,      24, 2, 44100, FRAMES, true,  5, 0 },
+  { "data shorter than one frame",            1,      16, 2, 44100, 0,      true,  3, 0 },
+  { "float samples",                          3,      32, 2, 44100, FRAMES, false, 0, 1 },
+  { "3 channels",                             1,      16, 3, 44100, FRAMES, true,  0, 1 }
+} ;
+
+static const int chunks[] = { 0, 1, 3, 32, 1000 } ;  // Sizes of the pieces, 0 is all at once
+static uint32_t  seed = 2026 ;
+
+
+//**************************************************************************************************
+//                                            P U T                                                *
+//**************************************************************************************************
+// Add a little endian number of n bytes to a file.                                                *
+//**************************************************************************************************
+static void put ( std::vector<uint8_t>& f, uint32_t x, int n )
+{
+  for ( int i = 0 ; i < n ; i++ )
+  {
+    f.push_back ( x >> ( 8 * i ) ) ;
+  }
+}
+
+
+//**************************************************************************************************
+//                                       P U T C H U N K                                           *
+//**************************************************************************************************
+// Add a chunk of "size" bytes 0xFF to a file, with the pad byte if size is odd.                   *
+//**************************************************************************************************
+static void putChunk ( std::vector<uint8_t>& f, const char* id, uint32_t size )
+{
+  f.insert ( f.end(), id, id + 4 ) ;
+  put ( f, size, 4 ) ;
+  f.insert ( f.end(), size + ( size & 1 ), 0xFF ) ;
+}
+
+
+//**************************************************************************************************
+//                                          R A N D O M                                            *
+//**************************************************************************************************
+// Random 24 bits sample, one in 16 is an edge value.                                              *
+//**************************************************************************************************
+static int32_t random24()
+{
+  static const int32_t edges[] = { 0, -1, 1, 0x7FFFFF, -0x800000, 0x7F80, -0x8080, 0x100 } ;
+
+  seed = seed * 1664525 + 1013904223 ;                // LCG of Numerical Recipes
+  if ( ( seed >> 28 ) == 0 )
+  {
+    return edges[( seed >> 8 ) & 7] ;
+  }
+  return (int32_t)seed >> 8 ;
+}
+
+
+//**************************************************************************************************
+//                                         M A K E W A V                                           *
+//**************************************************************************************************
+// Make the WAV file of a case, the expected output is added to pcm.                               *
+//**************************************************************************************************
+static std::vector<uint8_t> makeWav ( const wavcase_t& c, std::vector<int16_t>& pcm )
+{
+  std::vector<uint8_t> f ;
+  int                  align = c.ch * c.bits / 8 ;    // Bytes per frame
+  uint32_t             data = c.frames * align + c.partial ;
+  int32_t              s ;
+
+  f.insert ( f.end(), { 'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E' } ) ;
+  if ( c.extra )
+  {
+    putChunk ( f, "LIST", 7 ) ;                       // Odd length
+  }
+  f.insert ( f.end(), { 'f', 'm', 't', ' ' } ) ;
+  put ( f, ( c.tag == 0xFFFE ) ? 40 : 16, 4 ) ;
+  put ( f, c.tag, 2 ) ;
+  put ( f, c.ch, 2 ) ;
+  put ( f, c.rate, 4 ) ;
+  put ( f, c.rate * align, 4 ) ;
+  put ( f, align, 2 ) ;
+  put ( f, c.bits, 2 ) ;
+  if ( c.tag == 0xFFFE )
+  {
+    put ( f, 22, 2 ) ;                                // cbSize
+    put ( f, ( c.bits == 32 ) ? 24 : c.bits, 2 ) ;    // Valid bits
+    put ( f, ( c.ch == 1 ) ? 4 : 3, 4 ) ;             // Channel mask
+    f.insert ( f.end(), { 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,   // KSDATAFORMAT_
+                          0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 } ) ; // SUBTYPE_PCM
+  }
+  if ( c.extra )
+  {
+    putChunk ( f, "fact", 4 ) ;
+    putChunk ( f, "junk", 3 ) ;                       // Odd length
+  }
+  f.insert ( f.end(), { 'd', 'a', 't', 'a' } ) ;
+  put ( f, data, 4 ) ;
+  for ( int i = 0 ; i < c.frames * c.ch ; i++ )
+  {
+    s = random24() ;
+    switch ( c.bits )
+    {
+      case 8 :
+        put ( f, ( s >> 16 ) + 128, 1 ) ;
+        pcm.push_back ( (int16_t)( ( s >> 16 ) * 256 ) ) ;
+        break ;
+      case 16 :
+        put ( f, s >> 8, 2 ) ;
+        pcm.push_back ( (int16_t)( s >> 8 ) ) ;
+        break ;
+      default :
+        if ( c.bits == 32 )
+        {
+          put ( f, seed & 0xFF, 1 ) ;                 // Below the valid bits
+        }
+        put ( f, s, 3 ) ;
+        pcm.push_back ( (int16_t)( s >> 8 ) ) ;
+        break ;
+    }
+  }
+  f.insert ( f.end(), c.partial, 0x55 ) ;             // Partial frame
+  if ( data & 1 )
+  {
+    f.push_back ( 0 ) ;                               // Pad byte of the data chunk
+  }
+  putChunk ( f, "LIST", 9 ) ;                         // Chunk after the data
+  f[4] = f.size() - 8 ;                               // Size of the RIFF chunk
+  f[5] = ( f.size() - 8 ) >> 8 ;
+  f[6] = ( f.size() - 8 ) >> 16 ;
+  if ( c.errors )
+  {
+    pcm.clear() ;                                     // Not played
+  }
+  return f ;
+}
+
+
+//**************************************************************************************************
+//                                           P L A Y                                               *
+//**************************************************************************************************
+// Play a WAV file through playChunk in chunks of 32 bytes, return all output.  The frame buffer   *
+// must stay within mp3buf0 after every chunk, ok is cleared if not.                               *
+//**************************************************************************************************
+static std::vector<int16_t> play ( const std::vector<uint8_t>& buf, bool& ok )
+{
+  uint8_t chunk[32] ;
+  size_t  n ;
+
+  i2s_out.clear() ;
+  audio_ct = "audio/wav" ;
+  helixInit ( -1, -1 ) ;
+  ok = true ;
+  for ( size_t i = 0 ; i < buf.size() ; i += 32 )
+  {
+    n = min ( (size_t)32, buf.size() - i ) ;
+    memset ( chunk, 0, sizeof(chunk) ) ;              // Last chunk is padded with zeroes
+    memcpy ( chunk, &buf[i], n ) ;
+    playChunk ( chunk ) ;
+    if ( ( mp3bcnt < 0 ) || ( mp3bcnt > (int)sizeof(mp3buf0) ) || ( mp3bpnt != mp3buff + mp3bcnt ) )
+    {
+      ok = false ;
+    }
+  }
+  helixNextTrack() ;                                  // Play the samples left in the buffer
+  n = i2s_out.size() ;
+  while ( i2s_out.size() == n )                       // Pad until i2sbuf is sent
+  {
+    outputSample ( PAD ) ;
+  }
+  while ( i2s_out.back() == PAD )                     // Remove the padding
+  {
+    i2s_out.pop_back() ;
+  }
+  return i2s_out ;
+}
+
+
+//**************************************************************************************************
+//                                             M A I N                                             *
+//**************************************************************************************************
+int main()
+{
+  std::vector<int16_t> pcm ;                          // Expected output
+  std::vector<uint8_t> buf ;
+  std::vector<int16_t> out ;
+  decoded_t            d ;
+  bool                 ok ;
+
+  for ( const wavcase_t& c : cases )
+  {
+    pcm.clear() ;
+    buf = makeWav ( c, pcm ) ;
+    for ( int chunk : chunks )
+    {
+      decodeBuffer ( "wav", buf.data(), buf.size(), d, chunk ) ;
+      CHECK ( ( d.pcm == pcm ) && ( d.errors == c.errors ) &&
+              ( pcm.empty() == ( d.frames == 0 ) ) &&
+              ( c.errors || pcm.empty() || ( ( d.rate == c.rate ) && ( d.channels == c.ch ) ) ),
+              "%s in pieces of %d bytes: %d Hz, %d channels, %d frames, %d errors", c.name,
+              chunk ? chunk : (int)buf.size(), d.rate, d.channels,
+              (int)d.pcm.size() / max ( d.channels, 1 ), d.errors ) ;
+    }
+  }
+  player_setVolume ( 100 ) ;                          // Output gain 1
+  pcm.clear() ;
+  buf = makeWav ( cases[1], pcm ) ;
+  out = play ( buf, ok ) ;
+  CHECK ( ok && ( out.size() == 2 * pcm.size() ), "playChunk %s: %d frames of %d", cases[1].name,
+          (int)out.size() / 2, (int)pcm.size() ) ;
+  for ( size_t i = 0 ; ok && ( i < pcm.size() ) && ( out.size() == 2 * pcm.size() ) ; i++ )
+  {
+    ok = ( out[2*i] == pcm[i] ) && ( out[2*i+1] == pcm[i] ) ;   // Mono on both channels
+  }
+  CHECK ( ok, "playChunk %s: same samples as the reader", cases[1].name ) ;
+  buf.clear() ;
+  for ( int i = 0 ; i < GARBAGE ; i++ )
+  {
+    seed = seed * 1664525 + 1013904223 ;
+    buf.push_back ( seed >> 24 ) ;
+  }
+  out = play ( buf, ok ) ;
+  CHECK ( ok && out.empty(), "playChunk garbage: frame buffer within %d bytes, %d samples",
+          (int)sizeof(mp3buf0), (int)out.size() ) ;
+  buf.insert ( buf.begin(), { 'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+                              'L', 'I', 'S', 'T', 0xF0, 0xFF, 0xFF, 0xFF } ) ;
+  out = play ( buf, ok ) ;
+  CHECK ( ok && out.empty(), "playChunk chunk of 4 GB: frame buffer within %d bytes, %d samples",
+          (int)sizeof(mp3buf0), (int)out.size() ) ;
+  pcm.clear() ;
+  buf = makeWav ( cases[10], pcm ) ;
+  out = play ( buf, ok ) ;
+  CHECK ( ok && out.empty(), "playChunk %s: frame buffer within %d bytes, %d samples",
+          cases[10].name, (int)sizeof(mp3buf0), (int)out.size() ) ;
+  return checks_failed ;
+}
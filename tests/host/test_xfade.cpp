@@ -0,0 +1,233 @@
+// test_xfade.cpp
+// Test of the crossfade between two streams (helixXfadeReady, helixXfadeStart, helixXfadeChunk and
+// helixXfadeMix of helixfuncs.h).  The old stream is mp3_44k_stereo.mp3, the fade is armed after
+// ARMBYTES of it.  The rest of the old stream and the new stream are sent in chunks of 32 bytes to
+// helixXfadeChunk and playChunk, in the order of the playtask of main.cpp.  Both streams are also
+// played alone, as the reference.
+//  - helixXfadeStart swaps the voices: the globals hold the new stream, xf.v holds the old stream
+//    with its sample rate.  Both have a decoder instance of their own.
+//  - Same rate (gapless_b.mp3): the output is the old stream up to the start of the fade, then
+//    both streams mixed with the gain of the new stream rising linearly from 0 to 1 in FADEMS,
+//    within GAIN_TOL of the exact mix, then the new stream alone.  No frame of the old stream
+//    is missing in the mix and every frame of the new stream is played.
+//  - Other rate (mp3_22k_stereo.mp3): nothing is mixed, the old stream is cut and the new stream
+//    is played alone at its own rate.
+//  - No crossfade is armed if the largest free block cannot hold the buffers of a decoder.
+#include "hosttest.h"
+#include "helixhost.h"
+#include "helixfuncs.h"
+#include <climits>
+
+#define PAD        -32768                             // Padding to flush i2sbuf
+#define OLDFILE    "mp3_44k_stereo.mp3"               // Old stream
+#define ARMBYTES   4096                               // Bytes of the old stream before the fade
+#define FADEMS     500                                // Length of the fade
+#define GAIN_TOL   2                                  // Max. difference with the exact mix
+#define SEARCH     64                                 // Frames searched for the start of the fade
+
+
+//**************************************************************************************************
+//                                       F L U S H O U T                                           *
+//**************************************************************************************************
+// Send the rest of i2sbuf to i2s_out.                                                             *
+//**************************************************************************************************
+static void flushOut()
+{
+  size_t n = i2s_out.size() ;
+
+  while ( i2s_out.size() == n )                       // Pad until i2sbuf is sent
+  {
+    outputSample ( PAD ) ;
+  }
+  while ( i2s_out.back() == PAD )                     // Remove the padding
+  {
+    i2s_out.pop_back() ;
+  }
+}
+
+
+//**************************************************************************************************
+//                                         C H U N K                                               *
+//**************************************************************************************************
+// Copy the 32 bytes at position i of a file to chunk, the last chunk is padded with zeroes.       *
+//**************************************************************************************************
+static void chunk ( const std::vector<uint8_t>& buf, size_t i, uint8_t* c )
+{
+  memset ( c, 0, 32 ) ;
+  memcpy ( c, &buf[i], min ( (size_t)32, buf.size() - i ) ) ;
+}
+
+
+//**************************************************************************************************
+//                                          S O L O                                                *
+//**************************************************************************************************
+// Play a file of the corpus alone through playChunk, return all output.                           *
+//**************************************************************************************************
+static std::vector<int16_t> solo ( const std::string& name )
+{
+  std::vector<uint8_t> buf = readFile ( name ) ;
+  uint8_t              c[32] ;
+
+  i2s_out.clear() ;
+  audio_ct = "audio/mpeg" ;
+  helixInit ( -1, -1 ) ;
+  for ( size_t i = 0 ; i < buf.size() ; i += 32 )
+  {
+    chunk ( buf, i, c ) ;
+    playChunk ( c ) ;
+  }
+  helixNextTrack() ;                                  // Play the frames left in the buffer
+  flushOut() ;
+  return i2s_out ;
+}
+
+
+//**************************************************************************************************
+//                                      C R O S S F A D E                                          *
+//**************************************************************************************************
+// Crossfade from OLDFILE to a file of the corpus, return all output.  Swapped is set if the       *
+// voices are swapped by helixXfadeStart.                                                          *
+//**************************************************************************************************
+static std::vector<int16_t> crossfade ( const std::string& name, bool& swapped )
+{
+  std::vector<uint8_t> old = readFile ( OLDFILE ) ;
+  std::vector<uint8_t> buf = readFile ( name ) ;
+  uint8_t              c[32] ;
+  size_t               j ;                            // Position in the old stream
+  bool                 first ;                        // First old chunk in this pass
+
+  i2s_out.clear() ;
+  audio_ct = "audio/mpeg" ;
+  helixInit ( -1, -1 ) ;
+  for ( j = 0 ; j < ARMBYTES ; j += 32 )              // Old stream playing
+  {
+    chunk ( old, j, c ) ;
+    playChunk ( c ) ;
+  }
+  swapped = false ;
+  if ( ! helixXfadeReady() )
+  {
+    return i2s_out ;
+  }
+  helixXfadeArm ( FADEMS, false ) ;
+  helixXfadeArmed() ;                                 // QFADESONG
+  helixXfadeStart ( -1, -1 ) ;                        // QSTARTSONG of the new stream
+  swapped = ( xf.state == XF_WAIT ) && mp3mode && xf.v.mp3mode &&
+            ( mp3ctx != xf.v.mp3ctx ) &&
+            ( samprate == 0 ) && ( xf.v.samprate == 44100 ) ;
+  for ( size_t i = 0 ; i < buf.size() ; i += 32 )
+  {
+    first = true ;
+    while ( helixXfadeWant ( first ) && ( j < old.size() + 32 ) )
+    {
+      first = false ;
+      if ( j < old.size() )
+      {
+        chunk ( old, j, c ) ;
+        helixXfadeChunk ( c ) ;
+      }
+      else
+      {
+        helixXfadeChunk ( NULL ) ;                    // End of the old stream
+      }
+      j += 32 ;
+    }
+    chunk ( buf, i, c ) ;
+    playChunk ( c ) ;
+  }
+  helixNextTrack() ;                                  // Play the frames left in the buffer
+  flushOut() ;
+  return i2s_out ;
+}
+
+
+//**************************************************************************************************
+//                                      M I X E R R O R                                            *
+//**************************************************************************************************
+// Largest difference of the output with the exact mix of old stream a and new stream b, if the   *
+// fade of len frames starts at frame p.                                                           *
+//**************************************************************************************************
+static int mixError ( const std::vector<int16_t>& out, const std::vector<int16_t>& a,
+                      const std::vector<int16_t>& b, int p, int len )
+{
+  int nb = b.size() / 2 ;                             // Frames of the new stream
+  int err = 0 ;
+  int32_t g, o, x ;
+
+  for ( int k = 0 ; ( k < nb ) && ( 2 * ( p + k ) + 1 < (int)out.size() ) ; k++ )
+  {
+    g = ( k < len ) ? (int32_t)( (int64_t)k * 32768 / len ) : 32768 ;
+    for ( int ch = 0 ; ch < 2 ; ch++ )
+    {
+      o = ( 2 * ( p + k ) + ch < (int)a.size() ) ? a[2*(p+k)+ch] : 0 ;
+      x = ( b[2*k+ch] * g + o * ( 32768 - g ) ) >> 15 ;
+      err = max ( err, abs ( out[2*(p+k)+ch] - x ) ) ;
+    }
+  }
+  return err ;
+}
+
+
+//**************************************************************************************************
+//                                             M A I N                                             *
+//**************************************************************************************************
+int main()
+{
+  std::vector<int16_t> a ;                            // Old stream alone
+  std::vector<int16_t> b ;                            // New stream alone, same rate
+  std::vector<int16_t> c ;                            // New stream alone, other rate
+  std::vector<int16_t> out ;
+  bool                 swapped ;
+  int                  len = FADEMS * 44100 / 1000 ;  // Length of the fade in frames
+  int                  m = 0 ;                        // First frame that differs from old stream
+  int                  p = 0 ;                        // Start of the fade
+  int                  err = INT_MAX ;
+  int                  q ;                            // Frames of the old stream before a cut
+  uint32_t             cuts ;
+
+  player_setVolume ( 100 ) ;                          // Output gain 1
+  a = solo ( OLDFILE ) ;
+  b = solo ( "gapless_b.mp3" ) ;
+  c = solo ( "mp3_22k_stereo.mp3" ) ;
+  helixSetCrossfade ( 1 ) ;
+  host_heap_free = 400000 ;                           // Room for two decoders
+  out = crossfade ( "gapless_b.mp3", swapped ) ;
+  CHECK ( swapped, "start: new stream in the globals, old stream in xf.v, other decoders" ) ;
+  while ( ( 2 * m + 1 < (int)out.size() ) && ( 2 * m + 1 < (int)a.size() ) &&
+          ( out[2*m] == a[2*m] ) && ( out[2*m+1] == a[2*m+1] ) )
+  {
+    m++ ;
+  }
+  for ( int i = max ( 0, m - SEARCH ) ; i <= m ; i++ )  // Gain of the first frames may be 0
+  {
+    int e = mixError ( out, a, b, i, len ) ;
+    if ( e < err )
+    {
+      err = e ;
+      p = i ;
+    }
+  }
+  CHECK ( ( xf.fades == 1 ) && ( xf.under == 0 ) && ( xf.state == XF_IDLE ) &&
+          ( p + len <= (int)a.size() / 2 ), "same rate: fade done, %d frames without old stream, "
+          "frame %d..%d of %d of the old stream mixed", xf.under, p, p + len, (int)a.size() / 2 ) ;
+  CHECK ( err <= GAIN_TOL, "same rate: linear gain over %d frames, %d from the exact mix", len,
+          err ) ;
+  CHECK ( (int)out.size() == 2 * p + (int)b.size(), "same rate: %d frames, old stream %d, new "
+          "stream %d", (int)out.size() / 2, p, (int)b.size() / 2 ) ;
+  cuts = xf.cuts ;
+  out = crossfade ( "mp3_22k_stereo.mp3", swapped ) ;
+  q = ( out.size() - c.size() ) / 2 ;
+  CHECK ( swapped && ( xf.cuts == cuts + 1 ) && ( xf.fades == 1 ) && ( xf.state == XF_IDLE ),
+          "other rate: fade refused at the first frame of the new stream" ) ;
+  CHECK ( ( out.size() > c.size() ) &&
+          std::equal ( out.begin(), out.begin() + 2 * q, a.begin() ) &&
+          std::equal ( c.begin(), c.end(), out.begin() + 2 * q ) && ( i2s_rate == 22050 ),
+          "other rate: %d frames of the old stream, then the new stream alone at %d Hz", q,
+          i2s_rate ) ;
+  host_heap_block = 10000 ;                           // Fragmented heap
+  cuts = xf.cuts ;
+  out = crossfade ( "gapless_b.mp3", swapped ) ;
+  CHECK ( ! swapped && ( xf.cuts == cuts + 1 ) && ( xf.state == XF_IDLE ),
+          "largest free block %d bytes: no crossfade", (int)host_heap_block ) ;
+  return checks_failed ;
+}